@@ -16,6 +16,7 @@ cp      favicon.ico                  ${WEBFSDIR}/
 cp      version.txt                  ${WEBFSDIR}/
 cp      index.html                   ${WEBFSDIR}/
 cp      keymap.html                  ${WEBFSDIR}/keymap.html
+cp      macro.html                   ${WEBFSDIR}/macro.html
 cp      mouse.html                   ${WEBFSDIR}/mouse.html
 cp      ota.html                     ${WEBFSDIR}/ota.html
 cp      wifimanager.html             ${WEBFSDIR}/wifimanager.html
@@ -55,6 +56,7 @@ gzip -c jquery.edittable.js        > ${WEBFSDIR}/js/jquery.edittable.js.gz
 gzip -c jquery.edittable.min.js    > ${WEBFSDIR}/js/jquery.edittable.min.j.gz
 cp      jquery.min.js.gz             ${WEBFSDIR}/js/
 gzip -c keymap.js                  > ${WEBFSDIR}/js/keymap.js.gz
+gzip -c macro.js                   > ${WEBFSDIR}/js/macro.js.gz
 gzip -c mouse.js                   > ${WEBFSDIR}/js/mouse.js.gz
 gzip -c ota.js                     > ${WEBFSDIR}/js/ota.js.gz
 gzip -c wifimanager.js             > ${WEBFSDIR}/js/wifimanager.js.gz
@@ -58,40 +58,169 @@
 // to understand and the class can only ever be singleton.
 BT      *pBTThis = NULL;
 
-// Method to locate a valid scan entry in the results list.
+// Method to hash a BDA into a scan table slot. The low order bytes of a BDA are the most random so all are mixed (FNV-1a).
 //
-BT::t_scanListItem* BT::findValidScannedDevice(esp_bd_addr_t bda, std::vector<t_scanListItem> &scanList)
+uint32_t BT::hashBDA(const uint8_t *bda)
 {
     // Locals.
     //
+    uint32_t      hash = 2166136261UL;
 
-    // Loop through the scan results list looking for a valid entry, return entry if found.
-    for(std::size_t idx = 0; idx < scanList.size(); idx++)
+    for(int idx=0; idx < sizeof(esp_bd_addr_t); idx++)
+    {
+        hash = (hash ^ bda[idx]) * 16777619UL;
+    }
+    return(hash & (BT_SCAN_TABLE_SIZE - 1));
+}
+
+// Method to locate a scan entry in a results table, probing from the hashed slot until a match or an empty slot is found.
+//
+BT::t_scanEntry* BT::findScanEntry(t_scanTable &table, const uint8_t *bda)
+{
+    // Locals.
+    //
+    uint32_t      pos = hashBDA(bda);
+
+    // The table is never full, BT_SCAN_MAX_ENTRIES < BT_SCAN_TABLE_SIZE, so an empty slot always ends the probe.
+    while(table.entry[pos].used == true)
     {
-        if (memcmp(bda, scanList[idx].bda, sizeof(esp_bd_addr_t)) == 0)
+        if(memcmp(bda, table.entry[pos].bda, sizeof(esp_bd_addr_t)) == 0)
         {
-            return &scanList[idx];
+            return(&table.entry[pos]);
         }
+        pos = (pos + 1) & (BT_SCAN_TABLE_SIZE - 1);
     }
     return(nullptr);
 }
 
+// Method to remove an entry from a results table. Later entries in the probe chain are shifted back so no tombstones are needed.
+//
+void BT::removeScanEntry(t_scanTable &table, int pos)
+{
+    // Locals.
+    //
+    int           next = pos;
+    int           home;
+
+    table.entry[pos].used = false;
+    table.count--;
+    while(true)
+    {
+        next = (next + 1) & (BT_SCAN_TABLE_SIZE - 1);
+        if(table.entry[next].used == false)
+            break;
+
+        // Move the entry into the hole if its home slot does not lie cyclically between the hole and its current slot.
+        home = hashBDA(table.entry[next].bda);
+        if(((next - home) & (BT_SCAN_TABLE_SIZE - 1)) >= ((next - pos) & (BT_SCAN_TABLE_SIZE - 1)))
+        {
+            table.entry[pos] = table.entry[next];
+            table.entry[next].used = false;
+            pos = next;
+        }
+    }
+    return;
+}
+
+// Method to locate or create a scan entry. When the table reaches its load limit the least recently seen device is evicted.
+// A new entry is returned cleared apart from the BDA.
+//
+BT::t_scanEntry* BT::insertScanEntry(t_scanTable &table, const uint8_t *bda)
+{
+    // Locals.
+    //
+    t_scanEntry  *entry = findScanEntry(table, bda);
+    uint32_t      pos;
+    int           oldest = -1;
+
+    if(entry != nullptr)
+        return(entry);
+
+    // Evict the least recently seen device.
+    if(table.count >= BT_SCAN_MAX_ENTRIES)
+    {
+        for(int idx=0; idx < BT_SCAN_TABLE_SIZE; idx++)
+        {
+            if(table.entry[idx].used == true && (oldest == -1 || (TickType_t)(table.entry[oldest].lastSeen - table.entry[idx].lastSeen) < portMAX_DELAY/2))
+                oldest = idx;
+        }
+        removeScanEntry(table, oldest);
+    }
+
+    // Take the first empty slot in the probe chain.
+    pos = hashBDA(bda);
+    while(table.entry[pos].used == true)
+    {
+        pos = (pos + 1) & (BT_SCAN_TABLE_SIZE - 1);
+    }
+    memset(&table.entry[pos], 0x00, sizeof(t_scanEntry));
+    memcpy(table.entry[pos].bda, bda, sizeof(esp_bd_addr_t));
+    table.entry[pos].used = true;
+    table.count++;
+    return(&table.entry[pos]);
+}
+
+// Method to copy the devices seen since a given tick into a scan list. Devices unseen for longer than BT_SCAN_MAX_AGE are aged out.
+//
+void BT::copyScanResults(t_scanTable &table, TickType_t since, std::vector<t_scanListItem> &scanList)
+{
+    // Locals.
+    //
+    TickType_t     now = xTaskGetTickCount();
+    t_scanListItem item;
+
+    // Age out devices first, removal may shift a later entry into the freed slot so it is rechecked.
+    for(int idx=0; idx < BT_SCAN_TABLE_SIZE; idx++)
+    {
+        if(table.entry[idx].used == true && (now - table.entry[idx].lastSeen) > pdMS_TO_TICKS(BT_SCAN_MAX_AGE))
+        {
+            removeScanEntry(table, idx--);
+        }
+    }
+
+    for(int idx=0; idx < BT_SCAN_TABLE_SIZE; idx++)
+    {
+        // Only devices seen during the last scan are reported.
+        if(table.entry[idx].used == true && (TickType_t)(table.entry[idx].lastSeen - since) < portMAX_DELAY/2)
+        {
+            memcpy(item.bda, table.entry[idx].bda, sizeof(esp_bd_addr_t));
+            item.name.assign(table.entry[idx].name, table.entry[idx].nameLen);
+            item.rssi      = table.entry[idx].rssi;
+            item.usage     = table.entry[idx].usage;
+            item.transport = table.entry[idx].transport;
+            if(item.transport == ESP_HID_TRANSPORT_BLE)
+            {
+                item.ble.addr_type  = table.entry[idx].ble.addr_type;
+                item.ble.appearance = table.entry[idx].ble.appearance;
+            } else
+            {
+                memcpy(&item.bt.cod,  &table.entry[idx].bt.cod,  sizeof(esp_bt_cod_t));
+                memcpy(&item.bt.uuid, &table.entry[idx].bt.uuid, sizeof(esp_bt_uuid_t));
+            }
+            scanList.push_back(item);
+        }
+    }
+    return;
+}
+
 #ifdef CONFIG_CLASSIC_BT_ENABLED
 // Method to add a valid BT Classic device onto the scan list.
 //
 void BT::addBTScanDevice(esp_bd_addr_t bda, esp_bt_cod_t *cod, esp_bt_uuid_t *uuid, uint8_t *name, uint8_t name_len, int rssi)
 {
     // Locals.
-    t_scanListItem item;
+    bool         found  = (findScanEntry(btCtrl.btScanTable, bda) != nullptr);
+    t_scanEntry *result = insertScanEntry(btCtrl.btScanTable, bda);
+    uint32_t     codValue;
 
     // Find a valid device in the BT Classic scan results. If a device is found then this callback is with new data.
-    t_scanListItem* result = findValidScannedDevice(bda, btCtrl.btScanList);
-    if(result)
+    if(found)
     {
         // Information can be updated through several calls.
-        if(result->name.length() == 0 && name && name_len)
+        if(result->nameLen == 0 && name && name_len)
         {
-            result->name.assign((char *)name, name_len); 
+            result->nameLen = name_len < BT_SCAN_NAME_LEN ? name_len : BT_SCAN_NAME_LEN;
+            memcpy(result->name, name, result->nameLen);
         }
         if(result->bt.uuid.len == 0 && uuid->len)
         {
@@ -99,28 +228,27 @@ void BT::addBTScanDevice(esp_bd_addr_t bda, esp_bt_cod_t *cod, esp_bt_uuid_t *uu
         }
         if(rssi != 0)
         {
-          result->rssi = rssi;
+          result->rssi = (int8_t)((result->rssi * 3 + rssi) / 4);
         }
+        result->lastSeen = xTaskGetTickCount();
         return;
     }
 
     // Populate new list item with device results.
-    item.transport = ESP_HID_TRANSPORT_BT;
-    memcpy(item.bda,      bda,  sizeof(esp_bd_addr_t));
-    memcpy(&item.bt.cod,  cod,  sizeof(esp_bt_cod_t));
-    memcpy(&item.bt.uuid, uuid, sizeof(esp_bt_uuid_t));
-    item.usage = esp_hid_usage_from_cod((uint32_t)cod);
-    item.rssi  = rssi;
-    item.name  = "";
+    result->transport = ESP_HID_TRANSPORT_BT;
+    memcpy(&result->bt.cod,  cod,  sizeof(esp_bt_cod_t));
+    memcpy(&result->bt.uuid, uuid, sizeof(esp_bt_uuid_t));
+    memcpy(&codValue, cod, sizeof(uint32_t));
+    result->usage    = esp_hid_usage_from_cod(codValue);
+    result->rssi     = rssi;
+    result->lastSeen = xTaskGetTickCount();
 
     // Store device name if present. This is possibly provided in a seperate callback.
     if(name_len && name)
     {
-        item.name.assign((char *)name, name_len); 
+        result->nameLen = name_len < BT_SCAN_NAME_LEN ? name_len : BT_SCAN_NAME_LEN;
+        memcpy(result->name, name, result->nameLen);
     }
- 
-    // Add new item onto list.
-    btCtrl.btScanList.push_back(item);
     return;
 }
 #endif
@@ -131,32 +259,31 @@ void BT::addBLEScanDevice(esp_bd_addr_t bda, esp_ble_addr_type_t addr_type, uint
 {
     // Locals.
     //
-    t_scanListItem item;
+    t_scanEntry *result = findScanEntry(btCtrl.bleScanTable, bda);
 
-    // See if the device is already in the list, exit if found as data updates with seperate callbacks not normal under BLE.
-    if(findValidScannedDevice(bda, btCtrl.bleScanList))
+    // If the device is already in the table, age the RSSI and refresh it, data updates with seperate callbacks not normal under BLE.
+    if(result)
     {
-        ESP_LOGW(TAG, "Result already exists!");
+        result->rssi     = (int8_t)((result->rssi * 3 + rssi) / 4);
+        result->lastSeen = xTaskGetTickCount();
         return;
     }
 
     // Populate the item with data.
-    item.transport      = ESP_HID_TRANSPORT_BLE;
-    memcpy(item.bda, bda, sizeof(esp_bd_addr_t));
-    item.ble.appearance = appearance;
-    item.ble.addr_type  = addr_type;
-    item.usage          = esp_hid_usage_from_appearance(appearance);
-    item.rssi           = rssi;
-    item.name           = "";
+    result = insertScanEntry(btCtrl.bleScanTable, bda);
+    result->transport      = ESP_HID_TRANSPORT_BLE;
+    result->ble.appearance = appearance;
+    result->ble.addr_type  = addr_type;
+    result->usage          = esp_hid_usage_from_appearance(appearance);
+    result->rssi           = rssi;
+    result->lastSeen       = xTaskGetTickCount();
 
     // Store device name if present.
     if(name_len && name)
     {
-        item.name.assign((char *)name, name_len); 
+        result->nameLen = name_len < BT_SCAN_NAME_LEN ? name_len : BT_SCAN_NAME_LEN;
+        memcpy(result->name, name, result->nameLen);
     }
-
-    // Add new item onto list.
-    btCtrl.bleScanList.push_back(item);
     return;
 }
 
@@ -262,7 +389,7 @@ void BT::processBTDeviceScanResult(esp_bt_gap_cb_param_t * param)
     }
   
     // If the found device is a peripheral or a second call on an existing device, add/update the device.
-    if ((cod->major == ESP_BT_COD_MAJOR_DEV_PERIPHERAL) || (findValidScannedDevice(param->disc_res.bda, btCtrl.btScanList) != nullptr))
+    if ((cod->major == ESP_BT_COD_MAJOR_DEV_PERIPHERAL) || (findScanEntry(btCtrl.btScanTable, param->disc_res.bda) != nullptr))
     {
         addBTScanDevice(param->disc_res.bda, cod, &uuid, name, name_len, rssi);
     }
@@ -527,12 +654,9 @@ esp_err_t BT::scanForAllDevices(uint32_t timeout, size_t *noDevices, std::vector
 {
     // Locals.
     //
+    TickType_t  scanStart = xTaskGetTickCount();
 
-    // Clear previous lists.
-  #ifdef CONFIG_CLASSIC_BT_ENABLED
-    btCtrl.btScanList.clear();
-  #endif
-    btCtrl.bleScanList.clear();
+    // The scan tables are retained between scans, names and RSSI history carry over, only devices seen from now on are reported.
 
     // Scan for BLE devices.
     if(scanForBLEDevices(timeout) == ESP_OK)
@@ -563,15 +687,9 @@ esp_err_t BT::scanForAllDevices(uint32_t timeout, size_t *noDevices, std::vector
   
     // Process results into a merged list.
   #ifdef CONFIG_CLASSIC_BT_ENABLED
-    for(std::size_t idx = 0; idx < btCtrl.btScanList.size(); idx++)
-    {
-        scanList.push_back(btCtrl.btScanList[idx]);
-    }
+    copyScanResults(btCtrl.btScanTable, scanStart, scanList);
   #endif
-    for(std::size_t idx = 0; idx < btCtrl.bleScanList.size(); idx++)
-    {
-        scanList.push_back(btCtrl.bleScanList[idx]);
-    }
+    copyScanResults(btCtrl.bleScanTable, scanStart, scanList);
 
     // Update the final list with display values.
     for(std::size_t idx = 0; idx < scanList.size(); idx++)
@@ -594,12 +712,6 @@ esp_err_t BT::scanForAllDevices(uint32_t timeout, size_t *noDevices, std::vector
     // Save number of entries.
     *noDevices = scanList.size();
 
-    // Clear BT/BLE lists as data no longer needed.
-  #ifdef CONFIG_CLASSIC_BT_ENABLED
-    btCtrl.btScanList.clear();
-  #endif
-    btCtrl.bleScanList.clear();
-
     return(ESP_OK);
 }
 
@@ -777,6 +889,10 @@ BT::BT(void)
     btCtrl.bt_hidh_cb_semaphore = nullptr;
   #endif
     btCtrl.ble_hidh_cb_semaphore = nullptr;
+  #ifdef CONFIG_CLASSIC_BT_ENABLED
+    memset(&btCtrl.btScanTable, 0x00, sizeof(t_scanTable));
+  #endif
+    memset(&btCtrl.bleScanTable, 0x00, sizeof(t_scanTable));
     pBTThis = NULL;
     //
 }
@@ -21,6 +21,11 @@
 // History:         Mar 2022 - Initial write.
 //                  Jun 2022 - Updated with latest findings. Now checks the bonded list and opens 
 //                             connections or scans for new devices if no connections exist.
+//                  Oct 2026 - Key queue depths and lost reports reported to the runtime metrics.
+//                             Processed keys carry the time of their report for latency metrics.
+//                             Media key releases are sent as break codes.
+//                             Device list guarded by a mutex, opens no longer race the HID event task.
+//                             Keyboard LEDs sent to all open keyboards from the key processing thread.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -40,6 +45,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "BTHID.h"
+#include "Metrics.h"
 
 // Out of object pointer to a singleton class for use in the ESP IDF API callback routines which werent written for C++. Other methods can be used but this one is the simplest
 // to understand and the class can only ever be singleton.
@@ -54,15 +60,26 @@ bool BTHID::openDevice(esp_bd_addr_t bda, esp_hid_transport_t transport, esp_ble
     bool                    found = false;
     t_activeDev             device;
 
-    // Call underlying IDF API to open the device. Store handle for future use.
+    // Call underlying IDF API to open the device. Store handle for future use. The open blocks and raises the open event so the device
+    // list is not locked across it.
     device.hidhDevHdl = esp_hidh_dev_open(bda, transport, addrType);
 
-    // Add device to list of known devices.
-    for(std::size_t idx = 0; idx < pBTHID->btHIDCtrl.devices.size(); idx++)
+    // Add device to list of known devices, the list is shared with the HID event task and the reconnect thread.
+    xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
+    for(std::size_t idx = 0; idx < btHIDCtrl.devices.size(); idx++)
     {
         // Already on list?
         if (memcmp(bda, btHIDCtrl.devices[idx].bda, sizeof(esp_bd_addr_t)) == 0)
         {
+            if(device.hidhDevHdl != NULL)
+            {
+                btHIDCtrl.devices[idx].hidhDevHdl = device.hidhDevHdl;
+                btHIDCtrl.devices[idx].open = true;
+                btHIDCtrl.devices[idx].closing = false;
+            } else
+            {
+                btHIDCtrl.devices[idx].nextCheckTime = milliSeconds() + 5000L;
+            }
             found = true;
         }
     }
@@ -72,9 +89,11 @@ bool BTHID::openDevice(esp_bd_addr_t bda, esp_hid_transport_t transport, esp_ble
         device.transport = transport;
         device.addrType = addrType;
         device.open = true;
+        device.closing = false;
         device.nextCheckTime = milliSeconds() + 5000L;
         btHIDCtrl.devices.push_back(device);
     }
+    xSemaphoreGive(btHIDCtrl.devMutex);
  
     // Return connection status.
     return(device.hidhDevHdl == NULL ? false : true);
@@ -89,18 +108,22 @@ bool BTHID::closeDevice(esp_bd_addr_t bda)
     esp_err_t  result = ESP_OK;
 
     // Locate device and close it out.
-    for(std::size_t idx = 0; idx < pBTHID->btHIDCtrl.devices.size(); idx++)
+    xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
+    for(std::size_t idx = 0; idx < btHIDCtrl.devices.size(); idx++)
     {
         // Already on list?
         if (memcmp(bda, btHIDCtrl.devices[idx].bda, sizeof(esp_bd_addr_t)) == 0)
         {
             if(btHIDCtrl.devices[idx].hidhDevHdl != NULL)
             {
+                // The handle is released by the close event, nothing more is sent to the device meanwhile.
+                btHIDCtrl.devices[idx].closing = true;
                 result = esp_hidh_dev_close(btHIDCtrl.devices[idx].hidhDevHdl);
                 btHIDCtrl.devices[idx].open = false;
             }
         }
     }
+    xSemaphoreGive(btHIDCtrl.devMutex);
 
     return(result);
 }
@@ -156,13 +179,16 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
             {
                 // Update status of device in list.
                 bool found = false;
+                xSemaphoreTake(pBTHID->btHIDCtrl.devMutex, portMAX_DELAY);
                 for(std::size_t idx = 0; idx < pBTHID->btHIDCtrl.devices.size(); idx++)
                 {
                     // Try and re-open closed devices.
                     if(memcmp(bda, pBTHID->btHIDCtrl.devices[idx].bda, sizeof(esp_bd_addr_t)) == 0)
                     {
                         pBTHID->btHIDCtrl.devices[idx].open = true;
+                        pBTHID->btHIDCtrl.devices[idx].closing = false;
                         pBTHID->btHIDCtrl.devices[idx].usage = usage;
+                        pBTHID->btHIDCtrl.devices[idx].hidhDevHdl = param->open.dev;
                         found = true;
                         break;
                     }
@@ -174,10 +200,31 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
                     device.transport = esp_hidh_dev_transport_get(param->open.dev);
                     device.addrType = BLE_ADDR_TYPE_RANDOM;
                     device.open = true;
+                    device.closing = false;
                     device.usage = usage;
+                    device.hidhDevHdl = param->open.dev;
+                    device.nextCheckTime = pBTHID->milliSeconds() + 5000L;
                     pBTHID->btHIDCtrl.devices.push_back(device);
                 }
                 
+                // Record the device as the last connected, it is opened directly on the next power up.
+                if(pBTHID->btHIDCtrl.reconnect.lastDev.valid != BTHID_LASTDEV_VALID || memcmp(bda, pBTHID->btHIDCtrl.reconnect.lastDev.bda, sizeof(esp_bd_addr_t)) != 0)
+                {
+                    pBTHID->btHIDCtrl.reconnect.lastDev.valid     = BTHID_LASTDEV_VALID;
+                    memcpy(pBTHID->btHIDCtrl.reconnect.lastDev.bda, bda, sizeof(esp_bd_addr_t));
+                    pBTHID->btHIDCtrl.reconnect.lastDev.transport = esp_hidh_dev_transport_get(param->open.dev);
+                    pBTHID->btHIDCtrl.reconnect.lastDev.addrType  = BLE_ADDR_TYPE_RANDOM;
+                    for(std::size_t idx = 0; idx < pBTHID->btHIDCtrl.devices.size(); idx++)
+                    {
+                        if(memcmp(bda, pBTHID->btHIDCtrl.devices[idx].bda, sizeof(esp_bd_addr_t)) == 0)
+                            pBTHID->btHIDCtrl.reconnect.lastDev.addrType = pBTHID->btHIDCtrl.devices[idx].addrType;
+                    }
+                    pBTHID->btHIDCtrl.reconnect.dirty = true;
+                }
+                xSemaphoreGive(pBTHID->btHIDCtrl.devMutex);
+                if(pBTHID->btHIDCtrl.reconnect.openTime == 0)
+                    pBTHID->btHIDCtrl.reconnect.openTime = esp_timer_get_time();
+
                 // Ask for the current LED status on keyboards, this is used to pre-set the function locks.
                 if(usage == ESP_HID_USAGE_KEYBOARD)
                 {
@@ -189,6 +236,7 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
             } else
             {
                 // Update status of device in list.
+                xSemaphoreTake(pBTHID->btHIDCtrl.devMutex, portMAX_DELAY);
                 for(std::size_t idx = 0; idx < pBTHID->btHIDCtrl.devices.size(); idx++)
                 {
                     // Try and re-open closed devices.
@@ -197,6 +245,7 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
                         pBTHID->btHIDCtrl.devices[idx].open = false;
                     }
                 }
+                xSemaphoreGive(pBTHID->btHIDCtrl.devMutex);
                 ESP_LOGE(TAG, " OPEN failed!");
               //  pBTHID->closeDevice();
             }
@@ -228,6 +277,7 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
         {
             const uint8_t *bda = esp_hidh_dev_bda_get(param->feature.dev);
 
+            xSemaphoreTake(pBTHID->btHIDCtrl.devMutex, portMAX_DELAY);
             for(std::size_t idx = 0; idx < pBTHID->btHIDCtrl.devices.size(); idx++)
             {
                 // Matched device?
@@ -262,6 +312,7 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
                     break;
                 }
             }
+            xSemaphoreGive(pBTHID->btHIDCtrl.devMutex);
             ESP_LOGD(TAG, ESP_BD_ADDR_STR " FEATURE: %8s, MAP: %2u, ID: %3u, Len: %d", 
                           ESP_BD_ADDR_HEX(bda),
                           esp_hid_usage_str(param->feature.usage), 
@@ -276,6 +327,7 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
             const uint8_t *bda = esp_hidh_dev_bda_get(param->close.dev);
             if(bda != NULL)
             {
+                xSemaphoreTake(pBTHID->btHIDCtrl.devMutex, portMAX_DELAY);
                 for(std::size_t idx = 0; idx < pBTHID->btHIDCtrl.devices.size(); idx++)
                 {
                     // Device which has closed?
@@ -283,10 +335,25 @@ void BTHID::hidh_callback(void *handler_args, esp_event_base_t base, int32_t id,
                     {
                         ESP_LOGD(TAG, "Closing device:%d,%s", idx, esp_hidh_dev_name_get(param->close.dev));
                         pBTHID->btHIDCtrl.devices[idx].open = false;
+                        pBTHID->btHIDCtrl.devices[idx].closing = false;
+                        pBTHID->btHIDCtrl.devices[idx].hidhDevHdl = NULL;
                     }
                 }
+                xSemaphoreGive(pBTHID->btHIDCtrl.devMutex);
                 ESP_LOGD(TAG, ESP_BD_ADDR_STR " CLOSE: %s", ESP_BD_ADDR_HEX(bda), esp_hidh_dev_name_get(param->close.dev));
             }
+
+            // Release any keys held by the device, the close is queued behind its outstanding reports.
+            KeyInfo keyInfo;
+            memset(&keyInfo, 0x00, sizeof(KeyInfo));
+            keyInfo.closed = true;
+            keyInfo.hdlDev = param->close.dev;
+            keyInfo.time   = Metrics::now();
+            if(pBTHID->btHIDCtrl.kbd.rawKeyQueue != NULL && xQueueSend(pBTHID->btHIDCtrl.kbd.rawKeyQueue, &keyInfo, pdMS_TO_TICKS(100)) != pdTRUE)
+            {
+                pBTHID->btHIDCtrl.kbd.rawOverflows++;
+                Metrics::count(Metrics::COUNTER_RAW_KEY_QUEUE_FULL);
+            }
             break;
         }
         default:
@@ -320,8 +387,14 @@ void BTHID::pushKeyToFIFO(esp_hid_usage_t src, esp_hidh_dev_t *hdlDev, uint8_t *
         }
         keyInfo.length = size;
         keyInfo.cControl = (src == ESP_HID_USAGE_CCONTROL ? true : false);
+        keyInfo.closed = false;
         keyInfo.hdlDev = hdlDev;
-        xQueueSendFromISR(btHIDCtrl.kbd.rawKeyQueue, &keyInfo, 0);
+        keyInfo.time = Metrics::now();
+        if(xQueueSendFromISR(btHIDCtrl.kbd.rawKeyQueue, &keyInfo, 0) != pdTRUE)
+        {
+            btHIDCtrl.kbd.rawOverflows++;
+            Metrics::count(Metrics::COUNTER_RAW_KEY_QUEUE_FULL);
+        }
     }
     else if(src == ESP_HID_USAGE_MOUSE)
     {
@@ -348,8 +421,8 @@ void BTHID::pushKeyToFIFO(esp_hid_usage_t src, esp_hidh_dev_t *hdlDev, uint8_t *
             mouseData.position.x = mouseData.position.x * btHIDCtrl.ms.resolution;
             mouseData.position.y = mouseData.position.y * btHIDCtrl.ms.resolution;
 
-            // Set the wheel value.
-            mouseData.wheel      = keys[5];
+            // Set the wheel value, sign extended to match the PS/2 mouse data.
+            mouseData.wheel      = (int8_t)keys[5];
         }
 
         // If a data callback has been setup, invoke otherwise data is wasted.
@@ -360,6 +433,48 @@ void BTHID::pushKeyToFIFO(esp_hid_usage_t src, esp_hidh_dev_t *hdlDev, uint8_t *
     return;
 }
 
+// Method to persist the last connected device into NVS storage.
+//
+void BTHID::persistLastDevice(void)
+{
+    // Clear the flag first, a further change during the write will be persisted on the next check.
+    btHIDCtrl.reconnect.dirty = false;
+    if(btHIDCtrl.nvs == NULL)
+        return;
+
+    if(btHIDCtrl.nvs->persistData(BTHID_NVS_KEY, &btHIDCtrl.reconnect.lastDev, sizeof(t_lastDevice)) == false)
+    {
+        ESP_LOGW(TAG, "Persisting last connected device failed, check NVS setup.");
+    }
+    else if(btHIDCtrl.nvs->commitData() == false)
+    {
+        ESP_LOGW(TAG, "NVS Commit writes operation failed, some previous writes may not persist in future power cycles.");
+    } else
+    {
+        ESP_LOGI(TAG, ESP_BD_ADDR_STR " stored as last connected device.", ESP_BD_ADDR_HEX(btHIDCtrl.reconnect.lastDev.bda));
+    }
+    return;
+}
+
+// Thread to open the last connected device directly at power up. The open blocks until the device answers or times out so it runs
+// alongside the periodic open of the other bonded devices and a discovery scan, whichever connects first is used.
+//
+void BTHID::reconnectTask(void *pvParameters)
+{
+    // Locals.
+    //
+    BTHID              *pThis = (BTHID *)pvParameters;
+    bool                result;
+
+    ESP_LOGI(TAG, ESP_BD_ADDR_STR " FASTOPEN", ESP_BD_ADDR_HEX(pThis->btHIDCtrl.reconnect.directDev.bda));
+    result = pThis->openDevice(pThis->btHIDCtrl.reconnect.directDev.bda, pThis->btHIDCtrl.reconnect.directDev.transport, pThis->btHIDCtrl.reconnect.directDev.addrType);
+    ESP_LOGI(TAG, "Fast open %s after %ums.", result == true ? "succeeded" : "failed", (uint32_t)((esp_timer_get_time() - pThis->btHIDCtrl.reconnect.setupTime)/1000));
+
+    // Hand the device back to the periodic check.
+    pThis->btHIDCtrl.reconnect.active = false;
+    vTaskDelete(NULL);
+}
+
 // Method to check devices for connectivity. This generally entails re-opening closed devices as BT links are self maintaining until closure.
 //
 void BTHID::checkBTDevices(void)
@@ -368,13 +483,27 @@ void BTHID::checkBTDevices(void)
     //
     bool                            nonFound = true;
     std::vector<BT::t_scanListItem> scanList;
+    std::vector<t_activeDev>        openList;
+
+    // Persist a change of the last connected device, done here rather than in the HID callback to keep NVS writes off the BT event task.
+    if(btHIDCtrl.reconnect.dirty == true)
+    {
+        persistLastDevice();
+    }
 
     // Loop through list of known devices and open a connection with them. If no devices exist or no connection can be opened, start
     // a scan for new devices. Normally, bonded devices when activated will connect but sometimes a physical open is needed hence this 
-    // logic.
+    // logic. Devices due an open attempt are copied out of the list and opened once it is released as an open blocks and the list is
+    // updated by the HID event task and the reconnect thread meanwhile.
+    xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
     for(std::size_t idx = 0; idx < btHIDCtrl.devices.size(); idx++)
     {
         if(btHIDCtrl.devices[idx].open == true)
+        {
+            nonFound = false;
+        }
+        // Skip the last connected device whilst it is being opened directly.
+        else if(btHIDCtrl.reconnect.active == true && memcmp(btHIDCtrl.devices[idx].bda, btHIDCtrl.reconnect.directDev.bda, sizeof(esp_bd_addr_t)) == 0)
         {
             nonFound = false;
         } else
@@ -382,25 +511,38 @@ void BTHID::checkBTDevices(void)
             // If the timer has expired on this entry, make an open attempt.
             if(btHIDCtrl.devices[idx].nextCheckTime <= milliSeconds())
             {
-                ESP_LOGI(TAG, ESP_BD_ADDR_STR " PAIREDOPEN", ESP_BD_ADDR_HEX(btHIDCtrl.devices[idx].bda));
-                if(openDevice(btHIDCtrl.devices[idx].bda, btHIDCtrl.devices[idx].transport, btHIDCtrl.devices[idx].addrType) == true)
-                {
-                    btHIDCtrl.devices[idx].open = true;
-                } else
-                {
-                    btHIDCtrl.devices[idx].nextCheckTime = milliSeconds() + 5000L;
-                }
+                openList.push_back(btHIDCtrl.devices[idx]);
             }
             nonFound = false;
         }
     }
-    if(nonFound)
+    xSemaphoreGive(btHIDCtrl.devMutex);
+
+    // Open attempts, the outcome is recorded against the device by openDevice.
+    for(std::size_t idx = 0; idx < openList.size(); idx++)
+    {
+        ESP_LOGI(TAG, ESP_BD_ADDR_STR " PAIREDOPEN", ESP_BD_ADDR_HEX(openList[idx].bda));
+        openDevice(openList[idx].bda, openList[idx].transport, openList[idx].addrType);
+    }
+
+    // Whilst the last connected device is being opened directly, a discovery scan runs alongside it so a device which has moved or is
+    // advertising connects without waiting for the direct open to time out. Whichever path connects a device first is used, the other
+    // opens nothing further.
+    if(nonFound || (btHIDCtrl.reconnect.active == true && deviceOpen() == false))
     {
         // Get list of devices which can be seen by bluetooth receiver and try to connect to known/pairing devices.
         getDeviceList(scanList, 5);
 
         for(int idx = 0; idx < scanList.size(); idx++)
         {
+            if(nonFound == false)
+            {
+                // The direct open connected during the scan, or the direct open of this device is still in progress.
+                if(deviceOpen() == true)
+                    break;
+                if(btHIDCtrl.reconnect.active == true && memcmp(scanList[idx].bda, btHIDCtrl.reconnect.directDev.bda, sizeof(esp_bd_addr_t)) == 0)
+                    continue;
+            }
             ESP_LOGI(TAG, ESP_BD_ADDR_STR " SCANOPEN", ESP_BD_ADDR_HEX(scanList[idx].bda));
             openDevice(scanList[idx].bda, scanList[idx].transport, scanList[idx].ble.addr_type);
         }
@@ -408,6 +550,23 @@ void BTHID::checkBTDevices(void)
     return;
 }
 
+// Method to check if any device is open.
+//
+bool BTHID::deviceOpen(void)
+{
+    // Locals.
+    //
+    bool                            open = false;
+
+    xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
+    for(std::size_t idx = 0; idx < btHIDCtrl.devices.size() && open == false; idx++)
+    {
+        open = btHIDCtrl.devices[idx].open;
+    }
+    xSemaphoreGive(btHIDCtrl.devMutex);
+    return(open);
+}
+
 //*********************************************************************************************************************************************
 //** Mouse handler Methods.
 //*********************************************************************************************************************************************
@@ -508,25 +667,84 @@ bool BTHID::setSampleRate(enum PS2Mouse::PS2_SAMPLING rate)
 //** Keyboard handler Methods.
 //*********************************************************************************************************************************************
 
-// Method to map a Bluetooth Media Key (ESP HIDH specific) Scan Code to its PS/2 equivalent or 0x0000 if not mappable.
-uint16_t BTHID::mapBTMediaToPS2(uint32_t key)
+// Method to compile the BT to PS/2 mapping tables into direct lookup tables. The mapping tables are searched in order and the first
+// entry matching the scan code, either unqualified or qualified by the exact BT control state, wins. The same precedence is preserved
+// by only recording a qualified entry as an override if it precedes the unqualified entry for its scan code, later ones can never match.
+//
+void BTHID::buildKeyMaps(void)
 {
     // Locals.
     //
-    uint16_t       retKey = 0x0000;
+    uint8_t        btKey;
+    uint16_t       ps2Key;
+    uint32_t       mediaKey;
+    bool           based[256];
+
+    memset(btHIDCtrl.kbd.usageMap, 0x00, sizeof(btHIDCtrl.kbd.usageMap));
+    memset(btHIDCtrl.kbd.overrideMap, 0x00, sizeof(btHIDCtrl.kbd.overrideMap));
+    memset(btHIDCtrl.kbd.mediaMap, 0x00, sizeof(btHIDCtrl.kbd.mediaMap));
+    memset(based, 0x00, sizeof(based));
+    btHIDCtrl.kbd.overrideCnt = 0;
 
-    // Loop through mapping table to find a match.
-    for(int idx=0; idx < btHIDCtrl.kbd.kmeMediaRows; idx++)
+    for(int idx=0; idx < btHIDCtrl.kbd.kmeRows; idx++)
     {
-        if(btHIDCtrl.kbd.kmeMedia[idx].mediaKey == key)
+        btKey  = btHIDCtrl.kbd.kme[idx].btKeyCode;
+        if(based[btKey])
+            continue;
+
+        // Mimicking the PS/2 class, set Function for certain mapped keys.
+        ps2Key = (uint16_t)btHIDCtrl.kbd.kme[idx].ps2KeyCode;
+        if((ps2Key <= PS2_KEY_SPACE || ps2Key >= PS2_KEY_F1) && ps2Key != PS2_KEY_BTICK && ps2Key != PS2_KEY_HASH && ps2Key != PS2_KEY_EUROPE2) ps2Key |= PS2_FUNCTION;
+
+        if(btHIDCtrl.kbd.kme[idx].btCtrl == BT_NONE)
         {
-            retKey = (btHIDCtrl.kbd.kmeMedia[idx].ps2Ctrl << 8) | btHIDCtrl.kbd.kmeMedia[idx].ps2Key;
-            break;
+            btHIDCtrl.kbd.usageMap[btKey] = ps2Key;
+            based[btKey] = true;
+        }
+        else if(btHIDCtrl.kbd.overrideCnt < MAX_BT2PS2_OVERRIDES)
+        {
+            btHIDCtrl.kbd.overrides[btHIDCtrl.kbd.overrideCnt].btKeyCode = btKey;
+            btHIDCtrl.kbd.overrides[btHIDCtrl.kbd.overrideCnt].btCtrl    = btHIDCtrl.kbd.kme[idx].btCtrl;
+            btHIDCtrl.kbd.overrides[btHIDCtrl.kbd.overrideCnt].ps2Key    = ps2Key;
+            btHIDCtrl.kbd.overrideCnt++;
+            btHIDCtrl.kbd.overrideMap[btKey >> 5] |= (1 << (btKey & 0x1F));
+        } else
+        {
+            ESP_LOGE(TAG, "Too many BT control qualified mappings, increase MAX_BT2PS2_OVERRIDES.");
         }
     }
 
+    // PS/2 control flags for every combination of the BT modifier byte.
+    for(int flags=0; flags < 256; flags++)
+    {
+        btHIDCtrl.kbd.modifierFlags[flags] = 0x0000;
+        if(flags & BT_CTRL_LEFT || flags & BT_CTRL_RIGHT)   btHIDCtrl.kbd.modifierFlags[flags] |= PS2_CTRL;
+        if(flags & BT_SHIFT_LEFT || flags & BT_SHIFT_RIGHT) btHIDCtrl.kbd.modifierFlags[flags] |= PS2_SHIFT;
+        if(flags & BT_ALT_LEFT)                             btHIDCtrl.kbd.modifierFlags[flags] |= PS2_ALT;
+        if(flags & BT_ALT_RIGHT)                            btHIDCtrl.kbd.modifierFlags[flags] |= PS2_ALT_GR;
+        if(flags & BT_GUI_LEFT || flags & BT_GUI_RIGHT)     btHIDCtrl.kbd.modifierFlags[flags] |= PS2_GUI;
+    }
+
+    // Media keys are single bits, index by bit position. First entry wins as per the table search.
+    for(int idx=btHIDCtrl.kbd.kmeMediaRows-1; idx >= 0; idx--)
+    {
+        mediaKey = btHIDCtrl.kbd.kmeMedia[idx].mediaKey;
+        if(mediaKey != 0 && (mediaKey & (mediaKey - 1)) == 0 && mediaKey < (1UL << BT_MEDIA_BITS))
+        {
+            btHIDCtrl.kbd.mediaMap[__builtin_ctz(mediaKey)] = (btHIDCtrl.kbd.kmeMedia[idx].ps2Ctrl << 8) | btHIDCtrl.kbd.kmeMedia[idx].ps2Key;
+        }
+    }
+}
+
+// Method to map a Bluetooth Media Key (ESP HIDH specific) Scan Code to its PS/2 equivalent or 0x0000 if not mappable.
+uint16_t BTHID::mapBTMediaToPS2(uint32_t key)
+{
+    // Only a single media key bit is mappable.
+    if(key == 0 || (key & (key - 1)) != 0 || key >= (1UL << BT_MEDIA_BITS))
+        return(0x0000);
+
     // Return map result or 0x00 if not mappable.
-    return(retKey);
+    return(btHIDCtrl.kbd.mediaMap[__builtin_ctz(key)]);
 }
 
 // Method to map a Bluetooth Scan Code to its PS/2 equivalent or 0x00 if not mappable.
@@ -534,49 +752,108 @@ uint16_t BTHID::mapBTtoPS2(uint8_t key)
 {
     // Locals.
     //
-    uint16_t      retKey = 0x0000;
+    uint16_t      retKey = btHIDCtrl.kbd.usageMap[key];
   
-    // Loop through mapping table to find a match.
-    for(int idx=0; idx < btHIDCtrl.kbd.kmeRows && retKey == 0x0000; idx++)
+    // Entries qualified by the BT control state take precedence. They are few, so only searched for the scan codes which have them.
+    if(btHIDCtrl.kbd.overrideMap[key >> 5] & (1 << (key & 0x1F)))
     {
-        // Find a match.
-        if(btHIDCtrl.kbd.kme[idx].btKeyCode == key && (btHIDCtrl.kbd.kme[idx].btCtrl == btHIDCtrl.kbd.btFlags || btHIDCtrl.kbd.kme[idx].btCtrl == BT_NONE))
+        for(int idx=0; idx < btHIDCtrl.kbd.overrideCnt; idx++)
         {
-            retKey = (uint16_t)btHIDCtrl.kbd.kme[idx].ps2KeyCode;
-            if((retKey <= PS2_KEY_SPACE || retKey >= PS2_KEY_F1) && retKey != PS2_KEY_BTICK && retKey != PS2_KEY_HASH && retKey != PS2_KEY_EUROPE2) retKey |= PS2_FUNCTION;
-            if(btHIDCtrl.kbd.btFlags & BT_CTRL_LEFT || btHIDCtrl.kbd.btFlags & BT_CTRL_RIGHT)   retKey |= PS2_CTRL;
-            if(btHIDCtrl.kbd.btFlags & BT_SHIFT_LEFT || btHIDCtrl.kbd.btFlags & BT_SHIFT_RIGHT) retKey |= PS2_SHIFT;
-            if(btHIDCtrl.kbd.btFlags & BT_ALT_LEFT)                                             retKey |= PS2_ALT;
-            if(btHIDCtrl.kbd.btFlags & BT_ALT_RIGHT)                                            retKey |= PS2_ALT_GR;
-            if(btHIDCtrl.kbd.btFlags & BT_GUI_LEFT || btHIDCtrl.kbd.btFlags & BT_GUI_RIGHT)     retKey |= PS2_GUI;
+            if(btHIDCtrl.kbd.overrides[idx].btKeyCode == key && btHIDCtrl.kbd.overrides[idx].btCtrl == btHIDCtrl.kbd.btFlags)
+            {
+                retKey = btHIDCtrl.kbd.overrides[idx].ps2Key;
+                break;
+            }
         }
     }
 
+    // Add in the PS/2 control flags for the current modifier state.
+    if(retKey != 0x0000)
+        retKey |= btHIDCtrl.kbd.modifierFlags[btHIDCtrl.kbd.btFlags & 0xFF];
+
     // Return map result or 0x00 if not mappable.
     return(retKey);
 }
 
-// Method to set a status LED on the keyboard.
+// Method to send the LED status byte to an open keyboard, or to all open keyboards if hdlDev is NULL. Devices being closed are skipped as
+// their handle is released by the close event. The device list is held whilst sending so the close event cannot release a handle in use.
+// Only called from the key processing thread.
 //
-void BTHID::setStatusLED(esp_hidh_dev_t *dev, uint8_t led)
+void BTHID::sendKeyboardLEDs(esp_hidh_dev_t *hdlDev)
+{
+    // Locals.
+
+    xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
+    for(std::size_t idx = 0; idx < btHIDCtrl.devices.size(); idx++)
+    {
+        if(btHIDCtrl.devices[idx].open == true && btHIDCtrl.devices[idx].closing == false && btHIDCtrl.devices[idx].hidhDevHdl != NULL &&
+           btHIDCtrl.devices[idx].usage == ESP_HID_USAGE_KEYBOARD && (hdlDev == NULL || btHIDCtrl.devices[idx].hidhDevHdl == hdlDev))
+        {
+            esp_hidh_dev_output_set(btHIDCtrl.devices[idx].hidhDevHdl, 0, 0x1, &btHIDCtrl.kbd.statusLED, 1);
+        }
+    }
+    xSemaphoreGive(btHIDCtrl.devMutex);
+    return;
+}
+
+// Method to set a status LED on the keyboards.
+//
+void BTHID::setStatusLED(uint8_t led)
 {
     // Locals
 
-    // Set flag in LED status byte then forward to the keyboard for actual display.
+    // Set flag in LED status byte then forward to the keyboards for actual display.
     btHIDCtrl.kbd.statusLED |= led;
-    esp_hidh_dev_output_set(dev, 0, 0x1, &btHIDCtrl.kbd.statusLED, 1);
+    sendKeyboardLEDs(NULL);
     return;
 }
 
-// Method to clear a status LED on the keyboard.
+// Method to clear a status LED on the keyboards.
 //
-void BTHID::clearStatusLED(esp_hidh_dev_t *dev, uint8_t led)
+void BTHID::clearStatusLED(uint8_t led)
 {
     // Locals
 
-    // Clear flag in LED status byte then forward to the keyboard for actual display.
+    // Clear flag in LED status byte then forward to the keyboards for actual display.
     btHIDCtrl.kbd.statusLED &= ~led;
-    esp_hidh_dev_output_set(dev, 0, 0x1, &btHIDCtrl.kbd.statusLED, 1);
+    sendKeyboardLEDs(NULL);
+    return;
+}
+
+// Method to set the keyboard LEDs (BT_LED_* bits) selected by mask on all connected keyboards to a host supplied state. Only the LEDs are updated,
+// the lock flags used in mapping are unchanged. Called from the host interface threads so the request is merged into any request not yet taken
+// and sent by the key processing thread.
+//
+void BTHID::setKeyboardLEDs(uint8_t leds, uint8_t mask)
+{
+    // Locals.
+
+    portENTER_CRITICAL(&btHIDCtrl.kbd.ledMutex);
+    btHIDCtrl.kbd.ledPending     = mergeLEDs(btHIDCtrl.kbd.ledPending, leds, mask);
+    btHIDCtrl.kbd.ledPendingMask = btHIDCtrl.kbd.ledPendingMask | mask;
+    portEXIT_CRITICAL(&btHIDCtrl.kbd.ledMutex);
+    return;
+}
+
+// Method to take a host LED request, if any, into the LED status byte and send it to all open keyboards. Called from the key processing thread.
+//
+void BTHID::applyKeyboardLEDs(void)
+{
+    // Locals.
+    uint8_t        leds;
+    uint8_t        mask;
+
+    portENTER_CRITICAL(&btHIDCtrl.kbd.ledMutex);
+    leds = btHIDCtrl.kbd.ledPending;
+    mask = btHIDCtrl.kbd.ledPendingMask;
+    btHIDCtrl.kbd.ledPendingMask = 0x00;
+    portEXIT_CRITICAL(&btHIDCtrl.kbd.ledMutex);
+
+    if(mask != 0x00)
+    {
+        btHIDCtrl.kbd.statusLED = mergeLEDs(btHIDCtrl.kbd.statusLED, leds, mask);
+        sendKeyboardLEDs(NULL);
+    }
     return;
 }
 
@@ -628,260 +905,312 @@ void BTHID::clearStatusLED(esp_hidh_dev_t *dev, uint8_t led)
 //
 // Mapped data/events is pushed onto a queue which is read by the calling API.
 //
-void BTHID::processBTKeys(void)
+// Modifier bits in the report modifier byte and the PS/2 make codes they generate, processed in one pass per report.
+static const struct {
+    uint8_t         btBit;
+    uint16_t        ps2Flag;
+    uint8_t         ps2Key;
+} btModifierMap[] = {
+    { BT_CTRL_LEFT,    PS2_CTRL,    PS2_KEY_L_CTRL  },
+    { BT_CTRL_RIGHT,   PS2_CTRL,    PS2_KEY_R_CTRL  },
+    { BT_SHIFT_LEFT,   PS2_SHIFT,   PS2_KEY_L_SHIFT },
+    { BT_SHIFT_RIGHT,  PS2_SHIFT,   PS2_KEY_R_SHIFT },
+    { BT_ALT_LEFT,     PS2_ALT,     PS2_KEY_L_ALT   },
+    { BT_ALT_RIGHT,    PS2_ALT_GR,  PS2_KEY_R_ALT   },
+    { BT_GUI_LEFT,     PS2_GUI,     PS2_KEY_L_GUI   },
+    { BT_GUI_RIGHT,    PS2_GUI,     PS2_KEY_R_GUI   },
+};
+
+// Lock keys which toggle a flag and keyboard LED on each make event.
+static const struct {
+    uint8_t         btKey;
+    uint16_t        btFlag;
+    uint8_t         led;
+} btLockKeyMap[] = {
+    { BT_KEY_CAPSLOCK,   BT_CAPS_LOCK,   BT_LED_CAPSLOCK   },
+    { BT_KEY_NUMLOCK,    BT_NUM_LOCK,    BT_LED_NUMLOCK    },
+    { BT_KEY_SCROLLLOCK, BT_SCROLL_LOCK, BT_LED_SCROLLLOCK },
+};
+
+// Method to locate the report state of a device, optionally allocating a free slot for a new device. Only called from the key processing
+// thread so no locking is required.
+//
+BTHID::t_devKeyState *BTHID::getDevKeyState(esp_hidh_dev_t *hdlDev, bool allocate)
+{
+    // Locals.
+    t_devKeyState *freeSlot = NULL;
+
+    for(int idx=0; idx < MAX_BT_KEY_DEVICES; idx++)
+    {
+        if(btHIDCtrl.kbd.devState[idx].hdlDev == hdlDev)
+            return(&btHIDCtrl.kbd.devState[idx]);
+        if(freeSlot == NULL && btHIDCtrl.kbd.devState[idx].hdlDev == NULL)
+            freeSlot = &btHIDCtrl.kbd.devState[idx];
+    }
+
+    // New device, take a free slot if available.
+    if(allocate)
+    {
+        if(freeSlot != NULL)
+        {
+            memset(freeSlot, 0x00, sizeof(t_devKeyState));
+            freeSlot->hdlDev = hdlDev;
+
+            // Bring the LEDs of a newly reporting keyboard into line with the current state.
+            if(btHIDCtrl.kbd.statusLED != 0x00)
+                sendKeyboardLEDs(hdlDev);
+        } else
+        {
+            btHIDCtrl.kbd.devOverflows++;
+        }
+    } else
+    {
+        freeSlot = NULL;
+    }
+    return(freeSlot);
+}
+
+// Method to process a keyboard report from a device. Each report is converted into a 256 bit usage bitmap, one bit per scan code. Make and
+// break sets are the difference between the current and previous bitmaps of the device, found a word at a time. The device changes are then
+// merged, each key being reference counted across the devices holding it, so a PS/2 make is only generated when the first device presses a key
+// and a break when the last releases it.
+//
+void BTHID::processKeyReport(t_devKeyState *dev, uint8_t *keys, uint16_t *batch, int &batchCnt)
 {
     // Locals.
-    uint16_t   genKey;
-    uint32_t   mediaKey;
-    KeyInfo    keyInfo;
+    uint32_t   keyMap[BT_KEYMAP_WORDS];
+    uint32_t   eventMap;
+    uint8_t    changed;
+    uint8_t    btKey;
+    uint16_t   mapKey;
+    bool       rollOver;
 
-    // Process all the queued event data.
-    while(xQueueReceive(btHIDCtrl.kbd.rawKeyQueue, &keyInfo, 0) == pdTRUE)
+    // Modifier edges are the bits which differ from the last report of the device.
+    changed = keys[0] ^ dev->lastModifiers;
+    for(int idx=0; idx < NUMELEM(btModifierMap) && changed != 0; idx++)
     {
-        // Process normal scancodes.
-        if(keyInfo.cControl == false)
+        if(changed & btModifierMap[idx].btBit)
         {
-            // Only process if the size is correct.
-            if(keyInfo.length <= MAX_KEYBOARD_DATA_BYTES)
+            // First device to press sends a Make event, last to release a BREAK event.
+            if(keys[0] & btModifierMap[idx].btBit)
             {
-                // Process control keys and set flags.
-                if(keyInfo.keys[0] & BT_CTRL_LEFT)   btHIDCtrl.kbd.btFlags |= BT_CTRL_LEFT;    else btHIDCtrl.kbd.btFlags &= ~(BT_CTRL_LEFT);
-                if(keyInfo.keys[0] & BT_SHIFT_LEFT)  btHIDCtrl.kbd.btFlags |= BT_SHIFT_LEFT;   else btHIDCtrl.kbd.btFlags &= ~(BT_SHIFT_LEFT);
-                if(keyInfo.keys[0] & BT_ALT_LEFT)    btHIDCtrl.kbd.btFlags |= BT_ALT_LEFT;     else btHIDCtrl.kbd.btFlags &= ~BT_ALT_LEFT;
-                if(keyInfo.keys[0] & BT_GUI_LEFT)    btHIDCtrl.kbd.btFlags |= BT_GUI_LEFT;     else btHIDCtrl.kbd.btFlags &= ~BT_GUI_LEFT;
-                if(keyInfo.keys[0] & BT_CTRL_RIGHT)  btHIDCtrl.kbd.btFlags |= BT_CTRL_RIGHT;   else btHIDCtrl.kbd.btFlags &= ~(BT_CTRL_RIGHT);
-                if(keyInfo.keys[0] & BT_SHIFT_RIGHT) btHIDCtrl.kbd.btFlags |= BT_SHIFT_RIGHT;  else btHIDCtrl.kbd.btFlags &= ~(BT_SHIFT_RIGHT);
-                if(keyInfo.keys[0] & BT_ALT_RIGHT)   btHIDCtrl.kbd.btFlags |= BT_ALT_RIGHT;    else btHIDCtrl.kbd.btFlags &= ~(BT_ALT_RIGHT);
-                if(keyInfo.keys[0] & BT_GUI_RIGHT)   btHIDCtrl.kbd.btFlags |= BT_GUI_RIGHT;    else btHIDCtrl.kbd.btFlags &= ~(BT_GUI_RIGHT);
-
-                // Process the control(modifier) keys and generate events.
-                // CTRL keys
-                if((keyInfo.keys[0] & BT_CTRL_LEFT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_CTRL_LEFT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_CTRL | PS2_FUNCTION | PS2_KEY_L_CTRL;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_CTRL_LEFT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_CTRL_LEFT) != 0)
-                {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_L_CTRL;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_CTRL_RIGHT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_CTRL_RIGHT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_CTRL | PS2_FUNCTION | PS2_KEY_R_CTRL;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_CTRL_RIGHT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_CTRL_RIGHT) != 0)
-                {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_R_CTRL;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                // SHIFT Keys
-                if((keyInfo.keys[0] & BT_SHIFT_LEFT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_SHIFT_LEFT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_SHIFT | PS2_FUNCTION | PS2_KEY_L_SHIFT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_SHIFT_LEFT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_SHIFT_LEFT) != 0)
-                {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_L_SHIFT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_SHIFT_RIGHT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_SHIFT_RIGHT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_SHIFT | PS2_FUNCTION | PS2_KEY_R_SHIFT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_SHIFT_RIGHT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_SHIFT_RIGHT) != 0)
-                {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_R_SHIFT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                // ALT Keys
-                if((keyInfo.keys[0] & BT_ALT_LEFT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_ALT_LEFT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_ALT | PS2_FUNCTION | PS2_KEY_L_ALT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_ALT_LEFT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_ALT_LEFT) != 0)
-                {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_L_ALT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_ALT_RIGHT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_ALT_RIGHT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_ALT_GR | PS2_FUNCTION | PS2_KEY_R_ALT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_ALT_RIGHT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_ALT_RIGHT) != 0)
+                if(btHIDCtrl.kbd.modRefCnt[idx]++ == 0)
                 {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_R_ALT;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                // GUI Keys
-                if((keyInfo.keys[0] & BT_GUI_LEFT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_GUI_LEFT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_GUI | PS2_FUNCTION | PS2_KEY_L_GUI;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_GUI_LEFT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_GUI_LEFT) != 0)
-                {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_L_GUI;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_GUI_RIGHT) != 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_GUI_RIGHT) == 0)
-                {
-                    // First time key was pressed send a Make event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_GUI | PS2_FUNCTION | PS2_KEY_R_GUI;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
-                }
-                if((keyInfo.keys[0] & BT_GUI_RIGHT) == 0 && (btHIDCtrl.kbd.lastKeys[0] & BT_GUI_RIGHT) != 0)
-                {
-                    // Key being released generates a BREAK event.
-                    genKey = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | PS2_KEY_R_GUI;
-                    xQueueSend(btHIDCtrl.kbd.keyQueue, &genKey, 0);
+                    btHIDCtrl.kbd.modifiers |= btModifierMap[idx].btBit;
+                    batch[batchCnt++] = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | btModifierMap[idx].ps2Flag | PS2_FUNCTION | btModifierMap[idx].ps2Key;
                 }
+            }
+            else if(btHIDCtrl.kbd.modRefCnt[idx] > 0 && --btHIDCtrl.kbd.modRefCnt[idx] == 0)
+            {
+                btHIDCtrl.kbd.modifiers &= ~btModifierMap[idx].btBit;
+                batch[batchCnt++] = (btHIDCtrl.kbd.ps2Flags & 0xFF00) | PS2_BREAK | PS2_FUNCTION | btModifierMap[idx].ps2Key;
+            }
+        }
+    }
+    dev->lastModifiers = keys[0];
+
+    // The BT flags mirror the merged modifier byte.
+    btHIDCtrl.kbd.btFlags = (btHIDCtrl.kbd.btFlags & 0xFF00) | btHIDCtrl.kbd.modifiers;
 
-                // Loop through the 6 scan codes and if a code appears in this set but not in the last generate a Make event.
-                //
-                for(int idx=1; idx < MAX_KEYBOARD_DATA_BYTES; idx++)
+    // Build the usage bitmap of the scan codes in this report. When more keys are pressed than the report can hold, the keyboard fills the
+    // scan codes with the roll over error code, the key state is then unknown so the previous state is retained.
+    memset(keyMap, 0x00, sizeof(keyMap));
+    rollOver = false;
+    for(int idx=1; idx < MAX_KEYBOARD_DATA_BYTES; idx++)
+    {
+        btKey = keys[idx];
+        if(btKey >= BT_KEY_A)
+            keyMap[btKey >> 5] |= (1 << (btKey & 0x1F));
+        else if(btKey != BT_KEY_NONE)
+            rollOver = true;
+    }
+    if(rollOver == true)
+        return;
+
+    // Break events, keys in the last bitmap but not in the current.
+    for(int word=0; word < BT_KEYMAP_WORDS; word++)
+    {
+        eventMap = dev->lastKeyMap[word] & ~keyMap[word];
+        while(eventMap != 0)
+        {
+            btKey = (word << 5) | __builtin_ctz(eventMap);
+            eventMap &= (eventMap - 1);
+
+            // Key still held by another device?
+            if(btHIDCtrl.kbd.keyRefCnt[btKey] == 0 || --btHIDCtrl.kbd.keyRefCnt[btKey] != 0)
+                continue;
+
+            // Send break event by adding PS2_BREAK control flag. Do not forward certain keys.
+            mapKey = mapBTtoPS2(btKey);
+            if(mapKey != 0x0000 && btKey != BT_KEY_NUMLOCK)
+                batch[batchCnt++] = mapKey | PS2_BREAK;
+        }
+    }
+
+    // Make events, keys in the current bitmap but not in the last.
+    for(int word=0; word < BT_KEYMAP_WORDS; word++)
+    {
+        eventMap = keyMap[word] & ~dev->lastKeyMap[word];
+        while(eventMap != 0)
+        {
+            btKey = (word << 5) | __builtin_ctz(eventMap);
+            eventMap &= (eventMap - 1);
+
+            // Key already held by another device?
+            if(btHIDCtrl.kbd.keyRefCnt[btKey]++ != 0)
+                continue;
+
+            // Process CAPS, NUM and SCROLL Lock, toggling the flag and keyboard LED.
+            for(int idx=0; idx < NUMELEM(btLockKeyMap); idx++)
+            {
+                if(btKey == btLockKeyMap[idx].btKey)
                 {
-                    if(keyInfo.keys[idx] != 0)
-                    {
-                        bool found = false;
-                        for(int idx2=1; idx2 < MAX_KEYBOARD_DATA_BYTES; idx2++)
-                        {
-                            if(keyInfo.keys[idx] == btHIDCtrl.kbd.lastKeys[idx2]) found = true;
-                        }
-                        if(!found)
-                        {
-                            // Process CAPS Lock.
-                            if(keyInfo.keys[idx] == BT_KEY_CAPSLOCK && (btHIDCtrl.kbd.btFlags & BT_CAPS_LOCK) == 0)
-                            {
-                                btHIDCtrl.kbd.btFlags |= BT_CAPS_LOCK;
-                                setStatusLED(keyInfo.hdlDev, BT_LED_CAPSLOCK);
-                            }
-                            else if(keyInfo.keys[idx] == BT_KEY_CAPSLOCK && (btHIDCtrl.kbd.btFlags & BT_CAPS_LOCK) != 0)
-                            {
-                                btHIDCtrl.kbd.btFlags &= ~(BT_CAPS_LOCK);
-                                clearStatusLED(keyInfo.hdlDev, BT_LED_CAPSLOCK);
-                            }
-                           
-                            // Process NUM Lock.
-                            if(keyInfo.keys[idx] == BT_KEY_NUMLOCK && (btHIDCtrl.kbd.btFlags & BT_NUM_LOCK) == 0)
-                            {
-                                btHIDCtrl.kbd.btFlags |= BT_NUM_LOCK;
-                                setStatusLED(keyInfo.hdlDev, BT_LED_NUMLOCK);
-                            }
-                            else if(keyInfo.keys[idx] == BT_KEY_NUMLOCK && (btHIDCtrl.kbd.btFlags & BT_NUM_LOCK) != 0)
-                            {
-                                btHIDCtrl.kbd.btFlags &= ~(BT_NUM_LOCK);
-                                clearStatusLED(keyInfo.hdlDev, BT_LED_NUMLOCK);
-                            }
-                           
-                            // Process SCROLL Lock.
-                            if(keyInfo.keys[idx] == BT_KEY_SCROLLLOCK && (btHIDCtrl.kbd.btFlags & BT_SCROLL_LOCK) == 0)
-                            {
-                                btHIDCtrl.kbd.btFlags |= BT_SCROLL_LOCK;
-                                setStatusLED(keyInfo.hdlDev, BT_LED_SCROLLLOCK);
-                            }
-                            else if(keyInfo.keys[idx] == BT_KEY_SCROLLLOCK && (btHIDCtrl.kbd.btFlags & BT_SCROLL_LOCK) != 0)
-                            {
-                                btHIDCtrl.kbd.btFlags &= ~(BT_SCROLL_LOCK);
-                                clearStatusLED(keyInfo.hdlDev, BT_LED_SCROLLLOCK);
-                            }
-
-                            // Mimicking the PS/2 class, set Function for certain mapped keys.
-                            uint16_t mapKey = mapBTtoPS2(keyInfo.keys[idx]);
-                            ESP_LOGI(TAG, "BTKEYMAP:%02x:%04x -> %04x", keyInfo.keys[idx], btHIDCtrl.kbd.btFlags, mapKey);
-                                    
-                            // Do not forward certain keys.
-                            if(mapKey != 0x0000 && keyInfo.keys[idx] != BT_KEY_NUMLOCK)
-                            {
-                                // Create a Make event.
-                                xQueueSend(btHIDCtrl.kbd.keyQueue, &mapKey, 0);
-                            }
-                        }
-                    }
-                    // Now repeat in reverse, has a break event occurred?
-                    if(btHIDCtrl.kbd.lastKeys[idx] != 0)
-                    {
-                        bool found = false;
-                        for(int idx2=1; idx2 < MAX_KEYBOARD_DATA_BYTES; idx2++)
-                        {
-                            if(btHIDCtrl.kbd.lastKeys[idx] == keyInfo.keys[idx2]) found = true;
-                        }
-                        if(!found)
-                        {
-                            uint16_t mapKey = mapBTtoPS2(btHIDCtrl.kbd.lastKeys[idx]);
-                            mapKey |= PS2_BREAK; // Send break event by adding PS2_BREAK control flag.
-                                    
-                            // Do not forward certain keys.
-                            if(mapKey != 0x0000 && btHIDCtrl.kbd.lastKeys[idx] != BT_KEY_NUMLOCK)
-                            {
-                                // Create a Break event.
-                                xQueueSend(btHIDCtrl.kbd.keyQueue, &mapKey, 0);
-                            }
-                        }
-                    }
+                    btHIDCtrl.kbd.btFlags ^= btLockKeyMap[idx].btFlag;
+                    if(btHIDCtrl.kbd.btFlags & btLockKeyMap[idx].btFlag)
+                        setStatusLED(btLockKeyMap[idx].led);
+                    else
+                        clearStatusLED(btLockKeyMap[idx].led);
                 }
             }
+
+            // Mimicking the PS/2 class, set Function for certain mapped keys.
+            mapKey = mapBTtoPS2(btKey);
+            ESP_LOGI(TAG, "BTKEYMAP:%02x:%04x -> %04x", btKey, btHIDCtrl.kbd.btFlags, mapKey);
+
+            // Do not forward certain keys.
+            if(mapKey != 0x0000 && btKey != BT_KEY_NUMLOCK)
+                batch[batchCnt++] = mapKey;
+        }
+    }
+
+    // Store the bitmap for the next report.
+    memcpy(dev->lastKeyMap, keyMap, sizeof(keyMap));
+    return;
+}
+
+// Method to process a media control report from a device, each media key bit is reference counted across devices as per the keyboard keys.
+//
+void BTHID::processMediaReport(t_devKeyState *dev, uint32_t mediaKey, uint16_t *batch, int &batchCnt)
+{
+    // Locals.
+    uint32_t   eventMap;
+    uint32_t   bit;
+    uint16_t   mapKey;
+
+    // Make and break events are the bits which have changed, only forwarded on the first press and last release.
+    eventMap = mediaKey ^ dev->lastMediaKey;
+    while(eventMap != 0)
+    {
+        bit = __builtin_ctz(eventMap);
+        eventMap &= (eventMap - 1);
+
+        if(mediaKey & (1 << bit))
+        {
+            if(btHIDCtrl.kbd.mediaRefCnt[bit]++ != 0)
+                continue;
+        }
+        else if(btHIDCtrl.kbd.mediaRefCnt[bit] == 0 || --btHIDCtrl.kbd.mediaRefCnt[bit] != 0)
+        {
+            continue;
+        }
+
+        // Releases carry the PS2_BREAK flag as per the keyboard keys.
+        mapKey = mapBTMediaToPS2(1 << bit);
+        if(mapKey != 0x0000)
+            batch[batchCnt++] = (mediaKey & (1 << bit)) ? mapKey : (mapKey | PS2_BREAK);
+    }
+
+    // Store last processed keymap for next loop.
+    dev->lastMediaKey = mediaKey;
+    return;
+}
+
+// Method to process the incoming Bluetooth keyboard data stream and convert it into PS/2 compatible values. 
+//
+// Reports from each device are diffed against that device's previous report and merged into a single pressed key view, so several keyboards
+// or combo devices can be used together. The PS/2 events generated by a report are assembled into a batch and only queued once complete,
+// reports are not taken from the raw queue unless the key queue can accept the largest possible batch, so events are never dropped.
+//
+void BTHID::processBTKeys(void)
+{
+    // Locals.
+    uint16_t       batch[MAX_KEYBOARD_EVENTS];
+    int            batchCnt;
+    uint8_t        releaseKeys[MAX_KEYBOARD_DATA_BYTES];
+    uint32_t       overflows;
+    t_devKeyState *dev;
+    KeyInfo        keyInfo;
+    t_keyEvent     keyEvent;
+
+    // Forward any LED state requested by the host.
+    applyKeyboardLEDs();
+
+    // Process all the queued event data whilst there is room for the resulting events.
+    while(uxQueueSpacesAvailable(btHIDCtrl.kbd.keyQueue) >= MAX_KEYBOARD_EVENTS && xQueueReceive(btHIDCtrl.kbd.rawKeyQueue, &keyInfo, 0) == pdTRUE)
+    {
+        batchCnt = 0;
+
+        // Closed device, release everything it holds and free its state.
+        if(keyInfo.closed == true)
+        {
+            dev = getDevKeyState(keyInfo.hdlDev, false);
+            if(dev != NULL)
+            {
+                memset(releaseKeys, 0x00, sizeof(releaseKeys));
+                processKeyReport(dev, releaseKeys, batch, batchCnt);
+                processMediaReport(dev, 0x00000000, batch, batchCnt);
+                dev->hdlDev = NULL;
+            }
+        }
+        // Process normal scancodes, only if the size is correct.
+        else if(keyInfo.cControl == false)
+        {
+            if(keyInfo.length <= MAX_KEYBOARD_DATA_BYTES && (dev = getDevKeyState(keyInfo.hdlDev, true)) != NULL)
+            {
+                processKeyReport(dev, keyInfo.keys, batch, batchCnt);
+            }
         }
         // Media control keys, for some reason these come as a seperate BT report and are 24bits wide.
         else
         {
-            // Only process if size is correct.
-            if(keyInfo.length == MAX_CCONTROL_DATA_BYTES)
+            if(keyInfo.length == MAX_CCONTROL_DATA_BYTES && (dev = getDevKeyState(keyInfo.hdlDev, true)) != NULL)
             {
                 // Assemble 24bit map, easier to work with.
-                mediaKey = (keyInfo.keys[0] << 16) | (keyInfo.keys[1] << 8) | (keyInfo.keys[2]);
-
-                // Check for key Make events.
-                for(int idx=0; idx < 23; idx++)
-                {
-                    uint32_t mask = (1 << idx);
-                  
-                    // Make event.
-                    if((mediaKey & mask) != 0 && (btHIDCtrl.kbd.lastMediaKey & mask) == 0)
-                    {
-                        uint16_t mapKey = mapBTMediaToPS2(mediaKey & mask);
-                        xQueueSend(btHIDCtrl.kbd.keyQueue, &mapKey, 0);
-
-                    }
-                    // Break event.
-                    if((mediaKey & mask) == 0 && (btHIDCtrl.kbd.lastMediaKey & mask) != 0)
-                    {
-                        uint16_t mapKey = mapBTMediaToPS2(btHIDCtrl.kbd.lastMediaKey & mask);
-                        xQueueSend(btHIDCtrl.kbd.keyQueue, &mapKey, 0);
-                    }
-                }
-
-                // Store last processed keymap for next loop.
-                btHIDCtrl.kbd.lastMediaKey = mediaKey;
+                processMediaReport(dev, (keyInfo.keys[0] << 16) | (keyInfo.keys[1] << 8) | (keyInfo.keys[2]), batch, batchCnt);
             }
         }
 
-        // Copy current to last.
-        for(int idx=0; idx < MAX_KEYBOARD_DATA_BYTES; idx++)
+        // Boot timeline, logged once when the first key is delivered.
+        if(batchCnt > 0 && btHIDCtrl.reconnect.keyTime == 0)
+        {
+            btHIDCtrl.reconnect.keyTime = esp_timer_get_time();
+            ESP_LOGW(TAG, "Boot timeline, BT setup:%ums, first open:%ums, first key:%ums", (uint32_t)(btHIDCtrl.reconnect.setupTime/1000),
+                                                                                          (uint32_t)(btHIDCtrl.reconnect.openTime/1000),
+                                                                                          (uint32_t)(btHIDCtrl.reconnect.keyTime/1000));
+        }
+
+        // Queue the batch of events generated by this report, space has already been confirmed.
+        keyEvent.time = keyInfo.time;
+        for(int idx=0; idx < batchCnt; idx++)
         {
-            btHIDCtrl.kbd.lastKeys[idx] = keyInfo.keys[idx];
+            keyEvent.key = batch[idx];
+            xQueueSend(btHIDCtrl.kbd.keyQueue, &keyEvent, 0);
         }
     }
 
+    // Reports waiting on room in the key queue, the application is not keeping up.
+    if(uxQueueMessagesWaiting(btHIDCtrl.kbd.rawKeyQueue) > 0)
+    {
+        Metrics::count(Metrics::COUNTER_KEY_QUEUE_FULL);
+    }
+
+    // Report any lost reports, once per change.
+    overflows = btHIDCtrl.kbd.rawOverflows + btHIDCtrl.kbd.devOverflows;
+    if(overflows != btHIDCtrl.kbd.reportedOverflows)
+    {
+        ESP_LOGW(TAG, "Key reports lost, raw queue full:%u, device table full:%u", btHIDCtrl.kbd.rawOverflows, btHIDCtrl.kbd.devOverflows);
+        btHIDCtrl.kbd.reportedOverflows = overflows;
+    }
     return;
 }
 
@@ -891,9 +1220,9 @@ uint16_t BTHID::getKey(uint32_t timeout)
 {
     // Locals.
     //
-    uint16_t  key;
-    bool      result = false;
-    uint32_t  timeCurrent = milliSeconds();
+    t_keyEvent keyEvent;
+    bool       result = false;
+    uint32_t   timeCurrent = milliSeconds();
 
     // Loop processing BT keys until a key received or timeout occurs.
     do {
@@ -901,15 +1230,26 @@ uint16_t BTHID::getKey(uint32_t timeout)
         processBTKeys();
 
         // Get the next key from the processed queue and return to caller.
-        result = (xQueueReceive(btHIDCtrl.kbd.keyQueue, &key, 0) == pdTRUE ? true : false);
+        result = (xQueueReceive(btHIDCtrl.kbd.keyQueue, &keyEvent, 0) == pdTRUE ? true : false);
     } while(timeout > 0 && timeCurrent+timeout > milliSeconds() && result == false);
-  
+
     // Return key if one has been read else 0x00.
-    return(result == true ? key : 0x00); 
+    if(result == true)
+    {
+        btHIDCtrl.kbd.keyTime = keyEvent.time;
+    }
+    return(result == true ? keyEvent.key : 0x00); 
+}
+
+// Method to return the time the report generating the key last returned by getKey was received, for latency metrics.
+//
+uint32_t BTHID::getKeyTime(void)
+{
+    return(btHIDCtrl.kbd.keyTime);
 }
 
 // Method to configure Bluetooth and register required callbacks.
-bool BTHID::setup(t_pairingHandler *handler)
+bool BTHID::setup(t_pairingHandler *handler, NVS *hdlNVS)
 {
     // Locals.
     //
@@ -926,10 +1266,17 @@ bool BTHID::setup(t_pairingHandler *handler)
 
         // Store current object for use in callback handlers.
         pBTHID = this;
+        btHIDCtrl.nvs = hdlNVS;
+        btHIDCtrl.reconnect.setupTime = esp_timer_get_time();
+
+        // The device list is shared between this thread, the HID event task and the reconnect thread.
+        btHIDCtrl.devMutex = xSemaphoreCreateMutex();
       
         // Create a FIFO queue to store incoming keyboard keys and mouse movements.
-        btHIDCtrl.kbd.rawKeyQueue   = xQueueCreate(10, sizeof(KeyInfo));
-        btHIDCtrl.kbd.keyQueue      = xQueueCreate(10, sizeof(uint16_t));
+        btHIDCtrl.kbd.rawKeyQueue   = xQueueCreate(MAX_RAW_KEY_QUEUE_SIZE, sizeof(KeyInfo));
+        btHIDCtrl.kbd.keyQueue      = xQueueCreate(MAX_KEY_QUEUE_SIZE, sizeof(t_keyEvent));
+        Metrics::addQueue("rawKeyQueue", btHIDCtrl.kbd.rawKeyQueue);
+        Metrics::addQueue("keyQueue", btHIDCtrl.kbd.keyQueue);
 
         ESP_ERROR_CHECK(esp_ble_gattc_register_callback(esp_hidh_gattc_event_handler));
         esp_hidh_config_t config = {
@@ -942,6 +1289,7 @@ bool BTHID::setup(t_pairingHandler *handler)
       
         // Go through bonded lists and add to our control vector or known devices.
         // First BLE devices.
+        xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
         int bleDevNum = esp_ble_get_bond_device_num();
         esp_ble_bond_dev_t *bleDevList = (esp_ble_bond_dev_t *)malloc(sizeof(esp_ble_bond_dev_t) * bleDevNum);
         esp_ble_get_bond_device_list(&bleDevNum, bleDevList);
@@ -951,7 +1299,9 @@ bool BTHID::setup(t_pairingHandler *handler)
             memcpy(device.bda, bleDevList[idx].bd_addr, sizeof(esp_bd_addr_t));
             device.transport = ESP_HID_TRANSPORT_BLE;
             device.addrType = BLE_ADDR_TYPE_RANDOM;
+            device.hidhDevHdl = NULL;
             device.open = false;
+            device.closing = false;
             device.nextCheckTime = milliSeconds() + 3000L;
             btHIDCtrl.devices.push_back(device);
             ESP_LOGW(TAG, "BLE BONDED DEVICE: " ESP_BD_ADDR_STR, ESP_BD_ADDR_HEX(bleDevList[idx].bd_addr));
@@ -968,12 +1318,49 @@ bool BTHID::setup(t_pairingHandler *handler)
             memcpy(device.bda, btDevList[idx], sizeof(esp_bd_addr_t));
             device.transport = ESP_HID_TRANSPORT_BT;
             device.addrType = BLE_ADDR_TYPE_RANDOM;
+            device.hidhDevHdl = NULL;
             device.open = false;
+            device.closing = false;
             device.nextCheckTime = milliSeconds() + 3000L;
             btHIDCtrl.devices.push_back(device);
             ESP_LOGW(TAG, "BT BONDED DEVICE: " ESP_BD_ADDR_STR, ESP_BD_ADDR_HEX(btDevList[idx]));
         }
         free(btDevList);
+
+        // Open the last connected device directly rather than waiting on the periodic check, it is held back from the check until the open completes.
+        if(btHIDCtrl.nvs != NULL && btHIDCtrl.nvs->retrieveData(BTHID_NVS_KEY, &btHIDCtrl.reconnect.lastDev, sizeof(t_lastDevice)) == true && btHIDCtrl.reconnect.lastDev.valid == BTHID_LASTDEV_VALID)
+        {
+            bool found = false;
+            for(std::size_t idx = 0; idx < btHIDCtrl.devices.size(); idx++)
+            {
+                if(memcmp(btHIDCtrl.devices[idx].bda, btHIDCtrl.reconnect.lastDev.bda, sizeof(esp_bd_addr_t)) == 0)
+                {
+                    btHIDCtrl.devices[idx].addrType = btHIDCtrl.reconnect.lastDev.addrType;
+                    btHIDCtrl.devices[idx].nextCheckTime = milliSeconds() + 5000L;
+                    found = true;
+                }
+            }
+
+            // Only reopen devices which are still bonded, a cleared pairing invalidates the record.
+            xSemaphoreGive(btHIDCtrl.devMutex);
+            if(found == true)
+            {
+                // The record is updated by the first device to open, the direct open works from its own copy.
+                btHIDCtrl.reconnect.directDev = btHIDCtrl.reconnect.lastDev;
+                btHIDCtrl.reconnect.active = true;
+                if(::xTaskCreatePinnedToCore(&reconnectTask, "BTRECONNECT", 4096, this, 0, NULL, 0) != pdPASS)
+                {
+                    btHIDCtrl.reconnect.active = false;
+                }
+            } else
+            {
+                btHIDCtrl.reconnect.lastDev.valid = 0x00;
+            }
+        } else
+        {
+            xSemaphoreGive(btHIDCtrl.devMutex);
+            btHIDCtrl.reconnect.lastDev.valid = 0x00;
+        }
     }
   
     // False = failed to setup, true = success.
@@ -985,15 +1372,35 @@ BTHID::BTHID(void)
 {
     btHIDCtrl.kbd.rawKeyQueue   = NULL;
     btHIDCtrl.kbd.keyQueue      = NULL;
-    memset((void *)&btHIDCtrl.kbd.lastKeys, 0x00, 6);
-    btHIDCtrl.kbd.lastMediaKey  = 0x00000000;
+    btHIDCtrl.nvs               = NULL;
+    btHIDCtrl.devMutex          = NULL;
+    memset((void *)&btHIDCtrl.reconnect.lastDev, 0x00, sizeof(t_lastDevice));
+    memset((void *)&btHIDCtrl.reconnect.directDev, 0x00, sizeof(t_lastDevice));
+    btHIDCtrl.reconnect.dirty   = false;
+    btHIDCtrl.reconnect.active  = false;
+    btHIDCtrl.reconnect.setupTime = 0;
+    btHIDCtrl.reconnect.openTime  = 0;
+    btHIDCtrl.reconnect.keyTime   = 0;
+    memset((void *)&btHIDCtrl.kbd.devState, 0x00, sizeof(btHIDCtrl.kbd.devState));
+    memset((void *)&btHIDCtrl.kbd.keyRefCnt, 0x00, sizeof(btHIDCtrl.kbd.keyRefCnt));
+    memset((void *)&btHIDCtrl.kbd.modRefCnt, 0x00, sizeof(btHIDCtrl.kbd.modRefCnt));
+    memset((void *)&btHIDCtrl.kbd.mediaRefCnt, 0x00, sizeof(btHIDCtrl.kbd.mediaRefCnt));
+    btHIDCtrl.kbd.modifiers     = 0x00;
+    btHIDCtrl.kbd.rawOverflows  = 0;
+    btHIDCtrl.kbd.devOverflows  = 0;
+    btHIDCtrl.kbd.reportedOverflows = 0;
+    btHIDCtrl.kbd.keyTime       = 0;
     btHIDCtrl.kbd.ps2Flags      = 0x0000;
     btHIDCtrl.kbd.btFlags       = 0x0000;
     btHIDCtrl.kbd.statusLED     = 0x00;
+    btHIDCtrl.kbd.ledPending    = 0x00;
+    btHIDCtrl.kbd.ledPendingMask = 0x00;
+    btHIDCtrl.kbd.ledMutex      = portMUX_INITIALIZER_UNLOCKED;
     btHIDCtrl.kbd.kme           = BTKeyToPS2.kme;
     btHIDCtrl.kbd.kmeRows       = MAX_BT2PS2_MAP_ENTRIES;
     btHIDCtrl.kbd.kmeMedia      = MediaKeyToPS2.kme;
     btHIDCtrl.kbd.kmeMediaRows  = MAX_BTMEDIA2PS2_MAP_ENTRIES;
+    buildKeyMaps();
     btHIDCtrl.ms.mouseDataCallback = NULL;
     btHIDCtrl.ms.resolution     = 8;
     btHIDCtrl.ms.scaling        = 1;
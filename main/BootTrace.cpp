@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            BootTrace.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     A boot timeline trace. Start up stages are timestamped against the high resolution
+//                  system timer. When the host interface is live the timeline is logged and copied into
+//                  RTC memory which survives the restart into WiFi mode, so the web interface can report
+//                  the timings of the last interface boot.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "BootTrace.h"
+
+// Timeline of the current boot, held in normal RAM until complete.
+BootTrace::t_bootTimeline                   BootTrace::current  = { BOOTTRACE_MAGIC, 0, {} };
+
+// Timeline of the last completed interface boot, not initialised so it persists across a software restart.
+RTC_NOINIT_ATTR BootTrace::t_bootTimeline   BootTrace::lastBoot;
+
+// Method to record the completion of a start up stage.
+//
+void BootTrace::mark(const char *stage)
+{
+    if(current.stageCount < BOOTTRACE_MAX_STAGES)
+    {
+        strncpy(current.stage[current.stageCount].stage, stage, BOOTTRACE_STAGE_LEN - 1);
+        current.stage[current.stageCount].stage[BOOTTRACE_STAGE_LEN - 1] = '\0';
+        current.stage[current.stageCount].timeUs = (uint32_t)esp_timer_get_time();
+        current.stageCount++;
+    }
+    return;
+}
+
+// Method to close the timeline once the host interface is live. The timeline is logged and retained for the web interface.
+//
+void BootTrace::commit(void)
+{
+    for(uint32_t idx=0; idx < current.stageCount; idx++)
+    {
+        ESP_LOGW(TAG, "%-*s %6u.%03ums", BOOTTRACE_STAGE_LEN, current.stage[idx].stage, current.stage[idx].timeUs / 1000, current.stage[idx].timeUs % 1000);
+    }
+    memcpy(&lastBoot, &current, sizeof(t_bootTimeline));
+    return;
+}
+
+// Method to retrieve the timeline of the last completed interface boot, time in uS. Empty if there was none since power on.
+//
+void BootTrace::getTimeline(std::vector<std::pair<std::string, uint32_t>>& timeline)
+{
+    timeline.clear();
+    if(lastBoot.magic == BOOTTRACE_MAGIC && lastBoot.stageCount <= BOOTTRACE_MAX_STAGES)
+    {
+        for(uint32_t idx=0; idx < lastBoot.stageCount; idx++)
+        {
+            lastBoot.stage[idx].stage[BOOTTRACE_STAGE_LEN - 1] = '\0';
+            timeline.push_back(std::make_pair(std::string(lastBoot.stage[idx].stage), lastBoot.stage[idx].timeUs));
+        }
+    }
+    return;
+}
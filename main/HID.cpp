@@ -17,6 +17,13 @@
 //            v1.02 Jun 2022 - Updates to support Bluetooth keyboard and mouse. The mouse can be
 //                             a primary device or a secondary device for hosts which support
 //                             keyboard and mouse over one physical port.
+//            v1.03 Oct 2026 - Device receive time of each key read, for latency metrics.
+//            v1.04 Oct 2026 - Configuration saved before mouse acceleration was added is migrated.
+//            v1.05 Oct 2026 - PS/2 only keyboard for WiFi mode, no Bluetooth fallback as the radio is in use.
+//            v1.06 Oct 2026 - A PS/2 mouse configured at startup is marked active so it is not reset again,
+//                             which left it with reporting disabled.
+//            v1.07 Oct 2026 - Bluetooth disabled and enabled in place for a switch to WiFi mode without a restart.
+//            v1.08 Oct 2026 - In place Bluetooth disable and enable withdrawn, a switch to WiFi restarts.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -151,6 +158,7 @@ uint16_t HID::read(void)
                     if((result = ps2Keyboard->read()) != 0)
                     { 
                         hidCtrl.ps2CheckTimer = xTaskGetTickCount();
+                        hidCtrl.keyTime = ps2Keyboard->readTime();
                     } 
                     break;
 
@@ -160,6 +168,7 @@ uint16_t HID::read(void)
                     if((result = btHID->getKey(0)) != 0)
                     { 
                         hidCtrl.ps2CheckTimer = xTaskGetTickCount();
+                        hidCtrl.keyTime = btHID->getKeyTime();
                     }
                     break;
         
@@ -180,6 +189,83 @@ uint16_t HID::read(void)
     return(result);
 }
 
+// Method to return the time the key last returned by read was received by the keyboard device, PS/2 byte or Bluetooth report. Used to
+// measure key latency, only valid after read has returned a key.
+//
+uint32_t HID::readTime(void)
+{
+    return(hidCtrl.keyTime);
+}
+
+// Method to apply the host keyboard state to a PS/2 keyboard. The caller must hold the internal mutex. Bluetooth keyboards have no
+// typematic, repeats are generated by the host from the make/break pair, so only the LEDs are forwarded.
+//
+void HID::applyKeyboardState(void)
+{
+    // Locals.
+    //
+    uint8_t    btLeds;
+    uint8_t    btMask;
+
+    switch(hidCtrl.hidDevice)
+    {
+        case HID_DEVICE_PS2_KEYBOARD:
+            ps2Keyboard->setLock(hidCtrl.kbdLocks);
+            if(hidCtrl.hostRepeat)
+                ps2Keyboard->typematic(HID_TYPEMATIC_HOST_RATE, HID_TYPEMATIC_HOST_DELAY);
+            else
+                ps2Keyboard->typematic(HID_TYPEMATIC_DEFAULT_RATE, HID_TYPEMATIC_DEFAULT_DELAY);
+            break;
+
+        case HID_DEVICE_BLUETOOTH:
+        case HID_DEVICE_BT_KEYBOARD:
+            // PS/2 lock bits differ in order to the BT LED report bits.
+            btLeds = ((hidCtrl.kbdLocks    & PS2_LOCK_NUM)    ? BT_LED_NUMLOCK    : 0x00) |
+                     ((hidCtrl.kbdLocks    & PS2_LOCK_CAPS)   ? BT_LED_CAPSLOCK   : 0x00) |
+                     ((hidCtrl.kbdLocks    & PS2_LOCK_SCROLL) ? BT_LED_SCROLLLOCK : 0x00);
+            btMask = ((hidCtrl.kbdLockMask & PS2_LOCK_NUM)    ? BT_LED_NUMLOCK    : 0x00) |
+                     ((hidCtrl.kbdLockMask & PS2_LOCK_CAPS)   ? BT_LED_CAPSLOCK   : 0x00) |
+                     ((hidCtrl.kbdLockMask & PS2_LOCK_SCROLL) ? BT_LED_SCROLLLOCK : 0x00);
+            btHID->setKeyboardLEDs(btLeds, btMask);
+            break;
+
+        default:
+            break;
+    }
+    return;
+}
+
+// Method to set the keyboard lock LEDs (PS2_LOCK_* bits) selected by mask to the state held by the host, the remaining LEDs are left as set
+// by the keyboard.
+//
+void HID::setKeyboardLEDs(uint8_t locks, uint8_t mask)
+{
+    if(hidCtrl.mutexInternal != NULL && xSemaphoreTake(hidCtrl.mutexInternal, (TickType_t)100) == pdTRUE)
+    {
+        if(hidCtrl.hidDevice == HID_DEVICE_PS2_KEYBOARD)
+            hidCtrl.kbdLocks = ps2Keyboard->getLock();
+        hidCtrl.kbdLocks    = (hidCtrl.kbdLocks & ~mask) | (locks & mask);
+        hidCtrl.kbdLockMask = mask;
+        applyKeyboardState();
+        xSemaphoreGive(hidCtrl.mutexInternal);
+    }
+    return;
+}
+
+// Method to indicate that the host interface generates key repeats. The device typematic is slowed to its minimum so repeated makes, which the
+// interface discards, are infrequent.
+//
+void HID::setHostRepeat(bool hostRepeat)
+{
+    if(hidCtrl.mutexInternal != NULL && xSemaphoreTake(hidCtrl.mutexInternal, (TickType_t)100) == pdTRUE)
+    {
+        hidCtrl.hostRepeat = hostRepeat;
+        applyKeyboardState();
+        xSemaphoreGive(hidCtrl.mutexInternal);
+    }
+    return;
+}
+
 // Method to allow update of the mouse resolution. The config is updated and the device configured but the change is not persisted.
 //
 void HID::setMouseResolution(enum HID_MOUSE_RESOLUTION resolution)
@@ -199,6 +285,14 @@ void HID::setMouseHostScaling(enum HID_MOUSE_HOST_SCALING scaling)
     hidConfig.host.scaling = scaling;
 }
 
+// Method to allow update of the host side acceleration curve. The config is updated and the curve rebuilt on the next report. The change is not persisted.
+//
+void HID::setMouseHostAcceleration(enum HID_MOUSE_HOST_ACCEL acceleration)
+{
+    // Update the mouse acceleration in the config.
+    hidConfig.host.acceleration = acceleration;
+}
+
 // Method to allow update of the mouse scaling. The config is updated and the device configured but the change is not persisted.
 //
 void HID::setMouseScaling(enum HID_MOUSE_SCALING scaling)
@@ -307,6 +401,114 @@ void HID::processPS2Mouse( void )
     return;
 }
 
+// Method to rebuild the fixed point scaling gains and acceleration curve when the mouse configuration changes. The check is a few compares so
+// it is made on every report, the rebuild itself only occurs when a setting has actually changed.
+//
+void HID::updateMouseScaling(void)
+{
+    // Locals.
+    //
+    int32_t               resDivisor;
+    int32_t               hostDivisor;
+    int32_t               step;
+    int                   curve;
+
+    // Acceleration curves, Q8.8 maximum multiplier with the speed (host counts per report) at which acceleration starts and the span over which it
+    // ramps up to the maximum.
+    static const struct { uint16_t maxMult; uint8_t threshold; uint8_t span; } accelCurves[] = {
+        { 256,  0,  1 },                                                // HID_MOUSE_HOST_ACCEL_OFF
+        { 512,  3, 24 },                                                // HID_MOUSE_HOST_ACCEL_LOW
+        { 768,  2, 16 },                                                // HID_MOUSE_HOST_ACCEL_MEDIUM
+        { 1024, 1, 12 },                                                // HID_MOUSE_HOST_ACCEL_HIGH
+    };
+
+    // Nothing to do if the tables reflect the current configuration.
+    if(hidCtrl.scale.valid && hidCtrl.scale.resolution == hidConfig.mouse.resolution && hidCtrl.scale.scaling == hidConfig.host.scaling && hidCtrl.scale.acceleration == hidConfig.host.acceleration)
+        return;
+
+    // Resolution divisor, the data is normalised to the finest (1/8mm) resolution.
+    switch(hidConfig.mouse.resolution)
+    {
+        case HID_MOUSE_RESOLUTION_1_1:
+            resDivisor = 8;
+            break;
+        case HID_MOUSE_RESOLUTION_1_2:
+            resDivisor = 4;
+            break;
+        case HID_MOUSE_RESOLUTION_1_4:
+            resDivisor = 2;
+            break;
+        case HID_MOUSE_RESOLUTION_1_8:
+        default:
+            resDivisor = 1;
+            break;
+    }
+
+    // Host divisor, 1:1 .. 1:5.
+    hostDivisor = (hidConfig.host.scaling >= HID_MOUSE_HOST_SCALING_1_1 && hidConfig.host.scaling <= HID_MOUSE_HOST_SCALING_1_5) ? static_cast<int32_t>(hidConfig.host.scaling) + 1 : 1;
+
+    // Q16.16 gains, PS/2 is taken at face value, Bluetooth movement is 12bit so it is reduced by a further 16.
+    hidCtrl.scale.gain[0] = (int32_t)((1UL << 16) / (resDivisor * hostDivisor));
+    hidCtrl.scale.gain[1] = (int32_t)((1UL << 16) / (16 * resDivisor * hostDivisor));
+
+    // Precompute the acceleration multipliers, a linear ramp from 1:1 at the threshold speed to the maximum multiplier at the end of the span.
+    curve = (hidConfig.host.acceleration >= HID_MOUSE_HOST_ACCEL_OFF && hidConfig.host.acceleration <= HID_MOUSE_HOST_ACCEL_HIGH) ? static_cast<int>(hidConfig.host.acceleration) : 0;
+    for(int idx = 0; idx < HID_MOUSE_ACCEL_TABLE_SIZE; idx++)
+    {
+        step = idx - accelCurves[curve].threshold;
+        step = step < 0 ? 0 : step > accelCurves[curve].span ? accelCurves[curve].span : step;
+        hidCtrl.scale.accelTable[idx] = (uint16_t)(256 + ((accelCurves[curve].maxMult - 256) * step) / accelCurves[curve].span);
+    }
+
+    // Remainders belong to the previous scaling so discard them.
+    for(int idx = 0; idx < 2; idx++)
+    {
+        hidCtrl.scale.remX[idx] = 0;
+        hidCtrl.scale.remY[idx] = 0;
+    }
+    hidCtrl.scale.resolution   = hidConfig.mouse.resolution;
+    hidCtrl.scale.scaling      = hidConfig.host.scaling;
+    hidCtrl.scale.acceleration = hidConfig.host.acceleration;
+    hidCtrl.scale.valid        = true;
+}
+
+// Method to scale raw device movement into host counts. The movement is multiplied by the Q16.16 gain and the acceleration multiplier for the
+// current speed, the remainder from the previous report is added and the integer part returned. The fraction left over is carried forward so the
+// cumulative error never exceeds one host count regardless of how slow or long the movement is.
+//
+void HID::scaleMouseData(uint8_t src, int32_t xIn, int32_t yIn, int32_t *xOut, int32_t *yOut)
+{
+    // Locals.
+    //
+    int64_t               xScaled;
+    int64_t               yScaled;
+    int64_t               xTotal;
+    int64_t               yTotal;
+    uint32_t              speed;
+
+    // Ensure the tables reflect the current configuration.
+    updateMouseScaling();
+    src = src > 1 ? 1 : src;
+
+    // Apply the gain, giving Q16.16 host counts.
+    xScaled = (int64_t)xIn * hidCtrl.scale.gain[src];
+    yScaled = (int64_t)yIn * hidCtrl.scale.gain[src];
+
+    // Speed is the Manhattan length of the movement in host counts, used to index the acceleration curve.
+    speed   = (uint32_t)(((xScaled < 0 ? -xScaled : xScaled) + (yScaled < 0 ? -yScaled : yScaled)) >> 16);
+    speed   = speed >= HID_MOUSE_ACCEL_TABLE_SIZE ? HID_MOUSE_ACCEL_TABLE_SIZE - 1 : speed;
+    xScaled = (xScaled * hidCtrl.scale.accelTable[speed]) >> 8;
+    yScaled = (yScaled * hidCtrl.scale.accelTable[speed]) >> 8;
+
+    // Add in the carried remainder, the integer part (floor) is output and the fraction, always 0..65535, is carried.
+    xTotal  = xScaled + hidCtrl.scale.remX[src];
+    yTotal  = yScaled + hidCtrl.scale.remY[src];
+    *xOut   = (int32_t)(xTotal >> 16);
+    *yOut   = (int32_t)(yTotal >> 16);
+    hidCtrl.scale.remX[src] = (int32_t)(xTotal - ((int64_t)(*xOut) << 16));
+    hidCtrl.scale.remY[src] = (int32_t)(yTotal - ((int64_t)(*yOut) << 16));
+}
+
 // Callback to process mouse data originating from a PS/2 or Bluetooth mouse. The data is encapsulated in a PS/2
 // message and processed into a host message.
 //
@@ -347,7 +549,7 @@ void HID::mouseReceiveData(uint8_t src, PS2Mouse::MouseData mouseData)
     {
         // If configuration mode is enabled then the wheel value is used to increment/decrement an option value.
         //
-        int16_t wheel = -(((hidCtrl.mouseData.wheel & 0x80) ? 0xFF80 : 0x0000) | (hidCtrl.mouseData.wheel & 0x7F));
+        int16_t wheel = -hidCtrl.mouseData.wheel;
         if(hidCtrl.configMode != HOST_CONFIG_OFF)
         {
             hidCtrl.wheelCnt += wheel;
@@ -436,69 +638,9 @@ void HID::mouseReceiveData(uint8_t src, PS2Mouse::MouseData mouseData)
         }
       
         // Build the next message with all data, scaled and filtered as necessary.
-        // Firstly, for PS/2 extend the X,Y 9bit movement values into 16bit for easier manipulation.
-        if(src == 0)
-        {
-            mouseMsg.xPos = (((hidCtrl.mouseData.status & 0x10) ? 0xFF00 : 0x0000) | hidCtrl.mouseData.position.x);
-            mouseMsg.yPos = (((hidCtrl.mouseData.status & 0x20) ? 0xFF00 : 0x0000) | hidCtrl.mouseData.position.y);
-        } else
-        {
-            mouseMsg.xPos = hidCtrl.mouseData.position.x / 16;
-            mouseMsg.yPos = hidCtrl.mouseData.position.y / 16;
-        }
-
-        switch(hidConfig.mouse.resolution)
-        {
-            case HID_MOUSE_RESOLUTION_1_1:
-                mouseMsg.xPos = mouseMsg.xPos / 8;
-                mouseMsg.yPos = mouseMsg.yPos / 8;
-                break;
-
-            case HID_MOUSE_RESOLUTION_1_2:
-                mouseMsg.xPos = mouseMsg.xPos / 4;
-                mouseMsg.yPos = mouseMsg.yPos / 4;
-                break;
-
-            case HID_MOUSE_RESOLUTION_1_4:
-                mouseMsg.xPos = mouseMsg.xPos / 2;
-                mouseMsg.yPos = mouseMsg.yPos / 2;
-                break;
-
-            case HID_MOUSE_RESOLUTION_1_8:
-            default:
-                mouseMsg.xPos = mouseMsg.xPos / 1;
-                mouseMsg.yPos = mouseMsg.yPos / 1;
-                break;
-        }
-
-        // Perform any in-situ scaling and adjustments.
-        switch(hidConfig.host.scaling)
-        {
-            case HID::HID_MOUSE_HOST_SCALING_1_2:
-                mouseMsg.xPos = mouseMsg.xPos / 2;
-                mouseMsg.yPos = mouseMsg.yPos / 2;
-                break;
-    
-            case HID::HID_MOUSE_HOST_SCALING_1_3:
-                mouseMsg.xPos = mouseMsg.xPos / 3;
-                mouseMsg.yPos = mouseMsg.yPos / 3;
-                break;
-    
-            case HID::HID_MOUSE_HOST_SCALING_1_4:
-                mouseMsg.xPos = mouseMsg.xPos / 4;
-                mouseMsg.yPos = mouseMsg.yPos / 4;
-                break;
-    
-            case HID::HID_MOUSE_HOST_SCALING_1_5:
-                mouseMsg.xPos = mouseMsg.xPos / 5;
-                mouseMsg.yPos = mouseMsg.yPos / 5;
-                break;
-    
-            // No scaling needed for 1:1, the data is clipped at 8bit 2's compliment threshold and overflow/underflow set accordingly.
-            case HID::HID_MOUSE_HOST_SCALING_1_1:
-            default:
-                break;
-        }
+        // PS/2 data arrives as sign extended movement accumulated since the last poll and Bluetooth data as 12bit movement, both are converted to host
+        // counts by the fixed point scaling stage which carries the sub-count remainder between reports.
+        scaleMouseData(src, hidCtrl.mouseData.position.x, hidCtrl.mouseData.position.y, &mouseMsg.xPos, &mouseMsg.yPos);
 
         // Add in status and wheel data to complete message.
         //
@@ -586,6 +728,10 @@ bool HID::checkPS2Keyboard(void)
         {
             ESP_LOGW(HIDTAG, "PS2 keyboard detected and online.");
             hidCtrl.ps2Active = 1;
+
+            // A reconnected keyboard powers up with its own defaults, restore the host state.
+            if(hidCtrl.kbdLocks != 0x00 || hidCtrl.hostRepeat)
+                applyKeyboardState();
     
             // If indication was given that the keyboard has gone offline, issue a new message to show it is back online.
             // This coding is necessary due to KVM devices which can idle the PS/2 connection randomly or when another device such as the mouse is in use.
@@ -835,6 +981,8 @@ bool HID::persistConfig(void)
 void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
 {
     // Locals
+    t_hidConfigV1 hidConfigV1;
+    bool          persist = false;
     #define   INITTAG "init"
 
     // Initialise variables.
@@ -842,9 +990,26 @@ void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
     hidCtrl.dataCallback  = NULL;
     hidCtrl.configMode    = HOST_CONFIG_OFF;
     hidCtrl.loopTimer     = milliSeconds();
-
-    // Retrieve configuration, if it doesnt exist, set defaults.
+    hidCtrl.scale.valid   = false;
+    hidCtrl.kbdLocks      = 0x00;
+    hidCtrl.kbdLockMask   = 0x00;
+    hidCtrl.hostRepeat    = false;
+    hidCtrl.active        = false;
+    hidCtrl.updated       = false;
+
+    // Retrieve configuration, migrating one saved before acceleration was added, if it doesnt exist, set defaults.
     //
+    if(nvs->dataSize(className) == sizeof(t_hidConfigV1) && nvs->retrieveData(className, &hidConfigV1, sizeof(t_hidConfigV1)) == true)
+    {
+        ESP_LOGW(INITTAG, "HID configuration migrated, mouse acceleration off.");
+        hidConfig.mouse.resolution           = hidConfigV1.mouse.resolution;
+        hidConfig.mouse.scaling              = hidConfigV1.mouse.scaling;
+        hidConfig.mouse.sampleRate           = hidConfigV1.mouse.sampleRate;
+        hidConfig.host.scaling               = hidConfigV1.host.scaling;
+        hidConfig.host.acceleration          = HID_MOUSE_HOST_ACCEL_OFF;
+        hidConfig.params.optionAdvanceDelay  = hidConfigV1.params.optionAdvanceDelay;
+        persist = true;
+    } else
     if(nvs->retrieveData(className, &this->hidConfig, sizeof(t_hidConfig)) == false)
     {
         ESP_LOGW(INITTAG, "HID configuration set to default, no valid config in NVS found.");
@@ -852,12 +1017,17 @@ void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
         hidConfig.mouse.scaling              = HID_MOUSE_SCALING_1_1;
         hidConfig.mouse.sampleRate           = HID_MOUSE_SAMPLE_RATE_60;
         hidConfig.host.scaling               = HID_MOUSE_HOST_SCALING_1_1;
+        hidConfig.host.acceleration          = HID_MOUSE_HOST_ACCEL_OFF;
         hidConfig.params.optionAdvanceDelay  = 1;
+        persist = true;
+    }
 
+    if(persist == true)
+    {
         // Persist the data for next time.
         if(nvs->persistData(className, &this->hidConfig, sizeof(t_hidConfig)) == false)
         {
-            ESP_LOGW(INITTAG, "Persisting Default HID configuration data failed, check NVS setup.\n");
+            ESP_LOGW(INITTAG, "Persisting HID configuration data failed, check NVS setup.\n");
         }
         // Commit data, ensuring values are written to NVS and the mutex is released.
         else if(nvs->commitData() == false)
@@ -897,7 +1067,7 @@ void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
                 // Instantiate Bluetooth HID object.
                 ESP_LOGW(INITTAG, "Initialise Bluetooth keyboard.");
                 btHID = new BTHID();
-                btHID->setup(btPairingHandler);
+                btHID->setup(btPairingHandler, nvs);
                 sw->setBTPairingEventCallback(&HID::btStartPairing, this);
 
                 // Setup a mouse callback as it is possible to receive mouse data when the primary input method is a keyboard. This data can be used by a registered
@@ -914,6 +1084,27 @@ void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
             break;
         }
 
+        // WiFi mode, Bluetooth cannot run alongside WiFi so only a PS/2 keyboard is used. Keys are read to show their mapping live in the browser.
+        case HID_DEVICE_TYPE_PS2_KEYBOARD:
+        {
+            ESP_LOGW(INITTAG, "Initialise PS2 keyboard.");
+            ps2Keyboard = new PS2KeyAdvanced();
+            ps2Keyboard->begin(CONFIG_PS2_HW_DATAPIN, CONFIG_PS2_HW_CLKPIN);
+
+            if(checkPS2Keyboard() == false)
+            {
+                ESP_LOGW(INITTAG, "PS2 keyboard not available, no keys will be read.");
+                delete ps2Keyboard;
+                hidCtrl.deviceType = HID_DEVICE_TYPE_PS2_KEYBOARD;
+                hidCtrl.hidDevice  = HID_DEVICE_NONE;
+            } else
+            {
+                hidCtrl.deviceType = HID_DEVICE_TYPE_KEYBOARD;
+                hidCtrl.hidDevice  = HID_DEVICE_PS2_KEYBOARD;
+            }
+            break;
+        }
+
         case HID_DEVICE_TYPE_MOUSE:
         {
             // Instantiate the PS/2 Keyboard object and initialise.
@@ -932,7 +1123,7 @@ void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
                 // Instantiate Bluetooth HID object.
                 ESP_LOGW(INITTAG, "Initialise Bluetooth mouse.");
                 btHID = new BTHID();
-                btHID->setup(btPairingHandler);
+                btHID->setup(btPairingHandler, nvs);
                 btHID->setMouseDataCallback(&HID::mouseReceiveData, this);
                 sw->setBTPairingEventCallback(&HID::btStartPairing, this);
             } else
@@ -945,6 +1136,9 @@ void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
                 ps2Mouse->setStreamMode();
                 ps2Mouse->enableStreaming();
                 hidCtrl.hidDevice = HID_DEVICE_PS2_MOUSE;
+
+                // The mouse has been reset and configured, mark it active so the HID thread doesnt reset it again, a reset disables reporting.
+                hidCtrl.active = true;
             }
             break;
         }
@@ -958,9 +1152,12 @@ void HID::init(const char *className, enum HID_DEVICE_TYPES deviceType)
     xSemaphoreGive(hidCtrl.mutexInternal);
 
     // Core 0 - Application
-    // HID control thread.
-    ESP_LOGW(HIDTAG, "Starting HID thread...");
-    ::xTaskCreatePinnedToCore(&this->hidControl, "HID", 4096, this, 0, &this->TaskHID, 0);
+    // HID control thread, not needed when there is no device to maintain.
+    if(hidCtrl.deviceType != HID_DEVICE_TYPE_PS2_KEYBOARD)
+    {
+        ESP_LOGW(HIDTAG, "Starting HID thread...");
+        ::xTaskCreatePinnedToCore(&this->hidControl, "HID", 4096, this, 0, &this->TaskHID, 0);
+    }
 
     // All done, no return code!
     return;
@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            HostDetect.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host classification. Edge counts are normalised by their measurement window so the
+//                  decision depends only on the host signal rates, not on the CPU clock or how fast a
+//                  polling loop happened to run.
+//
+//                  MZ-2500 - MPX and RTSN both active, roughly one RTSN per MPX.
+//                  MZ-2800 - MPX active, RTSN one per ~14 or more MPX and may be idle for periods.
+//                  X1      - MPX idle, KDO[3:0] test pattern read back on KDB[3:0] as RTSN is tied low.
+//                  X68000  - MPX idle and low, RTSN high, KDB0 (TxD) quiet.
+//                  Mouse   - MPX idle and low, RTSN high, KDI4 high, KDB0 (MSCTRL) pulsing.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Permission check of a cached host type against the feature security.
+//            v1.02 Oct 2026 - KDB0 activity judged on its edge rate over the control window rather than a raw count.
+//            v1.03 Oct 2026 - KDB0 window ends early once decided, a cached X68000 is confirmed by a short quiet probe.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include "HostDetect.h"
+
+// Method to determine if the host is scanning a key matrix, ie. an MZ-2500 or MZ-2800. The KDO lines must not be driven for the
+// X1 loopback test on such a host.
+//
+bool HostDetect::isMatrixHost(const t_hostSignals &signals)
+{
+    return(signals.windowUs > 0 && ((uint64_t)signals.mpxEdges * 1000) >= ((uint64_t)signals.windowUs * HOSTDETECT_MPX_ACTIVE_RATE));
+}
+
+// Method to determine if the KDB0 line is pulsing, ie. the Mouse MSCTRL line rather than an idle X68000 TxD. The rate is taken over
+// the measured window so a longer or shorter window than HOSTDETECT_CTRL_WINDOW_US does not change the decision.
+//
+bool HostDetect::isCtrlActive(const t_hostSignals &signals)
+{
+    return(signals.ctrlWindowUs > 0 && ((uint64_t)signals.ctrlEdges * 1000000) > ((uint64_t)signals.ctrlWindowUs * HOSTDETECT_CTRL_ACTIVE_RATE));
+}
+
+// Method to determine if the KDB0 count so far decides the host, so the control window can end. Edges which make the line active
+// over the full window decide it at once. A cached X68000 is confirmed by a quiet probe window, an MSCTRL line always pulses within
+// it. Any edge in the probe, or any other cached host, runs the full window so a wrong cache cannot stick. ctrlWindowUs is the
+// time counted so far.
+//
+bool HostDetect::isCtrlDecided(const t_hostSignals &signals, uint32_t cachedIfMode)
+{
+    if(((uint64_t)signals.ctrlEdges * 1000000) > ((uint64_t)HOSTDETECT_CTRL_WINDOW_US * HOSTDETECT_CTRL_ACTIVE_RATE))
+        return(true);
+    if(cachedIfMode == 68000 && signals.ctrlEdges == 0 && signals.ctrlWindowUs >= HOSTDETECT_PROBE_WINDOW_US)
+        return(true);
+    return(signals.ctrlWindowUs >= HOSTDETECT_CTRL_WINDOW_US);
+}
+
+// Method to classify the host from its measured signals. Returns the interface mode, 0 if the host is unknown or not permitted.
+//
+uint32_t HostDetect::classify(const t_hostSignals &signals, uint32_t allowed)
+{
+    // Locals.
+    uint32_t    ifMode = 0;
+
+    if(isMatrixHost(signals))
+    {
+        // Both sampled over the same window, so the ratio of the counts is the ratio of the rates.
+        if((allowed & HOSTDETECT_ALLOW_MZ2500) && ((uint64_t)signals.rtsnEdges * HOSTDETECT_MZ2500_RATIO) >= signals.mpxEdges)
+            ifMode = 2500;
+        else if(allowed & HOSTDETECT_ALLOW_MZ2800)
+            ifMode = 2800;
+    }
+    else if(signals.x1Loopback)
+    {
+        if(allowed & HOSTDETECT_ALLOW_X1)
+            ifMode = 1;
+    }
+    else if(signals.mpxLevel == false && signals.rtsnLevel == true)
+    {
+        if(isCtrlActive(signals) == false)
+        {
+            if(allowed & HOSTDETECT_ALLOW_X68000)
+                ifMode = 68000;
+        }
+        else if(signals.kdi4Level == true && (allowed & HOSTDETECT_ALLOW_MOUSE))
+        {
+            ifMode = 2;
+        }
+    }
+    return(ifMode);
+}
+
+// Method to check a host type, ie. one cached from a previous boot, is permitted by the feature security in the same way as classify.
+//
+bool HostDetect::isAllowed(uint32_t ifMode, uint32_t allowed)
+{
+    // Locals.
+    uint32_t    mask = 0;
+
+    switch(ifMode)
+    {
+        case 2500:  mask = HOSTDETECT_ALLOW_MZ2500; break;
+        case 2800:  mask = HOSTDETECT_ALLOW_MZ2800; break;
+        case 1:     mask = HOSTDETECT_ALLOW_X1;     break;
+        case 68000: mask = HOSTDETECT_ALLOW_X68000; break;
+        case 2:     mask = HOSTDETECT_ALLOW_MOUSE;  break;
+        default:    mask = 0;                       break;
+    }
+    return((allowed & mask) != 0);
+}
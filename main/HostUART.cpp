@@ -0,0 +1,173 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            HostUART.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     A shared UART host transport. The UART driver event queue and the interface key
+//                  transmit queue are combined into a FreeRTOS queue set, the host interface thread
+//                  blocks on the set and is woken the moment a key is mapped or host data arrives.
+//                  Receive interrupts are configured for single byte latency, host traffic is sparse
+//                  so the interrupt load is negligible.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Line break reported, used as a host reset where reset shares the receive line.
+//            v1.02 Oct 2026 - Transmit idle test, paces keystroke macros.
+//            v1.03 Oct 2026 - Receive overflows reported to the runtime metrics.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "driver/uart.h"
+#include "sdkconfig.h"
+#include "HostUART.h"
+#include "Metrics.h"
+
+// Method to install the UART driver with an event queue and build the queue set. The transmit queue must be empty, a queue can only
+// be added to a set whilst empty, so init is called before the HID thread starts pushing keys.
+//
+bool HostUART::init(uart_port_t uartNum, const uart_config_t *uartConfig, int txPin, int rxPin, int bufferSize, int eventQueueSize, QueueHandle_t xmitQueue, int xmitQueueSize)
+{
+    // Install UART driver. Use RX/TX buffers with an event queue.
+    uartCtrl.uartNum   = uartNum;
+    uartCtrl.xmitQueue = xmitQueue;
+    ESP_ERROR_CHECK(uart_driver_install(uartNum, bufferSize, bufferSize, eventQueueSize, &uartCtrl.eventQueue, 0));
+
+    // Configure UART parameters and pin assignments, software flow control, not RTS/CTS.
+    ESP_ERROR_CHECK(uart_param_config(uartNum, uartConfig));
+    ESP_ERROR_CHECK(uart_set_pin(uartNum, txPin, rxPin, -1, -1));
+
+    // Signal host data on the first byte rather than after the default idle period, which is tens of milliseconds at the slow host baud rates.
+    ESP_ERROR_CHECK(uart_set_rx_full_threshold(uartNum, HOSTUART_RX_THRESHOLD));
+    ESP_ERROR_CHECK(uart_set_rx_timeout(uartNum, HOSTUART_RX_TIMEOUT));
+
+    // Combine the driver events and the keys into one set, sized so every member item can be signalled.
+    uartCtrl.queueSet = xQueueCreateSet(eventQueueSize + xmitQueueSize);
+    if(uartCtrl.queueSet == NULL || xQueueAddToSet(uartCtrl.eventQueue, uartCtrl.queueSet) != pdPASS || xQueueAddToSet(uartCtrl.xmitQueue, uartCtrl.queueSet) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to create host UART queue set.");
+        return(false);
+    }
+    return(true);
+}
+
+// Method to block until a key is waiting to be sent or host data has arrived. UART events other than data, ie. overflows, are handled
+// internally and return HOSTUART_EVENT_NONE as does a timeout.
+//
+enum HostUART::HOSTUART_EVENT HostUART::wait(TickType_t timeout)
+{
+    // Locals.
+    //
+    QueueSetMemberHandle_t  member;
+    uart_event_t            event;
+
+    member = xQueueSelectFromSet(uartCtrl.queueSet, timeout);
+    if(member == uartCtrl.xmitQueue)
+    {
+        return(HOSTUART_EVENT_XMIT);
+    }
+    if(member != uartCtrl.eventQueue || xQueueReceive(uartCtrl.eventQueue, (void *)&event, 0) != pdTRUE)
+    {
+        return(HOSTUART_EVENT_NONE);
+    }
+
+    switch(event.type)
+    {
+        case UART_DATA:
+            return(HOSTUART_EVENT_RCV);
+
+        // Overflow, the buffered data is incomplete so discard it, the host repeats commands which are not acknowledged.
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            uartCtrl.rxOverflows++;
+            Metrics::count(Metrics::COUNTER_UART_RX_OVERFLOW);
+            ESP_LOGW(TAG, "Host UART receive overflow(%d).", uartCtrl.rxOverflows);
+            uart_flush_input(uartCtrl.uartNum);
+            break;
+
+        // Line held low, on some hosts this is a reset signal sharing the receive line. Any partial data is from the falling edge so discard it.
+        case UART_BREAK:
+            uart_flush_input(uartCtrl.uartNum);
+            return(HOSTUART_EVENT_BREAK);
+
+        default:
+            break;
+    }
+    return(HOSTUART_EVENT_NONE);
+}
+
+// Method to read buffered host data without blocking. Returns the number of bytes read.
+//
+int HostUART::readData(uint8_t *buf, int size)
+{
+    // Locals.
+    //
+    int     rcvCnt;
+
+    rcvCnt = uart_read_bytes(uartCtrl.uartNum, buf, size, 0);
+    return(rcvCnt < 0 ? 0 : rcvCnt);
+}
+
+// Method to transmit a mapped key. Allows for multi byte transmissions, MSB sent first, leading zero bytes are not sent.
+//
+void HostUART::writeKey(uint32_t keyCode)
+{
+    // Locals.
+    //
+    uint8_t  uartData[4];
+    int      uartXmitCnt = 0;
+
+    if(keyCode == 0x00000000)
+        return;
+
+    while((keyCode & 0xff000000) == 0x00) { keyCode = keyCode << 8; }
+    for(int idx=0; idx < 4 && (keyCode & 0xff000000) != 0x00; idx++)
+    {
+        uartData[idx] = (uint8_t)((keyCode & 0xFF000000) >> 24);
+        uartXmitCnt++;
+        keyCode = keyCode << 8;
+    }
+    uart_write_bytes(uartCtrl.uartNum, (const char *)uartData, uartXmitCnt);
+    return;
+}
+
+// Method to test if all transmitted data has left the UART, ie. the host has been sent the last key in full.
+//
+bool HostUART::xmitIdle(void)
+{
+    return(uart_wait_tx_done(uartCtrl.uartNum, 0) == ESP_OK);
+}
+
+// Constructor, the transport is configured by init once the interface has created its queues.
+HostUART::HostUART(void)
+{
+    uartCtrl.uartNum     = UART_NUM_MAX;
+    uartCtrl.eventQueue  = NULL;
+    uartCtrl.xmitQueue   = NULL;
+    uartCtrl.queueSet    = NULL;
+    uartCtrl.rxOverflows = 0;
+}
@@ -13,6 +13,12 @@
 //
 // History:         Mar 2022 - Initial write.
 //            v1.01 May 2022 - Initial release version.
+//            v1.02 Oct 2026 - Thread readiness events, init waits on these rather than fixed delays.
+//            v1.03 Oct 2026 - Keymaps published as a whole, a reload no longer frees a table in use by mapKey.
+//            v1.05 Oct 2026 - Keystroke macro playback, keys are fed to mapKey at the rate the host accepts them.
+//            v1.07 Oct 2026 - Key read to key mapped latency recorded in the runtime metrics.
+//            v1.08 Oct 2026 - Device event time carried with each key so the host threads can record per stage and end to end latency.
+//            v1.09 Oct 2026 - Macro pacing only adapts on hosts which report rejects.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -150,6 +156,264 @@ bool KeyInterface::isRunning(bool waitForRelease)
     return(this->suspended);
 }
 
+// Method called by an interface thread once it has initialised and is servicing its host or device.
+//
+void KeyInterface::signalReady(EventBits_t readyBits)
+{
+    if(readyEvents != NULL)
+    {
+        xEventGroupSetBits(readyEvents, readyBits);
+    }
+}
+
+// Method to wait until the given interface threads have signalled they are running. The wait is bounded so a thread which fails
+// to start does not stall the boot, a timeout is logged and false returned.
+//
+bool KeyInterface::waitReady(EventBits_t readyBits)
+{
+    // Locals.
+    EventBits_t     bits;
+
+    if(readyEvents == NULL)
+        return(false);
+
+    bits = xEventGroupWaitBits(readyEvents, readyBits, pdFALSE, pdTRUE, pdMS_TO_TICKS(KEYIF_READY_TIMEOUT_MS));
+    if((bits & readyBits) != readyBits)
+    {
+        ESP_LOGW(subClassName.c_str(), "Interface thread not ready, events:%02x, expected:%02x.", bits, readyBits);
+        return(false);
+    }
+    return(true);
+}
+
+// Method to wait until the HID thread can no longer hold a keymap which has just been replaced. If the thread is between keys it will
+// pick up the new keymap on its next key, otherwise wait for it to finish mapping the current key.
+//
+bool KeyInterface::keyMapSynchronise(void)
+{
+    // Locals.
+    uint32_t        epoch = keyMapEpoch;
+    TickType_t      startTick = xTaskGetTickCount();
+
+    while((epoch & 1) != 0 && keyMapEpoch == epoch)
+    {
+        if((xTaskGetTickCount() - startTick) > pdMS_TO_TICKS(KEYIF_KEYMAP_SYNC_MS))
+        {
+            ESP_LOGW(subClassName.c_str(), "HID thread still mapping a key, replaced keymap not released.");
+            return(false);
+        }
+        vTaskDelay(1);
+    }
+    return(true);
+}
+
+// Method to start playing a macro file into the host. Playback starts after a short delay so the hotkey which started it can be released.
+// Called from the HID thread, normally via selectOption.
+//
+bool KeyInterface::macroPlay(const std::string &fileName)
+{
+    // Locals.
+    FILE       *fd;
+    long        fileSize;
+    size_t      readSize;
+
+    if(macroCtrl.active)
+    {
+        ESP_LOGW(subClassName.c_str(), "Macro already playing, press ESC to stop it.");
+        return(false);
+    }
+    if((fd = fopen(fileName.c_str(), "r")) == NULL)
+    {
+        ESP_LOGW(subClassName.c_str(), "Macro file %s not found.", fileName.c_str());
+        return(false);
+    }
+    fseek(fd, 0, SEEK_END);
+    fileSize = ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    if(fileSize <= 0 || fileSize > KEYMACRO_MAX_SIZE)
+    {
+        ESP_LOGW(subClassName.c_str(), "Macro file %s is empty or larger than %d bytes.", fileName.c_str(), KEYMACRO_MAX_SIZE);
+        fclose(fd);
+        return(false);
+    }
+    macroCtrl.text.resize(fileSize);
+    readSize = fread(&macroCtrl.text[0], 1, fileSize, fd);
+    fclose(fd);
+    macroCtrl.text.resize(readSize);
+
+    macroCtrl.pos       = 0;
+    macroCtrl.eventCnt  = 0;
+    macroCtrl.eventIdx  = 0;
+    macroCtrl.readyTick = xTaskGetTickCount() + pdMS_TO_TICKS(KEYMACRO_START_DELAY_MS);
+    macroCtrl.sentTick  = macroCtrl.readyTick;
+    macroCtrl.rejects   = macroFrames.rejects;
+    macroCtrl.skipped   = 0;
+    KeyMacro::paceStart(macroCtrl.pace, macroHostRejects());
+    macroCtrl.active    = true;
+    ESP_LOGW(subClassName.c_str(), "Playing macro %s, %d bytes.", fileName.c_str(), (int)readSize);
+    return(true);
+}
+
+// Method to stop macro playback. Keys of the current key not yet pressed are dropped, those already pressed are released so nothing is
+// left held on the host.
+//
+void KeyInterface::macroCancel(void)
+{
+    // Locals.
+    int         keep = macroCtrl.eventIdx;
+    bool        pressed;
+
+    if(macroCtrl.active == false)
+        return;
+
+    for(int idx=macroCtrl.eventIdx; idx < macroCtrl.eventCnt; idx++)
+    {
+        pressed = false;
+        for(int sentIdx=0; sentIdx < macroCtrl.eventIdx && (macroCtrl.events[idx] & PS2_BREAK); sentIdx++)
+        {
+            if((macroCtrl.events[sentIdx] & PS2_BREAK) == 0 && (macroCtrl.events[sentIdx] & 0xFF) == (macroCtrl.events[idx] & 0xFF))
+                pressed = true;
+        }
+        if(pressed)
+            macroCtrl.events[keep++] = macroCtrl.events[idx];
+    }
+    macroCtrl.eventCnt  = keep;
+    macroCtrl.pos       = macroCtrl.text.size();
+    macroCtrl.readyTick = xTaskGetTickCount();
+    ESP_LOGW(subClassName.c_str(), "Macro stopped.");
+}
+
+// Method to end playback and report how it went.
+//
+void KeyInterface::macroEnd(void)
+{
+    ESP_LOGW(subClassName.c_str(), "Macro complete, %d keys, %d skipped, %d rejected by the host, final gap %dms.",
+             macroCtrl.pace.accepted, macroCtrl.skipped, macroCtrl.pace.rejected, macroCtrl.pace.gapMs);
+    macroCtrl.active = false;
+    macroCtrl.text.clear();
+    macroCtrl.text.shrink_to_fit();
+}
+
+// Method to read the next key for the HID thread. Keys from the keyboard take precedence, a macro plays in the gaps between them.
+// ESC on the keyboard stops a macro.
+//
+uint16_t KeyInterface::readKey(void)
+{
+    // Locals.
+    uint16_t    scanCode = hid->read();
+
+    // Time the key, a keyboard key from its arrival at the device, a macro key from now as it has no device event.
+    if(scanCode != 0)
+    {
+        keyEventTime = hid->readTime();
+        keyReadTime  = Metrics::stage(Metrics::HIST_INPUT, keyEventTime);
+
+        if(macroCtrl.active && (scanCode & 0xFF) == PS2_KEY_ESC && (scanCode & (PS2_BREAK | PS2_SHIFT | PS2_CTRL | PS2_ALT | PS2_ALT_GR | PS2_GUI)) == 0)
+        {
+            macroCancel();
+            scanCode    = 0;
+            keyReadTime = 0;
+        }
+    } else
+    if(macroCtrl.active)
+    {
+        scanCode     = macroRead();
+        keyEventTime = 0;
+        keyReadTime  = (scanCode != 0 ? Metrics::now() : 0);
+    } else
+    {
+        keyReadTime  = 0;
+    }
+    return(scanCode);
+}
+
+// Method to return the next macro event, 0 if the host has not yet taken the last event or the gap before the next key has not elapsed.
+// Each key is sent as its make and break events, modifiers included. On a host which reports rejects the gap shrinks for each key the host
+// takes and widens when the host rejects one, so playback settles at the fastest rate the host keeps up with. Other hosts are held at a
+// fixed gap, each key still waits for the host to take the last.
+//
+uint16_t KeyInterface::macroRead(void)
+{
+    // Locals.
+    TickType_t          curTime = xTaskGetTickCount();
+    uint32_t            rejects = macroFrames.rejects;
+    uint16_t            event = 0;
+    uint16_t            keyCode;
+    KeyMacro::t_token   token;
+
+    if(rejects != macroCtrl.rejects)
+    {
+        macroCtrl.rejects = rejects;
+        KeyMacro::paceRejected(macroCtrl.pace);
+        macroCtrl.readyTick = curTime + pdMS_TO_TICKS(macroCtrl.pace.gapMs);
+    }
+
+    // Wait for the host to take the last event, a host which stops taking keys ends playback.
+    if(macroHostIdle() == false)
+    {
+        if((int32_t)(curTime - macroCtrl.sentTick) > (int32_t)pdMS_TO_TICKS(KEYMACRO_HOST_TIMEOUT_MS))
+        {
+            ESP_LOGW(subClassName.c_str(), "Host is not accepting keys.");
+            macroEnd();
+        }
+        return(0);
+    }
+    if((int32_t)(curTime - macroCtrl.readyTick) < 0)
+        return(0);
+
+    if(macroCtrl.eventIdx < macroCtrl.eventCnt)
+    {
+        event = macroCtrl.events[macroCtrl.eventIdx++];
+    } else
+    if(macroCtrl.eventCnt > 0)
+    {
+        // Key complete and taken by the host, the gap runs from here.
+        KeyMacro::paceAccepted(macroCtrl.pace);
+        macroCtrl.eventCnt  = 0;
+        macroCtrl.readyTick = curTime + pdMS_TO_TICKS(macroCtrl.pace.gapMs);
+    } else
+    {
+        macroCtrl.pos = KeyMacro::nextToken(macroCtrl.text, macroCtrl.pos, token);
+        switch(token.type)
+        {
+            case KeyMacro::TOKEN_CHAR:
+                if(macroKey(token.chr, keyCode))
+                    macroCtrl.eventCnt = KeyMacro::strokeEvents(keyCode, macroCtrl.events);
+                else
+                    macroCtrl.skipped++;
+                break;
+
+            case KeyMacro::TOKEN_KEY:
+                macroCtrl.eventCnt = KeyMacro::strokeEvents(token.keyCode, macroCtrl.events);
+                break;
+
+            case KeyMacro::TOKEN_WAIT:
+                macroCtrl.readyTick = curTime + pdMS_TO_TICKS(token.waitMs);
+                break;
+
+            case KeyMacro::TOKEN_INVALID:
+                macroCtrl.skipped++;
+                break;
+
+            case KeyMacro::TOKEN_END:
+            default:
+                macroEnd();
+                break;
+        }
+        macroCtrl.eventIdx = 0;
+        if(macroCtrl.eventCnt > 0)
+            event = macroCtrl.events[macroCtrl.eventIdx++];
+    }
+
+    // Let the interface note the host state the event is measured against.
+    if(event != 0)
+    {
+        macroHostMark();
+        macroCtrl.sentTick = curTime;
+    }
+    return(event);
+}
+
 // Base initialisation for generic hardware used by all sub-classes. The sub-class invokes the init
 // method manually from within it's init method.
 void KeyInterface::init(const char *subClassName, NVS *hdlNVS, LED *hdlLED, HID *hdlHID, uint32_t ifMode)
@@ -169,6 +433,12 @@ void KeyInterface::init(const char *subClassName, NVS *hdlNVS, LED *hdlLED, HID
     // Store the sub-class name for later use, ie. NVS key access.
     this->subClassName = subClassName;
 
+    // Create the readiness events before any interface thread is started.
+    if(readyEvents == NULL)
+    {
+        readyEvents = xEventGroupCreate();
+    }
+
     // Set LED to on.
     led->setLEDMode(LED::LED_MODE_ON, LED::LED_DUTY_CYCLE_OFF, 0, 0L, 0L);
 
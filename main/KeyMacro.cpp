@@ -0,0 +1,367 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMacro.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Keystroke macro logic. The macro text is split into tokens, each key becomes the
+//                  sequence of PS/2 events a keyboard would deliver for it, modifiers included, so the
+//                  interface mapKey sees exactly what a typist would produce. Characters are given as
+//                  keys on a UK PC keyboard, the layout the inbuilt keymaps are written against.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Pacing only adapts on hosts which report rejects, others use a fixed gap.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string>
+#include "KeyMacro.h"
+
+// Modifier flags and the key which delivers each, in the order they are pressed.
+static const struct {
+    uint16_t                            flag;
+    uint8_t                             key;
+} macroModifiers[] = {
+    { PS2_SHIFT,                        PS2_KEY_L_SHIFT },
+    { PS2_CTRL,                         PS2_KEY_L_CTRL  },
+    { PS2_ALT,                          PS2_KEY_L_ALT   },
+    { PS2_ALT_GR,                       PS2_KEY_R_ALT   },
+    { PS2_GUI,                          PS2_KEY_L_GUI   },
+};
+
+// Names accepted for modifiers within a bracketed token.
+static const struct {
+    const char                         *name;
+    uint16_t                            flag;
+} macroModifierNames[] = {
+    { "SHIFT",                          PS2_SHIFT  },
+    { "CTRL",                           PS2_CTRL   },
+    { "ALT",                            PS2_ALT    },
+    { "ALTGR",                          PS2_ALT_GR },
+    { "GUI",                            PS2_GUI    },
+};
+
+// Names accepted for keys, F1..F12 are decoded separately.
+static const struct {
+    const char                         *name;
+    uint8_t                             key;
+} macroKeyNames[] = {
+    { "ENTER",                          PS2_KEY_ENTER    },
+    { "TAB",                            PS2_KEY_TAB      },
+    { "ESC",                            PS2_KEY_ESC      },
+    { "BS",                             PS2_KEY_BS       },
+    { "DEL",                            PS2_KEY_DELETE   },
+    { "INS",                            PS2_KEY_INSERT   },
+    { "HOME",                           PS2_KEY_HOME     },
+    { "END",                            PS2_KEY_END      },
+    { "PGUP",                           PS2_KEY_PGUP     },
+    { "PGDN",                           PS2_KEY_PGDN     },
+    { "UP",                             PS2_KEY_UP_ARROW },
+    { "DOWN",                           PS2_KEY_DN_ARROW },
+    { "LEFT",                           PS2_KEY_L_ARROW  },
+    { "RIGHT",                          PS2_KEY_R_ARROW  },
+    { "SPACE",                          PS2_KEY_SPACE    },
+    { "BREAK",                          PS2_KEY_BREAK    },
+    { "PAUSE",                          PS2_KEY_PAUSE    },
+};
+
+// Method to return an upper case copy of a token name.
+//
+static std::string macroUpper(const std::string &name)
+{
+    // Locals.
+    std::string upper = name;
+
+    for(size_t idx=0; idx < upper.size(); idx++)
+    {
+        upper[idx] = (char)toupper((unsigned char)upper[idx]);
+    }
+    return(upper);
+}
+
+// Method to parse the token starting at pos. Returns the position following the token.
+//
+size_t KeyMacro::nextToken(const std::string &text, size_t pos, t_token &token)
+{
+    // Locals.
+    size_t      end;
+    size_t      plus;
+    std::string name;
+    std::string upper;
+    bool        valid = true;
+    uint16_t    modifiers = 0;
+
+    token.type    = TOKEN_END;
+    token.chr     = 0x00;
+    token.keyCode = 0x0000;
+    token.waitMs  = 0;
+
+    // Carriage returns are dropped so CR LF line endings give a single ENTER.
+    while(pos < text.size() && text[pos] == '\r')
+    {
+        pos++;
+    }
+    if(pos >= text.size())
+        return(pos);
+
+    // Plain character, {{ is an escaped brace.
+    if(text[pos] != '{' || (pos+1 < text.size() && text[pos+1] == '{'))
+    {
+        token.type = TOKEN_CHAR;
+        token.chr  = text[pos];
+        return(pos + (text[pos] == '{' ? 2 : 1));
+    }
+
+    // Bracketed token, an unterminated or overlong bracket is skipped one character at a time.
+    end = text.find('}', pos);
+    if(end == std::string::npos || end == pos+1 || (end - pos - 1) > KEYMACRO_MAX_NAME)
+    {
+        token.type = TOKEN_INVALID;
+        return(pos + 1);
+    }
+    name  = text.substr(pos+1, end-pos-1);
+    upper = macroUpper(name);
+
+    // Pause?
+    if(upper.compare(0, 5, "WAIT ") == 0)
+    {
+        token.type   = TOKEN_WAIT;
+        token.waitMs = strtoul(upper.c_str() + 5, NULL, 10);
+        if(token.waitMs > KEYMACRO_MAX_WAIT_MS)
+            token.waitMs = KEYMACRO_MAX_WAIT_MS;
+        return(end + 1);
+    }
+
+    // Modifiers precede the key, separated by +. A trailing + is the key itself, ie. {CTRL++}.
+    while(valid && (plus = name.find('+')) != std::string::npos && plus < name.size() - 1)
+    {
+        upper = macroUpper(name.substr(0, plus));
+        valid = false;
+        for(int idx=0; idx < (int)(sizeof(macroModifierNames)/sizeof(macroModifierNames[0])); idx++)
+        {
+            if(upper.compare(macroModifierNames[idx].name) == 0)
+            {
+                modifiers |= macroModifierNames[idx].flag;
+                valid = true;
+            }
+        }
+        name = name.substr(plus + 1);
+    }
+
+    // A single character is a typed key, otherwise a key name.
+    if(valid)
+    {
+        valid = (name.size() == 1 ? charToKey(name[0], token.keyCode) : nameToKey(macroUpper(name), token.keyCode));
+    }
+    token.type     = (valid ? TOKEN_KEY : TOKEN_INVALID);
+    token.keyCode |= modifiers;
+    return(end + 1);
+}
+
+// Method to give the key and shift state which types a character on a UK PC keyboard. Returns false if the character has no key.
+//
+bool KeyMacro::charToKey(char chr, uint16_t &keyCode)
+{
+    // Locals.
+    //
+    // Printable characters 0x20..0x7E, shifted keys flagged with PS2_SHIFT.
+    static const uint16_t asciiKeys[] = {
+        PS2_KEY_SPACE,                  PS2_SHIFT | PS2_KEY_1,          PS2_SHIFT | PS2_KEY_2,          PS2_KEY_HASH,                   // ' ' ! " #
+        PS2_SHIFT | PS2_KEY_4,          PS2_SHIFT | PS2_KEY_5,          PS2_SHIFT | PS2_KEY_7,          PS2_KEY_APOS,                   // $ % & '
+        PS2_SHIFT | PS2_KEY_9,          PS2_SHIFT | PS2_KEY_0,          PS2_SHIFT | PS2_KEY_8,          PS2_SHIFT | PS2_KEY_EQUAL,      // ( ) * +
+        PS2_KEY_COMMA,                  PS2_KEY_MINUS,                  PS2_KEY_DOT,                    PS2_KEY_DIV,                    // , - . /
+        PS2_KEY_0,                      PS2_KEY_1,                      PS2_KEY_2,                      PS2_KEY_3,                      // 0 1 2 3
+        PS2_KEY_4,                      PS2_KEY_5,                      PS2_KEY_6,                      PS2_KEY_7,                      // 4 5 6 7
+        PS2_KEY_8,                      PS2_KEY_9,                      PS2_SHIFT | PS2_KEY_SEMI,       PS2_KEY_SEMI,                   // 8 9 : ;
+        PS2_SHIFT | PS2_KEY_COMMA,      PS2_KEY_EQUAL,                  PS2_SHIFT | PS2_KEY_DOT,        PS2_SHIFT | PS2_KEY_DIV,        // < = > ?
+        PS2_SHIFT | PS2_KEY_APOS,                                                                                                       // @
+    };
+    static const uint16_t symbolKeys[] = {
+        PS2_KEY_OPEN_SQ,                PS2_KEY_BACK,                   PS2_KEY_CLOSE_SQ,               PS2_SHIFT | PS2_KEY_6,          // [ \ ] ^
+        PS2_SHIFT | PS2_KEY_MINUS,      PS2_KEY_BTICK,                                                                                  // _ `
+    };
+    static const uint16_t braceKeys[] = {
+        PS2_SHIFT | PS2_KEY_OPEN_SQ,    PS2_SHIFT | PS2_KEY_BTICK,      PS2_SHIFT | PS2_KEY_CLOSE_SQ,   PS2_SHIFT | PS2_KEY_HASH,       // { | } ~
+    };
+    bool        result = true;
+
+    if(chr >= 'A' && chr <= 'Z')
+        keyCode = PS2_SHIFT | (uint8_t)chr;
+    else if(chr >= 'a' && chr <= 'z')
+        keyCode = (uint8_t)(chr - 'a' + 'A');
+    else if(chr >= ' ' && chr <= '@')
+        keyCode = asciiKeys[chr - ' '];
+    else if(chr >= '[' && chr <= '`')
+        keyCode = symbolKeys[chr - '['];
+    else if(chr >= '{' && chr <= '~')
+        keyCode = braceKeys[chr - '{'];
+    else if(chr == '\n')
+        keyCode = PS2_KEY_ENTER;
+    else if(chr == '\t')
+        keyCode = PS2_KEY_TAB;
+    else if(chr == '\b')
+        keyCode = PS2_KEY_BS;
+    else if(chr == 0x1B)
+        keyCode = PS2_KEY_ESC;
+    else
+        result = false;
+
+    return(result);
+}
+
+// Method to give the key for a key name. Returns false if the name is not known.
+//
+bool KeyMacro::nameToKey(const std::string &name, uint16_t &keyCode)
+{
+    // Locals.
+    int         fkey;
+    bool        result = false;
+
+    // Function keys F1..F12 are contiguous codes.
+    if(name.size() >= 2 && name.size() <= 3 && name[0] == 'F' && isdigit((unsigned char)name[1]) && (name.size() == 2 || isdigit((unsigned char)name[2])))
+    {
+        fkey = atoi(name.c_str() + 1);
+        if(fkey >= 1 && fkey <= 12)
+        {
+            keyCode = PS2_KEY_F1 + fkey - 1;
+            result  = true;
+        }
+    } else
+    {
+        for(int idx=0; idx < (int)(sizeof(macroKeyNames)/sizeof(macroKeyNames[0])) && result == false; idx++)
+        {
+            if(name.compare(macroKeyNames[idx].name) == 0)
+            {
+                keyCode = macroKeyNames[idx].key;
+                result  = true;
+            }
+        }
+    }
+    return(result);
+}
+
+// Method to expand a key, with its modifier flags, into the PS/2 events a keyboard delivers when the key is typed. Modifiers are pressed
+// first and released last, each event carries the flags of the modifiers held at that point as the PS/2 and Bluetooth drivers report them.
+// events must hold KEYMACRO_MAX_EVENTS, returns the number of events.
+//
+int KeyMacro::strokeEvents(uint16_t keyCode, uint16_t *events)
+{
+    // Locals.
+    uint16_t    flags = 0x0000;
+    uint16_t    key = keyCode & 0x00FF;
+    uint16_t    function = 0x0000;
+    int         modCnt = (int)(sizeof(macroModifiers)/sizeof(macroModifiers[0]));
+    int         eventCnt = 0;
+
+    for(int idx=0; idx < modCnt; idx++)
+    {
+        if(keyCode & macroModifiers[idx].flag)
+        {
+            flags |= macroModifiers[idx].flag;
+            events[eventCnt++] = flags | PS2_FUNCTION | macroModifiers[idx].key;
+        }
+    }
+
+    // Mimicking the PS/2 class, set Function for non printable keys.
+    if((key <= PS2_KEY_SPACE || key >= PS2_KEY_F1) && key != PS2_KEY_BTICK && key != PS2_KEY_HASH && key != PS2_KEY_EUROPE2)
+        function = PS2_FUNCTION;
+    events[eventCnt++] = flags | function | key;
+    events[eventCnt++] = PS2_BREAK | flags | function | key;
+
+    for(int idx=modCnt-1; idx >= 0; idx--)
+    {
+        if(keyCode & macroModifiers[idx].flag)
+        {
+            flags &= ~macroModifiers[idx].flag;
+            events[eventCnt++] = PS2_BREAK | flags | PS2_FUNCTION | macroModifiers[idx].key;
+        }
+    }
+    return(eventCnt);
+}
+
+// Method to check macro text. Returns the number of tokens which cannot be typed, unknown key names and characters with no key on a
+// UK PC keyboard. Such tokens are skipped on playback unless the interface keymap maps the character.
+//
+int KeyMacro::validate(const std::string &text)
+{
+    // Locals.
+    t_token     token;
+    uint16_t    keyCode;
+    size_t      pos;
+    int         invalid = 0;
+
+    for(pos = nextToken(text, 0, token); token.type != TOKEN_END; pos = nextToken(text, pos, token))
+    {
+        if(token.type == TOKEN_INVALID || (token.type == TOKEN_CHAR && charToKey(token.chr, keyCode) == false))
+            invalid++;
+    }
+    return(invalid);
+}
+
+// Method to return the file holding a macro slot, the macros are stored alongside the keymap file.
+//
+std::string KeyMacro::fileName(const std::string &keyMapFileName, int slot)
+{
+    // Locals.
+    size_t      sep = keyMapFileName.rfind('/');
+    std::string path = (sep == std::string::npos ? "" : keyMapFileName.substr(0, sep + 1));
+
+    return(path + KEYMACRO_FILE_PREFIX + std::to_string(slot) + KEYMACRO_FILE_EXT);
+}
+
+// Method to reset the pacing to its starting gap. adaptive is set when the host reports the keys it rejects, without that the gap is fixed.
+//
+void KeyMacro::paceStart(t_pace &pace, bool adaptive)
+{
+    pace.gapMs    = (adaptive ? KEYMACRO_GAP_START_MS : KEYMACRO_GAP_FIXED_MS);
+    pace.accepted = 0;
+    pace.rejected = 0;
+    pace.adaptive = adaptive;
+}
+
+// Method to narrow the gap after a key the host accepted, rounding up so the gap reaches the minimum.
+//
+void KeyMacro::paceAccepted(t_pace &pace)
+{
+    // Locals.
+    uint32_t    decrease = (pace.gapMs + KEYMACRO_GAP_DECAY - 1) / KEYMACRO_GAP_DECAY;
+
+    pace.accepted++;
+    if(pace.adaptive)
+    {
+        pace.gapMs = (pace.gapMs - decrease > KEYMACRO_GAP_MIN_MS ? pace.gapMs - decrease : KEYMACRO_GAP_MIN_MS);
+    }
+}
+
+// Method to widen the gap after the host rejected or lost a key.
+//
+void KeyMacro::paceRejected(t_pace &pace)
+{
+    pace.rejected++;
+    if(pace.adaptive)
+    {
+        pace.gapMs = (pace.gapMs * 2) + KEYMACRO_GAP_STEP_MS;
+        if(pace.gapMs > KEYMACRO_GAP_MAX_MS)
+            pace.gapMs = KEYMACRO_GAP_MAX_MS;
+    }
+}
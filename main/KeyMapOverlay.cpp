@@ -0,0 +1,321 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMapOverlay.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Keymap overlay. Rather than a heap copy of the complete keymap, only the rows which
+//                  differ from the inbuilt keymap are held in the file and in memory. The inbuilt keymap
+//                  stays in flash and a 16bit index gives the merged row order seen by mapKey.
+//                  A complete keymap, as uploaded from the browser or saved by earlier firmware, is
+//                  converted by comparing it row by row with the inbuilt keymap. Rows are compared in
+//                  order, a short look ahead distinguishes an inserted or deleted row from a change so
+//                  that one added row does not turn every following row into a change.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Builds outside ESP-IDF so the overlay logic can be run on a host.
+//            v1.02 Oct 2026 - Host builds use the test shim esp_log.h, the local log substitute is removed.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "KeyMapOverlay.h"
+
+// Tag for logging.
+#define OVERLAYTAG                     "KeyMapOverlay"
+
+// Method to compare a set of keymap rows against the inbuilt keymap and produce the edits which turn the latter into the former.
+// Entries point into the given rows, one per insert or replace record.
+//
+void KeyMapOverlay::diff(const std::vector<const uint8_t *> &rows, const uint8_t *base, int baseRows, size_t entrySize, std::vector<t_overlayRecord> &records, std::vector<const uint8_t *> &entries)
+{
+    // Locals.
+    int                 rowCnt = (int)rows.size();
+    int                 idx = 0;
+    int                 baseIdx = 0;
+    int                 delCnt;
+    int                 insCnt;
+    t_overlayRecord     record = { 0, 0, 0 };
+
+    records.clear();
+    entries.clear();
+    while(idx < rowCnt || baseIdx < baseRows)
+    {
+        // Unchanged row.
+        if(idx < rowCnt && baseIdx < baseRows && memcmp(rows[idx], &base[baseIdx * entrySize], entrySize) == 0)
+        {
+            idx++;
+            baseIdx++;
+            continue;
+        }
+
+        // Look ahead for the current row further on in the inbuilt keymap, ie. inbuilt rows deleted, and for the current inbuilt row further on in the rows, ie. rows inserted.
+        for(delCnt=1; idx < rowCnt && delCnt <= KEYMAP_OVERLAY_LOOKAHEAD && baseIdx + delCnt < baseRows; delCnt++)
+        {
+            if(memcmp(rows[idx], &base[(baseIdx + delCnt) * entrySize], entrySize) == 0) break;
+        }
+        if(idx >= rowCnt || delCnt > KEYMAP_OVERLAY_LOOKAHEAD || baseIdx + delCnt >= baseRows) delCnt = 0;
+        for(insCnt=1; baseIdx < baseRows && insCnt <= KEYMAP_OVERLAY_LOOKAHEAD && idx + insCnt < rowCnt; insCnt++)
+        {
+            if(memcmp(rows[idx + insCnt], &base[baseIdx * entrySize], entrySize) == 0) break;
+        }
+        if(baseIdx >= baseRows || insCnt > KEYMAP_OVERLAY_LOOKAHEAD || idx + insCnt >= rowCnt) insCnt = 0;
+
+        // Trailing inbuilt rows removed or a deletion is the closer resync.
+        if(idx >= rowCnt || (delCnt > 0 && (insCnt == 0 || delCnt <= insCnt)))
+        {
+            for(int cnt=(delCnt > 0 ? delCnt : 1); cnt > 0; cnt--, baseIdx++)
+            {
+                record.baseRow = baseIdx; record.op = OVERLAY_DELETE;
+                records.push_back(record);
+            }
+        }
+        // Trailing rows added or an insertion is the closer resync.
+        else if(baseIdx >= baseRows || insCnt > 0)
+        {
+            for(int cnt=(insCnt > 0 ? insCnt : 1); cnt > 0; cnt--, idx++)
+            {
+                record.baseRow = baseIdx; record.op = OVERLAY_INSERT;
+                records.push_back(record);
+                entries.push_back(rows[idx]);
+            }
+        }
+        // No resync in range, the row has been changed.
+        else
+        {
+            record.baseRow = baseIdx; record.op = OVERLAY_REPLACE;
+            records.push_back(record);
+            entries.push_back(rows[idx]);
+            idx++;
+            baseIdx++;
+        }
+    }
+    return;
+}
+
+// Method to merge overlay edits with the inbuilt keymap, building the overlay rows and row index used by mapKey. The records must be in
+// inbuilt row order with inserts preceding any replace or delete of the same row, as created by diff.
+//
+bool KeyMapOverlay::merge(const std::vector<t_overlayRecord> &records, const std::vector<const uint8_t *> &entries, int baseRows, size_t entrySize, t_overlayMap &map)
+{
+    // Locals.
+    int                 rows = baseRows;
+    int                 lastRow = -1;
+    int                 recIdx = 0;
+    int                 entryIdx = 0;
+    int                 rowIdx = 0;
+    bool                consumed;
+
+    map.index       = NULL;
+    map.overlay     = NULL;
+    map.overlayRows = 0;
+    map.rows        = baseRows;
+
+    // No edits, mapKey uses the inbuilt keymap directly.
+    if(records.size() == 0)
+    {
+        return(true);
+    }
+
+    // Validate the edits and size the merged keymap.
+    for(std::size_t idx=0; idx < records.size(); idx++)
+    {
+        if(records[idx].baseRow > baseRows || (idx > 0 && records[idx].baseRow < records[idx-1].baseRow) || records[idx].op > OVERLAY_DELETE ||
+           (records[idx].op != OVERLAY_INSERT && (records[idx].baseRow >= baseRows || (int)records[idx].baseRow == lastRow)))
+        {
+            ESP_LOGW(OVERLAYTAG, "Keymap overlay record %d invalid, row:%d op:%d.", (int)idx, records[idx].baseRow, records[idx].op);
+            return(false);
+        }
+        if(records[idx].op != OVERLAY_INSERT)
+        {
+            lastRow = records[idx].baseRow;
+        }
+        rows += (records[idx].op == OVERLAY_INSERT ? 1 : (records[idx].op == OVERLAY_DELETE ? -1 : 0));
+    }
+    if(entries.size() > 0xFFFF - (std::size_t)baseRows)
+    {
+        return(false);
+    }
+
+    // Only the added and changed rows are held in memory, the index refers to inbuilt rows in place.
+    map.index   = new uint16_t[rows > 0 ? rows : 1];
+    map.overlay = new uint8_t[entries.size() > 0 ? entries.size() * entrySize : 1];
+    if(map.index == NULL || map.overlay == NULL)
+    {
+        if(map.index != NULL)   { delete [] map.index;   map.index = NULL; }
+        if(map.overlay != NULL) { delete [] map.overlay; map.overlay = NULL; }
+        return(false);
+    }
+    for(std::size_t idx=0; idx < entries.size(); idx++)
+    {
+        memcpy(&map.overlay[idx * entrySize], entries[idx], entrySize);
+    }
+
+    for(int baseIdx=0; baseIdx <= baseRows; baseIdx++)
+    {
+        for(consumed=false; recIdx < (int)records.size() && records[recIdx].baseRow == baseIdx; recIdx++)
+        {
+            if(records[recIdx].op == OVERLAY_DELETE)
+            {
+                consumed = true;
+            } else
+            {
+                map.index[rowIdx++] = (uint16_t)(baseRows + entryIdx++);
+                consumed = consumed || records[recIdx].op == OVERLAY_REPLACE;
+            }
+        }
+        if(baseIdx < baseRows && consumed == false)
+        {
+            map.index[rowIdx++] = (uint16_t)baseIdx;
+        }
+    }
+    map.overlayRows = entries.size();
+    map.rows        = rowIdx;
+    return(true);
+}
+
+// Method to load a keymap file and merge it with the inbuilt keymap. An overlay file is merged directly, a complete keymap is first
+// compared with the inbuilt keymap. On any error the inbuilt keymap is used.
+//
+enum KeyMapOverlay::OVERLAY_LOAD KeyMapOverlay::load(const std::string &fileName, const uint8_t *base, int baseRows, size_t entrySize, t_overlayMap &map)
+{
+    // Locals.
+    struct stat                     fileStat;
+    t_overlayHeader                 header;
+    t_overlayRecord                 record;
+    std::vector<t_overlayRecord>    records;
+    std::vector<const uint8_t *>    entries;
+    std::vector<const uint8_t *>    rows;
+    std::vector<uint8_t>            data;
+    enum OVERLAY_LOAD               result = OVERLAY_LOAD_INBUILT;
+
+    map.index       = NULL;
+    map.overlay     = NULL;
+    map.overlayRows = 0;
+    map.rows        = baseRows;
+
+    if(stat(fileName.c_str(), &fileStat) == -1 || fileStat.st_size == 0)
+    {
+        return(OVERLAY_LOAD_INBUILT);
+    }
+    std::fstream keyFileIn(fileName.c_str(), std::ios::in | std::ios::binary);
+    keyFileIn.read((char *)&header, sizeof(t_overlayHeader));
+
+    // Overlay, read the edits. Only valid against the inbuilt keymap it was made from.
+    if(keyFileIn.good() && header.magic == KEYMAP_OVERLAY_MAGIC)
+    {
+        if(header.format != KEYMAP_OVERLAY_FORMAT || header.entrySize != entrySize || header.baseRows != baseRows)
+        {
+            ESP_LOGW(OVERLAYTAG, "Keymap overlay %s made for a different inbuilt keymap, ignored.", fileName.c_str());
+        } else
+        {
+            data.resize(header.records * entrySize);
+            for(int idx=0; idx < header.records && keyFileIn.good(); idx++)
+            {
+                keyFileIn.read((char *)&record, sizeof(t_overlayRecord));
+                keyFileIn.read((char *)&data[idx * entrySize], entrySize);
+                if(keyFileIn.good())
+                {
+                    records.push_back(record);
+                    if(record.op != OVERLAY_DELETE)
+                    {
+                        entries.push_back(&data[idx * entrySize]);
+                    }
+                }
+            }
+            if(records.size() == header.records && merge(records, entries, baseRows, entrySize, map))
+            {
+                result = OVERLAY_LOAD_OVERLAY;
+            }
+        }
+    }
+    // Complete keymap, reduce it to the rows which differ.
+    else if((fileStat.st_size % entrySize) == 0)
+    {
+        data.resize(fileStat.st_size);
+        keyFileIn.clear();
+        keyFileIn.seekg(0);
+        keyFileIn.read((char *)data.data(), fileStat.st_size);
+        if(keyFileIn.good())
+        {
+            for(int idx=0; idx < (int)(fileStat.st_size / entrySize); idx++)
+            {
+                rows.push_back(&data[idx * entrySize]);
+            }
+            diff(rows, base, baseRows, entrySize, records, entries);
+            if(merge(records, entries, baseRows, entrySize, map))
+            {
+                result = OVERLAY_LOAD_COMPLETE;
+            }
+        }
+    }
+    keyFileIn.close();
+
+    if(result == OVERLAY_LOAD_INBUILT)
+    {
+        ESP_LOGW(OVERLAYTAG, "Failed to read keymap file:%s, using inbuilt keymap.", fileName.c_str());
+    }
+    return(result);
+}
+
+// Method to save a keymap as an overlay of the inbuilt keymap.
+//
+bool KeyMapOverlay::save(const std::string &fileName, const std::vector<const uint8_t *> &rows, const uint8_t *base, int baseRows, size_t entrySize)
+{
+    // Locals.
+    t_overlayHeader                 header;
+    std::vector<t_overlayRecord>    records;
+    std::vector<const uint8_t *>    entries;
+    std::vector<uint8_t>            noEntry(entrySize, 0x00);
+    bool                            result = true;
+
+    diff(rows, base, baseRows, entrySize, records, entries);
+
+    header.magic     = KEYMAP_OVERLAY_MAGIC;
+    header.format    = KEYMAP_OVERLAY_FORMAT;
+    header.entrySize = entrySize;
+    header.baseRows  = baseRows;
+    header.records   = records.size();
+
+    // Open file for binary writing, trunc specified to clear out the file, we arent appending.
+    std::fstream keyFileOut(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    keyFileOut.write((char *)&header, sizeof(t_overlayHeader));
+    for(std::size_t idx=0, entryIdx=0; idx < records.size() && keyFileOut.good(); idx++)
+    {
+        keyFileOut.write((char *)&records[idx], sizeof(t_overlayRecord));
+        keyFileOut.write((char *)(records[idx].op == OVERLAY_DELETE ? noEntry.data() : entries[entryIdx++]), entrySize);
+    }
+    if(keyFileOut.bad())
+    {
+        ESP_LOGW(OVERLAYTAG, "Failed to write keymap overlay to file:%s, deleting as state is unknown!", fileName.c_str());
+        keyFileOut.close();
+        std::remove(fileName.c_str());
+        result = false;
+    } else
+    {
+        keyFileOut.close();
+    }
+    return(result);
+}
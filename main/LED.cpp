@@ -11,6 +11,12 @@
 //
 // History:         Mar 2022 - Initial write.
 //            v1.01 May 2022 - Initial release version.
+//            v1.02 Oct 2026 - Blink waveform generated by the LEDC peripheral with an esp_timer for bursts,
+//                             the dedicated LED control thread is no longer required.
+//                             A new configuration is applied by its own kick timer so a change can no
+//                             longer restart or cut short the burst timer, LEDC period errors handled.
+//                             LEDC clock chosen per blink period, APB for short periods, REF_TICK for
+//                             long, as neither covers the full range.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -41,252 +47,224 @@
 #include "soc/timer_group_struct.h"
 #include "soc/timer_group_reg.h"
 #include "driver/timer.h"
+#include "driver/ledc.h"
+#include "esp_timer.h"
 #include "PS2KeyAdvanced.h"
 #include "PS2Mouse.h"
 #include "sdkconfig.h"
 #include "LED.h"
 
-// Method to set the LED mode, duty cycle and duty period. Once the current LED cycle has come to an end, the control
-// thread will replace the working configuration with the new configuration set here.
+// Method to set the LED mode, duty cycle and duty period. The configuration is staged and the kick timer is started so that
+// its callback applies it, the LEDC peripheral and timer are only ever programmed from that one context. The staging spinlock
+// is held for a structure copy only so this method never blocks and is safe to call on every keystroke.
 //
 bool LED::setLEDMode(enum LED_MODE mode, enum LED_DUTY_CYCLE dutyCycle, uint32_t maxBlinks, uint64_t usDutyPeriod, uint64_t msInterPeriod)
 {
     // Locals.
     //
-    bool result = true;
-
-    // If a setup is already waiting to be processed, exit with fail. This could be stacked into a vector but not really beneficial.
-    if(ledCtrl.newConfig.updated == false)
+    bool                kick;
+
+    portENTER_CRITICAL(&ledCtrl.cfgMutex);
+    kick = !ledCtrl.newConfig.updated;
+    ledCtrl.newConfig.mode        = mode;
+    ledCtrl.newConfig.dutyCycle   = dutyCycle;
+    ledCtrl.newConfig.maxBlinks   = maxBlinks;
+    ledCtrl.newConfig.dutyPeriod  = usDutyPeriod;
+    ledCtrl.newConfig.interPeriod = msInterPeriod;
+    ledCtrl.newConfig.updated     = true;
+    portEXIT_CRITICAL(&ledCtrl.cfgMutex);
+
+    // Kick the timer task to apply the configuration. The kick timer is started once per staged configuration, it is disarmed by the time
+    // its callback takes the configuration, so a configuration staged whilst a kick is pending is applied by that kick. The burst timer is
+    // never touched here, so a change cannot race the timer task arming it.
+    if(kick)
     {
-        // Ensure we have exclusive access, the LED can be controlled by numerous threads, so ensure only one can access and setup at a time.
-        if(xSemaphoreTake(ledCtrl.mutexInternal, (TickType_t)1000) == pdTRUE)
-        {
-            ledCtrl.newConfig.mode        = mode;
-            ledCtrl.newConfig.dutyCycle   = dutyCycle;
-            ledCtrl.newConfig.maxBlinks   = maxBlinks;
-            ledCtrl.newConfig.dutyPeriod  = usDutyPeriod;
-            ledCtrl.newConfig.interPeriod = msInterPeriod;
-            ledCtrl.newConfig.updated     = true;
-           
-            // Release mutex so other threads can set the LED.
-            xSemaphoreGive(ledCtrl.mutexInternal);
-        } else
-        {
-            result = false;
-        }
-    } else
-    {
-        result = false;
+        esp_timer_start_once(ledCtrl.kickTimer, 0);
     }
-    return(result);
+    return(true);
 }            
 
-// Thread method to provide LED control.
-IRAM_ATTR void LED::ledInterface(void *pvParameters)
+// Method to begin a burst of blinks. The LEDC counter is reset so the burst starts with the MARK of the first blink and, if the
+// burst is limited, the one-shot timer is armed to end it.
+void LED::startBurst(void)
+{
+    ledc_set_duty(LED_LEDC_MODE, LED_LEDC_CHANNEL, ledCtrl.ledcDuty);
+    ledc_update_duty(LED_LEDC_MODE, LED_LEDC_CHANNEL);
+    ledc_timer_rst(LED_LEDC_MODE, LED_LEDC_TIMER);
+    ledCtrl.inGap = false;
+
+    if(ledCtrl.burstBlinks > 0)
+    {
+        esp_timer_start_once(ledCtrl.burstTimer, (uint64_t)ledCtrl.burstBlinks * ledCtrl.blinkPeriod);
+    }
+}
+
+// Method to program the LEDC timer for a blink period. ledc_set_freq keeps the clock the timer was configured with and no one clock
+// covers every period, the 80MHz APB clock runs out of divider beyond ~13mS and the 1MHz REF_TICK cannot reach below ~1mS, so the
+// timer is configured afresh with the clock suited to the period.
+esp_err_t LED::configTimer(uint32_t period)
 {
     // Locals.
     //
-    uint32_t            LED_MASK;
-    uint64_t            delayTimer = 0LL;
-    uint64_t            curTime    = 0LL;
-    enum                LEDSTATE {
-                            LEDSTATE_IDLE        = 0,
-                            LEDSTATE_BLINK_MARK  = 1,
-                            LEDSTATE_BLINK_SPACE = 2,
-                            LEDSTATE_BLINK_INTER = 3,
-                        } fsmState = LEDSTATE_IDLE;
-    #define             LEDIFTAG "ledInterface"
-    
-    // Map the instantiating object so we can access its methods and data.
-    LED* pThis = (LED*)pvParameters;
-
-    // Set the LED GPIO mask according to the defined pin. This code needs updating if GPIO1 pins are used.
-    LED_MASK = (1 << pThis->ledCtrl.ledPin);
-
-    // Sign on.
-    ESP_LOGW("ledInterface", "Starting LED control thread.");
-
-    // Turn off LED.
-    GPIO.out_w1tc = LED_MASK;
-
-    // Loops forever.
-    for(;;)
+    ledc_timer_config_t     ledcTimer;
+
+    memset(&ledcTimer, 0, sizeof(ledc_timer_config_t));
+    ledcTimer.speed_mode      = LED_LEDC_MODE;
+    ledcTimer.duty_resolution = LED_LEDC_RESOLUTION;
+    ledcTimer.timer_num       = LED_LEDC_TIMER;
+    ledcTimer.freq_hz         = 1000000 / period;
+    ledcTimer.clk_cfg         = period > LED_APB_MAX_PERIOD ? LEDC_USE_REF_TICK : LEDC_USE_APB_CLK;
+    return(ledc_timer_config(&ledcTimer));
+}
+
+// Method to translate the current configuration into LEDC settings and burst parameters then start it.
+//
+// LED_MODE_BLINK         - Continuous blinking. If maxBlinks is set, a gap of interPeriod follows every maxBlinks blinks.
+// LED_MODE_BLINK_ONESHOT - Each blink is followed by a gap of interPeriod. If maxBlinks is set, the LED switches off after that many blinks.
+void LED::applyConfig(void)
+{
+    // Locals.
+    //
+    t_ledConfig        *cfg = &ledCtrl.currentConfig;
+    uint32_t            period;
+    #define             APPLYTAG "applyConfig"
+
+    // Cancel any burst or gap in progress.
+    esp_timer_stop(ledCtrl.burstTimer);
+    ledCtrl.burstCnt    = 0;
+    ledCtrl.burstBlinks = 0;
+    ledCtrl.burstLimit  = 0;
+    ledCtrl.ledcDuty    = 0;
+
+    switch(cfg->mode)
     {
-        // Check stack space, report if it is getting low.
-        if(uxTaskGetStackHighWaterMark(NULL) < 1024)
-        {
-            ESP_LOGW(LEDIFTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
-        }
+        case LED_MODE_ON:
+            ledCtrl.ledcDuty = LED_LEDC_MAX_DUTY;
+            break;
+
+        case LED_MODE_BLINK:
+        case LED_MODE_BLINK_ONESHOT:
+            // No duty cycle, no blink, LED remains off.
+            if(cfg->dutyCycle == LED_DUTY_CYCLE_OFF)
+                break;
+
+            // Clamp the period to that achievable by the LEDC timer. The timer is programmed in whole Hz so the period actually generated,
+            // which the burst timing must use, can differ from that requested. Only reprogram the timer if it has changed.
+            period = cfg->dutyPeriod < LED_MIN_PERIOD ? LED_MIN_PERIOD : cfg->dutyPeriod > LED_MAX_PERIOD ? LED_MAX_PERIOD : (uint32_t)cfg->dutyPeriod;
+            period = 1000000 / (1000000 / period);
+            if(period != ledCtrl.blinkPeriod)
+            {
+                // On failure the LEDC keeps the previous period, which the burst timing must continue to use.
+                if(configTimer(period) == ESP_OK)
+                {
+                    ledCtrl.blinkPeriod = period;
+                } else
+                {
+                    ESP_LOGW(APPLYTAG, "Blink period %duS not supported by the LEDC, %duS retained.", period, ledCtrl.blinkPeriod);
+                }
+            }
+            ledCtrl.ledcDuty = (LED_LEDC_MAX_DUTY * to_underlying(cfg->dutyCycle)) / 10;
 
-        // If a new configuration is set, then once the running FSM has returned to idle, update the configuration prior to the next FSM run.
-        //
-        if(pThis->ledCtrl.newConfig.updated)
-        {
-            // Take control of the Mutex so we are able to take on the data without a new setup clashing. If the Mutex is taken then continue on with the state machine logic till next loop.
-            if(xSemaphoreTake(pThis->ledCtrl.mutexInternal, (TickType_t)1) == pdTRUE)
+            if(cfg->mode == LED_MODE_BLINK)
+            {
+                ledCtrl.burstBlinks = cfg->maxBlinks;
+            } else
             {
-                pThis->ledCtrl.currentConfig = pThis->ledCtrl.newConfig;
-                pThis->ledCtrl.currentConfig.valid = true;
-                pThis->ledCtrl.newConfig.updated = false;
-                pThis->ledCtrl.blinkCnt = 0;
+                ledCtrl.burstBlinks = 1;
+                ledCtrl.burstLimit  = cfg->maxBlinks;
+            }
 
-                // Got new setup so release mutex.
-                xSemaphoreGive(pThis->ledCtrl.mutexInternal);
+            // Without a gap the bursts run back to back, so merge them into one.
+            if(cfg->interPeriod == 0)
+            {
+                ledCtrl.burstBlinks = ledCtrl.burstBlinks * ledCtrl.burstLimit;
+                ledCtrl.burstLimit  = ledCtrl.burstBlinks > 0 ? 1 : 0;
             }
-        }
+            break;
 
-        // Only run if we have a valid configuration.
-        if(pThis->ledCtrl.currentConfig.valid)
-        {
-            do {
-                // Get the current timer value, only run the FSM when the timer is idle.
-                timer_get_counter_value(TIMER_GROUP_0, TIMER_1, &curTime);
-                if(curTime >= delayTimer)
-                {
-                    // Ensure the timer is stopped.
-                    timer_pause(TIMER_GROUP_0, TIMER_1);
-                    delayTimer = 0LL;
-
-                    // Mini finite state machine for LED control.
-                    switch(fsmState)
-                    {
-                        case LEDSTATE_IDLE:
-                            // For on/off, no need for the FSM, just apply setting to LED and loop.
-                            switch(pThis->ledCtrl.currentConfig.mode)
-                            {
-                                case LED_MODE_ON:
-                                    // Turn on LED.
-                                    GPIO.out_w1ts = LED_MASK;
-                                    delayTimer = 1000UL;
-                                    break;
-
-                                case LED_MODE_BLINK_ONESHOT:
-                                    // If the number of blinks is not 0 then on reaching the count, switch to LED off mode.
-                                    if(pThis->ledCtrl.currentConfig.maxBlinks > 0 && pThis->ledCtrl.blinkCnt++ >= pThis->ledCtrl.currentConfig.maxBlinks)
-                                    {
-                                        pThis->ledCtrl.currentConfig.mode = LED_MODE_OFF;
-                                    } else
-                                    {
-                                        fsmState = LEDSTATE_BLINK_MARK;
-                                    }
-                                    break;
-
-                                case LED_MODE_BLINK:
-                                    // Normal blink mode increments the count which is used for determining inter blink period.
-                                    pThis->ledCtrl.blinkCnt++;
-                                    fsmState = LEDSTATE_BLINK_MARK;
-                                    break;
-
-                                case LED_MODE_OFF:
-                                default:
-                                    // Turn off LED.
-                                    GPIO.out_w1tc = LED_MASK;
-                                    delayTimer = 1000UL;
-                                    break;
-
-                            }
-                            break;
-
-                        case LEDSTATE_BLINK_MARK:
-                            // Turn on LED.
-                            GPIO.out_w1ts = LED_MASK;
-                            
-                            // Next state, SPACE.
-                            fsmState = LEDSTATE_BLINK_SPACE;
-
-                            // Calculate time to SPACE.
-                            switch(pThis->ledCtrl.currentConfig.dutyCycle)
-                            {
-                                case LED_DUTY_CYCLE_10:
-                                    delayTimer = (pThis->ledCtrl.currentConfig.dutyPeriod / 10);
-                                    break;
-                                case LED_DUTY_CYCLE_20:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 2);
-                                    break;
-                                case LED_DUTY_CYCLE_30:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 3);
-                                    break;
-                                case LED_DUTY_CYCLE_40:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 4);
-                                    break;
-                                case LED_DUTY_CYCLE_50:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 5);
-                                    break;
-                                case LED_DUTY_CYCLE_60:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 6);
-                                    break;
-                                case LED_DUTY_CYCLE_70:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 7);
-                                    break;
-                                case LED_DUTY_CYCLE_80:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 8);
-                                    break;
-                                case LED_DUTY_CYCLE_90:
-                                    delayTimer = ((pThis->ledCtrl.currentConfig.dutyPeriod / 10) * 9);
-                                    break;
-                                // We shouldnt be here if duty cycle is off, so back to idle.
-                                case LED_DUTY_CYCLE_OFF:
-                                default:
-                                    GPIO.out_w1tc = LED_MASK;
-                                    delayTimer = 0;
-                                    fsmState = LEDSTATE_IDLE;
-                                    break;
-                            }
-                            break;
-
-                        case LEDSTATE_BLINK_SPACE:
-                            // Turn off LED.
-                            GPIO.out_w1tc = LED_MASK;
-
-                            // Calculate time to next MARK.
-                            delayTimer = pThis->ledCtrl.currentConfig.dutyPeriod - delayTimer;
-
-                            // Now add an interblink delay prior to next blink.
-                            fsmState = LEDSTATE_BLINK_INTER;
-                            break;
-
-                        case LEDSTATE_BLINK_INTER:
-                            // If we are in normal mode with a blink limit set and limit reached or in limited mode, then add an interblink delay as configured.
-                            if((pThis->ledCtrl.currentConfig.mode == LED_MODE_BLINK && pThis->ledCtrl.currentConfig.maxBlinks > 0 && pThis->ledCtrl.blinkCnt >= pThis->ledCtrl.currentConfig.maxBlinks) ||
-                               (pThis->ledCtrl.currentConfig.mode == LED_MODE_BLINK_ONESHOT))
-                            {
-                                // Interblink delay is given in milli-seconds, so multiply up and set delay.
-                                delayTimer = pThis->ledCtrl.currentConfig.interPeriod * 1000;
-
-                                // Reset blink counter to trigger next interperiod delay.
-                                if(pThis->ledCtrl.currentConfig.mode == LED_MODE_BLINK)
-                                    pThis->ledCtrl.blinkCnt = 0;
-                            }
-                            
-                            // We return to IDLE to allow time for reconfiguration if requested.
-                            fsmState = LEDSTATE_IDLE;
-                            break;
-
-                        // Unknown or not programmed state, return to IDLE.
-                        default:
-                            fsmState = LEDSTATE_IDLE;
-                            break;
-                    }
-
-                    // If a new delay is requested, reset the value in the timer and start.
-                    if(delayTimer > 0LL)
-                    {
-                        timer_set_counter_value(TIMER_GROUP_0, TIMER_1, 0LL);
-                        timer_start(TIMER_GROUP_0, TIMER_1);
-                    }
-                }
+        case LED_MODE_OFF:
+        default:
+            break;
+    }
+    startBurst();
+}
 
-                // Give the OS some time...
-                taskYIELD();
-            } while(fsmState != LEDSTATE_IDLE);
+// Method to take a newly staged configuration as the current configuration, returns true if there was one.
+bool LED::takeConfig(void)
+{
+    // Locals.
+    //
+    bool                updated = false;
+
+    portENTER_CRITICAL(&ledCtrl.cfgMutex);
+    if(ledCtrl.newConfig.updated)
+    {
+        ledCtrl.currentConfig = ledCtrl.newConfig;
+        ledCtrl.currentConfig.valid = true;
+        ledCtrl.newConfig.updated = false;
+        updated = true;
+    }
+    portEXIT_CRITICAL(&ledCtrl.cfgMutex);
+    return(updated);
+}
+
+// Kick timer callback, runs in the esp_timer task. Applies the newly staged configuration.
+void LED::ledKickCallback(void *pvParameters)
+{
+    // Locals.
+    //
+    LED                *pThis = (LED*)pvParameters;
+
+    if(pThis->takeConfig())
+    {
+        pThis->applyConfig();
+    }
+}
 
+// Burst timer callback, runs in the esp_timer task. Applies a newly staged configuration, should its kick not yet have run, or, if none,
+// advances the burst engine between a burst of blinks and the gap which follows it.
+void LED::ledTimerCallback(void *pvParameters)
+{
+    // Locals.
+    //
+    LED                *pThis = (LED*)pvParameters;
+
+    if(pThis->takeConfig())
+    {
+        pThis->applyConfig();
+    }
+    else if(pThis->ledCtrl.inGap)
+    {
+        // Gap complete, start the next burst.
+        pThis->startBurst();
+    }
+    else if(pThis->ledCtrl.currentConfig.valid && pThis->ledCtrl.burstBlinks > 0)
+    {
+        // Burst complete, LED off.
+        ledc_set_duty(LED_LEDC_MODE, LED_LEDC_CHANNEL, 0);
+        ledc_update_duty(LED_LEDC_MODE, LED_LEDC_CHANNEL);
+
+        // On reaching the burst limit switch to LED off mode, otherwise wait out the gap.
+        if(pThis->ledCtrl.burstLimit > 0 && ++pThis->ledCtrl.burstCnt >= pThis->ledCtrl.burstLimit)
+        {
+            pThis->ledCtrl.currentConfig.mode = LED_MODE_OFF;
+            pThis->ledCtrl.burstBlinks = 0;
+        } else
+        {
+            pThis->ledCtrl.inGap = true;
+            esp_timer_start_once(pThis->ledCtrl.burstTimer, pThis->ledCtrl.currentConfig.interPeriod * 1000);
         }
     }
 }
 
-// Method to set the GPIO pin to be used for LED output.
+// Method to set the GPIO pin to be used for LED output and configure the LEDC peripheral and burst timer which drive it.
 void LED::ledInit(uint8_t ledPin)
 {
+    // Locals.
+    //
+    ledc_channel_config_t   ledcChannel;
+    esp_timer_create_args_t timerArgs;
+
     // Initialise variables.
     this->ledCtrl.currentConfig.valid = false;
     this->ledCtrl.currentConfig.updated = false;
@@ -295,32 +273,45 @@ void LED::ledInit(uint8_t ledPin)
     this->ledCtrl.currentConfig.dutyPeriod = 0LL;
     this->ledCtrl.currentConfig.interPeriod = 0LL;
     this->ledCtrl.newConfig = this->ledCtrl.currentConfig;
+    this->ledCtrl.burstBlinks = 0;
+    this->ledCtrl.burstLimit = 0;
+    this->ledCtrl.burstCnt = 0;
+    this->ledCtrl.ledcDuty = 0;
+    this->ledCtrl.blinkPeriod = 1000;
+    this->ledCtrl.inGap = false;
+    this->ledCtrl.cfgMutex = portMUX_INITIALIZER_UNLOCKED;
 
     // Store GPIO pin to which LED is connected.
     this->ledCtrl.ledPin = ledPin;
 
-    // Configure a timer to be used for the LED blink rate.
-    timer_config_t timerConfig = {
-        .alarm_en    = TIMER_ALARM_DIS,            // No alarm, were not using interrupts as we are in a dedicated thread.
-        .counter_en  = TIMER_PAUSE,                // Timer paused until required.
-        .intr_type   = TIMER_INTR_LEVEL,           // No interrupts used.
-        .counter_dir = TIMER_COUNT_UP,             // Timing a fixed period.
-        .auto_reload = TIMER_AUTORELOAD_DIS,       // No need for auto reload, fixed time period.
-        .divider     = 80                          // 1Mhz operation giving 1uS resolution.
-    };
-    ESP_ERROR_CHECK(timer_init(TIMER_GROUP_0, TIMER_1, &timerConfig));
-    ESP_ERROR_CHECK(timer_set_counter_value(TIMER_GROUP_0, TIMER_1, 0));            
-
-    // Setup mutex's.
-    ledCtrl.mutexInternal = xSemaphoreCreateMutex();
-
-    // Core 0 - Application
-    // LED control thread - dedicated thread to control the LED according to set mode.
-    ESP_LOGW("ledInit", "Starting LEDif thread...");
-    ::xTaskCreatePinnedToCore(&this->ledInterface, "ledif", 4096, this, 0, &this->TaskLEDIF, 0);            
+    // Configure the LEDC timer which generates the blink period in hardware, the period is reprogrammed per configuration.
+    ESP_ERROR_CHECK(configTimer(this->ledCtrl.blinkPeriod));
+
+    // Attach the LED pin to a channel, initially off.
+    memset(&ledcChannel, 0, sizeof(ledc_channel_config_t));
+    ledcChannel.gpio_num      = ledPin;
+    ledcChannel.speed_mode    = LED_LEDC_MODE;
+    ledcChannel.channel       = LED_LEDC_CHANNEL;
+    ledcChannel.intr_type     = LEDC_INTR_DISABLE;
+    ledcChannel.timer_sel     = LED_LEDC_TIMER;
+    ledcChannel.duty          = 0;
+    ledcChannel.hpoint        = 0;
+    ESP_ERROR_CHECK(ledc_channel_config(&ledcChannel));
+
+    // One-shot timers to end bursts and time the gaps, and to apply new configurations. Both run in the esp_timer task so the LEDC
+    // and burst timer are only programmed from one context.
+    memset(&timerArgs, 0, sizeof(esp_timer_create_args_t));
+    timerArgs.callback        = &LED::ledTimerCallback;
+    timerArgs.arg             = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name            = "ledburst";
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &this->ledCtrl.burstTimer));
+    timerArgs.callback        = &LED::ledKickCallback;
+    timerArgs.name            = "ledkick";
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &this->ledCtrl.kickTimer));
 }
 
-// Constructor, basically initialise the Singleton interface and let the control thread loose.
+// Constructor, basically initialise the Singleton interface and configure the LED hardware.
 LED::LED(uint32_t hwPin)
 {
     // Store the class name for later use, ie. NVS key access.
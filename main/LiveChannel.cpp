@@ -0,0 +1,241 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            LiveChannel.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     WebSocket live channel protocol. Keymap row edits from the editor are decoded and
+//                  applied to the interface, status is built for the periodic push and, in WiFi mode,
+//                  keys typed on a PS/2 keyboard are looked up in the active keymap and pushed so the
+//                  effect of an edit can be seen as it is made. The HTTP server only carries frames to
+//                  and from this class, so the protocol can be run against a stand-in server on a host.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Typed keys are looked up, not mapped, and pushed with the keymap row they select.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "KeyMapOverlay.h"
+#include "LiveChannel.h"
+
+// Tag for logging.
+#define LIVECHANNELTAG                 "LiveChannel"
+
+// Method to decode a keymap edit frame. The frame holds LIVECHANNEL_MSG_KEYMAP_EDIT, the edit count, the row size and then for each edit
+// the operation, the row (16 bit little endian) and, for an insert or replace, the row bytes. A truncated or overlong frame is rejected as a whole.
+//
+bool LiveChannel::parseKeyMapEdit(const std::vector<uint8_t> &payload, std::vector<KeyInterface::t_keyMapEdit> &edits)
+{
+    // Locals.
+    //
+    size_t                 pos = 3;
+    uint8_t                entrySize;
+
+    edits.clear();
+    if(payload.size() < 3 || payload[0] != LIVECHANNEL_MSG_KEYMAP_EDIT)
+    {
+        return(false);
+    }
+    entrySize = payload[2];
+    edits.resize(payload[1]);
+    for(std::size_t idx=0; idx < edits.size() && pos != 0; idx++)
+    {
+        if(pos + 3 > payload.size())
+        {
+            pos = 0;
+        } else
+        {
+            edits[idx].op  = payload[pos];
+            edits[idx].row = payload[pos+1] | (payload[pos+2] << 8);
+            pos += 3;
+            if(edits[idx].op != KeyMapOverlay::OVERLAY_DELETE)
+            {
+                if(pos + entrySize > payload.size())
+                {
+                    pos = 0;
+                } else
+                {
+                    edits[idx].entry.assign(payload.begin() + pos, payload.begin() + pos + entrySize);
+                    pos += entrySize;
+                }
+            }
+        }
+    }
+    return(pos == payload.size());
+}
+
+// Method to process a frame received from a client. Keymap edits are applied together and acknowledged with LIVECHANNEL_MSG_KEYMAP_ACK, the
+// status (0 = applied) and the rows now in the keymap (16 bit little endian), the other clients are told the keymap changed. A text frame with
+// "status" is answered with the status. Returns true if there is a reply for the sender, the broadcast is empty if there is nothing for the others.
+//
+bool LiveChannel::receive(const t_frame &frame, t_frame &reply, std::string &broadcast)
+{
+    // Locals.
+    //
+    int                    rows = -1;
+    bool                   result = false;
+    std::string            text;
+    std::vector<KeyInterface::t_keyMapEdit> edits;
+
+    broadcast.clear();
+    if(frame.binary == true && frame.payload.size() > 0 && frame.payload[0] == LIVECHANNEL_MSG_KEYMAP_EDIT)
+    {
+        if(keyIf != NULL && parseKeyMapEdit(frame.payload, edits) == true)
+        {
+            rows = keyIf->editKeyMap(edits);
+        }
+        ESP_LOGI(LIVECHANNELTAG, "Keymap edit, %d rows changed, %s.", (int)edits.size(), rows < 0 ? "rejected" : "applied");
+
+        reply.binary  = true;
+        reply.payload = { LIVECHANNEL_MSG_KEYMAP_ACK, (uint8_t)(rows < 0 ? 1 : 0), (uint8_t)((rows < 0 ? 0 : rows) & 0xFF), (uint8_t)(((rows < 0 ? 0 : rows) >> 8) & 0xFF) };
+        if(rows >= 0)
+        {
+            broadcast = "{\"type\":\"keymap\",\"rows\":" + std::to_string(rows) + "}";
+        }
+        result = true;
+    }
+    else if(frame.binary == false && std::string(frame.payload.begin(), frame.payload.end()).compare("status") == 0)
+    {
+        text          = status();
+        reply.binary  = false;
+        reply.payload.assign(text.begin(), text.end());
+        result = true;
+    }
+    return(result);
+}
+
+// Method to build the status message pushed to clients.
+//
+std::string LiveChannel::status(void)
+{
+    // Locals.
+    //
+    std::string            status;
+
+    status  = "{\"type\":\"status\",\"uptime\":" + std::to_string((uint32_t)(esp_timer_get_time() / 1000000));
+    status += ",\"heap\":"    + std::to_string(esp_get_free_heap_size());
+    status += ",\"heapMin\":" + std::to_string(esp_get_minimum_free_heap_size());
+    status += ",\"interface\":\"" + (keyIf == NULL ? std::string("") : keyIf->ifName()) + "\"}";
+    return(status);
+}
+
+// Method to look a key up in the active keymap and build the key message, the PS/2 scan code as read and the keymap row the key selects,
+// -1 if none. The key is looked up rather than mapped so the interface state is left as it was. The lookup is bracketed as on the HID
+// thread so a keymap edit published meanwhile waits for the key to finish.
+//
+std::string LiveChannel::keyEvent(uint16_t scanCode)
+{
+    // Locals.
+    //
+    int                    row = -1;
+
+    if(keyIf != NULL)
+    {
+        keyIf->keyMapReadBegin();
+        row = keyIf->lookupKey(scanCode);
+        keyIf->keyMapReadEnd();
+    }
+    return("{\"type\":\"key\",\"scanCode\":" + std::to_string(scanCode) + ",\"row\":" + std::to_string(row) + "}");
+}
+
+// Key monitor thread, reads keys straight from the keyboard and pushes each one with its keymap row until stopped. The interface readKey
+// is not used, its macro and ESC handling belong to the HID thread.
+//
+void LiveChannel::keyMonitor(void *pvParameters)
+{
+    // Locals.
+    //
+    uint16_t               scanCode;
+
+    // Map the instantiating object so we can access its methods and data.
+    LiveChannel* pThis = (LiveChannel*)pvParameters;
+
+    while(pThis->monitor.run)
+    {
+        if((scanCode = pThis->keyIf->hid->read()) != 0)
+        {
+            pThis->monitor.push(pThis->monitor.ctx, pThis->keyEvent(scanCode));
+        } else
+        {
+            vTaskDelay(LIVECHANNEL_KEY_POLL_MS / portTICK_PERIOD_MS);
+        }
+    }
+    pThis->monitor.running = false;
+    vTaskDelete(NULL);
+}
+
+// Method to start the key monitor, each key read from the interface keyboard is looked up and given to the push callback. Only one monitor runs.
+//
+bool LiveChannel::startKeyMonitor(t_pushCallback push, void *ctx)
+{
+    if(keyIf == NULL || keyIf->hid == NULL || push == NULL || monitor.running)
+    {
+        return(false);
+    }
+    monitor.push    = push;
+    monitor.ctx     = ctx;
+    monitor.run     = true;
+    monitor.running = true;
+    ::xTaskCreatePinnedToCore(&this->keyMonitor, "liveKeys", 4096, this, 0, NULL, 0);
+    return(true);
+}
+
+// Method to stop the key monitor, returns once the thread has stopped reading keys.
+//
+void LiveChannel::stopKeyMonitor(void)
+{
+    monitor.run = false;
+    while(monitor.running)
+    {
+        vTaskDelay(1);
+    }
+}
+
+// Constructor, the channel applies edits to and maps keys through the given interface, NULL if there is no keyboard interface.
+LiveChannel::LiveChannel(KeyInterface *hdlKeyIf)
+{
+    keyIf           = hdlKeyIf;
+    monitor.push    = NULL;
+    monitor.ctx     = NULL;
+    monitor.run     = false;
+    monitor.running = false;
+}
+
+// Constructor, used for version reporting.
+LiveChannel::LiveChannel(void)
+{
+    keyIf           = NULL;
+    monitor.push    = NULL;
+    monitor.ctx     = NULL;
+    monitor.run     = false;
+    monitor.running = false;
+}
+
+// Destructor, stops the key monitor if running.
+LiveChannel::~LiveChannel(void)
+{
+    stopKeyMonitor();
+}
@@ -36,6 +36,14 @@
 //            v1.02 Jun 2022 - Updated interface to yield Core 1 when no key has been pressed. This is
 //                             necessary to allow Bluetooth and NVS to work (even though BT is pinned
 //                             to core 0, the NVS seems to require both CPU's).
+//            v1.03 Oct 2026 - Keystroke macro playback, keys are held for a number of host matrix scans
+//                             which are counted in the interface loops.
+//            v1.04 Oct 2026 - Keymap row edits from the web editor applied without a full table upload.
+//            v1.05 Oct 2026 - Key latency recorded in the runtime metrics, a key is timed from entering the
+//                             matrix to the start of the first host scan which sees it.
+//            v1.06 Oct 2026 - Macro characters reverse mapped through the active keymap and the matrix key
+//                             legends rather than a fixed PC layout.
+//            v1.07 Oct 2026 - A macro key the host is slow to scan is reported as a reject, slowing playback.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -77,6 +85,25 @@
 #include "sdkconfig.h"
 #include "MZ2528.h"
 
+// Inbuilt keymap, constant so it is held in flash rather than copied into each instance.
+constexpr MZ2528::t_keyMap MZ2528::PS2toMZ;
+
+// Character on each MZ-2500/MZ-2800 matrix key, unshifted then shifted, for matrix rows 3 to 10 and column bits 0 to 7. Keys without a
+// character are 0. The MZ-80B/MZ-2000 differ on two keys of row 7, given separately.
+static const char mzLegend[8][8][2] = {
+    { { '\t', '\t' }, { ' ',  ' '  }, { '\r', '\r' }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 } },    // Row 3
+    { { '/',  '?'  }, { 'A',  'a'  }, { 'B',  'b'  }, { 'C',  'c'  }, { 'D',  'd'  }, { 'E',  'e'  }, { 'F',  'f'  }, { 'G',  'g'  } },    // Row 4
+    { { 'H',  'h'  }, { 'I',  'i'  }, { 'J',  'j'  }, { 'K',  'k'  }, { 'L',  'l'  }, { 'M',  'm'  }, { 'N',  'n'  }, { 'O',  'o'  } },    // Row 5
+    { { 'P',  'p'  }, { 'Q',  'q'  }, { 'R',  'r'  }, { 'S',  's'  }, { 'T',  't'  }, { 'U',  'u'  }, { 'V',  'v'  }, { 'W',  'w'  } },    // Row 6
+    { { 'X',  'x'  }, { 'Y',  'y'  }, { 'Z',  'z'  }, { '^',  0x00 }, { '\\', '|'  }, { '_',  0x00 }, { '.',  '>'  }, { ',',  '<'  } },    // Row 7
+    { { '0',  0x00 }, { '1',  '!'  }, { '2',  '"'  }, { '3',  '#'  }, { '4',  '$'  }, { '5',  '%'  }, { '6',  '&'  }, { '7',  '\'' } },    // Row 8
+    { { '8',  '('  }, { '9',  ')'  }, { ':',  '*'  }, { ';',  '+'  }, { '-',  '='  }, { '@',  '`'  }, { '[',  '{'  }, { 0x00, 0x00 } },    // Row 9
+    { { ']',  '}'  }, { 0x00, 0x00 }, { 0x00, 0x00 }, { 0x00, 0x00 }, { '\b', '\b' }, { 0x1B, 0x1B }, { 0x00, 0x00 }, { 0x00, 0x00 } },    // Row 10
+};
+static const char mz80bLegendRow7[8][2] = {
+      { 'X',  'x'  }, { 'Y',  'y'  }, { 'Z',  'z'  }, { '^',  '~'  }, { '\\', '|'  }, { '?',  0x00 }, { '.',  '>'  }, { ',',  '<'  }
+};
+
 // Tag for ESP main application logging.
 #define  MAINTAG  "mz25key"
 
@@ -116,6 +143,7 @@ IRAM_ATTR void MZ2528::mz25Interface( void * pvParameters )
     bool              critical = false;
     volatile uint32_t gpioIN;
     volatile uint8_t  strobeRow = 1;
+    uint8_t           lastRow = 0;
 
     // Mask values declared as variables, let the optimiser decide wether they are constants or placed in-memory.
     uint32_t          rowBitMask = (1 << CONFIG_HOST_KDB3) | (1 << CONFIG_HOST_KDB2) | (1 << CONFIG_HOST_KDB1) | (1 << CONFIG_HOST_KDB0);
@@ -141,6 +169,9 @@ IRAM_ATTR void MZ2528::mz25Interface( void * pvParameters )
     // Sign on.
     ESP_LOGW(MAINTAG, "Starting mz25Interface thread, colBitMask=%08x, rowBitMask=%08x.", colBitMask, rowBitMask);
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HOSTIF);
+
     // Permanent loop, just wait for an RTSN strobe, latch the row, lookup matrix and output.
     // Timings with Power LED = LED Off to On = 108ns, LED On to Off = 392ns
     for(;;)
@@ -200,10 +231,17 @@ IRAM_ATTR void MZ2528::mz25Interface( void * pvParameters )
             {
                 // Set all required KDO bits according to keyMatrix, set state = '0'.
                 GPIO.out_w1tc = pThis->mzControl.keyMatrixAsGPIO[strobeRow];  // Set to '0' active bits.
+
+                // A row number lower than the last starts a new scan of the matrix.
+                if(strobeRow < lastRow) pThis->hostScanStart();
+                lastRow = strobeRow;
             } else
             {
                 // Set all required KDO bits according to the strobe all value. set state = '0'.
                 GPIO.out_w1tc = pThis->mzControl.strobeAllAsGPIO;             // Set to '0' active bits.
+
+                // Strobe all samples every key, count as a scan.
+                pThis->hostScanStart();
             }
 
             // Wait for RTSN to go low. No lockup guarding as timing is critical also the watchdog is disabled, if RTSN never goes low then the user has probably unplugged the interface!
@@ -256,6 +294,7 @@ IRAM_ATTR void MZ2528::mz28Interface( void * pvParameters )
     bool              critical = false;
     volatile uint32_t gpioIN;
     volatile uint8_t  strobeRow = 1;
+    uint8_t           lastRow = 0;
 
     // Mask values declared as variables, let the optimiser decide wether they are constants or placed in-memory.
     uint32_t          rowBitMask = (1 << CONFIG_HOST_KDB3) | (1 << CONFIG_HOST_KDB2) | (1 << CONFIG_HOST_KDB1) | (1 << CONFIG_HOST_KDB0);
@@ -278,6 +317,9 @@ IRAM_ATTR void MZ2528::mz28Interface( void * pvParameters )
     // Sign on.
     ESP_LOGW(MAINTAG, "Starting mz28Interface thread, colBitMask=%08x, rowBitMask=%08x.", colBitMask, rowBitMask);
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HOSTIF);
+
     // Permanent loop, just wait for an RTSN strobe, latch the row, lookup matrix and output.
     for(;;)
     {
@@ -342,10 +384,17 @@ IRAM_ATTR void MZ2528::mz28Interface( void * pvParameters )
             {
                 // Set all required KDO bits according to keyMatrix, set state = '0'.
                 GPIO.out_w1tc = pThis->mzControl.keyMatrixAsGPIO[strobeRow];  // Set to '0' active bits.
+
+                // A row number lower than the last starts a new scan of the matrix.
+                if(strobeRow < lastRow) pThis->hostScanStart();
+                lastRow = strobeRow;
             } else
             {
                 // Set all required KDO bits according to the strobe all value. set state = '0'.
                 GPIO.out_w1tc = pThis->mzControl.strobeAllAsGPIO;             // Set to '0' active bits.
+
+                // Strobe all samples every key, count as a scan.
+                pThis->hostScanStart();
             }
 
             // Wait for RTSN to go low. No lockup guarding as timing is critical also the watchdog is disabled, if RTSN never goes low then the user has probably unplugged the interface!
@@ -404,6 +453,15 @@ void MZ2528::selectOption(uint8_t optionCode)
             this->mzConfig.params.activeKeyboardMap = KEYMAP_STANDARD;
             break;
 
+        // Play a keystroke macro, F1..F4 select the macro file.
+        case PS2_KEY_F1:
+        case PS2_KEY_F2:
+        case PS2_KEY_F3:
+        case PS2_KEY_F4:
+            updated = false;
+            macroPlay(KeyMacro::fileName(this->mzControl.keyMapFileName, optionCode - PS2_KEY_F1 + 1));
+            break;
+
         // Select the active machine model. If we are connected to an MZ-2500 host then it is possible to enable an MZ-2000/MZ-80B mapping.
         case PS2_KEY_END:
             this->mzConfig.params.activeMachineModel = (this->mzControl.mode2500 ? MZ_2500 : MZ_2800);
@@ -487,7 +545,8 @@ void MZ2528::updateMirrorMatrix(void)
 uint32_t MZ2528::mapKey(uint16_t scanCode)
 {
     // Locals.
-    uint8_t   idx;
+    t_keyMapTable<t_keyMapEntry> *keyMap = mzControl.keyMap;
+    uint32_t  idx;
     bool      changed = false;
     bool      matchExact = false;
     uint8_t   keyCode = (scanCode & 0xFF);
@@ -535,30 +594,30 @@ uint32_t MZ2528::mapKey(uint16_t scanCode)
         // Loop through the entire conversion table to find a match on this key, if found appy the conversion to the virtual
         // switch matrix.
         //
-        for(idx=0, changed=false, matchExact=false; idx < mzControl.kmeRows && (changed == false || (changed == true && matchExact == false)); idx++)
+        for(idx=0, changed=false, matchExact=false; idx < (uint32_t)keyMap->rows && (changed == false || (changed == true && matchExact == false)); idx++)
         {
             // Match key code? Make sure the current machine and keymap match as well.
-            if(mzControl.kme[idx].ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((mzControl.kme[idx].machine == MZ_ALL) || (mzControl.kme[idx].machine & mzConfig.params.activeMachineModel) != 0) && ((mzControl.kme[idx].keyboardModel & mzConfig.params.activeKeyboardMap) != 0))
+            if(keyMap->row(idx).ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((keyMap->row(idx).machine == MZ_ALL) || (keyMap->row(idx).machine & mzConfig.params.activeMachineModel) != 0) && ((keyMap->row(idx).keyboardModel & mzConfig.params.activeKeyboardMap) != 0))
             {
                 // Match Raw, Shift, Function, Control, ALT or ALT-Gr?
-                if( (((mzControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((mzControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC) == 0) && ((mzControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL) == 0) && ((mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALT) == 0) && ((mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALTGR) == 0)) ||
-                    ((scanCode & PS2_SHIFT)    && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) || 
-                    ((scanCode & PS2_CTRL)     && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
-                    ((scanCode & PS2_ALT)      && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALT)   != 0) ||
-                    ((scanCode & PS2_ALT_GR)   && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALTGR) != 0) ||
-                    ((scanCode & PS2_GUI)      && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || 
-                    ((scanCode & PS2_FUNCTION) && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+                if( (((keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_ALT) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_ALTGR) == 0)) ||
+                    ((scanCode & PS2_SHIFT)    && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) || 
+                    ((scanCode & PS2_CTRL)     && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                    ((scanCode & PS2_ALT)      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_ALT)   != 0) ||
+                    ((scanCode & PS2_ALT_GR)   && (keyMap->row(idx).ps2Ctrl & PS2CTRL_ALTGR) != 0) ||
+                    ((scanCode & PS2_GUI)      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || 
+                    ((scanCode & PS2_FUNCTION) && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) )
                 {
                     // Exact entry match, data + control key? On an exact match we only process the first key. On a data only match we fall through to include additional data and control key matches to allow for un-mapped key combinations, ie. Japanese characters.
-                    matchExact = (((scanCode & PS2_SHIFT)    && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0    && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
-                                 (((scanCode & PS2_CTRL)     && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0     && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
-                                 (((scanCode & PS2_ALT)      && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALT)   != 0) || ((scanCode & PS2_ALT) == 0      && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALT)   == 0)) &&
-                                 (((scanCode & PS2_ALT_GR)   && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALTGR) != 0) || ((scanCode & PS2_ALT_GR) == 0   && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_ALTGR) == 0)) &&
-                                 (((scanCode & PS2_GUI)      && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0      && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
-                                 (((scanCode & PS2_FUNCTION) && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0 && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0)) ? true : false;
+                    matchExact = (((scanCode & PS2_SHIFT)    && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0    && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                                 (((scanCode & PS2_CTRL)     && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0     && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                                 (((scanCode & PS2_ALT)      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_ALT)   != 0) || ((scanCode & PS2_ALT) == 0      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_ALT)   == 0)) &&
+                                 (((scanCode & PS2_ALT_GR)   && (keyMap->row(idx).ps2Ctrl & PS2CTRL_ALTGR) != 0) || ((scanCode & PS2_ALT_GR) == 0   && (keyMap->row(idx).ps2Ctrl & PS2CTRL_ALTGR) == 0)) &&
+                                 (((scanCode & PS2_GUI)      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                                 (((scanCode & PS2_FUNCTION) && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0)) ? true : false;
 
                     // If the exact flag is set, skip as we cannot process this entry when we dont have an exact match.
-                    if(matchExact == false && (mzControl.kme[idx].ps2Ctrl & PS2CTRL_EXACT) != 0)
+                    if(matchExact == false && (keyMap->row(idx).ps2Ctrl & PS2CTRL_EXACT) != 0)
                         continue;
                   
                     // RELEASE (PS2_BREAK == 1) or PRESS?
@@ -577,9 +636,9 @@ uint32_t MZ2528::mapKey(uint16_t scanCode)
                         for(int row=0; row < PS2TBL_MZ_MAX_MKROW; row++)
                         {
                             // Reset the matrix bit according to the lookup table. 1 = No key, 0 = key in the matrix.
-                            if(mzControl.kme[idx].mkRow[row] != 0xFF)
+                            if(keyMap->row(idx).mkRow[row] != 0xFF)
                             {
-                                mzControl.keyMatrix[mzControl.kme[idx].mkRow[row]] |= mzControl.kme[idx].mkKey[row];
+                                mzControl.keyMatrix[keyMap->row(idx).mkRow[row]] |= keyMap->row(idx).mkKey[row];
                                 changed = true;
                             }
                         }
@@ -589,9 +648,9 @@ uint32_t MZ2528::mapKey(uint16_t scanCode)
                         //
                         for(int row=0; row < PS2TBL_MZ_MAX_BRKROW; row++)
                         {
-                            if(mzControl.kme[idx].brkRow[row] != 0xFF)
+                            if(keyMap->row(idx).brkRow[row] != 0xFF)
                             {
-                                mzControl.keyMatrix[mzControl.kme[idx].brkRow[row]] &= ~mzControl.kme[idx].brkKey[row];
+                                mzControl.keyMatrix[keyMap->row(idx).brkRow[row]] &= ~keyMap->row(idx).brkKey[row];
                                 changed = true;
                             }
                         }
@@ -602,9 +661,9 @@ uint32_t MZ2528::mapKey(uint16_t scanCode)
                         //
                         for(int row=0; row < PS2TBL_MZ_MAX_BRKROW; row++)
                         {
-                            if(mzControl.kme[idx].brkRow[row] != 0xFF)
+                            if(keyMap->row(idx).brkRow[row] != 0xFF)
                             {
-                                mzControl.keyMatrix[mzControl.kme[idx].brkRow[row]] |= mzControl.kme[idx].brkKey[row];
+                                mzControl.keyMatrix[keyMap->row(idx).brkRow[row]] |= keyMap->row(idx).brkKey[row];
                                 changed = true;
                             }
                         }
@@ -622,9 +681,9 @@ uint32_t MZ2528::mapKey(uint16_t scanCode)
                         for(int row=0; row < PS2TBL_MZ_MAX_MKROW; row++)
                         {
                             // Set the matrix bit according to the lookup table. 1 = No key, 0 = key in the matrix.
-                            if(mzControl.kme[idx].mkRow[row] != 0xFF)
+                            if(keyMap->row(idx).mkRow[row] != 0xFF)
                             {
-                                mzControl.keyMatrix[mzControl.kme[idx].mkRow[row]] &= ~mzControl.kme[idx].mkKey[row];
+                                mzControl.keyMatrix[keyMap->row(idx).mkRow[row]] &= ~keyMap->row(idx).mkKey[row];
                                 changed = true;
                             }
                         }
@@ -644,6 +703,182 @@ uint32_t MZ2528::mapKey(uint16_t scanCode)
     return((uint32_t)changed);
 }
 
+// Method to give the keymap row a key make selects, -1 if none. Used by the live key monitor, no interface state is changed.
+//
+int MZ2528::lookupKey(uint16_t scanCode)
+{
+    return(macroMapRow(mzControl.keyMap, scanCode & ~PS2_BREAK));
+}
+
+// Method to find the keymap row mapKey applies to the matrix for a key make. Returns -1 if no row applies or if more than one does, as
+// rows without an exact match fall through and later rows add to the matrix.
+//
+int MZ2528::macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode)
+{
+    // Locals.
+    int       row = -1;
+    bool      matchExact;
+    bool      hasMake;
+
+    for(int idx=0; idx < keyMap->rows; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if(kme.ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((kme.machine == MZ_ALL) || (kme.machine & mzConfig.params.activeMachineModel) != 0) && ((kme.keyboardModel & mzConfig.params.activeKeyboardMap) != 0))
+        {
+            if( (((kme.ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((kme.ps2Ctrl & PS2CTRL_FUNC) == 0) && ((kme.ps2Ctrl & PS2CTRL_CTRL) == 0) && ((kme.ps2Ctrl & PS2CTRL_ALT) == 0) && ((kme.ps2Ctrl & PS2CTRL_ALTGR) == 0)) ||
+                ((scanCode & PS2_SHIFT)    && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                ((scanCode & PS2_CTRL)     && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                ((scanCode & PS2_ALT)      && (kme.ps2Ctrl & PS2CTRL_ALT)   != 0) ||
+                ((scanCode & PS2_ALT_GR)   && (kme.ps2Ctrl & PS2CTRL_ALTGR) != 0) ||
+                ((scanCode & PS2_GUI)      && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) ||
+                ((scanCode & PS2_FUNCTION) && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+            {
+                matchExact = (((scanCode & PS2_SHIFT)    && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0    && (kme.ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                             (((scanCode & PS2_CTRL)     && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0     && (kme.ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                             (((scanCode & PS2_ALT)      && (kme.ps2Ctrl & PS2CTRL_ALT)   != 0) || ((scanCode & PS2_ALT) == 0      && (kme.ps2Ctrl & PS2CTRL_ALT)   == 0)) &&
+                             (((scanCode & PS2_ALT_GR)   && (kme.ps2Ctrl & PS2CTRL_ALTGR) != 0) || ((scanCode & PS2_ALT_GR) == 0   && (kme.ps2Ctrl & PS2CTRL_ALTGR) == 0)) &&
+                             (((scanCode & PS2_GUI)      && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0      && (kme.ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                             (((scanCode & PS2_FUNCTION) && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0 && (kme.ps2Ctrl & PS2CTRL_FUNC)  == 0));
+                if(matchExact == false && (kme.ps2Ctrl & PS2CTRL_EXACT) != 0)
+                    continue;
+
+                // mapKey only stops on a row which changes the matrix.
+                hasMake = false;
+                for(int mkIdx=0; mkIdx < PS2TBL_MZ_MAX_MKROW; mkIdx++) { if(kme.mkRow[mkIdx] != 0xFF) hasMake = true; }
+                if(hasMake == false)
+                    continue;
+
+                if(row != -1)
+                    return(-1);
+                row = idx;
+                if(matchExact)
+                    break;
+            }
+        }
+    }
+    return(row);
+}
+
+// Method to give the PS/2 key which types a character on the MZ. The host reads a key matrix so the active keymap is searched in reverse
+// for a row pressing one character key, shifted if the row presses SHIFT itself or leaves the PS/2 shift in place. The key is then mapped
+// forward as mapKey would and only accepted if that row alone is applied. Control characters use the PC layout.
+//
+bool MZ2528::macroKey(char chr, uint16_t &keyCode)
+{
+    // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap;
+    uint16_t  events[KEYMACRO_MAX_EVENTS];
+    uint16_t  scanCode;
+    int       eventCnt;
+    int       keyIdx;
+    int       keyCnt;
+    bool      mkShift;
+    bool      brkShift;
+    bool      hostShift;
+    char      hostChr;
+    bool      result = false;
+
+    if((uint8_t)chr < 0x20)
+        return(KeyInterface::macroKey(chr, keyCode));
+
+    keyMapReadBegin();
+    keyMap = mzControl.keyMap;
+    for(int idx=0; idx < keyMap->rows && result == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if((kme.ps2Ctrl & (PS2CTRL_CTRL | PS2CTRL_ALT | PS2CTRL_ALTGR | PS2CTRL_GUI)) != 0)
+            continue;
+
+        // The character key pressed by the row and whether the row presses or releases SHIFT.
+        keyIdx = -1; keyCnt = 0; mkShift = false; brkShift = false;
+        for(int mkIdx=0; mkIdx < PS2TBL_MZ_MAX_MKROW; mkIdx++)
+        {
+            if(kme.mkRow[mkIdx] == 0x0B && kme.mkKey[mkIdx] == 0x04)
+                mkShift = true;
+            else if(kme.mkRow[mkIdx] != 0xFF)
+            {
+                keyIdx = mkIdx;
+                keyCnt++;
+            }
+        }
+        for(int brkIdx=0; brkIdx < PS2TBL_MZ_MAX_BRKROW; brkIdx++)
+        {
+            if(kme.brkRow[brkIdx] == 0x0B && kme.brkKey[brkIdx] == 0x04)
+                brkShift = true;
+        }
+        if(keyCnt != 1 || kme.mkRow[keyIdx] < 0x03 || kme.mkRow[keyIdx] > 0x0A || __builtin_popcount(kme.mkKey[keyIdx]) != 1)
+            continue;
+
+        for(int shift=0; shift < 2 && result == false; shift++)
+        {
+            if(shift == 0 && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0)
+                continue;
+
+            hostShift = mkShift || (shift == 1 && brkShift == false);
+            if(kme.mkRow[keyIdx] == 0x07 && (mzConfig.params.activeMachineModel & (MZ_80B | MZ_2000)) != 0)
+                hostChr = mz80bLegendRow7[__builtin_ctz(kme.mkKey[keyIdx])][hostShift ? 1 : 0];
+            else
+                hostChr = mzLegend[kme.mkRow[keyIdx] - 0x03][__builtin_ctz(kme.mkKey[keyIdx])][hostShift ? 1 : 0];
+            if(hostChr == chr)
+            {
+                // Key make as the macro delivers it, the Function flag follows the key.
+                keyCode  = kme.ps2KeyCode | (shift == 1 ? PS2_SHIFT : 0);
+                eventCnt = KeyMacro::strokeEvents(keyCode, events);
+                scanCode = events[(eventCnt / 2) - 1];
+                result   = (macroMapRow(keyMap, scanCode) == idx);
+            }
+        }
+    }
+    keyMapReadEnd();
+
+    return(result);
+}
+
+// Method to test if the host has taken the last macro key, ie. it has been held in the matrix for enough host scans and time. A key still
+// short of its scans once MZ2528IF_MACRO_LATE_MS has passed finds the host busy, that is reported once as a reject so playback slows.
+//
+bool MZ2528::macroHostIdle(void)
+{
+    // Locals.
+    //
+    uint32_t            scans  = mzControl.scanCount - mzControl.scanMark;
+    uint32_t            heldMs = (uint32_t)(xTaskGetTickCount() - mzControl.scanMarkTick) * portTICK_PERIOD_MS;
+
+    if(scans < MZ2528IF_MACRO_SCANS && heldMs >= MZ2528IF_MACRO_LATE_MS && mzControl.scanLate == false)
+    {
+        mzControl.scanLate = true;
+        macroHostReject();
+    }
+    return(scans >= MZ2528IF_MACRO_SCANS && heldMs >= MZ2528IF_MACRO_HOLD_MS);
+}
+
+// Method to note the scan count as a macro key enters the matrix.
+//
+void MZ2528::macroHostMark(void)
+{
+    mzControl.scanMark     = mzControl.scanCount;
+    mzControl.scanMarkTick = xTaskGetTickCount();
+    mzControl.scanLate     = false;
+}
+
+// Method to record the latency of the last key mapped once a host scan has seen it. The matrix has no queue, output is the time from the key
+// entering the matrix to the first host scan and total from the device event. Called by the HID thread.
+//
+void MZ2528::keyLatency(void)
+{
+    // Locals.
+    uint32_t    visibleTime = mzControl.keyVisibleTime;
+
+    if(mzControl.keyPending == false && visibleTime != 0)
+    {
+        Metrics::record(Metrics::HIST_OUTPUT, visibleTime - mzControl.keyMappedTime);
+        if(mzControl.keyEventTime != 0) Metrics::record(Metrics::HIST_TOTAL, visibleTime - mzControl.keyEventTime);
+        mzControl.keyVisibleTime = 0;
+    }
+}
+
 // Primary HID thread, running on Core 0.
 // This thread is responsible for receiving PS/2 or BT scan codes and mapping them to an MZ-2500/2800 keyboard matrix.
 //
@@ -655,6 +890,9 @@ IRAM_ATTR void MZ2528::hidInterface( void * pvParameters )
     // Map the instantiating object so we can access its methods and data.
     MZ2528* pThis = (MZ2528*)pvParameters;
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HIDIF);
+
     // Thread never exits, just polls the keyboard and updates the matrix.
     while(1)
     { 
@@ -665,7 +903,7 @@ IRAM_ATTR void MZ2528::hidInterface( void * pvParameters )
         }
 
         // Check for PS/2 keyboard scan codes.
-        while((scanCode = pThis->hid->read()) != 0)
+        while((scanCode = pThis->readKey()) != 0)
         {
             // Scan Code Breakdown:
             // Define name bit     description
@@ -691,16 +929,28 @@ IRAM_ATTR void MZ2528::hidInterface( void * pvParameters )
             ESP_LOGW(MAPKEYTAG, "SCANCODE:%04x",scanCode);
 
             // Update the virtual matrix with the new key value.
+            pThis->keyMapReadBegin();
             pThis->mapKey(scanCode);
+            pThis->keyMapReadEnd();
+
+            // Time the key to the host scan which sees it, a key superseded before a scan is not timed.
+            pThis->mzControl.keyEventTime   = pThis->takeKeyEventTime();
+            pThis->mzControl.keyMappedTime  = Metrics::now();
+            pThis->mzControl.keyVisibleTime = 0;
+            pThis->mzControl.keyPending     = true;
 
             // Toggle LED to indicate data flow.
             if((scanCode & PS2_BREAK) == 0)
                 pThis->led->setLEDMode(LED::LED_MODE_BLINK_ONESHOT, LED::LED_DUTY_CYCLE_10, 1, 100L, 0L);
         }
 
+        // Record the latency of a key the host has scanned.
+        pThis->keyLatency();
+
         // If all keys have been releaased or a suspend is requested, set the yieldInterface flag. This flag is intentional due to time
         // being critical in the host interface thread. then after a short count, 
-        if(pThis->mzControl.noKeyPressed == true || pThis->suspendRequested())
+        // The host interface keeps running between keys of a macro as the scans it counts pace the playback.
+        if((pThis->mzControl.noKeyPressed == true && pThis->macroActive() == false) || pThis->suspendRequested())
         {
             vTaskDelay(10);
             pThis->yieldHostInterface = true;
@@ -729,95 +979,28 @@ IRAM_ATTR void MZ2528::hidInterface( void * pvParameters )
         }
        
         // Yield if the suspend flag is set.
-        pThis->yield(10);
+        pThis->yield(pThis->macroPollDelay(10));
    }
 }
 
-// A method to load the keyboard mapping table into memory for use in the interface mapping logic. If no persistence file exists or an error reading persistence occurs, the keymap 
-// uses the internal static default. If no persistence file exists and attempt is made to create it with a copy of the inbuilt static map so that future operations all
-// work with persistence such that modifications can be made.
+// A method to load the keyboard mapping table for use in the interface mapping logic. The inbuilt keymap is used in place from flash and any user changes
+// held in the keymap file are merged with it. A complete keymap file, ie. a browser upload or one saved by earlier firmware, is reduced to the rows which
+// differ from the inbuilt keymap and saved back. The new table is published as a whole, so a reload can take place whilst the HID thread is mapping keys.
 //
 bool MZ2528::loadKeyMap(void)
 {
     // Locals.
     //
-    bool        result = false;
-    int         fileRows = 0;
-    struct stat keyMapFileNameStat;
+    enum KeyMapOverlay::OVERLAY_LOAD result;
 
-    // See if the file exists, if it does, get size so we can compute number of mapping rows.
-    if(stat(mzControl.keyMapFileName.c_str(), &keyMapFileNameStat) == -1)
+    result = buildKeyMap(mzControl.keyMap, mzControl.keyMapFileName, PS2toMZ.kme, PS2TBL_MZ_MAXROWS);
+    if(result == KeyMapOverlay::OVERLAY_LOAD_COMPLETE)
     {
-        ESP_LOGW(MAINTAG, "No keymap file, using inbuilt definitions.");
-    } else
-    {
-        // Get number of rows in the file.
-        fileRows = keyMapFileNameStat.st_size/sizeof(t_keyMapEntry);
-
-        // Subsequent reloads, delete memory prior to building new map, primarily to conserve precious resources rather than trying the memory allocation trying to realloc and then having to copy.
-        if(mzControl.kme != NULL && mzControl.kme != PS2toMZ.kme)
-        {
-            delete mzControl.kme;
-            mzControl.kme = NULL;
-        }
-
-        // Allocate memory for the new keymap table.
-        mzControl.kme = new t_keyMapEntry[fileRows];
-        if(mzControl.kme == NULL)
-        {
-            ESP_LOGW(MAINTAG, "Failed to allocate memory for keyboard map, fallback to inbuilt!");
-        } else
-        {
-            // Open the keymap extension file for binary reading to add data to our map table.
-            std::fstream keyFileIn(mzControl.keyMapFileName.c_str(), std::ios::in | std::ios::binary);
-
-            int idx=0;
-            while(keyFileIn.good())
-            {
-                keyFileIn.read((char *)&mzControl.kme[idx], sizeof(t_keyMapEntry));
-                if(keyFileIn.good())
-                {
-                    idx++;
-                }
-            }
-            // Any errors, we wind back and use the inbuilt mapping table.
-            if(keyFileIn.bad())
-            {
-                keyFileIn.close();
-                ESP_LOGW(MAINTAG, "Failed to read data from keymap extension file:%s, fallback to inbuilt!", mzControl.keyMapFileName.c_str());
-            } else
-            {
-                // No longer need the file.
-                keyFileIn.close();
-               
-                // Max rows in the KME table.
-                mzControl.kmeRows = fileRows;
-
-                // Good to go, map ready for use with the interface.
-                result = true;
-            }
-        }
-    }
-
-    // Any failures, free up memory and use the inbuilt mapping table.
-    if(result == false)
-    {
-        if(mzControl.kme != NULL && mzControl.kme != PS2toMZ.kme)
-        {
-            delete mzControl.kme;
-            mzControl.kme = NULL;
-        }
-     
-        // No point allocating memory if no extensions exist or an error occurs, just point to the static table.
-        mzControl.kme = PS2toMZ.kme;
-        mzControl.kmeRows = PS2TBL_MZ_MAXROWS;
-     
-        // Persist the data so that next load comes from file.
         saveKeyMap();
     }
 
-    // Return code. Either memory map was successfully loaded, true or failed, false.
-    return(result);
+    // Return code. True if user changes were loaded from the keymap file, false if the inbuilt keymap is used as is.
+    return(result != KeyMapOverlay::OVERLAY_LOAD_INBUILT);
 }
 
 // Method to save the current keymap out to an extension file.
@@ -826,12 +1009,12 @@ bool MZ2528::saveKeyMap(void)
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = mzControl.keyMap;
     bool        result = false;
-    int         idx = 0;
 
-    // Has a map been defined? Cannot save unless loadKeyMap has been called which sets mzControl.kme to point to the internal keymap or a new memory resident map.
+    // Has a map been defined? Cannot save unless loadKeyMap has been called which publishes the internal keymap or a new memory resident map.
     //
-    if(mzControl.kme == NULL)
+    if(keyMap == NULL)
     {
         ESP_LOGW(MAINTAG, "KeyMap hasnt yet been defined, need to call loadKeyMap.");
     } else
@@ -839,26 +1022,8 @@ bool MZ2528::saveKeyMap(void)
         // Request mutex from NVS to prevent it from accessing the NVS - LittleFS is based on NVS.
         if(nvs->takeMutex() == true)
         {
-            // Open file for binary writing, trunc specified to clear out the file, we arent appending.
-            std::fstream keyFileOut(mzControl.keyMapFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-
-            // Loop whilst no errors and data rows still not written.
-            while(keyFileOut.good() && idx < mzControl.kmeRows)
-            {
-                keyFileOut.write((char *)&mzControl.kme[idx], sizeof(t_keyMapEntry));
-                idx++;
-            }
-            if(keyFileOut.bad())
-            {
-                ESP_LOGW(MAINTAG, "Failed to write data from the keymap to file:%s, deleting as state is unknown!", mzControl.keyMapFileName.c_str());
-                keyFileOut.close();
-                std::remove(mzControl.keyMapFileName.c_str());
-            } else
-            {
-                // Success.
-                keyFileOut.close();
-                result = true;
-            }
+            // Write out the rows which differ from the inbuilt keymap.
+            result = saveKeyMapOverlay(keyMap, mzControl.keyMapFileName);
 
             // Relinquish mutex now write is complete.
             nvs->giveMutex();
@@ -969,6 +1134,10 @@ bool MZ2528::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
             if(std::rename(fileName.c_str(), mzControl.keyMapFileName.c_str()) != 0)
             {
                 result = false;
+            } else
+            {
+                // Apply the new keymap immediately, a key being mapped finishes on the old map.
+                loadKeyMap();
             }
         } else
         {
@@ -980,6 +1149,25 @@ bool MZ2528::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
     return(result);
 }
 
+// Method to apply row edits from the web editor to the active keymap. The edited keymap is saved as an overlay and reloaded.
+// Returns the rows in the new keymap, -1 if an edit was invalid or the save failed.
+//
+int MZ2528::editKeyMap(const std::vector<t_keyMapEdit> &edits)
+{
+    // Locals.
+    //
+    int            result = -1;
+
+    if(editKeyMapRows(mzControl.keyMap.load(), mzControl.keyMapFileName, edits) == true)
+    {
+        loadKeyMap();
+        result = mzControl.keyMap.load()->rows;
+    }
+
+    // Send result.
+    return(result);
+}
+
 // Method to return the keymap column names as header strings.
 //
 void MZ2528::getKeyMapHeaders(std::vector<std::string>& headerList)
@@ -1096,6 +1284,7 @@ bool MZ2528::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool star
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = mzControl.keyMap;
     bool      result = false;
 
     // If start flag is set, set row to 0.
@@ -1105,24 +1294,24 @@ bool MZ2528::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool star
     }
 
     // Bound check and if still valid, push data onto the vector.
-    if((*row) >= mzControl.kmeRows)
+    if((*row) >= keyMap->rows)
     {
         result = true;
     } else
     {
-        dataArray.push_back(mzControl.kme[*row].ps2KeyCode);
-        dataArray.push_back(mzControl.kme[*row].ps2Ctrl);
-        dataArray.push_back(mzControl.kme[*row].keyboardModel);
-        dataArray.push_back(mzControl.kme[*row].machine);
+        dataArray.push_back(keyMap->row(*row).ps2KeyCode);
+        dataArray.push_back(keyMap->row(*row).ps2Ctrl);
+        dataArray.push_back(keyMap->row(*row).keyboardModel);
+        dataArray.push_back(keyMap->row(*row).machine);
         for(int idx=0; idx < PS2TBL_MZ_MAX_MKROW; idx++)
         {
-            dataArray.push_back(mzControl.kme[*row].mkRow[idx]);
-            dataArray.push_back(mzControl.kme[*row].mkKey[idx]);
+            dataArray.push_back(keyMap->row(*row).mkRow[idx]);
+            dataArray.push_back(keyMap->row(*row).mkKey[idx]);
         }
         for(int idx=0; idx < PS2TBL_MZ_MAX_BRKROW; idx++)
         {
-            dataArray.push_back(mzControl.kme[*row].brkRow[idx]);
-            dataArray.push_back(mzControl.kme[*row].brkKey[idx]);
+            dataArray.push_back(keyMap->row(*row).brkRow[idx]);
+            dataArray.push_back(keyMap->row(*row).brkKey[idx]);
         }
         (*row) = (*row) + 1;
     }
@@ -1158,13 +1347,13 @@ void MZ2528::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
         ESP_LOGW(MAINTAG, "Starting mz28if thread...");
         ::xTaskCreatePinnedToCore(&this->mz28Interface, "mz28if", 2048, this, (configMAX_PRIORITIES - 1), &this->TaskHostIF, 1);
     }
-    vTaskDelay(1500);
+    waitReady(KEYIF_READY_HOSTIF);
 
     // Core 0 - Application
     // HID Interface handler thread.
     ESP_LOGW(MAINTAG, "Starting hidInterface thread...");
     ::xTaskCreatePinnedToCore(&this->hidInterface, "hidIf", 4096, this, 0, &this->TaskHIDIF, 0);
-    vTaskDelay(1500);
+    waitReady(KEYIF_READY_HIDIF);
 }
 
 // Initialisation routine without hardware.
@@ -1178,10 +1367,17 @@ void MZ2528::init(NVS *hdlNVS, HID *hdlHID)
     mzControl.mode2500           = true;
     mzControl.optionSelect       = false;
     mzControl.keyMapFileName     = mzControl.fsPath.append("/").append(MZ2528IF_KEYMAP_FILE);
-    mzControl.kmeRows            = 0;
-    mzControl.kme                = NULL;
+    mzControl.keyMap             = NULL;
     mzControl.noKeyPressed       = true;
     mzControl.persistConfig      = false;
+    mzControl.scanCount          = 0;
+    mzControl.scanMark           = 0;
+    mzControl.scanMarkTick       = 0;
+    mzControl.scanLate           = false;
+    mzControl.keyPending         = false;
+    mzControl.keyVisibleTime     = 0;
+    mzControl.keyEventTime       = 0;
+    mzControl.keyMappedTime      = 0;
     yieldHostInterface           = true;
   
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
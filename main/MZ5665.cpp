@@ -22,6 +22,22 @@
 // History:         Apr 2022 - Initial framework, waiting on arrival of real machine to progress further.
 //            v1.01 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
+//            v1.02 Oct 2026 - Host interface implemented, frames serialised by the RMT peripheral with
+//                             RTSN handshake. Key make/break and control key state now mapped.
+//            v1.03 Oct 2026 - Keystroke macros, played with CTRL+SHIFT+ESC then F1..F4 and paced by frame
+//                             completion, a key the host was not ready for slows playback. Characters are
+//                             reverse mapped through the active keymap.
+//            v1.04 Oct 2026 - Keymap row edits from the web editor applied without a full table upload.
+//            v1.05 Oct 2026 - Transmit queue depth and overflows reported to the runtime metrics.
+//            v1.06 Oct 2026 - Queue wait and frame transmit latency recorded per key in the runtime metrics.
+//            v1.07 Oct 2026 - Transmit engine only built with CONFIG_MZ5665_HOST_ENGINE as the frame timing is
+//                             unverified. The wait for RTSN blocks on its falling edge rather than polling.
+//            v1.08 Oct 2026 - Macro characters the keymap does not produce are skipped rather than typed with the PC layout.
+//                             The RTSN timeout is reported as a reject so macro pacing adapts to the host.
+//            v1.09 Oct 2026 - Transmit engine scoped as experimental, the frame format is a placeholder which was not
+//                             derived from the MZ-5600/MZ-6500. Host tests build it separately from the default engine.
+//            v1.10 Oct 2026 - Placeholder transmit engine removed, keys are discarded until the protocol has been captured
+//                             from a real machine.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -64,6 +80,9 @@
 #include "sdkconfig.h"
 #include "MZ5665.h"
 
+// Inbuilt keymap, constant so it is held in flash rather than copied into each instance.
+constexpr MZ5665::t_keyMap MZ5665::PS2toMZ5665;
+
 // Tag for ESP main application logging.
 #define                         MAINTAG  "mz5665key"
 
@@ -72,6 +91,8 @@ static QueueHandle_t            xmitQueue;
 
 // MZ-5600/MZ-6500 Protocol
 // ------------------------
+// The keyboard is connected by a 4 wire cable, +5V, GND, DATA (KDO0) and RTSN (RTSNi). The frame format and timing are not
+// known and have to be captured from a real machine before keys can be transmitted, until then keys are discarded.
 //
 
 
@@ -84,37 +105,28 @@ void MZ5665::pushKeyToQueue(uint32_t key)
     #define             PUSHKEYTAG "pushKeyToQueue"
 
     xmitMsg.keyCode = key;
+    xmitMsg.eventTime = takeKeyEventTime();
+    xmitMsg.queueTime = Metrics::now();
     if( xQueueSend(xmitQueue, (void *)&xmitMsg, 10) != pdPASS)
     {
         ESP_LOGW(PUSHKEYTAG, "Failed to put scancode:%04x into xmitQueue", key);
+        Metrics::count(Metrics::COUNTER_XMIT_QUEUE_FULL);
+    } else
+    {
+        macroFrameQueued();
     }
     return;
 }
 
 // Method to realise the MZ-5600/MZ-6500 4 wire serial protocol in order to transmit key presses to the
 // MZ-5600/MZ-6500.
-// This method uses Core 1 and it will hold it in a spinlock as necessary to ensure accurate timing.
+// The protocol has not yet been captured from a real machine, so keys are taken from the queue and discarded, this keeps
+// the queue and macro playback flowing.
 // A key is passed into the method via the FreeRTOS Queue handle xmitQueue.
 IRAM_ATTR void MZ5665::mzInterface( void * pvParameters )
 {
     // Locals.
-    //t_xmitQueueMessage  rcvMsg;
-
-    // Mask values declared as variables, let the optimiser decide wether they are constants or placed in-memory.
-//    uint32_t            X1DATA_MASK  = (1 << CONFIG_HOST_KDO0);
-    //uint64_t            delayTimer = 0LL;
-    //uint64_t            curTime    = 0LL;
-    //bool                bitStart = true;
-    //uint32_t            bitCount = 0;
-    //enum XMITSTATE {
-    //                    FSM_IDLE        = 0,
-    //                    FSM_STARTXMIT   = 1,
-    //                    FSM_HEADER      = 2,
-    //                    FSM_START       = 3,
-    //                    FSM_DATA        = 4,
-    //                    FSM_STOP        = 5,
-    //                    FSM_ENDXMIT     = 6
-    //}                   state = FSM_IDLE;
+    t_xmitQueueMessage  rcvMsg;
 
     // Retrieve pointer to object in order to access data.
     MZ5665* pThis = (MZ5665*)pvParameters;
@@ -122,181 +134,31 @@ IRAM_ATTR void MZ5665::mzInterface( void * pvParameters )
     // Initialise the MUTEX which prevents this core from being released to other tasks.
     pThis->mzMutex = portMUX_INITIALIZER_UNLOCKED;
 
-    // Initial delay needed because the xQueue will assert probably on a suspended task ALL if delay not inserted!
-    vTaskDelay(1000);
-
     // Sign on.
-    ESP_LOGW(MAINTAG, "Starting MZ-6500 thread.");
+    ESP_LOGW(MAINTAG, "Starting MZ-6500 thread, host protocol not implemented, keys are discarded.");
 
-//    // X1 data out default state is high.
-//    GPIO.out_w1ts = X1DATA_MASK;
-//
-//    // Configure a timer to be used for X1 protocol spacing with 1uS resolution. The default clock source is the APB running at 80MHz.
-//    timer_config_t timerConfig = {
-//        .alarm_en    = TIMER_ALARM_DIS,            // No alarm, were not using interrupts as we are in a dedicated thread.
-//        .counter_en  = TIMER_PAUSE,                // Timer paused until required.
-//        .intr_type   = TIMER_INTR_LEVEL,           // No interrupts used.
-//        .counter_dir = TIMER_COUNT_UP,             // Timing a fixed period.
-//        .auto_reload = TIMER_AUTORELOAD_DIS,       // No need for auto reload, fixed time period.
-//        .divider     = 80                          // 1Mhz operation giving 1uS resolution.
-//    };
-//    ESP_ERROR_CHECK(timer_init(TIMER_GROUP_0, TIMER_0, &timerConfig));
-//    ESP_ERROR_CHECK(timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0));
-//
-//    // Permanent loop, wait for an incoming message on the key to send queue, read it then transmit to the X1, repeat!
-//    for(;;)
-//    {
-//        // Get the current timer value, only run the FSM when the timer is idle.
-//        timer_get_counter_value(TIMER_GROUP_0, TIMER_0, &curTime);
-//        if(curTime >= delayTimer)
-//        {
-//            // Ensure the timer is stopped.
-//            timer_pause(TIMER_GROUP_0, TIMER_0);
-//            delayTimer = 0LL;
-//
-//            // Finite state machine to retrieve a key for transmission then serialise it according to the X1 protocol.
-//            switch(state)
-//            {
-//                case FSM_IDLE:
-//                    // Yield if the suspend flag is set.
-//                    pThis->yield(0);
-//
-//                    // Check stack space, report if it is getting low.
-//                    if(uxTaskGetStackHighWaterMark(NULL) < 1024)
-//                    {
-//                        ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
-//                    }
-//
-//                    // If a new message arrives, start the serialiser to send it to the X1.
-//                    if(xQueueReceive(xmitQueue, (void *)&rcvMsg, 0) == pdTRUE)
-//                    {
-//                        ESP_LOGW(MAINTAG, "Received:%08x, %d", rcvMsg.keyCode, rcvMsg.modeB);
-//                        state = FSM_STARTXMIT; 
-//                   
-//                        // Create, initialise and hold a spinlock so the current core is bound to this one method.
-//                        portENTER_CRITICAL(&pThis->mzMutex);
-//                    }
-//                    break;
-//
-//                case FSM_STARTXMIT:
-//                    // Ensure all variables and states correct before entering serialisation.
-//                    bitStart = true;
-//                    GPIO.out_w1ts = X1DATA_MASK;
-//                    state = FSM_HEADER;
-//                    if(rcvMsg.modeB)
-//                        bitCount = 24;
-//                    else
-//                        bitCount = 16;
-//                    break;
-//
-//                case FSM_HEADER:
-//                    if(bitStart)
-//                    {
-//                        // Send out the header by bringing X1DATA low for 1000us then high for 700uS.
-//                        GPIO.out_w1tc = X1DATA_MASK;
-//                        delayTimer = pThis->mzCtrl.modeB ? 400LL : 1000LL;
-//                    } else
-//                    {
-//                        // Bring high for 700us.
-//                        GPIO.out_w1ts = X1DATA_MASK;
-//                        delayTimer = pThis->mzCtrl.modeB ? 200LL : 700LL;
-//                        state = FSM_DATA;  // Jump past the Start Bit, I think the header is the actual start bit as there is an error in the X1 Center specs.
-//                    }
-//                    bitStart = !bitStart;
-//                    break;
-//
-//                // The original X1 Center specification shows a start bit but this doesnt seem necessary, in fact it is interpreted as a data bit, hence the
-//                // FSM jumps this state.
-//                case FSM_START:
-//                    if(bitStart)
-//                    {
-//                        // Send out the start bit by bringing X1DATA low for 250us then high for 750uS.
-//                        GPIO.out_w1tc = X1DATA_MASK;
-//                        delayTimer = pThis->mzCtrl.modeB ? 250LL : 250LL;
-//                    } else
-//                    {
-//                        // Bring high for 750us.
-//                        GPIO.out_w1ts = X1DATA_MASK;
-//                        delayTimer = pThis->mzCtrl.modeB ? 250LL : 750LL;
-//                        state = FSM_DATA;
-//                    }
-//                    bitStart = !bitStart;
-//                    break;
-//
-//                case FSM_DATA:
-//                    if(bitCount > 0)
-//                    {
-//                        if(bitStart)
-//                        {
-//                            // Send out the data bit by bringing X1DATA low for 250us then high for 1750uS when bit = 1 else 750uS when bit = 0.
-//                            GPIO.out_w1tc = X1DATA_MASK;
-//                            delayTimer = 250LL;
-//                            delayTimer = pThis->mzCtrl.modeB ? 250LL : 250LL;
-//                        } else
-//                        {
-//                            // Bring X1DATA high...
-//                            GPIO.out_w1ts = X1DATA_MASK;
-//
-//                            // ... Mode A 1750us as bit = 1, mode B 750uS.
-//                            if((rcvMsg.modeB && rcvMsg.keyCode & 0x800000) || (!rcvMsg.modeB && rcvMsg.keyCode & 0x8000))
-//                            {
-//                                delayTimer = pThis->mzCtrl.modeB ? 750LL : 1750LL;
-//                            } else
-//                            // ... Mode A 750us as bit = 0, mode B 250uS.
-//                            {
-//                                delayTimer = pThis->mzCtrl.modeB ? 250LL : 750LL;
-//                            }
-//                            rcvMsg.keyCode = (rcvMsg.keyCode << 1);
-//                            bitCount--;
-//                        }
-//                        bitStart = !bitStart;
-//                    } else
-//                    {
-//                        state = FSM_STOP;
-//                    }
-//                    break;
-//
-//                case FSM_STOP:
-//                    if(bitStart)
-//                    {
-//                        // Send out the stop bit, same in Mode A and B, by bringing X1DATA low for 250us then high for 250uS.
-//                        GPIO.out_w1tc = X1DATA_MASK;
-//                        delayTimer = 250LL;
-//                        delayTimer = pThis->mzCtrl.modeB ? 250LL : 250LL;
-//                    } else
-//                    {
-//                        // Bring high for 250us.
-//                        GPIO.out_w1ts = X1DATA_MASK;
-//                        delayTimer = pThis->mzCtrl.modeB ? 250LL : 250LL;
-//                        state = FSM_ENDXMIT;
-//                    }
-//                    bitStart = !bitStart;
-//                    break;
-//
-//                case FSM_ENDXMIT:
-//                    // End of critical timing loop, release the core.
-//                    portEXIT_CRITICAL(&pThis->mzMutex);
-//                    state = FSM_IDLE;
-//                    break;
-//
-//            }
-//
-//            // If a new delay is requested, set the value into the timer and start.
-//            if(delayTimer > 0LL)
-//            {
-//                timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0LL);
-//                timer_start(TIMER_GROUP_0, TIMER_0);
-//            }
-//        }
-//
-//        // Logic to feed the watchdog if needed. Watchdog disabled in menuconfig but if enabled this will need to be used.
-//        //TIMERG0.wdt_wprotect=TIMG_WDT_WKEY_VALUE; // write enable
-//        //TIMERG0.wdt_feed=1;                       // feed dog
-//        //TIMERG0.wdt_wprotect=0;                   // write protect
-//        //TIMERG1.wdt_wprotect=TIMG_WDT_WKEY_VALUE; // write enable
-//        //TIMERG1.wdt_feed=1;                       // feed dog
-//        //TIMERG1.wdt_wprotect=0;                   // write protect
-//    }
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HOSTIF);
+
+    // Permanent loop, wait for an incoming message on the key to send queue and discard it, repeat!
+    for(;;)
+    {
+        // Check stack space, report if it is getting low.
+        if(uxTaskGetStackHighWaterMark(NULL) < 1024)
+        {
+            ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
+        }
+
+        // Block for a key, the timeout bounds the response to a suspend request.
+        if(xQueueReceive(xmitQueue, (void *)&rcvMsg, pdMS_TO_TICKS(10)) == pdTRUE)
+        {
+            Metrics::stage(Metrics::HIST_QUEUE, rcvMsg.queueTime);
+            pThis->macroFrameSent();
+        }
+
+        // Yield if the suspend flag is set.
+        pThis->yield(0);
+    }
 }
 
 // Method to select keyboard configuration options. When a key sequence is pressed, ie. SHIFT+CTRL+ESC then the fourth simultaneous key is the required option and given to this 
@@ -341,6 +203,15 @@ void MZ5665::selectOption(uint8_t optionCode)
             this->mzConfig.params.activeKeyboardMap = KEYMAP_STANDARD;
             break;
 
+        // Play a keystroke macro, F1..F4 select the macro file.
+        case PS2_KEY_F1:
+        case PS2_KEY_F2:
+        case PS2_KEY_F3:
+        case PS2_KEY_F4:
+            updated = false;
+            macroPlay(KeyMacro::fileName(this->mzCtrl.keyMapFileName, optionCode - PS2_KEY_F1 + 1));
+            break;
+
 //        // Select the model of the host to enable specific mappings.
 //        case PS2_KEY_END:
 //            this->mzConfig.params.activeMachineModel = X1_ORIG;
@@ -399,6 +270,7 @@ void MZ5665::selectOption(uint8_t optionCode)
 uint32_t MZ5665::mapKey(uint16_t scanCode)
 {
     // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap = mzCtrl.keyMap;
     uint32_t  idx;
     uint8_t   keyCode = (scanCode & 0xFF);
     bool      mapped = false;
@@ -411,8 +283,8 @@ uint32_t MZ5665::mapKey(uint16_t scanCode)
     //
     if(scanCode & PS2_BREAK)
     {
- //       if((keyCode == PS2_KEY_L_SHIFT || keyCode == PS2_KEY_R_SHIFT)  && (scanCode & PS2_SHIFT) == 0) { mapped=true; this->mzCtrl.keyCtrl |= X1_CTRL_SHIFT; }
- //       if((keyCode == PS2_KEY_L_CTRL  || keyCode == PS2_KEY_R_CTRL)   && (scanCode & PS2_CTRL) == 0)  { mapped=true; this->mzCtrl.keyCtrl |= X1_CTRL_CTRL; }
+        if((keyCode == PS2_KEY_L_SHIFT || keyCode == PS2_KEY_R_SHIFT)  && (scanCode & PS2_SHIFT) == 0) { mapped=true; this->mzCtrl.keyCtrl |= MZ5665_CTRL_SHIFT; }
+        if((keyCode == PS2_KEY_L_CTRL  || keyCode == PS2_KEY_R_CTRL)   && (scanCode & PS2_CTRL) == 0)  { mapped=true; this->mzCtrl.keyCtrl |= MZ5665_CTRL_CTRL; }
 
         // Any break key clears the option select flag.
         this->mzCtrl.optionSelect = false;
@@ -421,14 +293,12 @@ uint32_t MZ5665::mapKey(uint16_t scanCode)
         led->setLEDMode(LED::LED_MODE_OFF, LED::LED_DUTY_CYCLE_OFF, 0, 0L, 0L);
     } else
     {
- //       if((keyCode == PS2_KEY_L_SHIFT || keyCode == PS2_KEY_R_SHIFT)  && (scanCode & PS2_SHIFT)) { mapped=true; this->mzCtrl.keyCtrl &= ~X1_CTRL_SHIFT; }
- //       if((keyCode == PS2_KEY_L_CTRL  || keyCode == PS2_KEY_R_CTRL)   && (scanCode & PS2_CTRL))  { mapped=true; this->mzCtrl.keyCtrl &= ~X1_CTRL_CTRL; }
- //       if(keyCode == PS2_KEY_L_ALT)     { mapped = true; this->mzCtrl.keyCtrl ^= X1_CTRL_KANA; }
- //       if(keyCode == PS2_KEY_R_ALT)     { mapped = true; this->mzCtrl.keyCtrl ^= X1_CTRL_GRAPH; }
- //       if(keyCode == PS2_KEY_CAPS)      { mapped = true; this->mzCtrl.keyCtrl ^= X1_CTRL_CAPS; }
+        if((keyCode == PS2_KEY_L_SHIFT || keyCode == PS2_KEY_R_SHIFT)  && (scanCode & PS2_SHIFT)) { mapped=true; this->mzCtrl.keyCtrl &= ~MZ5665_CTRL_SHIFT; }
+        if((keyCode == PS2_KEY_L_CTRL  || keyCode == PS2_KEY_R_CTRL)   && (scanCode & PS2_CTRL))  { mapped=true; this->mzCtrl.keyCtrl &= ~MZ5665_CTRL_CTRL; }
+        if(keyCode == PS2_KEY_L_ALT)     { mapped = true; this->mzCtrl.keyCtrl ^= MZ5665_CTRL_KANA; }
+        if(keyCode == PS2_KEY_R_ALT)     { mapped = true; this->mzCtrl.keyCtrl ^= MZ5665_CTRL_GRAPH; }
+        if(keyCode == PS2_KEY_CAPS)      { mapped = true; this->mzCtrl.keyCtrl ^= MZ5665_CTRL_CAPS; }
         // Special mapping to allow selection of keyboard options. If the user presses CTRL+SHIFT+ESC then a flag becomes active and should a fourth key be pressed before a BREAK then the fourth key is taken as an option key and processed accordingly.
-        if(this->mzCtrl.optionSelect == true) { mapped = true; this->mzCtrl.optionSelect = false; selectOption(keyCode); }
-        if(keyCode == PS2_KEY_ESC && (scanCode & PS2_CTRL) && (scanCode & PS2_SHIFT)) { mapped = true; this->mzCtrl.optionSelect = true; }
         if(this->mzCtrl.optionSelect == true && keyCode != PS2_KEY_ESC)
         {
             mapped = true;
@@ -454,34 +324,34 @@ uint32_t MZ5665::mapKey(uint16_t scanCode)
         // Loop through the entire conversion table to find a match on this key, if found map to MZ5665 equivalent.
         // switch matrix.
         //
-        for(idx=0, mapped=false, matchExact=false; idx < mzCtrl.kmeRows && (mapped == false || (mapped == true && matchExact == false)); idx++)
+        for(idx=0, mapped=false, matchExact=false; idx < (uint32_t)keyMap->rows && (mapped == false || (mapped == true && matchExact == false)); idx++)
         {
             // Match key code? Make sure the current machine and keymap match as well.
-            if(mzCtrl.kme[idx].ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((mzCtrl.kme[idx].machine == MZ5665_ALL) || ((mzCtrl.kme[idx].machine & mzConfig.params.activeMachineModel) != 0)) && ((mzCtrl.kme[idx].keyboardModel & mzConfig.params.activeKeyboardMap) != 0))
+            if(keyMap->row(idx).ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((keyMap->row(idx).machine == MZ5665_ALL) || ((keyMap->row(idx).machine & mzConfig.params.activeMachineModel) != 0)) && ((keyMap->row(idx).keyboardModel & mzConfig.params.activeKeyboardMap) != 0))
             {
                 // If CAPS lock is set in the table and in the scanCode, invert SHIFT so we send the correct value.
-                if((scanCode & PS2_CAPS) && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_CAPS) != 0)
+                if((scanCode & PS2_CAPS) && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS) != 0)
                 {
                     scanCode ^= PS2_SHIFT;
                 }
 
                 // Match Raw, Shift, Function, Control, ALT or ALT-Gr?
-                if( (((mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL) == 0) && ((mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)  == 0) && ((mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0) && ((mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
-                    ((scanCode & PS2_SHIFT)                         && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
-                    ((scanCode & PS2_CTRL)                          && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
-              //      ((this->mzCtrl.keyCtrl & X1_CTRL_KANA) == 0  && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)  != 0) ||
-              //      ((this->mzCtrl.keyCtrl & X1_CTRL_GRAPH) == 0 && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) != 0) ||
-                    ((scanCode & PS2_GUI)                           && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || 
-                    ((scanCode & PS2_FUNCTION)                      && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+                if( (((keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
+                    ((scanCode & PS2_SHIFT)                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                    ((scanCode & PS2_CTRL)                          && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                    ((this->mzCtrl.keyCtrl & MZ5665_CTRL_KANA) == 0  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  != 0) ||
+                    ((this->mzCtrl.keyCtrl & MZ5665_CTRL_GRAPH) == 0 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) != 0) ||
+                    ((scanCode & PS2_GUI)                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || 
+                    ((scanCode & PS2_FUNCTION)                      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) )
                 {
                     
                     // Exact entry match, data + control key? On an exact match we only process the first key. On a data only match we fall through to include additional data and control key matches to allow for un-mapped key combinations, ie. Japanese characters.
-                    matchExact = (((scanCode & PS2_SHIFT)                         && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0               && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
-                                 (((scanCode & PS2_CTRL)                          && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
-                       //          (((this->mzCtrl.keyCtrl & X1_CTRL_KANA) == 0  && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)  != 0) || ((this->mzCtrl.keyCtrl & X1_CTRL_KANA)  && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)  == 0)) &&
-                       //          (((this->mzCtrl.keyCtrl & X1_CTRL_GRAPH) == 0 && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) != 0) || ((this->mzCtrl.keyCtrl & X1_CTRL_GRAPH) && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) == 0)) &&
-                                 (((scanCode & PS2_GUI)                           && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                 && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
-                                 (((scanCode & PS2_FUNCTION)                      && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0            && (mzCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0))
+                    matchExact = (((scanCode & PS2_SHIFT)                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0               && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                                 (((scanCode & PS2_CTRL)                          && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                                 (((this->mzCtrl.keyCtrl & MZ5665_CTRL_KANA) == 0  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  != 0) || ((this->mzCtrl.keyCtrl & MZ5665_CTRL_KANA)  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  == 0)) &&
+                                 (((this->mzCtrl.keyCtrl & MZ5665_CTRL_GRAPH) == 0 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) != 0) || ((this->mzCtrl.keyCtrl & MZ5665_CTRL_GRAPH) && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) == 0)) &&
+                                 (((scanCode & PS2_GUI)                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                                 (((scanCode & PS2_FUNCTION)                      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0            && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0))
                                ? true : false;
     
                     // RELEASE (PS2_BREAK == 1) or PRESS?
@@ -496,26 +366,14 @@ uint32_t MZ5665::mapKey(uint16_t scanCode)
                             vTaskDelay(100);
                         }
 
-                        // Mode A sends a release with 0x00.
-                //        if(this->mzCtrl.modeB == false)
-                //        {
-                //            mappedKey = (0xFF << 8) | 0x00;
-                //            mapped = true;
-                //          //  vTaskDelay(300);
-                //        } else
-                //        if(this->mzCtrl.modeB == true)
-                //        {
-                            // Clear only the bits relevant to the released key.
-               //             mappedKey &= ((mzCtrl.kme[idx].x1Ctrl << 16) | (mzCtrl.kme[idx].x1Key2 << 8) | mzCtrl.kme[idx].x1Key);
-                //        }
+                        // A release is queued as key 0x00 with the current control key state.
+                        mappedKey = (this->mzCtrl.keyCtrl << 8) | 0x00;
+                        mapped = true;
                     } else
                     {
-                        // Mode A return the key in the table, mode B OR the key to build up a final map.
-              //          if(this->mzCtrl.modeB == false)
-               //             mappedKey = ((mzCtrl.kme[idx].x1Ctrl & this->mzCtrl.keyCtrl) << 8) | mzCtrl.kme[idx].x1Key;
-               //         else
-               //             mappedKey |= ((mzCtrl.kme[idx].x1Ctrl << 16) | (mzCtrl.kme[idx].x1Key2 << 8) | mzCtrl.kme[idx].x1Key);
-               //         mapped = true;
+                        // Table control flags are positive logic, clear them in the active low control key state.
+                        mappedKey = ((this->mzCtrl.keyCtrl & ~keyMap->row(idx).mzCtrl & 0xFF) << 8) | keyMap->row(idx).mzKey;
+                        mapped = true;
                     }
                 }
             }
@@ -524,6 +382,85 @@ uint32_t MZ5665::mapKey(uint16_t scanCode)
     return(mappedKey);
 }
 
+// Method to give the keymap row a key make selects, -1 if none. Used by the live key monitor, no interface state is changed.
+//
+int MZ5665::lookupKey(uint16_t scanCode)
+{
+    return(macroMapRow(mzCtrl.keyMap, scanCode & ~PS2_BREAK));
+}
+
+// Method to return the keymap row mapKey selects for a key make, -1 if none. The selection mirrors mapKey, the first exact match or failing
+// that the last partial match, without updating any state.
+//
+int MZ5665::macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode)
+{
+    // Locals.
+    int       row = -1;
+    bool      matchExact = false;
+
+    for(int idx=0; idx < keyMap->rows && matchExact == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if(kme.ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((kme.machine == MZ5665_ALL) || ((kme.machine & mzConfig.params.activeMachineModel) != 0)) && ((kme.keyboardModel & mzConfig.params.activeKeyboardMap) != 0))
+        {
+            if( (((kme.ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((kme.ps2Ctrl & PS2CTRL_CTRL) == 0) && ((kme.ps2Ctrl & PS2CTRL_KANA)  == 0) && ((kme.ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((kme.ps2Ctrl & PS2CTRL_GUI)   == 0) && ((kme.ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
+                ((scanCode & PS2_SHIFT)                          && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                ((scanCode & PS2_CTRL)                           && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                ((this->mzCtrl.keyCtrl & MZ5665_CTRL_KANA) == 0  && (kme.ps2Ctrl & PS2CTRL_KANA)  != 0) ||
+                ((this->mzCtrl.keyCtrl & MZ5665_CTRL_GRAPH) == 0 && (kme.ps2Ctrl & PS2CTRL_GRAPH) != 0) ||
+                ((scanCode & PS2_GUI)                            && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) ||
+                ((scanCode & PS2_FUNCTION)                       && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+            {
+                row = idx;
+                matchExact = (((scanCode & PS2_SHIFT)                          && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0                && (kme.ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                             (((scanCode & PS2_CTRL)                           && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                 && (kme.ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                             (((this->mzCtrl.keyCtrl & MZ5665_CTRL_KANA) == 0  && (kme.ps2Ctrl & PS2CTRL_KANA)  != 0) || ((this->mzCtrl.keyCtrl & MZ5665_CTRL_KANA)  && (kme.ps2Ctrl & PS2CTRL_KANA)  == 0)) &&
+                             (((this->mzCtrl.keyCtrl & MZ5665_CTRL_GRAPH) == 0 && (kme.ps2Ctrl & PS2CTRL_GRAPH) != 0) || ((this->mzCtrl.keyCtrl & MZ5665_CTRL_GRAPH) && (kme.ps2Ctrl & PS2CTRL_GRAPH) == 0)) &&
+                             (((scanCode & PS2_GUI)                            && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                  && (kme.ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                             (((scanCode & PS2_FUNCTION)                       && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0             && (kme.ps2Ctrl & PS2CTRL_FUNC)  == 0));
+            }
+        }
+    }
+    return(row);
+}
+
+// Method to give the PS/2 key which types a character on the MZ-5600/MZ-6500. The host receives ASCII so the active keymap is searched in
+// reverse for a row producing the character with at most SHIFT, the key is then mapped forward as mapKey would and only accepted if it
+// selects the same row. Control characters use the PC layout.
+//
+bool MZ5665::macroKey(char chr, uint16_t &keyCode)
+{
+    // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap;
+    uint16_t  events[KEYMACRO_MAX_EVENTS];
+    uint16_t  scanCode;
+    int       eventCnt;
+    bool      result = false;
+
+    if((uint8_t)chr < 0x20)
+        return(KeyInterface::macroKey(chr, keyCode));
+
+    keyMapReadBegin();
+    keyMap = mzCtrl.keyMap;
+    for(int idx=0; idx < keyMap->rows && result == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if(kme.mzKey == (uint8_t)chr && (kme.ps2Ctrl & (PS2CTRL_CTRL | PS2CTRL_KANA | PS2CTRL_GRAPH | PS2CTRL_GUI | PS2CTRL_FUNC)) == 0)
+        {
+            // Key make as the macro delivers it, the Function flag follows the key.
+            keyCode  = kme.ps2KeyCode | ((kme.ps2Ctrl & PS2CTRL_SHIFT) ? PS2_SHIFT : 0);
+            eventCnt = KeyMacro::strokeEvents(keyCode, events);
+            scanCode = events[(eventCnt / 2) - 1];
+            result   = (macroMapRow(keyMap, scanCode) == idx);
+        }
+    }
+    keyMapReadEnd();
+
+    return(result);
+}
+
 // Primary HID thread, running on Core 0.
 // This thread is responsible for receiving HID (PS/2 or BT) keyboard scan codes and mapping them to Sharp MZ5665 equivalent keys, updating state flags as needed.
 // The HID data is received via interrupt. The data to be sent to the MZ5665 is pushed onto a FIFO queue.
@@ -537,6 +474,9 @@ IRAM_ATTR void MZ5665::hidInterface( void * pvParameters )
     // Map the instantiating object so we can access its methods and data.
     MZ5665* pThis = (MZ5665*)pvParameters;
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HIDIF);
+
     // Thread never exits, just polls the keyboard and updates the matrix.
     while(1)
     { 
@@ -547,7 +487,7 @@ IRAM_ATTR void MZ5665::hidInterface( void * pvParameters )
         }
 
         // Check for HID keyboard scan codes.
-        while((scanCode = pThis->hid->read()) != 0)
+        while((scanCode = pThis->readKey()) != 0)
         {
             // Scan Code Breakdown:
             // Define name bit     description
@@ -573,7 +513,9 @@ IRAM_ATTR void MZ5665::hidInterface( void * pvParameters )
             ESP_LOGW(MAPKEYTAG, "SCANCODE:%04x",scanCode);
 
             // Map the PS/2 key to an MZ5665 CTRL + KEY
+            pThis->keyMapReadBegin();
             mzKey = pThis->mapKey(scanCode);
+            pThis->keyMapReadEnd();
             if(mzKey != 0L) { pThis->pushKeyToQueue(mzKey); }
 
             // Toggle LED to indicate data flow.
@@ -582,95 +524,28 @@ IRAM_ATTR void MZ5665::hidInterface( void * pvParameters )
         }
 
         // Yield if the suspend flag is set.
-        pThis->yield(10);
+        pThis->yield(pThis->macroPollDelay(10));
     }
 }
 
-// A method to load the keyboard mapping table into memory for use in the interface mapping logic. If no persistence file exists or an error reading persistence occurs, the keymap 
-// uses the internal static default. If no persistence file exists and attempt is made to create it with a copy of the inbuilt static map so that future operations all
-// work with persistence such that modifications can be made.
+// A method to load the keyboard mapping table for use in the interface mapping logic. The inbuilt keymap is used in place from flash and any user changes
+// held in the keymap file are merged with it. A complete keymap file, ie. a browser upload or one saved by earlier firmware, is reduced to the rows which
+// differ from the inbuilt keymap and saved back. The new table is published as a whole, so a reload can take place whilst the HID thread is mapping keys.
 //
 bool MZ5665::loadKeyMap(void)
 {
     // Locals.
     //
-    bool        result = false;
-    int         fileRows = 0;
-    struct stat keyMapFileNameStat;
-
-    // See if the file exists, if it does, get size so we can compute number of mapping rows.
-    if(stat(mzCtrl.keyMapFileName.c_str(), &keyMapFileNameStat) == -1)
-    {
-        ESP_LOGW(MAINTAG, "No keymap file, using inbuilt definitions.");
-    } else
-    {
-        // Get number of rows in the file.
-        fileRows = keyMapFileNameStat.st_size/sizeof(t_keyMapEntry);
-
-        // Subsequent reloads, delete memory prior to building new map, primarily to conserve precious resources rather than trying the memory allocation trying to realloc and then having to copy.
-        if(mzCtrl.kme != NULL && mzCtrl.kme != PS2toMZ5665.kme)
-        {
-            delete mzCtrl.kme;
-            mzCtrl.kme = NULL;
-        }
-
-        // Allocate memory for the new keymap table.
-        mzCtrl.kme = new t_keyMapEntry[fileRows];
-        if(mzCtrl.kme == NULL)
-        {
-            ESP_LOGW(MAINTAG, "Failed to allocate memory for keyboard map, fallback to inbuilt!");
-        } else
-        {
-            // Open the keymap extension file for binary reading to add data to our map table.
-            std::fstream keyFileIn(mzCtrl.keyMapFileName.c_str(), std::ios::in | std::ios::binary);
-
-            int idx=0;
-            while(keyFileIn.good())
-            {
-                keyFileIn.read((char *)&mzCtrl.kme[idx], sizeof(t_keyMapEntry));
-                if(keyFileIn.good())
-                {
-                    idx++;
-                }
-            }
-            // Any errors, we wind back and use the inbuilt mapping table.
-            if(keyFileIn.bad())
-            {
-                keyFileIn.close();
-                ESP_LOGW(MAINTAG, "Failed to read data from keymap extension file:%s, fallback to inbuilt!", mzCtrl.keyMapFileName.c_str());
-            } else
-            {
-                // No longer need the file.
-                keyFileIn.close();
-               
-                // Max rows in the KME table.
-                mzCtrl.kmeRows = fileRows;
-
-                // Good to go, map ready for use with the interface.
-                result = true;
-            }
-        }
-    }
+    enum KeyMapOverlay::OVERLAY_LOAD result;
 
-    // Any failures, free up memory and use the inbuilt mapping table.
-    if(result == false)
+    result = buildKeyMap(mzCtrl.keyMap, mzCtrl.keyMapFileName, PS2toMZ5665.kme, PS2TBL_MZ5665_MAXROWS);
+    if(result == KeyMapOverlay::OVERLAY_LOAD_COMPLETE)
     {
-        if(mzCtrl.kme != NULL && mzCtrl.kme != PS2toMZ5665.kme)
-        {
-            delete mzCtrl.kme;
-            mzCtrl.kme = NULL;
-        }
-     
-        // No point allocating memory if no extensions exist or an error occurs, just point to the static table.
-        mzCtrl.kme = PS2toMZ5665.kme;
-        mzCtrl.kmeRows = PS2TBL_MZ5665_MAXROWS;
-
-        // Persist the data so that next load comes from file.
         saveKeyMap();
     }
 
-    // Return code. Either memory map was successfully loaded, true or failed, false.
-    return(result);
+    // Return code. True if user changes were loaded from the keymap file, false if the inbuilt keymap is used as is.
+    return(result != KeyMapOverlay::OVERLAY_LOAD_INBUILT);
 }
 
 // Method to save the current keymap out to an extension file.
@@ -679,36 +554,18 @@ bool MZ5665::saveKeyMap(void)
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = mzCtrl.keyMap;
     bool        result = false;
-    int         idx = 0;
 
-    // Has a map been defined? Cannot save unless loadKeyMap has been called which sets mzCtrl.kme to point to the internal keymap or a new memory resident map.
+    // Has a map been defined? Cannot save unless loadKeyMap has been called which publishes the internal keymap or a new memory resident map.
     //
-    if(mzCtrl.kme == NULL)
+    if(keyMap == NULL)
     {
         ESP_LOGW(MAINTAG, "KeyMap hasnt yet been defined, need to call loadKeyMap.");
     } else
     {
-        // Open file for binary writing, trunc specified to clear out the file, we arent appending.
-        std::fstream keyFileOut(mzCtrl.keyMapFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-
-        // Loop whilst no errors and data rows still not written.
-        while(keyFileOut.good() && idx < mzCtrl.kmeRows)
-        {
-            keyFileOut.write((char *)&mzCtrl.kme[idx], sizeof(t_keyMapEntry));
-            idx++;
-        }
-        if(keyFileOut.bad())
-        {
-            ESP_LOGW(MAINTAG, "Failed to write data from the keymap to file:%s, deleting as state is unknown!", mzCtrl.keyMapFileName.c_str());
-            keyFileOut.close();
-            std::remove(mzCtrl.keyMapFileName.c_str());
-        } else
-        {
-            // Success.
-            keyFileOut.close();
-            result = true;
-        }
+        // Write out the rows which differ from the inbuilt keymap.
+        result = saveKeyMapOverlay(keyMap, mzCtrl.keyMapFileName);
     }
    
     // Return code. Either memory map was successfully saved, true or failed, false.
@@ -815,6 +672,10 @@ bool MZ5665::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
             if(std::rename(fileName.c_str(), mzCtrl.keyMapFileName.c_str()) != 0)
             {
                 result = false;
+            } else
+            {
+                // Apply the new keymap immediately, a key being mapped finishes on the old map.
+                loadKeyMap();
             }
         } else
         {
@@ -826,6 +687,25 @@ bool MZ5665::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
     return(result);
 }
 
+// Method to apply row edits from the web editor to the active keymap. The edited keymap is saved as an overlay and reloaded.
+// Returns the rows in the new keymap, -1 if an edit was invalid or the save failed.
+//
+int MZ5665::editKeyMap(const std::vector<t_keyMapEdit> &edits)
+{
+    // Locals.
+    //
+    int            result = -1;
+
+    if(editKeyMapRows(mzCtrl.keyMap.load(), mzCtrl.keyMapFileName, edits) == true)
+    {
+        loadKeyMap();
+        result = mzCtrl.keyMap.load()->rows;
+    }
+
+    // Send result.
+    return(result);
+}
+
 // Method to return the keymap column names as header strings.
 //
 void MZ5665::getKeyMapHeaders(std::vector<std::string>& headerList)
@@ -925,6 +805,7 @@ bool MZ5665::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool star
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = mzCtrl.keyMap;
     bool      result = false;
 
     // If start flag is set, set row to 0.
@@ -934,19 +815,19 @@ bool MZ5665::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool star
     }
 
     // Bound check and if still valid, push data onto the vector.
-    if((*row) >= mzCtrl.kmeRows)
+    if((*row) >= keyMap->rows)
     {
         result = true;
     } else
     {
-        dataArray.push_back(mzCtrl.kme[*row].ps2KeyCode);
-        dataArray.push_back(mzCtrl.kme[*row].ps2Ctrl);
-        dataArray.push_back(mzCtrl.kme[*row].keyboardModel);
-        dataArray.push_back(mzCtrl.kme[*row].machine);
-   //     dataArray.push_back(mzCtrl.kme[*row].x1Mode);
-   //     dataArray.push_back(mzCtrl.kme[*row].x1Key);
-   //     dataArray.push_back(mzCtrl.kme[*row].x1Key2);
-   //     dataArray.push_back(mzCtrl.kme[*row].x1Ctrl);
+        dataArray.push_back(keyMap->row(*row).ps2KeyCode);
+        dataArray.push_back(keyMap->row(*row).ps2Ctrl);
+        dataArray.push_back(keyMap->row(*row).keyboardModel);
+        dataArray.push_back(keyMap->row(*row).machine);
+   //     dataArray.push_back(keyMap->row(*row).x1Mode);
+   //     dataArray.push_back(keyMap->row(*row).x1Key);
+   //     dataArray.push_back(keyMap->row(*row).x1Key2);
+   //     dataArray.push_back(keyMap->row(*row).x1Ctrl);
         (*row) = (*row) + 1;
     }
 
@@ -964,22 +845,24 @@ void MZ5665::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
     KeyInterface::init(getClassName(__PRETTY_FUNCTION__), hdlNVS, hdlLED, hdlHID, ifMode);
 
-    // Create a task pinned to core 1 which will fulfill the Sharp MZ-6500 interface. This task has the highest priority
-    // and it will also hold spinlock and manipulate the watchdog to ensure a scan cycle timing can be met. This means 
-    // all other tasks running on Core 1 will suspend as needed. The PS/2 controller will be serviced with core 0.
+    // Create queue for buffering incoming keys prior to transmitting to the MZ-6500, it must exist before either thread uses it.
+    xmitQueue = xQueueCreate(MAX_MZ5665_XMIT_KEY_BUF, sizeof(t_xmitQueueMessage));
+    Metrics::addQueue("xmitQueue", xmitQueue);
+
+    // Create a task pinned to core 1 which will fulfill the Sharp MZ-6500 interface. This task has the highest priority,
+    // until the protocol is implemented it only drains the queue so other tasks running on Core 1 are not held off. The PS/2
+    // controller will be serviced with core 0.
     //
     // Core 1 - MZ-6500 Interface
     ESP_LOGW(MAINTAG, "Starting mz5600/mz6500 if thread...");
     ::xTaskCreatePinnedToCore(&this->mzInterface, "mzif", 4096, this, 25, &this->TaskHostIF, 1);
-    vTaskDelay(500);
+    waitReady(KEYIF_READY_HOSTIF);
 
     // Core 0 - Application
     // HID Interface handler thread.
     ESP_LOGW(MAINTAG, "Starting hidIf thread...");
     ::xTaskCreatePinnedToCore(&this->hidInterface, "hidIf", 8192, this, 22, &this->TaskHIDIF, 0);
-
-    // Create queue for buffering incoming keys prior to transmitting to the MZ-6500.
-    xmitQueue = xQueueCreate(MAX_MZ5665_XMIT_KEY_BUF, sizeof(t_xmitQueueMessage));
+    waitReady(KEYIF_READY_HIDIF);
 }  
 
 // Initialisation routine without hardware.
@@ -989,8 +872,7 @@ void MZ5665::init(NVS *hdlNVS, HID *hdlHID)
     this->mzCtrl.keyCtrl      = 0xFF;     // Negative logic, 0 - active, 1 = inactive.
     mzCtrl.optionSelect       = false;
     mzCtrl.keyMapFileName     = mzCtrl.fsPath.append("/").append(MZ5665IF_KEYMAP_FILE);
-    mzCtrl.kmeRows            = 0;
-    mzCtrl.kme                = NULL;
+    mzCtrl.keyMap             = NULL;
 
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
     KeyInterface::init(getClassName(__PRETTY_FUNCTION__), hdlNVS, hdlHID);
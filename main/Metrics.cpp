@@ -0,0 +1,222 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            Metrics.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Runtime performance metrics. Counters and histograms are updated lock free by the
+//                  threads and ISR's which own the events. The main thread samples them, together with
+//                  the FreeRTOS task states, heap and registered queue depths, into RTC memory so the
+//                  last interface run can be viewed once the SharpKey has restarted into WiFi mode.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Per stage keystroke latency, input, keymap, queue, output and end to end.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include "Metrics.h"
+
+// Names of the counters and histograms as reported, in enum order.
+static const char *counterName[Metrics::COUNTER_MAX]    = { "xmitQueueFull", "rawKeyQueueFull", "keyQueueFull", "ps2Parity", "ps2Resend", "ps2Overrun", "uartRxOverflow" };
+static const char *histogramName[Metrics::HIST_MAX]     = { "input", "keymap", "queue", "output", "total" };
+
+// Live counters, histograms and registered queues.
+std::atomic<uint32_t>       Metrics::counters[COUNTER_MAX];
+std::atomic<uint32_t>       Metrics::histograms[HIST_MAX][METRICS_HIST_BUCKETS];
+Metrics::t_queue            Metrics::queues[METRICS_MAX_QUEUES];
+uint32_t                    Metrics::queueCount = 0;
+
+// Sample of the last interface run, not initialised so it persists across a software restart.
+RTC_NOINIT_ATTR Metrics::t_sample Metrics::lastRun;
+
+// Method to register a queue whose depth is sampled. Called once by the queue creator.
+//
+void Metrics::addQueue(const char *name, QueueHandle_t queue)
+{
+    if(queue != NULL && queueCount < METRICS_MAX_QUEUES)
+    {
+        queues[queueCount].name   = name;
+        queues[queueCount].handle = queue;
+        queues[queueCount].peak   = 0;
+        queueCount++;
+    }
+    return;
+}
+
+// Method to sample the system state, counters and histograms.
+//
+void Metrics::sample(t_sample &current)
+{
+    // Locals.
+  #if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    std::vector<TaskStatus_t> taskStatus(uxTaskGetNumberOfTasks() + 2);
+    uint32_t                  totalRunTime = 0;
+    UBaseType_t               tasks;
+  #endif
+    uint16_t                  depth;
+
+    current.magic        = METRICS_MAGIC;
+    current.uptimeMs     = (uint32_t)(esp_timer_get_time() / 1000);
+    current.heapFree     = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    current.heapMin      = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    current.heapLargest  = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    current.totalRunTime = 0;
+    current.taskCount    = 0;
+
+    // Task CPU time and stack space, the high water mark is the least free stack the task has had. The run time counter is the 32 bit
+    // microsecond ESP timer, it wraps after 71 minutes so CPU shares of a long run are approximate.
+  #if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    tasks = uxTaskGetSystemState(taskStatus.data(), taskStatus.size(), &totalRunTime);
+    current.totalRunTime = totalRunTime;
+    for(UBaseType_t idx=0; idx < tasks && current.taskCount < METRICS_MAX_TASKS; idx++)
+    {
+        strncpy(current.task[current.taskCount].name, taskStatus[idx].pcTaskName, METRICS_NAME_LEN - 1);
+        current.task[current.taskCount].name[METRICS_NAME_LEN - 1] = '\0';
+        current.task[current.taskCount].stackFree = taskStatus[idx].usStackHighWaterMark;
+        current.task[current.taskCount].runTime   = taskStatus[idx].ulRunTimeCounter;
+        current.taskCount++;
+    }
+  #endif
+
+    // Queue depths, the peak is only as good as the sample period.
+    current.queueCount = queueCount;
+    for(uint32_t idx=0; idx < queueCount; idx++)
+    {
+        depth = uxQueueMessagesWaiting(queues[idx].handle);
+        if(depth > queues[idx].peak) queues[idx].peak = depth;
+        strncpy(current.queue[idx].name, queues[idx].name, METRICS_NAME_LEN - 1);
+        current.queue[idx].name[METRICS_NAME_LEN - 1] = '\0';
+        current.queue[idx].depth = depth;
+        current.queue[idx].peak  = queues[idx].peak;
+        current.queue[idx].size  = depth + uxQueueSpacesAvailable(queues[idx].handle);
+    }
+
+    for(int idx=0; idx < COUNTER_MAX; idx++)
+    {
+        current.counter[idx] = counters[idx].load(std::memory_order_relaxed);
+    }
+    for(int idx=0; idx < HIST_MAX; idx++)
+    {
+        for(int bkt=0; bkt < METRICS_HIST_BUCKETS; bkt++)
+        {
+            current.histogram[idx][bkt] = histograms[idx][bkt].load(std::memory_order_relaxed);
+        }
+    }
+    return;
+}
+
+// Method to sample the running interface and retain the sample for the web interface. Called periodically by the main thread and before a
+// restart into WiFi mode.
+//
+void Metrics::commit(void)
+{
+    // Locals.
+    t_sample        current;
+
+    sample(current);
+
+    // Invalidate whilst the sample is copied so a restart mid way doesnt leave a torn sample marked valid.
+    lastRun.magic = 0;
+    memcpy(&lastRun.uptimeMs, &current.uptimeMs, sizeof(t_sample) - sizeof(uint32_t));
+    lastRun.magic = METRICS_MAGIC;
+    return;
+}
+
+// Method to format a sample as a JSON object.
+//
+std::string Metrics::sampleToJSON(t_sample &current)
+{
+    // Locals.
+    std::string     json;
+    char            cpu[16];
+    uint64_t        totalRunTime = (uint64_t)current.totalRunTime * portNUM_PROCESSORS;
+
+    json  = "{\"uptimeMs\":" + std::to_string(current.uptimeMs);
+    json += ",\"heap\":{\"free\":" + std::to_string(current.heapFree) + ",\"min\":" + std::to_string(current.heapMin) + ",\"largest\":" + std::to_string(current.heapLargest) + "}";
+
+    // CPU time is the share of the run time of all cores since start up.
+    json += ",\"tasks\":[";
+    for(uint32_t idx=0; idx < current.taskCount && idx < METRICS_MAX_TASKS; idx++)
+    {
+        current.task[idx].name[METRICS_NAME_LEN - 1] = '\0';
+        snprintf(cpu, sizeof(cpu), "%.1f", totalRunTime == 0 ? 0.0 : (double)current.task[idx].runTime * 100.0 / (double)totalRunTime);
+        json += std::string(idx == 0 ? "" : ",") + "{\"name\":\"" + current.task[idx].name + "\",\"stackFree\":" + std::to_string(current.task[idx].stackFree) +
+                ",\"runTime\":" + std::to_string(current.task[idx].runTime) + ",\"cpu\":" + cpu + "}";
+    }
+    json += "]";
+
+    json += ",\"queues\":[";
+    for(uint32_t idx=0; idx < current.queueCount && idx < METRICS_MAX_QUEUES; idx++)
+    {
+        current.queue[idx].name[METRICS_NAME_LEN - 1] = '\0';
+        json += std::string(idx == 0 ? "" : ",") + "{\"name\":\"" + current.queue[idx].name + "\",\"depth\":" + std::to_string(current.queue[idx].depth) +
+                ",\"peak\":" + std::to_string(current.queue[idx].peak) + ",\"size\":" + std::to_string(current.queue[idx].size) + "}";
+    }
+    json += "]";
+
+    json += ",\"counters\":{";
+    for(int idx=0; idx < COUNTER_MAX; idx++)
+    {
+        json += std::string(idx == 0 ? "" : ",") + "\"" + counterName[idx] + "\":" + std::to_string(current.counter[idx]);
+    }
+    json += "}";
+
+    json += ",\"histograms\":{";
+    for(int idx=0; idx < HIST_MAX; idx++)
+    {
+        json += std::string(idx == 0 ? "" : ",") + "\"" + histogramName[idx] + "\":[";
+        for(int bkt=0; bkt < METRICS_HIST_BUCKETS; bkt++)
+        {
+            json += std::string(bkt == 0 ? "" : ",") + std::to_string(current.histogram[idx][bkt]);
+        }
+        json += "]";
+    }
+    json += "}}";
+    return(json);
+}
+
+// Method to return the metrics as JSON. The live object samples the running system, the interface object is the last sample of the host
+// interface, null if there has been none since power on.
+//
+std::string Metrics::json(void)
+{
+    // Locals.
+    std::string     json;
+    t_sample        current;
+    char            version[16];
+
+    sample(current);
+    snprintf(version, sizeof(version), "%.2f", METRICS_VERSION);
+    json  = "{\"version\":" + std::string(version) + ",\"histogramBuckets\":" + std::to_string(METRICS_HIST_BUCKETS);
+    json += ",\"live\":" + sampleToJSON(current);
+    json += ",\"interface\":" + (lastRun.magic == METRICS_MAGIC && lastRun.taskCount <= METRICS_MAX_TASKS && lastRun.queueCount <= METRICS_MAX_QUEUES ? sampleToJSON(lastRun) : std::string("null"));
+    json += "}";
+    return(json);
+}
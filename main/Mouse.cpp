@@ -21,6 +21,9 @@
 //                             bluetooth and suspend logic due to NVS issues using both cores.
 //                             Updates to reflect moving functionality into the HID and to support
 //                             Bluetooth as a primary mouse or secondary mouse.
+//            v1.03 Oct 2026 - Configuration saved before host acceleration was added is migrated.
+//            v1.04 Oct 2026 - Bitbang transport waits on the MSCTRL edge interrupt rather than a 100uS poll.
+//            v1.05 Oct 2026 - Only the button bits of the PS/2 status are sent, idle packets are 0x00 again.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -57,6 +60,7 @@
 #include "soc/timer_group_reg.h"
 #include "driver/timer.h"
 #include "sdkconfig.h"
+#include "TimerService.h"
 #include "Mouse.h"
 
 // Tag for ESP main application logging.
@@ -94,23 +98,26 @@
 
 
 // Method to realise the Sharp host Mouse protocol.
-// This method uses Core 1 and it will hold it in a spinlock as necessary to ensure accurate timing.
+// This method uses Core 1. In bitbang mode it will hold it in a spinlock as necessary to ensure accurate timing, in hardware UART mode it sleeps until
+// the host strobes MSCTRL and the UART peripheral provides the bit timing.
 // Mouse data is passed into the method via a direct object, using the FreeRTOS Queue creates a time lag resulting in the mouse data being out of sync with hand movement.
 IRAM_ATTR void Mouse::hostInterface( void * pvParameters )
 {
     // Locals.
     //
     Mouse*              pThis = (Mouse*)pvParameters;                         // Retrieve pointer to object in order to access data.
-    bool                msctrlEdge = false;
     uint8_t             txBuf[4];
+  #ifdef CONFIG_HOST_BITBANG_UART
     uint32_t            MSCTRL_MASK;
     uint32_t            MSDATA_MASK;
-  #ifdef CONFIG_HOST_BITBANG_UART
+    bool                msctrlEdge = false;
     int                 txPos;
     int                 txCnt;
     uint32_t            shiftReg;
     uint64_t            delayTimer = 0LL;
-    uint64_t            curTime    = 0LL;
+    uint64_t            deadline   = 0LL;
+    TimerService       *timerService = TimerService::getInstance();
+    int                 timerId;
     uint32_t            bitCount = 0;
     enum HOSTXMITSTATE {
                         FSM_IDLE        = 0,
@@ -125,6 +132,8 @@ IRAM_ATTR void Mouse::hostInterface( void * pvParameters )
     // Initialise the MUTEX which prevents this core from being released to other tasks.
     pThis->x1Mutex = portMUX_INITIALIZER_UNLOCKED;
 
+  #ifdef CONFIG_HOST_BITBANG_UART
+    // Bitbang mode reads MSCTRL and drives MSDATA directly, the hardware UART is given its pins when configured.
     if(pThis->hostControl.secondaryIf == false)
     {
         MSCTRL_MASK     = (1 << CONFIG_HOST_KDB0);
@@ -134,6 +143,7 @@ IRAM_ATTR void Mouse::hostInterface( void * pvParameters )
         MSCTRL_MASK     = (1 << CONFIG_HOST_KDB0);
         MSDATA_MASK     = (1 << CONFIG_HOST_KDI4);
     }
+  #endif
 
     gpio_config_t     ioConf;
     ioConf.intr_type    = GPIO_INTR_DISABLE;
@@ -144,7 +154,17 @@ IRAM_ATTR void Mouse::hostInterface( void * pvParameters )
     if(pThis->hostControl.secondaryIf == false)
     {
         ioConf.pin_bit_mask = (1ULL<<CONFIG_HOST_KDB0); 
+        // Transmission is armed by the falling edge of MSCTRL, the interrupt wakes this thread which then loads the UART FIFO or starts
+        // serialising the packet.
+        ioConf.intr_type    = GPIO_INTR_NEGEDGE;
         gpio_config(&ioConf);
+        // The ISR service may already be installed by another driver, that is not an error.
+        esp_err_t isrResult = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+        if(isrResult != ESP_OK && isrResult != ESP_ERR_INVALID_STATE)
+        {
+            ESP_ERROR_CHECK(isrResult);
+        }
+        ESP_ERROR_CHECK(gpio_isr_handler_add((gpio_num_t)CONFIG_HOST_KDB0, &Mouse::msctrlInterrupt, pThis));
     }
     // Bitbang mode also needs MSDATA setting as an output.
   #ifdef CONFIG_HOST_BITBANG_UART
@@ -161,219 +181,183 @@ IRAM_ATTR void Mouse::hostInterface( void * pvParameters )
   
     // Set MSDATA to default state which is high.
     GPIO.out_w1ts = MSDATA_MASK;
-  #endif
 
-    // Configure a timer to be used for the host mouse asynchronous protocol spacing with 1uS resolution. The default clock source is the APB running at 80MHz.
-    timer_config_t timerConfig = {
-        .alarm_en    = TIMER_ALARM_DIS,            // No alarm, were not using interrupts as we are in a dedicated thread.
-        .counter_en  = TIMER_PAUSE,                // Timer paused until required.
-        .intr_type   = TIMER_INTR_LEVEL,           // No interrupts used.
-        .counter_dir = TIMER_COUNT_UP,             // Timing a fixed period.
-        .auto_reload = TIMER_AUTORELOAD_DIS,       // No need for auto reload, fixed time period.
-        .divider     = 80                          // 1Mhz operation giving 1uS resolution.
-    };
-    ESP_ERROR_CHECK(timer_init(TIMER_GROUP_0, TIMER_0, &timerConfig));
-    ESP_ERROR_CHECK(timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0));
+    // Register with the shared timer service, bit timing spins on its free running counter and the gaps between packets sleep on a deadline.
+    timerId = timerService->registerTimer(xTaskGetCurrentTaskHandle());
+  #endif
 
     // Sign on.
     ESP_LOGW(MAINTAG, "Starting Host side Mouse thread.");
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HOSTIF);
+
     // Permanent loop, wait for an incoming message on the key to send queue, read it then transmit to the host, repeat!
     for(;;)
     {
       #ifdef CONFIG_HOST_BITBANG_UART
-        // Get the current timer value, only run the FSM when the timer is idle.
-        timer_get_counter_value(TIMER_GROUP_0, TIMER_0, &curTime);
-        if((state == FSM_IDLE && pThis->hostControl.secondaryIf == false) || curTime >= delayTimer)
+        delayTimer = 0LL;
+
+        // Finite state machine to retrieve a key for transmission then serialise it according to the X1 protocol.
+        switch(state)
         {
-            // Ensure the timer is stopped.
-            timer_pause(TIMER_GROUP_0, TIMER_0);
-            delayTimer = 0LL;
+            case FSM_IDLE:
+                // Yield if the suspend flag is set.
+                pThis->yield(0);
 
-            // Finite state machine to retrieve a key for transmission then serialise it according to the X1 protocol.
-            switch(state)
-            {
-                case FSM_IDLE:
-                    // Yield if the suspend flag is set.
-                    pThis->yield(0);
+                // Check stack space, report if it is getting low.
+                if(uxTaskGetStackHighWaterMark(NULL) < 1024)
+                {
+                    ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
+                }                    
+                
+                if(pThis->hostControl.secondaryIf == false)
+                {
+                    // Detect high to low edge. On mouse primary mode the MSCTRL signal forces the tempo. On mouse secondary mode (operating in tandem to keyboard),
+                    // the timer forces the tempo.
+                    //
+                    msctrlEdge = (REG_READ(GPIO_IN_REG) & MSCTRL_MASK) != 0 ? true : msctrlEdge;
+                }
 
-                    // Check stack space, report if it is getting low.
-                    if(uxTaskGetStackHighWaterMark(NULL) < 1024)
-                    {
-                        ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
-                    }                    
-                    
-                    if(pThis->hostControl.secondaryIf == false)
-                    {
-                        // Detect high to low edge. On mouse primary mode the MSCTRL signal forces the tempo. On mouse secondary mode (operating in tandem to keyboard),
-                        // the timer forces the tempo.
-                        //
-                        msctrlEdge = (REG_READ(GPIO_IN_REG) & MSCTRL_MASK) != 0 ? true : msctrlEdge;
-                    }
+                // Wait for a window when MSCTRL goes low.
+                if(pThis->hostControl.secondaryIf == true || (msctrlEdge == true && (REG_READ(GPIO_IN_REG) & MSCTRL_MASK) == 0))
+                {
+                    // Drain the next host sized packet from the accumulator. The Sharp host protocol requires a message on a regular period regardless
+                    // of new data so a zero change message results when there is no movement.
+                    pThis->getHostPacket(txBuf);
+                    txPos = 0;
+                    txCnt = 3;
 
-                    // Wait for a window when MSCTRL goes low.
-                    if(pThis->hostControl.secondaryIf == true || (msctrlEdge == true && (REG_READ(GPIO_IN_REG) & MSCTRL_MASK) == 0))
+                    // Advance to first start bit.
+                    state = FSM_STARTXMIT; 
+
+                    // Clear edge detect for next loop.
+                    msctrlEdge = false;
+                } else
+                {
+                    // Block until the host strobes MSCTRL low, signalled by the edge interrupt. The timer service only notifies this thread
+                    // in secondary mode so a notification is the edge. The timeout is a backstop, MSCTRL is sampled again on each pass.
+                    if(ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MOUSE_IDLE_BACKSTOP)) > 0)
                     {
-                        // Wait for incoming mouse movement message.
-                        if(pThis->xmitMsg.valid)
-                        {
-                            txBuf[0] = (uint8_t)pThis->xmitMsg.status;
-                            txBuf[1] = (uint8_t)pThis->xmitMsg.xPos;
-                            txBuf[2] = (uint8_t)pThis->xmitMsg.yPos;
-                            pThis->xmitMsg.valid = false;   // Shouldnt be a race state here but consider a mutex if mouse gets out of sync.
-                            txBuf[3] = 0x00;
-                            txPos = 0;
-                            txCnt = 3;
-                        } else
-                        {
-                            // Sharp host protocol requires us to send zero change messages on a regular period regardless of new data.
-                            txBuf[0] = 0x00;
-                            txBuf[1] = 0x00;
-                            txBuf[2] = 0x00;
-                            txBuf[3] = 0x00;
-                            txPos = 0;
-                            txCnt = 3;
-                        }
-
-                        // Advance to first start bit.
-                        state = FSM_STARTXMIT; 
-
-                        // Clear edge detect for next loop.
-                        msctrlEdge = false;
+                        msctrlEdge = true;
                     }
-                    break;
-
-                case FSM_STARTXMIT:
-                    // Ensure all variables and states correct before entering serialisation.
-                    GPIO.out_w1ts = MSDATA_MASK;
-                    state = FSM_STARTBIT;
-                    bitCount = 8;
-                    shiftReg = txBuf[txPos++];
-                    txCnt--;
-                   
-                    // Create, initialise and hold a spinlock so the current core is bound to this one method.
-                    portENTER_CRITICAL(&pThis->x1Mutex);
-
-                    break;
-
-                case FSM_STARTBIT:
-                    // Send out the start bit by bringing MSDATA low for 208us (4800 baud 1bit time period).
-                    GPIO.out_w1tc = MSDATA_MASK;
-                    delayTimer    = BITBANG_UART_BIT_TIME;
-                    state         = FSM_DATA;
-                    break;
-
-                case FSM_DATA:
-                    if(bitCount > 0)
+                }
+                break;
+
+            case FSM_STARTXMIT:
+                // Ensure all variables and states correct before entering serialisation.
+                GPIO.out_w1ts = MSDATA_MASK;
+                deadline = timerService->now();
+                state = FSM_STARTBIT;
+                bitCount = 8;
+                shiftReg = txBuf[txPos++];
+                txCnt--;
+               
+                // Create, initialise and hold a spinlock so the current core is bound to this one method.
+                portENTER_CRITICAL(&pThis->x1Mutex);
+
+                break;
+
+            case FSM_STARTBIT:
+                // Send out the start bit by bringing MSDATA low for 208us (4800 baud 1bit time period).
+                GPIO.out_w1tc = MSDATA_MASK;
+                delayTimer    = BITBANG_UART_BIT_TIME;
+                state         = FSM_DATA;
+                break;
+
+            case FSM_DATA:
+                if(bitCount > 0)
+                {
+                    // Setup the bit on MSDATA
+                    if(shiftReg & 0x00000001)
                     {
-                        // Setup the bit on MSDATA
-                        if(shiftReg & 0x00000001)
-                        {
-                            GPIO.out_w1ts = MSDATA_MASK;
-                        } else
-                        {
-                            GPIO.out_w1tc = MSDATA_MASK;
-                        }
-
-                        // Shift the data to the next bit for transmission.
-                        shiftReg = shiftReg >> 1;
-
-                        // 1 bit period.
-                        delayTimer = BITBANG_UART_BIT_TIME;
-
-                        // 1 Less bit in frame.
-                        bitCount--;
+                        GPIO.out_w1ts = MSDATA_MASK;
                     } else
                     {
-                        state = FSM_STOP;
+                        GPIO.out_w1tc = MSDATA_MASK;
                     }
-                    break;                    
 
-                case FSM_STOP:
-                    // Send out the stop bit, 2 are needed so just adjust the time delay.
-                    GPIO.out_w1ts = MSDATA_MASK;
-                    delayTimer = BITBANG_UART_BIT_TIME * 2;
-                    state = FSM_ENDXMIT;
-                    break;
+                    // Shift the data to the next bit for transmission.
+                    shiftReg = shiftReg >> 1;
 
-                case FSM_ENDXMIT:
-                    // End of critical timing loop, release the core so other tasks can run whilst we load up the next byte.
-                    portEXIT_CRITICAL(&pThis->x1Mutex);
+                    // 1 bit period.
+                    delayTimer = BITBANG_UART_BIT_TIME;
 
-                    // Any more bytes to transmit, loop and send if there are.
-                    if(txCnt > 0)
-                    {
-                        state = FSM_STARTXMIT;
-                    } else
+                    // 1 Less bit in frame.
+                    bitCount--;
+                } else
+                {
+                    state = FSM_STOP;
+                }
+                break;                    
+
+            case FSM_STOP:
+                // Send out the stop bit, 2 are needed so just adjust the time delay.
+                GPIO.out_w1ts = MSDATA_MASK;
+                delayTimer = BITBANG_UART_BIT_TIME * 2;
+                state = FSM_ENDXMIT;
+                break;
+
+            case FSM_ENDXMIT:
+                // End of critical timing loop, release the core so other tasks can run whilst we load up the next byte.
+                portEXIT_CRITICAL(&pThis->x1Mutex);
+
+                // Any more bytes to transmit, loop and send if there are.
+                if(txCnt > 0)
+                {
+                    state = FSM_STARTXMIT;
+                } else
+                {
+                    // In secondary mode the host expects a packet every 20mS, sleep for the gap. In primary mode MSCTRL sets the tempo.
+                    if(pThis->hostControl.secondaryIf == true)
                     {
-                        // Reset timer for next loop.
                         delayTimer = 20000UL;
-                        state = FSM_IDLE;
                     }
-                    break;
-            }
+                    state = FSM_IDLE;
+                }
+                break;
+        }
 
-            // If a new delay is requested, set the value into the timer and start.
-            if(delayTimer > 0LL)
+        // If a new delay is requested, wait for it on the shared timer. Each edge is placed relative to the previous deadline so loop overhead
+        // does not accumulate. Within a byte the critical section is held so the wait spins on the free running counter, the inter packet gap
+        // is outside it so the thread sleeps until woken by the timer alarm.
+        if(delayTimer > 0LL)
+        {
+            deadline += delayTimer;
+            if(state == FSM_IDLE)
+            {
+                timerService->sleepUntil(timerId, deadline);
+            } else
             {
-                timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0LL);
-                timer_start(TIMER_GROUP_0, TIMER_0);
+                timerService->spinUntil(deadline);
             }
         }
       #endif
 
       #ifdef CONFIG_HOST_HW_UART
-        // Get the current timer value, we need to wait 20ms between transmissions.
-        timer_get_counter_value(TIMER_GROUP_0, TIMER_0, &curTime);
-        if(curTime >= delayTimer)
+        // Block until the host strobes MSCTRL low, signalled by the edge interrupt. In secondary mode there is no strobe, the host expects a packet every
+        // 20ms so the notify timeout sets the tempo. No CPU is used whilst waiting.
+        if(ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(pThis->hostControl.secondaryIf ? 20 : 100)) > 0 || pThis->hostControl.secondaryIf == true)
         {
-            // Wait for a window when MSCTRL goes low.
-            if(pThis->hostControl.secondaryIf == true || (REG_READ(GPIO_IN_REG) & MSCTRL_MASK) == 0)
+            // Only send if the previous packet has left the FIFO, a strobe during transmission is a glitch and ignored.
+            if(uart_wait_tx_done(pThis->hostControl.uartNum, 0) == ESP_OK)
             {
-                // Ensure the timer is stopped, initialise to 0 and restart.
-                timer_pause(TIMER_GROUP_0, TIMER_0);
-                delayTimer = 20000LL;
-                timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0LL);
-                timer_start(TIMER_GROUP_0, TIMER_0);
-
-                // Wait for incoming mouse movement message.
-                if(pThis->xmitMsg.valid)
-                {
-                    txBuf[0] = (uint8_t)pThis->xmitMsg.status;
-                    txBuf[1] = (uint8_t)pThis->xmitMsg.xPos;
-                    txBuf[2] = (uint8_t)pThis->xmitMsg.yPos;
-                    pThis->xmitMsg.valid = false;   // Shouldnt be a race state here but consider a mutex if mouse gets out of sync.
-                    txBuf[3] = 0x00;
-                    txPos = 0;
-                    txCnt = 3;
-                } else
-                {
-                    // Sharp host protocol requires us to send zero change messages on a regular period regardless of new data.
-                    txBuf[0] = 0x00;
-                    txBuf[1] = 0x00;
-                    txBuf[2] = 0x00;
-                    txBuf[3] = 0x00;
-                    txPos = 0;
-                    txCnt = 3;
-                }
+                // Drain the next host sized packet from the accumulator, a zero change message results when there is no movement.
+                pThis->getHostPacket(txBuf);
 
-                // Send the bytes and wait.
+                // Load the packet into the UART FIFO, the peripheral serialises it as <1xStart><8xdata><2xstop> at 4800 baud so this call returns immediately.
                 uart_write_bytes(pThis->hostControl.uartNum, (const char *)txBuf, 3);
-
-                // This method doesnt actually return after the last byte is transmitted, it returns well before, so we tack on a 10ms delay which is the width for 3 bytes at 4800 baud.
-                uart_wait_tx_done(pThis->hostControl.uartNum, 25000);
-                vTaskDelay(10);
             }
+        }
         
-            // Check stack space, report if it is getting low.
-            if(uxTaskGetStackHighWaterMark(NULL) < 1024)
-            {
-                ESP_LOGW(MAPKEYTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
-            }
-            
-            // Yield if the suspend flag is set.
-            pThis->yield(0);
+        // Check stack space, report if it is getting low.
+        if(uxTaskGetStackHighWaterMark(NULL) < 1024)
+        {
+            ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
         }
+            
+        // Yield if the suspend flag is set.
+        pThis->yield(0);
       #endif
 
         // Logic to feed the watchdog if needed. Watchdog disabled in menuconfig but if enabled this will need to be used.
@@ -386,50 +370,80 @@ IRAM_ATTR void Mouse::hostInterface( void * pvParameters )
     }
 }
 
+// Interrupt handler for the falling edge of MSCTRL. The host is requesting a packet so wake the host interface thread to load the UART
+// or serialise the packet.
+//
+IRAM_ATTR void Mouse::msctrlInterrupt(void *pvParameters)
+{
+    // Locals.
+    Mouse*              pThis = (Mouse*)pvParameters;
+    BaseType_t          taskWoken = pdFALSE;
+
+    if(pThis->TaskHostIF != NULL)
+    {
+        vTaskNotifyGiveFromISR(pThis->TaskHostIF, &taskWoken);
+    }
+    if(taskWoken == pdTRUE)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+// Method to drain the next host packet from the motion accumulator. Movement is clamped to the 8bit 2's complement range of the Sharp host and
+// the remainder is left in the accumulator for subsequent packets, so large or fast movements are split over several packets rather than clipped.
+// Buttons pressed since the last packet are reported even if already released, the release follows in the next packet.
+//
+void Mouse::getHostPacket(uint8_t *txBuf)
+{
+    // Locals.
+    int32_t    xPos;
+    int32_t    yPos;
+    uint8_t    status;
+
+    portENTER_CRITICAL(&accMutex);
+    xPos                   = xmitAcc.xPos > 127 ? 127 : xmitAcc.xPos < -128 ? -128 : xmitAcc.xPos;
+    yPos                   = xmitAcc.yPos > 127 ? 127 : xmitAcc.yPos < -128 ? -128 : xmitAcc.yPos;
+    xmitAcc.xPos          -= xPos;
+    xmitAcc.yPos          -= yPos;
+    status                 = xmitAcc.buttonsLatched;
+    xmitAcc.buttonsLatched = xmitAcc.buttons;
+    xmitAcc.wheel          = 0;
+    portEXIT_CRITICAL(&accMutex);
+
+    // The status flag on the Sharp host is <Y Overflow><Y Underflow><X Overflow><X Underflow><1><0><Right Button><Left Button>. Overflow is never
+    // signalled as excess movement is carried into the next packet.
+    txBuf[0] = status;
+    txBuf[1] = (uint8_t)(int8_t)xPos;
+    txBuf[2] = (uint8_t)(int8_t)yPos;
+    txBuf[3] = 0x00;
+}
+
 // Primary HID routine.
 // This method is responsible for receiving HID (PS/2 or BT) mouse scan data and mapping it into Sharp compatible mouse data.
-// The HID mouse data once received is mapped and pushed onto a FIFO queue for transmission to the host.
+// The HID mouse data once received is mapped and summed into the motion accumulator from which the host thread drains packets.
 //
 void Mouse::mouseReceiveData(HID::t_mouseMessageElement mouseMessage)
 {
     // Locals.
-    uint8_t    status;
+    int32_t    limit = MAX_MOUSE_ACCUMULATOR;
 
-    // Invert Y as the Sharp host is inverted compared to a PS/2 on the Y axis.
-    mouseMessage.yPos = -mouseMessage.yPos;
+    portENTER_CRITICAL(&accMutex);
 
-    // Initialise the status flag, on the Sharp host it is <Y Overflow><Y Underflow><X Overflow><X Underflow><1><0><Right Button><Left Button>
-    status = (((mouseMessage.xPos >> 8) & 0x01) << 4) | (mouseMessage.status & 0x0F );
+    // Invert Y as the Sharp host is inverted compared to a PS/2 on the Y axis.
+    xmitAcc.xPos           += mouseMessage.xPos;
+    xmitAcc.yPos           -= mouseMessage.yPos;
+    xmitAcc.wheel          += mouseMessage.wheel;
 
-    // Check bounds and set flags accordingly.
-    if(mouseMessage.xPos > 127)
-    {
-        mouseMessage.xPos = 127;            // Maximum resolution of Sharp host X movement.
-        status |= (1UL << 4);               // Set overflow bit.
-    }
-    if(mouseMessage.xPos < -128)
-    {
-        mouseMessage.xPos = -128;           // Minimum resolution of Sharp host X movement.
-        status |= (1UL << 5);               // Set underflow bit.
-    }
-    if(mouseMessage.yPos > 127)
-    {
-        mouseMessage.yPos = 127;            // Maximum resolution of Sharp host Y movement.
-        status |= (1UL << 6);               // Set overflow bit.
-    }
-    if(mouseMessage.yPos < -128)
-    {
-        mouseMessage.yPos = -128;           // Minimum resolution of Sharp host Y movement.
-        status |= (1UL << 7);               // Set underflow bit.
-    }
+    // Bound the unsent movement so a host which stops requesting data doesnt cause a long catch up once it resumes.
+    xmitAcc.xPos            = xmitAcc.xPos > limit ? limit : xmitAcc.xPos < -limit ? -limit : xmitAcc.xPos;
+    xmitAcc.yPos            = xmitAcc.yPos > limit ? limit : xmitAcc.yPos < -limit ? -limit : xmitAcc.yPos;
 
-    // Convert back to 8bit 2's compliment and store in the host message to the host thread.
-    xmitMsg.xPos   = (int8_t)mouseMessage.xPos;
-    xmitMsg.yPos   = (int8_t)mouseMessage.yPos;
-    xmitMsg.status = status;
-    xmitMsg.wheel  = mouseMessage.wheel;
-    xmitMsg.valid  = true;
+    // Record the button state, latching presses until the host has seen them. Only the button bits are taken, PS/2 status bit 3 is always set
+    // and the baseline idle packet is 0x00.
+    xmitAcc.buttons         = mouseMessage.status & 0x07;
+    xmitAcc.buttonsLatched |= xmitAcc.buttons;
 
+    portEXIT_CRITICAL(&accMutex);
     return;
 }
 
@@ -440,6 +454,7 @@ void Mouse::getMouseConfigTypes(std::vector<std::string>& typeList)
     // Add the types.
     //
     typeList.push_back(HID_MOUSE_HOST_SCALING_TYPE);
+    typeList.push_back(HID_MOUSE_HOST_ACCEL_TYPE);
     typeList.push_back(HID_MOUSE_SCALING_TYPE);
     typeList.push_back(HID_MOUSE_RESOLUTION_TYPE);
     typeList.push_back(HID_MOUSE_SAMPLING_TYPE);
@@ -466,6 +481,14 @@ bool Mouse::getMouseSelectList(std::vector<std::pair<std::string, int>>& selectL
         selectList.push_back(std::make_pair(HID_MOUSE_HOST_SCALING_1_4_NAME,  HID::HID_MOUSE_HOST_SCALING_1_4));
         selectList.push_back(std::make_pair(HID_MOUSE_HOST_SCALING_1_5_NAME,  HID::HID_MOUSE_HOST_SCALING_1_5));
     } 
+    else if(option.compare(HID_MOUSE_HOST_ACCEL_TYPE) == 0)
+    {
+        selectList.push_back(std::make_pair("ACTIVE",                         mouseConfig.host.acceleration));
+        selectList.push_back(std::make_pair(HID_MOUSE_HOST_ACCEL_OFF_NAME,    HID::HID_MOUSE_HOST_ACCEL_OFF));
+        selectList.push_back(std::make_pair(HID_MOUSE_HOST_ACCEL_LOW_NAME,    HID::HID_MOUSE_HOST_ACCEL_LOW));
+        selectList.push_back(std::make_pair(HID_MOUSE_HOST_ACCEL_MED_NAME,    HID::HID_MOUSE_HOST_ACCEL_MEDIUM));
+        selectList.push_back(std::make_pair(HID_MOUSE_HOST_ACCEL_HIGH_NAME,   HID::HID_MOUSE_HOST_ACCEL_HIGH));
+    } 
     else if(option.compare(HID_MOUSE_SCALING_TYPE) == 0)
     {
         selectList.push_back(std::make_pair("ACTIVE",                         mouseConfig.mouse.scaling));
@@ -528,6 +551,21 @@ bool Mouse::setMouseConfigValue(std::string paramName, std::string paramValue)
             }
         }
     }
+    if(paramName.compare(HID_MOUSE_HOST_ACCEL_TYPE) == 0)
+    {
+        dataError = (static_cast<bool>(testVal >> value) ? false : true);
+        if(dataError == false)
+        {
+            if(value >= to_underlying(HID::HID_MOUSE_HOST_ACCEL_OFF) && value <= to_underlying(HID::HID_MOUSE_HOST_ACCEL_HIGH))
+            {
+                mouseConfig.host.acceleration = static_cast<HID::HID_MOUSE_HOST_ACCEL>(value);
+                hid->setMouseHostAcceleration(mouseConfig.host.acceleration);
+            } else
+            {
+                dataError = true;
+            }
+        }
+    }
     if(paramName.compare(HID_MOUSE_SCALING_TYPE) == 0)
     {
         dataError = (static_cast<bool>(testVal >> value) ? false : true);
@@ -608,11 +646,19 @@ void Mouse::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
 {
     // Initialise control variables.
   #ifdef CONFIG_HOST_HW_UART
-    hostControl.uartNum             = UART_NUM_2;
+    hostControl.uartNum             = UART_NUM_1;                       // UART 2 is used by the keyboard hosts when the mouse is a secondary interface.
     hostControl.uartBufferSize      = 256;
     hostControl.uartQueueSize       = 10;
   #endif
 
+    // Initialise the motion accumulator.
+    accMutex                        = portMUX_INITIALIZER_UNLOCKED;
+    xmitAcc.xPos                    = 0;
+    xmitAcc.yPos                    = 0;
+    xmitAcc.wheel                   = 0;
+    xmitAcc.buttons                 = 0;
+    xmitAcc.buttonsLatched          = 0;
+
     // Initialise the basic components.
     init(hdlNVS, hdlHID);
 
@@ -620,7 +666,8 @@ void Mouse::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     KeyInterface::init(getClassName(__PRETTY_FUNCTION__), hdlNVS, hdlLED, hdlHID, ifMode);
 
     // There are two build possibilities, hardware UART and BITBANG. I initially coded using hardware but whilst trying to find a bug, wrote a bitbang
-    // technique and both are fit for purpose, so enabling either yields the same result.
+    // technique and both are fit for purpose, so enabling either yields the same result on the wire. Hardware UART is the default as it doesnt hold
+    // Core 1 in a spinlock whilst each packet is serialised.
   #ifdef CONFIG_HOST_HW_UART
     // Prepare the UART to be used for communications with the Sharp host.
     // The Sharp host Mouse uses an Asynchronous protocol with 2 stop bits no parity 4800 baud.
@@ -636,9 +683,13 @@ void Mouse::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     };
 
     // Configure UART parameters and pin assignments, software flow control, not RTS/CTS.
-    // The mouse only uses a Tx line, the MSCTRL line is used as a gate signal, so assign the Rx line to an unused pin.
+    // The mouse only uses a Tx line, MSDATA, which differs in secondary mode. The MSCTRL line is used as a gate signal so the Rx line is left unassigned.
     ESP_ERROR_CHECK(uart_param_config(hostControl.uartNum, &uartConfig));
-    ESP_ERROR_CHECK(uart_set_pin(hostControl.uartNum, CONFIG_HOST_KDB1, CONFIG_HOST_KDB2, -1, -1));
+    ESP_ERROR_CHECK(uart_set_pin(hostControl.uartNum, hostControl.secondaryIf ? CONFIG_HOST_KDI4 : CONFIG_HOST_KDB1, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+  #ifdef CONFIG_HOST_HW_UART_INVERT
+    // Boards with an inverting buffer on MSDATA need the UART output inverted to present idle high, active low start bits to the host.
+    ESP_ERROR_CHECK(uart_set_line_inverse(hostControl.uartNum, UART_SIGNAL_TXD_INV));
+  #endif
     // Install UART driver. Use RX/TX buffers without event queue. 
     ESP_ERROR_CHECK(uart_driver_install(hostControl.uartNum, hostControl.uartBufferSize, hostControl.uartBufferSize, 0, NULL, 0));
   #endif
@@ -653,17 +704,31 @@ void Mouse::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     // Core 1 - Sharp Mouse Host Interface
     ESP_LOGW(MAINTAG, "Starting mouseIf thread...");
     ::xTaskCreatePinnedToCore(&this->hostInterface, "mouseIf", 4096, this, 25, &this->TaskHostIF, 1);
-    vTaskDelay(500);
+    waitReady(KEYIF_READY_HOSTIF);
 }
 
 // Initialisation routine without hardware.
 void Mouse::init(NVS *hdlNVS, HID *hdlHID)
 {
+    // Locals.
+    t_mouseConfigV1     mouseConfigV1;
+    bool                persist = false;
+
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
     KeyInterface::init(getClassName(__PRETTY_FUNCTION__), hdlNVS, hdlHID);
 
-    // Retrieve configuration, if it doesnt exist, set defaults.
+    // Retrieve configuration, migrating one saved before acceleration was added, if it doesnt exist, set defaults.
     //
+    if(nvs->dataSize(getClassName(__PRETTY_FUNCTION__)) == sizeof(t_mouseConfigV1) && nvs->retrieveData(getClassName(__PRETTY_FUNCTION__), &mouseConfigV1, sizeof(t_mouseConfigV1)) == true)
+    {
+        ESP_LOGW(MAINTAG, "Mouse configuration migrated, acceleration off.");
+        mouseConfig.mouse.resolution= mouseConfigV1.mouse.resolution;
+        mouseConfig.mouse.scaling   = mouseConfigV1.mouse.scaling;
+        mouseConfig.mouse.sampleRate= mouseConfigV1.mouse.sampleRate;
+        mouseConfig.host.scaling    = mouseConfigV1.host.scaling;
+        mouseConfig.host.acceleration = HID::HID_MOUSE_HOST_ACCEL_OFF;
+        persist = true;
+    } else
     if(nvs->retrieveData(getClassName(__PRETTY_FUNCTION__), &this->mouseConfig, sizeof(t_mouseConfig)) == false)
     {
         ESP_LOGW(MAINTAG, "Mouse configuration set to default, no valid config in NVS found.");
@@ -671,11 +736,16 @@ void Mouse::init(NVS *hdlNVS, HID *hdlHID)
         mouseConfig.mouse.scaling   = HID::HID_MOUSE_SCALING_1_1;
         mouseConfig.mouse.sampleRate= HID::HID_MOUSE_SAMPLE_RATE_60;
         mouseConfig.host.scaling    = HID::HID_MOUSE_HOST_SCALING_1_2;
+        mouseConfig.host.acceleration = HID::HID_MOUSE_HOST_ACCEL_OFF;
+        persist = true;
+    }
 
+    if(persist == true)
+    {
         // Persist the data for next time.
         if(nvs->persistData(getClassName(__PRETTY_FUNCTION__), &this->mouseConfig, sizeof(t_mouseConfig)) == false)
         {
-            ESP_LOGW(MAINTAG, "Persisting Default Mouse configuration data failed, check NVS setup.\n");
+            ESP_LOGW(MAINTAG, "Persisting Mouse configuration data failed, check NVS setup.\n");
         }
         // Few other updates so make a commit here to ensure data is flushed and written.
         else if(nvs->commitData() == false)
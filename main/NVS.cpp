@@ -10,6 +10,7 @@
 //
 // History:         Mar 2022 - Initial write.
 //            v1.01 May 2022 - Initial release version.
+//            v1.02 Oct 2026 - Size of a persisted block, to recognise and migrate an earlier layout.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -152,6 +153,36 @@ bool NVS::retrieveData(const char *key, void *pData, uint32_t size)
     return(result);
 }
 
+// Method to return the size of a data block persisted in the NVS RAM, 0 if it doesnt exist. A configuration structure whose layout has changed
+// uses this to recognise a block written with the earlier layout and migrate it rather than lose the settings.
+//
+uint32_t NVS::dataSize(const char *key)
+{
+    // Locals.
+    //
+    size_t       storedSize = 0;
+
+    // Ensure a handle has been opened to the NVS.
+    if(nvsCtrl.nvsHandle != (nvs_handle_t)0)
+    {
+        // Ensure we have exclusive access before accessing NVS.
+        if(xSemaphoreTake(nvsCtrl.mutexInternal, (TickType_t)1000) == pdTRUE)
+        {
+            // Without a buffer the size of the stored blob is returned.
+            if(nvs_get_blob(this->nvsCtrl.nvsHandle, key, NULL, &storedSize) != ESP_OK)
+            {
+                storedSize = 0;
+            }
+
+            // Release mutex, external access now possible to the input devices.
+            xSemaphoreGive(nvsCtrl.mutexInternal);
+        }
+    }
+
+    // Return size, 0 = not found.
+    return((uint32_t)storedSize);
+}
+
 // Method to ensure all data written to NVS is flushed and committed. This step is necessary as a write may be buffered and requires flushing to ensure persistence.
 //
 bool NVS::commitData(void)
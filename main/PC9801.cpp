@@ -22,6 +22,16 @@
 // History:         Apr 2022 - Initial framework, waiting on arrival of real machine to progress further.
 //            v1.01 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
+//            v1.02 Oct 2026 - Host UART is event driven, the interface blocks on host data and keys together.
+//            v1.03 Oct 2026 - Host command protocol, ACK/NACK responses, LED sync, host configured local key
+//                             repeat and resynchronisation on host reset.
+//            v1.04 Oct 2026 - Keystroke macros, keys paced by the UART transmit completing.
+//            v1.05 Oct 2026 - Keymap row edits from the web editor applied without a full table upload.
+//            v1.06 Oct 2026 - Transmit queue depth and overflows reported to the runtime metrics.
+//            v1.07 Oct 2026 - Queue wait and UART hand off latency recorded per key in the runtime metrics.
+//            v1.08 Oct 2026 - Macro characters reverse mapped through the active keymap and the PC-9801 key legends. Keys
+//                             discarded on a host reset are counted as rejected so macro playback does not stall.
+//            v1.09 Oct 2026 - Keys discarded on a host reset slow macro playback.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -65,6 +75,21 @@
 #include "sdkconfig.h"
 #include "PC9801.h"
 
+// Inbuilt keymap, constant so it is held in flash rather than copied into each instance.
+constexpr PC9801::t_keyMap PC9801::PS2toPC9801;
+
+// Character on each PC-9801 key, unshifted then shifted, indexed by key code up to SPACE. The main keys follow the JIS layout shown
+// below, keys without a character are 0. Caps lock is assumed off so letters are lower case unshifted.
+static const char pc9801Legend[][2] = {
+    { 0x1B, 0x1B }, { '1',  '!'  }, { '2',  '"'  }, { '3',  '#'  }, { '4',  '$'  }, { '5',  '%'  }, { '6',  '&'  }, { '7',  '\'' },    // 00-07
+    { '8',  '('  }, { '9',  ')'  }, { '0',  0x00 }, { '-',  '='  }, { '^',  '~'  }, { '\\', '|'  }, { '\b', '\b' }, { '\t', '\t' },    // 08-0F
+    { 'q',  'Q'  }, { 'w',  'W'  }, { 'e',  'E'  }, { 'r',  'R'  }, { 't',  'T'  }, { 'y',  'Y'  }, { 'u',  'U'  }, { 'i',  'I'  },    // 10-17
+    { 'o',  'O'  }, { 'p',  'P'  }, { '@',  '`'  }, { '[',  '{'  }, { '\r', '\r' }, { 'a',  'A'  }, { 's',  'S'  }, { 'd',  'D'  },    // 18-1F
+    { 'f',  'F'  }, { 'g',  'G'  }, { 'h',  'H'  }, { 'j',  'J'  }, { 'k',  'K'  }, { 'l',  'L'  }, { ';',  '+'  }, { ':',  '*'  },    // 20-27
+    { ']',  '}'  }, { 'z',  'Z'  }, { 'x',  'X'  }, { 'c',  'C'  }, { 'v',  'V'  }, { 'b',  'B'  }, { 'n',  'N'  }, { 'm',  'M'  },    // 28-2F
+    { ',',  '<'  }, { '.',  '>'  }, { '/',  '?'  }, { '_',  '_'  }, { ' ',  ' '  },                                                    // 30-34
+};
+
 // Tag for ESP main application logging.
 #define                         MAINTAG  "pc9801key"
 
@@ -86,6 +111,22 @@ static QueueHandle_t            rcvQueue;
 //     Idle State (RXD/TXD) = High.
 //     <START BIT 0 (low)><DATABIT 0><DATABIT 1><DATABIT 2><DATABIT 3><DATABIT 4><DATABIT 5><DATABIT 6><DATaBIT 7><ODD Parity><STOP BIT 1 (high)>
 //
+// DATA (PC-9801 -> KEYBOARD):
+//     Each command is answered with ACK (FA), an unknown command with NACK (FC). Commands with a parameter are answered again once the
+//     parameter is received.
+//       95 <p>    - Windows/Application key mode. Accepted, the mapping is fixed by the keymap.
+//       96        - Identify, answered with FA A0 86.
+//       9C <p>    - Repeat, p = 0DDRRRRR. DD selects the delay 1000/500/500/250ms, RRRRR the repeat time. The time is an
+//                   approximation, 30ms + RRRRR * 10ms, as the NEC documentation is sparse.
+//       9D <p>    - LEDs, p = 0111KC0N (Kana, Caps, Num) sets the LEDs, p = 60 reads them back as 0111KC0N.
+//       9F        - Keyboard type, answered with FA A0 80.
+//     /RST held low is seen by the UART as a line break. The host is restarting so queued keys are discarded, LEDs and repeat settings
+//     return to their power on state.
+//
+//     Repeat is generated by the keyboard resending the make code of the last key pressed. The PS/2 keyboard typematic is suppressed and
+//     the repeat generated here using the host settings. Caps maps to PS/2 CAPS LOCK and Kana to PS/2 SCROLL LOCK, Num is not forwarded
+//     as it changes the PS/2 keypad mapping.
+//
 // The following keymaps (from the TMK project, https://github.com/tmk/tmk_keyboard/wiki/PC-9801-Keyboard) show the PC-9801 keyboard layout
 // and generated scan codes.
 //
@@ -167,22 +208,29 @@ IRAM_ATTR void PC9801::pushKeyToQueue(uint32_t key)
     #define             PUSHKEYTAG "pushKeyToQueue"
 
     xmitMsg.keyCode = key;
+    xmitMsg.eventTime = takeKeyEventTime();
+    xmitMsg.queueTime = Metrics::now();
     if( xQueueSend(xmitQueue, (void *)&xmitMsg, 10) != pdPASS)
     {
         ESP_LOGW(PUSHKEYTAG, "Failed to put scancode:%04x into xmitQueue", key);
+        Metrics::count(Metrics::COUNTER_XMIT_QUEUE_FULL);
+    } else
+    {
+        macroFrameQueued();
     }
     return;
 }
 
 // Function to push a host command onto the processing queue.
 //
-IRAM_ATTR void PC9801::pushHostCmdToQueue(uint8_t cmd)
+IRAM_ATTR void PC9801::pushHostCmdToQueue(uint8_t cmd, uint8_t param)
 {
     // Locals.
     t_rcvQueueMessage   rcvMsg;
     #define             PUSHCMDTAG "pushHostCmdToQueue"
 
     rcvMsg.hostCmd = cmd;
+    rcvMsg.param   = param;
     if( xQueueSend(rcvQueue, (void *)&rcvMsg, 10) != pdPASS)
     {
         ESP_LOGW(PUSHCMDTAG, "Failed to put host command:%02x onto rcvQueue", cmd);
@@ -200,9 +248,9 @@ IRAM_ATTR void PC9801::pcInterface( void * pvParameters )
 {
     // Locals.
     t_xmitQueueMessage  rcvMsg;
+    uint32_t            xmitStart;
     uint8_t uartData[128];
-    int     uartXmitCnt;
-    size_t  uartRcvCnt;
+    int     uartRcvCnt;
 
     // Retrieve pointer to object in order to access data.
     PC9801* pThis = (PC9801*)pvParameters;
@@ -210,12 +258,12 @@ IRAM_ATTR void PC9801::pcInterface( void * pvParameters )
     // Initialise the MUTEX which prevents this core from being released to other tasks.
     pThis->pcMutex = portMUX_INITIALIZER_UNLOCKED;
 
-    // Initial delay needed because the xQueue will assert probably on a suspended task ALL if delay not inserted!
-    vTaskDelay(1000);
-
     // Sign on.
     ESP_LOGW(MAINTAG, "Starting NEC PC-9801 thread.");
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HOSTIF);
+
     // Permanent loop, wait for an incoming message on the key to send queue, read it then transmit to the PC-9801, repeat!
     for(;;)
     {
@@ -225,51 +273,51 @@ IRAM_ATTR void PC9801::pcInterface( void * pvParameters )
             ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
         }
 
-        if(xQueueReceive(xmitQueue, (void *)&rcvMsg, 0) == pdTRUE)
+        // Block until a key has been mapped or the PC-9801 sends data, the wait is bounded so a suspend request is honoured.
+        switch(pThis->pcCtrl.hostUART.wait(pdMS_TO_TICKS(HOSTUART_WAIT_MS)))
         {
-            ESP_LOGW(MAINTAG, "Received:%08x\n", rcvMsg.keyCode);
+            // Exactly one key is read per event, the queue set signals each queued key.
+            case HostUART::HOSTUART_EVENT_XMIT:
+                if(xQueueReceive(xmitQueue, (void *)&rcvMsg, 0) == pdTRUE)
+                {
+                    xmitStart = Metrics::stage(Metrics::HIST_QUEUE, rcvMsg.queueTime);
+                    ESP_LOGW(MAINTAG, "Received:%08x\n", rcvMsg.keyCode);
+                    pThis->pcCtrl.hostUART.writeKey(rcvMsg.keyCode);
+                    pThis->keyOutput(rcvMsg.eventTime, xmitStart);
+                    pThis->macroFrameSent();
+                }
+                break;
 
-            // Allow for multi byte transmissions, MSB sent first.
-            if(rcvMsg.keyCode != 0x00000000)
-            {
-                uartXmitCnt = 0;
-                while((rcvMsg.keyCode & 0xff000000) == 0x00) { rcvMsg.keyCode = rcvMsg.keyCode << 8; }
-                for(int idx=0; idx < 4 && (rcvMsg.keyCode & 0xff000000) != 0x00; idx++)
+            // Get data from PC-9801 - answer it and send any relevant commands for processing.
+            case HostUART::HOSTUART_EVENT_RCV:
+                while((uartRcvCnt = pThis->pcCtrl.hostUART.readData(uartData, sizeof(uartData))) > 0)
                 {
-                    if((rcvMsg.keyCode & 0xff000000) != 0)
+                    for(int idx=0; idx < uartRcvCnt; idx++)
                     {
-                        uartData[idx] = (uint8_t)((rcvMsg.keyCode & 0xFF000000) >> 24);
-                        uartXmitCnt++;
+                        pThis->processHostByte(uartData[idx]);
                     }
-                    rcvMsg.keyCode = rcvMsg.keyCode << 8;
                 }
-                if(uartXmitCnt > 0)
-                {
-                    ESP_LOGW(MAINTAG, "Received:%08x, Count=%d\n", rcvMsg.keyCode, uartXmitCnt);
-                    uart_write_bytes(pThis->pcCtrl.uartNum, (const char *)uartData, uartXmitCnt);
-                }
-            }
-        }
+                break;
 
-        // Get command data from the PC-9801 if any sent- this is where the PC-9801, later models, can send any relevant commands for processing.
-        uart_get_buffered_data_len(pThis->pcCtrl.uartNum, &uartRcvCnt);
-        if(uartRcvCnt > 0)
-        {
-            do {
-                uartRcvCnt = uart_read_bytes(pThis->pcCtrl.uartNum, uartData, (128 - 1), 20 / portTICK_PERIOD_MS);
-                for(int idx=0; idx < uartRcvCnt; idx++)
+            // /RST asserted, the host is restarting. Keys queued for the previous session are discarded along with any partial command.
+            case HostUART::HOSTUART_EVENT_BREAK:
+                ESP_LOGW(MAINTAG, "Host reset.");
+                while(xQueueReceive(xmitQueue, (void *)&rcvMsg, 0) == pdTRUE)
                 {
-                    // Filter out polling commands and send valid commands to the rcvQueue.
-                    if(uartData[idx] != 0x40 && uartData[idx] != 0x41)
-                    {
-                        pThis->pushHostCmdToQueue(uartData[idx]);
-                    }
+                    pThis->macroHostReject();
+                    pThis->macroFrameSent();
                 }
-            } while(uartRcvCnt > 0);
+                pThis->pcCtrl.link.pendingCmd = 0x00;
+                pThis->pcCtrl.link.leds       = 0x00;
+                pThis->pushHostCmdToQueue(PC9801_HOSTCMD_RESET, 0x00);
+                break;
+
+            default:
+                break;
         }
        
         // Yield if the suspend flag is set.
-        pThis->yield(50);
+        pThis->yield(0);
 
         // Logic to feed the watchdog if needed. Watchdog disabled in menuconfig but if enabled this will need to be used.
         //TIMERG0.wdt_wprotect=TIMG_WDT_WKEY_VALUE; // write enable
@@ -323,6 +371,15 @@ void PC9801::selectOption(uint8_t optionCode)
             this->pcConfig.params.activeKeyboardMap = KEYMAP_STANDARD;
             break;
 
+        // Play a keystroke macro, F1..F4 select the macro file.
+        case PS2_KEY_F1:
+        case PS2_KEY_F2:
+        case PS2_KEY_F3:
+        case PS2_KEY_F4:
+            updated = false;
+            macroPlay(KeyMacro::fileName(this->pcCtrl.keyMapFileName, optionCode - PS2_KEY_F1 + 1));
+            break;
+
         // Unknown option so ignore.
         default:
             updated = false;
@@ -346,6 +403,7 @@ void PC9801::selectOption(uint8_t optionCode)
 uint32_t PC9801::mapKey(uint16_t scanCode)
 {
     // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap = pcCtrl.keyMap;
     uint32_t  idx;
     uint8_t   keyCode = (scanCode & 0xFF);
     bool      mapped = false;
@@ -396,29 +454,29 @@ uint32_t PC9801::mapKey(uint16_t scanCode)
         // Loop through the entire conversion table to find a match on this key, if found map to X68000 equivalent.
         // switch matrix.
         //
-        for(idx=0, mapped=false, matchExact=false; idx < pcCtrl.kmeRows && (mapped == false || (mapped == true && matchExact == false)); idx++)
+        for(idx=0, mapped=false, matchExact=false; idx < (uint32_t)keyMap->rows && (mapped == false || (mapped == true && matchExact == false)); idx++)
         {
             // Match key code? Make sure the current machine and keymap match as well.
-            if(pcCtrl.kme[idx].ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((pcCtrl.kme[idx].machine == PC9801_ALL) || ((pcCtrl.kme[idx].machine & pcConfig.params.activeMachineModel) != 0)) && ((pcCtrl.kme[idx].keyboardModel & pcConfig.params.activeKeyboardMap) != 0))
+            if(keyMap->row(idx).ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((keyMap->row(idx).machine == PC9801_ALL) || ((keyMap->row(idx).machine & pcConfig.params.activeMachineModel) != 0)) && ((keyMap->row(idx).keyboardModel & pcConfig.params.activeKeyboardMap) != 0))
             {
                 // Match Raw, Shift, Function, Control, ALT or ALT-Gr?
-                //if( (((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL) == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)  == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
-                if( (((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL) == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0) && ((pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
-                    ((scanCode & PS2_SHIFT)                                && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
-                    ((scanCode & PS2_CTRL)                                 && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
-                    ((scanCode & PS2_GUI)                                  && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || 
-          //          ((this->pcCtrl.keyCtrl & PC9801_CTRL_KANA)           && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)!= 0) ||
-                //    ((scanCode & PS2_CAPS)                               && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CAPS)  != 0) || 
-                    ((scanCode & PS2_FUNCTION)                             && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+                //if( (((keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
+                if( (((keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
+                    ((scanCode & PS2_SHIFT)                                && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                    ((scanCode & PS2_CTRL)                                 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                    ((scanCode & PS2_GUI)                                  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || 
+          //          ((this->pcCtrl.keyCtrl & PC9801_CTRL_KANA)           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)!= 0) ||
+                //    ((scanCode & PS2_CAPS)                               && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS)  != 0) || 
+                    ((scanCode & PS2_FUNCTION)                             && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) )
                 {
                     
                     // Exact entry match, data + control key? On an exact match we only process the first key. On a data only match we fall through to include additional data and control key matches to allow for un-mapped key combinations, ie. Japanese characters.
-                    matchExact = (((scanCode & PS2_SHIFT)                            && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0                         && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
-                                 (((scanCode & PS2_CTRL)                             && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                          && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
-                                 (((scanCode & PS2_GUI)                              && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                           && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
-           //                      (((this->pcCtrl.keyCtrl & PC9801_CTRL_KANA)       && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)!= 0) || ((this->pcCtrl.keyCtrl & PC9801_CTRL_KANA) == 0    && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_KANA)== 0)) &&
-                 //              (((scanCode & PS2_CAPS)                             && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CAPS)  != 0) || ((scanCode & PS2_GUI) == 0                           && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_CAPS)  == 0)) &&
-                                 (((scanCode & PS2_FUNCTION)                         && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0                      && (pcCtrl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0))
+                    matchExact = (((scanCode & PS2_SHIFT)                            && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                                 (((scanCode & PS2_CTRL)                             && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                          && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                                 (((scanCode & PS2_GUI)                              && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+           //                      (((this->pcCtrl.keyCtrl & PC9801_CTRL_KANA)       && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)!= 0) || ((this->pcCtrl.keyCtrl & PC9801_CTRL_KANA) == 0    && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)== 0)) &&
+                 //              (((scanCode & PS2_CAPS)                             && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS)  != 0) || ((scanCode & PS2_GUI) == 0                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS)  == 0)) &&
+                                 (((scanCode & PS2_FUNCTION)                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0                      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0))
                                  ? true : false;
     
                     // RELEASE (PS2_BREAK == 1) or PRESS?
@@ -432,28 +490,28 @@ uint32_t PC9801::mapKey(uint16_t scanCode)
                         {
                             vTaskDelay(100);
                         }
-                        mappedKey = 0x80 | (pcCtrl.kme[idx].pcKey & 0x7F);
+                        mappedKey = 0x80 | (keyMap->row(idx).pcKey & 0x7F);
                         mapped = true;
                     } else
                     {
                         // Map key actioning any control overrides.
-                        if((pcCtrl.kme[idx].pcCtrl & PC9801_CTRL_RELEASESHIFT) != 0)
+                        if((keyMap->row(idx).pcCtrl & PC9801_CTRL_RELEASESHIFT) != 0)
                         {
                             // RELEASESHIFT infers that the X68000 must cancel the current shift status prior to receiving the key code. This is necessary when using foreign keyboards and a character appears
                             // on a shifted key whereas on the original X68000 keyboard the character is the primary key.
                             //
-                            mappedKey = ((0x80 | PC9801_KEY_SHIFT) << 16) | 0x00 | ((pcCtrl.kme[idx].pcKey & 0x7F) << 8) | (0x00 | PC9801_KEY_SHIFT);
+                            mappedKey = ((0x80 | PC9801_KEY_SHIFT) << 16) | 0x00 | ((keyMap->row(idx).pcKey & 0x7F) << 8) | (0x00 | PC9801_KEY_SHIFT);
                         } else
-                        if((pcCtrl.kme[idx].pcCtrl & PC9801_CTRL_SHIFT) != 0)
+                        if((keyMap->row(idx).pcCtrl & PC9801_CTRL_SHIFT) != 0)
                         {
                             // SHIFT infers that the X68000 must invoke shift status prior to receiving the key code. This is necessary when using foreign keyboards and a character appears
                             // as a primary key on the foreign keyboard but as a shifted key on the X68000 keyboard.
                             //
-                            mappedKey = ((0x00 | PC9801_KEY_SHIFT) << 16) | 0x00 | ((pcCtrl.kme[idx].pcKey & 0x7F) << 8) | (0x80 | PC9801_KEY_SHIFT);
+                            mappedKey = ((0x00 | PC9801_KEY_SHIFT) << 16) | 0x00 | ((keyMap->row(idx).pcKey & 0x7F) << 8) | (0x80 | PC9801_KEY_SHIFT);
                         }
                         else
                         {
-                            mappedKey = 0x00 | (pcCtrl.kme[idx].pcKey & 0x7F);
+                            mappedKey = 0x00 | (keyMap->row(idx).pcKey & 0x7F);
                         }
                         mapped = true;
                     }
@@ -464,6 +522,264 @@ uint32_t PC9801::mapKey(uint16_t scanCode)
     return(mappedKey);
 }
 
+// Method to process a byte received from the PC-9801. Runs in the interface thread so the response is sent immediately, commands affecting
+// the keyboard are passed to the HID thread.
+//
+void PC9801::processHostByte(uint8_t data)
+{
+    // Locals.
+    //
+    uint8_t             cmd;
+
+    // Parameter of a two byte command?
+    if(pcCtrl.link.pendingCmd != 0x00)
+    {
+        cmd = pcCtrl.link.pendingCmd;
+        pcCtrl.link.pendingCmd = 0x00;
+        switch(cmd)
+        {
+            case PC9801_HOSTCMD_LED:
+                if(data == PC9801_LED_READ)
+                {
+                    pcCtrl.hostUART.writeKey((PC9801_RESP_ACK << 8) | PC9801_LED_SET | pcCtrl.link.leds);
+                } else
+                if((data & PC9801_LED_SET_MASK) == PC9801_LED_SET)
+                {
+                    pcCtrl.hostUART.writeKey(PC9801_RESP_ACK);
+                    pcCtrl.link.leds = (data & ~PC9801_LED_SET_MASK);
+                    pushHostCmdToQueue(cmd, data);
+                } else
+                {
+                    pcCtrl.hostUART.writeKey(PC9801_RESP_NACK);
+                }
+                break;
+
+            case PC9801_HOSTCMD_REPEAT:
+                if((data & 0x80) == 0)
+                {
+                    pcCtrl.hostUART.writeKey(PC9801_RESP_ACK);
+                    pushHostCmdToQueue(cmd, data);
+                } else
+                {
+                    pcCtrl.hostUART.writeKey(PC9801_RESP_NACK);
+                }
+                break;
+
+            default:
+                pcCtrl.hostUART.writeKey(PC9801_RESP_ACK);
+                break;
+        }
+        return;
+    }
+
+    switch(data)
+    {
+        case PC9801_HOSTCMD_WINKEY:
+        case PC9801_HOSTCMD_REPEAT:
+        case PC9801_HOSTCMD_LED:
+            pcCtrl.hostUART.writeKey(PC9801_RESP_ACK);
+            pcCtrl.link.pendingCmd = data;
+            break;
+
+        case PC9801_HOSTCMD_IDENTIFY:
+            pcCtrl.hostUART.writeKey((PC9801_RESP_ACK << 16) | PC9801_KEYBOARD_ID);
+            break;
+
+        case PC9801_HOSTCMD_TYPE:
+            pcCtrl.hostUART.writeKey((PC9801_RESP_ACK << 16) | PC9801_KEYBOARD_TYPE);
+            break;
+
+        // Only refuse bytes which look like commands, others are noise on the shared /RST line.
+        default:
+            if(data & 0x80)
+            {
+                ESP_LOGD(MAINTAG, "Unknown Host Cmd:%02x", data);
+                pcCtrl.hostUART.writeKey(PC9801_RESP_NACK);
+            }
+            break;
+    }
+    return;
+}
+
+// Method to action a host command passed from the interface thread.
+//
+void PC9801::processHostCmd(uint8_t hostCmd, uint8_t param)
+{
+    // Locals.
+    //
+    uint8_t             locks;
+    static const uint32_t repeatDelay[] = { 1000, 500, 500, 250 };
+
+    switch(hostCmd)
+    {
+        case PC9801_HOSTCMD_LED:
+            locks = ((param & PC9801_LED_CAPS) ? PS2_LOCK_CAPS   : 0x00) |
+                    ((param & PC9801_LED_KANA) ? PS2_LOCK_SCROLL : 0x00);
+            hid->setKeyboardLEDs(locks, PS2_LOCK_CAPS | PS2_LOCK_SCROLL);
+            break;
+
+        case PC9801_HOSTCMD_REPEAT:
+            pcCtrl.host.repeatDelay = repeatDelay[(param >> PC9801_REPEAT_DELAY_SHIFT) & 0x03];
+            pcCtrl.host.repeatTime  = PC9801_REPEAT_TIME_BASE + ((param & PC9801_REPEAT_RATE_MASK) * PC9801_REPEAT_TIME_STEP);
+            break;
+
+        // Host restarted, return to the power on state. Held keys are forgotten so a key still held is resent as a make by the device typematic.
+        case PC9801_HOSTCMD_RESET:
+            pcCtrl.host.repeatDelay = PC9801_REPEAT_DELAY_DEFAULT;
+            pcCtrl.host.repeatTime  = PC9801_REPEAT_TIME_DEFAULT;
+            pcCtrl.host.repeatScan  = 0;
+            memset(pcCtrl.host.heldKeys, 0x00, sizeof(pcCtrl.host.heldKeys));
+            hid->setKeyboardLEDs(0x00, PS2_LOCK_CAPS | PS2_LOCK_SCROLL);
+            break;
+
+        default:
+            break;
+    }
+    return;
+}
+
+// Method to track the held keys and the key to be repeated. The most recently pressed key repeats, lock and modifier keys never repeat.
+//
+void PC9801::trackKey(uint16_t scanCode, uint32_t pcKey)
+{
+    // Locals.
+    //
+    uint8_t             keyCode = (scanCode & 0xFF);
+
+    if(scanCode & PS2_BREAK)
+    {
+        pcCtrl.host.heldKeys[keyCode >> 5] &= ~(1UL << (keyCode & 0x1F));
+        if(keyCode == pcCtrl.host.repeatScan)
+            pcCtrl.host.repeatScan = 0;
+    } else
+    {
+        pcCtrl.host.heldKeys[keyCode >> 5] |= (1UL << (keyCode & 0x1F));
+        if(pcKey != 0L && (keyCode < PS2_KEY_NUM || keyCode > PS2_KEY_R_GUI))
+        {
+            pcCtrl.host.repeatScan = keyCode;
+            pcCtrl.host.repeatKey  = pcKey;
+            pcCtrl.host.repeatNext = xTaskGetTickCount() + pdMS_TO_TICKS(pcCtrl.host.repeatDelay);
+        }
+    }
+    return;
+}
+
+// Method to give the keymap row a key make selects, -1 if none. Used by the live key monitor, no interface state is changed.
+//
+int PC9801::lookupKey(uint16_t scanCode)
+{
+    return(macroMapRow(pcCtrl.keyMap, scanCode & ~PS2_BREAK));
+}
+
+// Method to find the keymap row mapKey selects for a key. Returns -1 if no row matches.
+//
+int PC9801::macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode)
+{
+    // Locals.
+    int       row = -1;
+    bool      matchExact = false;
+
+    for(int idx=0; idx < keyMap->rows && matchExact == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if(kme.ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((kme.machine == PC9801_ALL) || ((kme.machine & pcConfig.params.activeMachineModel) != 0)) && ((kme.keyboardModel & pcConfig.params.activeKeyboardMap) != 0))
+        {
+            if( (((kme.ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((kme.ps2Ctrl & PS2CTRL_CTRL) == 0) && ((kme.ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((kme.ps2Ctrl & PS2CTRL_GUI) == 0) && ((kme.ps2Ctrl & PS2CTRL_FUNC) == 0)) ||
+                ((scanCode & PS2_SHIFT)     && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                ((scanCode & PS2_CTRL)      && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                ((scanCode & PS2_GUI)       && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) ||
+                ((scanCode & PS2_FUNCTION)  && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+            {
+                row = idx;
+                matchExact = (((scanCode & PS2_SHIFT)    && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0    && (kme.ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                             (((scanCode & PS2_CTRL)     && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0     && (kme.ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                             (((scanCode & PS2_GUI)      && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0      && (kme.ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                             (((scanCode & PS2_FUNCTION) && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0 && (kme.ps2Ctrl & PS2CTRL_FUNC)  == 0));
+            }
+        }
+    }
+    return(row);
+}
+
+// Method to give the PS/2 key which types a character on the PC-9801. The host receives key codes so the active keymap is searched in
+// reverse for a row whose PC-9801 key carries the character, with the shift the row leaves the host in. A row which does not need SHIFT is
+// tried both unshifted and shifted as the PS/2 shift reaches the host as its own key. The key is then mapped forward as mapKey would and
+// only accepted if it selects the same row. Control characters use the PC layout.
+//
+bool PC9801::macroKey(char chr, uint16_t &keyCode)
+{
+    // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap;
+    uint16_t  events[KEYMACRO_MAX_EVENTS];
+    uint16_t  scanCode;
+    int       eventCnt;
+    bool      hostShift;
+    bool      result = false;
+
+    if((uint8_t)chr < 0x20)
+        return(KeyInterface::macroKey(chr, keyCode));
+
+    keyMapReadBegin();
+    keyMap = pcCtrl.keyMap;
+    for(int idx=0; idx < keyMap->rows && result == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        for(int shift=0; shift < 2 && result == false; shift++)
+        {
+            if((kme.ps2Ctrl & (PS2CTRL_CTRL | PS2CTRL_KANA | PS2CTRL_GRAPH | PS2CTRL_GUI)) != 0 || (shift == 0 && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) || kme.pcKey >= sizeof(pc9801Legend)/sizeof(pc9801Legend[0]))
+                continue;
+
+            hostShift = (shift == 1 && (kme.pcCtrl & PC9801_CTRL_RELEASESHIFT) == 0) || (kme.pcCtrl & PC9801_CTRL_SHIFT) != 0;
+            if(pc9801Legend[kme.pcKey][hostShift ? 1 : 0] == chr)
+            {
+                // Key make as the macro delivers it, the Function flag follows the key.
+                keyCode  = kme.ps2KeyCode | (shift == 1 ? PS2_SHIFT : 0);
+                eventCnt = KeyMacro::strokeEvents(keyCode, events);
+                scanCode = events[(eventCnt / 2) - 1];
+                result   = (macroMapRow(keyMap, scanCode) == idx);
+            }
+        }
+    }
+    keyMapReadEnd();
+
+    return(result);
+}
+
+// Method to test if the host has taken the last macro key, ie. it has left the UART.
+//
+bool PC9801::macroHostIdle(void)
+{
+    return(KeyInterface::macroHostIdle() && pcCtrl.hostUART.xmitIdle());
+}
+
+// Method to send a repeat when due. Returns the ticks the HID thread can sleep, bounded by the next repeat.
+//
+TickType_t PC9801::processRepeat(void)
+{
+    // Locals.
+    //
+    TickType_t          curTime = xTaskGetTickCount();
+    TickType_t          delay   = pdMS_TO_TICKS(PC9801_HID_POLL_MS);
+
+    if(pcCtrl.host.repeatScan != 0)
+    {
+        if((int32_t)(curTime - pcCtrl.host.repeatNext) >= 0)
+        {
+            pushKeyToQueue(pcCtrl.host.repeatKey);
+
+            // Advance from the due time to hold the cadence, restarting from now if the thread was held off beyond a whole period.
+            pcCtrl.host.repeatNext += pdMS_TO_TICKS(pcCtrl.host.repeatTime);
+            if((int32_t)(curTime - pcCtrl.host.repeatNext) >= 0)
+                pcCtrl.host.repeatNext = curTime + pdMS_TO_TICKS(pcCtrl.host.repeatTime);
+        }
+        if((pcCtrl.host.repeatNext - curTime) < delay)
+            delay = pcCtrl.host.repeatNext - curTime;
+    }
+    return(delay);
+}
+
 // Primary HID thread, running on Core 0.
 // This thread is responsible for receiving HID (PS/2 or BT) keyboard scan codes and mapping them to Sharp PC9801 equivalent keys, updating state flags as needed.
 // The HID data is received via interrupt. The data to be sent to the PC9801 is pushed onto a FIFO queue.
@@ -473,11 +789,15 @@ IRAM_ATTR void PC9801::hidInterface( void * pvParameters )
     // Locals.
     uint16_t            scanCode      = 0x0000;
     uint32_t            pcKey         = 0x00000000;
+    uint8_t             keyCode;
     t_rcvQueueMessage   rcvMsg;
 
     // Map the instantiating object so we can access its methods and data.
     PC9801* pThis = (PC9801*)pvParameters;
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HIDIF);
+
     // Thread never exits, just polls the keyboard and updates the matrix.
     while(1)
     { 
@@ -488,7 +808,7 @@ IRAM_ATTR void PC9801::hidInterface( void * pvParameters )
         }
 
         // Check for HID keyboard scan codes.
-        while((scanCode = pThis->hid->read()) != 0)
+        while((scanCode = pThis->readKey()) != 0)
         {
             // Scan Code Breakdown:
             // Define name bit     description
@@ -513,8 +833,18 @@ IRAM_ATTR void PC9801::hidInterface( void * pvParameters )
             // BREAK code means all keys released so clear out flags and send update.
             ESP_LOGW(MAPKEYTAG, "SCANCODE:%04x",scanCode);
 
+            // Discard a make of a key already held, it is the device typematic, repeats are generated locally at the host rate.
+            keyCode = (scanCode & 0xFF);
+            if((scanCode & PS2_BREAK) == 0 && (pThis->pcCtrl.host.heldKeys[keyCode >> 5] & (1UL << (keyCode & 0x1F))))
+            {
+                continue;
+            }
+
             // Map the PS/2 key to an PC9801 CTRL + KEY
+            pThis->keyMapReadBegin();
             pcKey = pThis->mapKey(scanCode);
+            pThis->keyMapReadEnd();
+            pThis->trackKey(scanCode, pcKey);
             if(pcKey != 0L) { pThis->pushKeyToQueue(pcKey); }
 
             // Toggle LED to indicate data flow.
@@ -523,9 +853,10 @@ IRAM_ATTR void PC9801::hidInterface( void * pvParameters )
         }
 
         // Check for incoming host keyboard commands and execute them.
-        if(xQueueReceive(rcvQueue, (void *)&rcvMsg, 0) == pdTRUE)
+        while(xQueueReceive(rcvQueue, (void *)&rcvMsg, 0) == pdTRUE)
         {
-            ESP_LOGD(MAINTAG, "Received Host Cmd:%02x\n", rcvMsg.hostCmd);
+            ESP_LOGD(MAINTAG, "Received Host Cmd:%02x,%02x\n", rcvMsg.hostCmd, rcvMsg.param);
+            pThis->processHostCmd(rcvMsg.hostCmd, rcvMsg.param);
         }
 
         // NVS writes require both CPU cores to be free so write config out at a known junction.
@@ -554,96 +885,29 @@ IRAM_ATTR void PC9801::hidInterface( void * pvParameters )
             pThis->pcCtrl.persistConfig = false;
         }
 
-        // Yield if the suspend flag is set.
-        pThis->yield(25);
+        // Send any due repeat then yield, waking in time for the next repeat. Yield is held if the suspend flag is set.
+        pThis->yield(pThis->macroPollDelay(pThis->processRepeat()));
     }
 }
 
-// A method to load the keyboard mapping table into memory for use in the interface mapping logic. If no persistence file exists or an error reading persistence occurs, the keymap 
-// uses the internal static default. If no persistence file exists and attempt is made to create it with a copy of the inbuilt static map so that future operations all
-// work with persistence such that modifications can be made.
+// A method to load the keyboard mapping table for use in the interface mapping logic. The inbuilt keymap is used in place from flash and any user changes
+// held in the keymap file are merged with it. A complete keymap file, ie. a browser upload or one saved by earlier firmware, is reduced to the rows which
+// differ from the inbuilt keymap and saved back. The new table is published as a whole, so a reload can take place whilst the HID thread is mapping keys.
 //
 bool PC9801::loadKeyMap(void)
 {
     // Locals.
     //
-    bool        result = false;
-    int         fileRows = 0;
-    struct stat keyMapFileNameStat;
-
-    // See if the file exists, if it does, get size so we can compute number of mapping rows.
-    if(stat(pcCtrl.keyMapFileName.c_str(), &keyMapFileNameStat) == -1)
-    {
-        ESP_LOGW(MAINTAG, "No keymap file, using inbuilt definitions.");
-    } else
-    {
-        // Get number of rows in the file.
-        fileRows = keyMapFileNameStat.st_size/sizeof(t_keyMapEntry);
+    enum KeyMapOverlay::OVERLAY_LOAD result;
 
-        // Subsequent reloads, delete memory prior to building new map, primarily to conserve precious resources rather than trying the memory allocation trying to realloc and then having to copy.
-        if(pcCtrl.kme != NULL && pcCtrl.kme != PS2toPC9801.kme)
-        {
-            delete pcCtrl.kme;
-            pcCtrl.kme = NULL;
-        }
-
-        // Allocate memory for the new keymap table.
-        pcCtrl.kme = new t_keyMapEntry[fileRows];
-        if(pcCtrl.kme == NULL)
-        {
-            ESP_LOGW(MAINTAG, "Failed to allocate memory for keyboard map, fallback to inbuilt!");
-        } else
-        {
-            // Open the keymap extension file for binary reading to add data to our map table.
-            std::fstream keyFileIn(pcCtrl.keyMapFileName.c_str(), std::ios::in | std::ios::binary);
-
-            int idx=0;
-            while(keyFileIn.good())
-            {
-                keyFileIn.read((char *)&pcCtrl.kme[idx], sizeof(t_keyMapEntry));
-                if(keyFileIn.good())
-                {
-                    idx++;
-                }
-            }
-            // Any errors, we wind back and use the inbuilt mapping table.
-            if(keyFileIn.bad())
-            {
-                keyFileIn.close();
-                ESP_LOGW(MAINTAG, "Failed to read data from keymap extension file:%s, fallback to inbuilt!", pcCtrl.keyMapFileName.c_str());
-            } else
-            {
-                // No longer need the file.
-                keyFileIn.close();
-               
-                // Max rows in the KME table.
-                pcCtrl.kmeRows = fileRows;
-
-                // Good to go, map ready for use with the interface.
-                result = true;
-            }
-        }
-    }
-
-    // Any failures, free up memory and use the inbuilt mapping table.
-    if(result == false)
+    result = buildKeyMap(pcCtrl.keyMap, pcCtrl.keyMapFileName, PS2toPC9801.kme, PS2TBL_PC9801_MAXROWS);
+    if(result == KeyMapOverlay::OVERLAY_LOAD_COMPLETE)
     {
-        if(pcCtrl.kme != NULL && pcCtrl.kme != PS2toPC9801.kme)
-        {
-            delete pcCtrl.kme;
-            pcCtrl.kme = NULL;
-        }
-     
-        // No point allocating memory if no extensions exist or an error occurs, just point to the static table.
-        pcCtrl.kme = PS2toPC9801.kme;
-        pcCtrl.kmeRows = PS2TBL_PC9801_MAXROWS;
-
-        // Persist the data so that next load comes from file.
         saveKeyMap();
     }
 
-    // Return code. Either memory map was successfully loaded, true or failed, false.
-    return(result);
+    // Return code. True if user changes were loaded from the keymap file, false if the inbuilt keymap is used as is.
+    return(result != KeyMapOverlay::OVERLAY_LOAD_INBUILT);
 }
 
 // Method to save the current keymap out to an extension file.
@@ -652,36 +916,18 @@ bool PC9801::saveKeyMap(void)
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = pcCtrl.keyMap;
     bool        result = false;
-    int         idx = 0;
 
-    // Has a map been defined? Cannot save unless loadKeyMap has been called which sets pcCtrl.kme to point to the internal keymap or a new memory resident map.
+    // Has a map been defined? Cannot save unless loadKeyMap has been called which publishes the internal keymap or a new memory resident map.
     //
-    if(pcCtrl.kme == NULL)
+    if(keyMap == NULL)
     {
         ESP_LOGW(MAINTAG, "KeyMap hasnt yet been defined, need to call loadKeyMap.");
     } else
     {
-        // Open file for binary writing, trunc specified to clear out the file, we arent appending.
-        std::fstream keyFileOut(pcCtrl.keyMapFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-
-        // Loop whilst no errors and data rows still not written.
-        while(keyFileOut.good() && idx < pcCtrl.kmeRows)
-        {
-            keyFileOut.write((char *)&pcCtrl.kme[idx], sizeof(t_keyMapEntry));
-            idx++;
-        }
-        if(keyFileOut.bad())
-        {
-            ESP_LOGW(MAINTAG, "Failed to write data from the keymap to file:%s, deleting as state is unknown!", pcCtrl.keyMapFileName.c_str());
-            keyFileOut.close();
-            std::remove(pcCtrl.keyMapFileName.c_str());
-        } else
-        {
-            // Success.
-            keyFileOut.close();
-            result = true;
-        }
+        // Write out the rows which differ from the inbuilt keymap.
+        result = saveKeyMapOverlay(keyMap, pcCtrl.keyMapFileName);
     }
    
     // Return code. Either memory map was successfully saved, true or failed, false.
@@ -788,6 +1034,10 @@ bool PC9801::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
             if(std::rename(fileName.c_str(), pcCtrl.keyMapFileName.c_str()) != 0)
             {
                 result = false;
+            } else
+            {
+                // Apply the new keymap immediately, a key being mapped finishes on the old map.
+                loadKeyMap();
             }
         } else
         {
@@ -799,6 +1049,25 @@ bool PC9801::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
     return(result);
 }
 
+// Method to apply row edits from the web editor to the active keymap. The edited keymap is saved as an overlay and reloaded.
+// Returns the rows in the new keymap, -1 if an edit was invalid or the save failed.
+//
+int PC9801::editKeyMap(const std::vector<t_keyMapEdit> &edits)
+{
+    // Locals.
+    //
+    int            result = -1;
+
+    if(editKeyMapRows(pcCtrl.keyMap.load(), pcCtrl.keyMapFileName, edits) == true)
+    {
+        loadKeyMap();
+        result = pcCtrl.keyMap.load()->rows;
+    }
+
+    // Send result.
+    return(result);
+}
+
 // Method to return the keymap column names as header strings.
 //
 void PC9801::getKeyMapHeaders(std::vector<std::string>& headerList)
@@ -901,6 +1170,7 @@ bool PC9801::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool star
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = pcCtrl.keyMap;
     bool      result = false;
 
     // If start flag is set, set row to 0.
@@ -910,19 +1180,19 @@ bool PC9801::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool star
     }
 
     // Bound check and if still valid, push data onto the vector.
-    if((*row) >= pcCtrl.kmeRows)
+    if((*row) >= keyMap->rows)
     {
         result = true;
     } else
     {
-        dataArray.push_back(pcCtrl.kme[*row].ps2KeyCode);
-        dataArray.push_back(pcCtrl.kme[*row].ps2Ctrl);
-        dataArray.push_back(pcCtrl.kme[*row].keyboardModel);
-        dataArray.push_back(pcCtrl.kme[*row].machine);
-   //     dataArray.push_back(pcCtrl.kme[*row].x1Mode);
-   //     dataArray.push_back(pcCtrl.kme[*row].x1Key);
-   //     dataArray.push_back(pcCtrl.kme[*row].x1Key2);
-   //     dataArray.push_back(pcCtrl.kme[*row].x1Ctrl);
+        dataArray.push_back(keyMap->row(*row).ps2KeyCode);
+        dataArray.push_back(keyMap->row(*row).ps2Ctrl);
+        dataArray.push_back(keyMap->row(*row).keyboardModel);
+        dataArray.push_back(keyMap->row(*row).machine);
+   //     dataArray.push_back(keyMap->row(*row).x1Mode);
+   //     dataArray.push_back(keyMap->row(*row).x1Key);
+   //     dataArray.push_back(keyMap->row(*row).x1Key2);
+   //     dataArray.push_back(keyMap->row(*row).x1Ctrl);
         (*row) = (*row) + 1;
     }
 
@@ -953,18 +1223,19 @@ void PC9801::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
         .source_clk                 = UART_SCLK_APB,
     };
 
-    // Install UART driver. Use RX/TX buffers without event queue. 
-    ESP_ERROR_CHECK(uart_driver_install(pcCtrl.uartNum, pcCtrl.uartBufferSize, pcCtrl.uartBufferSize, 0, NULL, 0));
-
-    // Configure UART parameters and pin assignments, software flow control, not RTS/CTS.
-    ESP_ERROR_CHECK(uart_param_config(pcCtrl.uartNum, &uartConfig));
-    ESP_ERROR_CHECK(uart_set_pin(pcCtrl.uartNum, CONFIG_HOST_KDB0, CONFIG_HOST_KDB3, -1, -1));
-
     // Create queue for buffering incoming HID keys prior to transmitting to the PC-9801.
     xmitQueue = xQueueCreate(MAX_PC9801_XMIT_KEY_BUF, sizeof(t_xmitQueueMessage));
+    Metrics::addQueue("xmitQueue", xmitQueue);
     // Create queue for buffering incoming PC-9801 data for later processing.
     rcvQueue  = xQueueCreate(MAX_PC9801_RCV_KEY_BUF, sizeof(t_rcvQueueMessage));
 
+    // Install UART driver with an event queue, configure parameters and pin assignments, software flow control, not RTS/CTS.
+    // The interface thread blocks on the UART events and the key queue together.
+    pcCtrl.hostUART.init((uart_port_t)pcCtrl.uartNum, &uartConfig, CONFIG_HOST_KDB0, CONFIG_HOST_KDB3, pcCtrl.uartBufferSize, pcCtrl.uartQueueSize, xmitQueue, MAX_PC9801_XMIT_KEY_BUF);
+
+    // Key repeat is generated by the interface at the host configured rate, slow the keyboard typematic.
+    hid->setHostRepeat(true);
+
     // Create a task pinned to core 1 which will fulfill the NEC PC-9801 interface. This task has the highest priority
     // and it will also hold spinlock and manipulate the watchdog to ensure a scan cycle timing can be met. This means 
     // all other tasks running on Core 1 will suspend as needed. The HID devices will be serviced with core 0.
@@ -972,12 +1243,13 @@ void PC9801::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     // Core 1 - NEC PC-9801 Interface
     ESP_LOGW(MAINTAG, "Starting NEC PC-9801 if thread...");
     ::xTaskCreatePinnedToCore(&this->pcInterface, "pc9801if", 4096, this, 25, &this->TaskHostIF, 1);
-    vTaskDelay(500);
+    waitReady(KEYIF_READY_HOSTIF);
 
     // Core 0 - Application
     // HID Interface handler thread.
     ESP_LOGW(MAINTAG, "Starting hidIf thread...");
     ::xTaskCreatePinnedToCore(&this->hidInterface, "hidIf", 8192, this, 22, &this->TaskHIDIF, 0);
+    waitReady(KEYIF_READY_HIDIF);
 }
 
 // Initialisation routine without hardware.
@@ -990,9 +1262,16 @@ void PC9801::init(NVS *hdlNVS, HID *hdlHID)
     pcCtrl.uartBufferSize      = 256;
     pcCtrl.uartQueueSize       = 10;
     pcCtrl.keyMapFileName      = pcCtrl.fsPath.append("/").append(PC9801IF_KEYMAP_FILE);
-    pcCtrl.kmeRows             = 0;
-    pcCtrl.kme                 = NULL;
+    pcCtrl.keyMap              = NULL;
     pcCtrl.persistConfig       = false;
+    pcCtrl.link.pendingCmd     = 0x00;
+    pcCtrl.link.leds           = 0x00;
+    pcCtrl.host.repeatDelay    = PC9801_REPEAT_DELAY_DEFAULT;
+    pcCtrl.host.repeatTime     = PC9801_REPEAT_TIME_DEFAULT;
+    pcCtrl.host.repeatScan     = 0;
+    pcCtrl.host.repeatKey      = 0x00000000;
+    pcCtrl.host.repeatNext     = 0;
+    memset(pcCtrl.host.heldKeys, 0x00, sizeof(pcCtrl.host.heldKeys));
 
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
     KeyInterface::init(getClassName(__PRETTY_FUNCTION__), hdlNVS, hdlHID);
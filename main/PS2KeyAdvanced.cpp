@@ -137,6 +137,7 @@
 #include "PS2KeyAdvanced.h"
 #include "PS2KeyCode.h"
 #include "PS2KeyTable.h"
+#include "Metrics.h"
 
 
 // Private function declarations
@@ -172,6 +173,7 @@ volatile uint8_t _ps2mode;          /* _ps2mode contains
 
 /* volatile RX buffers and variables accessed via interrupt functions */
 volatile uint16_t _rx_buffer[ _RX_BUFFER_SIZE ];     // buffer for data from keyboard
+volatile uint32_t _rx_time[ _RX_BUFFER_SIZE ];       // time each byte was received, for latency metrics
 volatile uint8_t _head;              // _head = last byte written
 uint8_t _tail;                       // _tail = last byte read (not modified in IRQ ever)
 volatile int8_t _bytes_expected;
@@ -192,6 +194,9 @@ volatile uint8_t _tx_ready;         // TX status for type of send contains
 
 /* Output key buffering */
 uint16_t _key_buffer[ _KEY_BUFF_SIZE ]; // Output Buffer for translated keys
+uint32_t _key_time[ _KEY_BUFF_SIZE ];   // Time the last byte of each translated key was received
+uint32_t _translate_time;               // Time of the byte last translated
+uint32_t _read_time;                    // Time of the key last read
 uint8_t _key_head;                      // Output buffer WR pointer
 uint8_t _key_tail;                      // Output buffer RD pointer
 uint8_t _mode = 0;            // Mode for output buffer contains
@@ -265,6 +270,7 @@ else
     case 11: // Stop bit lots of spare time now
             if( _parity >= 0xFD )    // had parity error
               {
+              Metrics::count( Metrics::COUNTER_PS2_PARITY );
               send_now( PS2_KC_RESEND );    // request resend
               _tx_ready |= _HANDSHAKE;
               }
@@ -285,8 +291,11 @@ else
                   _rx_buffer[ val ] = uint16_t( _shiftdata );
                   // save extra details
                   _rx_buffer[ val ] |= uint16_t( _ps2mode ) << 8;
+                  _rx_time[ val ] = Metrics::now( );
                   _head = val;
                   }
+                else
+                  Metrics::count( Metrics::COUNTER_PS2_OVERRUN );
                 }
               if( ret & 0x10 )              // Special command to send (ECHO/RESEND)
                 {
@@ -346,10 +355,12 @@ switch( value )
    {
    case 0:      // Buffer overrun Errors Reset modes and buffers
    case PS2_KC_OVERRUN:
+                Metrics::count( Metrics::COUNTER_PS2_OVERRUN );
                 ps2_reset( );
                 state = 0xC;
                 break;
    case PS2_KC_RESEND:   // Resend last byte if we have sent something
+                Metrics::count( Metrics::COUNTER_PS2_RESEND );
                 if( ( _ps2mode & _LAST_VALID ) )
                   {
                   _now_send = _last_sent;
@@ -668,6 +679,7 @@ uint16_t translate( void )
     }
    
     // Get the flags byte break modes etc in this order
+    _translate_time = _rx_time[ index ];
     data = _rx_buffer[ index ] & 0xFF;
     index = ( _rx_buffer[ index ] & 0xFF00 ) >> 8;
 
@@ -1033,6 +1045,7 @@ while( i < ( _KEY_BUFF_SIZE - 1 ) ) // process if not full
       if( idx >= _KEY_BUFF_SIZE )  // loop to front if necessary
         idx = 0;
       _key_buffer[ idx ] = data; // save the data to out buffer
+      _key_time[ idx ] = _translate_time;
       _key_head = idx;
       i++;                      // update count
       }
@@ -1059,6 +1072,7 @@ while( ( result = available( ) ) )
     idx = 0;
   _key_tail = idx;
   result = _key_buffer[ idx ];
+  _read_time = _key_time[ idx ];
 
   // Filter out unwanted control data.
   if((result & 0xFF) != PS2_KC_ACK && (result & 0xFF) != PS2_KC_RESEND && (result & 0xFF) != 0)
@@ -1067,6 +1081,13 @@ while( ( result = available( ) ) )
 return result;
 }
 
+// Method to return the time the key last returned by read was received from the keyboard, for latency metrics.
+//
+uint32_t PS2KeyAdvanced::readTime(void)
+{
+    return(_read_time);
+}
+
 // Method to suspend the keyboard handler and disable the interrupts whilst other non-mutually inclusive tasks make 
 // use of system resources.
 //
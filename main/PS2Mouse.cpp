@@ -55,6 +55,9 @@ PS2Mouse::PS2Mouse(int clockPin, int dataPin)
     ps2Ctrl.dataPin = dataPin;
     ps2Ctrl.supportsIntelliMouseExtensions = false;
     ps2Ctrl.mouseDataCallback = NULL;
+    ps2Ctrl.streamingEnabled = false;
+    streaming.mutex = portMUX_INITIALIZER_UNLOCKED;
+    clearStreaming();
 }
 
 // Destructor - Detach interrupts and free resources.
@@ -190,18 +193,16 @@ IRAM_ATTR void PS2Mouse::ps2interrupt( void )
         // BIT 11 - STOP BIT
         if(pThis->ps2Ctrl.bitCount == 11)
         {
-            // Streaming mode, assemble the data into the buffer.
+            // Streaming mode, assemble the packet and, once complete, coalesce it into the motion accumulator. Packets are summed rather than
+            // overwritten so that no movement is lost when the consumer polls slower than the mouse sample rate.
             if(pThis->ps2Ctrl.streamingEnabled)
             {
-                if(pThis->ps2Ctrl.rxPos == 0 && pThis->streaming.newData == true) pThis->streaming.overrun = true;
-                if(pThis->ps2Ctrl.rxPos == 0) pThis->streaming.mouseData.status     = pThis->ps2Ctrl.shiftReg;
-                if(pThis->ps2Ctrl.rxPos == 1) pThis->streaming.mouseData.position.x = pThis->ps2Ctrl.shiftReg;
-                if(pThis->ps2Ctrl.rxPos == 2) pThis->streaming.mouseData.position.y = pThis->ps2Ctrl.shiftReg;
-                if(pThis->ps2Ctrl.rxPos == 3) pThis->streaming.mouseData.wheel      = pThis->ps2Ctrl.shiftReg;
+                if(pThis->ps2Ctrl.rxPos < 4) pThis->streaming.packet[pThis->ps2Ctrl.rxPos] = pThis->ps2Ctrl.shiftReg;
                 if( (pThis->ps2Ctrl.supportsIntelliMouseExtensions == false && pThis->ps2Ctrl.rxPos == 2) || (pThis->ps2Ctrl.supportsIntelliMouseExtensions == true && pThis->ps2Ctrl.rxPos == 3))
                 {
-                    pThis->streaming.newData         = true;
-                    pThis->streaming.overrun         = false;
+                    portENTER_CRITICAL_ISR(&pThis->streaming.mutex);
+                    pThis->accumulatePacket();
+                    portEXIT_CRITICAL_ISR(&pThis->streaming.mutex);
                     pThis->ps2Ctrl.rxPos             = 0;
                 } else
                 {
@@ -224,6 +225,56 @@ IRAM_ATTR void PS2Mouse::ps2interrupt( void )
     }
 }
 
+// Method, called from the interrupt handler with the streaming mutex held, to sign extend a completed PS/2 movement packet and add it into the
+// streaming accumulator. Buttons are latched so that a press and release occurring between two reads is still seen by the consumer.
+//
+IRAM_ATTR void PS2Mouse::accumulatePacket(void)
+{
+    // Locals.
+    //
+    int32_t            deltaX = (int32_t)streaming.packet[1] - ((streaming.packet[0] & 0x10) ? 256 : 0);
+    int32_t            deltaY = (int32_t)streaming.packet[2] - ((streaming.packet[0] & 0x20) ? 256 : 0);
+    int32_t            deltaW = ps2Ctrl.supportsIntelliMouseExtensions ? (int8_t)streaming.packet[3] : 0;
+
+    // Bit 3 is always set in a valid PS/2 status byte, if it is clear the stream is out of sync so discard the packet.
+    if((streaming.packet[0] & 0x08) == 0)
+    {
+        streaming.overrun = true;
+        return;
+    }
+
+    // Sum the movement, saturating well before the 32bit limit so a consumer which stalls cannot wrap the accumulator.
+    streaming.accX     += deltaX;
+    streaming.accY     += deltaY;
+    streaming.accWheel += deltaW;
+    if(streaming.accX > MAX_PS2_ACCUMULATOR || streaming.accX < -MAX_PS2_ACCUMULATOR || streaming.accY > MAX_PS2_ACCUMULATOR || streaming.accY < -MAX_PS2_ACCUMULATOR)
+    {
+        streaming.accX     = streaming.accX > MAX_PS2_ACCUMULATOR ? MAX_PS2_ACCUMULATOR : streaming.accX < -MAX_PS2_ACCUMULATOR ? -MAX_PS2_ACCUMULATOR : streaming.accX;
+        streaming.accY     = streaming.accY > MAX_PS2_ACCUMULATOR ? MAX_PS2_ACCUMULATOR : streaming.accY < -MAX_PS2_ACCUMULATOR ? -MAX_PS2_ACCUMULATOR : streaming.accY;
+        streaming.overrun  = true;
+    }
+
+    // Record the current buttons and latch any which have been pressed.
+    streaming.buttons         = streaming.packet[0] & 0x07;
+    streaming.buttonsLatched |= streaming.buttons;
+    streaming.newData         = true;
+}
+
+// Method to reset the streaming accumulator, discarding any movement not yet read.
+//
+void PS2Mouse::clearStreaming(void)
+{
+    portENTER_CRITICAL(&streaming.mutex);
+    streaming.accX           = 0;
+    streaming.accY           = 0;
+    streaming.accWheel       = 0;
+    streaming.buttons        = 0;
+    streaming.buttonsLatched = 0;
+    streaming.newData        = false;
+    streaming.overrun        = false;
+    portEXIT_CRITICAL(&streaming.mutex);
+}
+
 // Method to write a byte (control or parameter) to the Mouse. This method encapsulates the protocol necessary
 // to invoke Host -> PS/2 Mouse transmission and the interrupts, on falling clock edge, process the byte to send
 // and bitbang accordingly.
@@ -249,14 +300,8 @@ void PS2Mouse::writeByte(uint8_t command)
         ps2Ctrl.mode    |= _TX_MODE + _PS2_BUSY;
         ps2Ctrl.rxPos    = 0;
 
-        // Initialise the streaming buffer.
-        streaming.mouseData.valid      = false;
-        streaming.mouseData.status     = 0;
-        streaming.mouseData.position.x = 0;
-        streaming.mouseData.position.y = 0;
-        streaming.mouseData.wheel      = 0;
-        streaming.newData              = false;
-        streaming.overrun              = false;
+        // Initialise the streaming accumulator.
+        clearStreaming();
 
         // STOP the interrupt handler - Setting pin output low will cause interrupt before ready
         detachInterrupt( digitalPinToInterrupt( ps2Ctrl.clkPin ) );
@@ -476,9 +521,9 @@ bool PS2Mouse::setStreamMode(void)
 }
 
 // Public methods to enable and disable streaming (constant rate packet transmission from mouse to host).
-// This module accepts the data and updates an in object set which the caller queries. No buffering takes place
-// so should the caller fail to read the data then the arrival of the next packet from the mouse will override
-// the in object values.
+// This module accepts the data and sums it into an in object accumulator which the caller queries. Should the caller
+// read slower than the mouse sample rate, the movement of all packets received since the last read is returned as one
+// coalesced update.
 //
 bool PS2Mouse::enableStreaming(void)
 {
@@ -491,14 +536,8 @@ bool PS2Mouse::enableStreaming(void)
     {
         if(sendCmd(MOUSE_CMD_ENABLE_STREAMING, 0, respBuf, DEFAULT_MOUSE_TIMEOUT))
         {
-            // Initialise the streaming buffer.
-            streaming.mouseData.valid      = false;
-            streaming.mouseData.status     = 0;
-            streaming.mouseData.position.x = 0;
-            streaming.mouseData.position.y = 0;
-            streaming.mouseData.wheel      = 0;
-            streaming.newData              = false;
-            streaming.overrun              = false;
+            // Initialise the streaming accumulator.
+            clearStreaming();
             ps2Ctrl.streamingEnabled       = true;
         }
     }
@@ -589,18 +628,30 @@ PS2Mouse::MouseData PS2Mouse::readData(void)
     MouseData           data;
     uint8_t             dataBuf[8] = {0,0,0,0,0,0,0,0};
 
-    // If streaming mode enabled then set values according to data state. Data only valid if a new update has occurred since last call otherwise old data is returned and valid flag
-    // is cleared.
+    // If streaming mode enabled then return the movement accumulated since the last call. Data only valid if at least one packet has arrived since the
+    // last call otherwise the valid flag is cleared. The accumulator is reset atomically so packets arriving during the read are carried to the next call.
     if(ps2Ctrl.streamingEnabled)
     {
-        data.valid         = streaming.newData;
-        data.overrun       = streaming.overrun;
-        data.status        = streaming.mouseData.status;
-        data.position.x    = streaming.mouseData.position.x;
-        data.position.y    = streaming.mouseData.position.y;
-        data.wheel         = ps2Ctrl.supportsIntelliMouseExtensions ? streaming.mouseData.wheel : 0;
-        streaming.newData  = false;
-        streaming.overrun  = false;
+        portENTER_CRITICAL(&streaming.mutex);
+        data.valid                = streaming.newData;
+        data.overrun              = streaming.overrun;
+        data.status               = streaming.buttonsLatched | 0x08;
+        data.position.x           = streaming.accX;
+        data.position.y           = streaming.accY;
+        data.wheel                = ps2Ctrl.supportsIntelliMouseExtensions ? streaming.accWheel : 0;
+        streaming.accX            = 0;
+        streaming.accY            = 0;
+        streaming.accWheel        = 0;
+        streaming.buttonsLatched  = streaming.buttons;
+        streaming.overrun         = false;
+        // A button released since the last read was reported as pressed, the next read reports the release even if there is no movement.
+        streaming.newData         = (data.status & 0x07) != streaming.buttons;
+        portEXIT_CRITICAL(&streaming.mutex);
+
+        // Sign bits are recreated from the summed movement so the status byte stays consistent with the PS/2 packet format. Overflow bits are
+        // never set as the accumulator is wide enough to hold the full movement.
+        if(data.position.x < 0) data.status |= 0x10;
+        if(data.position.y < 0) data.status |= 0x20;
 
         // If a data callback has been setup execute it otherwise data is read by caller.
         //
@@ -615,9 +666,9 @@ PS2Mouse::MouseData PS2Mouse::readData(void)
             data.valid      = true;
             data.overrun    = false;
             data.status     = dataBuf[0];
-            data.position.x = dataBuf[1];
-            data.position.y = dataBuf[2];
-            data.wheel      = ps2Ctrl.supportsIntelliMouseExtensions ? dataBuf[3] : 0;
+            data.position.x = (int)dataBuf[1] - ((dataBuf[0] & 0x10) ? 256 : 0);
+            data.position.y = (int)dataBuf[2] - ((dataBuf[0] & 0x20) ? 256 : 0);
+            data.wheel      = ps2Ctrl.supportsIntelliMouseExtensions ? (int8_t)dataBuf[3] : 0;
         } else
         {
             data.valid      = false;
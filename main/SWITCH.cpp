@@ -10,6 +10,7 @@
 //
 // History:         May 2022 - Initial write.
 //            v1.00 Jun 2022 - Updates to add additional callbacks for RESET and CLEARNVS
+//            v1.01 Oct 2026 - Switch edges are interrupt driven and press duration is timed in milli-seconds.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -43,19 +44,78 @@
 #include "soc/timer_group_struct.h"
 #include "soc/timer_group_reg.h"
 #include "driver/timer.h"
+#include "esp_timer.h"
 #include "sdkconfig.h"
 #include "SWITCH.h"
 
+// LED feedback given whilst the switch is held, each stage indicates the action which will be taken if the switch is released.
+static const struct {
+    uint32_t                heldMs;
+    enum LED::LED_MODE      mode;
+    enum LED::LED_DUTY_CYCLE dutyCycle;
+    uint32_t                maxBlinks;
+    uint64_t                usDutyPeriod;
+    uint64_t                msInterPeriod;
+} swLEDStages[] = {
+    { SWITCH_WIFIEN_MIN_MS,    LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_50, 1, 50000L, 500L  },      // Entering WiFi enable mode.
+    { SWITCH_WIFIDEF_MIN_MS,   LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_30, 1, 25000L, 250L  },      // Enter default AP mode.
+    { SWITCH_BTPAIRING_MIN_MS, LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_10, 1, 10000L, 100L  },      // Enter BT pairing mode.
+    { SWITCH_CLEARNVS_MIN_MS,  LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_80, 5, 10000L, 1000L },      // Enter Clear NVS settings mode.
+};
+
+// Method to classify a completed press by the time, in milli-seconds, the switch was held. Presses falling between two bands are
+// ignored so the user has a margin to release the switch once the LED indicates the required mode.
+enum SWITCH::SWITCH_EVENT SWITCH::classifyPress(uint32_t heldMs)
+{
+    // Locals.
+    //
+    enum SWITCH_EVENT   event = SWITCH_EVENT_NONE;
+
+    if(heldMs >= SWITCH_CANCEL_MIN_MS && heldMs < SWITCH_WIFIEN_MIN_MS)
+        event = SWITCH_EVENT_CANCEL;
+    else if(heldMs > SWITCH_WIFIEN_MIN_MS && heldMs < SWITCH_WIFIEN_MAX_MS)
+        event = SWITCH_EVENT_WIFIEN;
+    else if(heldMs > SWITCH_WIFIDEF_MIN_MS && heldMs < SWITCH_BTPAIRING_MIN_MS)
+        event = SWITCH_EVENT_WIFIDEF;
+    else if(heldMs >= SWITCH_BTPAIRING_MIN_MS && heldMs < SWITCH_CLEARNVS_MIN_MS)
+        event = SWITCH_EVENT_BTPAIRING;
+    else if(heldMs >= SWITCH_CLEARNVS_MIN_MS)
+        event = SWITCH_EVENT_CLEARNVS;
+
+    return(event);
+}
+
+// Interrupt handler for either edge of the config/WiFi switch. Wakes the SWITCH thread which debounces and times the press.
+IRAM_ATTR void SWITCH::swEdgeInterrupt(void *pvParameters)
+{
+    // Locals.
+    //
+    SWITCH             *pThis = (SWITCH *)pvParameters;
+    BaseType_t          taskWoken = pdFALSE;
+
+    vTaskNotifyGiveFromISR(pThis->swCtrl.TaskSWIF, &taskWoken);
+    if(taskWoken == pdTRUE)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
 // Primary SWITCH thread, running on Core 0.
-// This thread is responsible for scanning the config/WiFi key on the SharpKey and generating callbacks according to state.
+// This thread is responsible for timing presses of the config/WiFi key on the SharpKey and generating callbacks according to state.
+// It blocks until the switch edge interrupt wakes it, whilst the switch is held it also wakes at each LED feedback stage.
 //
 IRAM_ATTR void SWITCH::swInterface( void * pvParameters )
 {
     // Locals.
     //
-    uint32_t          keyDebCtr     = 0;
     uint32_t          WIFIEN_MASK   = (1 << (CONFIG_IF_WIFI_EN_KEY - 32));
     uint32_t          resetTimer    = 0;
+    uint32_t          pressTime     = 0;
+    uint32_t          curTime;
+    uint32_t          heldTime;
+    uint32_t          ledStage      = 0;
+    bool              pressed       = false;
+    TickType_t        waitTicks;
     #define           WIFIIFTAG       "swInterface"
 
     // Map the instantiating object so we can access its methods and data.
@@ -64,114 +124,117 @@ IRAM_ATTR void SWITCH::swInterface( void * pvParameters )
     // Loop indefinitely.
     while(true)
     {
+        curTime = pThis->milliSeconds();
+
         // Check the switch, has it gone to zero, ie. pressed?
         //
         if((REG_READ(GPIO_IN1_REG) & WIFIEN_MASK) == 0)
         {
             // First press detection turn LED off.
-            if(keyDebCtr == 0)
+            if(pressed == false)
             {
                 pThis->led->setLEDMode(LED::LED_MODE_OFF, LED::LED_DUTY_CYCLE_OFF, 0, 0L, 0L);
+                pressTime = curTime;
+                ledStage  = 0;
+                pressed   = true;
             }
-            // Entering WiFi enable mode, blink LED 
-            if(keyDebCtr == 10)
-            {
-                pThis->led->setLEDMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_50, 1, 50000L, 500L);
-            }
-            // Enter default AP mode.
-            if(keyDebCtr == 50)
-            {
-                pThis->led->setLEDMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_30, 1, 25000L, 250L);
-            }
-            // Enter BT pairing mode.
-            if(keyDebCtr == 100)
-            {
-                pThis->led->setLEDMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_10, 1, 10000L, 100L);
-            }
-            // Enter Clear NVS settings mode.
-            if(keyDebCtr == 150)
+
+            // Indicate, via the LED, the mode selected by the current hold time.
+            heldTime = curTime - pressTime;
+            while(ledStage < NUMELEM(swLEDStages) && heldTime >= swLEDStages[ledStage].heldMs)
             {
-                pThis->led->setLEDMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_80, 5, 10000L, 1000L);
+                pThis->led->setLEDMode(swLEDStages[ledStage].mode, swLEDStages[ledStage].dutyCycle, swLEDStages[ledStage].maxBlinks, swLEDStages[ledStage].usDutyPeriod, swLEDStages[ledStage].msInterPeriod);
+                ledStage++;
             }
-            // Increment counter so we know how long it has been held.
-            keyDebCtr++;
         } else
-        if((REG_READ(GPIO_IN1_REG) & WIFIEN_MASK) != 0 && keyDebCtr > 1)
+        if(pressed == true)
         {
-            // On first 1/2 second press, if WiFi active, disable and reboot.
-            if(keyDebCtr > 1 && keyDebCtr < 10)
+            pressed = false;
+
+            switch(classifyPress(curTime - pressTime))
             {
-                // If a cancel callback has been setup, invoke it.
-                //
-                if(pThis->swCtrl.cancelEventCallback != NULL)
-                    pThis->swCtrl.cancelEventCallback();
-
-                // If the reset timer is running then a previous button press occurred. If it is less than 1 second then a RESET event
-                // is required.
-                if(resetTimer != 0 && (pThis->milliSeconds() - resetTimer) < 1000L)
-                {
-                    // If a handler is installed call it. If the return value is true then a restart is possible. No handler then we just restart.
-                    if(pThis->swCtrl.resetEventCallback != NULL)
+                // On a short press, if WiFi active, disable and reboot.
+                case SWITCH_EVENT_CANCEL:
+                    // If a cancel callback has been setup, invoke it.
+                    //
+                    if(pThis->swCtrl.cancelEventCallback != NULL)
+                        pThis->swCtrl.cancelEventCallback();
+
+                    // If a previous short press occurred within the reset window then a RESET event is required.
+                    if(resetTimer != 0 && (curTime - resetTimer) < SWITCH_RESET_WINDOW_MS)
                     {
-                        if(pThis->swCtrl.resetEventCallback())
+                        // If a handler is installed call it. If the return value is true then a restart is possible. No handler then we just restart.
+                        if(pThis->swCtrl.resetEventCallback != NULL)
+                        {
+                            if(pThis->swCtrl.resetEventCallback())
+                                esp_restart();
+                        } else
                             esp_restart();
                     } else
-                        esp_restart();
-                } else
-                {
-                    resetTimer = pThis->milliSeconds();
-                }
-            }
-            // If counter is in range 1 to 4 seconds then assume a WiFi on (so long as the client parameters have been configured).
-            else if(keyDebCtr > 10 && keyDebCtr < 40)
-            {
-                // If a wifi enable callback has been setup, invoke it.
-                //
-                if(pThis->swCtrl.wifiEnEventCallback != NULL)
-                    pThis->swCtrl.wifiEnEventCallback();
-            }
-            // If the key is held for 5 or more seconds, then enter Wifi Config Default AP mode.
-            else if(keyDebCtr > 50 && keyDebCtr < 100)
-            {
-                // If a wifi default enable callback has been setup, invoke it.
-                //
-                if(pThis->swCtrl.wifiDefEventCallback != NULL)
-                    pThis->swCtrl.wifiDefEventCallback();
-            } 
-            // If the key is held for 10 seconds or more, invoke Bluetooth pairing mode.
-            else if(keyDebCtr >= 100 && keyDebCtr < 150)
-            {
-                // If a bluetooth start pairing callback has been setup, invoke it.
-                //
-                if(pThis->swCtrl.btPairingEventCallback != NULL)
-                    pThis->swCtrl.btPairingEventCallback();
-            }
-            // If the key is held for 15 seconds or more, invoke the clear NVS settings (factory) mode.
-            else if(keyDebCtr >= 150)
-            {
-                // If a clear NVS handler has been installed, call it.
-                //
-                if(pThis->swCtrl.clearNVSEventCallback != NULL)
-                    pThis->swCtrl.clearNVSEventCallback();
+                    {
+                        resetTimer = curTime;
+                    }
+                    break;
+
+                // Held 1 to 4 seconds then assume a WiFi on (so long as the client parameters have been configured).
+                case SWITCH_EVENT_WIFIEN:
+                    // If a wifi enable callback has been setup, invoke it.
+                    //
+                    if(pThis->swCtrl.wifiEnEventCallback != NULL)
+                        pThis->swCtrl.wifiEnEventCallback();
+                    break;
+
+                // Held for 5 or more seconds, then enter Wifi Config Default AP mode.
+                case SWITCH_EVENT_WIFIDEF:
+                    // If a wifi default enable callback has been setup, invoke it.
+                    //
+                    if(pThis->swCtrl.wifiDefEventCallback != NULL)
+                        pThis->swCtrl.wifiDefEventCallback();
+                    break;
+
+                // Held for 10 seconds or more, invoke Bluetooth pairing mode.
+                case SWITCH_EVENT_BTPAIRING:
+                    // If a bluetooth start pairing callback has been setup, invoke it.
+                    //
+                    if(pThis->swCtrl.btPairingEventCallback != NULL)
+                        pThis->swCtrl.btPairingEventCallback();
+                    break;
+
+                // Held for 15 seconds or more, invoke the clear NVS settings (factory) mode.
+                case SWITCH_EVENT_CLEARNVS:
+                    // If a clear NVS handler has been installed, call it.
+                    //
+                    if(pThis->swCtrl.clearNVSEventCallback != NULL)
+                        pThis->swCtrl.clearNVSEventCallback();
+                    break;
+
+                // Bounce or a release between bands, nothing to do.
+                case SWITCH_EVENT_NONE:
+                default:
+                    break;
             }
            
             // LED off, no longer needed.
             pThis->led->setLEDMode(LED::LED_MODE_OFF, LED::LED_DUTY_CYCLE_OFF, 0, 0L, 0L);
-
-            // Re-init switch variables for next activation.
-            keyDebCtr = 0;
         }
-      
-        // Reset the reset timer if not activated.
-        if(resetTimer != 0 && (pThis->milliSeconds() - resetTimer) > 2000L) { resetTimer = 0; }
 
-        // Let other tasks run. NB. This value affects the debounce counter, update as necessary.
-        vTaskDelay(100);
+        // When idle, block until the switch changes state. Whilst held, also wake at the next LED feedback stage.
+        waitTicks = portMAX_DELAY;
+        if(pressed == true && ledStage < NUMELEM(swLEDStages))
+        {
+            waitTicks = pdMS_TO_TICKS(swLEDStages[ledStage].heldMs - (curTime - pressTime)) + 1;
+        }
+        if(ulTaskNotifyTake(pdTRUE, waitTicks) > 0)
+        {
+            // Edge seen, let the contacts settle before sampling and discard the edges caused by bounce.
+            vTaskDelay(pdMS_TO_TICKS(SWITCH_DEBOUNCE_MS));
+            ulTaskNotifyTake(pdTRUE, 0);
+        }
     }
     return;
 }
 
-// Initialisation routine. Setup variables and spawn a task to monitor the config switch.
+// Initialisation routine. Setup variables, spawn a task to time the config switch and attach the edge interrupt which wakes it.
 // 
 void SWITCH::init(void)
 {
@@ -182,7 +245,15 @@ void SWITCH::init(void)
     // SWITCH handler thread.
     ESP_LOGW(SWINITTAG, "Starting SWITCH thread...");
     ::xTaskCreatePinnedToCore(&this->swInterface, "switch", 4096, this, 0, &this->swCtrl.TaskSWIF, 0);
-    vTaskDelay(1500);
+
+    // Interrupt on both edges of the switch. The ISR service may already be installed by another driver, that is not an error.
+    ESP_ERROR_CHECK(gpio_set_intr_type((gpio_num_t)CONFIG_IF_WIFI_EN_KEY, GPIO_INTR_ANYEDGE));
+    esp_err_t isrResult = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if(isrResult != ESP_OK && isrResult != ESP_ERR_INVALID_STATE)
+    {
+        ESP_ERROR_CHECK(isrResult);
+    }
+    ESP_ERROR_CHECK(gpio_isr_handler_add((gpio_num_t)CONFIG_IF_WIFI_EN_KEY, &SWITCH::swEdgeInterrupt, this));
 }
 
 // Basic constructor, init variables!
@@ -50,6 +50,26 @@
 //                             immediately starts up in WiFi mode without enabling BT or hardware I/F.
 //                             This is necessary due to shared antenna in the ESP32 and also clashes
 //                             in the IDF library stack.
+//            v1.05 Oct 2026 - Fast boot, detected host type cached in NVS and confirmed by a short probe,
+//                             boot timeline trace of each start up stage.
+//            v1.06 Oct 2026 - Host detection measures signal edges with the pulse counter over a fixed window,
+//                             classification moved into HostDetect.
+//                             Mode switches between interface and WiFi hand the host type over in RTC
+//                             memory, skipping detection, and are actioned as soon as requested.
+//            v1.07 Oct 2026 - Runtime metrics of the interface sampled into RTC memory for the web interface.
+//            v1.08 Oct 2026 - Removed the fixed PC-9801 host type left from development, now a Debug Option.
+//                             Cached host type checked against the feature security, configuration saved
+//                             before the cache was added is migrated.
+//            v1.09 Oct 2026 - Mode switch round trip, interface to WiFi and back, logged on return to the
+//                             interface.
+//            v1.10 Oct 2026 - WiFi mode reads a PS/2 keyboard so keys can be shown live with their mapping.
+//            v1.11 Oct 2026 - Mode switch made in place for hosts which allow it, the interface and Bluetooth are
+//                             suspended, WiFi runs from heap reserved at boot and on exit the interface
+//                             resumes. A restart is still used after an update or when the reserve failed.
+//            v1.12 Oct 2026 - A cached host type no longer skips the KDB0 count. The count ends as soon as it
+//                             decides the host, a cached X68000 after a short quiet probe.
+//            v1.13 Oct 2026 - In place mode switch withdrawn until it has been built and tested on a device, a
+//                             switch to WiFi restarts with the host handoff.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -76,6 +96,7 @@
 #include <iostream>
 #include <vector>
 #include <iterator>
+#include <sys/time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
@@ -87,6 +108,8 @@
 #include "nvs.h"
 #include "Arduino.h"
 #include "driver/gpio.h"
+#include "driver/pcnt.h"
+#include "esp_timer.h"
 #include "soc/timer_group_struct.h"
 #include "soc/timer_group_reg.h"
 #include "soc/soc.h"
@@ -101,6 +124,10 @@
 #include "HID.h"
 #include "NVS.h"
 #include "WiFi.h"
+#include "TimerService.h"
+#include "BootTrace.h"
+#include "Metrics.h"
+#include "HostDetect.h"
 
 //////////////////////////////////////////////////////////////////////////
 // Important:
@@ -111,7 +138,7 @@
 
 // Constants.
 #define SHARPKEY_NAME                  "SharpKey"
-#define SHARPKEY_VERSION               1.04
+#define SHARPKEY_VERSION               1.13
 #define SHARPKEY_MODULES               "SharpKey MZ2528 X1 X68K MZ5665 PC9801 Mouse KeyInterface HID NVS LED SWITCH WiFi FilePack"
 
 // Tag for ESP main application logging.
@@ -121,14 +148,47 @@
 #define LITTLEFS_DEFAULT_PATH          "/littlefs"
 #define LITTLEFS_DEFAULT_PARTITION     "filesys"
 
+// Marks a host signature as valid, a zero signature is never cached.
+#define HOST_SIGNATURE_VALID           0x80000000
+
 // Structure for configuration information stored in NVS.
 struct SharpKeyConfig {
     struct {
         uint8_t                 bootMode;               // Flag to indicate the mode SharpKey should boot into.
                                                         // 0 = Interface, 1 = WiFi (configured), 2 = WiFi (default).
+        uint32_t                hostIfMode;             // Host type detected on a previous boot, 0 = none.
+        uint32_t                hostSignature;          // Static host line levels seen with hostIfMode, must match to reuse it.
     } params;
 } sharpKeyConfig;
 
+// Layout of the configuration persisted before the host type cache was added, recognised by its size and migrated.
+struct SharpKeyConfigV1 {
+    struct {
+        uint8_t                 bootMode;
+    } params;
+};
+
+// Marks a valid mode switch handoff in RTC memory, which is random after power on.
+#define MODE_HANDOFF_MAGIC             0x534B4D48
+#define MODE_HANDOFF_TO_WIFI           1
+#define MODE_HANDOFF_TO_INTERFACE      2
+
+// Handoff written just before a restart between interface and WiFi modes. RTC memory survives a software restart but not a power cycle,
+// so a valid record means the host is unchanged and its detection can be skipped.
+typedef struct {
+    uint32_t                    magic;
+    uint32_t                    direction;              // Mode being switched to.
+    uint32_t                    ifMode;                 // Host type of the boot which requested the switch.
+    int64_t                     requestTimeUs;          // System time when the switch was requested, the RTC keeps it running across the restart.
+    int64_t                     priorSwitchUs;          // Time taken by the switch into the mode now being left, 0 if it was not a switch.
+} t_modeHandoff;
+RTC_NOINIT_ATTR t_modeHandoff   modeHandoff;
+
+// Host type in use and the main task, which the switch callbacks notify so a mode change is actioned without waiting on the poll.
+uint32_t                        runIfMode = 0;
+int64_t                         runSwitchUs = 0;        // Time taken by the mode switch which started this boot, 0 if not a switch.
+TaskHandle_t                    mainTask  = NULL;
+
 // Overloads for the EFUSE Custom MAC definitions. Limited Efuse space and Custom MAC not needed in eFuse in this design
 // so we overload with custom flags.
 // 0-7 Reserved
@@ -403,8 +463,9 @@ void startWiFi(NVS &nvs, LED *led, bool defaultMode, uint32_t ifMode)
     }
     keyIf = NULL;
 
-    // Create a basic hid object for config persistence and retrieval.
-    hid = new HID(&nvs);
+    // Create the hid object for config persistence and retrieval. Keyboard hosts also read a PS/2 keyboard so keys typed can be shown with their
+    // mapping as the keymap is edited, Bluetooth cannot be used alongside WiFi.
+    hid = (ifMode == 2 ? new HID(&nvs) : new HID(HID::HID_DEVICE_TYPE_PS2_KEYBOARD, &nvs, led, NULL));
 
     // Create basic host interface objects without hardware configuration. This is needed as the WiFi object probes them for configuration parameters and to update
     // the parameters.
@@ -472,6 +533,12 @@ void startWiFi(NVS &nvs, LED *led, bool defaultMode, uint32_t ifMode)
         keyIf->reconfigADC2Ports(true);
     }
    
+    // Keys are mapped for the live channel, the option keys of an interface drive the LED.
+    if(keyIf != NULL)
+    {
+        keyIf->led = led;
+    }
+
     // Create a new WiFi object.
     wifi = new WiFi(keyIf, mouseIf, defaultMode, &nvs, led, LITTLEFS_DEFAULT_PATH, versionList);
 
@@ -480,74 +547,113 @@ void startWiFi(NVS &nvs, LED *led, bool defaultMode, uint32_t ifMode)
 }
 #endif
 
-// Method to determine which host the SharpKey is connected to. This is done by examining the host I/O for tell tale signals
-// or inputs wired in a fixed combination.
+#if defined(CONFIG_SHARPKEY)
+// Method to attach a pulse counter unit to a host signal, counting rising edges only. The counter is left cleared and paused.
+// No glitch filter is applied, MZ-2500 strobes are only a few hundred nano-seconds wide.
 //
-uint32_t getHostType(bool eFuseInvalid, t_EFUSE sharpkeyEfuses)
+static void hostSignalAttach(pcnt_unit_t unit, int gpio)
 {
     // Locals.
     //
-    uint32_t                 RTSNI_MASK = (1 << (CONFIG_HOST_RTSNI - 32));
-    uint32_t                 MPXI_MASK  = (1 << CONFIG_HOST_MPXI);
-    uint32_t                 KDB0_MASK  = (1 << CONFIG_HOST_KDB0);
-  //uint32_t                 KDB1_MASK  = (1 << CONFIG_HOST_KDB1);
-  //uint32_t                 KDB2_MASK  = (1 << CONFIG_HOST_KDB2);
-  //uint32_t                 KDB3_MASK  = (1 << CONFIG_HOST_KDB3);
+    pcnt_config_t pcntConfig = {
+        .pulse_gpio_num = gpio,
+        .ctrl_gpio_num  = PCNT_PIN_NOT_USED,
+        .lctrl_mode     = PCNT_MODE_KEEP,
+        .hctrl_mode     = PCNT_MODE_KEEP,
+        .pos_mode       = PCNT_COUNT_INC,
+        .neg_mode       = PCNT_COUNT_DIS,
+        .counter_h_lim  = 32767,
+        .counter_l_lim  = 0,
+        .unit           = unit,
+        .channel        = PCNT_CHANNEL_0,
+    };
+    pcnt_unit_config(&pcntConfig);
+    pcnt_filter_disable(unit);
+    pcnt_counter_pause(unit);
+    pcnt_counter_clear(unit);
+}
+
+// Method to read the edges counted by a pulse counter unit.
+//
+static uint32_t hostSignalEdges(pcnt_unit_t unit)
+{
+    // Locals.
+    //
+    int16_t       count = 0;
+
+    pcnt_get_counter_value(unit, &count);
+    return(count < 0 ? 0 : (uint32_t)count);
+}
+
+// Method to release a pulse counter unit from its host signal.
+//
+static void hostSignalDetach(pcnt_unit_t unit)
+{
+    pcnt_counter_pause(unit);
+    pcnt_set_pin(unit, PCNT_CHANNEL_0, PCNT_PIN_NOT_USED, PCNT_PIN_NOT_USED);
+}
+#endif
+
+// Method to determine which host the SharpKey is connected to. Rising edges on MPX, RTSN and KDB0 are counted in parallel by the
+// pulse counter over a fixed window, the X1 loopback and static line levels are sampled and the result classified by HostDetect.
+// The Mouse control line can pulse slowly so, if the host is neither a matrix host nor an X1, KDB0 is counted over an extended
+// window which ends once the count decides the host. If the static line signature matches the cached host, a cached X68000 is
+// confirmed by a shorter quiet probe. The signature is 0 when not applicable.
+//
+uint32_t getHostType(bool eFuseInvalid, t_EFUSE sharpkeyEfuses, uint32_t cachedIfMode, uint32_t cachedSignature, uint32_t &hostSignature)
+{
+    // No signature unless the extended window applies.
+    hostSignature = 0;
 
   // Build selectable target. This software can be built to run on the SharpKey or mz25key interfaces. If a resistor is connected from MPX input to the ESP32 IO12 pin 14 then
   // the SharpKey build can be used even though the mz25key only supports one target at a time. If no resistor is connected then you will need to build for a specific target
   // as the detection logic will not be able to determine if it is connected to an MZ-2500 or MZ-2800. Use menuconfig to select the target.
   #ifdef CONFIG_SHARPKEY
-
-    // Connected host detection. 
-    //
-    // MZ-2800 - RTSN Goes High and Low, MPX goes High and Low. RTSN, depending upon the machine mode may only oscillate a few times per second, so need to count
-    //           MPX pulses to determine MZ-2800 mode.
-    // MZ-2500 - RTSN Goes High and Low. MPX goes High and Low. On the falling edge of RTSN sample MPX 50ns in, if it is high then
-    //           select MZ-2500 mode.
-    // X1      - Output 1010 onto KDO[3:0] and read KDB[3:0] - if match then X1 mode.
-    // X68000  = KD4 = low,  MPX = low, RTSN = high
-    // Mouse   = KD4 = high, MPX = low, RTSN = high
-    //
-    // NB: The above tests ASSUME the interface is plugged into the host, only powered by the host and the host is switched on. Development cycles where the interface 
-    //     is powered by the UART adapter and/or the host is switched off will not detect the correct host.
+    // Locals.
     //
-    // First up, sample RTSN and MPX to see if they are alternating. The ratio of RTSN to MPX will yield the type of host.
-    uint32_t cntRTSN = 0;
-    uint32_t cntMPX  = 0;
-    uint32_t ifMode  = 0;
-    volatile uint32_t gpioIN, gpioINLast;
-    gpioIN = gpioINLast = REG_READ(GPIO_IN_REG);
-    for(uint32_t idx=0; idx < 400; idx++)
-    {
-        gpioIN = REG_READ(GPIO_IN_REG);
-        if((gpioIN & MPXI_MASK) && (gpioIN & MPXI_MASK) != (gpioINLast & MPXI_MASK))  cntMPX++;
-        gpioINLast = gpioIN;
-    }
-    gpioIN = gpioINLast = REG_READ(GPIO_IN1_REG);
-    for(uint32_t idx=0; idx < 400; idx++)
+    uint32_t                 RTSNI_MASK = (1 << (CONFIG_HOST_RTSNI - 32));
+    uint32_t                 MPXI_MASK  = (1 << CONFIG_HOST_MPXI);
+    uint32_t                 ifMode     = 0;
+    uint32_t                 allowed    = 0;
+    uint32_t                 gpioIN;
+    int64_t                  startTime;
+    HostDetect::t_hostSignals signals;
+
+    // Host types permitted by the feature security.
+    if(eFuseInvalid == false)
     {
-        gpioIN = REG_READ(GPIO_IN1_REG);
-        if((gpioIN & RTSNI_MASK) && (gpioIN & RTSNI_MASK) != (gpioINLast & RTSNI_MASK)) cntRTSN++;
-        gpioINLast = gpioIN;
+        allowed = sharpkeyEfuses.disableRestrictions == true ? HOSTDETECT_ALLOW_ALL :
+                  (sharpkeyEfuses.enableMZ2500 == true ? HOSTDETECT_ALLOW_MZ2500 : 0) | (sharpkeyEfuses.enableMZ2800 == true ? HOSTDETECT_ALLOW_MZ2800 : 0) |
+                  (sharpkeyEfuses.enableX1     == true ? HOSTDETECT_ALLOW_X1     : 0) | (sharpkeyEfuses.enableX68000 == true ? HOSTDETECT_ALLOW_X68000 : 0) |
+                  (sharpkeyEfuses.enableMouse  == true ? HOSTDETECT_ALLOW_MOUSE  : 0);
     }
 
-    // If RTSN and MPX are alternating then the number identifies the host, the MZ-2500 has 1 RTSN per 1 MPX repeating every 1.2uS whereas 
-    // the MZ-2800 has 1 RTSN per ~14 or more MPX cycles albeit there are periods of 1ms where no activity can be seen.
-    if(cntMPX > 1)
-    {
-        if(cntRTSN > 20 && cntMPX > 20 && eFuseInvalid == false && (sharpkeyEfuses.disableRestrictions == true || sharpkeyEfuses.enableMZ2500 == true))
-            ifMode = 2500;
-
-        // RTSN may not oscillate in the small capture window depending on run mode, so check MPX and if it is oscillating, at a lower rate than the MZ-2500, select MZ-2800 mode.
-        else if(cntMPX > 5 && eFuseInvalid == false && (sharpkeyEfuses.disableRestrictions == true || sharpkeyEfuses.enableMZ2800 == true))
-            ifMode = 2800;
-
-        if(ifMode > 0)
-            ESP_LOGW(MAINTAG, "Detected MZ-%d host, counts:RTSN=%d, MPX=%d.", ifMode, cntRTSN, cntMPX);
-    } else
+    // Connected host detection.
+    //
+    // NB: The tests ASSUME the interface is plugged into the host, only powered by the host and the host is switched on. Development cycles where the interface 
+    //     is powered by the UART adapter and/or the host is switched off will not detect the correct host.
+    //
+    // Count MPX, RTSN and KDB0 edges in parallel over the same window. The pulse counter enables the input pull-up, which KDB0 needs to
+    // see the X68000 TxD or Mouse MSCTRL pulses.
+    memset((void *)&signals, 0x00, sizeof(HostDetect::t_hostSignals));
+    hostSignalAttach(PCNT_UNIT_0, CONFIG_HOST_MPXI);
+    hostSignalAttach(PCNT_UNIT_1, CONFIG_HOST_RTSNI);
+    hostSignalAttach(PCNT_UNIT_2, CONFIG_HOST_KDB0);
+    startTime = esp_timer_get_time();
+    pcnt_counter_resume(PCNT_UNIT_0);
+    pcnt_counter_resume(PCNT_UNIT_1);
+    pcnt_counter_resume(PCNT_UNIT_2);
+    delayMicroseconds(HOSTDETECT_WINDOW_US);
+    pcnt_counter_pause(PCNT_UNIT_0);
+    pcnt_counter_pause(PCNT_UNIT_1);
+    signals.windowUs  = (uint32_t)(esp_timer_get_time() - startTime);
+    signals.mpxEdges  = hostSignalEdges(PCNT_UNIT_0);
+    signals.rtsnEdges = hostSignalEdges(PCNT_UNIT_1);
+
+    // Check for X1 - this is accomplished by writing a value to KDO and reading it back on KDB. This works because RTSN is tied low on the X1 cable as the X1 protocol is output only.
+    // Not performed on a matrix host as KDO carries its key data.
+    if(HostDetect::isMatrixHost(signals) == false)
     {
-        // Check for X1 - this is accomplished by writing a value to KDO and reading it back on KDB. This works because RTSN is tied low on the X1 cable as the X1 protocol is output only.
         // Clear all KDO bits - clear state = '0'
         GPIO.out_w1tc = (1 << CONFIG_HOST_KDO7) | (1 << CONFIG_HOST_KDO6) | (1 << CONFIG_HOST_KDO5) | (1 << CONFIG_HOST_KDO4) | 
                         (1 << CONFIG_HOST_KDO3) | (1 << CONFIG_HOST_KDO2) | (1 << CONFIG_HOST_KDO1) | (1 << CONFIG_HOST_KDO0);
@@ -558,57 +664,57 @@ uint32_t getHostType(bool eFuseInvalid, t_EFUSE sharpkeyEfuses)
         vTaskDelay(1);
         // Now read back KDB.
         gpioIN = REG_READ(GPIO_IN_REG);
-        if((gpioIN & (1 << CONFIG_HOST_KDB3)) && (gpioIN & (1 << CONFIG_HOST_KDB2)) == 0 && (gpioIN & (1 << CONFIG_HOST_KDB1)) && (gpioIN & (1 << CONFIG_HOST_KDB0)) == 0 && 
-           eFuseInvalid == false && (sharpkeyEfuses.disableRestrictions == true || sharpkeyEfuses.enableX1 == true))
+        signals.x1Loopback = (gpioIN & (1 << CONFIG_HOST_KDB3)) && (gpioIN & (1 << CONFIG_HOST_KDB2)) == 0 && (gpioIN & (1 << CONFIG_HOST_KDB1)) && (gpioIN & (1 << CONFIG_HOST_KDB0)) == 0;
+    }
+
+    // Sample the static host lines.
+    gpioIN = REG_READ(GPIO_IN_REG);
+    signals.mpxLevel  = (gpioIN & MPXI_MASK) != 0;
+    signals.rtsnLevel = (REG_READ(GPIO_IN1_REG) & RTSNI_MASK) != 0;
+    signals.kdi4Level = (gpioIN & (1 << CONFIG_HOST_KDI4)) != 0;
+
+    // X68000 and Mouse ports are only told apart by KDB0 activity, their line levels form a signature used to recognise the same host on the next boot.
+    if(HostDetect::isMatrixHost(signals) == false && signals.x1Loopback == false)
+    {
+        hostSignature = HOST_SIGNATURE_VALID |
+                        (signals.mpxLevel                   ? (1 << 0) : 0) |
+                        (signals.rtsnLevel                  ? (1 << 1) : 0) |
+                        (signals.kdi4Level                  ? (1 << 2) : 0) |
+                        ((gpioIN & (1 << CONFIG_HOST_KDB2)) ? (1 << 3) : 0) |
+                        ((gpioIN & (1 << CONFIG_HOST_KDB3)) ? (1 << 4) : 0);
+
+      #if defined(CONFIG_HOST_FAST_BOOT)
+        // Same signature as the boot which ran the extended window and still permitted by the feature security, the cached host type
+        // may shorten the KDB0 count but is never used without it.
+        if(cachedIfMode == 0 || cachedSignature != hostSignature || HostDetect::isAllowed(cachedIfMode, allowed) == false)
+      #endif
         {
-            ifMode = 1;
-        }
-        else
-        {
-            // Need to reconfigure the Mouse CTRL pin so we can detect counts.
-            gpio_config_t          io_conf;
-            io_conf.intr_type    = GPIO_INTR_DISABLE;
-            io_conf.mode         = GPIO_MODE_INPUT;
-            io_conf.pin_bit_mask = (1ULL<<CONFIG_HOST_KDB0); 
-            io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-            io_conf.pull_up_en   = GPIO_PULLUP_ENABLE;
-            gpio_config(&io_conf);
-
-            // Count the number of pulses on the TxD line (X68000) or Mouse Ctrl line. If there are pulses then the host is a mouse port.
-            uint32_t cntCtrl= 0;
-            gpioIN = gpioINLast = REG_READ(GPIO_IN_REG);
-            for(uint32_t idx=0; idx < 400000; idx++)
-            {
-                gpioIN = REG_READ(GPIO_IN_REG);
-                if((gpioIN & KDB0_MASK) && (gpioIN & KDB0_MASK) != (gpioINLast & KDB0_MASK))  cntCtrl++;
-                gpioINLast = gpioIN;
-            }
-            
-            // Restore config.
-            io_conf.pull_down_en = GPIO_PULLDOWN_ENABLE;
-            io_conf.pull_up_en   = GPIO_PULLUP_DISABLE;
-            gpio_config(&io_conf);
-
-            // Check for X68000 - KD4 = low, MPX = low, RTSN = high
-            gpioIN = REG_READ(GPIO_IN_REG);
-            if(cntCtrl <= 1 && (gpioIN & (1 << CONFIG_HOST_MPXI)) == 0 && (REG_READ(GPIO_IN1_REG) & RTSNI_MASK) != 0 && 
-               eFuseInvalid == false && (sharpkeyEfuses.disableRestrictions == true || sharpkeyEfuses.enableX68000 == true))
-            {
-                ifMode = 68000;
-            }
-            else
-            {
-                // Check for Mouse - KD4 = high, MPX = low, RTSN = high
-                gpioIN = REG_READ(GPIO_IN_REG);
-                if(cntCtrl > 1 && (gpioIN & (1 << CONFIG_HOST_KDI4)) != 0 && (gpioIN & (1 << CONFIG_HOST_MPXI)) == 0 && (REG_READ(GPIO_IN1_REG) & RTSNI_MASK) != 0 && 
-                   eFuseInvalid == false && (sharpkeyEfuses.disableRestrictions == true || sharpkeyEfuses.enableMouse == true))
-                {
-                    ifMode = 2;
-                }
-            }
+            cachedIfMode = 0;
         }
+
+        // KDB0 has been counting since the start, extend its window until the count decides the host.
+        do {
+            vTaskDelay(1);
+            signals.ctrlWindowUs = (uint32_t)(esp_timer_get_time() - startTime);
+            signals.ctrlEdges    = hostSignalEdges(PCNT_UNIT_2);
+        } while(HostDetect::isCtrlDecided(signals, cachedIfMode) == false);
+    }
+    pcnt_counter_pause(PCNT_UNIT_2);
+    signals.ctrlWindowUs = (uint32_t)(esp_timer_get_time() - startTime);
+    signals.ctrlEdges    = hostSignalEdges(PCNT_UNIT_2);
+
+    // Release the signals and restore the KDB0 pull-down.
+    hostSignalDetach(PCNT_UNIT_0);
+    hostSignalDetach(PCNT_UNIT_1);
+    hostSignalDetach(PCNT_UNIT_2);
+    gpio_set_pull_mode((gpio_num_t)CONFIG_HOST_KDB0, GPIO_PULLDOWN_ONLY);
+
+    ifMode = HostDetect::classify(signals, allowed);
+    if(cachedIfMode != 0 && hostSignature != 0)
+    {
+        ESP_LOGW(MAINTAG, "Cached host type %d %s by KDB0 probe, signature:%08x.", cachedIfMode, ifMode == cachedIfMode ? "confirmed" : "rejected", hostSignature);
     }
-    //ESP_LOGW(MAINTAG, "RTSN(%d) and MPX(%d) counts.", cntRTSN, cntMPX);
+    ESP_LOGW(MAINTAG, "Host type:%d, edges in %dus MPX=%d, RTSN=%d, in %dus KDB0=%d, X1 loopback=%d.", ifMode, signals.windowUs, signals.mpxEdges, signals.rtsnEdges, signals.ctrlWindowUs, signals.ctrlEdges, signals.x1Loopback);
   #endif
 
   // Target build for an MZ-2500 using the mz25key hardware.
@@ -620,16 +726,62 @@ uint32_t getHostType(bool eFuseInvalid, t_EFUSE sharpkeyEfuses)
   #ifdef CONFIG_MZ25KEY_MZ2800
     uint32_t ifMode = 2800;
   #endif
-ifMode = 9801; 
+  // Development override of the detected host, ie. for hosts which cannot be detected, see the Debug Options in menuconfig. The override
+  // has no line signature so is never cached.
+  #if defined(CONFIG_DEBUG_FORCE_HOST) && CONFIG_DEBUG_FORCE_HOST != 0
+    ifMode        = CONFIG_DEBUG_FORCE_HOST;
+    hostSignature = 0;
+    ESP_LOGW(MAINTAG, "Host type forced to %d by configuration.", ifMode);
+  #endif
+
     // Return a value which represents the detected host type.
     return(ifMode);
 }
 
+// Method to return the system time in uS. It is maintained by the RTC so remains valid across a software restart.
+static int64_t rtcTimeUs(void)
+{
+    // Locals.
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return(((int64_t)tv.tv_sec * 1000000L) + tv.tv_usec);
+}
+
+// Method to record the mode switch handoff and restart into the requested mode. Interface and WiFi modes are exclusive, Bluetooth and WiFi
+// share the antenna and clash in the IDF stack, and the HID layer cannot bring Bluedroid back once WiFi has run, so a switch is always a
+// restart. The handoff keeps it short, the host type is carried over and the time of the switch into the current mode is passed on so the
+// round trip can be reported.
+void modeSwitchRestart(uint32_t direction)
+{
+    modeHandoff.direction     = direction;
+    modeHandoff.ifMode        = runIfMode;
+    modeHandoff.requestTimeUs = rtcTimeUs();
+    modeHandoff.priorSwitchUs = runSwitchUs;
+    modeHandoff.magic         = MODE_HANDOFF_MAGIC;
+    esp_restart();
+}
+
+// Method to claim the mode switch handoff left by the previous boot. The record is consumed so any later reset runs full host detection.
+bool modeSwitchClaim(t_modeHandoff &handoff)
+{
+    // Locals.
+    bool    result = (modeHandoff.magic == MODE_HANDOFF_MAGIC && esp_reset_reason() == ESP_RST_SW);
+
+    if(result)
+    {
+        memcpy(&handoff, &modeHandoff, sizeof(t_modeHandoff));
+    }
+    modeHandoff.magic = 0;
+    return(result);
+}
+
 // Method triggered on a WiFi Enable switch event. Set the boot mode and restart to enter WiFi handler and webserver.
 void wifiEnableCallback(void)
 {
     ESP_LOGW(MAINTAG, "Setting WiFi Enable mode.");
     sharpKeyConfig.params.bootMode = 1;
+    if(mainTask != NULL) xTaskNotifyGive(mainTask);
 }
 
 // Method triggered on a WiFi Default Mode Enable switch event. Set the boot mode and restart to enter WiFi handler and webserver.
@@ -637,6 +789,7 @@ void wifiDefaultCallback(void)
 {
     ESP_LOGW(MAINTAG, "Setting WiFi Default Enable mode.");
     sharpKeyConfig.params.bootMode = 2;
+    if(mainTask != NULL) xTaskNotifyGive(mainTask);
 }
 
 // Method triggered on a Clear NVS switch event. Close the NVS and erase its contents setting the SharpKey back to factory default.
@@ -644,6 +797,7 @@ void clearNVSCallback(void)
 {
     ESP_LOGW(MAINTAG, "Clearing NVS...");
     sharpKeyConfig.params.bootMode = 255;
+    if(mainTask != NULL) xTaskNotifyGive(mainTask);
 }
 
 // Setup method to configure ports, devices and threads prior to application run.
@@ -661,7 +815,12 @@ void setup(NVS &nvs)
 {
     // Locals.
     uint32_t                 ifMode;
+    uint32_t                 hostSignature = 0;
+    struct SharpKeyConfigV1  sharpKeyConfigV1;
+    bool                     persistConfig = false;
     bool                     eFuseInvalid = false;
+    bool                     handoffValid;
+    t_modeHandoff            handoff;
     KeyInterface             *keyIf = NULL;
     KeyInterface             *mouseIf = NULL;
     HID                      *hid  = NULL;
@@ -706,6 +865,7 @@ void setup(NVS &nvs)
     #if defined(CONFIG_DISABLE_FEATURE_SECURITY)
         sharpkeyEfuses.disableRestrictions = true;
     #endif
+    BootTrace::mark("efuse");
 
     // Configure 4 inputs to be the Strobe Row Number which is used to index the virtual key matrix and the strobe data returned.
     #if !defined(CONFIG_DEBUG_DISABLE_KDB)
@@ -799,6 +959,7 @@ void setup(NVS &nvs)
         io_conf.mode         = GPIO_MODE_OUTPUT; 
         io_conf.pin_bit_mask = (1ULL<<CONFIG_PS2_HW_CLKPIN); 
         gpio_config(&io_conf);
+    BootTrace::mark("gpio");
 
     // Filesystem configuration.
     lfsConf = {
@@ -837,6 +998,7 @@ void setup(NVS &nvs)
             ESP_LOGW(SETUPTAG, "Partition size: total: %d, used: %d", total, used);
         }       
     }
+    BootTrace::mark("littlefs");
    
     // Setup activity LED first to show life.
     ESP_LOGW(MAINTAG, "Configuring Status LED.");
@@ -850,6 +1012,9 @@ void setup(NVS &nvs)
 
     // Instantiate the activity LED control object.
     led = new LED(CONFIG_PWRLED);
+
+    // Start the shared hardware timer service prior to any interface thread which uses it.
+    TimerService::getInstance();
  
     // Initialize NVS, most important it is open.
   //  nvs = new NVS();
@@ -861,17 +1026,32 @@ void setup(NVS &nvs)
         ESP_LOGW(SETUPTAG, "Error opening NVS handle with key (%s)!\n", SHARPKEY_NAME);
     }
 
-    // Retrieve configuration, if it doesnt exist, set defaults.
+    // Retrieve configuration, migrating one saved before the host type cache was added, if it doesnt exist, set defaults. The boot mode must
+    // survive an upgrade as it carries a pending switch into WiFi mode.
     //
+    if(nvs.dataSize(SHARPKEY_NAME) == sizeof(struct SharpKeyConfigV1) && nvs.retrieveData(SHARPKEY_NAME, &sharpKeyConfigV1, sizeof(struct SharpKeyConfigV1)) == true)
+    {
+        ESP_LOGW(SETUPTAG, "SharpKey configuration migrated, no cached host type.");
+        sharpKeyConfig.params.bootMode      = sharpKeyConfigV1.params.bootMode;
+        sharpKeyConfig.params.hostIfMode    = 0;
+        sharpKeyConfig.params.hostSignature = 0;
+        persistConfig = true;
+    } else
     if(nvs.retrieveData(SHARPKEY_NAME, &sharpKeyConfig, sizeof(struct SharpKeyConfig)) == false)
     {
         ESP_LOGW(SETUPTAG, "SharpKey configuration set to default, no valid config found in NVS.");
-        sharpKeyConfig.params.bootMode = 0;
+        sharpKeyConfig.params.bootMode      = 0;
+        sharpKeyConfig.params.hostIfMode    = 0;
+        sharpKeyConfig.params.hostSignature = 0;
+        persistConfig = true;
+    }
 
+    if(persistConfig == true)
+    {
         // Persist the data for next time.
         if(nvs.persistData(SHARPKEY_NAME, &sharpKeyConfig, sizeof(struct SharpKeyConfig)) == false)
         {
-            ESP_LOGW(SETUPTAG, "Persisting Default SharpKey configuration data failed, check NVS setup.");
+            ESP_LOGW(SETUPTAG, "Persisting SharpKey configuration data failed, check NVS setup.");
         }
         // No other updates so make a commit here to ensure data is flushed and written.
         else if(nvs.commitData() == false)
@@ -880,8 +1060,36 @@ void setup(NVS &nvs)
         }
     }
 
-    // Get the host type SharpKey is connected with.
-    ifMode = getHostType(eFuseInvalid, sharpkeyEfuses);
+    BootTrace::mark("nvs");
+
+    // Get the host type SharpKey is connected with. A restart to switch between interface and WiFi modes hands over the host type already
+    // detected, the host cannot have changed as it powers the SharpKey.
+    handoffValid = modeSwitchClaim(handoff);
+    if(handoffValid == true && handoff.ifMode != 0)
+    {
+        ifMode = handoff.ifMode;
+        ESP_LOGW(SETUPTAG, "Host type %d handed over by mode switch.", ifMode);
+    } else
+    {
+        ifMode = getHostType(eFuseInvalid, sharpkeyEfuses, sharpKeyConfig.params.hostIfMode, sharpKeyConfig.params.hostSignature, hostSignature);
+    }
+    runIfMode = ifMode;
+
+    // Cache the host type with its line signature so the next boot can confirm it with the short probe. Only written on change to spare the flash.
+    if(ifMode != 0 && hostSignature != 0 && (sharpKeyConfig.params.hostIfMode != ifMode || sharpKeyConfig.params.hostSignature != hostSignature))
+    {
+        sharpKeyConfig.params.hostIfMode    = ifMode;
+        sharpKeyConfig.params.hostSignature = hostSignature;
+        if(nvs.persistData(SHARPKEY_NAME, &sharpKeyConfig, sizeof(struct SharpKeyConfig)) == false)
+        {
+            ESP_LOGW(SETUPTAG, "Persisting SharpKey configuration data failed, updates will not persist in future power cycles.");
+        }
+        else if(nvs.commitData() == false)
+        {
+            ESP_LOGW(SETUPTAG, "NVS Commit writes operation failed, some previous writes may not persist in future power cycles.");
+        }
+    }
+    BootTrace::mark("host detect");
 
     // If bootMode is for Wifi, start it. This has to be seperate due to a conflict with Bluetooth and WiFi which shares the same antenna.
     // Code is written to allow co-existence but it doesnt work so well in this project.
@@ -902,13 +1110,19 @@ void setup(NVS &nvs)
         {
             ESP_LOGW(SETUPTAG, "NVS Commit writes operation failed, some previous writes may not persist in future power cycles.");
         }
+        if(handoffValid == true && handoff.direction == MODE_HANDOFF_TO_WIFI)
+        {
+            runSwitchUs = rtcTimeUs() - handoff.requestTimeUs;
+            ESP_LOGW(SETUPTAG, "Interface to WiFi mode switch, %lldms to WiFi start.", runSwitchUs / 1000);
+        }
+
       #if defined(CONFIG_IF_WIFI_ENABLED)
         // Fire up WiFi.
         startWiFi(nvs, led, defaultMode, ifMode);
       #endif
 
         // Any exit from the WiFi module requires a reboot so the SharpKey starts up with WiFi disabled and Interface mode running.
-        esp_restart();
+        modeSwitchRestart(MODE_HANDOFF_TO_INTERFACE);
       
     } else
     {
@@ -931,6 +1145,7 @@ void setup(NVS &nvs)
             // When the detected host is a Keyboard port then it is possible, if using Bluetooth, to simultaneously offer a Mouse service at the same time, host dependent.
             hid = new HID(HID::HID_DEVICE_TYPE_KEYBOARD, &nvs, led, sw);
         }
+        BootTrace::mark("hid");
     
         // Setup host interface according to the detected host. We run the interface regardless of optional extras such as LittleFS/WiFi as 
         // keyboard protocol conversion is this devices priority.
@@ -1010,6 +1225,20 @@ void setup(NVS &nvs)
             }
         }
     
+        // Interface threads have signalled they are running, the host interface is live.
+        BootTrace::mark("host interface live");
+        BootTrace::commit();
+        if(handoffValid == true && handoff.direction == MODE_HANDOFF_TO_INTERFACE)
+        {
+            runSwitchUs = rtcTimeUs() - handoff.requestTimeUs;
+            ESP_LOGW(SETUPTAG, "WiFi to interface mode switch, %lldms to host interface live.", runSwitchUs / 1000);
+            if(handoff.priorSwitchUs != 0)
+            {
+                ESP_LOGW(SETUPTAG, "Mode switch round trip %lldms, %lldms into WiFi and %lldms back, time spent in WiFi excluded.",
+                         (handoff.priorSwitchUs + runSwitchUs) / 1000, handoff.priorSwitchUs / 1000, runSwitchUs / 1000);
+            }
+        }
+
         // Disable the brownout detector, when WiFi starts up it randomly triggers the brownout even though the voltage at the WROOM input is 3.3V. It is posisbly a hardware bug 
         // as adding larger capacitors doesnt solve it.
         //
@@ -1028,6 +1257,9 @@ extern "C" void app_main()
     // Locals.
     NVS    nvs;
 
+    // Switch callbacks wake this task to action a mode change.
+    mainTask = xTaskGetCurrentTaskHandle();
+
     // Setup hardware and start primary control threads,
     setup(nvs);
 
@@ -1051,8 +1283,9 @@ extern "C" void app_main()
                 ESP_LOGW(SETUPTAG, "NVS Commit writes operation failed, some previous writes may not persist in future power cycles.");
             }
             
-            // Restart and the SharpKey will come up in Wifi mode.
-            esp_restart();
+            // Restart and the SharpKey will come up in Wifi mode, the last metrics sample of the interface is retained for viewing.
+            Metrics::commit();
+            modeSwitchRestart(MODE_HANDOFF_TO_WIFI);
         }
 
         // Piggy backing off the bootMode is a flag to indicate NVS flash erase and reboot.
@@ -1066,8 +1299,11 @@ extern "C" void app_main()
             esp_restart();
         }
 
-        // Sleep, not much to be done other than look at event flags.
-        vTaskDelay(500);
+        // Sample the interface metrics, retained in RTC memory so they survive a restart.
+        Metrics::commit();
+
+        // Sleep until a switch callback signals or the poll period expires, not much to be done other than look at event flags.
+        ulTaskNotifyTake(pdTRUE, 500);
     }
 
     // Lost in space.... this thread is no longer required!
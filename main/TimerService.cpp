@@ -0,0 +1,300 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            TimerService.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     A shared hardware timer service. One hardware timer runs freely at 1MHz and provides
+//                  the time base for all interface threads. Threads register a timer and schedule an
+//                  absolute deadline, the deadlines are held in a min-heap and the hardware alarm is armed
+//                  for the root. On expiry the alarm ISR notifies the owning thread and re-arms for the
+//                  next deadline, so waiting threads consume no CPU.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "soc/timer_group_struct.h"
+#include "soc/timer_group_reg.h"
+#include "driver/timer.h"
+#include "sdkconfig.h"
+#include "TimerService.h"
+
+// Singleton instance, the hardware timer can only be owned once.
+static TimerService *pTimerService = NULL;
+
+// Method to return the singleton, creating it on first use. The first call is made during setup, prior to any interface threads
+// starting, so no lock is required.
+TimerService *TimerService::getInstance(void)
+{
+    if(pTimerService == NULL)
+    {
+        pTimerService = new TimerService();
+    }
+    return(pTimerService);
+}
+
+// Method to register a timer for a thread. The returned id is used in all subsequent calls. Returns TIMERSERVICE_INVALID if no slots remain.
+int TimerService::registerTimer(TaskHandle_t owner)
+{
+    // Locals.
+    //
+    int         timerId = TIMERSERVICE_INVALID;
+
+    portENTER_CRITICAL(&timerCtrl.mutex);
+    if(timerCtrl.slotCount < TIMERSERVICE_MAX_TIMERS)
+    {
+        timerId = timerCtrl.slotCount++;
+        timerCtrl.slot[timerId].owner    = owner;
+        timerCtrl.slot[timerId].deadline = 0LL;
+        timerCtrl.slot[timerId].heapPos  = TIMERSERVICE_INVALID;
+    }
+    portEXIT_CRITICAL(&timerCtrl.mutex);
+
+    if(timerId == TIMERSERVICE_INVALID)
+    {
+        ESP_LOGE("registerTimer", "No free timer slots, increase TIMERSERVICE_MAX_TIMERS.");
+    }
+    return(timerId);
+}
+
+// Method to schedule a timer to expire at an absolute deadline, rescheduling it if already active. The owning thread is notified
+// on expiry. Returns false if the deadline has already been reached, in which case no notification is sent.
+bool TimerService::startTimer(int timerId, uint64_t deadline)
+{
+    // Locals.
+    //
+    bool        result = false;
+    uint64_t    curTime;
+
+    if(timerId >= 0 && timerId < timerCtrl.slotCount)
+    {
+        portENTER_CRITICAL(&timerCtrl.mutex);
+        curTime = now();
+        if(deadline > curTime + TIMERSERVICE_ALARM_LEAD)
+        {
+            // Remove any existing schedule then add the new deadline at the bottom of the heap and sift it up to its place.
+            if(timerCtrl.slot[timerId].heapPos != TIMERSERVICE_INVALID)
+            {
+                heapRemove(timerCtrl.slot[timerId].heapPos);
+            }
+            timerCtrl.slot[timerId].deadline = deadline;
+            timerCtrl.slot[timerId].heapPos  = timerCtrl.heapSize;
+            timerCtrl.heap[timerCtrl.heapSize++] = timerId;
+            heapUp(timerCtrl.slot[timerId].heapPos);
+
+            // Alarm only needs re-arming if the new deadline is now the earliest.
+            if(timerCtrl.heap[0] == timerId)
+            {
+                armAlarm(curTime);
+            }
+            result = true;
+        }
+        portEXIT_CRITICAL(&timerCtrl.mutex);
+    }
+    return(result);
+}
+
+// Method to cancel a scheduled timer. A notification already sent by an expiry cannot be withdrawn, sleepUntil tolerates this.
+void TimerService::cancelTimer(int timerId)
+{
+    if(timerId >= 0 && timerId < timerCtrl.slotCount)
+    {
+        portENTER_CRITICAL(&timerCtrl.mutex);
+        if(timerCtrl.slot[timerId].heapPos != TIMERSERVICE_INVALID)
+        {
+            heapRemove(timerCtrl.slot[timerId].heapPos);
+            armAlarm(now());
+        }
+        portEXIT_CRITICAL(&timerCtrl.mutex);
+    }
+}
+
+// Method to block the calling thread until an absolute deadline is reached. The thread must own the timer. The wait is repeated
+// until the deadline has truly passed so a stale notification or a cancelled timer cannot cause an early return. A tick based
+// timeout backs up the alarm should it be missed. Returns false if the timer id is invalid, in which case no delay is made.
+bool TimerService::sleepUntil(int timerId, uint64_t deadline)
+{
+    // Locals.
+    //
+    uint64_t    curTime;
+
+    if(timerId < 0 || timerId >= timerCtrl.slotCount)
+        return(false);
+
+    while((curTime = now()) < deadline)
+    {
+        if(startTimer(timerId, deadline))
+        {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS((deadline - curTime) / 1000) + 2);
+        }
+    }
+
+    // Clear the schedule in case the tick timeout, rather than the alarm, released the thread.
+    cancelTimer(timerId);
+    return(true);
+}
+
+// Method to busy wait until an absolute deadline is reached. Used by bit level serialisers which hold a critical section for
+// timing accuracy, interrupts being disabled, the alarm cannot be used. The shared counter is read only so any number of
+// threads can spin on it concurrently.
+void TimerService::spinUntil(uint64_t deadline)
+{
+    while(now() < deadline);
+}
+
+// Heap helpers. All are called with the mutex held. The heap array holds timer ids, each slot records its own heap position
+// so a scheduled timer can be removed without a search.
+//
+IRAM_ATTR void TimerService::heapSwap(int posA, int posB)
+{
+    // Locals.
+    //
+    int         timerId = timerCtrl.heap[posA];
+
+    timerCtrl.heap[posA] = timerCtrl.heap[posB];
+    timerCtrl.heap[posB] = timerId;
+    timerCtrl.slot[timerCtrl.heap[posA]].heapPos = posA;
+    timerCtrl.slot[timerCtrl.heap[posB]].heapPos = posB;
+}
+
+IRAM_ATTR void TimerService::heapUp(int pos)
+{
+    // Locals.
+    //
+    int         parent;
+
+    while(pos > 0)
+    {
+        parent = (pos - 1) / 2;
+        if(timerCtrl.slot[timerCtrl.heap[parent]].deadline <= timerCtrl.slot[timerCtrl.heap[pos]].deadline)
+            break;
+        heapSwap(pos, parent);
+        pos = parent;
+    }
+}
+
+IRAM_ATTR void TimerService::heapDown(int pos)
+{
+    // Locals.
+    //
+    int         child;
+
+    while((child = (pos * 2) + 1) < timerCtrl.heapSize)
+    {
+        // Select the earlier of the two children.
+        if(child + 1 < timerCtrl.heapSize && timerCtrl.slot[timerCtrl.heap[child + 1]].deadline < timerCtrl.slot[timerCtrl.heap[child]].deadline)
+            child++;
+        if(timerCtrl.slot[timerCtrl.heap[pos]].deadline <= timerCtrl.slot[timerCtrl.heap[child]].deadline)
+            break;
+        heapSwap(pos, child);
+        pos = child;
+    }
+}
+
+IRAM_ATTR void TimerService::heapRemove(int pos)
+{
+    // Locals.
+    //
+    int         last = --timerCtrl.heapSize;
+
+    timerCtrl.slot[timerCtrl.heap[pos]].heapPos = TIMERSERVICE_INVALID;
+    if(pos != last)
+    {
+        // Move the last entry into the hole and restore heap order in whichever direction is needed.
+        timerCtrl.heap[pos] = timerCtrl.heap[last];
+        timerCtrl.slot[timerCtrl.heap[pos]].heapPos = pos;
+        heapUp(pos);
+        heapDown(timerCtrl.slot[timerCtrl.heap[pos]].heapPos);
+    }
+}
+
+// Method to arm the hardware alarm for the earliest deadline. Called with the mutex held. The alarm only fires on the counter
+// reaching the alarm value, so a deadline which is already within the lead time is armed just ahead of the counter instead.
+IRAM_ATTR void TimerService::armAlarm(uint64_t curTime)
+{
+    // Locals.
+    //
+    uint64_t    alarmTime;
+
+    if(timerCtrl.heapSize > 0)
+    {
+        alarmTime = timerCtrl.slot[timerCtrl.heap[0]].deadline;
+        if(alarmTime < curTime + TIMERSERVICE_ALARM_LEAD)
+            alarmTime = curTime + TIMERSERVICE_ALARM_LEAD;
+        timer_group_set_alarm_value_in_isr(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER, alarmTime);
+        timer_group_enable_alarm_in_isr(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER);
+    }
+}
+
+// Alarm interrupt callback. Expires every deadline which has been reached, notifying the owning threads, then re-arms the alarm
+// for the new earliest deadline. Returns true if a higher priority thread was woken so the driver yields on exit.
+IRAM_ATTR bool TimerService::alarmInterrupt(void *pvParameters)
+{
+    // Locals.
+    //
+    TimerService       *pThis = (TimerService *)pvParameters;
+    BaseType_t          taskWoken = pdFALSE;
+    uint64_t            curTime;
+    int                 timerId;
+
+    portENTER_CRITICAL_ISR(&pThis->timerCtrl.mutex);
+    curTime = timer_group_get_counter_value_in_isr(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER);
+    while(pThis->timerCtrl.heapSize > 0 && pThis->timerCtrl.slot[pThis->timerCtrl.heap[0]].deadline <= curTime + TIMERSERVICE_ALARM_LEAD)
+    {
+        timerId = pThis->timerCtrl.heap[0];
+        pThis->heapRemove(0);
+        vTaskNotifyGiveFromISR(pThis->timerCtrl.slot[timerId].owner, &taskWoken);
+    }
+    pThis->armAlarm(curTime);
+    portEXIT_CRITICAL_ISR(&pThis->timerCtrl.mutex);
+
+    return(taskWoken == pdTRUE);
+}
+
+// Constructor, configure the shared hardware timer as a free running 1MHz counter and attach the alarm interrupt.
+TimerService::TimerService(void)
+{
+    // Initialise the scheduler.
+    timerCtrl.heapSize  = 0;
+    timerCtrl.slotCount = 0;
+    timerCtrl.mutex     = portMUX_INITIALIZER_UNLOCKED;
+
+    // Configure the timer with 1uS resolution. The default clock source is the APB running at 80MHz.
+    timer_config_t timerConfig = {
+        .alarm_en    = TIMER_ALARM_DIS,            // Alarm armed on demand for the earliest deadline.
+        .counter_en  = TIMER_PAUSE,                // Timer paused until configured.
+        .intr_type   = TIMER_INTR_LEVEL,           // Level interrupt on alarm.
+        .counter_dir = TIMER_COUNT_UP,             // Free running time base.
+        .auto_reload = TIMER_AUTORELOAD_DIS,       // Never reloaded, 64bit counter will not wrap.
+        .divider     = 80                          // 1Mhz operation giving 1uS resolution.
+    };
+    ESP_ERROR_CHECK(timer_init(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER, &timerConfig));
+    ESP_ERROR_CHECK(timer_set_counter_value(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER, 0LL));
+    ESP_ERROR_CHECK(timer_isr_callback_add(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER, &TimerService::alarmInterrupt, this, 0));
+    ESP_ERROR_CHECK(timer_start(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER));
+}
@@ -24,6 +24,14 @@
 //                             via a reboot process. This is necessary now that Bluetooth is inbuilt
 //                             as the ESP32 shares an antenna and both operating together electrically
 //                             is difficult but also the IDF stack conflicts as well.
+//            v1.03 Oct 2026 - Keystroke macro upload, macros are stored for playback by the interface.
+//            v1.04 Oct 2026 - WebSocket live channel, status is pushed to the browser and keymap row edits are
+//                             applied individually rather than uploading the whole table.
+//            v1.05 Oct 2026 - Runtime metrics served as JSON on /metrics.
+//            v1.06 Oct 2026 - WebSocket messages are decoded by LiveChannel, the handler only carries frames.
+//                             Keys typed on a PS/2 keyboard are pushed with their mapping in the active keymap.
+//            v1.07 Oct 2026 - Stopped in place so the interface resumes without a restart, unless an update needs one.
+//            v1.08 Oct 2026 - In place stop withdrawn, leaving WiFi mode restarts.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -66,6 +74,7 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_ota_ops.h"
+#include "esp_timer.h"
 #include "lwip/err.h"
 #include "lwip/sys.h"
 #include "Arduino.h"
@@ -76,6 +85,8 @@
 #include "esp_tls_crypto.h"
 #include <esp_http_server.h>
 #include "esp_littlefs.h"
+#include "BootTrace.h"
+#include "Metrics.h"
 #include "WiFi.h"
 
 // FreeRTOS event group to signal when we are connected
@@ -614,6 +625,19 @@ esp_err_t WiFi::expandVarsAndSend(httpd_req_t *req, std::string str)
                                                     list << "</tr></tbody?></table>";
                                                     keyValue.value = list.str();
                                                 } else { keyValue.value = "Unknown"; };                                                                                              pairs.push_back(keyValue);
+    keyValue.name  = "%SK_BOOTTIMELINE%";       {
+                                                    std::vector<std::pair<std::string, uint32_t>> timeline;
+                                                    std::ostringstream list;
+                                                    BootTrace::getTimeline(timeline);
+                                                    list << "<table class=\"table table-borderless table-sm\"><tbody>";
+                                                    for(auto stage : timeline)
+                                                    {
+                                                        list << "<tr><td>" << stage.first << "</td><td><i>" << to_str((float)stage.second / 1000, 3, 10) << "ms</i></td></tr>";
+                                                    }
+                                                    if(timeline.size() == 0) { list << "<tr><td>No interface boot recorded since power on.</td></tr>"; }
+                                                    list << "</tbody></table>";
+                                                    keyValue.value = list.str();
+                                                }                                                                                                                                    pairs.push_back(keyValue);
     keyValue.name  = "%SK_FILEPACK%";           {
                                                     std::ostringstream list;
                                                     list << "<table class=\"table table-borderless table-sm\"><tbody><tr>";
@@ -653,6 +677,7 @@ esp_err_t WiFi::expandVarsAndSend(httpd_req_t *req, std::string str)
     keyValue.name  = "%SK_KEYMAPDATA%";         keyValue.value = "";                                                                                                                 pairs.push_back(keyValue);
     keyValue.name  = "%SK_KEYMAPPOPOVER%";      keyValue.value = "";                                                                                                                 pairs.push_back(keyValue);
     keyValue.name  = "%SK_MOUSEHOSTSCALING%";   keyValue.value = "";                                                                                                                 pairs.push_back(keyValue);
+    keyValue.name  = "%SK_MOUSEHOSTACCEL%";     keyValue.value = "";                                                                                                                 pairs.push_back(keyValue);
     keyValue.name  = "%SK_MOUSEPS2SCALING%";    keyValue.value = "";                                                                                                                 pairs.push_back(keyValue);
     keyValue.name  = "%SK_MOUSEPS2RESOLUTION%"; keyValue.value = "";                                                                                                                 pairs.push_back(keyValue);
     keyValue.name  = "%SK_MOUSEPS2SAMPLERATE%"; keyValue.value = "";                                                                                                                 pairs.push_back(keyValue);
@@ -666,7 +691,7 @@ esp_err_t WiFi::expandVarsAndSend(httpd_req_t *req, std::string str)
         {
             // Dont expand large data macros yet, they can potentially generate too much data for the limited ESP32 RAM.
             if(pair.name.compare("%SK_KEYMAPHEADER%") != 0 && pair.name.compare("%SK_KEYMAPTYPES%") != 0 && pair.name.compare("%SK_KEYMAPDATA%") != 0 && 
-               pair.name.compare("%SK_KEYMAPJSFIELDS%") != 0 && pair.name.compare("%SK_KEYMAPPOPOVER%") != 0 && pair.name.compare("%SK_MOUSEHOSTSCALING%") != 0 &&
+               pair.name.compare("%SK_KEYMAPJSFIELDS%") != 0 && pair.name.compare("%SK_KEYMAPPOPOVER%") != 0 && pair.name.compare("%SK_MOUSEHOSTSCALING%") != 0 && pair.name.compare("%SK_MOUSEHOSTACCEL%") != 0 &&
                pair.name.compare("%SK_MOUSEPS2SCALING%") != 0 && pair.name.compare("%SK_MOUSEPS2RESOLUTION%") != 0 && pair.name.compare("%SK_MOUSEPS2SAMPLERATE%") != 0
               ) 
             {
@@ -738,6 +763,11 @@ esp_err_t WiFi::expandVarsAndSend(httpd_req_t *req, std::string str)
                     {
                         result = sendMouseRadioChoice(req, "host_scaling");
                     }
+                    // Mouse host acceleration - Radio selection of the acceleration curve applied after scaling.
+                    if(pair.name.compare("%SK_MOUSEHOSTACCEL%") == 0)
+                    {
+                        result = sendMouseRadioChoice(req, "host_accel");
+                    }
                     if(pair.name.compare("%SK_MOUSEPS2SCALING%") == 0)
                     {
                         result = sendMouseRadioChoice(req, "mouse_scaling");
@@ -1683,6 +1713,240 @@ esp_err_t WiFi::keymapUploadPOSTHandler(httpd_req_t *req)
 }
 
 
+// Method to store a keystroke macro. The slot is given by the URI, ie. /macro/1, and the POST body is the macro text which is
+// written as is, an empty body removes the macro. The response is the number of keys the macro types.
+esp_err_t WiFi::macroPOSTHandler(httpd_req_t *req)
+{
+    // Locals.
+    //
+    int                    slot;
+    FILE                  *macroFile;
+    std::string            uriStr;
+    std::string            fileName;
+    std::string            macroText = "";
+
+    // Retrieve pointer to object in order to access data.
+    WiFi* pThis = (WiFi*)req->user_ctx;
+
+    // Get the slot from the URI.
+    if(pThis->keyIf == NULL || pThis->getPathFromURI(uriStr, "/macro/", req->uri) == ESP_FAIL || uriStr.size() != 1 || (slot = uriStr[0] - '0') < 1 || slot > KEYMACRO_SLOTS)
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown macro");
+        return(ESP_FAIL);
+    }
+    if(req->content_len > KEYMACRO_MAX_SIZE)
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Macro too large");
+        return(ESP_FAIL);
+    }
+    fileName = KeyMacro::fileName(std::string(pThis->wifiCtrl.run.basePath).append("/").append(pThis->keyIf->getKeyMapFileName()), slot);
+
+    // Allocate heap space for our receive buffer.
+    //
+    char *chunk = new char[MAX_CHUNK_SIZE];
+    int chunkSize;
+
+    // Use the Content length as the size of the macro to be uploaded.
+    int remaining = req->content_len;
+
+    // Loop while data is still expected.
+    while(remaining > 0)
+    {
+        // The macro is received in chunks according to the free memory available for a buffer.
+        if((chunkSize = httpd_req_recv(req, chunk, MIN(remaining, MAX_CHUNK_SIZE))) <= 0)
+        {
+            // Retry if timeout occurred.
+            if (chunkSize == HTTPD_SOCK_ERR_TIMEOUT)
+                continue;
+
+            // Release memory, error!!
+            delete[] chunk;
+
+            // Respond with 500 Internal Server Error when a reception error occurs.
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to receive macro");
+            return(ESP_FAIL);
+        }
+        macroText.append(chunk, chunkSize);
+        remaining -= chunkSize;
+    }
+    // Release memory, all done!
+    delete[] chunk;
+
+    // An empty macro removes the file, otherwise write out the text.
+    if(macroText.size() == 0)
+    {
+        std::remove(fileName.c_str());
+    } else
+    {
+        if((macroFile = fopen(fileName.c_str(), "w")) == NULL)
+        {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to create macro file");
+            return(ESP_FAIL);
+        }
+        if(fwrite(macroText.c_str(), 1, macroText.size(), macroFile) != macroText.size())
+        {
+            fclose(macroFile);
+            std::remove(fileName.c_str());
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to write macro file");
+            return(ESP_FAIL);
+        }
+        fclose(macroFile);
+    }
+    ESP_LOGI(WIFITAG, "Macro %d stored, %d bytes.", slot, (int)macroText.size());
+
+    // Done, send the number of keys the macro types.
+    httpd_resp_set_status(req, "200 OK");
+    httpd_resp_sendstr(req, std::to_string(KeyMacro::validate(macroText)).c_str());
+
+    // Send result.
+    return(ESP_OK);
+}
+
+// Method to send the runtime metrics as JSON, the running WiFi mode system and the last sample of the host interface.
+esp_err_t WiFi::metricsGETHandler(httpd_req_t *req)
+{
+    // Locals.
+    //
+    std::string            metrics = Metrics::json();
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_sendstr(req, metrics.c_str());
+    return(ESP_OK);
+}
+
+// Method to send a text message to all WebSocket clients except the given socket, -1 for all. Runs in the server context, called directly by a
+// handler or queued as work by another task. Returns the number of WebSocket clients.
+int WiFi::wsBroadcast(const std::string &message, int skipFd)
+{
+    // Locals.
+    //
+    size_t                 fdCnt = CONFIG_LWIP_MAX_SOCKETS;
+    int                    fds[CONFIG_LWIP_MAX_SOCKETS];
+    int                    clients = 0;
+    httpd_ws_frame_t       frame;
+
+    if(httpd_get_client_list(wifiCtrl.run.server, &fdCnt, fds) != ESP_OK)
+    {
+        return(0);
+    }
+    memset(&frame, 0, sizeof(httpd_ws_frame_t));
+    frame.type    = HTTPD_WS_TYPE_TEXT;
+    frame.payload = (uint8_t *)message.c_str();
+    frame.len     = message.size();
+    for(size_t idx=0; idx < fdCnt; idx++)
+    {
+        if(httpd_ws_get_fd_info(wifiCtrl.run.server, fds[idx]) == HTTPD_WS_CLIENT_WEBSOCKET)
+        {
+            clients++;
+            if(fds[idx] != skipFd)
+            {
+                httpd_ws_send_frame_async(wifiCtrl.run.server, fds[idx], &frame);
+            }
+        }
+    }
+    return(clients);
+}
+
+// Work item queued by the run loop, pushes the status to all WebSocket clients from within the server context.
+//
+void WiFi::wsStatusWork(void *arg)
+{
+    // Retrieve pointer to object in order to access data.
+    WiFi* pThis = (WiFi*)arg;
+
+    pThis->wsBroadcast(pThis->live->status(), -1);
+}
+
+// Work item queued by the key monitor, pushes a key event to all WebSocket clients from within the server context.
+//
+void WiFi::wsPushWork(void *arg)
+{
+    // Retrieve the message and the object it was queued for.
+    t_wsPush* push = (t_wsPush*)arg;
+
+    push->wifi->wsBroadcast(push->message, -1);
+    delete push;
+}
+
+// Callback from the live channel key monitor, the send has to be made from the server context so the message is queued as work.
+//
+void WiFi::wsPush(void *ctx, const std::string &message)
+{
+    // Locals.
+    //
+    t_wsPush              *push;
+
+    // Retrieve pointer to object in order to access data.
+    WiFi* pThis = (WiFi*)ctx;
+
+    if(pThis->wifiCtrl.run.server != NULL)
+    {
+        push = new t_wsPush{pThis, message};
+        if(httpd_queue_work(pThis->wifiCtrl.run.server, wsPushWork, push) != ESP_OK)
+        {
+            delete push;
+        }
+    }
+}
+
+// WebSocket handler for the live channel. The frames are decoded and answered by the live channel, this handler only carries them. Status and
+// key events are pushed to all clients, keymap row edits are received from the keymap editor.
+esp_err_t WiFi::wsHandler(httpd_req_t *req)
+{
+    // Locals.
+    //
+    esp_err_t              result;
+    httpd_ws_frame_t       frame;
+    LiveChannel::t_frame   request;
+    LiveChannel::t_frame   reply;
+    std::string            broadcast;
+
+    // Retrieve pointer to object in order to access data.
+    WiFi* pThis = (WiFi*)req->user_ctx;
+
+    // The GET is the handshake, the connection is a WebSocket from here on.
+    if(req->method == HTTP_GET)
+    {
+        ESP_LOGI(WIFITAG, "WebSocket client connected.");
+        return(ESP_OK);
+    }
+
+    // Get the frame length then the frame.
+    memset(&frame, 0, sizeof(httpd_ws_frame_t));
+    if((result = httpd_ws_recv_frame(req, &frame, 0)) != ESP_OK)
+    {
+        return(result);
+    }
+    if(frame.len > LIVECHANNEL_MAX_FRAME)
+    {
+        ESP_LOGW(WIFITAG, "WebSocket frame of %d bytes too large.", (int)frame.len);
+        return(ESP_FAIL);
+    }
+    request.binary = (frame.type == HTTPD_WS_TYPE_BINARY);
+    request.payload.resize(frame.len);
+    frame.payload = request.payload.data();
+    if(frame.len > 0 && (result = httpd_ws_recv_frame(req, &frame, frame.len)) != ESP_OK)
+    {
+        return(result);
+    }
+
+    // Process the message, replying to the sender and telling the other clients of any change.
+    if(pThis->live->receive(request, reply, broadcast) == true)
+    {
+        if(broadcast.empty() == false)
+        {
+            pThis->wsBroadcast(broadcast, httpd_req_to_sockfd(req));
+        }
+        memset(&frame, 0, sizeof(httpd_ws_frame_t));
+        frame.type    = (reply.binary == true ? HTTPD_WS_TYPE_BINARY : HTTPD_WS_TYPE_TEXT);
+        frame.payload = reply.payload.data();
+        frame.len     = reply.payload.size();
+        result = httpd_ws_send_frame(req, &frame);
+    }
+    return(result);
+}
+
 // Method to store the keymap table data. The POST data is captured in chunks and sent to the underlying interface method 
 // for parsing and extraction.
 esp_err_t WiFi::keymapTablePOSTHandler(httpd_req_t *req)
@@ -2196,7 +2460,7 @@ bool WiFi::startWebserver(void)
     config.stack_size = 10240;
     config.uri_match_fn = httpd_uri_match_wildcard;
     config.lru_purge_enable = true;
-    config.max_uri_handlers = 12;
+    config.max_uri_handlers = 15;
 
     // Setup the required paths and descriptors then register them with the server.
     const httpd_uri_t dataPOST = {
@@ -2235,6 +2499,27 @@ bool WiFi::startWebserver(void)
         .handler   = keymapUploadPOSTHandler,
         .user_ctx  = this
     };
+    const httpd_uri_t macroPOST = {
+        .uri       = "/macro/*",
+        .method    = HTTP_POST,
+        .handler   = macroPOSTHandler,
+        .user_ctx  = this
+    };
+    const httpd_uri_t metricsGET = {
+        .uri       = "/metrics",
+        .method    = HTTP_GET,
+        .handler   = metricsGETHandler,
+        .user_ctx  = this
+    };
+    const httpd_uri_t ws = {
+        .uri                      = "/ws",
+        .method                   = HTTP_GET,
+        .handler                  = wsHandler,
+        .user_ctx                 = this,
+        .is_websocket             = true,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL
+    };
     const httpd_uri_t otafw = {
         .uri       = "/ota/firmware",
         .method    = HTTP_POST,
@@ -2295,6 +2580,9 @@ bool WiFi::startWebserver(void)
         httpd_register_uri_handler(wifiCtrl.run.server, &dataGET);
         httpd_register_uri_handler(wifiCtrl.run.server, &keymapTablePOST);
         httpd_register_uri_handler(wifiCtrl.run.server, &keymap);
+        httpd_register_uri_handler(wifiCtrl.run.server, &macroPOST);
+        httpd_register_uri_handler(wifiCtrl.run.server, &metricsGET);
+        httpd_register_uri_handler(wifiCtrl.run.server, &ws);
         httpd_register_uri_handler(wifiCtrl.run.server, &otafw);
         httpd_register_uri_handler(wifiCtrl.run.server, &otafp);
         httpd_register_uri_handler(wifiCtrl.run.server, &rebootPOST);
@@ -2769,10 +3057,19 @@ void WiFi::run(void)
         }
     }
 
+    // Push keys typed on the keyboard and the keymap row each selects to the live channel clients, so keymap edits can be tried as they are made.
+    live->startKeyMonitor(wsPush, this);
+
     // Enter a loop, only exitting if a reboot is required.
     do {
         // Let other tasks run. NB. This value affects the debounce counter, update as necessary.
         vTaskDelay(500);
+
+        // Push the status to any live WebSocket clients, the send has to be made from the server context.
+        if(wifiCtrl.run.server != NULL)
+        {
+            httpd_queue_work(wifiCtrl.run.server, wsStatusWork, this);
+        }
     } while(wifiCtrl.run.reboot == false);
 
     return;
@@ -2854,11 +3151,15 @@ WiFi::WiFi(KeyInterface *hdlKeyIf, KeyInterface *hdlMouseIf, bool defaultMode, N
         this->keyIf   = hdlKeyIf;
         this->mouseIf = hdlMouseIf;
     }
+
+    // The live channel decodes the WebSocket messages and maps keys through the keyboard interface.
+    live = new LiveChannel(this->keyIf);
 }
 
 // Constructor, used for version reporting so no hardware is initialised.
 WiFi::WiFi(void)
 {
+    live = NULL;
     return;
 }
 
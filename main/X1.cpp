@@ -22,6 +22,12 @@
 //            v1.01 May 2022 - Initial release version.
 //            v1.02 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
+//            v1.04 Oct 2026 - Keystroke macros, played with CTRL+SHIFT+ESC then F1..F4 and paced by frame
+//                             completion. Characters are reverse mapped through the active keymap.
+//            v1.05 Oct 2026 - Keymap row edits from the web editor applied without a full table upload.
+//            v1.06 Oct 2026 - Transmit queue depth and overflows reported to the runtime metrics.
+//            v1.07 Oct 2026 - Queue wait and frame transmit latency recorded per key in the runtime metrics.
+//            v1.08 Oct 2026 - Macro characters the keymap does not produce are skipped rather than typed with the PC layout.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -62,8 +68,12 @@
 #include "esp_littlefs.h"
 #include "PS2KeyAdvanced.h"
 #include "sdkconfig.h"
+#include "TimerService.h"
 #include "X1.h"
 
+// Inbuilt keymap, constant so it is held in flash rather than copied into each instance.
+constexpr X1::t_keyMap X1::PS2toX1;
+
 // Tag for ESP main application logging.
 #define                         MAINTAG  "x1key"
 
@@ -126,9 +136,15 @@ void X1::pushKeyToQueue(bool keybMode, uint32_t key)
 
     xmitMsg.modeB = keybMode;
     xmitMsg.keyCode = key;
+    xmitMsg.eventTime = takeKeyEventTime();
+    xmitMsg.queueTime = Metrics::now();
     if( xQueueSend(xmitQueue, (void *)&xmitMsg, 10) != pdPASS)
     {
         ESP_LOGW(PUSHKEYTAG, "Failed to put scancode:%04x into xmitQueue", key);
+        Metrics::count(Metrics::COUNTER_XMIT_QUEUE_FULL);
+    } else
+    {
+        macroFrameQueued();
     }
     return;
 }
@@ -140,11 +156,13 @@ IRAM_ATTR void X1::x1Interface( void * pvParameters )
 {
     // Locals.
     t_xmitQueueMessage  rcvMsg;
+    uint32_t            xmitStart = 0;
 
     // Mask values declared as variables, let the optimiser decide wether they are constants or placed in-memory.
     uint32_t            X1DATA_MASK  = (1 << CONFIG_HOST_KDO0);
     uint64_t            delayTimer = 0LL;
-    uint64_t            curTime    = 0LL;
+    uint64_t            deadline   = 0LL;
+    TimerService       *timerService = TimerService::getInstance();
     bool                bitStart = true;
     uint32_t            bitCount = 0;
     enum X1XMITSTATE {
@@ -163,171 +181,157 @@ IRAM_ATTR void X1::x1Interface( void * pvParameters )
     // Initialise the MUTEX which prevents this core from being released to other tasks.
     pThis->x1Mutex = portMUX_INITIALIZER_UNLOCKED;
 
-    // Initial delay needed because the xQueue will assert probably on a suspended task ALL if delay not inserted!
-    vTaskDelay(1000);
-
     // Sign on.
     ESP_LOGW(MAINTAG, "Starting X1 thread.");
 
     // X1 data out default state is high.
     GPIO.out_w1ts = X1DATA_MASK;
 
-    // Configure a timer to be used for X1 protocol spacing with 1uS resolution. The default clock source is the APB running at 80MHz.
-    timer_config_t timerConfig = {
-        .alarm_en    = TIMER_ALARM_DIS,            // No alarm, were not using interrupts as we are in a dedicated thread.
-        .counter_en  = TIMER_PAUSE,                // Timer paused until required.
-        .intr_type   = TIMER_INTR_LEVEL,           // No interrupts used.
-        .counter_dir = TIMER_COUNT_UP,             // Timing a fixed period.
-        .auto_reload = TIMER_AUTORELOAD_DIS,       // No need for auto reload, fixed time period.
-        .divider     = 80                          // 1Mhz operation giving 1uS resolution.
-    };
-    ESP_ERROR_CHECK(timer_init(TIMER_GROUP_0, TIMER_0, &timerConfig));
-    ESP_ERROR_CHECK(timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0));
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HOSTIF);
 
     // Permanent loop, wait for an incoming message on the key to send queue, read it then transmit to the X1, repeat!
     for(;;)
     {
-        // Get the current timer value, only run the FSM when the timer is idle.
-        timer_get_counter_value(TIMER_GROUP_0, TIMER_0, &curTime);
-        if(curTime >= delayTimer)
-        {
-            // Ensure the timer is stopped.
-            timer_pause(TIMER_GROUP_0, TIMER_0);
-            delayTimer = 0LL;
+        delayTimer = 0LL;
 
-            // Finite state machine to retrieve a key for transmission then serialise it according to the X1 protocol.
-            switch(state)
-            {
-                case FSM_IDLE:
-                    // Yield if the suspend flag is set.
-                    pThis->yield(0);
+        // Finite state machine to retrieve a key for transmission then serialise it according to the X1 protocol.
+        switch(state)
+        {
+            case FSM_IDLE:
+                // Yield if the suspend flag is set.
+                pThis->yield(0);
 
-                    // Check stack space, report if it is getting low.
-                    if(uxTaskGetStackHighWaterMark(NULL) < 1024)
-                    {
-                        ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
-                    }
+                // Check stack space, report if it is getting low.
+                if(uxTaskGetStackHighWaterMark(NULL) < 1024)
+                {
+                    ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
+                }
 
-                    // If a new message arrives, start the serialiser to send it to the X1.
-                    if(xQueueReceive(xmitQueue, (void *)&rcvMsg, 0) == pdTRUE)
-                    {
-                        ESP_LOGW(MAINTAG, "Received:%08x, %d", rcvMsg.keyCode, rcvMsg.modeB);
-                        state = FSM_STARTXMIT; 
-                   
-                        // Create, initialise and hold a spinlock so the current core is bound to this one method.
-                        portENTER_CRITICAL(&pThis->x1Mutex);
-                    }
-                    break;
+                // Block waiting for a new message, when it arrives start the serialiser to send it to the X1. The timeout allows the suspend flag to be serviced.
+                if(xQueueReceive(xmitQueue, (void *)&rcvMsg, pdMS_TO_TICKS(10)) == pdTRUE)
+                {
+                    xmitStart = Metrics::stage(Metrics::HIST_QUEUE, rcvMsg.queueTime);
+                    ESP_LOGW(MAINTAG, "Received:%08x, %d", rcvMsg.keyCode, rcvMsg.modeB);
+                    state = FSM_STARTXMIT; 
+               
+                    // Create, initialise and hold a spinlock so the current core is bound to this one method.
+                    portENTER_CRITICAL(&pThis->x1Mutex);
+                }
+                break;
+
+            case FSM_STARTXMIT:
+                // Ensure all variables and states correct before entering serialisation.
+                bitStart = true;
+                deadline = timerService->now();
+                GPIO.out_w1ts = X1DATA_MASK;
+                state = FSM_HEADER;
+                if(rcvMsg.modeB)
+                    bitCount = 24;
+                else
+                    bitCount = 16;
+                break;
+
+            case FSM_HEADER:
+                if(bitStart)
+                {
+                    // Send out the header by bringing X1DATA low for 1000us then high for 700uS.
+                    GPIO.out_w1tc = X1DATA_MASK;
+                    delayTimer = pThis->x1Control.modeB ? 400LL : 1000LL;
+                } else
+                {
+                    // Bring high for 700us.
+                    GPIO.out_w1ts = X1DATA_MASK;
+                    delayTimer = pThis->x1Control.modeB ? 200LL : 700LL;
+                    state = FSM_DATA;  // Jump past the Start Bit, I think the header is the actual start bit as there is an error in the X1 Center specs.
+                }
+                bitStart = !bitStart;
+                break;
 
-                case FSM_STARTXMIT:
-                    // Ensure all variables and states correct before entering serialisation.
-                    bitStart = true;
+            // The original X1 Center specification shows a start bit but this doesnt seem necessary, in fact it is interpreted as a data bit, hence the
+            // FSM jumps this state.
+            case FSM_START:
+                if(bitStart)
+                {
+                    // Send out the start bit by bringing X1DATA low for 250us then high for 750uS.
+                    GPIO.out_w1tc = X1DATA_MASK;
+                    delayTimer = pThis->x1Control.modeB ? 250LL : 250LL;
+                } else
+                {
+                    // Bring high for 750us.
                     GPIO.out_w1ts = X1DATA_MASK;
-                    state = FSM_HEADER;
-                    if(rcvMsg.modeB)
-                        bitCount = 24;
-                    else
-                        bitCount = 16;
-                    break;
-
-                case FSM_HEADER:
-                    if(bitStart)
-                    {
-                        // Send out the header by bringing X1DATA low for 1000us then high for 700uS.
-                        GPIO.out_w1tc = X1DATA_MASK;
-                        delayTimer = pThis->x1Control.modeB ? 400LL : 1000LL;
-                    } else
-                    {
-                        // Bring high for 700us.
-                        GPIO.out_w1ts = X1DATA_MASK;
-                        delayTimer = pThis->x1Control.modeB ? 200LL : 700LL;
-                        state = FSM_DATA;  // Jump past the Start Bit, I think the header is the actual start bit as there is an error in the X1 Center specs.
-                    }
-                    bitStart = !bitStart;
-                    break;
+                    delayTimer = pThis->x1Control.modeB ? 250LL : 750LL;
+                    state = FSM_DATA;
+                }
+                bitStart = !bitStart;
+                break;
 
-                // The original X1 Center specification shows a start bit but this doesnt seem necessary, in fact it is interpreted as a data bit, hence the
-                // FSM jumps this state.
-                case FSM_START:
+            case FSM_DATA:
+                if(bitCount > 0)
+                {
                     if(bitStart)
                     {
-                        // Send out the start bit by bringing X1DATA low for 250us then high for 750uS.
+                        // Send out the data bit by bringing X1DATA low for 250us then high for 1750uS when bit = 1 else 750uS when bit = 0.
                         GPIO.out_w1tc = X1DATA_MASK;
+                        delayTimer = 250LL;
                         delayTimer = pThis->x1Control.modeB ? 250LL : 250LL;
                     } else
                     {
-                        // Bring high for 750us.
+                        // Bring X1DATA high...
                         GPIO.out_w1ts = X1DATA_MASK;
-                        delayTimer = pThis->x1Control.modeB ? 250LL : 750LL;
-                        state = FSM_DATA;
-                    }
-                    bitStart = !bitStart;
-                    break;
 
-                case FSM_DATA:
-                    if(bitCount > 0)
-                    {
-                        if(bitStart)
+                        // ... Mode A 1750us as bit = 1, mode B 750uS.
+                        if((rcvMsg.modeB && rcvMsg.keyCode & 0x800000) || (!rcvMsg.modeB && rcvMsg.keyCode & 0x8000))
                         {
-                            // Send out the data bit by bringing X1DATA low for 250us then high for 1750uS when bit = 1 else 750uS when bit = 0.
-                            GPIO.out_w1tc = X1DATA_MASK;
-                            delayTimer = 250LL;
-                            delayTimer = pThis->x1Control.modeB ? 250LL : 250LL;
+                            delayTimer = pThis->x1Control.modeB ? 750LL : 1750LL;
                         } else
+                        // ... Mode A 750us as bit = 0, mode B 250uS.
                         {
-                            // Bring X1DATA high...
-                            GPIO.out_w1ts = X1DATA_MASK;
-
-                            // ... Mode A 1750us as bit = 1, mode B 750uS.
-                            if((rcvMsg.modeB && rcvMsg.keyCode & 0x800000) || (!rcvMsg.modeB && rcvMsg.keyCode & 0x8000))
-                            {
-                                delayTimer = pThis->x1Control.modeB ? 750LL : 1750LL;
-                            } else
-                            // ... Mode A 750us as bit = 0, mode B 250uS.
-                            {
-                                delayTimer = pThis->x1Control.modeB ? 250LL : 750LL;
-                            }
-                            rcvMsg.keyCode = (rcvMsg.keyCode << 1);
-                            bitCount--;
+                            delayTimer = pThis->x1Control.modeB ? 250LL : 750LL;
                         }
-                        bitStart = !bitStart;
-                    } else
-                    {
-                        state = FSM_STOP;
-                    }
-                    break;
-
-                case FSM_STOP:
-                    if(bitStart)
-                    {
-                        // Send out the stop bit, same in Mode A and B, by bringing X1DATA low for 250us then high for 250uS.
-                        GPIO.out_w1tc = X1DATA_MASK;
-                        delayTimer = 250LL;
-                        delayTimer = pThis->x1Control.modeB ? 250LL : 250LL;
-                    } else
-                    {
-                        // Bring high for 250us.
-                        GPIO.out_w1ts = X1DATA_MASK;
-                        delayTimer = pThis->x1Control.modeB ? 250LL : 250LL;
-                        state = FSM_ENDXMIT;
+                        rcvMsg.keyCode = (rcvMsg.keyCode << 1);
+                        bitCount--;
                     }
                     bitStart = !bitStart;
-                    break;
+                } else
+                {
+                    state = FSM_STOP;
+                }
+                break;
 
-                case FSM_ENDXMIT:
-                    // End of critical timing loop, release the core.
-                    portEXIT_CRITICAL(&pThis->x1Mutex);
-                    state = FSM_IDLE;
-                    break;
+            case FSM_STOP:
+                if(bitStart)
+                {
+                    // Send out the stop bit, same in Mode A and B, by bringing X1DATA low for 250us then high for 250uS.
+                    GPIO.out_w1tc = X1DATA_MASK;
+                    delayTimer = 250LL;
+                    delayTimer = pThis->x1Control.modeB ? 250LL : 250LL;
+                } else
+                {
+                    // Bring high for 250us.
+                    GPIO.out_w1ts = X1DATA_MASK;
+                    delayTimer = pThis->x1Control.modeB ? 250LL : 250LL;
+                    state = FSM_ENDXMIT;
+                }
+                bitStart = !bitStart;
+                break;
 
-            }
+            case FSM_ENDXMIT:
+                // End of critical timing loop, release the core.
+                portEXIT_CRITICAL(&pThis->x1Mutex);
+                pThis->keyOutput(rcvMsg.eventTime, xmitStart);
+                pThis->macroFrameSent();
+                state = FSM_IDLE;
+                break;
 
-            // If a new delay is requested, set the value into the timer and start.
-            if(delayTimer > 0LL)
-            {
-                timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0LL);
-                timer_start(TIMER_GROUP_0, TIMER_0);
-            }
+        }
+
+        // If a new delay is requested, wait for the edge on the shared timer. The frame is sent under a critical section so the wait
+        // spins on the free running counter, each edge is placed relative to the previous deadline so loop overhead does not accumulate.
+        if(delayTimer > 0LL)
+        {
+            deadline += delayTimer;
+            timerService->spinUntil(deadline);
         }
 
         // Logic to feed the watchdog if needed. Watchdog disabled in menuconfig but if enabled this will need to be used.
@@ -407,6 +411,15 @@ void X1::selectOption(uint8_t optionCode)
             this->x1Control.modeB = true;
             break;
 
+        // Play a keystroke macro, F1..F4 select the macro file.
+        case PS2_KEY_F1:
+        case PS2_KEY_F2:
+        case PS2_KEY_F3:
+        case PS2_KEY_F4:
+            updated = false;
+            macroPlay(KeyMacro::fileName(this->x1Control.keyMapFileName, optionCode - PS2_KEY_F1 + 1));
+            break;
+
         // Unknown option so ignore.
         default:
             updated = false;
@@ -430,6 +443,7 @@ void X1::selectOption(uint8_t optionCode)
 uint32_t X1::mapKey(uint16_t scanCode)
 {
     // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap = x1Control.keyMap;
     uint32_t  idx;
     uint8_t   keyCode = (scanCode & 0xFF);
     bool      mapped = false;
@@ -487,34 +501,34 @@ uint32_t X1::mapKey(uint16_t scanCode)
         // Loop through the entire conversion table to find a match on this key, if found map to X1 equivalent.
         // switch matrix.
         //
-        for(idx=0, mapped=false, matchExact=false; idx < x1Control.kmeRows && (mapped == false || (mapped == true && matchExact == false)); idx++)
+        for(idx=0, mapped=false, matchExact=false; idx < (uint32_t)keyMap->rows && (mapped == false || (mapped == true && matchExact == false)); idx++)
         {
             // Match key code? Make sure the current machine and keymap match as well.
-            if(x1Control.kme[idx].ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((x1Control.kme[idx].machine == X1_ALL) || ((x1Control.kme[idx].machine & x1Config.params.activeMachineModel) != 0)) && ((x1Control.kme[idx].keyboardModel & x1Config.params.activeKeyboardMap) != 0) && ((x1Control.kme[idx].x1Mode == X1_MODE_A && this->x1Control.modeB == false) || (x1Control.kme[idx].x1Mode == X1_MODE_B && this->x1Control.modeB == true)))
+            if(keyMap->row(idx).ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((keyMap->row(idx).machine == X1_ALL) || ((keyMap->row(idx).machine & x1Config.params.activeMachineModel) != 0)) && ((keyMap->row(idx).keyboardModel & x1Config.params.activeKeyboardMap) != 0) && ((keyMap->row(idx).x1Mode == X1_MODE_A && this->x1Control.modeB == false) || (keyMap->row(idx).x1Mode == X1_MODE_B && this->x1Control.modeB == true)))
             {
                 // If CAPS lock is set in the table and in the scanCode, invert SHIFT so we send the correct value.
-                if((scanCode & PS2_CAPS) && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_CAPS) != 0)
+                if((scanCode & PS2_CAPS) && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS) != 0)
                 {
                     scanCode ^= PS2_SHIFT;
                 }
 
                 // Match Raw, Shift, Function, Control, ALT or ALT-Gr?
-                if( (((x1Control.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((x1Control.kme[idx].ps2Ctrl & PS2CTRL_CTRL) == 0) && ((x1Control.kme[idx].ps2Ctrl & PS2CTRL_KANA)  == 0) && ((x1Control.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((x1Control.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0) && ((x1Control.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
-                    ((scanCode & PS2_SHIFT)                         && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
-                    ((scanCode & PS2_CTRL)                          && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
-                    ((this->x1Control.keyCtrl & X1_CTRL_KANA) == 0  && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_KANA)  != 0) ||
-                    ((this->x1Control.keyCtrl & X1_CTRL_GRAPH) == 0 && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) != 0) ||
-                    ((scanCode & PS2_GUI)                           && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || 
-                    ((scanCode & PS2_FUNCTION)                      && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+                if( (((keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
+                    ((scanCode & PS2_SHIFT)                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                    ((scanCode & PS2_CTRL)                          && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                    ((this->x1Control.keyCtrl & X1_CTRL_KANA) == 0  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  != 0) ||
+                    ((this->x1Control.keyCtrl & X1_CTRL_GRAPH) == 0 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) != 0) ||
+                    ((scanCode & PS2_GUI)                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || 
+                    ((scanCode & PS2_FUNCTION)                      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) )
                 {
                     
                     // Exact entry match, data + control key? On an exact match we only process the first key. On a data only match we fall through to include additional data and control key matches to allow for un-mapped key combinations, ie. Japanese characters.
-                    matchExact = (((scanCode & PS2_SHIFT)                         && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0               && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
-                                 (((scanCode & PS2_CTRL)                          && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
-                                 (((this->x1Control.keyCtrl & X1_CTRL_KANA) == 0  && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_KANA)  != 0) || ((this->x1Control.keyCtrl & X1_CTRL_KANA)  && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_KANA)  == 0)) &&
-                                 (((this->x1Control.keyCtrl & X1_CTRL_GRAPH) == 0 && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) != 0) || ((this->x1Control.keyCtrl & X1_CTRL_GRAPH) && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_GRAPH) == 0)) &&
-                                 (((scanCode & PS2_GUI)                           && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                 && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
-                                 (((scanCode & PS2_FUNCTION)                      && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0            && (x1Control.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0));
+                    matchExact = (((scanCode & PS2_SHIFT)                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0               && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                                 (((scanCode & PS2_CTRL)                          && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                                 (((this->x1Control.keyCtrl & X1_CTRL_KANA) == 0  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  != 0) || ((this->x1Control.keyCtrl & X1_CTRL_KANA)  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_KANA)  == 0)) &&
+                                 (((this->x1Control.keyCtrl & X1_CTRL_GRAPH) == 0 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) != 0) || ((this->x1Control.keyCtrl & X1_CTRL_GRAPH) && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GRAPH) == 0)) &&
+                                 (((scanCode & PS2_GUI)                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                                 (((scanCode & PS2_FUNCTION)                      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0            && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0));
     
                     // RELEASE (PS2_BREAK == 1) or PRESS?
                     if((scanCode & PS2_BREAK))
@@ -538,17 +552,17 @@ uint32_t X1::mapKey(uint16_t scanCode)
                         if(this->x1Control.modeB == true)
                         {
                             // Clear only the bits relevant to the released key.
-                            mappedKey &= ((x1Control.kme[idx].x1Ctrl << 16) | (x1Control.kme[idx].x1Key2 << 8) | x1Control.kme[idx].x1Key);
+                            mappedKey &= ((keyMap->row(idx).x1Ctrl << 16) | (keyMap->row(idx).x1Key2 << 8) | keyMap->row(idx).x1Key);
                         }
                     } else
                     {
                         // Mode A return the key in the table, mode B OR the key to build up a final map.
                         if(this->x1Control.modeB == false)
-                            mappedKey = ((x1Control.kme[idx].x1Ctrl & this->x1Control.keyCtrl) << 8) | x1Control.kme[idx].x1Key;
+                            mappedKey = ((keyMap->row(idx).x1Ctrl & this->x1Control.keyCtrl) << 8) | keyMap->row(idx).x1Key;
                         else
-                            mappedKey |= ((x1Control.kme[idx].x1Ctrl << 16) | (x1Control.kme[idx].x1Key2 << 8) | x1Control.kme[idx].x1Key);
+                            mappedKey |= ((keyMap->row(idx).x1Ctrl << 16) | (keyMap->row(idx).x1Key2 << 8) | keyMap->row(idx).x1Key);
                         mapped = true;
-                        //printf("%02x,%02x,%d,%d\n", (x1Control.kme[idx].x1Ctrl & this->x1Control.keyCtrl), x1Control.kme[idx].x1Key, idx,this->x1Control.modeB);
+                        //printf("%02x,%02x,%d,%d\n", (keyMap->row(idx).x1Ctrl & this->x1Control.keyCtrl), keyMap->row(idx).x1Key, idx,this->x1Control.modeB);
                     }
                 }
             }
@@ -557,6 +571,87 @@ uint32_t X1::mapKey(uint16_t scanCode)
     return(mappedKey);
 }
 
+// Method to give the keymap row a key make selects, -1 if none. Used by the live key monitor, no interface state is changed.
+//
+int X1::lookupKey(uint16_t scanCode)
+{
+    return(macroMapRow(x1Control.keyMap, scanCode & ~PS2_BREAK));
+}
+
+// Method to return the keymap row mapKey selects for a key make in mode A, -1 if none. The selection mirrors mapKey, the first exact match
+// or failing that the last partial match, without updating any state.
+//
+int X1::macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode)
+{
+    // Locals.
+    int       row = -1;
+    bool      matchExact = false;
+
+    for(int idx=0; idx < keyMap->rows && matchExact == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if(kme.ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((kme.machine == X1_ALL) || ((kme.machine & x1Config.params.activeMachineModel) != 0)) && ((kme.keyboardModel & x1Config.params.activeKeyboardMap) != 0) && kme.x1Mode == X1_MODE_A)
+        {
+            if( (((kme.ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((kme.ps2Ctrl & PS2CTRL_CTRL) == 0) && ((kme.ps2Ctrl & PS2CTRL_KANA)  == 0) && ((kme.ps2Ctrl & PS2CTRL_GRAPH) == 0) && ((kme.ps2Ctrl & PS2CTRL_GUI)   == 0) && ((kme.ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
+                ((scanCode & PS2_SHIFT)                         && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                ((scanCode & PS2_CTRL)                          && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                ((this->x1Control.keyCtrl & X1_CTRL_KANA) == 0  && (kme.ps2Ctrl & PS2CTRL_KANA)  != 0) ||
+                ((this->x1Control.keyCtrl & X1_CTRL_GRAPH) == 0 && (kme.ps2Ctrl & PS2CTRL_GRAPH) != 0) ||
+                ((scanCode & PS2_GUI)                           && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) ||
+                ((scanCode & PS2_FUNCTION)                      && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+            {
+                row = idx;
+                matchExact = (((scanCode & PS2_SHIFT)                         && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0               && (kme.ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                             (((scanCode & PS2_CTRL)                          && (kme.ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                && (kme.ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                             (((this->x1Control.keyCtrl & X1_CTRL_KANA) == 0  && (kme.ps2Ctrl & PS2CTRL_KANA)  != 0) || ((this->x1Control.keyCtrl & X1_CTRL_KANA)  && (kme.ps2Ctrl & PS2CTRL_KANA)  == 0)) &&
+                             (((this->x1Control.keyCtrl & X1_CTRL_GRAPH) == 0 && (kme.ps2Ctrl & PS2CTRL_GRAPH) != 0) || ((this->x1Control.keyCtrl & X1_CTRL_GRAPH) && (kme.ps2Ctrl & PS2CTRL_GRAPH) == 0)) &&
+                             (((scanCode & PS2_GUI)                           && (kme.ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                 && (kme.ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                             (((scanCode & PS2_FUNCTION)                      && (kme.ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0            && (kme.ps2Ctrl & PS2CTRL_FUNC)  == 0));
+            }
+        }
+    }
+    return(row);
+}
+
+// Method to give the PS/2 key which types a character on the X1. Mode A sends ASCII so the active keymap is searched in reverse for a row
+// producing the character with at most SHIFT, the key is then mapped forward as mapKey would and only accepted if it selects the same row.
+// Control characters use the PC layout. Mode B reports a map of held keys rather than characters so no printable character is typed in it.
+//
+bool X1::macroKey(char chr, uint16_t &keyCode)
+{
+    // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap;
+    uint16_t  events[KEYMACRO_MAX_EVENTS];
+    uint16_t  scanCode;
+    int       eventCnt;
+    bool      result = false;
+
+    if((uint8_t)chr < 0x20)
+        return(KeyInterface::macroKey(chr, keyCode));
+    if(this->x1Control.modeB == true)
+        return(false);
+
+    keyMapReadBegin();
+    keyMap = x1Control.keyMap;
+    for(int idx=0; idx < keyMap->rows && result == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if(kme.x1Key == (uint8_t)chr && kme.x1Mode == X1_MODE_A && (kme.ps2Ctrl & (PS2CTRL_CTRL | PS2CTRL_KANA | PS2CTRL_GRAPH | PS2CTRL_GUI | PS2CTRL_FUNC)) == 0)
+        {
+            // Key make as the macro delivers it, the Function flag follows the key.
+            keyCode  = kme.ps2KeyCode | ((kme.ps2Ctrl & PS2CTRL_SHIFT) ? PS2_SHIFT : 0);
+            eventCnt = KeyMacro::strokeEvents(keyCode, events);
+            scanCode = events[(eventCnt / 2) - 1];
+            result   = (macroMapRow(keyMap, scanCode) == idx);
+        }
+    }
+    keyMapReadEnd();
+
+    return(result);
+}
+
 // Primary HID thread, running on Core 0.
 // This thread is responsible for receiving HID (PS/2 or BT) keyboard scan codes and mapping them to Sharp X1 equivalent keys, updating state flags as needed.
 // The HID data is received via interrupt. The data to be sent to the X1 is pushed onto a FIFO queue.
@@ -570,6 +665,9 @@ IRAM_ATTR void X1::hidInterface( void * pvParameters )
     // Map the instantiating object so we can access its methods and data.
     X1* pThis = (X1*)pvParameters;
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HIDIF);
+
     // Thread never exits, just polls the keyboard and updates the matrix.
     while(1)
     { 
@@ -580,7 +678,7 @@ IRAM_ATTR void X1::hidInterface( void * pvParameters )
         }
 
         // Check for HID keyboard scan codes.
-        while((scanCode = pThis->hid->read()) != 0)
+        while((scanCode = pThis->readKey()) != 0)
         {
             // Scan Code Breakdown:
             // Define name bit     description
@@ -606,7 +704,9 @@ IRAM_ATTR void X1::hidInterface( void * pvParameters )
             ESP_LOGW(MAPKEYTAG, "SCANCODE:%04x", scanCode);
 
             // Map the PS/2 key to an X1 CTRL + KEY
+            pThis->keyMapReadBegin();
             x1Key = pThis->mapKey(scanCode);
+            pThis->keyMapReadEnd();
             if(x1Key != 0L) { pThis->pushKeyToQueue(pThis->x1Control.modeB, x1Key); }
 
             // Toggle LED to indicate data flow.
@@ -641,95 +741,28 @@ IRAM_ATTR void X1::hidInterface( void * pvParameters )
         }        
 
         // Yield if the suspend flag is set.
-        pThis->yield(10);
+        pThis->yield(pThis->macroPollDelay(10));
     }
 }
 
-// A method to load the keyboard mapping table into memory for use in the interface mapping logic. If no persistence file exists or an error reading persistence occurs, the keymap 
-// uses the internal static default. If no persistence file exists and attempt is made to create it with a copy of the inbuilt static map so that future operations all
-// work with persistence such that modifications can be made.
+// A method to load the keyboard mapping table for use in the interface mapping logic. The inbuilt keymap is used in place from flash and any user changes
+// held in the keymap file are merged with it. A complete keymap file, ie. a browser upload or one saved by earlier firmware, is reduced to the rows which
+// differ from the inbuilt keymap and saved back. The new table is published as a whole, so a reload can take place whilst the HID thread is mapping keys.
 //
 bool X1::loadKeyMap(void)
 {
     // Locals.
     //
-    bool        result = false;
-    int         fileRows = 0;
-    struct stat keyMapFileNameStat;
-
-    // See if the file exists, if it does, get size so we can compute number of mapping rows.
-    if(stat(x1Control.keyMapFileName.c_str(), &keyMapFileNameStat) == -1)
-    {
-        ESP_LOGW(MAINTAG, "No keymap file, using inbuilt definitions.");
-    } else
-    {
-        // Get number of rows in the file.
-        fileRows = keyMapFileNameStat.st_size/sizeof(t_keyMapEntry);
-
-        // Subsequent reloads, delete memory prior to building new map, primarily to conserve precious resources rather than trying the memory allocation trying to realloc and then having to copy.
-        if(x1Control.kme != NULL && x1Control.kme != PS2toX1.kme)
-        {
-            delete x1Control.kme;
-            x1Control.kme = NULL;
-        }
-
-        // Allocate memory for the new keymap table.
-        x1Control.kme = new t_keyMapEntry[fileRows];
-        if(x1Control.kme == NULL)
-        {
-            ESP_LOGW(MAINTAG, "Failed to allocate memory for keyboard map, fallback to inbuilt!");
-        } else
-        {
-            // Open the keymap extension file for binary reading to add data to our map table.
-            std::fstream keyFileIn(x1Control.keyMapFileName.c_str(), std::ios::in | std::ios::binary);
-
-            int idx=0;
-            while(keyFileIn.good())
-            {
-                keyFileIn.read((char *)&x1Control.kme[idx], sizeof(t_keyMapEntry));
-                if(keyFileIn.good())
-                {
-                    idx++;
-                }
-            }
-            // Any errors, we wind back and use the inbuilt mapping table.
-            if(keyFileIn.bad())
-            {
-                keyFileIn.close();
-                ESP_LOGW(MAINTAG, "Failed to read data from keymap extension file:%s, fallback to inbuilt!", x1Control.keyMapFileName.c_str());
-            } else
-            {
-                // No longer need the file.
-                keyFileIn.close();
-               
-                // Max rows in the KME table.
-                x1Control.kmeRows = fileRows;
+    enum KeyMapOverlay::OVERLAY_LOAD result;
 
-                // Good to go, map ready for use with the interface.
-                result = true;
-            }
-        }
-    }
-
-    // Any failures, free up memory and use the inbuilt mapping table.
-    if(result == false)
+    result = buildKeyMap(x1Control.keyMap, x1Control.keyMapFileName, PS2toX1.kme, PS2TBL_X1_MAXROWS);
+    if(result == KeyMapOverlay::OVERLAY_LOAD_COMPLETE)
     {
-        if(x1Control.kme != NULL && x1Control.kme != PS2toX1.kme)
-        {
-            delete x1Control.kme;
-            x1Control.kme = NULL;
-        }
-     
-        // No point allocating memory if no extensions exist or an error occurs, just point to the static table.
-        x1Control.kme = PS2toX1.kme;
-        x1Control.kmeRows = PS2TBL_X1_MAXROWS;
-
-        // Persist the data so that next load comes from file.
         saveKeyMap();
     }
 
-    // Return code. Either memory map was successfully loaded, true or failed, false.
-    return(result);
+    // Return code. True if user changes were loaded from the keymap file, false if the inbuilt keymap is used as is.
+    return(result != KeyMapOverlay::OVERLAY_LOAD_INBUILT);
 }
 
 // Method to save the current keymap out to an extension file.
@@ -738,36 +771,18 @@ bool X1::saveKeyMap(void)
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = x1Control.keyMap;
     bool        result = false;
-    int         idx = 0;
 
-    // Has a map been defined? Cannot save unless loadKeyMap has been called which sets x1Control.kme to point to the internal keymap or a new memory resident map.
+    // Has a map been defined? Cannot save unless loadKeyMap has been called which publishes the internal keymap or a new memory resident map.
     //
-    if(x1Control.kme == NULL)
+    if(keyMap == NULL)
     {
         ESP_LOGW(MAINTAG, "KeyMap hasnt yet been defined, need to call loadKeyMap.");
     } else
     {
-        // Open file for binary writing, trunc specified to clear out the file, we arent appending.
-        std::fstream keyFileOut(x1Control.keyMapFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-
-        // Loop whilst no errors and data rows still not written.
-        while(keyFileOut.good() && idx < x1Control.kmeRows)
-        {
-            keyFileOut.write((char *)&x1Control.kme[idx], sizeof(t_keyMapEntry));
-            idx++;
-        }
-        if(keyFileOut.bad())
-        {
-            ESP_LOGW(MAINTAG, "Failed to write data from the keymap to file:%s, deleting as state is unknown!", x1Control.keyMapFileName.c_str());
-            keyFileOut.close();
-            std::remove(x1Control.keyMapFileName.c_str());
-        } else
-        {
-            // Success.
-            keyFileOut.close();
-            result = true;
-        }
+        // Write out the rows which differ from the inbuilt keymap.
+        result = saveKeyMapOverlay(keyMap, x1Control.keyMapFileName);
     }
    
     // Return code. Either memory map was successfully saved, true or failed, false.
@@ -874,6 +889,10 @@ bool X1::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
             if(std::rename(fileName.c_str(), x1Control.keyMapFileName.c_str()) != 0)
             {
                 result = false;
+            } else
+            {
+                // Apply the new keymap immediately, a key being mapped finishes on the old map.
+                loadKeyMap();
             }
         } else
         {
@@ -885,6 +904,25 @@ bool X1::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
     return(result);
 }
 
+// Method to apply row edits from the web editor to the active keymap. The edited keymap is saved as an overlay and reloaded.
+// Returns the rows in the new keymap, -1 if an edit was invalid or the save failed.
+//
+int X1::editKeyMap(const std::vector<t_keyMapEdit> &edits)
+{
+    // Locals.
+    //
+    int            result = -1;
+
+    if(editKeyMapRows(x1Control.keyMap.load(), x1Control.keyMapFileName, edits) == true)
+    {
+        loadKeyMap();
+        result = x1Control.keyMap.load()->rows;
+    }
+
+    // Send result.
+    return(result);
+}
+
 // Method to return the keymap column names as header strings.
 //
 void X1::getKeyMapHeaders(std::vector<std::string>& headerList)
@@ -995,6 +1033,7 @@ bool X1::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start)
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = x1Control.keyMap;
     bool      result = false;
 
     // If start flag is set, set row to 0.
@@ -1004,19 +1043,19 @@ bool X1::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start)
     }
 
     // Bound check and if still valid, push data onto the vector.
-    if((*row) >= x1Control.kmeRows)
+    if((*row) >= keyMap->rows)
     {
         result = true;
     } else
     {
-        dataArray.push_back(x1Control.kme[*row].ps2KeyCode);
-        dataArray.push_back(x1Control.kme[*row].ps2Ctrl);
-        dataArray.push_back(x1Control.kme[*row].keyboardModel);
-        dataArray.push_back(x1Control.kme[*row].machine);
-        dataArray.push_back(x1Control.kme[*row].x1Mode);
-        dataArray.push_back(x1Control.kme[*row].x1Key);
-        dataArray.push_back(x1Control.kme[*row].x1Key2);
-        dataArray.push_back(x1Control.kme[*row].x1Ctrl);
+        dataArray.push_back(keyMap->row(*row).ps2KeyCode);
+        dataArray.push_back(keyMap->row(*row).ps2Ctrl);
+        dataArray.push_back(keyMap->row(*row).keyboardModel);
+        dataArray.push_back(keyMap->row(*row).machine);
+        dataArray.push_back(keyMap->row(*row).x1Mode);
+        dataArray.push_back(keyMap->row(*row).x1Key);
+        dataArray.push_back(keyMap->row(*row).x1Key2);
+        dataArray.push_back(keyMap->row(*row).x1Ctrl);
         (*row) = (*row) + 1;
     }
 
@@ -1034,6 +1073,10 @@ void X1::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
     KeyInterface::init(getClassName(__PRETTY_FUNCTION__), hdlNVS, hdlLED, hdlHID, ifMode);
 
+    // Create queue for buffering incoming keys prior to transmitting to the X1, it must exist before either thread uses it.
+    xmitQueue = xQueueCreate(MAX_X1_XMIT_KEY_BUF, sizeof(t_xmitQueueMessage));
+    Metrics::addQueue("xmitQueue", xmitQueue);
+
     // Create a task pinned to core 1 which will fulfill the Sharp X1 interface. This task has the highest priority
     // and it will also hold spinlock and manipulate the watchdog to ensure a scan cycle timing can be met. This means 
     // all other tasks running on Core 1 will suspend as needed. The PS/2 controller will be serviced with core 0.
@@ -1041,15 +1084,13 @@ void X1::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     // Core 1 - X1 Interface
     ESP_LOGW(MAINTAG, "Starting x1if thread...");
     ::xTaskCreatePinnedToCore(&this->x1Interface, "x1if", 4096, this, 25, &this->TaskHostIF, 1);
-    vTaskDelay(500);
+    waitReady(KEYIF_READY_HOSTIF);
 
     // Core 0 - Application
     // HID Interface handler thread.
     ESP_LOGW(MAINTAG, "Starting hidIf thread...");
     ::xTaskCreatePinnedToCore(&this->hidInterface, "hidIf", 8192, this, 22, &this->TaskHIDIF, 0);
-
-    // Create queue for buffering incoming keys prior to transmitting to the X1.
-    xmitQueue = xQueueCreate(MAX_X1_XMIT_KEY_BUF, sizeof(t_xmitQueueMessage));
+    waitReady(KEYIF_READY_HIDIF);
 }
 
 // Initialisation routine without hardware.
@@ -1060,8 +1101,7 @@ void X1::init(NVS *hdlNVS, HID *hdlHID)
     x1Control.modeB              = false;
     x1Control.optionSelect       = false;
     x1Control.keyMapFileName     = x1Control.fsPath.append("/").append(X1IF_KEYMAP_FILE);
-    x1Control.kmeRows            = 0;
-    x1Control.kme                = NULL;
+    x1Control.keyMap             = NULL;
     x1Control.persistConfig      = false;
 
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
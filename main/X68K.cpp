@@ -23,6 +23,16 @@
 //            v1.01 May 2022 - Initial release version.
 //            v1.02 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
+//            v1.04 Oct 2026 - Host UART is event driven, the interface blocks on host data and keys together.
+//            v1.05 Oct 2026 - Host command decoder, keyboard LEDs follow the host and key repeat is generated
+//                             locally at the host configured delay and rate.
+//            v1.06 Oct 2026 - Keystroke macros, keys paced by the UART transmit completing and the host
+//                             enabling key data.
+//            v1.07 Oct 2026 - Keymap row edits from the web editor applied without a full table upload.
+//            v1.08 Oct 2026 - Transmit queue depth and overflows reported to the runtime metrics.
+//            v1.09 Oct 2026 - Queue wait and UART hand off latency recorded per key in the runtime metrics.
+//            v1.10 Oct 2026 - Macro characters reverse mapped through the active keymap and the X68000 key legends.
+//            v1.11 Oct 2026 - The host inhibiting key data during macro playback is a reject, slowing playback.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -66,6 +76,21 @@
 #include "sdkconfig.h"
 #include "X68K.h"
 
+// Inbuilt keymap, constant so it is held in flash rather than copied into each instance.
+constexpr X68K::t_keyMap X68K::PS2toX68K;
+
+// Character on each X68000 key, unshifted then shifted, indexed by key code up to SPACE. Keys without a character are 0. Caps lock is
+// assumed off so letters are lower case unshifted.
+static const char x68kLegend[][2] = {
+    { 0x00, 0x00 }, { 0x1B, 0x1B }, { '1',  '!'  }, { '2',  '"'  }, { '3',  '#'  }, { '4',  '$'  }, { '5',  '%'  }, { '6',  '&'  },    // 00-07
+    { '7',  '\'' }, { '8',  '('  }, { '9',  ')'  }, { '0',  0x00 }, { '-',  '='  }, { '^',  '~'  }, { '\\', '|'  }, { '\b', '\b' },    // 08-0F
+    { '\t', '\t' }, { 'q',  'Q'  }, { 'w',  'W'  }, { 'e',  'E'  }, { 'r',  'R'  }, { 't',  'T'  }, { 'y',  'Y'  }, { 'u',  'U'  },    // 10-17
+    { 'i',  'I'  }, { 'o',  'O'  }, { 'p',  'P'  }, { '@',  '`'  }, { '[',  '{'  }, { '\r', '\r' }, { 'a',  'A'  }, { 's',  'S'  },    // 18-1F
+    { 'd',  'D'  }, { 'f',  'F'  }, { 'g',  'G'  }, { 'h',  'H'  }, { 'j',  'J'  }, { 'k',  'K'  }, { 'l',  'L'  }, { ';',  '+'  },    // 20-27
+    { ':',  '*'  }, { ']',  '}'  }, { 'z',  'Z'  }, { 'x',  'X'  }, { 'c',  'C'  }, { 'v',  'V'  }, { 'b',  'B'  }, { 'n',  'N'  },    // 28-2F
+    { 'm',  'M'  }, { ',',  '<'  }, { '.',  '>'  }, { '/',  '?'  }, { '_',  '_'  }, { ' ',  ' '  },                                    // 30-35
+};
+
 // Tag for ESP main application logging.
 #define                         MAINTAG  "x68kkey"
 
@@ -115,6 +140,14 @@ static QueueHandle_t            rcvQueue;
 //       bit [7:4] - Command specifier, set to "0111"
 //       bit [3:0] - Repeat time period in formula, REPEAT TIME = 30 + (((int(bit[3:0]))^2) * 5(ms)). Default repeat time = 110ms
 //
+//     Key data enable
+//       bit [7:1] - Command specifier, set to "0100100"
+//       bit [0]   - 1 = Keyboard may send key data, 0 = key data inhibited.
+//
+//     Repeat is generated by the keyboard, the make code of the last key pressed is resent until it is released. The PS/2 keyboard
+//     typematic is suppressed and the repeat generated here using the host settings. The CAPS LED is mapped to PS/2 CAPS LOCK and the
+//     Kana LED to PS/2 SCROLL LOCK, the remaining LEDs have no PS/2 equivalent.
+//
 // Scan Codes
 // ----------
 // ,---. ,---.    ,-------------------,    ,-------------------.  ,-----------. ,---------------.
@@ -157,9 +190,15 @@ IRAM_ATTR void X68K::pushKeyToQueue(uint32_t key)
     #define             PUSHKEYTAG "pushKeyToQueue"
 
     xmitMsg.keyCode = key;
+    xmitMsg.eventTime = takeKeyEventTime();
+    xmitMsg.queueTime = Metrics::now();
     if( xQueueSend(xmitQueue, (void *)&xmitMsg, 10) != pdPASS)
     {
         ESP_LOGW(PUSHKEYTAG, "Failed to put scancode:%04x into xmitQueue", key);
+        Metrics::count(Metrics::COUNTER_XMIT_QUEUE_FULL);
+    } else
+    {
+        macroFrameQueued();
     }
     return;
 }
@@ -188,9 +227,9 @@ IRAM_ATTR void X68K::x68kInterface( void * pvParameters )
 {
     // Locals.
     t_xmitQueueMessage  rcvMsg;
+    uint32_t            xmitStart;
     uint8_t uartData[128];
-    int     uartXmitCnt;
-    size_t  uartRcvCnt;
+    int     uartRcvCnt;
 
     // Retrieve pointer to object in order to access data.
     X68K* pThis = (X68K*)pvParameters;
@@ -198,12 +237,12 @@ IRAM_ATTR void X68K::x68kInterface( void * pvParameters )
     // Initialise the MUTEX which prevents this core from being released to other tasks.
     //pThis->x68kMutex = portMUX_INITIALIZER_UNLOCKED;
 
-    // Initial delay needed because the xQueue will assert probably on a suspended task ALL if delay not inserted!
-    vTaskDelay(1000);
-
     // Sign on.
     ESP_LOGW(MAINTAG, "Starting X68000 thread.");
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HOSTIF);
+
     // Permanent loop, wait for an incoming message on the key to send queue, read it then transmit to the X68K, repeat!
     for(;;)
     {
@@ -213,50 +252,41 @@ IRAM_ATTR void X68K::x68kInterface( void * pvParameters )
             ESP_LOGW(MAINTAG, "THREAD STACK SPACE(%d)\n",uxTaskGetStackHighWaterMark(NULL));
         }
 
-        if(xQueueReceive(xmitQueue, (void *)&rcvMsg, 0) == pdTRUE)
+        // Block until a key has been mapped or the X68000 sends data, the wait is bounded so a suspend request is honoured.
+        switch(pThis->x68kControl.hostUART.wait(pdMS_TO_TICKS(HOSTUART_WAIT_MS)))
         {
-            //ESP_LOGW(MAINTAG, "Received:%08x\n", rcvMsg.keyCode);
-
-            // Allow for multi byte transmissions, MSB sent first.
-            if(rcvMsg.keyCode != 0x00000000)
-            {
-                uartXmitCnt = 0;
-                while((rcvMsg.keyCode & 0xff000000) == 0x00) { rcvMsg.keyCode = rcvMsg.keyCode << 8; }
-                for(int idx=0; idx < 4 && (rcvMsg.keyCode & 0xff000000) != 0x00; idx++)
+            // Exactly one key is read per event, the queue set signals each queued key.
+            case HostUART::HOSTUART_EVENT_XMIT:
+                if(xQueueReceive(xmitQueue, (void *)&rcvMsg, 0) == pdTRUE)
                 {
-                    if((rcvMsg.keyCode & 0xff000000) != 0)
-                    {
-                        uartData[idx] = (uint8_t)((rcvMsg.keyCode & 0xFF000000) >> 24);
-                        uartXmitCnt++;
-                    }
-                    rcvMsg.keyCode = rcvMsg.keyCode << 8;
+                    xmitStart = Metrics::stage(Metrics::HIST_QUEUE, rcvMsg.queueTime);
+                    pThis->x68kControl.hostUART.writeKey(rcvMsg.keyCode);
+                    pThis->keyOutput(rcvMsg.eventTime, xmitStart);
+                    pThis->macroFrameSent();
                 }
-                if(uartXmitCnt > 0)
-                {
-                    uart_write_bytes(pThis->x68kControl.uartNum, (const char *)uartData, uartXmitCnt);
-                }
-            }
-        }
+                break;
 
-        // Get data from X68000 - send any relevant commands for processing.
-        uart_get_buffered_data_len(pThis->x68kControl.uartNum, &uartRcvCnt);
-        if(uartRcvCnt > 0)
-        {
-            do {
-                uartRcvCnt = uart_read_bytes(pThis->x68kControl.uartNum, uartData, (128 - 1), 20 / portTICK_PERIOD_MS);
-                for(int idx=0; idx < uartRcvCnt; idx++)
+            // Get data from X68000 - send any relevant commands for processing.
+            case HostUART::HOSTUART_EVENT_RCV:
+                while((uartRcvCnt = pThis->x68kControl.hostUART.readData(uartData, sizeof(uartData))) > 0)
                 {
-                    // Filter out polling commands and send valid commands to the rcvQueue.
-                    if(uartData[idx] != 0x40 && uartData[idx] != 0x41)
+                    for(int idx=0; idx < uartRcvCnt; idx++)
                     {
-                        pThis->pushHostCmdToQueue(uartData[idx]);
+                        // Filter out polling commands and send valid commands to the rcvQueue.
+                        if(uartData[idx] != 0x40 && uartData[idx] != 0x41)
+                        {
+                            pThis->pushHostCmdToQueue(uartData[idx]);
+                        }
                     }
                 }
-            } while(uartRcvCnt > 0);
+                break;
+
+            default:
+                break;
         }
        
         // Yield if the suspend flag is set.
-        pThis->yield(50);
+        pThis->yield(0);
 
         // Logic to feed the watchdog if needed. Watchdog disabled in menuconfig but if enabled this will need to be used.
         //TIMERG0.wdt_wprotect=TIMG_WDT_WKEY_VALUE; // write enable
@@ -337,6 +367,15 @@ void X68K::selectOption(uint8_t optionCode)
             this->x68kConfig.params.activeMachineModel = X68K_ALL;
             break;
 
+        // Play a keystroke macro, F1..F4 select the macro file.
+        case PS2_KEY_F1:
+        case PS2_KEY_F2:
+        case PS2_KEY_F3:
+        case PS2_KEY_F4:
+            updated = false;
+            macroPlay(KeyMacro::fileName(this->x68kControl.keyMapFileName, optionCode - PS2_KEY_F1 + 1));
+            break;
+
         // Unknown option so ignore.
         default:
             updated = false;
@@ -360,6 +399,7 @@ void X68K::selectOption(uint8_t optionCode)
 uint32_t X68K::mapKey(uint16_t scanCode)
 {
     // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap = x68kControl.keyMap;
     uint32_t  idx;
     uint8_t   keyCode = (scanCode & 0xFF);
     bool      mapped = false;
@@ -410,28 +450,28 @@ uint32_t X68K::mapKey(uint16_t scanCode)
         // Loop through the entire conversion table to find a match on this key, if found map to X68000 equivalent.
         // switch matrix.
         //
-        for(idx=0, mapped=false, matchExact=false; idx < x68kControl.kmeRows && (mapped == false || (mapped == true && matchExact == false)); idx++)
+        for(idx=0, mapped=false, matchExact=false; idx < (uint32_t)keyMap->rows && (mapped == false || (mapped == true && matchExact == false)); idx++)
         {
             // Match key code? Make sure the current machine and keymap match as well.
-            if(x68kControl.kme[idx].ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((x68kControl.kme[idx].machine == X68K_ALL) || ((x68kControl.kme[idx].machine & x68kConfig.params.activeMachineModel) != 0)) && ((x68kControl.kme[idx].keyboardModel & x68kConfig.params.activeKeyboardMap) != 0))
+            if(keyMap->row(idx).ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((keyMap->row(idx).machine == X68K_ALL) || ((keyMap->row(idx).machine & x68kConfig.params.activeMachineModel) != 0)) && ((keyMap->row(idx).keyboardModel & x68kConfig.params.activeKeyboardMap) != 0))
             {
                 // Match Raw, Shift, Function, Control, ALT or ALT-Gr?
-                if( (((x68kControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((x68kControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL) == 0) && ((x68kControl.kme[idx].ps2Ctrl & PS2CTRL_R_CTRL)  == 0) && ((x68kControl.kme[idx].ps2Ctrl & PS2CTRL_ALTGR) == 0) && ((x68kControl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0) && ((x68kControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
-                    ((scanCode & PS2_SHIFT)                                && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
-                    ((scanCode & PS2_CTRL)                                 && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
-                    ((scanCode & PS2_GUI)                                  && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || 
-                    ((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL)        && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_R_CTRL)!= 0) ||
-                //    ((scanCode & PS2_CAPS)                               && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_CAPS)  != 0) || 
-                    ((scanCode & PS2_FUNCTION)                             && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) )
+                if( (((keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_R_CTRL)  == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_ALTGR) == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0) && ((keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0)) ||
+                    ((scanCode & PS2_SHIFT)                                && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) ||
+                    ((scanCode & PS2_CTRL)                                 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) ||
+                    ((scanCode & PS2_GUI)                                  && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || 
+                    ((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL)        && (keyMap->row(idx).ps2Ctrl & PS2CTRL_R_CTRL)!= 0) ||
+                //    ((scanCode & PS2_CAPS)                               && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS)  != 0) || 
+                    ((scanCode & PS2_FUNCTION)                             && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) )
                 {
                     
                     // Exact entry match, data + control key? On an exact match we only process the first key. On a data only match we fall through to include additional data and control key matches to allow for un-mapped key combinations, ie. Japanese characters.
-                    matchExact = (((scanCode & PS2_SHIFT)                            && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0                         && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
-                                 (((scanCode & PS2_CTRL)                             && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                          && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
-                                 (((scanCode & PS2_GUI)                              && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                           && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
-                                 (((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL)    && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_R_CTRL)!= 0) || ((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL) == 0 && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_R_CTRL)== 0)) &&
-                 //              (((scanCode & PS2_CAPS)                             && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_CAPS)  != 0) || ((scanCode & PS2_GUI) == 0                           && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_CAPS)  == 0)) &&
-                                 (((scanCode & PS2_FUNCTION)                         && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0                      && (x68kControl.kme[idx].ps2Ctrl & PS2CTRL_FUNC)  == 0))
+                    matchExact = (((scanCode & PS2_SHIFT)                            && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) != 0) || ((scanCode & PS2_SHIFT) == 0                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_SHIFT) == 0)) &&
+                                 (((scanCode & PS2_CTRL)                             && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  != 0) || ((scanCode & PS2_CTRL) == 0                          && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CTRL)  == 0)) &&
+                                 (((scanCode & PS2_GUI)                              && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   != 0) || ((scanCode & PS2_GUI) == 0                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_GUI)   == 0)) &&
+                                 (((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL)    && (keyMap->row(idx).ps2Ctrl & PS2CTRL_R_CTRL)!= 0) || ((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL) == 0 && (keyMap->row(idx).ps2Ctrl & PS2CTRL_R_CTRL)== 0)) &&
+                 //              (((scanCode & PS2_CAPS)                             && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS)  != 0) || ((scanCode & PS2_GUI) == 0                           && (keyMap->row(idx).ps2Ctrl & PS2CTRL_CAPS)  == 0)) &&
+                                 (((scanCode & PS2_FUNCTION)                         && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  != 0) || ((scanCode & PS2_FUNCTION) == 0                      && (keyMap->row(idx).ps2Ctrl & PS2CTRL_FUNC)  == 0))
                                  ? true : false;
     
                     // RELEASE (PS2_BREAK == 1) or PRESS?
@@ -445,28 +485,28 @@ uint32_t X68K::mapKey(uint16_t scanCode)
                         {
                             vTaskDelay(100);
                         }
-                        mappedKey = 0x80 | (x68kControl.kme[idx].x68kKey & 0x7F);
+                        mappedKey = 0x80 | (keyMap->row(idx).x68kKey & 0x7F);
                         mapped = true;
                     } else
                     {
                         // Map key actioning any control overrides.
-                        if((x68kControl.kme[idx].x68kCtrl & X68K_CTRL_RELEASESHIFT) != 0)
+                        if((keyMap->row(idx).x68kCtrl & X68K_CTRL_RELEASESHIFT) != 0)
                         {
                             // RELEASESHIFT infers that the X68000 must cancel the current shift status prior to receiving the key code. This is necessary when using foreign keyboards and a character appears
                             // on a shifted key whereas on the original X68000 keyboard the character is the primary key.
                             //
-                            mappedKey = ((0x80 | X68K_KEY_SHIFT) << 16) | 0x00 | ((x68kControl.kme[idx].x68kKey & 0x7F) << 8) | (0x00 | X68K_KEY_SHIFT);
+                            mappedKey = ((0x80 | X68K_KEY_SHIFT) << 16) | 0x00 | ((keyMap->row(idx).x68kKey & 0x7F) << 8) | (0x00 | X68K_KEY_SHIFT);
                         } else
-                        if((x68kControl.kme[idx].x68kCtrl & X68K_CTRL_SHIFT) != 0)
+                        if((keyMap->row(idx).x68kCtrl & X68K_CTRL_SHIFT) != 0)
                         {
                             // SHIFT infers that the X68000 must invoke shift status prior to receiving the key code. This is necessary when using foreign keyboards and a character appears
                             // as a primary key on the foreign keyboard but as a shifted key on the X68000 keyboard.
                             //
-                            mappedKey = ((0x00 | X68K_KEY_SHIFT) << 16) | 0x00 | ((x68kControl.kme[idx].x68kKey & 0x7F) << 8) | (0x80 | X68K_KEY_SHIFT);
+                            mappedKey = ((0x00 | X68K_KEY_SHIFT) << 16) | 0x00 | ((keyMap->row(idx).x68kKey & 0x7F) << 8) | (0x80 | X68K_KEY_SHIFT);
                         }
                         else
                         {
-                            mappedKey = 0x00 | (x68kControl.kme[idx].x68kKey & 0x7F);
+                            mappedKey = 0x00 | (keyMap->row(idx).x68kKey & 0x7F);
                         }
                         mapped = true;
                     }
@@ -477,6 +517,197 @@ uint32_t X68K::mapKey(uint16_t scanCode)
     return(mappedKey);
 }
 
+// Method to give the keymap row a key make selects, -1 if none. Used by the live key monitor, no interface state is changed.
+//
+int X68K::lookupKey(uint16_t scanCode)
+{
+    return(macroMapRow(x68kControl.keyMap, scanCode & ~PS2_BREAK));
+}
+
+// Method to find the keymap row mapKey selects for a key, with the current lock state. Returns -1 if no row matches.
+//
+int X68K::macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode)
+{
+    // Locals.
+    int       row = -1;
+    bool      matchExact = false;
+
+    for(int idx=0; idx < keyMap->rows && matchExact == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        if(kme.ps2KeyCode == (uint8_t)(scanCode&0xFF) && ((kme.machine == X68K_ALL) || ((kme.machine & x68kConfig.params.activeMachineModel) != 0)) && ((kme.keyboardModel & x68kConfig.params.activeKeyboardMap) != 0))
+        {
+            if( (((kme.ps2Ctrl & PS2CTRL_SHIFT) == 0) && ((kme.ps2Ctrl & PS2CTRL_CTRL) == 0) && ((kme.ps2Ctrl & PS2CTRL_R_CTRL) == 0) && ((kme.ps2Ctrl & PS2CTRL_ALTGR) == 0) && ((kme.ps2Ctrl & PS2CTRL_GUI) == 0) && ((kme.ps2Ctrl & PS2CTRL_FUNC) == 0)) ||
+                ((scanCode & PS2_SHIFT)                          && (kme.ps2Ctrl & PS2CTRL_SHIFT)  != 0) ||
+                ((scanCode & PS2_CTRL)                           && (kme.ps2Ctrl & PS2CTRL_CTRL)   != 0) ||
+                ((scanCode & PS2_GUI)                            && (kme.ps2Ctrl & PS2CTRL_GUI)    != 0) ||
+                ((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL)  && (kme.ps2Ctrl & PS2CTRL_R_CTRL) != 0) ||
+                ((scanCode & PS2_FUNCTION)                       && (kme.ps2Ctrl & PS2CTRL_FUNC)   != 0) )
+            {
+                row = idx;
+                matchExact = (((scanCode & PS2_SHIFT)                         && (kme.ps2Ctrl & PS2CTRL_SHIFT)  != 0) || ((scanCode & PS2_SHIFT) == 0                         && (kme.ps2Ctrl & PS2CTRL_SHIFT)  == 0)) &&
+                             (((scanCode & PS2_CTRL)                          && (kme.ps2Ctrl & PS2CTRL_CTRL)   != 0) || ((scanCode & PS2_CTRL) == 0                          && (kme.ps2Ctrl & PS2CTRL_CTRL)   == 0)) &&
+                             (((scanCode & PS2_GUI)                           && (kme.ps2Ctrl & PS2CTRL_GUI)    != 0) || ((scanCode & PS2_GUI) == 0                           && (kme.ps2Ctrl & PS2CTRL_GUI)    == 0)) &&
+                             (((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL) && (kme.ps2Ctrl & PS2CTRL_R_CTRL) != 0) || ((this->x68kControl.keyCtrl & X68K_CTRL_R_CTRL) == 0 && (kme.ps2Ctrl & PS2CTRL_R_CTRL) == 0)) &&
+                             (((scanCode & PS2_FUNCTION)                      && (kme.ps2Ctrl & PS2CTRL_FUNC)   != 0) || ((scanCode & PS2_FUNCTION) == 0                      && (kme.ps2Ctrl & PS2CTRL_FUNC)   == 0));
+            }
+        }
+    }
+    return(row);
+}
+
+// Method to give the PS/2 key which types a character on the X68000. The host receives key codes so the active keymap is searched in reverse
+// for a row whose X68000 key carries the character, with the shift the row leaves the host in. A row which does not need SHIFT is tried both
+// unshifted and shifted as the PS/2 shift reaches the host as its own key. The key is then mapped forward as mapKey would and only accepted
+// if it selects the same row. Control characters use the PC layout.
+//
+bool X68K::macroKey(char chr, uint16_t &keyCode)
+{
+    // Locals.
+    t_keyMapTable<t_keyMapEntry> *keyMap;
+    uint16_t  events[KEYMACRO_MAX_EVENTS];
+    uint16_t  scanCode;
+    int       eventCnt;
+    bool      hostShift;
+    bool      result = false;
+
+    if((uint8_t)chr < 0x20)
+        return(KeyInterface::macroKey(chr, keyCode));
+
+    keyMapReadBegin();
+    keyMap = x68kControl.keyMap;
+    for(int idx=0; idx < keyMap->rows && result == false; idx++)
+    {
+        const t_keyMapEntry &kme = keyMap->row(idx);
+
+        for(int shift=0; shift < 2 && result == false; shift++)
+        {
+            if((kme.ps2Ctrl & (PS2CTRL_CTRL | PS2CTRL_R_CTRL | PS2CTRL_ALTGR | PS2CTRL_GUI)) != 0 || (shift == 0 && (kme.ps2Ctrl & PS2CTRL_SHIFT) != 0) || kme.x68kKey >= sizeof(x68kLegend)/sizeof(x68kLegend[0]))
+                continue;
+
+            hostShift = (shift == 1 && (kme.x68kCtrl & X68K_CTRL_RELEASESHIFT) == 0) || (kme.x68kCtrl & X68K_CTRL_SHIFT) != 0;
+            if(x68kLegend[kme.x68kKey][hostShift ? 1 : 0] == chr)
+            {
+                // Key make as the macro delivers it, the Function flag follows the key.
+                keyCode  = kme.ps2KeyCode | (shift == 1 ? PS2_SHIFT : 0);
+                eventCnt = KeyMacro::strokeEvents(keyCode, events);
+                scanCode = events[(eventCnt / 2) - 1];
+                result   = (macroMapRow(keyMap, scanCode) == idx);
+            }
+        }
+    }
+    keyMapReadEnd();
+
+    return(result);
+}
+
+// Method to decode and action a command received from the X68000.
+//
+void X68K::processHostCmd(uint8_t hostCmd)
+{
+    // Locals.
+    //
+    uint8_t             locks;
+    uint8_t             param = (hostCmd & 0x0F);
+    #define             HOSTCMDTAG "processHostCmd"
+
+    if((hostCmd & X68K_HOSTCMD_LED_MASK) == X68K_HOSTCMD_LED)
+    {
+        // The LED state is resent by the host, only forward changes as a PS/2 LED update stalls the keyboard for several milliseconds.
+        if(hostCmd != x68kControl.host.leds)
+        {
+            x68kControl.host.leds = hostCmd;
+            locks = ((hostCmd & X68K_LED_CAPS) == 0 ? PS2_LOCK_CAPS   : 0x00) |
+                    ((hostCmd & X68K_LED_KANA) == 0 ? PS2_LOCK_SCROLL : 0x00);
+            hid->setKeyboardLEDs(locks, PS2_LOCK_CAPS | PS2_LOCK_SCROLL);
+        }
+    } else
+    if((hostCmd & X68K_HOSTCMD_REPEAT_MASK) == X68K_HOSTCMD_REPEAT_TIME)
+    {
+        x68kControl.host.repeatTime = 30 + (param * param * 5);
+    } else
+    if((hostCmd & X68K_HOSTCMD_REPEAT_MASK) == X68K_HOSTCMD_REPEAT_DELAY)
+    {
+        x68kControl.host.repeatDelay = 200 + (param * 100);
+    } else
+    if((hostCmd & X68K_HOSTCMD_KEY_ENABLE_MASK) == X68K_HOSTCMD_KEY_ENABLE)
+    {
+        // The host stops key data when it cannot take more, during macro playback that is a refused key so playback slows.
+        if(x68kControl.host.keyEnable && (hostCmd & 0x01) == 0 && macroActive())
+            macroHostReject();
+        x68kControl.host.keyEnable = (hostCmd & 0x01) ? true : false;
+    } else
+    if((hostCmd & X68K_HOSTCMD_BRIGHTNESS_MASK) == X68K_HOSTCMD_BRIGHTNESS)
+    {
+        // Keyboard LEDs cannot be dimmed, ignore.
+    } else
+    {
+        ESP_LOGD(HOSTCMDTAG, "Unhandled Host Cmd:%02x", hostCmd);
+    }
+    return;
+}
+
+// Method to track the held keys and the key to be repeated. The most recently pressed key repeats, lock and modifier keys never repeat.
+//
+void X68K::trackKey(uint16_t scanCode, uint32_t x68kKey)
+{
+    // Locals.
+    //
+    uint8_t             keyCode = (scanCode & 0xFF);
+
+    if(scanCode & PS2_BREAK)
+    {
+        x68kControl.host.heldKeys[keyCode >> 5] &= ~(1UL << (keyCode & 0x1F));
+        if(keyCode == x68kControl.host.repeatScan)
+            x68kControl.host.repeatScan = 0;
+    } else
+    {
+        x68kControl.host.heldKeys[keyCode >> 5] |= (1UL << (keyCode & 0x1F));
+        if(x68kKey != 0L && (keyCode < PS2_KEY_NUM || keyCode > PS2_KEY_R_GUI))
+        {
+            x68kControl.host.repeatScan = keyCode;
+            x68kControl.host.repeatKey  = x68kKey;
+            x68kControl.host.repeatNext = xTaskGetTickCount() + pdMS_TO_TICKS(x68kControl.host.repeatDelay);
+        }
+    }
+    return;
+}
+
+// Method to test if the host has taken the last macro key, ie. it has left the UART and the host is accepting key data.
+//
+bool X68K::macroHostIdle(void)
+{
+    return(KeyInterface::macroHostIdle() && x68kControl.hostUART.xmitIdle() && x68kControl.host.keyEnable);
+}
+
+// Method to send a repeat when due. Returns the ticks the HID thread can sleep, bounded by the next repeat.
+//
+TickType_t X68K::processRepeat(void)
+{
+    // Locals.
+    //
+    TickType_t          curTime = xTaskGetTickCount();
+    TickType_t          delay   = pdMS_TO_TICKS(X68K_HID_POLL_MS);
+
+    if(x68kControl.host.repeatScan != 0)
+    {
+        if((int32_t)(curTime - x68kControl.host.repeatNext) >= 0)
+        {
+            if(x68kControl.host.keyEnable)
+                pushKeyToQueue(x68kControl.host.repeatKey);
+
+            // Advance from the due time to hold the cadence, restarting from now if the thread was held off beyond a whole period.
+            x68kControl.host.repeatNext += pdMS_TO_TICKS(x68kControl.host.repeatTime);
+            if((int32_t)(curTime - x68kControl.host.repeatNext) >= 0)
+                x68kControl.host.repeatNext = curTime + pdMS_TO_TICKS(x68kControl.host.repeatTime);
+        }
+        if((x68kControl.host.repeatNext - curTime) < delay)
+            delay = x68kControl.host.repeatNext - curTime;
+    }
+    return(delay);
+}
+
 // Primary HID thread, running on Core 0.
 // This thread is responsible for receiving HID (PS/2 or BT) keyboard scan codes and mapping them to Sharp X68000 equivalent keys, updating state flags as needed.
 // The HID data is received via interrupt. The data to be sent to the X68000 is pushed onto a FIFO queue.
@@ -486,11 +717,15 @@ IRAM_ATTR void X68K::hidInterface( void * pvParameters )
     // Locals.
     uint16_t            scanCode      = 0x0000;
     uint32_t            x68kKey       = 0x00000000;
+    uint8_t             keyCode;
     t_rcvQueueMessage   rcvMsg;
 
     // Map the instantiating object so we can access its methods and data.
     X68K* pThis = (X68K*)pvParameters;
 
+    // Running, release the interface init.
+    pThis->signalReady(KEYIF_READY_HIDIF);
+
     // Thread never exits, just polls the keyboard and updates the matrix.
     while(1)
     { 
@@ -501,7 +736,7 @@ IRAM_ATTR void X68K::hidInterface( void * pvParameters )
         }
 
         // Check for HID keyboard scan codes.
-        while((scanCode = pThis->hid->read()) != 0)
+        while((scanCode = pThis->readKey()) != 0)
         {
             // Scan Code Breakdown:
             // Define name bit     description
@@ -526,9 +761,19 @@ IRAM_ATTR void X68K::hidInterface( void * pvParameters )
             // BREAK code means all keys released so clear out flags and send update.
             ESP_LOGW(MAPKEYTAG, "SCANCODE:%04x",scanCode);
 
-            // Map the PS/2 key to an X68000 CTRL + KEY
+            // Discard a make of a key already held, it is the device typematic, repeats are generated locally at the host rate.
+            keyCode = (scanCode & 0xFF);
+            if((scanCode & PS2_BREAK) == 0 && (pThis->x68kControl.host.heldKeys[keyCode >> 5] & (1UL << (keyCode & 0x1F))))
+            {
+                continue;
+            }
+
+            // Map the PS/2 key to an X68000 CTRL + KEY. Whilst the host inhibits key data only breaks are sent so no key is left held.
+            pThis->keyMapReadBegin();
             x68kKey = pThis->mapKey(scanCode);
-            if(x68kKey != 0L)
+            pThis->keyMapReadEnd();
+            pThis->trackKey(scanCode, x68kKey);
+            if(x68kKey != 0L && (pThis->x68kControl.host.keyEnable || (scanCode & PS2_BREAK)))
             {
                 pThis->pushKeyToQueue(x68kKey);
             }
@@ -539,9 +784,10 @@ IRAM_ATTR void X68K::hidInterface( void * pvParameters )
         }
 
         // Check for incoming host keyboard commands and execute them.
-        if(xQueueReceive(rcvQueue, (void *)&rcvMsg, 0) == pdTRUE)
+        while(xQueueReceive(rcvQueue, (void *)&rcvMsg, 0) == pdTRUE)
         {
             ESP_LOGD(MAINTAG, "Received Host Cmd:%02x\n", rcvMsg.hostCmd);
+            pThis->processHostCmd(rcvMsg.hostCmd);
         }
 
         // NVS writes require both CPU cores to be free so write config out at a known junction.
@@ -570,96 +816,29 @@ IRAM_ATTR void X68K::hidInterface( void * pvParameters )
             pThis->x68kControl.persistConfig = false;
         }
 
-        // Yield if the suspend flag is set.
-        pThis->yield(25);
+        // Send any due repeat then yield, waking in time for the next repeat. Yield is held if the suspend flag is set.
+        pThis->yield(pThis->macroPollDelay(pThis->processRepeat()));
     }
 }
 
-// A method to load the keyboard mapping table into memory for use in the interface mapping logic. If no persistence file exists or an error reading persistence occurs, the keymap 
-// uses the internal static default. If no persistence file exists and attempt is made to create it with a copy of the inbuilt static map so that future operations all
-// work with persistence such that modifications can be made.
+// A method to load the keyboard mapping table for use in the interface mapping logic. The inbuilt keymap is used in place from flash and any user changes
+// held in the keymap file are merged with it. A complete keymap file, ie. a browser upload or one saved by earlier firmware, is reduced to the rows which
+// differ from the inbuilt keymap and saved back. The new table is published as a whole, so a reload can take place whilst the HID thread is mapping keys.
 //
 bool X68K::loadKeyMap(void)
 {
     // Locals.
     //
-    bool        result = false;
-    int         fileRows = 0;
-    struct stat keyMapFileNameStat;
-
-    // See if the file exists, if it does, get size so we can compute number of mapping rows.
-    if(stat(x68kControl.keyMapFileName.c_str(), &keyMapFileNameStat) == -1)
-    {
-        ESP_LOGW(MAINTAG, "No keymap file, using inbuilt definitions.");
-    } else
-    {
-        // Get number of rows in the file.
-        fileRows = keyMapFileNameStat.st_size/sizeof(t_keyMapEntry);
-
-        // Subsequent reloads, delete memory prior to building new map, primarily to conserve precious resources rather than trying the memory allocation trying to realloc and then having to copy.
-        if(x68kControl.kme != NULL && x68kControl.kme != PS2toX68K.kme)
-        {
-            delete x68kControl.kme;
-            x68kControl.kme = NULL;
-        }
-
-        // Allocate memory for the new keymap table.
-        x68kControl.kme = new t_keyMapEntry[fileRows];
-        if(x68kControl.kme == NULL)
-        {
-            ESP_LOGW(MAINTAG, "Failed to allocate memory for keyboard map, fallback to inbuilt!");
-        } else
-        {
-            // Open the keymap extension file for binary reading to add data to our map table.
-            std::fstream keyFileIn(x68kControl.keyMapFileName.c_str(), std::ios::in | std::ios::binary);
+    enum KeyMapOverlay::OVERLAY_LOAD result;
 
-            int idx=0;
-            while(keyFileIn.good())
-            {
-                keyFileIn.read((char *)&x68kControl.kme[idx], sizeof(t_keyMapEntry));
-                if(keyFileIn.good())
-                {
-                    idx++;
-                }
-            }
-            // Any errors, we wind back and use the inbuilt mapping table.
-            if(keyFileIn.bad())
-            {
-                keyFileIn.close();
-                ESP_LOGW(MAINTAG, "Failed to read data from keymap extension file:%s, fallback to inbuilt!", x68kControl.keyMapFileName.c_str());
-            } else
-            {
-                // No longer need the file.
-                keyFileIn.close();
-               
-                // Max rows in the KME table.
-                x68kControl.kmeRows = fileRows;
-
-                // Good to go, map ready for use with the interface.
-                result = true;
-            }
-        }
-    }
-
-    // Any failures, free up memory and use the inbuilt mapping table.
-    if(result == false)
+    result = buildKeyMap(x68kControl.keyMap, x68kControl.keyMapFileName, PS2toX68K.kme, PS2TBL_X68K_MAXROWS);
+    if(result == KeyMapOverlay::OVERLAY_LOAD_COMPLETE)
     {
-        if(x68kControl.kme != NULL && x68kControl.kme != PS2toX68K.kme)
-        {
-            delete x68kControl.kme;
-            x68kControl.kme = NULL;
-        }
-     
-        // No point allocating memory if no extensions exist or an error occurs, just point to the static table.
-        x68kControl.kme = PS2toX68K.kme;
-        x68kControl.kmeRows = PS2TBL_X68K_MAXROWS;
-
-        // Persist the data so that next load comes from file.
         saveKeyMap();
     }
 
-    // Return code. Either memory map was successfully loaded, true or failed, false.
-    return(result);
+    // Return code. True if user changes were loaded from the keymap file, false if the inbuilt keymap is used as is.
+    return(result != KeyMapOverlay::OVERLAY_LOAD_INBUILT);
 }
 
 // Method to save the current keymap out to an extension file.
@@ -668,36 +847,18 @@ bool X68K::saveKeyMap(void)
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = x68kControl.keyMap;
     bool        result = false;
-    int         idx = 0;
 
-    // Has a map been defined? Cannot save unless loadKeyMap has been called which sets x68kControl.kme to point to the internal keymap or a new memory resident map.
+    // Has a map been defined? Cannot save unless loadKeyMap has been called which publishes the internal keymap or a new memory resident map.
     //
-    if(x68kControl.kme == NULL)
+    if(keyMap == NULL)
     {
         ESP_LOGW(MAINTAG, "KeyMap hasnt yet been defined, need to call loadKeyMap.");
     } else
     {
-        // Open file for binary writing, trunc specified to clear out the file, we arent appending.
-        std::fstream keyFileOut(x68kControl.keyMapFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
-
-        // Loop whilst no errors and data rows still not written.
-        while(keyFileOut.good() && idx < x68kControl.kmeRows)
-        {
-            keyFileOut.write((char *)&x68kControl.kme[idx], sizeof(t_keyMapEntry));
-            idx++;
-        }
-        if(keyFileOut.bad())
-        {
-            ESP_LOGW(MAINTAG, "Failed to write data from the keymap to file:%s, deleting as state is unknown!", x68kControl.keyMapFileName.c_str());
-            keyFileOut.close();
-            std::remove(x68kControl.keyMapFileName.c_str());
-        } else
-        {
-            // Success.
-            keyFileOut.close();
-            result = true;
-        }
+        // Write out the rows which differ from the inbuilt keymap.
+        result = saveKeyMapOverlay(keyMap, x68kControl.keyMapFileName);
     }
    
     // Return code. Either memory map was successfully saved, true or failed, false.
@@ -804,6 +965,10 @@ bool X68K::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
             if(std::rename(fileName.c_str(), x68kControl.keyMapFileName.c_str()) != 0)
             {
                 result = false;
+            } else
+            {
+                // Apply the new keymap immediately, a key being mapped finishes on the old map.
+                loadKeyMap();
             }
         } else
         {
@@ -815,6 +980,25 @@ bool X68K::closeAndCommitKeyMapFile(std::fstream &outFile, bool cleanupOnly)
     return(result);
 }
 
+// Method to apply row edits from the web editor to the active keymap. The edited keymap is saved as an overlay and reloaded.
+// Returns the rows in the new keymap, -1 if an edit was invalid or the save failed.
+//
+int X68K::editKeyMap(const std::vector<t_keyMapEdit> &edits)
+{
+    // Locals.
+    //
+    int            result = -1;
+
+    if(editKeyMapRows(x68kControl.keyMap.load(), x68kControl.keyMapFileName, edits) == true)
+    {
+        loadKeyMap();
+        result = x68kControl.keyMap.load()->rows;
+    }
+
+    // Send result.
+    return(result);
+}
+
 // Method to return the keymap column names as header strings.
 //
 void X68K::getKeyMapHeaders(std::vector<std::string>& headerList)
@@ -916,6 +1100,7 @@ bool X68K::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start)
 {
     // Locals.
     //
+    t_keyMapTable<t_keyMapEntry> *keyMap = x68kControl.keyMap;
     bool      result = false;
 
     // If start flag is set, set row to 0.
@@ -925,17 +1110,17 @@ bool X68K::getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start)
     }
 
     // Bound check and if still valid, push data onto the vector.
-    if((*row) >= x68kControl.kmeRows)
+    if((*row) >= keyMap->rows)
     {
         result = true;
     } else
     {
-        dataArray.push_back(x68kControl.kme[*row].ps2KeyCode);
-        dataArray.push_back(x68kControl.kme[*row].ps2Ctrl);
-        dataArray.push_back(x68kControl.kme[*row].keyboardModel);
-        dataArray.push_back(x68kControl.kme[*row].machine);
-        dataArray.push_back(x68kControl.kme[*row].x68kKey);
-        dataArray.push_back(x68kControl.kme[*row].x68kCtrl);
+        dataArray.push_back(keyMap->row(*row).ps2KeyCode);
+        dataArray.push_back(keyMap->row(*row).ps2Ctrl);
+        dataArray.push_back(keyMap->row(*row).keyboardModel);
+        dataArray.push_back(keyMap->row(*row).machine);
+        dataArray.push_back(keyMap->row(*row).x68kKey);
+        dataArray.push_back(keyMap->row(*row).x68kCtrl);
         (*row) = (*row) + 1;
     }
 
@@ -966,18 +1151,19 @@ void X68K::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
         .source_clk                 = UART_SCLK_APB,
     };
 
-    // Install UART driver. Use RX/TX buffers without event queue. 
-    ESP_ERROR_CHECK(uart_driver_install(x68kControl.uartNum, x68kControl.uartBufferSize, x68kControl.uartBufferSize, 0, NULL, 0));
-
-    // Configure UART parameters and pin assignments, software flow control, not RTS/CTS.
-    ESP_ERROR_CHECK(uart_param_config(x68kControl.uartNum, &uartConfig));
-    ESP_ERROR_CHECK(uart_set_pin(x68kControl.uartNum, CONFIG_HOST_KDB0, CONFIG_HOST_KDB1, -1, -1));
-
     // Create queue for buffering incoming HID keys prior to transmitting to the X68000.
     xmitQueue = xQueueCreate(MAX_X68K_XMIT_KEY_BUF, sizeof(t_xmitQueueMessage));
+    Metrics::addQueue("xmitQueue", xmitQueue);
     // Create queue for buffering incoming X68000 data for later processing.
     rcvQueue  = xQueueCreate(MAX_X68K_RCV_KEY_BUF, sizeof(t_rcvQueueMessage));
 
+    // Install UART driver with an event queue, configure parameters and pin assignments, software flow control, not RTS/CTS.
+    // The interface thread blocks on the UART events and the key queue together.
+    x68kControl.hostUART.init((uart_port_t)x68kControl.uartNum, &uartConfig, CONFIG_HOST_KDB0, CONFIG_HOST_KDB1, x68kControl.uartBufferSize, x68kControl.uartQueueSize, xmitQueue, MAX_X68K_XMIT_KEY_BUF);
+
+    // Key repeat is generated by the interface at the host configured rate, slow the keyboard typematic.
+    hid->setHostRepeat(true);
+
     // Create a task pinned to core 1 which will fulfill the Sharp X68000 interface. This task has the highest priority
     // and it will also hold spinlock and manipulate the watchdog to ensure a scan cycle timing can be met. This means 
     // all other tasks running on Core 1 will suspend as needed. The HID devices will be serviced with core 0.
@@ -985,12 +1171,13 @@ void X68K::init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID)
     // Core 1 - X68000 Interface
     ESP_LOGW(MAINTAG, "Starting x68kif thread...");
     ::xTaskCreatePinnedToCore(&this->x68kInterface, "x68kif", 4096, this, 25, &this->TaskHostIF, 1);
-    vTaskDelay(500);
+    waitReady(KEYIF_READY_HOSTIF);
 
     // Core 0 - Application
     // HID Interface handler thread.
     ESP_LOGW(MAINTAG, "Starting hidIf thread...");
     ::xTaskCreatePinnedToCore(&this->hidInterface, "hidIf", 8192, this, 22, &this->TaskHIDIF, 0);
+    waitReady(KEYIF_READY_HIDIF);
 }
 
 // Initialisation routine without hardware.
@@ -1003,9 +1190,16 @@ void X68K::init(NVS *hdlNVS, HID *hdlHID)
     x68kControl.uartBufferSize      = 256;
     x68kControl.uartQueueSize       = 10;
     x68kControl.keyMapFileName      = x68kControl.fsPath.append("/").append(X68KIF_KEYMAP_FILE);
-    x68kControl.kmeRows             = 0;
-    x68kControl.kme                 = NULL;
+    x68kControl.keyMap              = NULL;
     x68kControl.persistConfig       = false;
+    x68kControl.host.leds           = 0xFF;
+    x68kControl.host.keyEnable      = true;
+    x68kControl.host.repeatDelay    = X68K_REPEAT_DELAY_DEFAULT;
+    x68kControl.host.repeatTime     = X68K_REPEAT_TIME_DEFAULT;
+    x68kControl.host.repeatScan     = 0;
+    x68kControl.host.repeatKey      = 0x00000000;
+    x68kControl.host.repeatNext     = 0;
+    memset(x68kControl.host.heldKeys, 0x00, sizeof(x68kControl.host.heldKeys));
 
     // Invoke the prototype init which initialises common variables and devices shared by all subclass. 
     KeyInterface::init(getClassName(__PRETTY_FUNCTION__), hdlNVS, hdlHID);
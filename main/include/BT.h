@@ -10,6 +10,7 @@
 // Copyright:       (c) 2022 Philip Smart <philip.smart@net2net.org>
 //
 // History:         Mar 2022 - Initial write.
+//                  Oct 2026 - Internals protected so the scan result tables can be driven from a derived class.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -51,6 +52,12 @@
 class BT {
     #define SIZEOF_ARRAY(a) (sizeof(a) / sizeof(*a))
 
+    // Constants.
+    #define BT_SCAN_TABLE_SIZE             32                                      // Slots in a scan result table, must be a power of 2.
+    #define BT_SCAN_MAX_ENTRIES            24                                      // Entries held before the least recently seen is evicted, bounds the probe length.
+    #define BT_SCAN_NAME_LEN               32                                      // Maximum stored device name length.
+    #define BT_SCAN_MAX_AGE                30000                                   // Time in mS after which an unseen device is dropped.
+
     public:
         typedef void t_pairingHandler(uint32_t code, uint8_t trigger);
 
@@ -89,7 +96,7 @@ class BT {
         inline uint8_t                     getBatteryLevel() { return btCtrl.batteryLevel; }
         inline void                        setBatteryLevel(uint8_t level) { btCtrl.batteryLevel = level; }
         
-    private:
+    protected:
         static constexpr char const        *TAG = "BT";
       #ifdef CONFIG_CLASSIC_BT_ENABLED
         const char                        *gap_bt_prop_type_names[5] = { "", "BDNAME", "COD", "RSSI", "EIR" };
@@ -109,12 +116,40 @@ class BT {
         static const esp_bt_mode_t         HIDH_BT_MODE              = (esp_bt_mode_t) 0x02;
         static const esp_bt_mode_t         HIDH_BTDM_MODE            = (esp_bt_mode_t) 0x03;
 
+        // Structure to hold a scanned device within a scan result table. Fixed size so the GAP callbacks never allocate.
+        typedef struct {
+            bool                           used;
+            esp_bd_addr_t                  bda;
+            char                           name[BT_SCAN_NAME_LEN];
+            uint8_t                        nameLen;
+            int8_t                         rssi;                 // Smoothed RSSI, averaged over advertisements.
+            esp_hid_usage_t                usage;
+            esp_hid_transport_t            transport;
+            TickType_t                     lastSeen;             // Tick of the last advertisement, used for aging and LRU eviction.
+            union {
+                struct {
+                    esp_bt_cod_t           cod;
+                    esp_bt_uuid_t          uuid;
+                } bt;
+                struct {
+                    esp_ble_addr_type_t    addr_type;
+                    uint16_t               appearance;
+                } ble;
+            };
+        } t_scanEntry;
+
+        // Structure of a scan result table, open addressed with linear probing on a hash of the BDA.
+        typedef struct {
+            t_scanEntry                    entry[BT_SCAN_TABLE_SIZE];
+            int                            count;
+        } t_scanTable;
+
         // Structure to maintain control variables.
         typedef struct {
           #ifdef CONFIG_CLASSIC_BT_ENABLED
-            std::vector<t_scanListItem>    btScanList;
+            t_scanTable                    btScanTable;
           #endif
-            std::vector<t_scanListItem>    bleScanList;
+            t_scanTable                    bleScanTable;
 
             t_pairingHandler              *pairingHandler;
             esp_hidh_dev_t                *hidhDevHdl;
@@ -136,7 +171,11 @@ class BT {
         // Prototypes.
         static void                        processBTGapEvent(esp_bt_gap_cb_event_t event,  esp_bt_gap_cb_param_t * param);
         static void                        processBLEGapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t * param);
-        t_scanListItem*                    findValidScannedDevice(esp_bd_addr_t bda, std::vector<t_scanListItem> &scanList);
+        static uint32_t                    hashBDA(const uint8_t *bda);
+        t_scanEntry*                       findScanEntry(t_scanTable &table, const uint8_t *bda);
+        t_scanEntry*                       insertScanEntry(t_scanTable &table, const uint8_t *bda);
+        void                               removeScanEntry(t_scanTable &table, int pos);
+        void                               copyScanResults(t_scanTable &table, TickType_t since, std::vector<t_scanListItem> &scanList);
         void                               processBLEDeviceScanResult(esp_ble_gap_cb_param_t * scan_rst);
         void                               addBLEScanDevice(esp_bd_addr_t bda, esp_ble_addr_type_t addr_type, uint16_t appearance, uint8_t *name, uint8_t name_len, int rssi);
 
@@ -12,6 +12,10 @@
 // History:         Mar 2022 - Initial write.
 //                  Jun 2022 - Updated with latest findings. Now checks the bonded list and opens 
 //                             connections or scans for new devices if no connections exist. 
+//                  Oct 2026 - Processed keys carry the time of their report for latency metrics.
+//                             Device list guarded by a mutex, opens no longer race the HID event task.
+//                             Keyboard LEDs sent to all open keyboards from the key processing thread.
+//                             Internals protected so the key translation can be driven from a derived class.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -43,6 +47,7 @@
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_event.h"
+#include "esp_timer.h"
 #include "esp_bt.h"
 #include "esp_bt_defs.h"
 #include "esp_bt_main.h"
@@ -52,6 +57,7 @@
 #include "esp_gap_ble_api.h"
 #include "PS2KeyAdvanced.h"
 #include "PS2Mouse.h"
+#include "NVS.h"
 #include "BT.h"
 
 // Keyboard is a sub-class of BT which provides methods to setup BT for use by a keyboard.
@@ -66,6 +72,16 @@ class BTHID : public BT  {
     #define MAX_MOUSE_DATA_BYTES           7
     #define MAX_BT2PS2_MAP_ENTRIES         179 
     #define MAX_BTMEDIA2PS2_MAP_ENTRIES    8
+    #define MAX_KEYBOARD_EVENTS            24                                      // Largest number of PS/2 events a single report can generate.
+    #define MAX_KEY_QUEUE_SIZE             32                                      // Size of the processed key queue, must hold at least one batch.
+    #define MAX_BT_KEY_DEVICES             4                                       // Maximum keyboard/media devices reporting concurrently.
+    #define RAW_KEY_QUEUE_PER_DEVICE       10                                      // Raw report queue depth allowed for each device.
+    #define MAX_RAW_KEY_QUEUE_SIZE         (MAX_BT_KEY_DEVICES * RAW_KEY_QUEUE_PER_DEVICE)
+    #define BTHID_NVS_KEY                  "BTHID"                                 // NVS key of the last connected device record.
+    #define BTHID_LASTDEV_VALID            0xB7                                    // Marker of a valid last connected device record.
+    #define BT_KEYMAP_WORDS                8                                       // 256 bit usage bitmap, one bit per scan code.
+    #define MAX_BT2PS2_OVERRIDES           16                                      // Maximum mapping entries qualified by a BT control state.
+    #define BT_MEDIA_BITS                  24                                      // Width of the media control key bitmap.
 
     // LED's
     #define BT_LED_NUMLOCK                 0x01
@@ -375,13 +391,21 @@ class BTHID : public BT  {
                                            uint8_t         keys[MAX_KEYBOARD_DATA_BYTES];
                                            uint8_t         length;
                                            bool            cControl;
+                                           bool            closed;
                                            esp_hidh_dev_t *hdlDev;
+                                           uint32_t        time;                  // Time the report was received, Metrics::now().
         };
 
+        // Processed key, with the time of the report which generated it.
+        typedef struct {
+            uint16_t                       key;
+            uint32_t                       time;
+        } t_keyEvent;
+
         // Prototypes.
                                            BTHID(void);
         virtual                            ~BTHID(void);
-        bool                               setup(t_pairingHandler *handler);
+        bool                               setup(t_pairingHandler *handler, NVS *hdlNVS = nullptr);
         bool                               openDevice(esp_bd_addr_t bda, esp_hid_transport_t transport, esp_ble_addr_type_t addrType);
         bool                               closeDevice(esp_bd_addr_t bda);
         void                               checkBTDevices(void);
@@ -390,6 +414,8 @@ class BTHID : public BT  {
         bool                               setSampleRate(enum PS2Mouse::PS2_SAMPLING rate);
         void                               processBTKeys(void);
         uint16_t                           getKey(uint32_t timeout = 0);
+        uint32_t                           getKeyTime(void);
+        void                               setKeyboardLEDs(uint8_t leds, uint8_t mask);
 
         // Method to register an object method for callback with context.
         template<typename A, typename B>
@@ -398,13 +424,19 @@ class BTHID : public BT  {
             btHIDCtrl.ms.mouseDataCallback = bind(func_ptr, obj_ptr, 1, std::placeholders::_1);
         }
 
+        // Method to merge the LEDs selected by mask into an LED status byte, the remaining LEDs are unchanged.
+        static inline uint8_t mergeLEDs(uint8_t current, uint8_t leds, uint8_t mask)
+        {
+            return((current & ~mask) | (leds & mask));
+        }
+
         // Template to aid in conversion of an enum to integer.
         template <typename E> constexpr typename std::underlying_type<E>::type to_underlying(E e) noexcept
         {
             return static_cast<typename std::underlying_type<E>::type>(e);
         }
 
-    private:
+    protected:
         static constexpr char const * TAG = "BTHID";
 
         // Structure to hold details of an active or post-active connection.
@@ -416,8 +448,25 @@ class BTHID : public BT  {
             esp_hidh_dev_t                *hidhDevHdl;
             uint32_t                       nextCheckTime;
             bool                           open;
+            bool                           closing;                               // Close requested, the handle is released by the close event.
         } t_activeDev;
        
+        // Structure to hold the last connected device, persisted so it can be reopened directly on the next power up.
+        typedef struct {
+            uint8_t                        valid;                                 // BTHID_LASTDEV_VALID when the record is set.
+            esp_bd_addr_t                  bda;
+            esp_hid_transport_t            transport;
+            esp_ble_addr_type_t            addrType;
+        } t_lastDevice;
+
+        // Structure to hold the last report state of a keyboard device, each device is diffed against its own reports.
+        typedef struct {
+            esp_hidh_dev_t                *hdlDev;                                // Device owning the state, NULL = free slot.
+            uint32_t                       lastKeyMap[BT_KEYMAP_WORDS];           // Usage bitmap of the last report, required to generate a PS/2 break event when a key is released.
+            uint8_t                        lastModifiers;                         // Modifier byte of the last report.
+            uint32_t                       lastMediaKey;                          // Required to detect changes in the media control keys, ie. release.
+        } t_devKeyState;
+
         // Structure to encapsulate a single key map from Bluetooth to PS/2.
         typedef struct {
             uint8_t                        btKeyCode;
@@ -426,6 +475,13 @@ class BTHID : public BT  {
             uint16_t                       ps2Ctrl;
         } t_keyMapEntry;        
 
+        // Structure to hold a mapping which only applies in a specific BT control state, ie. keypad with NUM LOCK.
+        typedef struct {
+            uint8_t                        btKeyCode;
+            uint16_t                       btCtrl;
+            uint16_t                       ps2Key;
+        } t_keyOverride;
+
         // Structure to encapsulate the entire static keyboard mapping table.
         typedef struct {
             t_keyMapEntry                  kme[MAX_BT2PS2_MAP_ENTRIES];
@@ -447,6 +503,18 @@ class BTHID : public BT  {
         typedef struct {
             // Array of active devices which connect with the SharpKey.
             std::vector<t_activeDev>       devices;
+            SemaphoreHandle_t              devMutex;                              // Guards devices, updated by the HID event task, reconnect thread and HID thread.
+
+            // Fast reconnect, the last connected device is opened directly at boot whilst the normal discovery continues.
+            struct {
+                t_lastDevice               lastDev;                               // Last connected device as held in NVS.
+                t_lastDevice               directDev;                             // Device being opened directly, the boot value of lastDev.
+                bool                       dirty;                                 // Last device changed, to be persisted.
+                volatile bool              active;                                // Direct open of the last device in progress.
+                int64_t                    setupTime;                             // Boot timeline, uS since boot, of BT setup, first open and first key.
+                int64_t                    openTime;
+                int64_t                    keyTime;
+            } reconnect;
 
             // Keyboard handling.
             struct {
@@ -454,15 +522,34 @@ class BTHID : public BT  {
                 xQueueHandle               rawKeyQueue;
                 xQueueHandle               keyQueue;
 
-                uint8_t                    lastKeys[MAX_KEYBOARD_DATA_BYTES];     // Required to generate a PS/2 break event when a key is released.
-                uint32_t                   lastMediaKey;                          // Required to detect changes in the media control keys, ie. release.
+                // Per device report state, merged into a single view by reference counting each key across the devices holding it.
+                t_devKeyState              devState[MAX_BT_KEY_DEVICES];
+                uint8_t                    keyRefCnt[256];                        // Number of devices holding each BT scan code.
+                uint8_t                    modRefCnt[8];                          // Number of devices holding each modifier, indexed as btModifierMap.
+                uint8_t                    mediaRefCnt[BT_MEDIA_BITS];            // Number of devices holding each media key bit.
+                uint8_t                    modifiers;                             // Merged modifier byte.
+                uint32_t                   rawOverflows;                          // Reports lost as the raw queue was full.
+                uint32_t                   devOverflows;                          // Reports lost as the device state table was full.
+                uint32_t                   reportedOverflows;                     // Overflow total last logged.
                 uint16_t                   btFlags;                               // Bluetooth control flags.
                 uint16_t                   ps2Flags;                              // PS/2 translated control flags.
                 uint8_t                    statusLED;                             // Keyboard LED state.
+                uint8_t                    ledPending;                            // Host LED request awaiting the key processing thread.
+                uint8_t                    ledPendingMask;                        // LEDs selected by the pending request, 0 = none.
+                portMUX_TYPE               ledMutex;                              // Guards the pending LED request.
+                uint32_t                   keyTime;                               // Report time of the key last returned by getKey.
                 t_keyMapEntry             *kme;                                   // Pointer to the mapping array.
                 t_mediaMapEntry           *kmeMedia;                              // Pointer to the media key mapping array.
                 int                        kmeRows;                               // Number of entries in the BT to PS/2 mapping table.
                 int                        kmeMediaRows;                          // Number of entries in the BT to PS/2 media key mapping table.
+
+                // Lookup tables compiled from the mapping tables, BT scan codes are translated with direct indexing.
+                uint16_t                   usageMap[256];                         // PS/2 key and function flag per BT scan code, 0 = not mapped.
+                uint32_t                   overrideMap[BT_KEYMAP_WORDS];          // Bitmap of scan codes which have BT control qualified entries.
+                t_keyOverride              overrides[MAX_BT2PS2_OVERRIDES];       // BT control qualified entries, taking precedence over usageMap.
+                int                        overrideCnt;                           // Number of entries in overrides.
+                uint16_t                   modifierFlags[256];                    // PS/2 control flags per BT modifier state.
+                uint16_t                   mediaMap[BT_MEDIA_BITS];               // PS/2 key and control flags per media key bit.
             } kbd;
 
             // Mouse handling.
@@ -477,6 +564,9 @@ class BTHID : public BT  {
                 std::function<void(PS2Mouse::MouseData)> mouseDataCallback;            
             } ms;
 
+            // NVS persistence object, NULL if the last device is not to be persisted.
+            NVS                            *nvs;
+
             BTHID                          *pThis;
         } t_btHIDCtrl;
 
@@ -486,10 +576,19 @@ class BTHID : public BT  {
         // Prototypes.
         static void                        hidh_callback(void * handler_args, esp_event_base_t base, int32_t id, void * event_data);
         void                               pushKeyToFIFO(esp_hid_usage_t src, esp_hidh_dev_t *hdlDev, uint8_t *keys, uint8_t size);
-        void                               setStatusLED(esp_hidh_dev_t *dev, uint8_t led);
-        void                               clearStatusLED(esp_hidh_dev_t *dev, uint8_t led);
+        void                               setStatusLED(uint8_t led);
+        void                               clearStatusLED(uint8_t led);
+        void                               sendKeyboardLEDs(esp_hidh_dev_t *hdlDev);
+        void                               applyKeyboardLEDs(void);
         uint16_t                           mapBTMediaToPS2(uint32_t key);
         uint16_t                           mapBTtoPS2(uint8_t key);
+        void                               buildKeyMaps(void);
+        static void                        reconnectTask(void *pvParameters);
+        void                               persistLastDevice(void);
+        bool                               deviceOpen(void);
+        t_devKeyState                     *getDevKeyState(esp_hidh_dev_t *hdlDev, bool allocate);
+        void                               processKeyReport(t_devKeyState *dev, uint8_t *keys, uint16_t *batch, int &batchCnt);
+        void                               processMediaReport(t_devKeyState *dev, uint32_t mediaKey, uint16_t *batch, int &batchCnt);
         inline uint32_t milliSeconds(void)
         {
             return( (uint32_t) (clock() ) );
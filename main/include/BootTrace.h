@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            BootTrace.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for the boot timeline trace. Each start up stage records a timestamp, the
+//                  completed timeline of an interface boot is logged and retained in RTC memory across a
+//                  software restart so it can be viewed from the WiFi web interface.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOTTRACE_H
+#define BOOTTRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "esp_log.h"
+#include "esp_system.h"
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to record the start up timeline, all methods are static as there is only one boot.
+class BootTrace  {
+
+    // Constants.
+    #define BOOTTRACE_VERSION           1.00
+    #define BOOTTRACE_MAX_STAGES        16                              // Maximum number of recorded stages, further stages are ignored.
+    #define BOOTTRACE_STAGE_LEN         24                              // Maximum length of a stage name including terminator.
+    #define BOOTTRACE_MAGIC             0x54425453                      // Marks a valid timeline in RTC memory, which is random after power on.
+
+    public:
+        // Prototypes.
+        static void                     mark(const char *stage);
+        static void                     commit(void);
+        static void                     getTimeline(std::vector<std::pair<std::string, uint32_t>>& timeline);
+
+        // Method to return the class version number.
+        static float version(void)
+        {
+            return(BOOTTRACE_VERSION);
+        }
+
+    protected:
+
+    private:
+        static constexpr char const    *TAG = "BootTrace";
+
+        // A recorded stage, time is in uS since the application started.
+        typedef struct {
+            char                        stage[BOOTTRACE_STAGE_LEN];
+            uint32_t                    timeUs;
+        } t_bootStage;
+
+        // Structure to hold a timeline.
+        typedef struct {
+            uint32_t                    magic;
+            uint32_t                    stageCount;
+            t_bootStage                 stage[BOOTTRACE_MAX_STAGES];
+        } t_bootTimeline;
+
+        // Timeline of this boot, and the last completed interface boot retained across a software restart.
+        static t_bootTimeline           current;
+        static t_bootTimeline           lastBoot;
+};
+#endif // BOOTTRACE_H
@@ -14,6 +14,13 @@
 //            v1.02 Jun 2022 - Updates to support Bluetooth keyboard and mouse. The mouse can be
 //                             a primary device or a secondary device for hosts which support
 //                             keyboard and mouse over one physical port.
+//            v1.03 Oct 2026 - Device receive time of each key read, for latency metrics.
+//            v1.04 Oct 2026 - Configuration saved before mouse acceleration was added is migrated.
+//            v1.05 Oct 2026 - PS/2 only keyboard for WiFi mode, no Bluetooth fallback as the radio is in use.
+//            v1.06 Oct 2026 - A PS/2 mouse configured at startup is marked active so it is not reset again,
+//                             which left it with reporting disabled.
+//            v1.07 Oct 2026 - Bluetooth disabled and enabled in place for a switch to WiFi mode without a restart.
+//            v1.08 Oct 2026 - In place Bluetooth disable and enable withdrawn.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -68,12 +75,18 @@ class HID  {
     #define NUMELEM(a)                     (sizeof(a)/sizeof(a[0]))
 
     // Constants.
-    #define HID_VERSION                    1.02
+    #define HID_VERSION                    1.08
     #define HID_MOUSE_DATA_POLL_DELAY      10
     #define MAX_MOUSE_INACTIVITY_TIME      500 * HID_MOUSE_DATA_POLL_DELAY
+    #define HID_MOUSE_ACCEL_TABLE_SIZE     64                            // Number of speed steps in the precomputed acceleration curve.
+    #define HID_TYPEMATIC_HOST_RATE        31                            // PS/2 typematic when the host repeats keys, slowest rate (2cps) and
+    #define HID_TYPEMATIC_HOST_DELAY       3                             // longest delay (1s), repeated makes are discarded by the interface.
+    #define HID_TYPEMATIC_DEFAULT_RATE     0x0B                          // PS/2 keyboard power on typematic, 10.9cps after 0.5s.
+    #define HID_TYPEMATIC_DEFAULT_DELAY    1
     
     // Categories of configuration possible with the mouse. These are used primarily with the web based UI for rendering selection choices.
     #define HID_MOUSE_HOST_SCALING_TYPE    "host_scaling"
+    #define HID_MOUSE_HOST_ACCEL_TYPE      "host_accel"
     #define HID_MOUSE_SCALING_TYPE         "mouse_scaling"
     #define HID_MOUSE_RESOLUTION_TYPE      "mouse_resolution"
     #define HID_MOUSE_SAMPLING_TYPE        "mouse_sampling"
@@ -83,6 +96,10 @@ class HID  {
     #define HID_MOUSE_HOST_SCALING_1_3_NAME "1:3"
     #define HID_MOUSE_HOST_SCALING_1_4_NAME "1:4"
     #define HID_MOUSE_HOST_SCALING_1_5_NAME "1:5"    
+    #define HID_MOUSE_HOST_ACCEL_OFF_NAME  "Off"
+    #define HID_MOUSE_HOST_ACCEL_LOW_NAME  "Low"
+    #define HID_MOUSE_HOST_ACCEL_MED_NAME  "Medium"
+    #define HID_MOUSE_HOST_ACCEL_HIGH_NAME "High"
 
     // Names for the configuration value settings.
     #define HID_MOUSE_RESOLUTION_1_1_NAME  "1 c/mm"
@@ -105,6 +122,7 @@ class HID  {
             HID_DEVICE_TYPE_KEYBOARD     = 0x00,
             HID_DEVICE_TYPE_MOUSE        = 0x01,
             HID_DEVICE_TYPE_BLUETOOTH    = 0x02,
+            HID_DEVICE_TYPE_PS2_KEYBOARD = 0x03,                          // PS/2 keyboard only, used in WiFi mode where Bluetooth cannot run.
         };
 
         // HID class can encapsulate many input device objects, only one at a time though. On startup the device is enumerated and then all
@@ -114,7 +132,8 @@ class HID  {
             HID_DEVICE_PS2_MOUSE         = 0x01,
             HID_DEVICE_BLUETOOTH         = 0x02,
             HID_DEVICE_BT_KEYBOARD       = 0x03,
-            HID_DEVICE_BT_MOUSE          = 0x04
+            HID_DEVICE_BT_MOUSE          = 0x04,
+            HID_DEVICE_NONE              = 0x05
         };
 
         // Scaling - The host receiving mouse data may have a different resolution to that of the mouse, so we use configurable host side scaling to compensate. The mouse data received
@@ -127,6 +146,15 @@ class HID  {
             HID_MOUSE_HOST_SCALING_1_5   = 0x04,
         };
 
+        // Acceleration - an optional curve applied after scaling, slow movements pass through at 1:1 for precision and faster movements are amplified
+        // so the pointer can cross the host screen without excessive hand travel.
+        enum HID_MOUSE_HOST_ACCEL {
+            HID_MOUSE_HOST_ACCEL_OFF     = 0x00,
+            HID_MOUSE_HOST_ACCEL_LOW     = 0x01,
+            HID_MOUSE_HOST_ACCEL_MEDIUM  = 0x02,
+            HID_MOUSE_HOST_ACCEL_HIGH    = 0x03,
+        };
+
         // Resolution - the mouse can digitize movement from 1mm to 1/8mm, the default being 1/4 (ie. 1mm = 4 counts). This allows configuration for a finer or rougher
         // tracking digitisation.
         enum HID_MOUSE_RESOLUTION {
@@ -159,11 +187,13 @@ class HID  {
         bool                               suspended = true;
        
         // Element to store mouse data in a queue. The data is actual mouse movements, any control data and private data for the actual mouse is stripped.
+        // Movement is signed and unclipped, it may represent several coalesced device reports so the consumer is responsible for splitting it into host
+        // sized packets.
         typedef struct {
-            int16_t                        xPos;
-            int16_t                        yPos;
+            int32_t                        xPos;
+            int32_t                        yPos;
             uint8_t                        status;
-            uint8_t                        wheel;
+            int16_t                        wheel;
         } t_mouseMessageElement;
 
         // Prototypes.
@@ -178,12 +208,16 @@ class HID  {
         void                               suspendInterface(bool suspendIf);
         bool                               persistConfig(void);
         uint16_t                           read(void);
+        uint32_t                           readTime(void);
         void                               setMouseResolution(enum HID_MOUSE_RESOLUTION resolution);
         void                               setMouseHostScaling(enum HID_MOUSE_HOST_SCALING scaling);
+        void                               setMouseHostAcceleration(enum HID_MOUSE_HOST_ACCEL acceleration);
         void                               setMouseScaling(enum HID_MOUSE_SCALING scaling);
         void                               setMouseSampleRate(enum HID_MOUSE_SAMPLING sampleRate);
         void                               btStartPairing(void);
         void                               btCancelPairing(void);    
+        void                               setKeyboardLEDs(uint8_t locks, uint8_t mask);
+        void                               setHostRepeat(bool hostRepeat);
 
 
         // Method to register an object method for callback with context.
@@ -274,11 +308,14 @@ class HID  {
                   bool                     nvsCommitData(void);
                   void                     checkKeyboard( void );
                   bool                     checkPS2Keyboard( void );
+                  void                     applyKeyboardState( void );
                   bool                     checkPS2Mouse( void );
                   void                     checkMouse( void );
                   void                     processPS2Mouse( void );
                   void                     checkBTMouse( void );
                   void                     mouseReceiveData(uint8_t src, PS2Mouse::MouseData mouseData);
+                  void                     updateMouseScaling(void);
+                  void                     scaleMouseData(uint8_t src, int32_t xIn, int32_t yIn, int32_t *xOut, int32_t *yOut);
         IRAM_ATTR static void              hidControl( void * pvParameters );
                   static void              btPairingHandler(uint32_t pid, uint8_t trigger);
         inline uint32_t milliSeconds(void)
@@ -308,6 +345,7 @@ class HID  {
             struct {
                 // Host data for adjustment and configuration.
                 enum HID_MOUSE_HOST_SCALING scaling;
+                enum HID_MOUSE_HOST_ACCEL  acceleration;
             } host;
 
             struct {
@@ -318,6 +356,21 @@ class HID  {
 
         } t_hidConfig;
 
+        // Layout of the configuration persisted before host mouse acceleration was added, recognised by its size and migrated.
+        typedef struct {
+            struct {
+                enum HID_MOUSE_RESOLUTION  resolution;
+                enum HID_MOUSE_SCALING     scaling;
+                enum HID_MOUSE_SAMPLING    sampleRate;
+            } mouse;
+            struct {
+                enum HID_MOUSE_HOST_SCALING scaling;
+            } host;
+            struct {
+                uint16_t                   optionAdvanceDelay;
+            } params;
+        } t_hidConfigV1;
+
         // Structure to maintain an active settings for HID devices.
         typedef struct {
             enum HID_INPUT_DEVICE          hidDevice;          // Active HID device, only one can be active.
@@ -325,6 +378,12 @@ class HID  {
             bool                           ps2Active;          // Flag to indicate PS/2 device is online and active.
             uint32_t                       noEchoCount   = 0L; // Echo back counter, used for testing if a keyboard is online.
             TickType_t                     ps2CheckTimer = 0;  // Check timer, used for timing periodic keyboard checks.
+            uint32_t                       keyTime       = 0;  // Time the key last read was received by the device, Metrics::now().
+
+            // Keyboard state set by the host, reapplied when a PS/2 keyboard is reconnected.
+            uint8_t                        kbdLocks;           // Lock LEDs, PS2_LOCK_* bits.
+            uint8_t                        kbdLockMask;        // Lock LEDs owned by the host.
+            bool                           hostRepeat;         // Host repeats keys, device typematic is suppressed.
 
             // Mouse control variables.
             uint32_t                       noValidMouseMessage = 0;
@@ -333,6 +392,20 @@ class HID  {
             bool                           middleKeyPressed    = false;
             PS2Mouse::MouseData            mouseData;
 
+            // Fixed point scaling stage. The combined source, resolution and host divisors are held as a Q16.16 gain per source (0 = PS/2, 1 = Bluetooth)
+            // and the fraction discarded when converting a movement to host counts is carried into the next report, so slow movements accumulate rather
+            // than truncate to zero. The acceleration curve is precomputed as Q8.8 multipliers indexed by speed, both are rebuilt only when the settings change.
+            struct {
+                int32_t                    gain[2];
+                int32_t                    remX[2];
+                int32_t                    remY[2];
+                uint16_t                   accelTable[HID_MOUSE_ACCEL_TABLE_SIZE];
+                enum HID_MOUSE_RESOLUTION  resolution;
+                enum HID_MOUSE_HOST_SCALING scaling;
+                enum HID_MOUSE_HOST_ACCEL  acceleration;
+                bool                       valid;
+            } scale;
+
             // Flag to indicate the mouse is active and online.
             bool                           active;
 
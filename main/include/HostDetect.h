@@ -0,0 +1,90 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            HostDetect.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for the host classification logic. The host signals are measured by the
+//                  pulse counter peripheral over a fixed time window, the resulting edge counts and line
+//                  levels are classified into a host type. Classification has no hardware dependencies so
+//                  it can be built and exercised away from the target.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Permission check of a cached host type against the feature security.
+//            v1.02 Oct 2026 - KDB0 activity judged on its edge rate over the control window rather than a raw count.
+//            v1.03 Oct 2026 - KDB0 window ends early once decided, a cached X68000 is confirmed by a short quiet probe.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOSTDETECT_H
+#define HOSTDETECT_H
+
+#include <stdint.h>
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to encapsulate classification of the connected host from its measured signals.
+class HostDetect  {
+
+    // Constants.
+    #define HOSTDETECT_VERSION          1.03
+    #define HOSTDETECT_WINDOW_US        5000                            // Window over which MPX, RTSN and KDB0 edges are counted in parallel.
+    #define HOSTDETECT_CTRL_WINDOW_US   50000                           // Extended KDB0 window, needed to separate the X68000 and Mouse ports.
+    #define HOSTDETECT_PROBE_WINDOW_US  25000                           // KDB0 window confirming a cached X68000, longer than an MSCTRL period of 40Hz or more.
+    #define HOSTDETECT_MPX_ACTIVE_RATE  1                               // MPX rising edges per mS at or above which the host scans a key matrix.
+    #define HOSTDETECT_MZ2500_RATIO     4                               // MZ-2500 strobes RTSN with every MPX, the MZ-2800 once per ~14 or more.
+    #define HOSTDETECT_CTRL_ACTIVE_RATE 20                              // KDB0 rising edges per second above which the Mouse control line is deemed active.
+
+    // Host types permitted, normally derived from the eFuse feature bits.
+    #define HOSTDETECT_ALLOW_MZ2500     (1 << 0)
+    #define HOSTDETECT_ALLOW_MZ2800     (1 << 1)
+    #define HOSTDETECT_ALLOW_X1         (1 << 2)
+    #define HOSTDETECT_ALLOW_X68000     (1 << 3)
+    #define HOSTDETECT_ALLOW_MOUSE      (1 << 4)
+    #define HOSTDETECT_ALLOW_ALL        0xFF
+
+    public:
+        // Measured host signals.
+        typedef struct {
+            uint32_t                    windowUs;           // Duration over which mpxEdges and rtsnEdges were counted.
+            uint32_t                    mpxEdges;           // Rising edges on MPX.
+            uint32_t                    rtsnEdges;          // Rising edges on RTSN.
+            uint32_t                    ctrlWindowUs;       // Duration over which ctrlEdges were counted.
+            uint32_t                    ctrlEdges;          // Rising edges on KDB0, the X68000 TxD or Mouse MSCTRL line.
+            bool                        x1Loopback;         // Test pattern written to KDO[3:0] was read back on KDB[3:0].
+            bool                        mpxLevel;           // Static line levels sampled after the window.
+            bool                        rtsnLevel;
+            bool                        kdi4Level;
+        } t_hostSignals;
+
+        // Prototypes.
+        static bool                     isMatrixHost(const t_hostSignals &signals);
+        static bool                     isCtrlActive(const t_hostSignals &signals);
+        static bool                     isCtrlDecided(const t_hostSignals &signals, uint32_t cachedIfMode);
+        static uint32_t                 classify(const t_hostSignals &signals, uint32_t allowed);
+        static bool                     isAllowed(uint32_t ifMode, uint32_t allowed);
+
+        // Method to return the class version number.
+        static float version(void)
+        {
+            return(HOSTDETECT_VERSION);
+        }
+};
+#endif // HOSTDETECT_H
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            HostUART.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for the shared UART host transport. Hosts using an asynchronous serial keyboard
+//                  link (X68000, PC-9801) block on a queue set combining the UART driver event queue and
+//                  the interface key transmit queue, so mapped keys are sent and host commands received
+//                  as soon as they are available rather than on a polling period.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Line break reported, used as a host reset where reset shares the receive line.
+//            v1.02 Oct 2026 - Transmit idle test, paces keystroke macros.
+//            v1.03 Oct 2026 - Runtime metrics.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOSTUART_H
+#define HOSTUART_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "driver/uart.h"
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to encapsulate a host UART and the key transmit queue feeding it.
+class HostUART  {
+
+    // Constants.
+    #define HOSTUART_VERSION            1.03
+    #define HOSTUART_RX_TIMEOUT         1                               // Receive idle timeout, in symbols, before buffered host data is signalled.
+    #define HOSTUART_RX_THRESHOLD       1                               // Receive FIFO level at which host data is signalled.
+    #define HOSTUART_WAIT_MS            100                             // Longest wait of the interface thread, bounds the response to a suspend request.
+
+    public:
+        // Events returned by a wait, the caller services the source.
+        enum HOSTUART_EVENT {
+            HOSTUART_EVENT_NONE         = 0,                            // Timeout or internally handled UART event.
+            HOSTUART_EVENT_XMIT         = 1,                            // A key is waiting, exactly one message must be read from the transmit queue.
+            HOSTUART_EVENT_RCV          = 2,                            // Host data is buffered, read with readData.
+            HOSTUART_EVENT_BREAK        = 3,                            // Receive line held low beyond a character, buffered data is discarded.
+        };
+
+        // Prototypes.
+                                        HostUART(void);
+        virtual                        ~HostUART(void) {};
+        bool                            init(uart_port_t uartNum, const uart_config_t *uartConfig, int txPin, int rxPin, int bufferSize, int eventQueueSize, QueueHandle_t xmitQueue, int xmitQueueSize);
+        enum HOSTUART_EVENT             wait(TickType_t timeout);
+        int                             readData(uint8_t *buf, int size);
+        void                            writeKey(uint32_t keyCode);
+        bool                            xmitIdle(void);
+
+        // Method to return the class version number.
+        virtual float version(void)
+        {
+            return(HOSTUART_VERSION);
+        }
+
+    protected:
+
+    private:
+        static constexpr char const    *TAG = "HostUART";
+
+        // Structure to maintain the transport.
+        typedef struct {
+            uart_port_t                 uartNum;
+            QueueHandle_t               eventQueue;         // UART driver event queue.
+            QueueHandle_t               xmitQueue;          // Interface key transmit queue.
+            QueueSetHandle_t            queueSet;           // Set combining the two, the thread blocks on this.
+            uint32_t                    rxOverflows;        // Host data lost to a FIFO or buffer overflow.
+        } t_hostUARTControl;
+
+        // Variables to control the transport.
+        t_hostUARTControl               uartCtrl;
+};
+#endif // HOSTUART_H
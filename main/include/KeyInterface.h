@@ -11,6 +11,14 @@
 //
 // History:         Mar 2022 - Initial write.
 //            v1.01 May 2022 - Initial release version.
+//            v1.02 Oct 2026 - Thread readiness events, init waits on these rather than fixed delays.
+//            v1.03 Oct 2026 - Keymaps published as a whole, a reload no longer frees a table in use by mapKey.
+//            v1.04 Oct 2026 - Keymaps are an overlay of user edits on the inbuilt keymap held in flash.
+//            v1.05 Oct 2026 - Keystroke macro playback, keys are fed to mapKey at the rate the host accepts them.
+//            v1.06 Oct 2026 - Keymap row edits applied to the active keymap without a full table upload.
+//            v1.07 Oct 2026 - Key read to key mapped latency recorded in the runtime metrics.
+//            v1.08 Oct 2026 - Device event time carried with each key so the host threads can record per stage and end to end latency.
+//            v1.09 Oct 2026 - Macro pacing only adapts on hosts which report rejects.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -38,10 +46,13 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <atomic>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "soc/timer_group_struct.h"
 #include "soc/timer_group_reg.h"
 #include "driver/timer.h"
@@ -50,6 +61,9 @@
 #include "NVS.h"
 #include "LED.h"
 #include "HID.h"
+#include "KeyMapOverlay.h"
+#include "KeyMacro.h"
+#include "Metrics.h"
 
 
 // NB: Macros definitions put inside class for clarity, they are still global scope.
@@ -63,7 +77,11 @@ class KeyInterface  {
     #define NUMELEM(a)                  (sizeof(a)/sizeof(a[0]))
 
     // Constants.
-    #define KEYIF_VERSION               1.01
+    #define KEYIF_VERSION               1.09
+    #define KEYIF_READY_HOSTIF          (1 << 0)                        // Host interface thread initialised and running.
+    #define KEYIF_READY_HIDIF           (1 << 1)                        // HID interface thread initialised and running.
+    #define KEYIF_READY_TIMEOUT_MS      2000                            // Longest wait for a thread to signal, guards against a thread which fails to start.
+    #define KEYIF_KEYMAP_SYNC_MS        1000                            // Longest wait for the HID thread to finish mapping a key before a replaced keymap is freed.
     
     public:
         // Suspend flag. When active, the interface components enter an idle state after completing there latest cycle.
@@ -79,6 +97,30 @@ class KeyInterface  {
         // HID object, used for keyboard input.
         HID                             *hid;
 
+        // A keymap as seen by mapKey. A new table is built aside and published as a whole, the HID thread never sees a partial update.
+        // The inbuilt keymap stays in flash, only rows the user has added or changed are held in memory.
+        // An edit of one keymap row, made by the web editor. Rows are numbered in the merged keymap after the preceding edits have been applied.
+        typedef struct {
+            uint8_t                     op;                     // KeyMapOverlay::OVERLAY_OP.
+            uint16_t                    row;
+            std::vector<uint8_t>        entry;                  // Row bytes in column order, empty for a delete.
+        } t_keyMapEdit;
+
+        template <typename T> struct t_keyMapTable {
+            const T                    *base;                   // Inbuilt keymap.
+            int                         baseRows;               // Number of rows in the inbuilt keymap.
+            uint16_t                   *index;                  // Merged row order, below baseRows an inbuilt row else an overlay row. NULL without an overlay.
+            uint8_t                    *overlay;                // Rows added or changed by the user.
+            int                         overlayRows;            // Number of rows in the overlay.
+            int                         rows;                   // Number of rows in the merged keymap.
+
+            // Method to return a row of the merged keymap.
+            inline const T &row(int idx) const
+            {
+                return(index == NULL ? base[idx] : (index[idx] < baseRows ? base[index[idx]] : ((const T *)overlay)[index[idx] - baseRows]));
+            }
+        };
+
         // Prototypes.
                                         KeyInterface(void) {};
         virtual                        ~KeyInterface(void) {};
@@ -91,6 +133,9 @@ class KeyInterface  {
         virtual void                    identify(void) { };
         virtual void                    init(const char * subClassName, NVS *hdlNVS, LED *hdlLED, HID *hdlHID, uint32_t ifMode);
         virtual void                    init(const char * subClassName, NVS *hdlNVS, HID *hdlHID);
+        void                            signalReady(EventBits_t readyBits);
+        bool                            waitReady(EventBits_t readyBits);
+        bool                            keyMapSynchronise(void);
         // Persistence.
         virtual bool                    persistConfig(void) { return(true); }
 
@@ -105,6 +150,16 @@ class KeyInterface  {
         virtual void                    getKeyMapTypes(std::vector<std::string>& typeList) { };
         virtual bool                    getKeyMapSelectList(std::vector<std::pair<std::string, int>>& selectList, std::string option) { return(true); }
         virtual bool                    getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start) { return(true); };
+        virtual int                     editKeyMap(const std::vector<t_keyMapEdit> &edits) { return(-1); };
+        virtual int                     lookupKey(uint16_t scanCode) { return(-1); }
+        // Keystroke macros.
+        bool                            macroPlay(const std::string &fileName);
+        void                            macroCancel(void);
+        uint16_t                        readKey(void);
+        virtual bool                    macroKey(char chr, uint16_t &keyCode) { return(KeyMacro::charToKey(chr, keyCode)); }
+        virtual bool                    macroHostIdle(void) { return(macroFrames.queued == macroFrames.sent); }
+        virtual void                    macroHostMark(void) { };
+        virtual bool                    macroHostRejects(void) { return(false); }
         // Mouse config.
         virtual void                    getMouseConfigTypes(std::vector<std::string>& typeList) { };
         virtual bool                    getMouseSelectList(std::vector<std::pair<std::string, int>>& selectList, std::string option) { return(true); }
@@ -131,6 +186,173 @@ class KeyInterface  {
             }
         }
 
+        // Methods to bracket the use of a keymap, the epoch is odd whilst a key is being mapped or looked up. Only one thread reads the keymap,
+        // the HID thread in interface mode or the live key monitor in WiFi mode where the interface threads do not run. The monitor only
+        // looks keys up with lookupKey, which changes no interface state.
+        inline void keyMapReadBegin(void)
+        {
+            keyMapEpoch++;
+        }
+        inline void keyMapReadEnd(void)
+        {
+            keyMapEpoch++;
+
+            // Time from the key being read to it being mapped for the host, macro reverse lookups are not keys read so are not recorded.
+            if(keyReadTime != 0)
+            {
+                Metrics::stage(Metrics::HIST_KEYMAP, keyReadTime);
+                keyReadTime = 0;
+            }
+        }
+
+        // Method for the host side of an interface to take the device event time of the key just mapped, 0 if none, ie. a macro key. The time
+        // is handed over once so a key mapped into several host codes is only timed end to end once.
+        inline uint32_t takeKeyEventTime(void)
+        {
+            return(keyEventTime.exchange(0));
+        }
+
+        // Method to record the time taken to deliver a key to the host, called by the host thread once the frame is sent or the key is visible to
+        // the host. Output is timed from the start given, total from the device event.
+        inline void keyOutput(uint32_t eventTime, uint32_t startTime)
+        {
+            // Locals.
+            uint32_t        time = Metrics::stage(Metrics::HIST_OUTPUT, startTime);
+
+            if(eventTime != 0) Metrics::record(Metrics::HIST_TOTAL, time - eventTime);
+        }
+
+        // Method to publish a new keymap in place of the current one. The replaced table is freed once the keymap reader, the HID thread or the
+        // live key monitor, is no longer using it, if it does not finish in time the table is left allocated rather than risk freeing it under
+        // the reader. Keymaps are uploaded or edited through the web server in WiFi mode, where the interface is built without its host threads.
+        // An upload or row edit is published to that interface at once, so the next key the live monitor looks up uses it. The host interface
+        // loads the saved keymap when the switch back out of WiFi mode restarts into it.
+        template <typename T> void publishKeyMap(std::atomic<t_keyMapTable<T> *> &keyMap, t_keyMapTable<T> *newMap)
+        {
+            // Locals.
+            t_keyMapTable<T>           *oldMap = keyMap.exchange(newMap);
+
+            if(oldMap != NULL && keyMapSynchronise() == true)
+            {
+                delete [] oldMap->index;
+                delete [] oldMap->overlay;
+                delete oldMap;
+            }
+        }
+
+        // Method to build a keymap from the inbuilt keymap and the user keymap file, then publish it. Returns the form of the file, a complete
+        // keymap should be saved back as an overlay.
+        template <typename T> enum KeyMapOverlay::OVERLAY_LOAD buildKeyMap(std::atomic<t_keyMapTable<T> *> &keyMap, const std::string &fileName, const T *base, int baseRows)
+        {
+            // Locals.
+            enum KeyMapOverlay::OVERLAY_LOAD  result;
+            KeyMapOverlay::t_overlayMap       overlayMap;
+            t_keyMapTable<T>                 *newMap = new t_keyMapTable<T>;
+
+            if(newMap == NULL)
+            {
+                ESP_LOGW(subClassName.c_str(), "Failed to allocate memory for keyboard map, keeping current map!");
+                return(KeyMapOverlay::OVERLAY_LOAD_INBUILT);
+            }
+            result = KeyMapOverlay::load(fileName, (const uint8_t *)base, baseRows, sizeof(T), overlayMap);
+            newMap->base        = base;
+            newMap->baseRows    = baseRows;
+            newMap->index       = overlayMap.index;
+            newMap->overlay     = overlayMap.overlay;
+            newMap->overlayRows = overlayMap.overlayRows;
+            newMap->rows        = overlayMap.rows;
+            ESP_LOGW(subClassName.c_str(), "Keymap %d rows, %d user rows, %d bytes heap, a full copy would use %d bytes.", newMap->rows, newMap->overlayRows,
+                     (newMap->index == NULL ? 0 : newMap->rows * sizeof(uint16_t)) + newMap->overlayRows * sizeof(T), newMap->rows * sizeof(T));
+
+            // Replace the active map, the previous map is released once the HID thread has finished with it.
+            publishKeyMap(keyMap, newMap);
+            return(result);
+        }
+
+        // Method to write a keymap to the user keymap file as an overlay of the inbuilt keymap.
+        template <typename T> bool saveKeyMapOverlay(const t_keyMapTable<T> *keyMap, const std::string &fileName)
+        {
+            // Locals.
+            std::vector<const uint8_t *>      rows;
+
+            for(int idx=0; idx < keyMap->rows; idx++)
+            {
+                rows.push_back((const uint8_t *)&keyMap->row(idx));
+            }
+            return(KeyMapOverlay::save(fileName, rows, (const uint8_t *)keyMap->base, keyMap->baseRows, sizeof(T)));
+        }
+
+        // Method to apply row edits to a keymap and write the result to the user keymap file as an overlay. The caller reloads the keymap
+        // to publish it. All edits are validated before the file is written, a bad edit leaves the file unchanged.
+        template <typename T> bool editKeyMapRows(const t_keyMapTable<T> *keyMap, const std::string &fileName, const std::vector<t_keyMapEdit> &edits)
+        {
+            // Locals.
+            std::vector<const uint8_t *>      rows;
+            bool                              result = (keyMap != NULL);
+
+            for(int idx=0; result && idx < keyMap->rows; idx++)
+            {
+                rows.push_back((const uint8_t *)&keyMap->row(idx));
+            }
+            for(std::size_t idx=0; result && idx < edits.size(); idx++)
+            {
+                const t_keyMapEdit &edit = edits[idx];
+
+                if(edit.op != KeyMapOverlay::OVERLAY_DELETE && edit.entry.size() != sizeof(T))
+                {
+                    result = false;
+                }
+                else if(edit.op == KeyMapOverlay::OVERLAY_INSERT && edit.row <= rows.size())
+                {
+                    rows.insert(rows.begin() + edit.row, edit.entry.data());
+                }
+                else if(edit.op == KeyMapOverlay::OVERLAY_REPLACE && edit.row < rows.size())
+                {
+                    rows[edit.row] = edit.entry.data();
+                }
+                else if(edit.op == KeyMapOverlay::OVERLAY_DELETE && edit.row < rows.size())
+                {
+                    rows.erase(rows.begin() + edit.row);
+                } else
+                {
+                    result = false;
+                }
+            }
+            if(result)
+            {
+                result = KeyMapOverlay::save(fileName, rows, (const uint8_t *)keyMap->base, keyMap->baseRows, sizeof(T));
+            }
+            return(result);
+        }
+
+        // Methods for the host thread to report key frames, queued when handed to the host thread, sent once on the wire or discarded. The host has
+        // taken all keys when the two counts match. A reject is a key the host could not accept, it slows macro playback on an interface whose
+        // macroHostRejects is set.
+        inline void macroFrameQueued(void)
+        {
+            macroFrames.queued++;
+        }
+        inline void macroFrameSent(void)
+        {
+            macroFrames.sent++;
+        }
+        inline void macroHostReject(void)
+        {
+            macroFrames.rejects++;
+        }
+
+        // Method to test for macro playback in progress.
+        inline bool macroActive(void)
+        {
+            return(macroCtrl.active);
+        }
+
+        // Method to shorten the HID thread poll whilst a macro plays, the next key is sent as soon as the host has taken the last.
+        inline uint32_t macroPollDelay(uint32_t delay)
+        {
+            return(macroCtrl.active && delay > 1 ? 1 : delay);
+        }
+
         // Method to see if the interface must enter suspend mode.
         //
         inline virtual bool suspendRequested(void)
@@ -193,10 +415,47 @@ class KeyInterface  {
     private:
         // Prototypes.
         virtual IRAM_ATTR void          selectOption(uint8_t optionCode) {};
+        uint16_t                        macroRead(void);
+        void                            macroEnd(void);
+
+        // Structure to maintain macro playback, used only by the HID thread.
+        typedef struct {
+            std::string                 text;                   // Macro being played.
+            size_t                      pos;                    // Position of the next token in text.
+            uint16_t                    events[KEYMACRO_MAX_EVENTS]; // Events of the key being typed.
+            int                         eventCnt;
+            int                         eventIdx;
+            TickType_t                  readyTick;              // Next key not sent before this tick, the pacing gap or a {WAIT}.
+            TickType_t                  sentTick;               // Tick the last event was sent, bounds the wait for the host to take it.
+            KeyMacro::t_pace            pace;
+            uint32_t                    rejects;                // Host rejects already acted on.
+            int                         skipped;                // Characters or names which could not be typed.
+            bool                        active;
+        } t_macroControl;
+        t_macroControl                  macroCtrl = {};
+
+        // Key frame counts maintained by the host thread.
+        struct {
+            std::atomic<uint32_t>       queued{0};
+            std::atomic<uint32_t>       sent{0};
+            std::atomic<uint32_t>       rejects{0};
+        } macroFrames;
 
         // Name of the sub-class for this instantiation.
         std::string                     subClassName;
 
+        // Events set by each interface thread once running, replaces fixed start up delays.
+        EventGroupHandle_t              readyEvents = NULL;
+
+        // Keymap read epoch, incremented by the HID thread on entry to and exit from mapping a key.
+        std::atomic<uint32_t>           keyMapEpoch{0};
+
+        // Time the last key was read, Metrics::now(), cleared once it has been mapped. Only used by the HID thread.
+        uint32_t                        keyReadTime = 0;
+
+        // Time the last key read was received by the keyboard device, taken by the host side of the interface when the mapped key is queued.
+        std::atomic<uint32_t>           keyEventTime{0};
+
         // Thread handle for the LED control thread.
         TaskHandle_t                    TaskLEDIF  = NULL;
 };
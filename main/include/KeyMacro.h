@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMacro.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for the keystroke macro logic. A macro is a text file of characters and
+//                  bracketed key names which is played into the host as though typed on the keyboard.
+//                  This class parses the text, breaks each key into the PS/2 make and break events a
+//                  keyboard would deliver and paces the events to the rate the host accepts. It has no
+//                  hardware dependencies, the interface supplies the host feedback.
+//
+//                  Macro text:
+//                      abc 123         Characters typed as is, a newline is ENTER.
+//                      {ENTER}         Named key, see nameToKey.
+//                      {CTRL+C}        Key with modifiers SHIFT, CTRL, ALT, ALTGR, GUI.
+//                      {WAIT 500}      Pause in milliseconds, ie. whilst the host runs a command.
+//                      {{              A literal {.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Pacing only adapts on hosts which report rejects, others use a fixed gap.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef KEYMACRO_H
+#define KEYMACRO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include "PS2KeyAdvanced.h"
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to encapsulate parsing, key event generation and pacing of keystroke macros.
+class KeyMacro  {
+
+    // Constants.
+    #define KEYMACRO_VERSION            1.01
+    #define KEYMACRO_SLOTS              4                               // Macro files, played with CTRL+SHIFT+ESC then F1..F4.
+    #define KEYMACRO_MAX_SIZE           16384                           // Largest macro file accepted.
+    #define KEYMACRO_FILE_PREFIX        "macro"                         // Macro file is <prefix><slot>.txt alongside the keymap.
+    #define KEYMACRO_FILE_EXT           ".txt"
+    #define KEYMACRO_MAX_NAME           16                              // Longest bracketed token, ie. {CTRL+SHIFT+PGDN}.
+    #define KEYMACRO_MAX_WAIT_MS        60000                           // Longest {WAIT}.
+    #define KEYMACRO_MAX_EVENTS         12                              // Events of one key, 5 modifier makes, key make, key break, 5 modifier breaks.
+    #define KEYMACRO_START_DELAY_MS     500                             // Delay before playback, lets the user release the hotkey.
+    #define KEYMACRO_HOST_TIMEOUT_MS    2000                            // Longest wait for the host to accept an event before playback is abandoned.
+    #define KEYMACRO_GAP_START_MS       20                              // Gap between keys at the start of playback.
+    #define KEYMACRO_GAP_FIXED_MS       20                              // Gap between keys on a host which does not report rejects.
+    #define KEYMACRO_GAP_MIN_MS         0                               // Fastest, keys paced purely by the host.
+    #define KEYMACRO_GAP_MAX_MS         250                             // Slowest gap after repeated rejects.
+    #define KEYMACRO_GAP_STEP_MS        4                               // Added to the doubled gap on a reject so a zero gap recovers.
+    #define KEYMACRO_GAP_DECAY          8                               // Gap reduced by 1/n for each key accepted.
+
+    public:
+        // Type of token parsed from the macro text.
+        enum TOKEN_TYPE {
+            TOKEN_END                   = 0,                            // End of text.
+            TOKEN_CHAR                  = 1,                            // Character to be reverse mapped by the interface.
+            TOKEN_KEY                   = 2,                            // Named key, keyCode holds the PS/2 key and modifier flags.
+            TOKEN_WAIT                  = 3,                            // Pause, waitMs holds the period.
+            TOKEN_INVALID               = 4                             // Unknown name or malformed token, skipped.
+        };
+
+        typedef struct {
+            enum TOKEN_TYPE             type;
+            char                        chr;
+            uint16_t                    keyCode;
+            uint32_t                    waitMs;
+        } t_token;
+
+        // Pacing state. On a host which reports rejects the gap between keys shrinks by a fraction on each accepted key and doubles
+        // on a reject. A host without that feedback gives no sign of keys lost to a short gap so it is held at a fixed gap.
+        typedef struct {
+            uint32_t                    gapMs;
+            uint32_t                    accepted;
+            uint32_t                    rejected;
+            bool                        adaptive;
+        } t_pace;
+
+        // Prototypes.
+        static size_t                   nextToken(const std::string &text, size_t pos, t_token &token);
+        static bool                     charToKey(char chr, uint16_t &keyCode);
+        static bool                     nameToKey(const std::string &name, uint16_t &keyCode);
+        static int                      strokeEvents(uint16_t keyCode, uint16_t *events);
+        static int                      validate(const std::string &text);
+        static std::string              fileName(const std::string &keyMapFileName, int slot);
+        static void                     paceStart(t_pace &pace, bool adaptive);
+        static void                     paceAccepted(t_pace &pace);
+        static void                     paceRejected(t_pace &pace);
+
+        // Method to return the class version number.
+        static float version(void)
+        {
+            return(KEYMACRO_VERSION);
+        }
+};
+#endif // KEYMACRO_H
@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMapOverlay.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for the keymap overlay. The inbuilt keymap of each interface remains in flash,
+//                  the keymap file only holds the rows the user has added, changed or deleted relative
+//                  to it. On load the two are merged into an index of rows which mapKey walks in order.
+//                  The logic is independent of the interface, rows are handled as fixed size records.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Builds outside ESP-IDF so the overlay logic can be run on a host.
+//            v1.02 Oct 2026 - Host builds use the test shim esp_log.h, the local log substitute is removed.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef KEYMAPOVERLAY_H
+#define KEYMAPOVERLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to encapsulate the keymap overlay file format and the merge with an inbuilt keymap.
+class KeyMapOverlay  {
+
+    // Constants.
+    #define KEYMAP_OVERLAY_VERSION      1.02
+    #define KEYMAP_OVERLAY_MAGIC        0x4F4D4B53                      // 'SKMO', identifies an overlay file, a file without it is a complete keymap.
+    #define KEYMAP_OVERLAY_FORMAT       1                               // Revision of the file layout.
+    #define KEYMAP_OVERLAY_LOOKAHEAD    16                              // Rows searched ahead to recognise an insertion or deletion rather than a change.
+
+    public:
+        // Edit applied to the inbuilt keymap at a given row.
+        enum OVERLAY_OP {
+            OVERLAY_INSERT              = 0,                            // Row inserted before the inbuilt row, or appended when the row is the inbuilt row count.
+            OVERLAY_REPLACE             = 1,                            // Inbuilt row replaced.
+            OVERLAY_DELETE              = 2                             // Inbuilt row removed.
+        };
+
+        // Result of loading a keymap file.
+        enum OVERLAY_LOAD {
+            OVERLAY_LOAD_INBUILT        = 0,                            // No usable file, the inbuilt keymap applies unchanged.
+            OVERLAY_LOAD_OVERLAY        = 1,                            // Overlay file merged with the inbuilt keymap.
+            OVERLAY_LOAD_COMPLETE       = 2                             // Complete keymap file, ie. an upload or an earlier firmware, converted to an overlay which should be saved.
+        };
+
+        // File header, followed by records each holding one keymap row, the row is zero for a delete.
+        typedef struct {
+            uint32_t                    magic;
+            uint16_t                    format;
+            uint16_t                    entrySize;                      // Size of a keymap row, must match the interface.
+            uint16_t                    baseRows;                       // Rows in the inbuilt keymap the overlay was made against.
+            uint16_t                    records;
+        } t_overlayHeader;
+
+        typedef struct {
+            uint16_t                    baseRow;
+            uint8_t                     op;
+            uint8_t                     reserved;
+        } t_overlayRecord;
+
+        // Merged keymap. Index entries below baseRows are inbuilt rows, the remainder are overlay rows. No index when there is no overlay.
+        typedef struct {
+            uint16_t                   *index;
+            uint8_t                    *overlay;
+            int                         overlayRows;
+            int                         rows;
+        } t_overlayMap;
+
+        // Prototypes.
+        static enum OVERLAY_LOAD        load(const std::string &fileName, const uint8_t *base, int baseRows, size_t entrySize, t_overlayMap &map);
+        static bool                     save(const std::string &fileName, const std::vector<const uint8_t *> &rows, const uint8_t *base, int baseRows, size_t entrySize);
+        static void                     diff(const std::vector<const uint8_t *> &rows, const uint8_t *base, int baseRows, size_t entrySize, std::vector<t_overlayRecord> &records, std::vector<const uint8_t *> &entries);
+        static bool                     merge(const std::vector<t_overlayRecord> &records, const std::vector<const uint8_t *> &entries, int baseRows, size_t entrySize, t_overlayMap &map);
+
+        // Method to return the class version number.
+        static float version(void)
+        {
+            return(KEYMAP_OVERLAY_VERSION);
+        }
+};
+#endif // KEYMAPOVERLAY_H
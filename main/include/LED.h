@@ -12,6 +12,8 @@
 //
 // History:         Mar 2022 - Initial write.
 //            v1.01 May 2022 - Initial release version.
+//            v1.02 Oct 2026 - LEDC blink waveform, configurations applied by a kick timer.
+//                             LEDC clock chosen per blink period.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -47,6 +49,8 @@
 #include "soc/timer_group_struct.h"
 #include "soc/timer_group_reg.h"
 #include "driver/timer.h"
+#include "driver/ledc.h"
+#include "esp_timer.h"
 #include "PS2KeyAdvanced.h"
 #include "PS2Mouse.h"
 #include "NVS.h"
@@ -61,7 +65,15 @@ class LED  {
     #define NUMELEM(a)                  (sizeof(a)/sizeof(a[0]))
 
     // Constants.
-    #define LED_VERSION                 1.01
+    #define LED_VERSION                 1.02
+    #define LED_LEDC_MODE               LEDC_LOW_SPEED_MODE             // LEDC speed mode used to drive the LED.
+    #define LED_LEDC_TIMER              LEDC_TIMER_0                    // LEDC timer setting the blink period.
+    #define LED_LEDC_CHANNEL            LEDC_CHANNEL_0                  // LEDC channel driving the LED pin.
+    #define LED_LEDC_RESOLUTION         LEDC_TIMER_10_BIT               // Duty resolution, 10 bits allows periods from 13uS to just over 1S.
+    #define LED_LEDC_MAX_DUTY           (1 << 10)                       // Duty value for a permanently lit LED.
+    #define LED_MIN_PERIOD              20                              // Shortest blink period in uS, the 80MHz APB clock over 10 bits is 78KHz.
+    #define LED_APB_MAX_PERIOD          13000                           // Longest blink period in uS on the APB clock, 80MHz over the maximum divider and 10 bits is ~76Hz.
+    #define LED_MAX_PERIOD              1000000                         // Longest blink period in uS, the 1MHz REF_TICK over the maximum divider and 10 bits is ~0.95Hz.
     
     public:
         // Interface LED activity modes.
@@ -94,7 +106,8 @@ class LED  {
 
         // LED Control.
         bool                            setLEDMode(enum LED_MODE mode, enum LED_DUTY_CYCLE dutyCycle, uint32_t maxBlinks, uint64_t usDutyPeriod, uint64_t msInterPeriod);
-        IRAM_ATTR static void           ledInterface(void *pvParameters);
+        static void                     ledTimerCallback(void *pvParameters);
+        static void                     ledKickCallback(void *pvParameters);
         void                            ledInit(uint8_t ledPin);
 
         // Helper method to identify the sub class, this is used in non volatile key management.
@@ -138,6 +151,10 @@ class LED  {
 
     private:
         // Prototypes.
+        bool                            takeConfig(void);
+        void                            applyConfig(void);
+        void                            startBurst(void);
+        esp_err_t                       configTimer(uint32_t period);
 
         // Structure to maintain configuration for the LED.
         // 
@@ -152,21 +169,33 @@ class LED  {
             uint64_t                    interPeriod;        // Period, is milli-seconds between LED activity.
         } t_ledConfig;
 
-        // Structure to maintain an active setting for the LED. The LED control thread uses these values to effect the required lighting of the LED.
+        // Structure to maintain an active setting for the LED. The LEDC peripheral and burst timer use these values to effect the required lighting of the LED.
         typedef struct {
-            // Current, ie. working LED config acted upon by the LED thread.
+            // Current, ie. working LED config acted upon by the burst timer.
             t_ledConfig                 currentConfig;
-            // New config to replace current on next state.
+            // New config to replace current, applied by the burst timer callback.
             t_ledConfig                 newConfig;
 
             // Led GPIO pin.
             uint8_t                     ledPin;
 
-            // Runtime parameters for state machine and control.
-            uint32_t                    blinkCnt;           // count of blink on periods.
+            // Runtime parameters for the burst engine. The LEDC peripheral generates the blinks, the one-shot timer switches between
+            // a burst of blinks and the gap which follows it.
+            uint32_t                    burstBlinks;        // Blinks in a burst, 0 = continuous blinking with no gap.
+            uint32_t                    burstLimit;         // Number of bursts before the LED switches off, 0 = no limit.
+            uint32_t                    burstCnt;           // Count of bursts completed.
+            uint32_t                    ledcDuty;           // LEDC duty value for the configured duty cycle.
+            uint32_t                    blinkPeriod;        // Blink period, in uS, programmed into the LEDC timer, saves reprogramming for an identical period.
+            bool                        inGap;              // Burst engine is in the gap between bursts.
 
-            // Mutex to block access to limit one thread at a time.
-            SemaphoreHandle_t           mutexInternal;
+            // One-shot timer for burst counts and inter-burst gaps, only started from the timer task.
+            esp_timer_handle_t          burstTimer;
+
+            // One-shot timer started by setLEDMode to apply a new configuration in the timer task, at most one start is pending.
+            esp_timer_handle_t          kickTimer;
+
+            // Spinlock guarding the new configuration, held only for a structure copy so callers never block.
+            portMUX_TYPE                cfgMutex;
         } t_ledControl;
 
         // Variables to control the LED.
@@ -174,8 +203,5 @@ class LED  {
 
         // Name of the class for this instantiation.
         std::string                     className;
-
-        // Thread handle for the LED control thread.
-        TaskHandle_t                    TaskLEDIF  = NULL;
 };
 #endif // LED_H
@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            LiveChannel.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for the WebSocket live channel protocol. Messages from the browser are decoded
+//                  and applied to the interface, replies and pushes are encoded, independent of the
+//                  HTTP server which only carries the frames.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Typed keys pushed with their keymap row.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef LIVECHANNEL_H
+#define LIVECHANNEL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "KeyInterface.h"
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to encapsulate the messages exchanged with the browser over the WebSocket live channel.
+class LiveChannel  {
+
+    // Constants.
+    #define LIVECHANNEL_VERSION         1.01
+    #define LIVECHANNEL_MSG_KEYMAP_EDIT 'E'                             // Keymap row edits from the editor.
+    #define LIVECHANNEL_MSG_KEYMAP_ACK  'A'                             // Result of a keymap edit.
+    #define LIVECHANNEL_MAX_FRAME       4096                            // Largest frame accepted from a client.
+    #define LIVECHANNEL_KEY_POLL_MS     10                              // Keyboard poll period of the key monitor when idle.
+
+    public:
+        // A WebSocket frame, text or binary.
+        typedef struct {
+            bool                        binary;
+            std::vector<uint8_t>        payload;
+        } t_frame;
+
+        // Callback to push a text message to every client, called from the key monitor task.
+        typedef void (*t_pushCallback)(void *ctx, const std::string &message);
+
+        // Prototypes.
+                                        LiveChannel(KeyInterface *hdlKeyIf);
+                                        LiveChannel(void);
+                                       ~LiveChannel(void);
+        bool                            receive(const t_frame &frame, t_frame &reply, std::string &broadcast);
+        std::string                     status(void);
+        std::string                     keyEvent(uint16_t scanCode);
+        bool                            startKeyMonitor(t_pushCallback push, void *ctx);
+        void                            stopKeyMonitor(void);
+        static bool                     parseKeyMapEdit(const std::vector<uint8_t> &payload, std::vector<KeyInterface::t_keyMapEdit> &edits);
+
+        // Method to return the class version number.
+        float version(void)
+        {
+            return(LIVECHANNEL_VERSION);
+        }
+
+    private:
+        static void                     keyMonitor(void *pvParameters);
+
+        // Interface the keymap edits are applied to and keys are looked up in.
+        KeyInterface                   *keyIf;
+
+        // Key monitor, reads the keyboard and pushes each key and its keymap row to the clients.
+        struct {
+            t_pushCallback              push;
+            void                       *ctx;
+            std::atomic<bool>           run;
+            std::atomic<bool>           running;
+        } monitor;
+};
+#endif // LIVECHANNEL_H
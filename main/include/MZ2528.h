@@ -11,6 +11,11 @@
 // History:         Mar 2022 - Initial write.
 //            v1.01 May 2022 - Initial release version.
 //            v1.02 Jun 2022 - Updates to reflect bluetooth.
+//            v1.03 Oct 2026 - Keystroke macros, keys paced by the host matrix scans.
+//            v1.04 Oct 2026 - Keymap row edits.
+//            v1.05 Oct 2026 - Per key latency metrics, a key is timed to the host scan which first sees it.
+//            v1.06 Oct 2026 - Macro characters reverse mapped through the active keymap.
+//            v1.07 Oct 2026 - Late host scans of a macro key reported as a reject.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -49,8 +54,11 @@ class MZ2528  : public KeyInterface {
     #define NUMELEM(a)                      (sizeof(a)/sizeof(a[0]))
 
     // Constants.
-    #define MZ2528IF_VERSION                1.02
+    #define MZ2528IF_VERSION                1.07
     #define MZ2528IF_KEYMAP_FILE            "MZ2528_KeyMap.BIN"
+    #define MZ2528IF_MACRO_SCANS            3                       // Host matrix scans a macro key is held for, the first may be partial.
+    #define MZ2528IF_MACRO_HOLD_MS          20                      // Least time a macro key is held, the host software samples the matrix at its own rate.
+    #define MZ2528IF_MACRO_LATE_MS          100                     // A macro key not yet scanned MZ2528IF_MACRO_SCANS times by now finds the host busy.
     #define PS2TBL_MZ_MAXROWS               165
     #define PS2TBL_MZ_MAX_MKROW             3
     #define PS2TBL_MZ_MAX_BRKROW            2
@@ -170,6 +178,7 @@ class MZ2528  : public KeyInterface {
         void                            getKeyMapTypes(std::vector<std::string>& typeList);
         bool                            getKeyMapSelectList(std::vector<std::pair<std::string, int>>& selectList, std::string option);
         bool                            getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start);
+        int                             editKeyMap(const std::vector<t_keyMapEdit> &edits);
 
         // Overloaded method to see if the interface must enter suspend mode, either triggered by an external event or internal.
         //
@@ -205,12 +214,26 @@ class MZ2528  : public KeyInterface {
             return(MZ2528IF_VERSION);
         }
 
+        // Method to read a row of the virtual key matrix, a 0 bit is a pressed key.
+        inline uint8_t matrixRow(uint8_t row)
+        {
+            return(mzControl.keyMatrix[row & 0x0F]);
+        }
+
     protected:
 
     private:
         // Prototypes.
                   void                  updateMirrorMatrix(void);
                   uint32_t              mapKey(uint16_t scanCode);
+        bool                            macroKey(char chr, uint16_t &keyCode);
+        int                             lookupKey(uint16_t scanCode);
+        bool                            macroHostIdle(void);
+        void                            macroHostMark(void);
+
+        // The host scanning a macro key late is taken as a refusal, so macro pacing can adapt to it.
+        bool                            macroHostRejects(void) { return(true); }
+        void                            keyLatency(void);
         IRAM_ATTR static void           mz25Interface(void *pvParameters );
         IRAM_ATTR static void           mz28Interface(void *pvParameters );
         IRAM_ATTR static void           hidInterface(void *pvParameters );
@@ -220,6 +243,18 @@ class MZ2528  : public KeyInterface {
         void                            init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID);
         void                            init(NVS *hdlNVS, HID *hdlHID);
 
+        // Method called by the host interface threads at the start of each host matrix scan. Counts the scan and timestamps the first scan to see
+        // a newly mapped key, the time is only taken when a key is pending so the scan loop is otherwise unchanged.
+        inline __attribute__((always_inline)) void hostScanStart(void)
+        {
+            mzControl.scanCount++;
+            if(mzControl.keyPending)
+            {
+                mzControl.keyVisibleTime = Metrics::now();
+                mzControl.keyPending     = false;
+            }
+        }
+
         // Overload the base yield method to include suspension of the PS/2 Keyboard interface. This interface uses interrupts which are not mutex protected and clash with the
         // WiFi API methods.
 //        inline void yield(uint32_t delay)
@@ -260,6 +295,9 @@ class MZ2528  : public KeyInterface {
             t_keyMapEntry               kme[PS2TBL_MZ_MAXROWS];
         } t_keyMap;
 
+        // Keymap row applied by mapKey for a key, prototype follows the keymap types it uses.
+        int                             macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode);
+
         // Structure to maintain the MZ2528 interface configuration data. This data is persisted through powercycles as needed.
         typedef struct {
             struct {
@@ -280,11 +318,18 @@ class MZ2528  : public KeyInterface {
             bool                        mode2500;
             bool                        optionSelect;           // Flag to indicate a user requested keyboard configuration option is being selected.
             std::string                 fsPath;                 // Path on the underlying filesystem where storage is mounted and accessible.
-            t_keyMapEntry              *kme;                    // Pointer to an array in memory to contain PS2 to MZ-2500/MZ-2800 mapping values.
-            int                         kmeRows;                // Number of rows in the kme table.
+            std::atomic<t_keyMapTable<t_keyMapEntry> *> keyMap;    // Active PS2 to MZ-2500/MZ-2800 mapping table, replaced as a whole on reload.
             std::string                 keyMapFileName;         // Name of file where extension or replacement key map entries are stored.
             bool                        noKeyPressed;           // Flag to indicate no key has been pressed.
             bool                        persistConfig;          // Flag to request saving of the config into NVS storage.
+            volatile uint32_t           scanCount;              // Matrix scans made by the host, counted by the host interface thread.
+            uint32_t                    scanMark;               // Scan count when the last macro key entered the matrix.
+            TickType_t                  scanMarkTick;           // Time the last macro key entered the matrix.
+            bool                        scanLate;               // The last macro key was not scanned in time, reported as a reject.
+            volatile bool               keyPending;             // Key mapped into the matrix awaiting a host scan, cleared by the host interface thread.
+            volatile uint32_t           keyVisibleTime;         // Time of the host scan which first saw the key, Metrics::now().
+            uint32_t                    keyEventTime;           // Device event time of the key, 0 if none.
+            uint32_t                    keyMappedTime;          // Time the key entered the matrix.
         } t_mzControl;
 
         // Thread handles - one per function, ie. HID interface and host target interface.
@@ -350,7 +395,7 @@ class MZ2528  : public KeyInterface {
         //
         // This initial mapping is for the UK Wyse KB-3926 PS/2 keyboard and his equates to KEYMAP_STANDARD.
         //
-        t_keyMap                        PS2toMZ = {
+        static constexpr t_keyMap       PS2toMZ = {
         {
           //                                                                                                                              < Keys to be applied on match                    >       < Keys to be reset on match      >
           //  PS2 Code         PS2 Ctrl (Flags to Match)                       Keyboard Model                    Machine                  MK_ROW1  MK_ROW2  MK_ROW3  MK_KEY1  MK_KEY2  MK_KEY3     BRK_ROW1 BRK_ROW2 BRK_KEY1 BRK_KEY2
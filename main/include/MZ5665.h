@@ -11,6 +11,15 @@
 // History:         Apr 2022 - Initial write.
 //            v1.01 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
+//            v1.02 Oct 2026 - Host interface implemented, frames serialised by the RMT peripheral.
+//            v1.03 Oct 2026 - Keystroke macros, characters reverse mapped through the active keymap.
+//            v1.04 Oct 2026 - Keymap row edits.
+//            v1.05 Oct 2026 - Runtime metrics.
+//            v1.06 Oct 2026 - Per key latency metrics.
+//            v1.07 Oct 2026 - Transmit engine behind CONFIG_MZ5665_HOST_ENGINE, RTSN wait on the edge interrupt.
+//            v1.08 Oct 2026 - Macro pacing adapts to host rejects.
+//            v1.09 Oct 2026 - Transmit engine scoped as experimental, the frame format is a placeholder.
+//            v1.10 Oct 2026 - Placeholder transmit engine removed until the protocol is captured from a real machine.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -49,9 +58,10 @@ class MZ5665 : public KeyInterface  {
     #define NUMELEM(a)                      (sizeof(a)/sizeof(a[0]))
     
     // Constants.
-    #define MZ5665IF_VERSION                1.01
+    #define MZ5665IF_VERSION                1.10
     #define MZ5665IF_KEYMAP_FILE            "MZ5665_KeyMap.BIN"
     #define MAX_MZ5665_XMIT_KEY_BUF         16
+
     #define PS2TBL_MZ5665_MAXROWS           349
     
     // MZ-6500 Key control bit mask.
@@ -167,6 +177,7 @@ class MZ5665 : public KeyInterface  {
         void                            getKeyMapTypes(std::vector<std::string>& typeList);
         bool                            getKeyMapSelectList(std::vector<std::pair<std::string, int>>& selectList, std::string option);        
         bool                            getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start);
+        int                             editKeyMap(const std::vector<t_keyMapEdit> &edits);
 
         // Method to return the class version number.
         float version(void)
@@ -183,6 +194,8 @@ class MZ5665 : public KeyInterface  {
         IRAM_ATTR static void           hidInterface( void * pvParameters );
                   void                  selectOption(uint8_t optionCode);
                   uint32_t              mapKey(uint16_t scanCode);
+        bool                            macroKey(char chr, uint16_t &keyCode);
+        int                             lookupKey(uint16_t scanCode);
         bool                            loadKeyMap();
         bool                            saveKeyMap(void);
         void                            init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID);
@@ -226,6 +239,9 @@ class MZ5665 : public KeyInterface  {
             t_keyMapEntry               kme[PS2TBL_MZ5665_MAXROWS];
         } t_keyMap;
 
+        // Keymap row selected by mapKey for a key, prototype follows the keymap types it uses.
+        int                             macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode);
+
         // Structure to maintain the MZ-5600/MZ-6500 interface configuration data. This data is persisted through powercycles as needed.
         typedef struct {
             struct {
@@ -243,14 +259,15 @@ class MZ5665 : public KeyInterface  {
             uint8_t                     keyCtrl;                // Keyboard state flag control.
 
             std::string                 fsPath;                 // Path on the underlying filesystem where storage is mounted and accessible.
-            t_keyMapEntry              *kme;                    // Pointer to an array in memory to contain PS2 to MZ-6500 mapping values.
-            int                         kmeRows;                // Number of rows in the kme table.
+            std::atomic<t_keyMapTable<t_keyMapEntry> *> keyMap;    // Active PS2 to MZ-6500 mapping table, replaced as a whole on reload.
             std::string                 keyMapFileName;         // Name of file where extension or replacement key map entries are stored.
         } t_mzControl;
 
         // Transmit buffer queue item.
         typedef struct {
-            uint32_t                    keyCode;                // 16bit, bits 8:0 represent the key, 9 if CTRL to be sent, 10 if ALT to be sent.
+            uint32_t                    keyCode;                // 16bit, bits 7:0 represent the key, 15:8 the control key state.
+            uint32_t                    eventTime;              // Device event time of the key, Metrics::now(), 0 if none.
+            uint32_t                    queueTime;              // Time the key was queued, Metrics::now().
         } t_xmitQueueMessage;
 
         // Thread handles - one per function, ie. HID interface and host target interface.
@@ -266,7 +283,7 @@ class MZ5665 : public KeyInterface  {
         //
         // This mapping is for the UK Wyse KB-3926 PS/2 keyboard
         //
-        t_keyMap                        PS2toMZ5665 = {
+        static constexpr t_keyMap       PS2toMZ5665 = {
         {
             // HELP
             // COPY
@@ -0,0 +1,194 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            Metrics.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for the runtime performance metrics. Error counters and latency histograms are
+//                  updated by the interface threads and ISR's, the main thread periodically samples them
+//                  along with task CPU time, stack space, heap and queue depths into RTC memory. The sample
+//                  survives the restart into WiFi mode and is served, with a sample of the WiFi mode
+//                  system, as JSON by the web interface.
+//
+//                  Histograms are log2, bucket 0 holds zero, bucket n holds values in the range
+//                  2^(n-1) .. 2^n - 1 and the last bucket holds all larger values.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//            v1.01 Oct 2026 - Per stage keystroke latency, input, keymap, queue, output and end to end.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <string>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to collect runtime metrics, all methods are static as there is one set per device.
+class Metrics  {
+
+    // Constants.
+    #define METRICS_VERSION             1.01
+    #define METRICS_MAGIC               0x534D5401                      // Marks a valid sample in RTC memory, which is random after power on. Changed with the sample layout.
+    #define METRICS_HIST_BUCKETS        16                              // Log2 buckets, the last holds 2^14 and above.
+    #define METRICS_MAX_TASKS           24                              // Tasks recorded in a sample, further tasks are ignored.
+    #define METRICS_MAX_QUEUES          4                               // Queues which can be registered for depth sampling.
+    #define METRICS_NAME_LEN            16                              // Task or queue name including terminator, matches CONFIG_FREERTOS_MAX_TASK_NAME_LEN.
+
+    public:
+        // Error and overflow counters.
+        enum COUNTER {
+            COUNTER_XMIT_QUEUE_FULL     = 0,                            // Mapped key lost, host transmit queue full.
+            COUNTER_RAW_KEY_QUEUE_FULL  = 1,                            // Bluetooth report lost, raw key queue full.
+            COUNTER_KEY_QUEUE_FULL      = 2,                            // Bluetooth report processing held off, key queue full.
+            COUNTER_PS2_PARITY          = 3,                            // PS/2 byte received with a parity error, a resend was requested.
+            COUNTER_PS2_RESEND          = 4,                            // PS/2 keyboard requested a resend of a command byte.
+            COUNTER_PS2_OVERRUN         = 5,                            // PS/2 byte lost, keyboard overrun code or receive buffer full.
+            COUNTER_UART_RX_OVERFLOW    = 6,                            // Host UART receive FIFO or buffer overflow.
+            COUNTER_MAX                 = 7
+        };
+
+        // Latency histograms, values in microseconds. A key passes through the stages in order, total is the device event to the host.
+        enum HISTOGRAM {
+            HIST_INPUT                  = 0,                            // PS/2 byte or Bluetooth report received to key read from the HID.
+            HIST_KEYMAP                 = 1,                            // Key read from the HID to key mapped for the host.
+            HIST_QUEUE                  = 2,                            // Mapped key queued to taken by the host thread.
+            HIST_OUTPUT                 = 3,                            // Taken by the host thread to frame sent or matrix visible to the host.
+            HIST_TOTAL                  = 4,                            // Device event to frame sent or matrix visible to the host.
+            HIST_MAX                    = 5
+        };
+
+        // Prototypes.
+        static void                     addQueue(const char *name, QueueHandle_t queue);
+        static void                     commit(void);
+        static std::string              json(void);
+
+        // Method to increment a counter, callable from an ISR, always inlined so an IRAM ISR does not call into flash.
+        static inline __attribute__((always_inline)) void count(enum COUNTER counter)
+        {
+            counters[counter].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Method to return the log2 histogram bucket for a value.
+        static inline __attribute__((always_inline)) uint32_t bucket(uint32_t value)
+        {
+            // Locals.
+            uint32_t        idx = (value == 0 ? 0 : 32 - __builtin_clz(value));
+
+            return(idx < METRICS_HIST_BUCKETS ? idx : METRICS_HIST_BUCKETS - 1);
+        }
+
+        // Method to add a value to a histogram, callable from an ISR.
+        static inline __attribute__((always_inline)) void record(enum HISTOGRAM histogram, uint32_t value)
+        {
+            histograms[histogram][bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Method to return a timestamp for latency measurement, uS. The system timer is used rather than the CPU cycle counter as a key crosses
+        // cores and the cycle counters of the two cores are not aligned. Zero is reserved to mean no timestamp, the difference of two timestamps
+        // is valid across the 32 bit wrap.
+        static inline __attribute__((always_inline)) uint32_t now(void)
+        {
+            // Locals.
+            uint32_t        time = (uint32_t)esp_timer_get_time();
+
+            return(time == 0 ? 1 : time);
+        }
+
+        // Method to record the time since a stage started, ignored when the start has no timestamp. Returns the time, the start of the next stage.
+        static inline __attribute__((always_inline)) uint32_t stage(enum HISTOGRAM histogram, uint32_t start)
+        {
+            // Locals.
+            uint32_t        time = now();
+
+            if(start != 0) record(histogram, time - start);
+            return(time);
+        }
+
+        // Method to return the class version number.
+        static float version(void)
+        {
+            return(METRICS_VERSION);
+        }
+
+    protected:
+
+    private:
+        static constexpr char const    *TAG = "Metrics";
+
+        // Task sample, run time is in the units of the FreeRTOS run time counter.
+        typedef struct {
+            char                        name[METRICS_NAME_LEN];
+            uint32_t                    stackFree;
+            uint32_t                    runTime;
+        } t_taskSample;
+
+        // Queue sample, peak is the deepest seen at a sample point.
+        typedef struct {
+            char                        name[METRICS_NAME_LEN];
+            uint16_t                    depth;
+            uint16_t                    peak;
+            uint16_t                    size;
+        } t_queueSample;
+
+        // Structure to hold a complete sample.
+        typedef struct {
+            uint32_t                    magic;
+            uint32_t                    uptimeMs;
+            uint32_t                    heapFree;
+            uint32_t                    heapMin;
+            uint32_t                    heapLargest;
+            uint32_t                    totalRunTime;
+            uint32_t                    taskCount;
+            t_taskSample                task[METRICS_MAX_TASKS];
+            uint32_t                    queueCount;
+            t_queueSample               queue[METRICS_MAX_QUEUES];
+            uint32_t                    counter[COUNTER_MAX];
+            uint32_t                    histogram[HIST_MAX][METRICS_HIST_BUCKETS];
+        } t_sample;
+
+        // Registered queue.
+        typedef struct {
+            const char                 *name;
+            QueueHandle_t               handle;
+            uint16_t                    peak;
+        } t_queue;
+
+        // Prototypes.
+        static void                     sample(t_sample &current);
+        static std::string              sampleToJSON(t_sample &current);
+
+        // Live counters and histograms, registered queues and the last sample of the interface retained across a software restart.
+        static std::atomic<uint32_t>    counters[COUNTER_MAX];
+        static std::atomic<uint32_t>    histograms[HIST_MAX][METRICS_HIST_BUCKETS];
+        static t_queue                  queues[METRICS_MAX_QUEUES];
+        static uint32_t                 queueCount;
+        static t_sample                 lastRun;
+};
+#endif // METRICS_H
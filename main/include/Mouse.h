@@ -14,6 +14,8 @@
 //                             bluetooth and suspend logic due to NVS issues using both cores.
 //                             Updates to reflect moving functionality into the HID and to support
 //                             Bluetooth as a primary mouse or secondary mouse.            
+//            v1.03 Oct 2026 - Configuration saved before host acceleration was added is migrated.
+//            v1.04 Oct 2026 - Bitbang transport waits on the MSCTRL edge interrupt rather than a 100uS poll.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -50,9 +52,11 @@ class Mouse : public KeyInterface  {
     #define NUMELEM(a)                  (sizeof(a)/sizeof(a[0]))
 
     // Constants.
-    #define MOUSEIF_VERSION             1.02      
+    #define MOUSEIF_VERSION             1.05      
     #define MAX_MOUSE_XMIT_KEY_BUF      128
     #define BITBANG_UART_BIT_TIME       208UL
+    #define MOUSE_IDLE_BACKSTOP         10                                    // Idle wait, in mS, for the MSCTRL edge before it is sampled again.
+    #define MAX_MOUSE_ACCUMULATOR       8192                                  // Limit of unsent movement, caps the catch up after a host stall.
 
     public:
 
@@ -79,8 +83,10 @@ class Mouse : public KeyInterface  {
     private:
         // Prototypes.
         IRAM_ATTR static void           hostInterface( void * pvParameters );
+        IRAM_ATTR static void           msctrlInterrupt( void * pvParameters );
         void                            init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID);
         void                            init(NVS *hdlNVS, HID *hdlHID);
+        void                            getHostPacket(uint8_t *txBuf);
 
         // Structure to maintain mouse interface configuration data. This data is persisted through powercycles as needed.
         typedef struct {
@@ -95,11 +101,26 @@ class Mouse : public KeyInterface  {
             struct {
                 // Host data for adjustment and configuration.
                 enum HID::HID_MOUSE_HOST_SCALING scaling;
+                enum HID::HID_MOUSE_HOST_ACCEL   acceleration;
             } host;
 
             struct {
             } params;
         } t_mouseConfig;
+
+        // Layout of the configuration persisted before host acceleration was added, recognised by its size and migrated.
+        typedef struct {
+            struct {
+                enum HID::HID_MOUSE_RESOLUTION resolution;
+                enum HID::HID_MOUSE_SCALING    scaling;
+                enum HID::HID_MOUSE_SAMPLING   sampleRate;
+            } mouse;
+            struct {
+                enum HID::HID_MOUSE_HOST_SCALING scaling;
+            } host;
+            struct {
+            } params;
+        } t_mouseConfigV1;
        
         // Configuration data.
         t_mouseConfig                   mouseConfig;
@@ -128,17 +149,21 @@ class Mouse : public KeyInterface  {
         // Host Control variables.
         volatile t_hostControl          hostControl;
 
-        // PS/2 to HOST serialiser buffer item.
+        // PS/2 to HOST motion accumulator. HID movement is summed here as it arrives and drained in host sized packets each time the host
+        // requests data, movement beyond the 8bit range of a host packet is carried into the following packets so none is lost.
         typedef struct {
-            uint8_t                     xPos;
-            uint8_t                     yPos;
-            uint8_t                     status;
-            uint8_t                     wheel;
-            bool                        valid;
-        } t_xmitMessage;
-
-        // Create an object for storing the data to be sent to the Host. This data has already been converted and adjusted from the incoming PS/2 message.
-        t_xmitMessage                   xmitMsg;
+            int32_t                     xPos;                                 // Summed X movement not yet sent to the host.
+            int32_t                     yPos;                                 // Summed Y movement, host orientation, not yet sent.
+            int32_t                     wheel;                                // Summed wheel movement not yet sent.
+            uint8_t                     buttons;                              // Current button state.
+            uint8_t                     buttonsLatched;                       // Buttons pressed since the last packet, ensures short clicks reach the host.
+        } t_xmitAccumulator;
+
+        // Create an object for accumulating the data to be sent to the Host. This data has already been converted and adjusted from the incoming PS/2 message.
+        t_xmitAccumulator               xmitAcc;
+
+        // Spin lock guarding the accumulator, it is written on the HID core and drained on the host interface core.
+        portMUX_TYPE                    accMutex;
        
         // Thread handles - one per function, ie. ps/2 interface, host target interface, wifi interface.
         TaskHandle_t                    TaskHostIF = NULL;
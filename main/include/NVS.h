@@ -12,6 +12,7 @@
 //
 // History:         Mar 2022 - Initial write.
 //            v1.01 May 2022 - Initial release version.
+//            v1.02 Oct 2026 - Size of a persisted block, to recognise and migrate an earlier layout.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -62,7 +63,7 @@ class NVS  {
     #define NUMELEM(a)                  (sizeof(a)/sizeof(a[0]))
 
     // Constants.
-    #define NVS_VERSION                 1.01
+    #define NVS_VERSION                 1.02
     
     public:
 
@@ -78,6 +79,7 @@ class NVS  {
         bool                            open(std::string keyName);
         bool                            persistData(const char *key, void *pData, uint32_t size);
         bool                            retrieveData(const char *key, void *pData, uint32_t size);
+        uint32_t                        dataSize(const char *key);
         bool                            commitData(void);
 
         // Helper method to identify the sub class, this is used in non volatile key management.
@@ -11,6 +11,12 @@
 // History:         Apr 2022 - Initial write.
 //            v1.01 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
+//            v1.04 Oct 2026 - Keystroke macros, keys paced by the UART transmit completing.
+//            v1.05 Oct 2026 - Keymap row edits.
+//            v1.06 Oct 2026 - Runtime metrics.
+//            v1.07 Oct 2026 - Per key latency metrics.
+//            v1.08 Oct 2026 - Macro characters reverse mapped through the active keymap.
+//            v1.09 Oct 2026 - Keys discarded on a host reset reported as rejects.
 //
 //
 // Notes:           See Makefile to enable/disable conditional components
@@ -38,6 +44,7 @@
 #include "NVS.h"
 #include "LED.h"
 #include "HID.h"
+#include "HostUART.h"
 #include <vector>
 #include <map>
 
@@ -50,10 +57,36 @@ class PC9801 : public KeyInterface  {
     #define NUMELEM(a)                      (sizeof(a)/sizeof(a[0]))
     
     // Constants.
-    #define PC9801IF_VERSION                1.00
+    #define PC9801IF_VERSION                1.09
     #define PC9801IF_KEYMAP_FILE            "PC9801_KeyMap.BIN"
     #define MAX_PC9801_XMIT_KEY_BUF         16
     #define MAX_PC9801_RCV_KEY_BUF          16
+    #define PC9801_HID_POLL_MS              25                                           // HID thread poll period when no key repeat is pending.
+
+    // Host command protocol, PC-9801 -> keyboard. Each command byte is acknowledged, a command taking a parameter is acknowledged again
+    // when the parameter is received.
+    #define PC9801_HOSTCMD_WINKEY           0x95                                         // Windows/Application key mode, one parameter.
+    #define PC9801_HOSTCMD_IDENTIFY         0x96                                         // Keyboard identification, ACK + 2 byte id.
+    #define PC9801_HOSTCMD_REPEAT           0x9C                                         // Repeat delay and rate, one parameter.
+    #define PC9801_HOSTCMD_LED              0x9D                                         // LED state, one parameter.
+    #define PC9801_HOSTCMD_TYPE             0x9F                                         // Keyboard type, ACK + 2 byte type.
+    #define PC9801_HOSTCMD_RESET            0x00                                         // Internal, /RST asserted by the host.
+    #define PC9801_RESP_ACK                 0xFA
+    #define PC9801_RESP_NACK                0xFC
+    #define PC9801_KEYBOARD_ID              0xA086
+    #define PC9801_KEYBOARD_TYPE            0xA080
+    #define PC9801_LED_SET                  0x70                                         // LED parameter 0111xxxx sets the LEDs.
+    #define PC9801_LED_SET_MASK             0xF0
+    #define PC9801_LED_READ                 0x60                                         // LED parameter requesting the current state.
+    #define PC9801_LED_NUM                  0x01
+    #define PC9801_LED_CAPS                 0x04
+    #define PC9801_LED_KANA                 0x08
+    #define PC9801_REPEAT_DELAY_SHIFT       5                                            // Repeat parameter 0DDRRRRR, delay index and rate.
+    #define PC9801_REPEAT_RATE_MASK         0x1F
+    #define PC9801_REPEAT_TIME_BASE         30                                           // Repeat time = base + rate * step, ms.
+    #define PC9801_REPEAT_TIME_STEP         10
+    #define PC9801_REPEAT_DELAY_DEFAULT     500                                          // Power on repeat delay, ms.
+    #define PC9801_REPEAT_TIME_DEFAULT      60                                           // Power on repeat time, ms.
     
     // NEC PC-9801 Key control bit mask.
     #define PC9801_CTRL_SHIFT               ((unsigned char) (1 << 5))
@@ -291,6 +324,7 @@ class PC9801 : public KeyInterface  {
         void                            getKeyMapTypes(std::vector<std::string>& typeList);
         bool                            getKeyMapSelectList(std::vector<std::pair<std::string, int>>& selectList, std::string option);        
         bool                            getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start);
+        int                             editKeyMap(const std::vector<t_keyMapEdit> &edits);
 
         // Method to return the class version number.
         float version(void)
@@ -303,11 +337,22 @@ class PC9801 : public KeyInterface  {
     private:
         // Prototypes.
         IRAM_ATTR void                  pushKeyToQueue(uint32_t key);
-        IRAM_ATTR void                  pushHostCmdToQueue(uint8_t cmd);
+        IRAM_ATTR void                  pushHostCmdToQueue(uint8_t cmd, uint8_t param);
         IRAM_ATTR static void           pcInterface( void * pvParameters );
         IRAM_ATTR static void           hidInterface( void * pvParameters );
                   void                  selectOption(uint8_t optionCode);
                   uint32_t              mapKey(uint16_t scanCode);
+                  void                  processHostByte(uint8_t data);
+                  void                  processHostCmd(uint8_t hostCmd, uint8_t param);
+                  void                  trackKey(uint16_t scanCode, uint32_t pcKey);
+                  TickType_t            processRepeat(void);
+        bool                            macroHostIdle(void);
+        bool                            macroKey(char chr, uint16_t &keyCode);
+        int                             lookupKey(uint16_t scanCode);
+
+        // Keys queued when the host asserts /RST are discarded, the only refusal the host makes as /RDY and /RTY are not wired, so macro
+        // pacing can adapt to it.
+        bool                            macroHostRejects(void) { return(true); }
         bool                            loadKeyMap();
         bool                            saveKeyMap(void);
         void                            init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID);
@@ -328,6 +373,9 @@ class PC9801 : public KeyInterface  {
             t_keyMapEntry               kme[PS2TBL_PC9801_MAXROWS];
         } t_keyMap;
 
+        // Keymap row selected by mapKey for a key, prototype follows the keymap types it uses.
+        int                             macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode);
+
         // Structure to maintain the NEC PC-9801 interface configuration data. This data is persisted through powercycles as needed.
         typedef struct {
             struct {
@@ -347,22 +395,42 @@ class PC9801 : public KeyInterface  {
             int                         uartNum;
             int                         uartBufferSize;
             int                         uartQueueSize;
+            HostUART                    hostUART;               // UART transport, blocks on host data and keys to transmit.
 
             std::string                 fsPath;                 // Path on the underlying filesystem where storage is mounted and accessible.
-            t_keyMapEntry              *kme;                    // Pointer to an array in memory to contain PS2 to NEC PC-9801 mapping values.
-            int                         kmeRows;                // Number of rows in the kme table.
+            std::atomic<t_keyMapTable<t_keyMapEntry> *> keyMap;    // Active PS2 to NEC PC-9801 mapping table, replaced as a whole on reload.
             std::string                 keyMapFileName;         // Name of file where extension or replacement key map entries are stored.
             bool                        persistConfig;          // Flag to request saving of the config into NVS storage.
+
+            // Host protocol state, owned by the interface thread which must answer within the host timeout.
+            struct {
+                uint8_t                 pendingCmd;             // Command awaiting its parameter, 0 = none.
+                uint8_t                 leds;                   // LED state as last set by the host, PC9801_LED_* bits.
+            } link;
+
+            // Host configured local key repeat, owned by the HID thread. The device typematic is suppressed and the most recently pressed key
+            // is repeated at the host rate.
+            struct {
+                uint32_t                repeatDelay;            // Delay, in ms, before a held key repeats.
+                uint32_t                repeatTime;             // Period, in ms, between repeats.
+                uint8_t                 repeatScan;             // PS/2 key code being repeated, 0 = none.
+                uint32_t                repeatKey;              // PC-9801 key sequence sent on each repeat.
+                TickType_t              repeatNext;             // Tick at which the next repeat is due.
+                uint32_t                heldKeys[8];            // Bitmap of held PS/2 key codes, repeated makes from the device are discarded.
+            } host;
         } t_pcControl;
 
         // Transmit buffer queue item.
         typedef struct {
             uint32_t                    keyCode;                // Key data to be sent to PC-9801, 4 bytes to allow for extended sequences..
+            uint32_t                    eventTime;              // Device event time of the key, Metrics::now(), 0 if none.
+            uint32_t                    queueTime;              // Time the key was queued, Metrics::now().
         } t_xmitQueueMessage;
        
         // Receive buffer queue item.
         typedef struct {
-            uint8_t                     hostCmd;  // Keyboard configuration command received from X68000.
+            uint8_t                     hostCmd;                // Keyboard configuration command received from PC-9801.
+            uint8_t                     param;                  // Command parameter.
         } t_rcvQueueMessage;
 
         // Thread handles - one per function, ie. HID interface and host target interface.
@@ -378,7 +446,7 @@ class PC9801 : public KeyInterface  {
         //
         // This mapping is for the UK Wyse KB-3926 PS/2 keyboard
         //
-        t_keyMap                        PS2toPC9801 = {
+        static constexpr t_keyMap       PS2toPC9801 = {
         {
             //PS2 Code           PS2 Ctrl (Flags to Match)                                    Keyboard Model                        Machine                     PC-9801 Data               PC-9801 Ctrl (Flags to Set).
             // Function keys
@@ -398,6 +398,9 @@ class PS2KeyAdvanced {
        If there is no key available, 0 is returned.  */
     uint16_t read( );
 
+    // Returns the time, Metrics::now(), the key last read was received from the keyboard.
+    uint32_t readTime(void);
+
     /* Returns the current status of Locks
         Use Macro to mask out bits from
         PS2_LOCK_NUM    PS2_LOCK_CAPS   PS2_LOCK_SCROLL */
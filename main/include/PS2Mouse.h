@@ -56,6 +56,7 @@ class PS2Mouse {
     #define INTELLI_MOUSE                  3
     #define SCALING_1_TO_1                 0xE6
     #define DEFAULT_MOUSE_TIMEOUT          100
+    #define MAX_PS2_ACCUMULATOR            0x00FFFFFF                    // Saturation limit of the streaming movement accumulator.
 
     public:
         // Public structures used for containment of mouse movement and control data. These are used by the insantiating
@@ -65,7 +66,8 @@ class PS2Mouse {
             int x, y;
         } Position;
     
-        // Mouse data, containing positional data, status, wheel data and validity.
+        // Mouse data, containing positional data, status, wheel data and validity. Position and wheel values are sign extended movement counts
+        // accumulated since the previous read.
         typedef struct {
             bool     valid;
             bool     overrun;
@@ -168,17 +170,26 @@ class PS2Mouse {
             std::function<void(PS2Mouse::MouseData)> mouseDataCallback;
         } ps2Ctrl;
     
-        // Structure to store incoming streamed mouse data along with validity flags.
+        // Structure to accumulate incoming streamed mouse data along with validity flags. Each completed packet is summed into 32bit accumulators
+        // which are only cleared when the consumer reads them, so movement is coalesced rather than lost when the consumer runs slower than the mouse.
         struct {
-            MouseData            mouseData;
+            uint8_t              packet[4];                                  // Packet being assembled by the interrupt handler.
+            int32_t              accX;                                       // Summed X movement since the last query.
+            int32_t              accY;                                       // Summed Y movement since the last query.
+            int32_t              accWheel;                                   // Summed wheel movement since the last query.
+            uint8_t              buttons;                                    // Button state in the most recent packet.
+            uint8_t              buttonsLatched;                             // Buttons pressed at any time since the last query.
             bool                 newData;                                    // An update has occurred since the last query.
-            bool                 overrun;                                    // A data overrun has occurred since the last query.
+            bool                 overrun;                                    // A packet was discarded or the accumulator saturated since the last query.
+            portMUX_TYPE         mutex;                                      // Spinlock guarding the accumulator between interrupt and reader.
         } streaming;
     
         // Interrupt handler - needs to be declared static and assigned to internal RAM (within the ESP32) to function correctly.
         IRAM_ATTR static void ps2interrupt( void );
     
         // Prototypes.
+        IRAM_ATTR void accumulatePacket(void);
+        void clearStreaming(void);
         bool requestData(uint8_t expectedBytes, uint8_t *respBuf, uint32_t timeout);
         bool sendCmd(uint8_t cmd, uint8_t expectedBytes, uint8_t *respBuf, uint32_t timeout);
 
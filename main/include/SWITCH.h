@@ -45,6 +45,7 @@
 #include "soc/timer_group_struct.h"
 #include "soc/timer_group_reg.h"
 #include "driver/timer.h"
+#include "esp_timer.h"
 #include "LED.h"
 
 
@@ -58,14 +59,32 @@ class SWITCH  {
     #define NUMELEM(a)                  (sizeof(a)/sizeof(a[0]))
 
     // Constants.
-    #define SWITCH_VERSION              1.00
+    #define SWITCH_VERSION              1.01
+    #define SWITCH_DEBOUNCE_MS          20                              // Time for the switch contacts to settle after an edge.
+    #define SWITCH_CANCEL_MIN_MS        200                             // Shortest press accepted, anything less is noise.
+    #define SWITCH_WIFIEN_MIN_MS        1000                            // Press time bands, in milli-seconds, for each switch action.
+    #define SWITCH_WIFIEN_MAX_MS        4000
+    #define SWITCH_WIFIDEF_MIN_MS       5000
+    #define SWITCH_BTPAIRING_MIN_MS     10000
+    #define SWITCH_CLEARNVS_MIN_MS      15000
+    #define SWITCH_RESET_WINDOW_MS      1000                            // Two short presses within this window request a RESET.
     
     public:
+        // Actions which can be selected by the switch press duration.
+        enum SWITCH_EVENT {
+            SWITCH_EVENT_NONE         = 0x00,
+            SWITCH_EVENT_CANCEL       = 0x01,
+            SWITCH_EVENT_WIFIEN       = 0x02,
+            SWITCH_EVENT_WIFIDEF      = 0x03,
+            SWITCH_EVENT_BTPAIRING    = 0x04,
+            SWITCH_EVENT_CLEARNVS     = 0x05,
+        };
 
         // Prototypes.
                                         SWITCH(LED *led);
                                         SWITCH(void);
         virtual                        ~SWITCH(void);
+        static enum SWITCH_EVENT        classifyPress(uint32_t heldMs);
 
         // Method to register an object method for callback with context.
         template<typename A, typename B>
@@ -191,9 +210,10 @@ class SWITCH  {
         // Prototypes.
                          void               init(void);
         IRAM_ATTR static void               swInterface( void * pvParameters );
+        IRAM_ATTR static void               swEdgeInterrupt(void *pvParameters);
         inline uint32_t milliSeconds(void)
         {
-            return( (uint32_t) clock() );
+            return( (uint32_t)(esp_timer_get_time() / 1000) );
         }        
 
         // Structure to maintain an active setting for the LED. The LED control thread uses these values to effect the required lighting of the LED.
@@ -0,0 +1,124 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            TimerService.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Header for a shared hardware timer service. A single free running 1MHz hardware timer
+//                  provides the time base for all interface threads and an alarm interrupt, driven from a
+//                  min-heap of deadlines, wakes the thread owning the earliest deadline via a task
+//                  notification. This replaces the per-thread busy polling of individual timers.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           See Makefile to enable/disable conditional components
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TIMERSERVICE_H
+#define TIMERSERVICE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "soc/timer_group_struct.h"
+#include "soc/timer_group_reg.h"
+#include "driver/timer.h"
+
+// NB: Macros definitions put inside class for clarity, they are still global scope.
+
+// Define a class to encapsulate the shared hardware timer and the scheduler of thread deadlines.
+class TimerService  {
+
+    // Macros.
+    //
+    #define NUMELEM(a)                  (sizeof(a)/sizeof(a[0]))
+
+    // Constants.
+    #define TIMERSERVICE_VERSION        1.00
+    #define TIMERSERVICE_GROUP          TIMER_GROUP_0                   // Hardware timer group used as the shared time base.
+    #define TIMERSERVICE_TIMER          TIMER_0                         // Hardware timer used as the shared time base.
+    #define TIMERSERVICE_MAX_TIMERS     8                               // Maximum number of registered timers, one per thread is sufficient.
+    #define TIMERSERVICE_ALARM_LEAD     5                               // Minimum lead, in uS, when arming the alarm, deadlines closer than this fire immediately.
+    #define TIMERSERVICE_INVALID        -1                              // Invalid timer id or heap position.
+
+    public:
+        // Prototypes.
+                                        TimerService(void);
+        virtual                        ~TimerService(void) {};
+        static TimerService            *getInstance(void);
+        int                             registerTimer(TaskHandle_t owner);
+        bool                            startTimer(int timerId, uint64_t deadline);
+        void                            cancelTimer(int timerId);
+        bool                            sleepUntil(int timerId, uint64_t deadline);
+        IRAM_ATTR void                  spinUntil(uint64_t deadline);
+
+        // Method to return the current time, in uS, of the free running shared timer.
+        inline IRAM_ATTR uint64_t now(void)
+        {
+            // Locals.
+            uint64_t    curTime;
+
+            timer_get_counter_value(TIMERSERVICE_GROUP, TIMERSERVICE_TIMER, &curTime);
+            return(curTime);
+        }
+
+        // Method to return the class version number.
+        virtual float version(void)
+        {
+            return(TIMERSERVICE_VERSION);
+        }
+
+    protected:
+
+    private:
+        // Prototypes.
+        IRAM_ATTR static bool           alarmInterrupt(void *pvParameters);
+        IRAM_ATTR void                  heapSwap(int posA, int posB);
+        IRAM_ATTR void                  heapUp(int pos);
+        IRAM_ATTR void                  heapDown(int pos);
+        IRAM_ATTR void                  heapRemove(int pos);
+        IRAM_ATTR void                  armAlarm(uint64_t curTime);
+
+        // Structure to hold a registered timer, the owning thread is notified when the deadline expires.
+        typedef struct {
+            TaskHandle_t                owner;              // Thread to be notified on expiry.
+            uint64_t                    deadline;           // Absolute expiry time in uS of the shared timer.
+            int                         heapPos;            // Position in the deadline heap, TIMERSERVICE_INVALID when not scheduled.
+        } t_timerSlot;
+
+        // Structure to maintain the scheduler. The heap holds timer ids ordered by deadline, the root being the next to expire and
+        // the only entry the alarm is armed for.
+        typedef struct {
+            t_timerSlot                 slot[TIMERSERVICE_MAX_TIMERS];
+            int                         heap[TIMERSERVICE_MAX_TIMERS];
+            int                         heapSize;
+            int                         slotCount;
+
+            // Spinlock guarding the heap, shared between threads on both cores and the alarm ISR.
+            portMUX_TYPE                mutex;
+        } t_timerControl;
+
+        // Variables to control the scheduler.
+        t_timerControl                  timerCtrl;
+};
+#endif // TIMERSERVICE_H
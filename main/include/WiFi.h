@@ -14,6 +14,12 @@
 //                             via a reboot process. This is necessary now that Bluetooth is inbuilt
 //                             as the ESP32 shares an antenna and both operating together electrically
 //                             is difficult but also the IDF stack conflicts as well.
+//            v1.03 Oct 2026 - Keystroke macro upload.
+//            v1.04 Oct 2026 - WebSocket live channel for status and keymap row edits.
+//            v1.05 Oct 2026 - Runtime metrics.
+//            v1.06 Oct 2026 - WebSocket protocol moved to LiveChannel, keys typed are pushed with their mapping.
+//            v1.07 Oct 2026 - Stopped in place so the interface resumes without a restart, unless an update needs one.
+//            v1.08 Oct 2026 - In place stop withdrawn.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -52,6 +58,7 @@
   #include "NVS.h"
   #include "LED.h"
   #include "HID.h"
+  #include "LiveChannel.h"
 
   // Include the specification class.
   #include "KeyInterface.h"
@@ -59,7 +66,7 @@
   // Encapsulate the WiFi functionality.
   class WiFi {
       // Constants.
-      #define WIFI_VERSION                    1.02
+      #define WIFI_VERSION                    1.08
       #define OBJECT_VERSION_LIST_MAX         18
       #define FILEPACK_VERSION_FILE           "version.txt"
       #define WIFI_AP_DEFAULT_IP              "192.168.4.1"
@@ -242,6 +249,15 @@
           // Control data.
           t_wifiControl                   wifiCtrl;
 
+          // WebSocket live channel protocol, the server carries its frames.
+          LiveChannel                    *live;
+
+          // Message queued by the key monitor for sending from the server context.
+          typedef struct {
+              WiFi                       *wifi;
+              std::string                 message;
+          } t_wsPush;
+
           // Prototypes.
                     bool                  setupWifiClient(void);
                     bool                  setupWifiAP(void);
@@ -268,6 +284,13 @@
           IRAM_ATTR static esp_err_t      otaFilepackUpdatePOSTHandler(httpd_req_t *req);
                     static esp_err_t      keymapUploadPOSTHandler(httpd_req_t *req);
                     static esp_err_t      keymapTablePOSTHandler(httpd_req_t *req);
+                    static esp_err_t      macroPOSTHandler(httpd_req_t *req);
+                    static esp_err_t      metricsGETHandler(httpd_req_t *req);
+                    static esp_err_t      wsHandler(httpd_req_t *req);
+                    static void           wsStatusWork(void *arg);
+                    static void           wsPushWork(void *arg);
+                    static void           wsPush(void *ctx, const std::string &message);
+                    int                   wsBroadcast(const std::string &message, int skipFd);
 
                     static esp_err_t      defaultRebootHandler(httpd_req_t *req);
                     esp_err_t             getPOSTData(httpd_req_t *req, std::vector<t_kvPair> *pairs);
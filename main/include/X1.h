@@ -13,6 +13,11 @@
 //            v1.02 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
 //            v1.03 Jun 2022 - Further updates adding in keymaps for UK BT and Japan OADG109.
+//            v1.04 Oct 2026 - Keystroke macros, characters reverse mapped through the active keymap.
+//            v1.05 Oct 2026 - Keymap row edits.
+//            v1.06 Oct 2026 - Runtime metrics.
+//            v1.07 Oct 2026 - Per key latency metrics.
+//            v1.08 Oct 2026 - Macro characters only typed through the active keymap.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -51,7 +56,7 @@ class X1 : public KeyInterface  {
     #define NUMELEM(a)                      (sizeof(a)/sizeof(a[0]))
     
     // Constants.
-    #define X1IF_VERSION                    1.03
+    #define X1IF_VERSION                    1.08
     #define X1IF_KEYMAP_FILE                "X1_KeyMap.BIN"
     #define MAX_X1_XMIT_KEY_BUF             16
     #define PS2TBL_X1_MAXROWS               349
@@ -194,6 +199,7 @@ class X1 : public KeyInterface  {
         void                            getKeyMapTypes(std::vector<std::string>& typeList);
         bool                            getKeyMapSelectList(std::vector<std::pair<std::string, int>>& selectList, std::string option);        
         bool                            getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start);
+        int                             editKeyMap(const std::vector<t_keyMapEdit> &edits);
 
         // Method to return the class version number.
         float version(void)
@@ -210,6 +216,8 @@ class X1 : public KeyInterface  {
         IRAM_ATTR static void           hidInterface( void * pvParameters );
                   void                  selectOption(uint8_t optionCode);
                   uint32_t              mapKey(uint16_t scanCode);
+        bool                            macroKey(char chr, uint16_t &keyCode);
+        int                             lookupKey(uint16_t scanCode);
         bool                            loadKeyMap();
         bool                            saveKeyMap(void);
         void                            init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID);
@@ -255,6 +263,9 @@ class X1 : public KeyInterface  {
             t_keyMapEntry               kme[PS2TBL_X1_MAXROWS];
         } t_keyMap;
 
+        // Keymap row selected by mapKey for a key, prototype follows the keymap types it uses.
+        int                             macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode);
+
         // Structure to maintain the X1 interface configuration data. This data is persisted through powercycles as needed.
         typedef struct {
             struct {
@@ -273,8 +284,7 @@ class X1 : public KeyInterface  {
             uint8_t                     keyCtrl;                // Keyboard state flag control.
 
             std::string                 fsPath;                 // Path on the underlying filesystem where storage is mounted and accessible.
-            t_keyMapEntry              *kme;                    // Pointer to an array in memory to contain PS2 to X1 mapping values.
-            int                         kmeRows;                // Number of rows in the kme table.
+            std::atomic<t_keyMapTable<t_keyMapEntry> *> keyMap;    // Active PS2 to X1 mapping table, replaced as a whole on reload.
             std::string                 keyMapFileName;         // Name of file where extension or replacement key map entries are stored.
             bool                        persistConfig;          // Flag to request saving of the config into NVS storage.
         } t_x1Control;
@@ -283,6 +293,8 @@ class X1 : public KeyInterface  {
         typedef struct {
             uint32_t                    keyCode;  // 32bit because normal mode A is 16bit, game mode B is 24bit
             bool                        modeB;    // True if in game mode B.
+            uint32_t                    eventTime;// Device event time of the key, Metrics::now(), 0 if none.
+            uint32_t                    queueTime;// Time the key was queued, Metrics::now().
         } t_xmitQueueMessage;
 
         // Thread handles - one per function, ie. HID interface and host target interface.
@@ -303,7 +315,7 @@ class X1 : public KeyInterface  {
         //
         // This mapping is for the UK Wyse KB-3926 PS/2 keyboard
         //
-        t_keyMap                        PS2toX1 = {
+        static constexpr t_keyMap       PS2toX1 = {
         {
             // HELP
             // COPY
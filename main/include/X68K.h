@@ -13,6 +13,12 @@
 //            v1.02 Jun 2022 - Updates to reflect changes realised in other modules due to addition of
 //                             bluetooth and suspend logic due to NVS issues using both cores.
 //            v1.03 Jun 2022 - Further updates adding in keymaps for UK BT and Japan OADG109.
+//            v1.06 Oct 2026 - Keystroke macros, keys paced by the UART transmit completing.
+//            v1.07 Oct 2026 - Keymap row edits.
+//            v1.08 Oct 2026 - Runtime metrics.
+//            v1.09 Oct 2026 - Per key latency metrics.
+//            v1.10 Oct 2026 - Macro characters reverse mapped through the active keymap.
+//            v1.11 Oct 2026 - Key inhibit during macro playback reported as a reject.
 //
 // Notes:           See Makefile to enable/disable conditional components
 //
@@ -39,6 +45,7 @@
 #include "NVS.h"
 #include "LED.h"
 #include "HID.h"
+#include "HostUART.h"
 #include <vector>
 #include <map>
 
@@ -51,10 +58,31 @@ class X68K : public KeyInterface  {
     #define NUMELEM(a)                      (sizeof(a)/sizeof(a[0]))
     
     // Constants.
-    #define X68KIF_VERSION                  1.03   
+    #define X68KIF_VERSION                  1.11   
     #define X68KIF_KEYMAP_FILE              "X68K_KeyMap.BIN"
     #define MAX_X68K_XMIT_KEY_BUF           16
     #define MAX_X68K_RCV_KEY_BUF            16
+    #define X68K_HID_POLL_MS                25                                        // HID thread poll period when no key repeat is pending.
+    
+    // Host command decoding, X68000 -> keyboard.
+    #define X68K_HOSTCMD_LED                0x80                                      // 1xxxxxxx - LED state, 0 = ON.
+    #define X68K_HOSTCMD_LED_MASK           0x80
+    #define X68K_HOSTCMD_REPEAT_TIME        0x70                                      // 0111xxxx - Repeat time.
+    #define X68K_HOSTCMD_REPEAT_DELAY       0x60                                      // 0110xxxx - Repeat delay.
+    #define X68K_HOSTCMD_REPEAT_MASK        0xF0
+    #define X68K_HOSTCMD_BRIGHTNESS         0x54                                      // 010101xx - LED brightness.
+    #define X68K_HOSTCMD_BRIGHTNESS_MASK    0xFC
+    #define X68K_HOSTCMD_KEY_ENABLE         0x48                                      // 0100100x - Key data transmission, 1 = enabled.
+    #define X68K_HOSTCMD_KEY_ENABLE_MASK    0xFE
+    #define X68K_LED_KANA                   0x01
+    #define X68K_LED_ROMAJI                 0x02
+    #define X68K_LED_CODE_INPUT             0x04
+    #define X68K_LED_CAPS                   0x08
+    #define X68K_LED_INS                    0x10
+    #define X68K_LED_HIRAGANA               0x20
+    #define X68K_LED_FULL_WIDTH             0x40
+    #define X68K_REPEAT_DELAY_DEFAULT       500                                       // Power on repeat delay, ms.
+    #define X68K_REPEAT_TIME_DEFAULT        110                                       // Power on repeat time, ms.
     
     // PS2 Flag definitions.
     #define PS2CTRL_NONE                    0x00                                      // No keys active = 0
@@ -290,6 +318,7 @@ class X68K : public KeyInterface  {
         void                            getKeyMapTypes(std::vector<std::string>& typeList);
         bool                            getKeyMapSelectList(std::vector<std::pair<std::string, int>>& selectList, std::string option);        
         bool                            getKeyMapData(std::vector<uint32_t>& dataArray, int *row, bool start);
+        int                             editKeyMap(const std::vector<t_keyMapEdit> &edits);
 
         // Method to return the class version number.
         float version(void)
@@ -307,6 +336,15 @@ class X68K : public KeyInterface  {
         IRAM_ATTR static void           hidInterface( void * pvParameters );
                   void                  selectOption(uint8_t optionCode);
                   uint32_t              mapKey(uint16_t scanCode);
+                  void                  processHostCmd(uint8_t hostCmd);
+                  void                  trackKey(uint16_t scanCode, uint32_t x68kKey);
+                  TickType_t            processRepeat(void);
+        bool                            macroHostIdle(void);
+        bool                            macroKey(char chr, uint16_t &keyCode);
+        int                             lookupKey(uint16_t scanCode);
+
+        // The host inhibits key data it is not ready for, so macro pacing can adapt to it.
+        bool                            macroHostRejects(void) { return(true); }
         bool                            loadKeyMap();
         bool                            saveKeyMap(void);
         void                            init(uint32_t ifMode, NVS *hdlNVS, LED *hdlLED, HID *hdlHID);
@@ -326,6 +364,9 @@ class X68K : public KeyInterface  {
         typedef struct {
             t_keyMapEntry               kme[PS2TBL_X68K_MAXROWS];
         } t_keyMap;
+
+        // Keymap row selected by mapKey for a key, prototype follows the keymap types it uses.
+        int                             macroMapRow(t_keyMapTable<t_keyMapEntry> *keyMap, uint16_t scanCode);
         
         // Structure to maintain the X68000 interface configuration data. This data is persisted through powercycles as needed.
         typedef struct {
@@ -346,17 +387,32 @@ class X68K : public KeyInterface  {
             int                         uartNum;
             int                         uartBufferSize;
             int                         uartQueueSize;
+            HostUART                    hostUART;               // UART transport, blocks on host data and keys to transmit.
 
             std::string                 fsPath;                 // Path on the underlying filesystem where storage is mounted and accessible.
-            t_keyMapEntry              *kme;                    // Pointer to an array in memory to contain PS2 to X68K mapping values.
-            int                         kmeRows;                // Number of rows in the kme table.
+            std::atomic<t_keyMapTable<t_keyMapEntry> *> keyMap;    // Active PS2 to X68K mapping table, replaced as a whole on reload.
             std::string                 keyMapFileName;         // Name of file where extension or replacement key map entries are stored.
             bool                        persistConfig;          // Flag to request saving of the config into NVS storage.
+
+            // Host command state and the local key repeat it configures. The device typematic is suppressed, only the most recently pressed
+            // key is repeated, as on the X68000 keyboard.
+            struct {
+                uint8_t                 leds;                   // Last LED command, X68000 negative logic.
+                bool                    keyEnable;              // Host accepts key data.
+                uint32_t                repeatDelay;            // Delay, in ms, before a held key repeats.
+                uint32_t                repeatTime;             // Period, in ms, between repeats.
+                uint8_t                 repeatScan;             // PS/2 key code being repeated, 0 = none.
+                uint32_t                repeatKey;              // X68000 key sequence sent on each repeat.
+                TickType_t              repeatNext;             // Tick at which the next repeat is due.
+                uint32_t                heldKeys[8];            // Bitmap of held PS/2 key codes, repeated makes from the device are discarded.
+            } host;
         } t_x68kControl;
 
         // Transmit buffer queue item.
         typedef struct {
             uint32_t                    keyCode;                // Key data to be sent to X68000.
+            uint32_t                    eventTime;              // Device event time of the key, Metrics::now(), 0 if none.
+            uint32_t                    queueTime;              // Time the key was queued, Metrics::now().
         } t_xmitQueueMessage;
        
         // Receive buffer queue item.
@@ -382,7 +438,7 @@ class X68K : public KeyInterface  {
         //
         //const unsigned char PS2toX68K[PS2TBL_X68K_MAXROWS][PS2TBL_X68K_MAXCOLS] =
         //t_keyMapEntry                         PS2toX68K[PS2TBL_X68K_MAXROWS] = 
-        t_keyMap                        PS2toX68K = {
+        static constexpr t_keyMap       PS2toX68K = {
         {
             //PS2 Code           PS2 Ctrl (Flags to Match)                                    Keyboard Model                        Machine                   X68K Data                X68K Ctrl (Flags to Set).
             // Function keys
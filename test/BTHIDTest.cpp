@@ -0,0 +1,505 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            BTHIDTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the BTHID key merge. Reports from several devices are interleaved through the
+//                  HID host shim and the PS/2 events checked against a reference model of the merged key
+//                  view. The BT to PS/2 lookup tables are checked against a search of the mapping tables.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+#include "BTHID.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // The interface under test, one instance per process as BTHID only allows a single setup.
+    BTHID &bthid(void)
+    {
+        static BTHID                   *instance = NULL;
+
+        if(instance == NULL)
+        {
+            instance = new BTHID();
+            instance->setup(NULL, NULL);
+        }
+        return(*instance);
+    }
+
+    esp_hidh_dev_t *openKeyboard(uint8_t id)
+    {
+        // Locals.
+        //
+        const uint8_t                   bda[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, id };
+        esp_hidh_dev_t                 *dev;
+
+        bthid();
+        dev = Shim::hidhCreateDevice(bda, ESP_HID_TRANSPORT_BT, ESP_HID_USAGE_KEYBOARD, "Keyboard");
+        Shim::hidhOpen(dev);
+        return(dev);
+    }
+
+    // Send a boot keyboard report holding the given modifier byte and scan codes.
+    void keyReport(esp_hidh_dev_t *dev, uint8_t modifiers, const std::set<uint8_t> &keys)
+    {
+        // Locals.
+        //
+        uint8_t                         report[MAX_KEYBOARD_DATA_BYTES];
+        int                             idx = 2;
+
+        memset(report, 0x00, sizeof(report));
+        report[0] = modifiers;
+        for(uint8_t key : keys)
+            report[idx++] = key;
+        Shim::hidhInput(dev, ESP_HID_USAGE_KEYBOARD, 1, report, sizeof(report));
+    }
+
+    void mediaReport(esp_hidh_dev_t *dev, uint32_t media)
+    {
+        // Locals.
+        //
+        const uint8_t                   report[MAX_CCONTROL_DATA_BYTES] = { (uint8_t)(media >> 16), (uint8_t)(media >> 8), (uint8_t)media };
+
+        Shim::hidhInput(dev, ESP_HID_USAGE_CCONTROL, 3, report, sizeof(report));
+    }
+
+    // All PS/2 events generated so far, reduced to the key code and break flag.
+    std::vector<uint16_t> drain(void)
+    {
+        // Locals.
+        //
+        std::vector<uint16_t>           events;
+        uint16_t                        key;
+
+        while((key = bthid().getKey(0)) != 0x0000)
+            events.push_back(key & (PS2_BREAK | 0x00FF));
+        return(events);
+    }
+
+    // The PS/2 code of BT usages A..Z.
+    uint16_t ps2Letter(uint8_t btKey)
+    {
+        return(PS2_KEY_A + (btKey - BT_KEY_A));
+    }
+
+    // Access to the key translation of an unconnected interface, with the first match search of the mapping tables it replaced as reference.
+    class MapProbe : public BTHID
+    {
+        public:
+            uint16_t map(uint8_t key, uint16_t btFlags)
+            {
+                btHIDCtrl.kbd.btFlags = btFlags;
+                return(mapBTtoPS2(key));
+            }
+
+            uint16_t mapMedia(uint32_t key)
+            {
+                return(mapBTMediaToPS2(key));
+            }
+
+            uint16_t referenceMap(uint8_t key, uint16_t btFlags)
+            {
+                // Locals.
+                //
+                uint16_t                retKey = 0x0000;
+
+                for(int idx=0; idx < btHIDCtrl.kbd.kmeRows && retKey == 0x0000; idx++)
+                {
+                    if(btHIDCtrl.kbd.kme[idx].btKeyCode == key && (btHIDCtrl.kbd.kme[idx].btCtrl == btFlags || btHIDCtrl.kbd.kme[idx].btCtrl == BT_NONE))
+                    {
+                        retKey = (uint16_t)btHIDCtrl.kbd.kme[idx].ps2KeyCode;
+                        if((retKey <= PS2_KEY_SPACE || retKey >= PS2_KEY_F1) && retKey != PS2_KEY_BTICK && retKey != PS2_KEY_HASH && retKey != PS2_KEY_EUROPE2) retKey |= PS2_FUNCTION;
+                        if(btFlags & BT_CTRL_LEFT || btFlags & BT_CTRL_RIGHT)   retKey |= PS2_CTRL;
+                        if(btFlags & BT_SHIFT_LEFT || btFlags & BT_SHIFT_RIGHT) retKey |= PS2_SHIFT;
+                        if(btFlags & BT_ALT_LEFT)                               retKey |= PS2_ALT;
+                        if(btFlags & BT_ALT_RIGHT)                              retKey |= PS2_ALT_GR;
+                        if(btFlags & BT_GUI_LEFT || btFlags & BT_GUI_RIGHT)     retKey |= PS2_GUI;
+                    }
+                }
+                return(retKey);
+            }
+
+            uint16_t referenceMedia(uint32_t key)
+            {
+                for(int idx=0; idx < btHIDCtrl.kbd.kmeMediaRows; idx++)
+                {
+                    if(btHIDCtrl.kbd.kmeMedia[idx].mediaKey == key)
+                        return((btHIDCtrl.kbd.kmeMedia[idx].ps2Ctrl << 8) | btHIDCtrl.kbd.kmeMedia[idx].ps2Key);
+                }
+                return(0x0000);
+            }
+
+            // Rebuild the lookup tables from a given mapping table, rows of BT key, BT control, PS/2 key and PS/2 control.
+            void loadKeyMap(const std::vector<std::vector<uint16_t>> &rows)
+            {
+                keyMap.resize(rows.size());
+                for(std::size_t idx=0; idx < rows.size(); idx++)
+                {
+                    keyMap[idx].btKeyCode  = (uint8_t)rows[idx][0];
+                    keyMap[idx].btCtrl     = rows[idx][1];
+                    keyMap[idx].ps2KeyCode = (uint8_t)rows[idx][2];
+                    keyMap[idx].ps2Ctrl    = rows[idx][3];
+                }
+                btHIDCtrl.kbd.kme     = keyMap.data();
+                btHIDCtrl.kbd.kmeRows = (int)keyMap.size();
+                buildKeyMaps();
+            }
+
+            // Media keys in the mapping table, to cover any which are not a single bit.
+            std::vector<uint32_t> mediaKeys(void)
+            {
+                // Locals.
+                //
+                std::vector<uint32_t>   keys;
+
+                for(int idx=0; idx < btHIDCtrl.kbd.kmeMediaRows; idx++)
+                    keys.push_back(btHIDCtrl.kbd.kmeMedia[idx].mediaKey);
+                return(keys);
+            }
+
+        private:
+            std::vector<t_keyMapEntry>  keyMap;
+    };
+
+    // Every BT control state, the modifier byte with each combination of the lock flags.
+    std::vector<uint16_t> allBTFlags(void)
+    {
+        // Locals.
+        //
+        std::vector<uint16_t>           flags;
+        const uint16_t                  locks[] = { BT_CAPS_LOCK, BT_NUM_LOCK, BT_SCROLL_LOCK };
+
+        for(int lockSet=0; lockSet < 8; lockSet++)
+        {
+            for(int modifiers=0; modifiers < 256; modifiers++)
+            {
+                flags.push_back((uint16_t)modifiers);
+                for(int idx=0; idx < 3; idx++)
+                    if(lockSet & (1 << idx))
+                        flags.back() |= locks[idx];
+            }
+        }
+        return(flags);
+    }
+}
+
+// The LED merge only replaces the bits selected by the mask.
+TEST_CASE(mergeLEDsKeepsUnmaskedBits)
+{
+    CHECK_EQ(BTHID::mergeLEDs(0x00, 0x07, 0x00), 0x00);
+    CHECK_EQ(BTHID::mergeLEDs(0x05, 0x00, 0x01), 0x04);
+    CHECK_EQ(BTHID::mergeLEDs(0x00, BT_LED_CAPSLOCK, BT_LED_CAPSLOCK), BT_LED_CAPSLOCK);
+    CHECK_EQ(BTHID::mergeLEDs(BT_LED_NUMLOCK, BT_LED_CAPSLOCK | BT_LED_SCROLLLOCK, BT_LED_CAPSLOCK), BT_LED_NUMLOCK | BT_LED_CAPSLOCK);
+    CHECK_EQ(BTHID::mergeLEDs(0xFF, 0x00, 0xFF), 0x00);
+}
+
+// A key or modifier held on two keyboards makes once on the first press and breaks once on the last release, a close releases what the device held.
+TEST_CASE(twoKeyboardsShareKeys)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = openKeyboard(1);
+    esp_hidh_dev_t                     *devB = openKeyboard(2);
+    std::vector<uint16_t>               events;
+
+    drain();
+    keyReport(devA, 0, { BT_KEY_A });
+    keyReport(devB, 0, { BT_KEY_A });
+    CHECK(drain() == std::vector<uint16_t>({ PS2_KEY_A }));
+    keyReport(devA, 0, { });
+    CHECK(drain().empty());
+    keyReport(devB, 0, { });
+    CHECK(drain() == std::vector<uint16_t>({ PS2_KEY_A | PS2_BREAK }));
+
+    keyReport(devA, BT_SHIFT_LEFT, { });
+    keyReport(devB, BT_SHIFT_LEFT, { BT_KEY_A + 1 });
+    events = drain();
+    CHECK_EQ(events.size(), 2U);
+    if(events.size() == 2)
+    {
+        CHECK_EQ(events[0], PS2_KEY_L_SHIFT);
+        CHECK_EQ(events[1], PS2_KEY_A + 1);
+    }
+    Shim::hidhClose(devA);
+    CHECK(drain().empty());
+    Shim::hidhClose(devB);
+    events = drain();
+    CHECK_EQ(events.size(), 2U);
+    if(events.size() == 2)
+    {
+        CHECK_EQ(events[0], PS2_KEY_L_SHIFT | PS2_BREAK);
+        CHECK_EQ(events[1], (PS2_KEY_A + 1) | PS2_BREAK);
+    }
+}
+
+// Media keys are reference counted across devices as the keyboard keys.
+TEST_CASE(mediaKeysShareAcrossDevices)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = openKeyboard(3);
+    esp_hidh_dev_t                     *devB = openKeyboard(4);
+
+    drain();
+    mediaReport(devA, BT_MEDIA_MUTE);
+    mediaReport(devB, BT_MEDIA_MUTE | BT_MEDIA_VOL_UP);
+    CHECK(drain() == std::vector<uint16_t>({ PS2_KEY_MUTE, PS2_KEY_VOL_UP }));
+    mediaReport(devA, 0);
+    CHECK(drain().empty());
+    mediaReport(devB, BT_MEDIA_VOL_UP);
+    CHECK(drain() == std::vector<uint16_t>({ PS2_KEY_MUTE | PS2_BREAK }));
+    Shim::hidhClose(devB);
+    CHECK(drain() == std::vector<uint16_t>({ PS2_KEY_VOL_UP | PS2_BREAK }));
+    Shim::hidhClose(devA);
+    CHECK(drain().empty());
+}
+
+// Random interleaved reports from three keyboards, the events must match the changes of the union of the pressed sets.
+TEST_CASE(interleavedReportsMatchMergedView)
+{
+    // Locals.
+    //
+    std::mt19937                        rng(2026);
+    esp_hidh_dev_t                     *devs[3];
+    std::set<uint8_t>                   held[3];
+    int                                 refCnt[256] = { 0 };
+    std::vector<uint16_t>               expected;
+    std::vector<uint16_t>               breaks;
+    std::vector<uint16_t>               makes;
+    std::set<uint8_t>                   next;
+    int                                 mismatches = 0;
+    int                                 dev;
+
+    for(int idx = 0; idx < 3; idx++)
+        devs[idx] = openKeyboard(10 + idx);
+    drain();
+
+    for(int report = 0; report < 5000; report++)
+    {
+        dev = rng() % 3;
+        next.clear();
+        for(int cnt = rng() % 7; cnt > 0; cnt--)
+            next.insert(BT_KEY_A + (rng() % 8));
+
+        breaks.clear();
+        makes.clear();
+        for(uint8_t key : held[dev])
+            if(next.count(key) == 0 && --refCnt[key] == 0)
+                breaks.push_back(ps2Letter(key) | PS2_BREAK);
+        for(uint8_t key : next)
+            if(held[dev].count(key) == 0 && refCnt[key]++ == 0)
+                makes.push_back(ps2Letter(key));
+        expected = breaks;
+        expected.insert(expected.end(), makes.begin(), makes.end());
+        held[dev] = next;
+
+        keyReport(devs[dev], 0, next);
+        if(drain() != expected)
+            mismatches++;
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // Closing every device releases each key still held exactly once.
+    expected.clear();
+    for(int idx = 0; idx < 3; idx++)
+    {
+        Shim::hidhClose(devs[idx]);
+        for(uint16_t key : drain())
+            expected.push_back(key);
+    }
+    for(int key = 0; key < 256; key++)
+    {
+        if(refCnt[key] > 0)
+        {
+            CHECK_EQ(std::count(expected.begin(), expected.end(), ps2Letter(key) | PS2_BREAK), 1);
+        }
+    }
+    for(uint16_t key : expected)
+        CHECK((key & PS2_BREAK) != 0);
+}
+
+// A host LED request and a lock key pressed on either keyboard reach every open keyboard, a closed keyboard is skipped.
+TEST_CASE(keyboardLEDsReachEveryKeyboard)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = openKeyboard(20);
+    esp_hidh_dev_t                     *devB = openKeyboard(21);
+    esp_hidh_dev_t                     *devC = openKeyboard(22);
+    uint32_t                            closedCount;
+
+    drain();
+    Shim::hidhClose(devC);
+    closedCount = Shim::hidhOutputCount(devC);
+    bthid().setKeyboardLEDs(BT_LED_CAPSLOCK, BT_LED_CAPSLOCK);
+    drain();
+    CHECK(Shim::hidhOutput(devA) == std::vector<uint8_t>({ BT_LED_CAPSLOCK }));
+    CHECK(Shim::hidhOutput(devB) == std::vector<uint8_t>({ BT_LED_CAPSLOCK }));
+
+    // Two requests before the HID thread runs merge, the later one wins for the bits it selects.
+    bthid().setKeyboardLEDs(BT_LED_NUMLOCK, BT_LED_NUMLOCK | BT_LED_CAPSLOCK);
+    bthid().setKeyboardLEDs(BT_LED_SCROLLLOCK, BT_LED_SCROLLLOCK);
+    drain();
+    CHECK(Shim::hidhOutput(devB) == std::vector<uint8_t>({ BT_LED_NUMLOCK | BT_LED_SCROLLLOCK }));
+
+    // Caps lock on keyboard A lights the LED on keyboard B.
+    keyReport(devA, 0, { BT_KEY_CAPSLOCK });
+    keyReport(devA, 0, { });
+    drain();
+    CHECK((Shim::hidhOutput(devB)[0] & BT_LED_CAPSLOCK) != 0);
+    keyReport(devB, 0, { BT_KEY_CAPSLOCK });
+    keyReport(devB, 0, { });
+    drain();
+    CHECK((Shim::hidhOutput(devA)[0] & BT_LED_CAPSLOCK) == 0);
+    CHECK_EQ(Shim::hidhOutputCount(devC), closedCount);
+
+    Shim::hidhClose(devA);
+    Shim::hidhClose(devB);
+    drain();
+}
+
+// Every BT scan code in every modifier and lock state translates as the first match search of the mapping table.
+TEST_CASE(usageMapMatchesTableSearch)
+{
+    // Locals.
+    //
+    MapProbe                            probe;
+    int                                 mismatches = 0;
+    int                                 mapped = 0;
+    int                                 overridden = 0;
+
+    for(uint16_t btFlags : allBTFlags())
+    {
+        for(int key=0; key < 256; key++)
+        {
+            if(probe.map((uint8_t)key, btFlags) != probe.referenceMap((uint8_t)key, btFlags) && mismatches++ < 10)
+                printf("  key %02x flags %04x: %04x, table %04x\n", key, btFlags, probe.map((uint8_t)key, btFlags), probe.referenceMap((uint8_t)key, btFlags));
+            mapped += probe.map((uint8_t)key, btFlags) != 0x0000;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // The search covered mapped keys and the NUM LOCK keypad entries, which only apply with no modifier held.
+    CHECK(mapped > 100 * 2048);
+    for(int key=0; key < 256; key++)
+        overridden += probe.map((uint8_t)key, BT_NUM_LOCK) != probe.map((uint8_t)key, BT_NONE);
+    CHECK(overridden > 0);
+    CHECK_EQ(probe.map(BT_KEY_A, BT_SHIFT_LEFT), PS2_KEY_A | PS2_SHIFT);
+    CHECK_EQ(probe.map(BT_KEY_A, BT_CTRL_RIGHT | BT_ALT_RIGHT | BT_CAPS_LOCK), PS2_KEY_A | PS2_CTRL | PS2_ALT_GR);
+}
+
+// Tables with duplicate and qualified entries in any order, ie. a qualified entry after the unqualified one never applies, build lookups
+// which translate as the first match search.
+TEST_CASE(usageMapBuiltFromAnyTable)
+{
+    // Locals.
+    //
+    MapProbe                            probe;
+    std::mt19937                        rng(330);
+    const uint16_t                      ctrls[] = { BT_NONE, BT_NONE, BT_NUM_LOCK, BT_CAPS_LOCK, BT_NUM_LOCK | BT_SHIFT_LEFT };
+    std::vector<std::vector<uint16_t>>  rows;
+    std::vector<uint16_t>               flags = { BT_NONE, BT_NUM_LOCK, BT_CAPS_LOCK, BT_NUM_LOCK | BT_SHIFT_LEFT, BT_SHIFT_LEFT, BT_NUM_LOCK | BT_CAPS_LOCK };
+    int                                 mismatches = 0;
+    int                                 qualified;
+    uint16_t                            btCtrl;
+
+    for(int table=0; table < 200; table++)
+    {
+        rows.clear();
+        qualified = 0;
+        for(int idx=0; idx < 40; idx++)
+        {
+            btCtrl = ctrls[rng() % NUMELEM(ctrls)];
+            if(btCtrl != BT_NONE && ++qualified > MAX_BT2PS2_OVERRIDES)
+                btCtrl = BT_NONE;
+            rows.push_back({ (uint16_t)(BT_KEY_A + rng() % 8), btCtrl, (uint16_t)(rng() % 0x100), PS2_FLG_NONE });
+        }
+        probe.loadKeyMap(rows);
+        for(uint16_t btFlags : flags)
+        {
+            for(int key=0; key < 256; key++)
+            {
+                if(probe.map((uint8_t)key, btFlags) != probe.referenceMap((uint8_t)key, btFlags) && mismatches++ < 10)
+                    printf("  table %d key %02x flags %04x: %04x, table %04x\n", table, key, btFlags, probe.map((uint8_t)key, btFlags), probe.referenceMap((uint8_t)key, btFlags));
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+// Media keys translate as the table search for single bits, pairs of bits and every key in the table.
+TEST_CASE(mediaMapMatchesTableSearch)
+{
+    // Locals.
+    //
+    MapProbe                            probe;
+    std::vector<uint32_t>               keys = probe.mediaKeys();
+    int                                 mismatches = 0;
+    int                                 mapped = 0;
+
+    keys.push_back(0);
+    for(int bit=0; bit < 32; bit++)
+        for(int bit2=bit; bit2 < 32; bit2++)
+            keys.push_back((1UL << bit) | (1UL << bit2));
+    for(uint32_t key : keys)
+    {
+        if(probe.mapMedia(key) != probe.referenceMedia(key) && mismatches++ < 10)
+            printf("  media %06x: %04x, table %04x\n", key, probe.mapMedia(key), probe.referenceMedia(key));
+        mapped += probe.mapMedia(key) != 0x0000;
+    }
+    CHECK_EQ(mismatches, 0);
+    CHECK(mapped > 10);
+}
+
+// The lookup against the table search it replaced, over a key stream mixing letters, keypad keys and modifier states.
+TEST_CASE(usageMapBenchmark)
+{
+    // Locals.
+    //
+    MapProbe                            probe;
+    std::vector<uint16_t>               flags = allBTFlags();
+    std::mt19937                        rng(33);
+    std::vector<uint8_t>                keys;
+    uint32_t                            sink = 0;
+    double                              lookupNs;
+    double                              searchNs;
+
+    for(int idx=0; idx < 4096; idx++)
+        keys.push_back((uint8_t)(rng() % 0xE8));
+    lookupNs = TestRunner::benchmark("mapBTtoPS2 lookup", 2000000, [&](uint32_t idx) { sink += probe.map(keys[idx & 4095], flags[idx % flags.size()]); });
+    searchNs = TestRunner::benchmark("mapping table search", 2000000, [&](uint32_t idx) { sink += probe.referenceMap(keys[idx & 4095], flags[idx % flags.size()]); });
+    printf("  key lookup %.1fx the table search\n", searchNs / lookupNs);
+    CHECK(lookupNs < searchNs);
+    lookupNs = TestRunner::benchmark("mapBTMediaToPS2 lookup", 2000000, [&](uint32_t idx) { sink += probe.mapMedia(1UL << (idx % 24)); });
+    searchNs = TestRunner::benchmark("media table search", 2000000, [&](uint32_t idx) { sink += probe.referenceMedia(1UL << (idx % 24)); });
+    printf("  media lookup %.1fx the table search (%u)\n", searchNs / lookupNs, sink & 1);
+}
+
+TEST_MAIN()
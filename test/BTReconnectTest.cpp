@@ -0,0 +1,318 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            BTReconnectTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the BTHID fast reconnect. The last connected device record is placed in NVS and
+//                  the bonded and advertising devices set in the shim before BTHID is set up, the direct
+//                  open, the periodic check and the discovery scan are then raced by delaying the opens.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           BTHID only allows a single setup per process, each case is run as its own ctest.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include "BTHID.h"
+#include "NVS.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    const uint8_t                       bdaA[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x01 };
+    const uint8_t                       bdaB[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x02 };
+
+    // Access to the reconnect state and device list of the interface under test.
+    class ReconnectProbe : public BTHID
+    {
+        public:
+            // Write the last connected device record as a previous session would have left it.
+            static void storeLastDevice(NVS &nvs, const uint8_t *bda, esp_hid_transport_t transport)
+            {
+                // Locals.
+                //
+                t_lastDevice            lastDev;
+
+                memset(&lastDev, 0x00, sizeof(lastDev));
+                lastDev.valid     = BTHID_LASTDEV_VALID;
+                memcpy(lastDev.bda, bda, sizeof(esp_bd_addr_t));
+                lastDev.transport = transport;
+                lastDev.addrType  = BLE_ADDR_TYPE_RANDOM;
+                nvs.persistData(BTHID_NVS_KEY, &lastDev, sizeof(lastDev));
+                nvs.commitData();
+            }
+
+            // Bda of the last connected device record held in NVS, false if there is no valid record.
+            static bool storedLastDevice(NVS &nvs, uint8_t *bda)
+            {
+                // Locals.
+                //
+                t_lastDevice            lastDev;
+
+                if(nvs.retrieveData(BTHID_NVS_KEY, &lastDev, sizeof(lastDev)) == false || lastDev.valid != BTHID_LASTDEV_VALID)
+                    return(false);
+                memcpy(bda, lastDev.bda, sizeof(esp_bd_addr_t));
+                return(true);
+            }
+
+            bool active(void)
+            {
+                return(btHIDCtrl.reconnect.active);
+            }
+
+            bool lastDeviceValid(void)
+            {
+                return(btHIDCtrl.reconnect.lastDev.valid == BTHID_LASTDEV_VALID);
+            }
+
+            int64_t setupTime(void) { return(btHIDCtrl.reconnect.setupTime); }
+            int64_t openTime(void)  { return(btHIDCtrl.reconnect.openTime); }
+            int64_t keyTime(void)   { return(btHIDCtrl.reconnect.keyTime); }
+
+            bool isOpen(const uint8_t *bda)
+            {
+                // Locals.
+                //
+                bool                    open = false;
+
+                xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
+                for(std::size_t idx = 0; idx < btHIDCtrl.devices.size(); idx++)
+                {
+                    if(memcmp(btHIDCtrl.devices[idx].bda, bda, sizeof(esp_bd_addr_t)) == 0)
+                        open = btHIDCtrl.devices[idx].open;
+                }
+                xSemaphoreGive(btHIDCtrl.devMutex);
+                return(open);
+            }
+
+            // Make every device due an open attempt, the check interval is CPU time which barely moves in a test.
+            void expireChecks(void)
+            {
+                xSemaphoreTake(btHIDCtrl.devMutex, portMAX_DELAY);
+                for(std::size_t idx = 0; idx < btHIDCtrl.devices.size(); idx++)
+                    btHIDCtrl.devices[idx].nextCheckTime = 0;
+                xSemaphoreGive(btHIDCtrl.devMutex);
+            }
+    };
+
+    NVS &nvs(void)
+    {
+        static NVS                     *instance = NULL;
+
+        if(instance == NULL)
+        {
+            instance = new NVS();
+            instance->init();
+            instance->open("SharpKey");
+        }
+        return(*instance);
+    }
+
+    // The interface under test, set up against the shim state the case has prepared.
+    ReconnectProbe &bthid(void)
+    {
+        static ReconnectProbe          *instance = NULL;
+
+        if(instance == NULL)
+        {
+            instance = new ReconnectProbe();
+            instance->setup(NULL, &nvs());
+        }
+        return(*instance);
+    }
+
+    esp_hidh_dev_t *keyboard(const uint8_t *bda)
+    {
+        return(Shim::hidhCreateDevice(bda, ESP_HID_TRANSPORT_BLE, ESP_HID_USAGE_KEYBOARD, "Keyboard"));
+    }
+
+    // Wait, in real time, for a condition set by the interface threads.
+    bool waitFor(std::function<bool(void)> condition, uint32_t timeoutMs = 2000)
+    {
+        // Locals.
+        //
+        auto                            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        while(condition() == false)
+        {
+            if(std::chrono::steady_clock::now() > deadline)
+                return(false);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return(true);
+    }
+}
+
+// The device record is written to NVS by the periodic check after an open, once per change of device.
+TEST_CASE(persistOnlyOnChange)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = keyboard(bdaA);
+    esp_hidh_dev_t                     *devB = keyboard(bdaB);
+    uint8_t                             stored[6];
+
+    bthid();
+    CHECK(bthid().lastDeviceValid() == false);
+    Shim::hidhOpen(devA);
+    CHECK(waitFor([](){ return(bthid().isOpen(bdaA)); }));
+    CHECK_EQ(Shim::nvsWrites(BTHID_NVS_KEY), 0U);
+    bthid().checkBTDevices();
+    CHECK_EQ(Shim::nvsWrites(BTHID_NVS_KEY), 1U);
+    CHECK(ReconnectProbe::storedLastDevice(nvs(), stored) && memcmp(stored, bdaA, sizeof(stored)) == 0);
+
+    // Reopening the same device leaves the record alone.
+    Shim::hidhClose(devA);
+    CHECK(waitFor([](){ return(bthid().isOpen(bdaA) == false); }));
+    Shim::hidhOpen(devA);
+    CHECK(waitFor([](){ return(bthid().isOpen(bdaA)); }));
+    bthid().checkBTDevices();
+    CHECK_EQ(Shim::nvsWrites(BTHID_NVS_KEY), 1U);
+
+    // A different device replaces it.
+    Shim::hidhOpen(devB);
+    CHECK(waitFor([](){ return(bthid().isOpen(bdaB)); }));
+    bthid().checkBTDevices();
+    bthid().checkBTDevices();
+    CHECK_EQ(Shim::nvsWrites(BTHID_NVS_KEY), 2U);
+    CHECK(ReconnectProbe::storedLastDevice(nvs(), stored) && memcmp(stored, bdaB, sizeof(stored)) == 0);
+}
+
+// A stored device whose pairing has been cleared is not opened directly, nor by the periodic check.
+TEST_CASE(unbondedRecordDropped)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = keyboard(bdaA);
+
+    ReconnectProbe::storeLastDevice(nvs(), bdaA, ESP_HID_TRANSPORT_BLE);
+    CHECK(bthid().lastDeviceValid() == false);
+    CHECK(bthid().active() == false);
+    bthid().checkBTDevices();
+    Shim::settle(100);
+    CHECK_EQ(Shim::hidhOpenCount(devA), 0U);
+    CHECK(bthid().isOpen(bdaA) == false);
+}
+
+// Whilst the direct open is in progress the periodic check leaves the device alone, even when its check time is due.
+TEST_CASE(checkSkipsWhileActive)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = keyboard(bdaA);
+
+    Shim::btBond(bdaA, ESP_HID_TRANSPORT_BLE);
+    Shim::hidhOpenDelay(devA, 300);
+    ReconnectProbe::storeLastDevice(nvs(), bdaA, ESP_HID_TRANSPORT_BLE);
+    CHECK(bthid().lastDeviceValid());
+    CHECK(waitFor([devA](){ return(Shim::hidhOpenCount(devA) == 1); }));
+    CHECK(bthid().active());
+    bthid().expireChecks();
+    bthid().checkBTDevices();
+    CHECK_EQ(Shim::hidhOpenCount(devA), 1U);
+
+    // Once the direct open completes the device is open and the check has nothing to do.
+    CHECK(waitFor([](){ return(bthid().active() == false); }));
+    CHECK(bthid().isOpen(bdaA));
+    bthid().expireChecks();
+    bthid().checkBTDevices();
+    CHECK_EQ(Shim::hidhOpenCount(devA), 1U);
+}
+
+// A slow direct open does not hold up the scan, an advertising device connects first.
+TEST_CASE(scanWinsWhenDirectSlow)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = keyboard(bdaA);
+    esp_hidh_dev_t                     *devB = keyboard(bdaB);
+
+    Shim::btBond(bdaA, ESP_HID_TRANSPORT_BLE);
+    Shim::hidhOpenDelay(devA, 500);
+    Shim::bleAdvertise(bdaB, "Keyboard");
+    ReconnectProbe::storeLastDevice(nvs(), bdaA, ESP_HID_TRANSPORT_BLE);
+    CHECK(bthid().active());
+    bthid().checkBTDevices();
+    CHECK(bthid().isOpen(bdaB));
+    CHECK(bthid().active());
+    CHECK(bthid().isOpen(bdaA) == false);
+    CHECK_EQ(Shim::hidhOpenCount(devB), 1U);
+
+    // The direct open still completes and its device is kept.
+    CHECK(waitFor([](){ return(bthid().active() == false); }));
+    CHECK(bthid().isOpen(bdaA));
+    CHECK(bthid().isOpen(bdaB));
+}
+
+// A direct open which connects during the scan stops the scan results being opened.
+TEST_CASE(directWinsWhenScanSlow)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = keyboard(bdaA);
+    esp_hidh_dev_t                     *devB = keyboard(bdaB);
+
+    Shim::btBond(bdaA, ESP_HID_TRANSPORT_BLE);
+    Shim::hidhOpenDelay(devA, 50);
+    Shim::bleAdvertise(bdaB, "Keyboard");
+    Shim::btScanTime(300);
+    ReconnectProbe::storeLastDevice(nvs(), bdaA, ESP_HID_TRANSPORT_BLE);
+    CHECK(bthid().active());
+    bthid().checkBTDevices();
+    CHECK(bthid().isOpen(bdaA));
+    CHECK(bthid().isOpen(bdaB) == false);
+    CHECK_EQ(Shim::hidhOpenCount(devB), 0U);
+
+    // With a device open the check no longer scans.
+    CHECK(waitFor([](){ return(bthid().active() == false); }));
+    bthid().checkBTDevices();
+    CHECK_EQ(Shim::hidhOpenCount(devB), 0U);
+}
+
+// The boot timeline records BT setup, the first open and the first key in that order.
+TEST_CASE(bootTimeline)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                     *devA = keyboard(bdaA);
+    uint8_t                             report[MAX_KEYBOARD_DATA_BYTES];
+    uint16_t                            key = 0x0000;
+
+    Shim::btBond(bdaA, ESP_HID_TRANSPORT_BLE);
+    ReconnectProbe::storeLastDevice(nvs(), bdaA, ESP_HID_TRANSPORT_BLE);
+    CHECK(bthid().setupTime() > 0);
+    CHECK(waitFor([](){ return(bthid().openTime() != 0); }));
+    CHECK_EQ(bthid().keyTime(), 0);
+
+    memset(report, 0x00, sizeof(report));
+    report[2] = BT_KEY_A;
+    Shim::hidhInput(devA, ESP_HID_USAGE_KEYBOARD, 1, report, sizeof(report));
+    CHECK(waitFor([&key](){ return((key = bthid().getKey(0)) != 0x0000); }));
+    CHECK_EQ(key & 0x00FF, PS2_KEY_A);
+    CHECK(bthid().keyTime() != 0);
+    CHECK(bthid().setupTime() <= bthid().openTime());
+    CHECK(bthid().openTime() <= bthid().keyTime());
+}
+
+TEST_MAIN()
@@ -0,0 +1,525 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            BTScanTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the BT scan result tables. Synthetic advertisements are given to the GAP scan
+//                  result handlers with the clock frozen and the tables checked against a reference model
+//                  of the devices held, with LRU eviction, RSSI averaging and aging.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "BT.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+// Heap allocations made by the calling thread, to check the GAP handlers never allocate.
+static thread_local uint32_t            heapAllocs = 0;
+
+void *operator new(std::size_t size)
+{
+    // Locals.
+    //
+    void                               *ptr;
+
+    heapAllocs++;
+    if((ptr = malloc(size == 0 ? 1 : size)) == NULL)
+        throw std::bad_alloc();
+    return(ptr);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t size) noexcept
+{
+    free(ptr);
+}
+
+namespace
+{
+    // Access to the scan result tables of an unconnected interface, advertisements are built as the controller would deliver them.
+    class ScanProbe : public BT
+    {
+        public:
+            // A BT Classic inquiry result as delivered by the controller.
+            typedef struct {
+                esp_bd_addr_t           bda;
+                uint32_t                cod;
+                int8_t                  rssi;
+                char                    name[64];
+            } t_inquiryResult;
+
+            // Build a BLE advertisement, only those carrying the HID service are held.
+            static esp_ble_gap_cb_param_t bleAdvert(uint64_t addr, int rssi, const char *name = "", bool hid = true)
+            {
+                // Locals.
+                //
+                esp_ble_gap_cb_param_t  param;
+                int                     pos = 0;
+                const uint8_t           uuid[2] = { (uint8_t)(hid ? 0x12 : 0x0F), 0x18 };
+                const uint8_t           appearance[2] = { 0xC1, 0x03 };
+
+                memset(&param, 0x00, sizeof(param));
+                param.scan_rst.search_evt    = ESP_GAP_SEARCH_INQ_RES_EVT;
+                param.scan_rst.ble_addr_type = BLE_ADDR_TYPE_RANDOM;
+                param.scan_rst.rssi          = rssi;
+                toBDA(addr, param.scan_rst.bda);
+                addRecord(param.scan_rst.ble_adv, pos, ESP_BLE_AD_TYPE_16SRV_CMPL, uuid, sizeof(uuid));
+                addRecord(param.scan_rst.ble_adv, pos, ESP_BLE_AD_TYPE_APPEARANCE, appearance, sizeof(appearance));
+                if(strlen(name) > 0)
+                    addRecord(param.scan_rst.ble_adv, pos, ESP_BLE_AD_TYPE_NAME_CMPL, (const uint8_t *)name, strlen(name));
+                return(param);
+            }
+
+            // Build a BT Classic inquiry result, held if the device is a peripheral or already known.
+            static t_inquiryResult btInquiry(uint64_t addr, int8_t rssi, const char *name = "", bool peripheral = true)
+            {
+                // Locals.
+                //
+                t_inquiryResult         result;
+
+                memset(&result, 0x00, sizeof(result));
+                toBDA(addr, result.bda);
+                result.cod  = (peripheral ? ESP_BT_COD_MAJOR_DEV_PERIPHERAL : ESP_BT_COD_MAJOR_DEV_PHONE) << 8 | (0x10 << 2);
+                result.rssi = rssi;
+                strncpy(result.name, name, sizeof(result.name) - 1);
+                return(result);
+            }
+
+            // Give an advertisement to the BLE GAP scan result handler.
+            void advertiseBLE(const esp_ble_gap_cb_param_t &advert)
+            {
+                // Locals.
+                //
+                esp_ble_gap_cb_param_t  param = advert;
+
+                processBLEDeviceScanResult(&param);
+            }
+
+            void advertiseBLE(uint64_t addr, int rssi, const char *name = "", bool hid = true)
+            {
+                advertiseBLE(bleAdvert(addr, rssi, name, hid));
+            }
+
+            // Give an inquiry result to the BT GAP scan result handler, the name property is only present if named.
+            void discoverBT(t_inquiryResult result)
+            {
+                // Locals.
+                //
+                esp_bt_gap_cb_param_t   param;
+                esp_bt_gap_dev_prop_t   prop[3];
+
+                memset(&param, 0x00, sizeof(param));
+                memcpy(param.disc_res.bda, result.bda, sizeof(esp_bd_addr_t));
+                prop[0] = { ESP_BT_GAP_DEV_PROP_COD,    sizeof(result.cod),  &result.cod };
+                prop[1] = { ESP_BT_GAP_DEV_PROP_RSSI,   sizeof(result.rssi), &result.rssi };
+                prop[2] = { ESP_BT_GAP_DEV_PROP_BDNAME, (int)strlen(result.name), result.name };
+                param.disc_res.num_prop = strlen(result.name) > 0 ? 3 : 2;
+                param.disc_res.prop     = prop;
+                processBTDeviceScanResult(&param);
+            }
+
+            void discoverBT(uint64_t addr, int8_t rssi, const char *name = "", bool peripheral = true)
+            {
+                discoverBT(btInquiry(addr, rssi, name, peripheral));
+            }
+
+            // Held entry of a device, NULL if not in the table.
+            const t_scanEntry *find(uint64_t addr, bool ble = true)
+            {
+                // Locals.
+                //
+                esp_bd_addr_t           bda;
+
+                toBDA(addr, bda);
+                return(findScanEntry(ble ? btCtrl.bleScanTable : btCtrl.btScanTable, bda));
+            }
+
+            // Addresses of the devices held.
+            std::vector<uint64_t> held(bool ble = true)
+            {
+                // Locals.
+                //
+                t_scanTable            &table = ble ? btCtrl.bleScanTable : btCtrl.btScanTable;
+                std::vector<uint64_t>   addrs;
+
+                for(int idx=0; idx < BT_SCAN_TABLE_SIZE; idx++)
+                {
+                    if(table.entry[idx].used)
+                        addrs.push_back(fromBDA(table.entry[idx].bda));
+                }
+                std::sort(addrs.begin(), addrs.end());
+                return(addrs);
+            }
+
+            // The count is the number of used slots and every entry is found from its hashed slot, ie. removal left no gap in a probe chain.
+            bool consistent(bool ble = true)
+            {
+                // Locals.
+                //
+                t_scanTable            &table = ble ? btCtrl.bleScanTable : btCtrl.btScanTable;
+                int                     used = 0;
+
+                for(int idx=0; idx < BT_SCAN_TABLE_SIZE; idx++)
+                {
+                    if(table.entry[idx].used)
+                    {
+                        used++;
+                        if(findScanEntry(table, table.entry[idx].bda) != &table.entry[idx])
+                            return(false);
+                    }
+                }
+                return(used == table.count && used <= BT_SCAN_MAX_ENTRIES);
+            }
+
+            // The scan list as built at the end of a scan started at the given tick.
+            std::vector<t_scanListItem> results(TickType_t since, bool ble = true)
+            {
+                // Locals.
+                //
+                std::vector<t_scanListItem> scanList;
+
+                copyScanResults(ble ? btCtrl.bleScanTable : btCtrl.btScanTable, since, scanList);
+                return(scanList);
+            }
+
+            // Insert or refresh a device directly, without the handler.
+            void insert(uint64_t addr)
+            {
+                // Locals.
+                //
+                esp_bd_addr_t           bda;
+
+                toBDA(addr, bda);
+                insertScanEntry(btCtrl.bleScanTable, bda)->lastSeen = xTaskGetTickCount();
+            }
+
+            void clear(void)
+            {
+                memset(&btCtrl.btScanTable, 0x00, sizeof(t_scanTable));
+                memset(&btCtrl.bleScanTable, 0x00, sizeof(t_scanTable));
+            }
+
+            static void toBDA(uint64_t addr, uint8_t *bda)
+            {
+                for(int idx=0; idx < 6; idx++)
+                    bda[idx] = (uint8_t)(addr >> (8 * (5 - idx)));
+            }
+
+            static uint64_t fromBDA(const uint8_t *bda)
+            {
+                // Locals.
+                //
+                uint64_t                addr = 0;
+
+                for(int idx=0; idx < 6; idx++)
+                    addr = (addr << 8) | bda[idx];
+                return(addr);
+            }
+
+        private:
+            static void addRecord(uint8_t *adv, int &pos, uint8_t type, const uint8_t *data, size_t len)
+            {
+                adv[pos++] = (uint8_t)(len + 1);
+                adv[pos++] = type;
+                memcpy(&adv[pos], data, len);
+                pos += len;
+            }
+    };
+
+    ScanProbe &scanner(void)
+    {
+        // Locals.
+        //
+        static ScanProbe               *instance = NULL;
+
+        if(instance == NULL)
+        {
+            Shim::freezeTime();
+            Shim::advanceTime(1000000);
+            instance = new ScanProbe();
+        }
+        instance->clear();
+        return(*instance);
+    }
+
+    // Step the clock by whole milli-seconds, one tick each.
+    void tick(uint32_t ms = 1)
+    {
+        Shim::advanceTime(ms * 1000LL);
+    }
+
+    // Synthetic device addresses, random so the hashed slots collide as they would on air.
+    std::vector<uint64_t> devicePool(int count, uint32_t seed)
+    {
+        // Locals.
+        //
+        std::mt19937_64                 rng(seed);
+        std::vector<uint64_t>           pool;
+
+        for(int idx=0; idx < count; idx++)
+            pool.push_back(rng() & 0xFFFFFFFFFFFFULL);
+        return(pool);
+    }
+}
+
+// A device is held once however many times it advertises, its name and transport details are kept.
+TEST_CASE(advertisementsHeldOncePerDevice)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+    const ScanProbe::t_scanListItem    *item;
+    std::vector<ScanProbe::t_scanListItem> list;
+    TickType_t                          start = xTaskGetTickCount();
+
+    for(int idx=0; idx < 5; idx++)
+    {
+        scan.advertiseBLE(0x112233445566ULL, -60, "Keyboard");
+        scan.advertiseBLE(0x665544332211ULL, -70, "Mouse");
+        tick();
+    }
+    scan.advertiseBLE(0x0A0B0C0D0E0FULL, -50, "Speaker", false);
+    CHECK(scan.held() == std::vector<uint64_t>({ 0x112233445566ULL, 0x665544332211ULL }));
+    CHECK(scan.consistent());
+
+    list = scan.results(start);
+    CHECK_EQ(list.size(), 2u);
+    item = list[0].name == "Keyboard" ? &list[0] : &list[1];
+    CHECK(item->name == std::string("Keyboard"));
+    CHECK_EQ(item->transport, ESP_HID_TRANSPORT_BLE);
+    CHECK_EQ(item->ble.addr_type, BLE_ADDR_TYPE_RANDOM);
+    CHECK_EQ(item->ble.appearance, 0x03C1);
+    CHECK_EQ(ScanProbe::fromBDA(item->bda), 0x112233445566ULL);
+
+    // Classic peripherals are held, other classes are not unless already known. A name in a later result fills the entry.
+    scan.discoverBT(0xA1A2A3A4A5A6ULL, -40);
+    scan.discoverBT(0xB1B2B3B4B5B6ULL, -40, "Phone", false);
+    scan.discoverBT(0xA1A2A3A4A5A6ULL, -40, "BT Keyboard", false);
+    CHECK(scan.held(false) == std::vector<uint64_t>({ 0xA1A2A3A4A5A6ULL }));
+    list = scan.results(start, false);
+    CHECK_EQ(list.size(), 1u);
+    CHECK(list[0].name == std::string("BT Keyboard"));
+    CHECK_EQ(list[0].transport, ESP_HID_TRANSPORT_BT);
+    CHECK_EQ(list[0].bt.cod.major, (uint32_t)ESP_BT_COD_MAJOR_DEV_PERIPHERAL);
+}
+
+// Names longer than the entry buffer are truncated, not overrun.
+TEST_CASE(longNamesTruncated)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+    std::string                         name(40, 'N');
+
+    scan.advertiseBLE(0x010203040506ULL, -60, name.c_str());
+    CHECK_EQ(scan.find(0x010203040506ULL)->nameLen, BT_SCAN_NAME_LEN);
+    CHECK(scan.results(0)[0].name == name.substr(0, BT_SCAN_NAME_LEN));
+    CHECK(scan.consistent());
+}
+
+// Each advertisement folds its RSSI into a running average.
+TEST_CASE(rssiAveraged)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+
+    scan.advertiseBLE(0x0000000000AAULL, -80);
+    CHECK_EQ(scan.find(0x0000000000AAULL)->rssi, -80);
+    scan.advertiseBLE(0x0000000000AAULL, -40);
+    CHECK_EQ(scan.find(0x0000000000AAULL)->rssi, -70);
+    for(int idx=0; idx < 40; idx++)
+        scan.advertiseBLE(0x0000000000AAULL, -40);
+    CHECK(scan.find(0x0000000000AAULL)->rssi >= -43);
+
+    // A classic result without an RSSI leaves the average.
+    scan.discoverBT(0x0000000000BBULL, -60);
+    scan.discoverBT(0x0000000000BBULL, 0);
+    CHECK_EQ(scan.find(0x0000000000BBULL, false)->rssi, -60);
+}
+
+// At the load limit a new device evicts the least recently seen, a device which keeps advertising is never evicted.
+TEST_CASE(leastRecentlySeenEvicted)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+    std::vector<uint64_t>               pool = devicePool(BT_SCAN_MAX_ENTRIES + 8, 36);
+
+    for(int idx=0; idx < BT_SCAN_MAX_ENTRIES; idx++)
+    {
+        scan.advertiseBLE(pool[idx], -60);
+        tick();
+    }
+    CHECK_EQ(scan.held().size(), (size_t)BT_SCAN_MAX_ENTRIES);
+
+    // Refresh the oldest, the next oldest goes when a new device arrives.
+    scan.advertiseBLE(pool[0], -60);
+    tick();
+    scan.advertiseBLE(pool[BT_SCAN_MAX_ENTRIES], -60);
+    CHECK(scan.find(pool[0]) != NULL);
+    CHECK(scan.find(pool[1]) == NULL);
+    CHECK(scan.find(pool[BT_SCAN_MAX_ENTRIES]) != NULL);
+    CHECK_EQ(scan.held().size(), (size_t)BT_SCAN_MAX_ENTRIES);
+    CHECK(scan.consistent());
+}
+
+// Only devices seen since the scan started are reported, devices unseen for BT_SCAN_MAX_AGE are dropped.
+TEST_CASE(resultsAgedBySighting)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+    TickType_t                          start;
+
+    scan.advertiseBLE(0x000000000001ULL, -60, "Old");
+    tick(BT_SCAN_MAX_AGE / 2);
+    start = xTaskGetTickCount();
+    scan.advertiseBLE(0x000000000002ULL, -60, "New");
+    CHECK_EQ(scan.results(start).size(), 1u);
+    CHECK(scan.results(start)[0].name == std::string("New"));
+    CHECK_EQ(scan.held().size(), 2u);
+
+    // The earlier device is held until it ages out, a sighting before then keeps its name.
+    tick(BT_SCAN_MAX_AGE / 2 + 1);
+    CHECK_EQ(scan.results(0).size(), 1u);
+    CHECK(scan.held() == std::vector<uint64_t>({ 0x000000000002ULL }));
+    scan.advertiseBLE(0x000000000002ULL, -60);
+    CHECK(scan.results(start)[0].name == std::string("New"));
+    CHECK(scan.consistent());
+}
+
+// Random advertisements from a pool larger than the table, with aging, against a reference model of the devices held.
+TEST_CASE(tableMatchesReferenceModel)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+    std::vector<uint64_t>               pool = devicePool(80, 360);
+    std::mt19937                        rng(3600);
+    std::map<uint64_t, TickType_t>      model;
+    std::map<uint64_t, TickType_t>::iterator oldest;
+    std::vector<uint64_t>               expected;
+    uint64_t                            addr;
+    int                                 mismatches = 0;
+
+    for(int op=0; op < 20000; op++)
+    {
+        // Mostly a small active set with a tail of rare devices, so entries are refreshed, evicted and aged.
+        addr = pool[rng() % 4 != 0 ? rng() % 16 : rng() % pool.size()];
+        tick(1 + (rng() % 50 == 0 ? rng() % BT_SCAN_MAX_AGE : 0));
+        scan.advertiseBLE(addr, -50 - (int)(rng() % 40));
+        if(model.find(addr) == model.end() && model.size() >= BT_SCAN_MAX_ENTRIES)
+        {
+            oldest = model.begin();
+            for(auto it = model.begin(); it != model.end(); ++it)
+                if(it->second < oldest->second)
+                    oldest = it;
+            model.erase(oldest);
+        }
+        model[addr] = xTaskGetTickCount();
+
+        // End of a scan, aging out devices.
+        if(op % 500 == 499)
+        {
+            tick(rng() % BT_SCAN_MAX_AGE);
+            scan.results(0);
+            for(auto it = model.begin(); it != model.end(); )
+                it = (xTaskGetTickCount() - it->second) > pdMS_TO_TICKS(BT_SCAN_MAX_AGE) ? model.erase(it) : ++it;
+        }
+
+        expected.clear();
+        for(auto &device : model)
+            expected.push_back(device.first);
+        if((scan.held() != expected || !scan.consistent()) && mismatches++ < 5)
+            printf("  op %d: %u held, model %u\n", op, (unsigned)scan.held().size(), (unsigned)expected.size());
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+// Advertisements are handled without touching the heap, new devices, known devices and evictions alike.
+TEST_CASE(advertisementsDontAllocate)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+    std::vector<uint64_t>               pool = devicePool(200, 3601);
+    std::vector<esp_ble_gap_cb_param_t> adverts;
+    std::vector<ScanProbe::t_inquiryResult> inquiries;
+    uint32_t                            allocs;
+
+    for(uint64_t addr : pool)
+    {
+        adverts.push_back(ScanProbe::bleAdvert(addr, -60, "Keyboard"));
+        inquiries.push_back(ScanProbe::btInquiry(addr, -60, "Keyboard"));
+    }
+    allocs = heapAllocs;
+    for(int idx=0; idx < 2000; idx++)
+    {
+        scan.advertiseBLE(adverts[idx % pool.size()]);
+        scan.discoverBT(inquiries[idx % pool.size()]);
+        tick();
+    }
+    CHECK_EQ(heapAllocs - allocs, 0u);
+    CHECK_EQ(scan.held().size(), (size_t)BT_SCAN_MAX_ENTRIES);
+    CHECK_EQ(scan.held(false).size(), (size_t)BT_SCAN_MAX_ENTRIES);
+}
+
+// Thousands of synthetic advertisements, from a few devices re-advertising and from a stream of new devices forcing eviction.
+TEST_CASE(advertisementBenchmark)
+{
+    // Locals.
+    //
+    ScanProbe                          &scan = scanner();
+    std::vector<esp_ble_gap_cb_param_t> few;
+    std::vector<esp_ble_gap_cb_param_t> many;
+    std::vector<ScanProbe::t_inquiryResult> inquiries;
+
+    for(uint64_t addr : devicePool(16, 3602))
+        few.push_back(ScanProbe::bleAdvert(addr, -60, "Keyboard"));
+    for(uint64_t addr : devicePool(10000, 3603))
+    {
+        many.push_back(ScanProbe::bleAdvert(addr, -60, "Keyboard"));
+        inquiries.push_back(ScanProbe::btInquiry(addr, -60, "Keyboard"));
+    }
+    TestRunner::benchmark("BLE advertisement, 16 devices", 10000, [&](uint32_t idx) { scan.advertiseBLE(few[idx & 15]); });
+    TestRunner::benchmark("BLE advertisement, 10000 devices", 10000, [&](uint32_t idx) { tick(); scan.advertiseBLE(many[idx]); });
+    TestRunner::benchmark("BT inquiry result, 10000 devices", 10000, [&](uint32_t idx) { tick(); scan.discoverBT(inquiries[idx]); });
+    TestRunner::benchmark("Table insert, 10000 devices", 10000, [&](uint32_t idx) { tick(); scan.insert(ScanProbe::fromBDA(many[idx].scan_rst.bda)); });
+    CHECK(scan.consistent());
+    CHECK(scan.consistent(false));
+}
+
+TEST_MAIN()
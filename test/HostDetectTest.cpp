@@ -0,0 +1,221 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            HostDetectTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the host classification. Each host edge rate signature is classified over a
+//                  range of measurement windows, the decision must follow the rates and not the raw
+//                  counts. The KDB0 count is run tick by tick against periodic edges to check when it ends,
+//                  with and without a cached host type.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//                  Oct 2026 - KDB0 count ended early and cached host confirmation.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include "HostDetect.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // Host signal signature as edge rates, converted to counts for a given window.
+    struct t_signature
+    {
+        const char                     *name;
+        uint32_t                        mpxPerSec;
+        uint32_t                        rtsnPerSec;
+        uint32_t                        ctrlPerSec;
+        bool                            x1Loopback;
+        bool                            mpxLevel;
+        bool                            rtsnLevel;
+        bool                            kdi4Level;
+        uint32_t                        ifMode;
+        uint32_t                        allowBit;
+    };
+
+    const t_signature                   signatures[] = {
+        { "MZ-2500",          10000, 10000,   0, false, true,  true,  false, 2500,  HOSTDETECT_ALLOW_MZ2500 },
+        { "MZ-2500 slow scan", 2000,  1600,   0, false, true,  true,  false, 2500,  HOSTDETECT_ALLOW_MZ2500 },
+        { "MZ-2800",          10000,   600,   0, false, true,  true,  false, 2800,  HOSTDETECT_ALLOW_MZ2800 },
+        { "MZ-2800 RTSN idle", 10000,    0,   0, false, true,  true,  false, 2800,  HOSTDETECT_ALLOW_MZ2800 },
+        { "X1",                   0,     0,   0, true,  false, false, false, 1,     HOSTDETECT_ALLOW_X1     },
+        { "X68000",               0,     0,   0, false, false, true,  false, 68000, HOSTDETECT_ALLOW_X68000 },
+        { "X68000 stray edges",   0,     0,  15, false, false, true,  true,  68000, HOSTDETECT_ALLOW_X68000 },
+        { "Mouse",                0,     0, 100, false, false, true,  true,  2,     HOSTDETECT_ALLOW_MOUSE  },
+        { "Mouse slow MSCTRL",    0,     0,  60, false, false, true,  true,  2,     HOSTDETECT_ALLOW_MOUSE  },
+        { "Unknown idle",         0,     0,   0, false, true,  true,  true,  0,     0                       },
+        { "Unknown no KDI4",      0,     0,  60, false, false, true,  false, 0,     0                       },
+    };
+
+    HostDetect::t_hostSignals measure(const t_signature &sig, uint32_t windowUs, uint32_t ctrlWindowUs)
+    {
+        // Locals.
+        //
+        HostDetect::t_hostSignals       signals;
+
+        memset(&signals, 0, sizeof(signals));
+        signals.windowUs     = windowUs;
+        signals.mpxEdges     = (uint32_t)(((uint64_t)sig.mpxPerSec * windowUs) / 1000000);
+        signals.rtsnEdges    = (uint32_t)(((uint64_t)sig.rtsnPerSec * windowUs) / 1000000);
+        signals.ctrlWindowUs = ctrlWindowUs;
+        signals.ctrlEdges    = (uint32_t)(((uint64_t)sig.ctrlPerSec * ctrlWindowUs) / 1000000);
+        signals.x1Loopback   = sig.x1Loopback;
+        signals.mpxLevel     = sig.mpxLevel;
+        signals.rtsnLevel    = sig.rtsnLevel;
+        signals.kdi4Level    = sig.kdi4Level;
+        return(signals);
+    }
+
+    // Run the KDB0 count as getHostType does, one 1mS tick at a time after the parallel window, against periodic edges of the signature
+    // starting at the given phase. Returns the signals at the end of the count.
+    HostDetect::t_hostSignals countCtrl(const t_signature &sig, uint32_t phaseUs, uint32_t cachedIfMode)
+    {
+        // Locals.
+        //
+        HostDetect::t_hostSignals       signals = measure(sig, HOSTDETECT_WINDOW_US, 0);
+        uint32_t                        periodUs = sig.ctrlPerSec == 0 ? 0 : 1000000 / sig.ctrlPerSec;
+
+        signals.ctrlWindowUs = HOSTDETECT_WINDOW_US;
+        do {
+            signals.ctrlWindowUs += 1000;
+            signals.ctrlEdges     = periodUs == 0 || signals.ctrlWindowUs < phaseUs ? 0 : (signals.ctrlWindowUs - phaseUs) / periodUs + 1;
+        } while(HostDetect::isCtrlDecided(signals, cachedIfMode) == false);
+        return(signals);
+    }
+}
+
+// Every signature classifies to its host whether the windows are the nominal length, shorter, or stretched by a slow polling loop.
+TEST_CASE(classifyFollowsRatesAcrossWindows)
+{
+    // Locals.
+    //
+    const uint32_t                      scale[][2] = { { 1, 1 }, { 1, 2 }, { 2, 1 }, { 4, 1 }, { 10, 1 } };
+    uint32_t                            ifMode;
+
+    for(const t_signature &sig : signatures)
+    {
+        for(const uint32_t *factor : scale)
+        {
+            ifMode = HostDetect::classify(measure(sig, HOSTDETECT_WINDOW_US * factor[0] / factor[1], HOSTDETECT_CTRL_WINDOW_US * factor[0] / factor[1]), HOSTDETECT_ALLOW_ALL);
+            if(!CHECK_EQ(ifMode, sig.ifMode))
+                fprintf(stderr, "  %s, window x%u/%u\n", sig.name, factor[0], factor[1]);
+        }
+    }
+}
+
+// A host whose type is not permitted is not reported as that type.
+TEST_CASE(classifyHonoursAllowedMask)
+{
+    // Locals.
+    //
+    uint32_t                            ifMode;
+
+    for(const t_signature &sig : signatures)
+    {
+        CHECK_EQ(HostDetect::classify(measure(sig, HOSTDETECT_WINDOW_US, HOSTDETECT_CTRL_WINDOW_US), 0), 0U);
+        if(sig.allowBit == 0)
+            continue;
+        ifMode = HostDetect::classify(measure(sig, HOSTDETECT_WINDOW_US, HOSTDETECT_CTRL_WINDOW_US), sig.allowBit);
+        CHECK_EQ(ifMode, sig.ifMode);
+        ifMode = HostDetect::classify(measure(sig, HOSTDETECT_WINDOW_US, HOSTDETECT_CTRL_WINDOW_US), HOSTDETECT_ALLOW_ALL & ~sig.allowBit);
+        CHECK(ifMode != sig.ifMode);
+        CHECK(HostDetect::isAllowed(sig.ifMode, sig.allowBit));
+        CHECK(!HostDetect::isAllowed(sig.ifMode, HOSTDETECT_ALLOW_ALL & ~sig.allowBit));
+    }
+    CHECK(!HostDetect::isAllowed(0, HOSTDETECT_ALLOW_ALL));
+}
+
+// The rate thresholds sit between the signatures, edge counts either side of them and an empty window.
+TEST_CASE(rateThresholds)
+{
+    // Locals.
+    //
+    HostDetect::t_hostSignals           signals;
+
+    memset(&signals, 0, sizeof(signals));
+    CHECK(!HostDetect::isMatrixHost(signals));
+    CHECK(!HostDetect::isCtrlActive(signals));
+    signals.mpxEdges = 100;
+    CHECK(!HostDetect::isMatrixHost(signals));
+
+    signals.windowUs = 5000;
+    signals.mpxEdges = 4;
+    CHECK(!HostDetect::isMatrixHost(signals));
+    signals.mpxEdges = 5;
+    CHECK(HostDetect::isMatrixHost(signals));
+
+    // One edge in the nominal control window is the most an idle line may show, the same edge over a shorter window is a pulse train.
+    signals.ctrlWindowUs = HOSTDETECT_CTRL_WINDOW_US;
+    signals.ctrlEdges    = 1;
+    CHECK(!HostDetect::isCtrlActive(signals));
+    signals.ctrlEdges    = 2;
+    CHECK(HostDetect::isCtrlActive(signals));
+    signals.ctrlWindowUs = HOSTDETECT_CTRL_WINDOW_US * 4;
+    CHECK(!HostDetect::isCtrlActive(signals));
+    signals.ctrlWindowUs = HOSTDETECT_CTRL_WINDOW_US / 2;
+    signals.ctrlEdges    = 1;
+    CHECK(HostDetect::isCtrlActive(signals));
+}
+
+// The KDB0 count gives the same host as the full window for every phase of the edges and any cached host, so a wrong cache is
+// always caught. It ends at the full window, or earlier once the line is active or a cached X68000 sees a quiet probe.
+TEST_CASE(ctrlCountConfirmsCache)
+{
+    // Locals.
+    //
+    const uint32_t                      cached[] = { 0, 68000, 2 };
+    HostDetect::t_hostSignals           signals;
+    uint32_t                            longest;
+    uint32_t                            periodUs;
+    uint32_t                            ifMode;
+
+    for(const t_signature &sig : signatures)
+    {
+        if(HostDetect::isMatrixHost(measure(sig, HOSTDETECT_WINDOW_US, 0)) || sig.x1Loopback)
+            continue;
+        for(uint32_t cachedIfMode : cached)
+        {
+            longest  = 0;
+            periodUs = sig.ctrlPerSec == 0 ? 1 : 1000000 / sig.ctrlPerSec;
+            for(uint32_t phaseUs = 0; phaseUs < periodUs; phaseUs += 500)
+            {
+                signals = countCtrl(sig, phaseUs, cachedIfMode);
+                ifMode  = HostDetect::classify(signals, HOSTDETECT_ALLOW_ALL);
+                if(!CHECK_EQ(ifMode, sig.ifMode))
+                    fprintf(stderr, "  %s, cached %u, phase %uus\n", sig.name, cachedIfMode, phaseUs);
+                CHECK(signals.ctrlWindowUs <= HOSTDETECT_CTRL_WINDOW_US);
+                longest = signals.ctrlWindowUs > longest ? signals.ctrlWindowUs : longest;
+            }
+            printf("  %-20s cached %-5u KDB0 count ends by %uus\n", sig.name, cachedIfMode, longest);
+
+            // A quiet X68000 line is confirmed in the probe window when cached, only the full window confirms it otherwise.
+            if(sig.ctrlPerSec == 0)
+                CHECK_EQ(longest, (uint32_t)(cachedIfMode == 68000 ? HOSTDETECT_PROBE_WINDOW_US : HOSTDETECT_CTRL_WINDOW_US));
+            // An MSCTRL line decides itself within two of its periods, cached or not.
+            if(sig.ifMode == 2)
+                CHECK(longest <= HOSTDETECT_WINDOW_US + 2 * 1000000 / sig.ctrlPerSec + 1000);
+        }
+    }
+}
+
+TEST_MAIN()
@@ -0,0 +1,173 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            HostHarness.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Common bring up for the interface tests. Creates the LED, NVS, SWITCH and HID objects
+//                  in the order app_main does, with no PS/2 keyboard attached so HID falls back to
+//                  Bluetooth, and provides a stand-in Bluetooth keyboard to type on and checks of the key
+//                  latency recorded along the way.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//                  Oct 2026 - Key latency histogram checks.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HOSTHARNESS_H
+#define HOSTHARNESS_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+#include "NVS.h"
+#include "LED.h"
+#include "SWITCH.h"
+#include "HID.h"
+#include "TimerService.h"
+#include "Metrics.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace HostHarness
+{
+    struct t_host
+    {
+        NVS                             nvs;
+        LED                            *led;
+        SWITCH                         *sw;
+        HID                            *hid;
+        std::string                     fsPath;
+        esp_hidh_dev_t                 *keyboard;
+    };
+
+    // The shared objects, created on first use. HID allows one instance with hardware so every test in a process uses the same set.
+    inline t_host &host(void)
+    {
+        // Locals.
+        //
+        static t_host                  *instance = NULL;
+        const uint8_t                   bda[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x01 };
+        char                            fsTemplate[] = "/tmp/sharpkeyXXXXXX";
+
+        if(instance == NULL)
+        {
+            instance = new t_host;
+            instance->fsPath = mkdtemp(fsTemplate);
+            instance->led    = new LED(CONFIG_PWRLED);
+            TimerService::getInstance();
+            instance->nvs.init();
+            instance->nvs.open("SharpKey");
+            instance->sw     = new SWITCH(instance->led);
+            instance->hid    = new HID(HID::HID_DEVICE_TYPE_KEYBOARD, &instance->nvs, instance->led, instance->sw);
+            instance->keyboard = Shim::hidhCreateDevice(bda, ESP_HID_TRANSPORT_BT, ESP_HID_USAGE_KEYBOARD, "Keyboard");
+            Shim::hidhOpen(instance->keyboard);
+        }
+        return(*instance);
+    }
+
+    // Send a boot keyboard report from the stand-in keyboard holding the given modifier byte and scan codes.
+    inline void keyReport(uint8_t modifiers, const std::set<uint8_t> &keys)
+    {
+        // Locals.
+        //
+        uint8_t                         report[MAX_KEYBOARD_DATA_BYTES];
+        int                             idx = 2;
+
+        memset(report, 0x00, sizeof(report));
+        report[0] = modifiers;
+        for(uint8_t key : keys)
+            report[idx++] = key;
+        Shim::hidhInput(host().keyboard, ESP_HID_USAGE_KEYBOARD, 1, report, sizeof(report));
+    }
+
+    // Press and release a key, holding it long enough for the HID thread to see both states.
+    inline void tapKey(uint8_t btKey, uint8_t modifiers = 0x00, uint32_t holdMs = 20)
+    {
+        keyReport(modifiers, { btKey });
+        Shim::settle(holdMs);
+        keyReport(0x00, {});
+        Shim::settle(holdMs);
+    }
+
+    // The live key latency histograms from the metrics JSON, in Metrics::HISTOGRAM order.
+    typedef std::vector<std::vector<uint32_t>> t_latency;
+    inline t_latency latency(void)
+    {
+        // Locals.
+        //
+        const char                     *names[Metrics::HIST_MAX] = { "input", "keymap", "queue", "output", "total" };
+        std::string                     json = Metrics::json();
+        size_t                          live = json.find("\"live\":");
+        t_latency                       histograms(Metrics::HIST_MAX);
+        const char                     *pos;
+
+        for(int idx = 0; idx < Metrics::HIST_MAX; idx++)
+        {
+            pos = json.c_str() + json.find(std::string("\"") + names[idx] + "\":[", live) + strlen(names[idx]) + 3;
+            for(int bkt = 0; bkt < METRICS_HIST_BUCKETS; bkt++)
+                histograms[idx].push_back((uint32_t)strtoul(pos + 1, (char **)&pos, 10));
+        }
+        return(histograms);
+    }
+
+    // Check the key latency recorded since the given reading. Each key read is timed through input and keymap, each host code queued through
+    // the queue and each sent through output, a key is timed end to end once it is delivered. Repeats have no device event so are left out of
+    // the total. A key takes at least as long end to end as any one of its stages, so the total has nothing in a bucket below the lowest of
+    // any stage.
+    inline bool latencyRecorded(const t_latency &before, uint32_t keysRead, uint32_t codesQueued, uint32_t codesSent, uint32_t keysDelivered)
+    {
+        // Locals.
+        //
+        t_latency                       after = latency();
+        uint32_t                        count[Metrics::HIST_MAX] = { 0 };
+        int                             lowest[Metrics::HIST_MAX];
+        bool                            ok = true;
+
+        for(int idx = 0; idx < Metrics::HIST_MAX; idx++)
+        {
+            lowest[idx] = METRICS_HIST_BUCKETS;
+            for(int bkt = METRICS_HIST_BUCKETS - 1; bkt >= 0; bkt--)
+            {
+                count[idx] += after[idx][bkt] - before[idx][bkt];
+                if(after[idx][bkt] != before[idx][bkt])
+                    lowest[idx] = bkt;
+            }
+        }
+        ok &= CHECK_EQ(count[Metrics::HIST_INPUT],  keysRead);
+        ok &= CHECK_EQ(count[Metrics::HIST_KEYMAP], keysRead);
+        ok &= CHECK_EQ(count[Metrics::HIST_QUEUE],  codesQueued);
+        ok &= CHECK_EQ(count[Metrics::HIST_OUTPUT], codesSent);
+        ok &= CHECK_EQ(count[Metrics::HIST_TOTAL],  keysDelivered);
+        for(int idx = 0; idx < Metrics::HIST_TOTAL; idx++)
+            ok &= CHECK(lowest[Metrics::HIST_TOTAL] >= lowest[idx]);
+        return(ok);
+    }
+
+    // As above, every key read delivered to the host in the given number of host codes.
+    inline bool latencyRecorded(const t_latency &before, uint32_t keysRead, uint32_t hostCodes)
+    {
+        return(latencyRecorded(before, keysRead, hostCodes, hostCodes, keysRead));
+    }
+}
+
+#endif // HOSTHARNESS_H
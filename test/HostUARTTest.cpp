@@ -0,0 +1,279 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            HostUARTTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the host UART transport. The UART is a pty, the test plays the host on its
+//                  far side and the interface thread on this side, checking keys and host data each wake
+//                  the thread blocked on the queue set as soon as they arrive.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "HostUART.h"
+#include "Metrics.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    #define XMIT_QUEUE_SIZE             10
+    #define SMALL_BUFFER_SIZE           16
+
+    // A transport as an interface sets it up, keys are 32 bit mapped key codes.
+    struct t_transport
+    {
+        uart_port_t                     port;
+        QueueHandle_t                   xmitQueue;
+        HostUART                        uart;
+    };
+
+    t_transport &transport(uart_port_t port = UART_NUM_1, int bufferSize = 256)
+    {
+        // Locals.
+        //
+        static t_transport             *instance[UART_NUM_MAX] = { NULL };
+        uart_config_t                   config;
+
+        if(instance[port] == NULL)
+        {
+            memset(&config, 0x00, sizeof(config));
+            config.baud_rate = 2400;
+            config.data_bits = UART_DATA_8_BITS;
+            instance[port] = new t_transport;
+            instance[port]->port      = port;
+            instance[port]->xmitQueue = xQueueCreate(XMIT_QUEUE_SIZE, sizeof(uint32_t));
+            CHECK(instance[port]->uart.init(port, &config, 1, 3, bufferSize, 10, instance[port]->xmitQueue, XMIT_QUEUE_SIZE));
+        }
+        return(*instance[port]);
+    }
+
+    // Bytes the host has received, waiting up to the given time for the first and then until the line is quiet.
+    std::vector<uint8_t> hostRead(uart_port_t port, int waitMs = 500)
+    {
+        // Locals.
+        //
+        struct pollfd                   pfd = { Shim::uartHostFd(port), POLLIN, 0 };
+        std::vector<uint8_t>            bytes;
+        uint8_t                         buf[64];
+        ssize_t                         rcvCnt;
+
+        while(poll(&pfd, 1, bytes.empty() ? waitMs : 20) > 0 && (rcvCnt = read(pfd.fd, buf, sizeof(buf))) > 0)
+            bytes.insert(bytes.end(), buf, buf + rcvCnt);
+        return(bytes);
+    }
+
+    void hostWrite(uart_port_t port, const std::vector<uint8_t> &bytes)
+    {
+        CHECK_EQ(write(Shim::uartHostFd(port), bytes.data(), bytes.size()), (ssize_t)bytes.size());
+    }
+
+    double msSince(std::chrono::steady_clock::time_point start)
+    {
+        return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // The live counter of host receive overflows.
+    uint32_t rxOverflows(void)
+    {
+        // Locals.
+        //
+        std::string                     json = Metrics::json();
+        size_t                          pos = json.find("\"uartRxOverflow\":");
+
+        return(pos == std::string::npos ? 0xFFFFFFFF : (uint32_t)strtoul(json.c_str() + pos + 17, NULL, 10));
+    }
+}
+
+// A key pushed whilst the interface thread is blocked wakes it at once, the key is then read from the transmit queue.
+TEST_CASE(keyWakesWait)
+{
+    // Locals.
+    //
+    t_transport                        &tp = transport();
+    HostUART::HOSTUART_EVENT            event;
+    uint32_t                            key = 0x00000042;
+    std::chrono::steady_clock::time_point start;
+    double                              wakeMs;
+    std::thread                         hid([&](void) { usleep(50000); start = std::chrono::steady_clock::now(); xQueueSend(tp.xmitQueue, &key, 0); });
+
+    event  = tp.uart.wait(pdMS_TO_TICKS(2000));
+    wakeMs = msSince(start);
+    hid.join();
+    CHECK_EQ(event, HostUART::HOSTUART_EVENT_XMIT);
+    CHECK(wakeMs < 20.0);
+    key = 0;
+    CHECK(xQueueReceive(tp.xmitQueue, &key, 0) == pdTRUE);
+    CHECK_EQ(key, 0x00000042u);
+
+    // Each queued key is signalled once.
+    for(uint32_t idx=1; idx <= 3; idx++)
+        xQueueSend(tp.xmitQueue, &idx, 0);
+    for(uint32_t idx=1; idx <= 3; idx++)
+    {
+        CHECK_EQ(tp.uart.wait(0), HostUART::HOSTUART_EVENT_XMIT);
+        CHECK(xQueueReceive(tp.xmitQueue, &key, 0) == pdTRUE && key == idx);
+    }
+    CHECK_EQ(tp.uart.wait(0), HostUART::HOSTUART_EVENT_NONE);
+}
+
+// Host data arriving whilst the interface thread is blocked wakes it at once and can be read without blocking.
+TEST_CASE(hostDataWakesWait)
+{
+    // Locals.
+    //
+    t_transport                        &tp = transport();
+    HostUART::HOSTUART_EVENT            event;
+    std::chrono::steady_clock::time_point start;
+    double                              wakeMs;
+    uint8_t                             buf[16];
+    std::thread                         host([&](void) { usleep(50000); start = std::chrono::steady_clock::now(); hostWrite(tp.port, { 0x41, 0x5B }); });
+
+    event  = tp.uart.wait(pdMS_TO_TICKS(2000));
+    wakeMs = msSince(start);
+    host.join();
+    CHECK_EQ(event, HostUART::HOSTUART_EVENT_RCV);
+    CHECK(wakeMs < 20.0);
+    usleep(10000);
+    while(tp.uart.wait(0) == HostUART::HOSTUART_EVENT_RCV);
+    CHECK_EQ(tp.uart.readData(buf, sizeof(buf)), 2);
+    CHECK(buf[0] == 0x41 && buf[1] == 0x5B);
+    CHECK_EQ(tp.uart.readData(buf, sizeof(buf)), 0);
+}
+
+// With nothing to do the wait times out, it bounds the response of the thread to a suspend request.
+TEST_CASE(idleWaitTimesOut)
+{
+    // Locals.
+    //
+    t_transport                        &tp = transport();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    CHECK_EQ(tp.uart.wait(pdMS_TO_TICKS(HOSTUART_WAIT_MS)), HostUART::HOSTUART_EVENT_NONE);
+    CHECK(msSince(start) >= HOSTUART_WAIT_MS - 5);
+}
+
+// A key is sent most significant byte first without its leading zero bytes, a zero key sends nothing.
+TEST_CASE(writeKeyMSBFirst)
+{
+    // Locals.
+    //
+    t_transport                        &tp = transport();
+
+    tp.uart.writeKey(0x00000042);
+    CHECK(hostRead(tp.port) == std::vector<uint8_t>({ 0x42 }));
+    tp.uart.writeKey(0x0000E012);
+    CHECK(hostRead(tp.port) == std::vector<uint8_t>({ 0xE0, 0x12 }));
+    tp.uart.writeKey(0x12345678);
+    CHECK(hostRead(tp.port) == std::vector<uint8_t>({ 0x12, 0x34, 0x56, 0x78 }));
+    tp.uart.writeKey(0x00000000);
+    CHECK(hostRead(tp.port, 100).empty());
+    CHECK(tp.uart.xmitIdle());
+}
+
+// A break discards the partial data before it, the host uses it as a reset on the receive line.
+TEST_CASE(breakDiscardsInput)
+{
+    // Locals.
+    //
+    t_transport                        &tp = transport();
+    uint8_t                             buf[16];
+
+    hostWrite(tp.port, { 0x01, 0x02, 0x03 });
+    CHECK_EQ(tp.uart.wait(pdMS_TO_TICKS(500)), HostUART::HOSTUART_EVENT_RCV);
+    Shim::uartBreak(tp.port);
+    while(tp.uart.wait(pdMS_TO_TICKS(100)) == HostUART::HOSTUART_EVENT_RCV);
+    CHECK_EQ(tp.uart.readData(buf, sizeof(buf)), 0);
+
+    // The line recovers, following data is delivered.
+    hostWrite(tp.port, { 0x04 });
+    CHECK_EQ(tp.uart.wait(pdMS_TO_TICKS(500)), HostUART::HOSTUART_EVENT_RCV);
+    CHECK_EQ(tp.uart.readData(buf, sizeof(buf)), 1);
+    CHECK_EQ(buf[0], 0x04);
+}
+
+// Host data which overflows the receive buffer is discarded and counted, the transport carries on.
+TEST_CASE(overflowDiscardedAndCounted)
+{
+    // Locals.
+    //
+    t_transport                        &tp = transport(UART_NUM_2, SMALL_BUFFER_SIZE);
+    uint32_t                            overflows = rxOverflows();
+    std::vector<uint8_t>                burst(SMALL_BUFFER_SIZE * 4, 0x55);
+    uint8_t                             buf[SMALL_BUFFER_SIZE * 4];
+    int                                 rcvCnt;
+
+    hostWrite(tp.port, burst);
+    usleep(50000);
+    while(tp.uart.wait(pdMS_TO_TICKS(50)) != HostUART::HOSTUART_EVENT_NONE);
+    CHECK(rxOverflows() > overflows);
+    CHECK(tp.uart.readData(buf, sizeof(buf)) < SMALL_BUFFER_SIZE * 4);
+
+    hostWrite(tp.port, { 0x0A });
+    CHECK_EQ(tp.uart.wait(pdMS_TO_TICKS(500)), HostUART::HOSTUART_EVENT_RCV);
+    while(tp.uart.wait(0) != HostUART::HOSTUART_EVENT_NONE);
+    rcvCnt = tp.uart.readData(buf, sizeof(buf));
+    CHECK(rcvCnt >= 1 && buf[rcvCnt - 1] == 0x0A);
+}
+
+// A key and a host byte at a time, the time from each arriving to the blocked thread waking, against the 50ms poll of the old transport.
+TEST_CASE(wakeLatency)
+{
+    // Locals.
+    //
+    t_transport                        &tp = transport();
+    std::vector<double>                 keyMs;
+    std::vector<double>                 hostMs;
+    std::chrono::steady_clock::time_point start;
+    uint32_t                            key;
+    uint8_t                             buf[16];
+
+    for(int idx=0; idx < 100; idx++)
+    {
+        std::thread hid([&](void) { usleep(2000); key = 0x10 + idx; start = std::chrono::steady_clock::now(); xQueueSend(tp.xmitQueue, &key, 0); });
+        CHECK_EQ(tp.uart.wait(pdMS_TO_TICKS(1000)), HostUART::HOSTUART_EVENT_XMIT);
+        keyMs.push_back(msSince(start));
+        hid.join();
+        xQueueReceive(tp.xmitQueue, &key, 0);
+
+        std::thread host([&](void) { usleep(2000); start = std::chrono::steady_clock::now(); hostWrite(tp.port, { (uint8_t)idx }); });
+        CHECK_EQ(tp.uart.wait(pdMS_TO_TICKS(1000)), HostUART::HOSTUART_EVENT_RCV);
+        hostMs.push_back(msSince(start));
+        host.join();
+        tp.uart.readData(buf, sizeof(buf));
+    }
+    std::sort(keyMs.begin(), keyMs.end());
+    std::sort(hostMs.begin(), hostMs.end());
+    printf("[ BENCH    ] key wake    median %.3f ms, max %.3f ms\n", keyMs[keyMs.size() / 2], keyMs.back());
+    printf("[ BENCH    ] host wake   median %.3f ms, max %.3f ms\n", hostMs[hostMs.size() / 2], hostMs.back());
+    CHECK(keyMs[keyMs.size() / 2] < 5.0);
+    CHECK(hostMs[hostMs.size() / 2] < 5.0);
+}
+
+TEST_MAIN()
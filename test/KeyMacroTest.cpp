@@ -0,0 +1,293 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMacroTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of keystroke macro pacing and of the characters a macro types on each host.
+//                  Every printable character is reverse mapped through the built in keymap of each
+//                  interface, played through mapKey and decoded from the host output with the host
+//                  key legends.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include "KeyMacro.h"
+#include "X1.h"
+#include "X68K.h"
+#include "PC9801.h"
+#include "MZ2528.h"
+#include "MZ5665.h"
+#include "HostHarness.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // Characters every host must be able to type from its built in keymap.
+    const char                         *coreChars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ,./;-";
+
+    // X68000 key legends by key code, unshifted and shifted. The PC-9801 uses the same JIS layout one code lower.
+    const char                          jisUnshifted[] = "\0\x1b" "1234567890-^\\\b\tqwertyuiop@[\rasdfghjkl;:]zxcvbnm,./_ ";
+    const char                          jisShifted[]   = "\0\x1b" "!\"#$%&'()\0=~|\b\tQWERTYUIOP`{\rASDFGHJKL+*}ZXCVBNM<>?_ ";
+
+    // MZ-2500 matrix legends for rows 3 to 10, eight column bits per row.
+    const char                          mzUnshifted[] = "\t \r\0\0\0\0\0" "/ABCDEFG" "HIJKLMNO" "PQRSTUVW" "XYZ^\\_.," "01234567" "89:;-@[\0" "]\0\0\0\b\x1b\0\0";
+    const char                          mzShifted[]   = "\t \r\0\0\0\0\0" "?abcdefg" "hijklmno" "pqrstuvw" "xyz\0|\0><" "\0!\"#$%&'" "()*+=`{\0" "}\0\0\0\b\x1b\0\0";
+
+    // Character the host sees for a macro key, -1 if none and -2 if more than one.
+    typedef int t_decode(KeyInterface &ki, uint16_t keyCode);
+
+    // ASCII hosts, the character is the low byte mapped for the key make.
+    int decodeAscii(KeyInterface &ki, uint16_t keyCode)
+    {
+        // Locals.
+        //
+        uint16_t                        events[KEYMACRO_MAX_EVENTS];
+        int                             eventCnt = KeyMacro::strokeEvents(keyCode, events);
+        uint32_t                        mapped;
+        int                             chr = -1;
+
+        for(int idx = 0; idx < eventCnt; idx++)
+        {
+            mapped = ki.mapKey(events[idx]);
+            if(idx == (eventCnt / 2) - 1)
+                chr = (int)(mapped & 0xFF);
+        }
+        return(chr);
+    }
+
+    // Key code hosts, codes are sent MSB first with bit 7 set on a break and SHIFT (0x70) tracked as the host would.
+    int decodeKeyCodes(KeyInterface &ki, uint16_t keyCode, int codeOffset)
+    {
+        // Locals.
+        //
+        uint16_t                        events[KEYMACRO_MAX_EVENTS];
+        int                             eventCnt = KeyMacro::strokeEvents(keyCode, events);
+        uint32_t                        mapped;
+        uint8_t                         code;
+        bool                            shift = false;
+        int                             chr = -1;
+
+        for(int idx = 0; idx < eventCnt; idx++)
+        {
+            mapped = ki.mapKey(events[idx]);
+            for(int byteNo = 3; byteNo >= 0; byteNo--)
+            {
+                code = (mapped >> (byteNo * 8)) & 0xFF;
+                if(code == 0x00 && (mapped >> (byteNo * 8)) == 0)
+                    continue;
+                if((code & 0x7F) == 0x70)
+                    shift = (code & 0x80) == 0;
+                else if((code & 0x80) == 0)
+                {
+                    if(chr != -1 || code + codeOffset >= (int)sizeof(jisUnshifted) - 1)
+                        return(-2);
+                    chr = (uint8_t)(shift ? jisShifted : jisUnshifted)[code + codeOffset];
+                }
+            }
+        }
+        return(shift ? -2 : chr);
+    }
+
+    int decodeX68K(KeyInterface &ki, uint16_t keyCode)
+    {
+        return(decodeKeyCodes(ki, keyCode, 0));
+    }
+
+    int decodePC9801(KeyInterface &ki, uint16_t keyCode)
+    {
+        return(decodeKeyCodes(ki, keyCode, 1));
+    }
+
+    // Matrix host, the character is the one key pressed in the matrix after the key make, shifted if SHIFT (row 11 bit 2) is pressed.
+    int decodeMZ2528(KeyInterface &ki, uint16_t keyCode)
+    {
+        // Locals.
+        //
+        MZ2528                         &mz = static_cast<MZ2528 &>(ki);
+        uint16_t                        events[KEYMACRO_MAX_EVENTS];
+        int                             eventCnt = KeyMacro::strokeEvents(keyCode, events);
+        int                             chr = -1;
+
+        for(int idx = 0; idx < eventCnt; idx++)
+        {
+            ki.mapKey(events[idx]);
+            if(idx != (eventCnt / 2) - 1)
+                continue;
+            for(int row = 0x03; row <= 0x0A; row++)
+            {
+                for(int bit = 0; bit < 8; bit++)
+                {
+                    if((mz.matrixRow(row) & (1 << bit)) != 0)
+                        continue;
+                    if(chr != -1)
+                        return(-2);
+                    chr = (uint8_t)((mz.matrixRow(0x0B) & 0x04) == 0 ? mzShifted : mzUnshifted)[((row - 0x03) * 8) + bit];
+                }
+            }
+        }
+
+        // Every key must be released once the stroke is played.
+        for(int row = 0x00; row <= 0x0F; row++)
+        {
+            if(mz.matrixRow(row) != 0xFF)
+                return(-2);
+        }
+        return(chr);
+    }
+
+    // Type every printable character through an interface and check the host sees it. Characters the keymap cannot type are listed.
+    void roundTrip(const char *name, KeyInterface &ki, t_decode *decode)
+    {
+        // Locals.
+        //
+        std::string                     skipped;
+        uint16_t                        keyCode;
+        int                             typed = 0;
+
+        ki.led = HostHarness::host().led;
+        for(int chr = 0x20; chr < 0x7F; chr++)
+        {
+            if(ki.macroKey((char)chr, keyCode) == false)
+            {
+                skipped += (char)chr;
+                continue;
+            }
+            if(!CHECK_EQ(decode(ki, keyCode), chr))
+                fprintf(stderr, "%s: '%c' typed with key %04x\n", name, chr, keyCode);
+            typed++;
+        }
+        for(const char *core = coreChars; *core != 0x00; core++)
+        {
+            if(!CHECK(skipped.find(*core) == std::string::npos))
+                fprintf(stderr, "%s: '%c' cannot be typed\n", name, *core);
+        }
+        printf("%s: %d characters typed, not typeable: \"%s\"\n", name, typed, skipped.c_str());
+    }
+}
+
+TEST_CASE(paceAdaptive)
+{
+    // Locals.
+    //
+    KeyMacro::t_pace                    pace;
+
+    KeyMacro::paceStart(pace, true);
+    CHECK_EQ(pace.gapMs, (uint32_t)KEYMACRO_GAP_START_MS);
+    for(int idx = 0; idx < 100; idx++)
+        KeyMacro::paceAccepted(pace);
+    CHECK_EQ(pace.gapMs, (uint32_t)KEYMACRO_GAP_MIN_MS);
+    KeyMacro::paceRejected(pace);
+    CHECK_EQ(pace.gapMs, (uint32_t)KEYMACRO_GAP_MIN_MS * 2 + KEYMACRO_GAP_STEP_MS);
+    for(int idx = 0; idx < 20; idx++)
+        KeyMacro::paceRejected(pace);
+    CHECK_EQ(pace.gapMs, (uint32_t)KEYMACRO_GAP_MAX_MS);
+    CHECK_EQ(pace.accepted, (uint32_t)100);
+    CHECK_EQ(pace.rejected, (uint32_t)21);
+}
+
+TEST_CASE(paceFixed)
+{
+    // Locals.
+    //
+    KeyMacro::t_pace                    pace;
+
+    KeyMacro::paceStart(pace, false);
+    CHECK_EQ(pace.gapMs, (uint32_t)KEYMACRO_GAP_FIXED_MS);
+    for(int idx = 0; idx < 100; idx++)
+        KeyMacro::paceAccepted(pace);
+    CHECK_EQ(pace.gapMs, (uint32_t)KEYMACRO_GAP_FIXED_MS);
+    KeyMacro::paceRejected(pace);
+    CHECK_EQ(pace.gapMs, (uint32_t)KEYMACRO_GAP_FIXED_MS);
+    CHECK_EQ(pace.accepted, (uint32_t)100);
+    CHECK_EQ(pace.rejected, (uint32_t)1);
+}
+
+TEST_CASE(hostRejectsAdaptPace)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X1                                  x1(&host.nvs, host.hid, host.fsPath.c_str());
+    X68K                                x68k(&host.nvs, host.hid, host.fsPath.c_str());
+    PC9801                              pc9801(&host.nvs, host.hid, host.fsPath.c_str());
+    MZ2528                              mz2528(&host.nvs, host.hid, host.fsPath.c_str());
+    MZ5665                              mz5665(&host.nvs, host.hid, host.fsPath.c_str());
+
+    CHECK(static_cast<KeyInterface &>(x1).macroHostRejects() == false);
+    CHECK(static_cast<KeyInterface &>(x68k).macroHostRejects() == true);
+    CHECK(static_cast<KeyInterface &>(pc9801).macroHostRejects() == true);
+    CHECK(static_cast<KeyInterface &>(mz2528).macroHostRejects() == true);
+    CHECK(static_cast<KeyInterface &>(mz5665).macroHostRejects() == false);
+}
+
+TEST_CASE(roundTripX1)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X1                                  x1(&host.nvs, host.hid, host.fsPath.c_str());
+
+    roundTrip("X1", x1, decodeAscii);
+}
+
+TEST_CASE(roundTripMZ5665)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    MZ5665                              mz5665(&host.nvs, host.hid, host.fsPath.c_str());
+
+    roundTrip("MZ5665", mz5665, decodeAscii);
+}
+
+TEST_CASE(roundTripX68K)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X68K                                x68k(&host.nvs, host.hid, host.fsPath.c_str());
+
+    roundTrip("X68K", x68k, decodeX68K);
+}
+
+TEST_CASE(roundTripPC9801)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    PC9801                              pc9801(&host.nvs, host.hid, host.fsPath.c_str());
+
+    roundTrip("PC9801", pc9801, decodePC9801);
+}
+
+TEST_CASE(roundTripMZ2528)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    MZ2528                              mz2528(&host.nvs, host.hid, host.fsPath.c_str());
+
+    roundTrip("MZ2528", mz2528, decodeMZ2528);
+}
+
+TEST_MAIN()
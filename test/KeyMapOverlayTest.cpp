@@ -0,0 +1,529 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMapOverlayTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the keymap overlay. Edited keymaps are reduced to overlay edits and merged
+//                  back, through memory and through files, and compared with the edited rows. The host
+//                  keymap_overlay tool is run against the firmware load and save, and each interface's
+//                  keymap is edited to measure the heap held by the overlay against a full copy.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "KeyMapOverlay.h"
+#include "MZ2528.h"
+#include "MZ5665.h"
+#include "X1.h"
+#include "X68K.h"
+#include "PC9801.h"
+#include "HostHarness.h"
+#include "TestRunner.h"
+
+// Heap held by the test thread, the usable size of each block so a block freed counts back what it counted in.
+thread_local int64_t                    heapHeld = 0;
+
+void *operator new(size_t size)
+{
+    // Locals.
+    //
+    void                               *block = malloc(size > 0 ? size : 1);
+
+    if(block == NULL)
+        throw std::bad_alloc();
+    heapHeld += malloc_usable_size(block);
+    return(block);
+}
+
+void *operator new[](size_t size)
+{
+    return(operator new(size));
+}
+
+void operator delete(void *block) noexcept
+{
+    if(block != NULL)
+        heapHeld -= malloc_usable_size(block);
+    free(block);
+}
+
+void operator delete[](void *block) noexcept
+{
+    operator delete(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+    operator delete(block);
+}
+
+void operator delete[](void *block, size_t) noexcept
+{
+    operator delete(block);
+}
+
+namespace
+{
+    #define ENTRY_SIZE                  6
+    #define BASE_ROWS                   131
+    #define RANDOM_KEYMAPS              2000
+    #define OVERHEAD_PER_BLOCK          24
+
+    typedef std::vector<uint8_t>        t_row;
+
+    // Inbuilt keymap with distinct rows, as the interface keymaps have.
+    std::vector<uint8_t> inbuiltKeyMap(int rows = BASE_ROWS)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            keyMap;
+
+        for(int idx = 0; idx < rows; idx++)
+        {
+            const uint8_t               row[ENTRY_SIZE] = { (uint8_t)idx, (uint8_t)(idx >> 8), 0x11, 0x22, (uint8_t)(idx * 7), 0x33 };
+            keyMap.insert(keyMap.end(), row, row + ENTRY_SIZE);
+        }
+        return(keyMap);
+    }
+
+    std::vector<t_row> splitRows(const std::vector<uint8_t> &keyMap)
+    {
+        // Locals.
+        //
+        std::vector<t_row>              rows;
+
+        for(size_t pos = 0; pos < keyMap.size(); pos += ENTRY_SIZE)
+            rows.push_back(t_row(keyMap.begin() + pos, keyMap.begin() + pos + ENTRY_SIZE));
+        return(rows);
+    }
+
+    std::vector<const uint8_t *> rowPointers(const std::vector<t_row> &rows)
+    {
+        // Locals.
+        //
+        std::vector<const uint8_t *>    pointers;
+
+        for(const t_row &row : rows)
+            pointers.push_back(row.data());
+        return(pointers);
+    }
+
+    // A user row, not present in the inbuilt keymap.
+    t_row userRow(uint32_t seq)
+    {
+        return(t_row({ (uint8_t)seq, (uint8_t)(seq >> 8), 0xEE, (uint8_t)(seq >> 16), 0x55, 0xAA }));
+    }
+
+    // The rows of a merged keymap in the order mapKey sees them.
+    std::vector<t_row> mergedRows(const KeyMapOverlay::t_overlayMap &map, const std::vector<uint8_t> &base)
+    {
+        // Locals.
+        //
+        std::vector<t_row>              rows;
+        int                             baseRows = base.size() / ENTRY_SIZE;
+        const uint8_t                  *row;
+
+        for(int idx = 0; idx < map.rows; idx++)
+        {
+            row = (map.index == NULL ? &base[idx * ENTRY_SIZE] :
+                   (map.index[idx] < baseRows ? &base[map.index[idx] * ENTRY_SIZE] : &map.overlay[(map.index[idx] - baseRows) * ENTRY_SIZE]));
+            rows.push_back(t_row(row, row + ENTRY_SIZE));
+        }
+        return(rows);
+    }
+
+    void freeMap(KeyMapOverlay::t_overlayMap &map)
+    {
+        delete [] map.index;
+        delete [] map.overlay;
+        map.index   = NULL;
+        map.overlay = NULL;
+    }
+
+    // Reduce the rows to overlay edits then merge them with the inbuilt keymap, returning the merged rows.
+    std::vector<t_row> roundTrip(const std::vector<t_row> &rows, const std::vector<uint8_t> &base, std::vector<KeyMapOverlay::t_overlayRecord> &records)
+    {
+        // Locals.
+        //
+        std::vector<const uint8_t *>    entries;
+        KeyMapOverlay::t_overlayMap     map;
+        std::vector<t_row>              merged;
+
+        KeyMapOverlay::diff(rowPointers(rows), base.data(), base.size() / ENTRY_SIZE, ENTRY_SIZE, records, entries);
+        if(KeyMapOverlay::merge(records, entries, base.size() / ENTRY_SIZE, ENTRY_SIZE, map) == false)
+            return(merged);
+        if(map.overlayRows != (int)entries.size() || map.rows != (int)rows.size())
+            return(merged);
+        merged = mergedRows(map, base);
+        freeMap(map);
+        return(merged);
+    }
+
+    std::string tempFile(const char *name)
+    {
+        return(HostHarness::host().fsPath + "/" + name);
+    }
+
+    bool writeFile(const std::string &fileName, const std::vector<uint8_t> &data)
+    {
+        // Locals.
+        //
+        std::ofstream                   fileOut(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+        fileOut.write((const char *)data.data(), data.size());
+        return(fileOut.good());
+    }
+
+    std::vector<uint8_t> readFile(const std::string &fileName)
+    {
+        // Locals.
+        //
+        std::ifstream                   fileIn(fileName.c_str(), std::ios::in | std::ios::binary);
+
+        return(std::vector<uint8_t>(std::istreambuf_iterator<char>(fileIn), std::istreambuf_iterator<char>()));
+    }
+
+    std::vector<uint8_t> joinRows(const std::vector<t_row> &rows)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            data;
+
+        for(const t_row &row : rows)
+            data.insert(data.end(), row.begin(), row.end());
+        return(data);
+    }
+
+    bool recordIs(const KeyMapOverlay::t_overlayRecord &record, uint16_t baseRow, enum KeyMapOverlay::OVERLAY_OP op)
+    {
+        return(record.baseRow == baseRow && record.op == op);
+    }
+
+    // Edit an interface keymap as a user would, changing a row, removing a row and adding a row, and return the heap the keymap then holds.
+    template <typename T> void measureHeap(const char *name)
+    {
+        // Locals.
+        //
+        HostHarness::t_host            &host = HostHarness::host();
+        std::string                     fileName;
+        KeyMapOverlay::t_overlayHeader  header;
+        std::vector<uint8_t>            overlay;
+        int64_t                         heldBefore;
+        int64_t                         held;
+        int64_t                         expected;
+        int                             fullCopy;
+        int                             rows;
+
+        // The entry size is private to the interface, a delete needs no entry and the overlay written for it records the size.
+        {
+            T                           probe(&host.nvs, host.hid, host.fsPath.c_str());
+
+            fileName = host.fsPath + "/" + probe.getKeyMapFileName();
+            remove(fileName.c_str());
+            CHECK(probe.editKeyMap({ { KeyMapOverlay::OVERLAY_DELETE, 0, {} } }) > 0);
+            overlay = readFile(fileName);
+            remove(fileName.c_str());
+        }
+        if(!CHECK(overlay.size() >= sizeof(header)))
+            return;
+        memcpy(&header, overlay.data(), sizeof(header));
+        CHECK_EQ(header.magic, (uint32_t)KEYMAP_OVERLAY_MAGIC);
+
+        // Edit the inbuilt keymap, the heap held afterwards is the new keymap less the inbuilt keymap it replaced.
+        T                               ki(&host.nvs, host.hid, host.fsPath.c_str());
+
+        heldBefore = heapHeld;
+        rows = ki.editKeyMap({ { KeyMapOverlay::OVERLAY_REPLACE, 1,  std::vector<uint8_t>(header.entrySize, 0xEE) },
+                               { KeyMapOverlay::OVERLAY_DELETE,  10, {} },
+                               { KeyMapOverlay::OVERLAY_INSERT,  20, std::vector<uint8_t>(header.entrySize, 0xDD) } });
+        held     = heapHeld - heldBefore;
+        expected = rows * sizeof(uint16_t) + 2 * header.entrySize;
+        fullCopy = rows * header.entrySize;
+        CHECK_EQ(rows, (int)header.baseRows);
+        CHECK(held >= expected && held <= expected + 2 * OVERHEAD_PER_BLOCK);
+        CHECK(held < fullCopy);
+        printf("[ HEAP     ] %-8s %3d rows of %2d bytes, overlay holds %5lld bytes, a full copy %5d bytes, %5lld bytes saved\n",
+               name, rows, header.entrySize, (long long)held, fullCopy, (long long)(fullCopy - held));
+        remove(fileName.c_str());
+    }
+}
+
+// The inbuilt keymap unchanged needs no edits and no heap, mapKey uses the flash table directly.
+TEST_CASE(unchangedKeyMapHoldsNothing)
+{
+    // Locals.
+    //
+    std::vector<uint8_t>                base = inbuiltKeyMap();
+    std::vector<KeyMapOverlay::t_overlayRecord> records;
+    std::vector<const uint8_t *>        entries;
+    KeyMapOverlay::t_overlayMap         map;
+
+    KeyMapOverlay::diff(rowPointers(splitRows(base)), base.data(), BASE_ROWS, ENTRY_SIZE, records, entries);
+    CHECK(records.empty());
+    CHECK(entries.empty());
+    CHECK(KeyMapOverlay::merge(records, entries, BASE_ROWS, ENTRY_SIZE, map));
+    CHECK(map.index == NULL);
+    CHECK(map.overlay == NULL);
+    CHECK_EQ(map.rows, BASE_ROWS);
+}
+
+// A single edit is recorded as that edit and nothing else, the look ahead keeping rows after an insert or delete unchanged.
+TEST_CASE(singleEditsRecordedMinimally)
+{
+    // Locals.
+    //
+    std::vector<uint8_t>                base = inbuiltKeyMap();
+    std::vector<t_row>                  rows;
+    std::vector<KeyMapOverlay::t_overlayRecord> records;
+
+    rows = splitRows(base);
+    rows[5] = userRow(1);
+    CHECK(roundTrip(rows, base, records) == rows);
+    CHECK(records.size() == 1 && recordIs(records[0], 5, KeyMapOverlay::OVERLAY_REPLACE));
+
+    rows = splitRows(base);
+    rows.erase(rows.begin() + 5);
+    CHECK(roundTrip(rows, base, records) == rows);
+    CHECK(records.size() == 1 && recordIs(records[0], 5, KeyMapOverlay::OVERLAY_DELETE));
+
+    rows = splitRows(base);
+    rows.insert(rows.begin() + 5, userRow(1));
+    CHECK(roundTrip(rows, base, records) == rows);
+    CHECK(records.size() == 1 && recordIs(records[0], 5, KeyMapOverlay::OVERLAY_INSERT));
+
+    rows = splitRows(base);
+    rows.push_back(userRow(1));
+    CHECK(roundTrip(rows, base, records) == rows);
+    CHECK(records.size() == 1 && recordIs(records[0], BASE_ROWS, KeyMapOverlay::OVERLAY_INSERT));
+
+    rows = splitRows(base);
+    rows.resize(BASE_ROWS - 3);
+    CHECK(roundTrip(rows, base, records) == rows);
+    CHECK(records.size() == 3 && recordIs(records[0], BASE_ROWS - 3, KeyMapOverlay::OVERLAY_DELETE) && recordIs(records[2], BASE_ROWS - 1, KeyMapOverlay::OVERLAY_DELETE));
+
+    rows = splitRows(base);
+    rows.insert(rows.begin() + 40, { userRow(1), userRow(2), userRow(3) });
+    CHECK(roundTrip(rows, base, records) == rows);
+    CHECK(records.size() == 3 && recordIs(records[0], 40, KeyMapOverlay::OVERLAY_INSERT) && recordIs(records[2], 40, KeyMapOverlay::OVERLAY_INSERT));
+
+    // A moved row is a delete and an insert, the rows between are unchanged.
+    rows = splitRows(base);
+    rows.insert(rows.begin() + 30, rows[20]);
+    rows.erase(rows.begin() + 20);
+    CHECK(roundTrip(rows, base, records) == rows);
+    CHECK_EQ(records.size(), 2u);
+}
+
+// Any edited keymap merges back to the edited rows, whatever mix of changes, inserts, deletes and moves the user made.
+TEST_CASE(randomEditsRoundTrip)
+{
+    // Locals.
+    //
+    std::mt19937                        rng(0x5EED0045);
+    std::vector<uint8_t>                base;
+    std::vector<t_row>                  rows;
+    std::vector<KeyMapOverlay::t_overlayRecord> records;
+    uint32_t                            seq = 0;
+    int                                 failures = 0;
+    int                                 pos;
+
+    for(int keyMap = 0; keyMap < RANDOM_KEYMAPS; keyMap++)
+    {
+        base = inbuiltKeyMap(1 + rng() % BASE_ROWS);
+        rows = splitRows(base);
+        for(int edit = rng() % 40; edit > 0; edit--)
+        {
+            pos = rows.empty() ? 0 : rng() % rows.size();
+            switch(rng() % 5)
+            {
+                case 0:  if(!rows.empty()) rows[pos] = userRow(++seq);                    break;
+                case 1:  rows.insert(rows.begin() + pos, userRow(++seq));                 break;
+                case 2:  if(!rows.empty()) rows.erase(rows.begin() + pos);                break;
+                case 3:  rows.push_back(userRow(++seq));                                  break;
+                default: if(!rows.empty()) rows.insert(rows.begin() + rng() % rows.size(), rows[pos]); break;
+            }
+        }
+        if(roundTrip(rows, base, records) != rows)
+            failures++;
+    }
+    CHECK_EQ(failures, 0);
+}
+
+// Edits out of inbuilt row order, beyond the inbuilt keymap, acting twice on a row or of an unknown kind are refused and nothing is held.
+TEST_CASE(badRecordsRefused)
+{
+    // Locals.
+    //
+    std::vector<uint8_t>                base = inbuiltKeyMap();
+    t_row                               entry = userRow(1);
+    std::vector<const uint8_t *>        entries = { entry.data(), entry.data() };
+    KeyMapOverlay::t_overlayMap         map;
+    const std::vector<std::vector<KeyMapOverlay::t_overlayRecord>> bad = {
+        { { 9, KeyMapOverlay::OVERLAY_REPLACE, 0 }, { 3, KeyMapOverlay::OVERLAY_REPLACE, 0 } },
+        { { BASE_ROWS, KeyMapOverlay::OVERLAY_REPLACE, 0 } },
+        { { BASE_ROWS + 1, KeyMapOverlay::OVERLAY_INSERT, 0 } },
+        { { 4, KeyMapOverlay::OVERLAY_REPLACE, 0 }, { 4, KeyMapOverlay::OVERLAY_DELETE, 0 } },
+        { { 4, KeyMapOverlay::OVERLAY_DELETE, 0 }, { 4, KeyMapOverlay::OVERLAY_DELETE, 0 } },
+        { { 4, 3, 0 } } };
+
+    for(const std::vector<KeyMapOverlay::t_overlayRecord> &records : bad)
+    {
+        CHECK(KeyMapOverlay::merge(records, entries, BASE_ROWS, ENTRY_SIZE, map) == false);
+        CHECK(map.index == NULL && map.overlay == NULL && map.rows == BASE_ROWS);
+    }
+
+    // An insert ahead of a change to the same row is the order diff creates.
+    CHECK(KeyMapOverlay::merge({ { 4, KeyMapOverlay::OVERLAY_INSERT, 0 }, { 4, KeyMapOverlay::OVERLAY_REPLACE, 0 } }, entries, BASE_ROWS, ENTRY_SIZE, map));
+    CHECK_EQ(map.rows, BASE_ROWS + 1);
+    freeMap(map);
+}
+
+// An overlay saved to file loads back to the same rows, the file holding only the edits.
+TEST_CASE(overlayFileRoundTrip)
+{
+    // Locals.
+    //
+    std::vector<uint8_t>                base = inbuiltKeyMap();
+    std::vector<t_row>                  rows = splitRows(base);
+    std::string                         fileName = tempFile("overlay.bin");
+    KeyMapOverlay::t_overlayMap         map;
+
+    rows[3] = userRow(1);
+    rows.erase(rows.begin() + 50);
+    rows.insert(rows.begin() + 90, userRow(2));
+    CHECK(KeyMapOverlay::save(fileName, rowPointers(rows), base.data(), BASE_ROWS, ENTRY_SIZE));
+    CHECK_EQ(readFile(fileName).size(), sizeof(KeyMapOverlay::t_overlayHeader) + 3 * (sizeof(KeyMapOverlay::t_overlayRecord) + ENTRY_SIZE));
+    CHECK_EQ(KeyMapOverlay::load(fileName, base.data(), BASE_ROWS, ENTRY_SIZE, map), KeyMapOverlay::OVERLAY_LOAD_OVERLAY);
+    CHECK(mergedRows(map, base) == rows);
+    CHECK_EQ(map.overlayRows, 2);
+    freeMap(map);
+}
+
+// A complete keymap file, as uploaded or saved by earlier firmware, loads as the same rows and is flagged to be saved back as an overlay.
+TEST_CASE(completeFileConverted)
+{
+    // Locals.
+    //
+    std::vector<uint8_t>                base = inbuiltKeyMap();
+    std::vector<t_row>                  rows = splitRows(base);
+    std::string                         fileName = tempFile("complete.bin");
+    KeyMapOverlay::t_overlayMap         map;
+
+    rows[7] = userRow(1);
+    rows.push_back(userRow(2));
+    CHECK(writeFile(fileName, joinRows(rows)));
+    CHECK_EQ(KeyMapOverlay::load(fileName, base.data(), BASE_ROWS, ENTRY_SIZE, map), KeyMapOverlay::OVERLAY_LOAD_COMPLETE);
+    CHECK(mergedRows(map, base) == rows);
+    CHECK_EQ(map.overlayRows, 2);
+    freeMap(map);
+}
+
+// A file which is missing, empty, truncated, corrupt or made against another inbuilt keymap leaves the inbuilt keymap in use.
+TEST_CASE(unusableFilesIgnored)
+{
+    // Locals.
+    //
+    std::vector<uint8_t>                base = inbuiltKeyMap();
+    std::vector<t_row>                  rows = splitRows(base);
+    std::string                         fileName = tempFile("unusable.bin");
+    std::vector<uint8_t>                overlay;
+    KeyMapOverlay::t_overlayMap         map;
+
+    auto loads = [&](const std::vector<uint8_t> &data, int baseRows, size_t entrySize)
+    {
+        writeFile(fileName, data);
+        return(KeyMapOverlay::load(fileName, base.data(), baseRows, entrySize, map) == KeyMapOverlay::OVERLAY_LOAD_INBUILT && map.index == NULL && map.rows == baseRows);
+    };
+
+    remove(fileName.c_str());
+    CHECK(KeyMapOverlay::load(fileName, base.data(), BASE_ROWS, ENTRY_SIZE, map) == KeyMapOverlay::OVERLAY_LOAD_INBUILT && map.index == NULL);
+    CHECK(loads({}, BASE_ROWS, ENTRY_SIZE));
+
+    rows[3] = userRow(1);
+    rows[9] = userRow(2);
+    CHECK(KeyMapOverlay::save(fileName, rowPointers(rows), base.data(), BASE_ROWS, ENTRY_SIZE));
+    overlay = readFile(fileName);
+    CHECK(loads(overlay, BASE_ROWS - 1, ENTRY_SIZE));
+    CHECK(loads(std::vector<uint8_t>(overlay.begin(), overlay.end() - 1), BASE_ROWS, ENTRY_SIZE));
+    overlay[sizeof(KeyMapOverlay::t_overlayHeader)] = BASE_ROWS + 1;
+    CHECK(loads(overlay, BASE_ROWS, ENTRY_SIZE));
+    overlay = joinRows(rows);
+    CHECK(loads(std::vector<uint8_t>(overlay.begin(), overlay.end() - 1), BASE_ROWS, ENTRY_SIZE));
+}
+
+// The host tool's overlay loads in the firmware as the complete keymap it was made from, and the tool expands a firmware overlay back to the
+// complete keymap.
+TEST_CASE(toolMatchesFirmware)
+{
+    // Locals.
+    //
+    std::vector<uint8_t>                base = inbuiltKeyMap();
+    std::vector<t_row>                  rows = splitRows(base);
+    std::string                         inbuiltFile  = tempFile("tool_inbuilt.bin");
+    std::string                         completeFile = tempFile("tool_complete.bin");
+    std::string                         overlayFile  = tempFile("tool_overlay.bin");
+    std::string                         mergedFile   = tempFile("tool_merged.bin");
+    std::string                         tool = KEYMAP_OVERLAY_TOOL;
+    KeyMapOverlay::t_overlayMap         map;
+
+    rows[0] = userRow(1);
+    rows.insert(rows.begin() + 60, userRow(2));
+    rows.erase(rows.begin() + 100, rows.begin() + 104);
+    CHECK(writeFile(inbuiltFile, base));
+    CHECK(writeFile(completeFile, joinRows(rows)));
+
+    CHECK_EQ(system((tool + " diff " + inbuiltFile + " " + completeFile + " " + std::to_string(ENTRY_SIZE) + " " + overlayFile + " >/dev/null").c_str()), 0);
+    CHECK_EQ(KeyMapOverlay::load(overlayFile, base.data(), BASE_ROWS, ENTRY_SIZE, map), KeyMapOverlay::OVERLAY_LOAD_OVERLAY);
+    CHECK(mergedRows(map, base) == rows);
+    freeMap(map);
+
+    remove(overlayFile.c_str());
+    CHECK(KeyMapOverlay::save(overlayFile, rowPointers(rows), base.data(), BASE_ROWS, ENTRY_SIZE));
+    CHECK_EQ(system((tool + " merge " + inbuiltFile + " " + overlayFile + " " + mergedFile).c_str()), 0);
+    CHECK(readFile(mergedFile) == joinRows(rows));
+
+    // The tool refuses an overlay against the wrong inbuilt keymap and a size which is not whole rows.
+    CHECK(writeFile(inbuiltFile, inbuiltKeyMap(BASE_ROWS - 1)));
+    CHECK(system((tool + " merge " + inbuiltFile + " " + overlayFile + " " + mergedFile + " 2>/dev/null").c_str()) != 0);
+    CHECK(system((tool + " diff " + inbuiltFile + " " + completeFile + " 7 " + overlayFile + " 2>/dev/null").c_str()) != 0);
+}
+
+// Each interface's keymap after a typical user edit holds its index and the edited rows, not a copy of the whole keymap.
+TEST_CASE(interfaceHeapSaved)
+{
+    measureHeap<MZ2528>("MZ2528");
+    measureHeap<MZ5665>("MZ5665");
+    measureHeap<X1>("X1");
+    measureHeap<X68K>("X68K");
+    measureHeap<PC9801>("PC9801");
+}
+
+TEST_MAIN()
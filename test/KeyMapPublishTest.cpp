@@ -0,0 +1,253 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMapPublishTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Threaded tests of keymap publishing. A reader thread maps keys as the HID thread would
+//                  whilst tables are swapped under it, a freed table shows up as a corrupt row.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string.h>
+#include "KeyInterface.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // Keymap row used by the tests, the check field ties the row to the table generation which built it.
+    struct t_testEntry
+    {
+        uint32_t                        generation;
+        uint16_t                        key;
+        uint16_t                        check;
+    };
+
+    typedef KeyInterface::t_keyMapTable<t_testEntry> t_testTable;
+
+    #define TEST_BASE_ROWS              64
+    #define TEST_POISON                 0xEE
+
+    t_testEntry                         baseRows[TEST_BASE_ROWS];
+
+    uint16_t rowCheck(uint32_t generation, uint16_t key)
+    {
+        return((uint16_t)~((generation * 2654435761u) ^ key));
+    }
+
+    // Build a table of the inbuilt rows interleaved with overlay rows stamped with the generation, as a user keymap would be merged.
+    t_testTable *buildTable(uint32_t generation, int overlayRows)
+    {
+        // Locals.
+        //
+        t_testTable                    *table = new t_testTable;
+        t_testEntry                    *overlay = new t_testEntry[overlayRows];
+
+        table->base        = baseRows;
+        table->baseRows    = TEST_BASE_ROWS;
+        table->overlayRows = overlayRows;
+        table->rows        = TEST_BASE_ROWS + overlayRows;
+        table->index       = new uint16_t[table->rows];
+        table->overlay     = (uint8_t *)overlay;
+        for(int idx = 0; idx < overlayRows; idx++)
+        {
+            overlay[idx].generation = generation;
+            overlay[idx].key        = (uint16_t)(0x100 + idx);
+            overlay[idx].check      = rowCheck(generation, overlay[idx].key);
+        }
+        for(int idx = 0; idx < table->rows; idx++)
+        {
+            table->index[idx] = (uint16_t)(idx < overlayRows * 2 ? (idx % 2 == 0 ? idx / 2 : TEST_BASE_ROWS + idx / 2) : idx - overlayRows);
+        }
+        return(table);
+    }
+
+    // Walk a table as mapKey does, returning false on a row which is out of range, corrupt or from another generation.
+    bool walkTable(const t_testTable *table, uint16_t key, int &found)
+    {
+        // Locals.
+        //
+        uint32_t                        generation = 0;
+
+        found = -1;
+        if(table->rows != table->baseRows + table->overlayRows)
+            return(false);
+        for(int idx = 0; idx < table->rows; idx++)
+        {
+            if(table->index[idx] >= table->baseRows + table->overlayRows)
+                return(false);
+            const t_testEntry &row = table->row(idx);
+            if(row.check != rowCheck(row.generation, row.key))
+                return(false);
+            if(row.generation != 0)
+            {
+                if(generation != 0 && row.generation != generation)
+                    return(false);
+                generation = row.generation;
+            }
+            if(row.key == key && found == -1)
+                found = idx;
+        }
+        return(true);
+    }
+
+    // Stand-in interface holding the published keymap, the epoch and publish logic are those of every interface.
+    class TestInterface : public KeyInterface
+    {
+        public:
+            std::atomic<t_testTable *>  keyMap{NULL};
+    };
+
+    // Allocate and poison blocks the size of a table just replaced, the allocator hands freed blocks straight back so a reader still on a freed
+    // table sees the poison.
+    void poisonFreed(std::vector<uint8_t *> &blocks, int overlayRows)
+    {
+        // Locals.
+        //
+        size_t                          sizes[] = { overlayRows * sizeof(t_testEntry), (TEST_BASE_ROWS + overlayRows) * sizeof(uint16_t), sizeof(t_testTable) };
+
+        for(uint8_t *block : blocks)
+            delete [] block;
+        blocks.clear();
+        for(size_t size : sizes)
+        {
+            blocks.push_back(new uint8_t[size]);
+            memset(blocks.back(), TEST_POISON, size);
+        }
+    }
+
+    void initBaseRows(void)
+    {
+        for(int idx = 0; idx < TEST_BASE_ROWS; idx++)
+        {
+            baseRows[idx].generation = 0;
+            baseRows[idx].key        = (uint16_t)idx;
+            baseRows[idx].check      = rowCheck(0, (uint16_t)idx);
+        }
+    }
+}
+
+TEST_CASE(readerDuringSwaps)
+{
+    // Locals.
+    //
+    TestInterface                       ki;
+    std::atomic<bool>                   stop{false};
+    std::atomic<uint32_t>               lookups{0};
+    std::atomic<uint32_t>               corrupt{0};
+    std::atomic<uint32_t>               missing{0};
+    std::vector<uint8_t *>              poison;
+    int                                 swaps = 0;
+
+    initBaseRows();
+    ki.keyMap = buildTable(1, 16);
+
+    // The HID thread, maps keys back to back bracketed by the read epoch.
+    std::thread reader([&]()
+    {
+        // Locals.
+        //
+        int                             found;
+
+        while(!stop)
+        {
+            ki.keyMapReadBegin();
+            const t_testTable *table = ki.keyMap.load();
+            if(walkTable(table, (uint16_t)(0x100 + (lookups % 8)), found) == false)
+                corrupt++;
+            else if(found == -1)
+                missing++;
+            ki.keyMapReadEnd();
+            lookups++;
+        }
+    });
+    while(lookups == 0)
+        std::this_thread::yield();
+
+    // The writer, a reload per swap with the table size changing each time, for at least a quarter second of swaps.
+    auto start = std::chrono::steady_clock::now();
+    for(swaps = 0; swaps < 2000 || std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250); swaps++)
+    {
+        int overlayRows = 8 + (swaps % 41);
+        ki.publishKeyMap(ki.keyMap, buildTable((uint32_t)(swaps + 2), overlayRows));
+        poisonFreed(poison, overlayRows);
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stop = true;
+    reader.join();
+    for(uint8_t *block : poison)
+        delete [] block;
+
+    printf("%d swaps in %.0fms, %u lookups during the swaps.\n", swaps, elapsedMs, lookups.load());
+    CHECK(lookups > (uint32_t)swaps);
+    CHECK_EQ(corrupt.load(), (uint32_t)0);
+    CHECK_EQ(missing.load(), (uint32_t)0);
+    CHECK_EQ(ki.keyMap.load()->overlayRows, 8 + ((swaps - 1) % 41));
+}
+
+TEST_CASE(stalledReaderKeepsTable)
+{
+    // Locals.
+    //
+    TestInterface                       ki;
+    t_testTable                        *oldTable;
+    std::atomic<bool>                   reading{false};
+    std::atomic<bool>                   release{false};
+    int                                 found;
+
+    initBaseRows();
+    ki.keyMap = oldTable = buildTable(1, 16);
+
+    // A reader which holds the table mid key for longer than the writer waits.
+    std::thread reader([&]()
+    {
+        ki.keyMapReadBegin();
+        reading = true;
+        while(!release)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        ki.keyMapReadEnd();
+    });
+    while(!reading)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto start = std::chrono::steady_clock::now();
+    ki.publishKeyMap(ki.keyMap, buildTable(2, 16));
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // The replaced table is left allocated and intact for the reader.
+    CHECK(elapsedMs >= KEYIF_KEYMAP_SYNC_MS);
+    CHECK(walkTable(oldTable, 0x100, found));
+    CHECK_EQ(found, 1);
+    release = true;
+    reader.join();
+
+    // A reader between keys does not hold up the next publish.
+    start = std::chrono::steady_clock::now();
+    ki.publishKeyMap(ki.keyMap, buildTable(3, 16));
+    elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    CHECK(elapsedMs < 100.0);
+}
+
+TEST_MAIN()
@@ -0,0 +1,253 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            LEDTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the LED blink engine. Each mode is set with the clock frozen, the clock is
+//                  stepped and the LED output of the modelled LEDC is sampled into an on/off timeline
+//                  which is checked against the blink period, duty cycle, burst length and gap.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "LED.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // A lit period of the LED, times relative to the mode being applied.
+    struct t_pulse
+    {
+        int64_t                         start;
+        int64_t                         width;
+
+        bool operator==(const t_pulse &other) const { return(start == other.start && width == other.width); }
+    };
+
+    // The LED under test, created with the clock frozen so its timers only run as the clock is stepped.
+    LED &led(void)
+    {
+        // Locals.
+        //
+        static LED                     *instance = NULL;
+
+        if(instance == NULL)
+        {
+            Shim::freezeTime();
+            instance = new LED(CONFIG_PWRLED);
+            Shim::advanceTime(0);
+        }
+        return(*instance);
+    }
+
+    // Set a mode and let the kick timer apply it, returning the time it took effect.
+    int64_t setMode(enum LED::LED_MODE mode, enum LED::LED_DUTY_CYCLE dutyCycle, uint32_t maxBlinks, uint64_t usDutyPeriod, uint64_t msInterPeriod)
+    {
+        led().setLEDMode(mode, dutyCycle, maxBlinks, usDutyPeriod, msInterPeriod);
+        Shim::advanceTime(0);
+        return(Shim::now());
+    }
+
+    // Step the clock for the given time, sampling the LED every stepUs, and return the lit periods. A pulse still lit at the end is
+    // returned with the width seen so far.
+    std::vector<t_pulse> timeline(int64_t start, int64_t durationUs, int64_t stepUs)
+    {
+        // Locals.
+        //
+        std::vector<t_pulse>            pulses;
+        int                             level = 0;
+
+        for(int64_t elapsed = 0; elapsed <= durationUs; elapsed += stepUs)
+        {
+            if(elapsed > 0)
+                Shim::advanceTime(stepUs);
+            if(Shim::ledcLevel() != level)
+            {
+                level = Shim::ledcLevel();
+                if(level)
+                    pulses.push_back({ Shim::now() - start, 0 });
+                else
+                    pulses.back().width = Shim::now() - start - pulses.back().start;
+            }
+        }
+        if(level)
+            pulses.back().width = Shim::now() - start - pulses.back().start;
+        return(pulses);
+    }
+
+    // Lit time of one blink of the given period and duty cycle, as generated by the 10 bit LEDC.
+    int64_t litTime(uint32_t period, enum LED::LED_DUTY_CYCLE dutyCycle)
+    {
+        return((int64_t)period * ((LED_LEDC_MAX_DUTY * (int)dutyCycle) / 10) / LED_LEDC_MAX_DUTY);
+    }
+
+    // The pulses a run of blinks should produce, starting at the given time.
+    void expectBlinks(std::vector<t_pulse> &expected, int64_t start, uint32_t blinks, uint32_t period, enum LED::LED_DUTY_CYCLE dutyCycle)
+    {
+        for(uint32_t idx = 0; idx < blinks; idx++)
+            expected.push_back({ start + (int64_t)idx * period, litTime(period, dutyCycle) });
+    }
+
+    // Compare pulse timelines allowing for the sampling step, reporting the first mismatch.
+    bool matches(const std::vector<t_pulse> &actual, const std::vector<t_pulse> &expected, int64_t stepUs)
+    {
+        if(CHECK_EQ(actual.size(), expected.size()) == false)
+            return(false);
+        for(size_t idx = 0; idx < actual.size(); idx++)
+        {
+            if(CHECK(actual[idx].start - expected[idx].start < stepUs && expected[idx].start - actual[idx].start < stepUs) == false ||
+               CHECK(actual[idx].width - expected[idx].width < stepUs && expected[idx].width - actual[idx].width < stepUs) == false)
+            {
+                printf("  pulse %zu at %lld width %lld, expected at %lld width %lld\n", idx, (long long)actual[idx].start, (long long)actual[idx].width,
+                                                                                          (long long)expected[idx].start, (long long)expected[idx].width);
+                return(false);
+            }
+        }
+        return(true);
+    }
+}
+
+// Every blink period in use is generated, short periods from the APB clock and long ones from REF_TICK, neither clock reaches both. 13mS
+// is 76Hz, 13.16mS, just beyond the APB range.
+TEST_CASE(blinkPeriodsSelectClock)
+{
+    // Locals.
+    //
+    const uint32_t                      periods[] = { 100, 500, 1000, 10000, 12500, 13000, 25000, 50000, 100000, 150000, 250000, 500000, 1000000 };
+
+    for(uint32_t period : periods)
+    {
+        setMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_50, 0, period, 0);
+        CHECK_EQ(Shim::ledcFreq(), 1000000 / period);
+        CHECK_EQ(Shim::ledcClockHz(), 1000000 / Shim::ledcFreq() > LED_APB_MAX_PERIOD ? 1000000u : 80000000u);
+    }
+    setMode(LED::LED_MODE_OFF, LED::LED_DUTY_CYCLE_OFF, 0, 0, 0);
+}
+
+// On lights the LED continuously, off and a zero duty cycle blink leave it dark.
+TEST_CASE(onAndOff)
+{
+    // Locals.
+    //
+    int64_t                             start;
+
+    start = setMode(LED::LED_MODE_ON, LED::LED_DUTY_CYCLE_OFF, 0, 0, 0);
+    CHECK(matches(timeline(start, 2000000, 1000), { { 0, 2000000 } }, 1000));
+    start = setMode(LED::LED_MODE_OFF, LED::LED_DUTY_CYCLE_OFF, 0, 0, 0);
+    CHECK(timeline(start, 2000000, 1000).empty());
+    start = setMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_OFF, 0, 50000, 500);
+    CHECK(timeline(start, 2000000, 1000).empty());
+}
+
+// Continuous blinking repeats the period with no gap, each blink lit for the duty cycle of the period.
+TEST_CASE(blinkContinuous)
+{
+    // Locals.
+    //
+    std::vector<t_pulse>                expected;
+    int64_t                             start = setMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_30, 0, 10000, 0);
+
+    expectBlinks(expected, 0, 20, 10000, LED::LED_DUTY_CYCLE_30);
+    CHECK(matches(timeline(start, 200000 - 100, 100), expected, 100));
+}
+
+// Each duty cycle lights the LED for its tenth of the period, from the start of the period.
+TEST_CASE(dutyCycles)
+{
+    // Locals.
+    //
+    std::vector<t_pulse>                expected;
+    int64_t                             start;
+
+    for(int duty = LED::LED_DUTY_CYCLE_10; duty <= LED::LED_DUTY_CYCLE_90; duty++)
+    {
+        expected.clear();
+        start = setMode(LED::LED_MODE_BLINK, (enum LED::LED_DUTY_CYCLE)duty, 0, 50000, 0);
+        expectBlinks(expected, 0, 4, 50000, (enum LED::LED_DUTY_CYCLE)duty);
+        CHECK(matches(timeline(start, 200000 - 100, 100), expected, 100));
+    }
+}
+
+// A burst limited blink is the burst of blinks then the inter period gap, repeated. Periods are generated in whole Hz, 150mS is 6Hz.
+TEST_CASE(blinkBurstsWithGap)
+{
+    // Locals.
+    //
+    std::vector<t_pulse>                expected;
+    const uint32_t                      period = 1000000 / 6;
+    const int64_t                       burst  = 3 * period + 1000000;
+    int64_t                             start = setMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_20, 3, 150000, 1000);
+
+    for(int idx = 0; idx < 3; idx++)
+        expectBlinks(expected, idx * burst, 3, period, LED::LED_DUTY_CYCLE_20);
+    CHECK(matches(timeline(start, 3 * burst - 1000, 100), expected, 100));
+}
+
+// A oneshot blink is followed by the gap, and with a limit the LED switches off after that many blinks.
+TEST_CASE(oneshotLimited)
+{
+    // Locals.
+    //
+    std::vector<t_pulse>                expected;
+    int64_t                             start = setMode(LED::LED_MODE_BLINK_ONESHOT, LED::LED_DUTY_CYCLE_50, 4, 25000, 100);
+
+    for(int idx = 0; idx < 4; idx++)
+        expectBlinks(expected, idx * (25000 + 100000), 1, 25000, LED::LED_DUTY_CYCLE_50);
+    CHECK(matches(timeline(start, 2000000, 100), expected, 100));
+}
+
+// Without a gap the oneshot blinks run back to back, 5 blinks then off, as used for key activity.
+TEST_CASE(oneshotBackToBack)
+{
+    // Locals.
+    //
+    std::vector<t_pulse>                expected;
+    int64_t                             start = setMode(LED::LED_MODE_BLINK_ONESHOT, LED::LED_DUTY_CYCLE_50, 5, 100000, 0);
+
+    expectBlinks(expected, 0, 5, 100000, LED::LED_DUTY_CYCLE_50);
+    CHECK(matches(timeline(start, 2000000, 100), expected, 100));
+
+    // Short blinks on the APB clock, 200 of 1mS then off.
+    expected.clear();
+    start = setMode(LED::LED_MODE_BLINK_ONESHOT, LED::LED_DUTY_CYCLE_10, 200, 1000, 0);
+    expectBlinks(expected, 0, 200, 1000, LED::LED_DUTY_CYCLE_10);
+    CHECK(matches(timeline(start, 400000, 10), expected, 10));
+}
+
+// A new mode takes over at once, cutting short the burst or gap in progress.
+TEST_CASE(newModeReplacesBurst)
+{
+    // Locals.
+    //
+    std::vector<t_pulse>                expected;
+    int64_t                             start = setMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_50, 2, 50000, 1000);
+
+    timeline(start, 300000, 1000);
+    start = setMode(LED::LED_MODE_BLINK, LED::LED_DUTY_CYCLE_80, 1, 25000, 250);
+    for(int idx = 0; idx < 4; idx++)
+        expectBlinks(expected, idx * (25000 + 250000), 1, 25000, LED::LED_DUTY_CYCLE_80);
+    CHECK(matches(timeline(start, 4 * 275000 - 1000, 100), expected, 100));
+}
+
+TEST_MAIN()
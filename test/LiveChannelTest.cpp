@@ -0,0 +1,406 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            LiveChannelTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the WebSocket live channel protocol run through a stand-in server. The server
+//                  carries frames between clients and the live channel as the WiFi handler does, the
+//                  keymap editor is played by sending row edits built from the table the browser reads
+//                  and the effect is checked by looking keys up, both directly and typed on the stand-in
+//                  keyboard through the key monitor.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LiveChannel.h"
+#include "KeyMapOverlay.h"
+#include "X1.h"
+#include "HostHarness.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // Stand-in for the WiFi server, clients are numbered and hold the frames sent to them. A frame from a client is given to the live channel,
+    // the reply goes back to the sender and any broadcast to the other clients, pushes from the key monitor go to every client.
+    class StandInServer
+    {
+        public:
+            StandInServer(KeyInterface *keyIf, int clientCnt) : live(keyIf), clients(clientCnt) { }
+
+            // Send a frame from a client, returns false if the live channel did not reply.
+            bool send(int client, bool binary, const std::vector<uint8_t> &payload)
+            {
+                // Locals.
+                //
+                LiveChannel::t_frame    frame = { binary, payload };
+                LiveChannel::t_frame    reply;
+                std::string             broadcast;
+                bool                    result;
+
+                if(payload.size() > LIVECHANNEL_MAX_FRAME)
+                    return(false);
+                result = live.receive(frame, reply, broadcast);
+
+                std::lock_guard<std::mutex> lk(lock);
+                for(int idx = 0; idx < (int)clients.size() && broadcast.empty() == false; idx++)
+                {
+                    if(idx != client)
+                        clients[idx].push_back({ false, std::vector<uint8_t>(broadcast.begin(), broadcast.end()) });
+                }
+                if(result)
+                    clients[client].push_back(reply);
+                return(result);
+            }
+
+            // Push callback for the key monitor, sent to all clients as the work queued by the WiFi server is.
+            static void push(void *ctx, const std::string &message)
+            {
+                StandInServer *server = (StandInServer *)ctx;
+
+                std::lock_guard<std::mutex> lk(server->lock);
+                for(auto &client : server->clients)
+                    client.push_back({ false, std::vector<uint8_t>(message.begin(), message.end()) });
+            }
+
+            // Take the frames received by a client.
+            std::vector<LiveChannel::t_frame> take(int client)
+            {
+                std::lock_guard<std::mutex> lk(lock);
+                std::vector<LiveChannel::t_frame> frames;
+
+                frames.swap(clients[client]);
+                return(frames);
+            }
+
+            LiveChannel                         live;
+
+        private:
+            std::mutex                          lock;
+            std::vector<std::vector<LiveChannel::t_frame>> clients;
+    };
+
+    // Text of a frame.
+    std::string text(const LiveChannel::t_frame &frame)
+    {
+        return(std::string(frame.payload.begin(), frame.payload.end()));
+    }
+
+    // Numeric field of a JSON message, -1 if absent.
+    long field(const std::string &message, const char *name)
+    {
+        // Locals.
+        //
+        std::string                     key = std::string("\"") + name + "\":";
+        size_t                          pos = message.find(key);
+
+        return(pos == std::string::npos ? -1 : strtol(message.c_str() + pos + key.size(), NULL, 10));
+    }
+
+    // Keymap rows as the browser reads them, one byte per column.
+    std::vector<std::vector<uint8_t>> keyMapRows(KeyInterface &ki)
+    {
+        // Locals.
+        //
+        std::vector<std::vector<uint8_t>> rows;
+        std::vector<uint32_t>           data;
+        int                             row = 0;
+
+        for(bool start = true; ki.getKeyMapData(data, &row, start) == false; start = false)
+        {
+            rows.push_back(std::vector<uint8_t>(data.begin(), data.end()));
+            data.clear();
+        }
+        return(rows);
+    }
+
+    // Edit frame as keymap.js builds it, one edit.
+    std::vector<uint8_t> editFrame(uint8_t op, uint16_t row, const std::vector<uint8_t> &entry, uint8_t entrySize)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            frame = { LIVECHANNEL_MSG_KEYMAP_EDIT, 1, entrySize, op, (uint8_t)(row & 0xFF), (uint8_t)(row >> 8) };
+
+        for(uint8_t value : entry)
+            frame.push_back(value);
+        return(frame);
+    }
+
+    // Check an acknowledgement, the status and row count.
+    bool checkAck(const std::vector<LiveChannel::t_frame> &frames, uint8_t status, int rows)
+    {
+        return(CHECK_EQ(frames.size(), (size_t)1) && CHECK(frames[0].binary) && CHECK_EQ(frames[0].payload.size(), (size_t)4) &&
+               CHECK_EQ(frames[0].payload[0], (uint8_t)LIVECHANNEL_MSG_KEYMAP_ACK) && CHECK_EQ(frames[0].payload[1], status) &&
+               CHECK_EQ(frames[0].payload[2] | (frames[0].payload[3] << 8), rows));
+    }
+
+    // Keymap row mapKey uses for a key, the first row for the key producing the given key code. X1 mode A maps to the key in column 5.
+    int mappedRow(const std::vector<std::vector<uint8_t>> &rows, uint8_t ps2Key, uint8_t x1Key)
+    {
+        for(int idx = 0; idx < (int)rows.size(); idx++)
+        {
+            if(rows[idx][0] == ps2Key && rows[idx][5] == x1Key)
+                return(idx);
+        }
+        return(-1);
+    }
+}
+
+TEST_CASE(statusOnRequest)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X1                                  x1(&host.nvs, host.hid, host.fsPath.c_str());
+    StandInServer                       server(&x1, 2);
+    std::vector<LiveChannel::t_frame>   frames;
+    std::string                         request = "status";
+
+    CHECK(server.send(0, false, std::vector<uint8_t>(request.begin(), request.end())));
+    frames = server.take(0);
+    if(CHECK_EQ(frames.size(), (size_t)1))
+    {
+        CHECK(frames[0].binary == false);
+        CHECK(text(frames[0]).find("\"type\":\"status\"") != std::string::npos);
+        CHECK(text(frames[0]).find("\"interface\":\"" + x1.ifName() + "\"") != std::string::npos);
+        CHECK(field(text(frames[0]), "heap") > 0);
+    }
+    CHECK(server.take(1).empty());
+
+    // Anything else is not answered.
+    request = "hello";
+    CHECK(server.send(0, false, std::vector<uint8_t>(request.begin(), request.end())) == false);
+    CHECK(server.send(0, true, { 'Z', 0 }) == false);
+    CHECK(server.take(0).empty());
+}
+
+TEST_CASE(editChangesMappingLive)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X1                                  x1(&host.nvs, host.hid, host.fsPath.c_str());
+    StandInServer                       server(&x1, 2);
+    std::vector<std::vector<uint8_t>>   rows;
+    std::vector<std::vector<uint8_t>>   edited;
+    std::vector<uint8_t>                entry;
+    std::vector<LiveChannel::t_frame>   frames;
+    int                                 row;
+
+    x1.led = host.led;
+    rows   = keyMapRows(x1);
+    row    = field(server.live.keyEvent(PS2_KEY_A), "row");
+    CHECK_EQ(row, mappedRow(rows, PS2_KEY_A, 'A'));
+    if(!CHECK(row >= 0))
+        return;
+
+    // Replace the row the key uses, the editor gets the acknowledgement, the other client is told and the key still selects the row, now
+    // holding the new code.
+    entry    = rows[row];
+    entry[5] = 'Q';
+    CHECK(server.send(0, true, editFrame(KeyMapOverlay::OVERLAY_REPLACE, row, entry, entry.size())));
+    checkAck(server.take(0), 0, rows.size());
+    frames = server.take(1);
+    if(CHECK_EQ(frames.size(), (size_t)1))
+    {
+        CHECK(text(frames[0]).find("\"type\":\"keymap\"") != std::string::npos);
+        CHECK_EQ(field(text(frames[0]), "rows"), (long)rows.size());
+    }
+    CHECK_EQ(field(server.live.keyEvent(PS2_KEY_A), "row"), (long)row);
+    edited = keyMapRows(x1);
+    CHECK(edited[row] == entry);
+
+    // Insert a row for the key ahead of it, the key selects the insert at once, then delete the insert, the row count follows.
+    entry[5] = 'W';
+    CHECK(server.send(0, true, editFrame(KeyMapOverlay::OVERLAY_INSERT, 0, entry, entry.size())));
+    checkAck(server.take(0), 0, rows.size() + 1);
+    CHECK_EQ(field(server.live.keyEvent(PS2_KEY_A), "row"), 0L);
+    CHECK(server.send(0, true, editFrame(KeyMapOverlay::OVERLAY_DELETE, 0, {}, entry.size())));
+    checkAck(server.take(0), 0, rows.size());
+    CHECK_EQ(field(server.live.keyEvent(PS2_KEY_A), "row"), (long)row);
+
+    // Restore the inbuilt row.
+    CHECK(server.send(0, true, editFrame(KeyMapOverlay::OVERLAY_REPLACE, row, rows[row], entry.size())));
+    checkAck(server.take(0), 0, rows.size());
+    CHECK_EQ(field(server.live.keyEvent(PS2_KEY_A), "row"), (long)row);
+    server.take(1);
+}
+
+TEST_CASE(badEditRejected)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X1                                  x1(&host.nvs, host.hid, host.fsPath.c_str());
+    StandInServer                       server(&x1, 2);
+    std::vector<std::vector<uint8_t>>   rows = keyMapRows(x1);
+    std::vector<uint8_t>                frame;
+    std::vector<KeyInterface::t_keyMapEdit> edits;
+
+    // Truncated, one byte short of the row.
+    frame = editFrame(KeyMapOverlay::OVERLAY_REPLACE, 0, rows[0], rows[0].size());
+    frame.pop_back();
+    CHECK(LiveChannel::parseKeyMapEdit(frame, edits) == false);
+    CHECK(server.send(0, true, frame));
+    checkAck(server.take(0), 1, 0);
+
+    // Trailing bytes after the last edit.
+    frame = editFrame(KeyMapOverlay::OVERLAY_DELETE, 0, {}, rows[0].size());
+    frame.push_back(0x00);
+    CHECK(LiveChannel::parseKeyMapEdit(frame, edits) == false);
+    CHECK(server.send(0, true, frame));
+    checkAck(server.take(0), 1, 0);
+
+    // Row size which is not the interface row size.
+    frame = editFrame(KeyMapOverlay::OVERLAY_REPLACE, 0, std::vector<uint8_t>(rows[0].size() + 1, 0x00), rows[0].size() + 1);
+    CHECK(LiveChannel::parseKeyMapEdit(frame, edits));
+    CHECK(server.send(0, true, frame));
+    checkAck(server.take(0), 1, 0);
+
+    // Row beyond the keymap.
+    frame = editFrame(KeyMapOverlay::OVERLAY_REPLACE, rows.size(), rows[0], rows[0].size());
+    CHECK(server.send(0, true, frame));
+    checkAck(server.take(0), 1, 0);
+
+    // Nothing changed and no other client was told.
+    CHECK(keyMapRows(x1) == rows);
+    CHECK(server.take(1).empty());
+}
+
+TEST_CASE(noKeyboardInterface)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    StandInServer                       server(NULL, 1);
+
+    CHECK(server.send(0, true, editFrame(KeyMapOverlay::OVERLAY_DELETE, 0, {}, 8)));
+    checkAck(server.take(0), 1, 0);
+    CHECK_EQ(field(server.live.keyEvent(PS2_KEY_A), "row"), -1L);
+    CHECK(server.live.startKeyMonitor(StandInServer::push, &server) == false);
+    (void)host;
+}
+
+TEST_CASE(typedKeysPushed)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X1                                  x1(&host.nvs, host.hid, host.fsPath.c_str());
+    StandInServer                       server(&x1, 2);
+    std::vector<LiveChannel::t_frame>   frames[2];
+    long                                row;
+    int                                 makes = 0;
+    int                                 breaks = 0;
+
+    x1.led = host.led;
+    row = field(server.live.keyEvent(PS2_KEY_A), "row");
+    CHECK(row >= 0);
+    while(host.hid->read() != 0);
+
+    CHECK(server.live.startKeyMonitor(StandInServer::push, &server));
+    CHECK(server.live.startKeyMonitor(StandInServer::push, &server) == false);
+    HostHarness::tapKey(0x04);
+    Shim::settle(100);
+    server.live.stopKeyMonitor();
+
+    // Both clients see the make and the break with the row the key selects.
+    for(int client = 0; client < 2; client++)
+    {
+        frames[client] = server.take(client);
+        for(const LiveChannel::t_frame &frame : frames[client])
+        {
+            CHECK(frame.binary == false);
+            CHECK(text(frame).find("\"type\":\"key\"") != std::string::npos);
+            if((field(text(frame), "scanCode") & 0xFF) != PS2_KEY_A)
+                continue;
+            if(field(text(frame), "scanCode") & PS2_BREAK)
+                breaks++;
+            else
+                makes++;
+            CHECK_EQ(field(text(frame), "row"), row);
+        }
+    }
+    CHECK_EQ(makes, 2);
+    CHECK_EQ(breaks, 2);
+    CHECK(frames[0].size() == frames[1].size());
+
+    // Stopped, keys are no longer read.
+    HostHarness::tapKey(0x04);
+    Shim::settle(100);
+    CHECK(server.take(0).empty());
+    while(host.hid->read() != 0);
+}
+
+TEST_CASE(editWhileTyping)
+{
+    // Locals.
+    //
+    HostHarness::t_host                &host = HostHarness::host();
+    X1                                  x1(&host.nvs, host.hid, host.fsPath.c_str());
+    StandInServer                       server(&x1, 1);
+    std::vector<std::vector<uint8_t>>   rows;
+    std::vector<uint8_t>                entry;
+    std::vector<LiveChannel::t_frame>   frames;
+    long                                row;
+    int                                 applied = 0;
+    int                                 seen = 0;
+
+    x1.led = host.led;
+    rows   = keyMapRows(x1);
+    row    = field(server.live.keyEvent(PS2_KEY_A), "row");
+    if(!CHECK(row > 0))
+        return;
+    while(host.hid->read() != 0);
+
+    // Keys are typed and looked up on the monitor thread whilst the editor inserts and deletes a row for the key ahead of its row, every
+    // make selects the insert or the original row.
+    CHECK(server.live.startKeyMonitor(StandInServer::push, &server));
+    entry = rows[row];
+    for(int idx = 0; idx < 10; idx++)
+    {
+        HostHarness::keyReport(0x00, { 0x04 });
+        if(server.send(0, true, (idx & 1) ? editFrame(KeyMapOverlay::OVERLAY_DELETE, 0, {}, entry.size()) : editFrame(KeyMapOverlay::OVERLAY_INSERT, 0, entry, entry.size())))
+            applied++;
+        HostHarness::keyReport(0x00, {});
+        Shim::settle(20);
+    }
+    Shim::settle(100);
+    server.live.stopKeyMonitor();
+    CHECK_EQ(applied, 10);
+
+    frames = server.take(0);
+    for(const LiveChannel::t_frame &frame : frames)
+    {
+        if(frame.binary || (field(text(frame), "scanCode") & 0xFF) != PS2_KEY_A || (field(text(frame), "scanCode") & PS2_BREAK))
+            continue;
+        seen++;
+        CHECK(field(text(frame), "row") == row || field(text(frame), "row") == 0);
+    }
+    CHECK(seen > 0);
+    CHECK(keyMapRows(x1) == rows);
+}
+
+TEST_MAIN()
@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            MZ2528Test.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the MZ-2500 host interface on the virtual GPIO. Keys typed on the stand-in
+//                  keyboard are read back from KDO[7:0] by strobing RTSN with the row on KDB[3:0], as
+//                  the MZ-2500 keyboard controller scans the matrix.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "MZ2528.h"
+#include "HostHarness.h"
+#include "TestRunner.h"
+
+namespace
+{
+    #define BT_KEY_A                    0x04
+    #define BT_KEY_B                    0x05
+    #define BT_MOD_L_SHIFT              0x02
+    #define MZ_ROWS                     14
+    #define MZ_ROW_SHIFT                11                              // SHIFT is column 2.
+    #define MZ_ROW_A                    4                               // A is column 1, B column 2.
+
+    const int                           kdoPins[8] = { CONFIG_HOST_KDO0, CONFIG_HOST_KDO1, CONFIG_HOST_KDO2, CONFIG_HOST_KDO3,
+                                                       CONFIG_HOST_KDO4, CONFIG_HOST_KDO5, CONFIG_HOST_KDO6, CONFIG_HOST_KDO7 };
+
+    // The interface under test, created once as it owns the host GPIO. RTSN is held low, idle, between strobes.
+    MZ2528 &mz2528(void)
+    {
+        // Locals.
+        //
+        static MZ2528                  *instance = NULL;
+        HostHarness::t_host            &host = HostHarness::host();
+
+        if(instance == NULL)
+        {
+            Shim::setInput(CONFIG_HOST_RTSNI, 0);
+            Shim::setInput(CONFIG_HOST_KDI4, 1);
+            Shim::gpioTrace(CONFIG_HOST_KDO7);
+            instance = new MZ2528(2500, &host.nvs, host.led, host.hid, host.fsPath.c_str());
+            Shim::settle(100);
+        }
+        return(*instance);
+    }
+
+    // Strobe a row as the host does, row on KDB[3:0] and KDI4 selecting the row or the AND of all rows, then RTSN high. The interface resets
+    // KDO to inactive on each strobe, the byte is read once that write and the following row data have been made. Returns the KDO byte,
+    // a key down is a 0 bit. With the interface idle, no key held, KDO stays inactive and the wait times out.
+    uint8_t strobeRow(int row, bool allRows = false)
+    {
+        // Locals.
+        //
+        size_t                          writes;
+        uint8_t                         data = 0;
+
+        mz2528();
+        Shim::setInput(CONFIG_HOST_KDB0, (row >> 0) & 1);
+        Shim::setInput(CONFIG_HOST_KDB1, (row >> 1) & 1);
+        Shim::setInput(CONFIG_HOST_KDB2, (row >> 2) & 1);
+        Shim::setInput(CONFIG_HOST_KDB3, (row >> 3) & 1);
+        Shim::setInput(CONFIG_HOST_KDI4, allRows ? 0 : 1);
+        writes = Shim::gpioWrites(CONFIG_HOST_KDO7).size();
+        Shim::setInput(CONFIG_HOST_RTSNI, 1);
+        for(int wait = 0; wait < 50 && Shim::gpioWrites(CONFIG_HOST_KDO7).size() == writes; wait++)
+            Shim::settle(1);
+        Shim::settle(1);
+        for(int bit = 0; bit < 8; bit++)
+            data |= (Shim::getOutput(kdoPins[bit]) ? 1 : 0) << bit;
+        Shim::setInput(CONFIG_HOST_RTSNI, 0);
+        Shim::settle(1);
+        return(data);
+    }
+
+    // A full scan of the matrix, one byte per row.
+    std::vector<uint8_t> scanMatrix(void)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            matrix;
+
+        for(int row = 0; row < MZ_ROWS; row++)
+            matrix.push_back(strobeRow(row));
+        return(matrix);
+    }
+
+    // The matrix with the given keys down, as row and column pairs.
+    std::vector<uint8_t> expectMatrix(const std::vector<std::pair<int, int>> &keys)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            matrix(MZ_ROWS, 0xFF);
+
+        for(const std::pair<int, int> &key : keys)
+            matrix[key.first] &= ~(1 << key.second);
+        return(matrix);
+    }
+}
+
+// With no key held the host reads every row, and the strobe all byte, as inactive.
+TEST_CASE(idleMatrix)
+{
+    CHECK(scanMatrix() == expectMatrix({}));
+    CHECK_EQ(strobeRow(0, true), 0xFF);
+}
+
+// A key held on the stand-in keyboard is seen by the host at its row and column only, and by the strobe all byte, until released.
+TEST_CASE(keyInMatrix)
+{
+    HostHarness::keyReport(0x00, { BT_KEY_A });
+    Shim::settle(50);
+    CHECK(scanMatrix() == expectMatrix({ { MZ_ROW_A, 1 } }));
+    CHECK_EQ(strobeRow(0, true), (uint8_t)~(1 << 1));
+
+    HostHarness::keyReport(0x00, {});
+    Shim::settle(50);
+    CHECK(scanMatrix() == expectMatrix({}));
+    CHECK_EQ(strobeRow(0, true), 0xFF);
+}
+
+// Keys held together each appear in the matrix, SHIFT on its own row, and the strobe all byte is the AND of the rows.
+TEST_CASE(shiftedKeysInMatrix)
+{
+    HostHarness::keyReport(BT_MOD_L_SHIFT, { BT_KEY_A, BT_KEY_B });
+    Shim::settle(50);
+    CHECK(scanMatrix() == expectMatrix({ { MZ_ROW_SHIFT, 2 }, { MZ_ROW_A, 1 }, { MZ_ROW_A, 2 } }));
+    CHECK_EQ(strobeRow(0, true), (uint8_t)~((1 << 1) | (1 << 2)));
+
+    HostHarness::keyReport(0x00, {});
+    Shim::settle(50);
+    CHECK(scanMatrix() == expectMatrix({}));
+}
+
+TEST_MAIN()
@@ -0,0 +1,622 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            MetricsTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the runtime metrics. The /metrics JSON is parsed and checked against its
+//                  schema, and values, counts and queue depths put in are checked in the figures it
+//                  reports, including the histogram bucket each value lands in. Key latency stages are
+//                  timed against the shim clock.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//                  Oct 2026 - Stage timing tests.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <time.h>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "Metrics.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    #define RECORD_THREADS              8
+    #define RECORDS_PER_THREAD          2000000
+    #define CPU_SPIN_MS                 100
+
+    // A parsed JSON value. Object members are kept in order with duplicates so the schema checks see exactly what was sent.
+    struct t_json
+    {
+        enum { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT } type = JSON_NULL;
+        double                          number = 0.0;
+        std::string                     text;
+        std::vector<t_json>             items;
+        std::vector<std::string>        names;
+
+        const t_json *member(const std::string &name) const
+        {
+            for(size_t idx = 0; idx < names.size(); idx++)
+                if(names[idx] == name)
+                    return(&items[idx]);
+            return(NULL);
+        }
+    };
+
+    // Strict JSON parser, RFC 8259 less unicode escapes which the metrics never produce. Returns false on any syntax error.
+    class JSONParser
+    {
+        public:
+            JSONParser(const std::string &text) : text(text), pos(0) {}
+
+            bool parse(t_json &value)
+            {
+                return(parseValue(value) && (skipSpace(), pos == text.size()));
+            }
+
+        private:
+            const std::string          &text;
+            size_t                      pos;
+
+            void skipSpace(void)
+            {
+                while(pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+                    pos++;
+            }
+
+            bool literal(const char *word)
+            {
+                // Locals.
+                //
+                size_t                  len = strlen(word);
+
+                if(text.compare(pos, len, word) != 0)
+                    return(false);
+                pos += len;
+                return(true);
+            }
+
+            bool parseString(std::string &result)
+            {
+                if(pos >= text.size() || text[pos++] != '"')
+                    return(false);
+                result.clear();
+                while(pos < text.size() && text[pos] != '"')
+                {
+                    if((unsigned char)text[pos] < 0x20)
+                        return(false);
+                    if(text[pos] == '\\')
+                    {
+                        if(++pos >= text.size() || strchr("\"\\/bfnrt", text[pos]) == NULL)
+                            return(false);
+                    }
+                    result += text[pos++];
+                }
+                return(pos++ < text.size());
+            }
+
+            bool parseNumber(double &result)
+            {
+                // Locals.
+                //
+                size_t                  start = pos;
+
+                if(pos < text.size() && text[pos] == '-') pos++;
+                if(pos >= text.size() || !isdigit((unsigned char)text[pos])) return(false);
+                if(text[pos] == '0') pos++; else while(pos < text.size() && isdigit((unsigned char)text[pos])) pos++;
+                if(pos < text.size() && text[pos] == '.')
+                {
+                    if(++pos >= text.size() || !isdigit((unsigned char)text[pos])) return(false);
+                    while(pos < text.size() && isdigit((unsigned char)text[pos])) pos++;
+                }
+                if(pos < text.size() && (text[pos] == 'e' || text[pos] == 'E'))
+                {
+                    if(++pos < text.size() && (text[pos] == '+' || text[pos] == '-')) pos++;
+                    if(pos >= text.size() || !isdigit((unsigned char)text[pos])) return(false);
+                    while(pos < text.size() && isdigit((unsigned char)text[pos])) pos++;
+                }
+                result = strtod(text.substr(start, pos - start).c_str(), NULL);
+                return(true);
+            }
+
+            bool parseValue(t_json &value)
+            {
+                skipSpace();
+                if(pos >= text.size())
+                    return(false);
+                switch(text[pos])
+                {
+                    case '{':
+                        value.type = t_json::JSON_OBJECT;
+                        pos++;
+                        skipSpace();
+                        if(pos < text.size() && text[pos] == '}') { pos++; return(true); }
+                        do {
+                            skipSpace();
+                            value.names.push_back("");
+                            value.items.push_back(t_json());
+                            if(!parseString(value.names.back())) return(false);
+                            skipSpace();
+                            if(pos >= text.size() || text[pos++] != ':') return(false);
+                            if(!parseValue(value.items.back())) return(false);
+                            skipSpace();
+                        } while(pos < text.size() && text[pos] == ',' && ++pos);
+                        return(pos < text.size() && text[pos++] == '}');
+
+                    case '[':
+                        value.type = t_json::JSON_ARRAY;
+                        pos++;
+                        skipSpace();
+                        if(pos < text.size() && text[pos] == ']') { pos++; return(true); }
+                        do {
+                            value.items.push_back(t_json());
+                            if(!parseValue(value.items.back())) return(false);
+                            skipSpace();
+                        } while(pos < text.size() && text[pos] == ',' && ++pos);
+                        return(pos < text.size() && text[pos++] == ']');
+
+                    case '"':
+                        value.type = t_json::JSON_STRING;
+                        return(parseString(value.text));
+
+                    case 't': value.type = t_json::JSON_BOOL; value.number = 1; return(literal("true"));
+                    case 'f': value.type = t_json::JSON_BOOL; value.number = 0; return(literal("false"));
+                    case 'n': value.type = t_json::JSON_NULL; return(literal("null"));
+
+                    default:
+                        value.type = t_json::JSON_NUMBER;
+                        return(parseNumber(value.number));
+                }
+            }
+    };
+
+    t_json metrics(void)
+    {
+        // Locals.
+        //
+        t_json                          root;
+        std::string                     json = Metrics::json();
+
+        if(!CHECK(JSONParser(json).parse(root)))
+            fprintf(stderr, "%s\n", json.c_str());
+        return(root);
+    }
+
+    // An object holding exactly the named members, in order.
+    bool hasMembers(const t_json *value, const std::vector<std::string> &names)
+    {
+        return(value != NULL && value->type == t_json::JSON_OBJECT && value->names == names);
+    }
+
+    bool isCount(const t_json *value)
+    {
+        return(value != NULL && value->type == t_json::JSON_NUMBER && value->number >= 0 && value->number == (double)(uint32_t)value->number);
+    }
+
+    // Check a sample, the live figures or those retained from the interface, against the schema.
+    bool sampleValid(const t_json *sample)
+    {
+        // Locals.
+        //
+        bool                            valid;
+        const t_json                   *counters;
+        const t_json                   *histograms;
+
+        valid = hasMembers(sample, { "uptimeMs", "heap", "tasks", "queues", "counters", "histograms" }) && isCount(sample->member("uptimeMs")) &&
+                hasMembers(sample->member("heap"), { "free", "min", "largest" }) &&
+                sample->member("tasks")->type == t_json::JSON_ARRAY && sample->member("queues")->type == t_json::JSON_ARRAY;
+        if(!valid)
+            return(false);
+        for(const char *figure : { "free", "min", "largest" })
+            valid &= isCount(sample->member("heap")->member(figure));
+        for(const t_json &task : sample->member("tasks")->items)
+        {
+            valid &= hasMembers(&task, { "name", "stackFree", "runTime", "cpu" }) && task.member("name")->type == t_json::JSON_STRING &&
+                     isCount(task.member("stackFree")) && isCount(task.member("runTime")) &&
+                     task.member("cpu")->type == t_json::JSON_NUMBER && task.member("cpu")->number >= 0.0 && task.member("cpu")->number <= 100.0;
+        }
+        for(const t_json &queue : sample->member("queues")->items)
+        {
+            valid &= hasMembers(&queue, { "name", "depth", "peak", "size" }) && queue.member("name")->type == t_json::JSON_STRING &&
+                     isCount(queue.member("depth")) && isCount(queue.member("peak")) && isCount(queue.member("size")) &&
+                     queue.member("depth")->number <= queue.member("peak")->number && queue.member("peak")->number <= queue.member("size")->number;
+        }
+        counters = sample->member("counters");
+        valid &= hasMembers(counters, { "xmitQueueFull", "rawKeyQueueFull", "keyQueueFull", "ps2Parity", "ps2Resend", "ps2Overrun", "uartRxOverflow" });
+        for(size_t idx = 0; valid && idx < counters->items.size(); idx++)
+            valid &= isCount(&counters->items[idx]);
+        histograms = sample->member("histograms");
+        valid &= hasMembers(histograms, { "input", "keymap", "queue", "output", "total" });
+        for(size_t idx = 0; valid && idx < histograms->items.size(); idx++)
+        {
+            valid &= histograms->items[idx].type == t_json::JSON_ARRAY && histograms->items[idx].items.size() == METRICS_HIST_BUCKETS;
+            for(size_t bkt = 0; valid && bkt < histograms->items[idx].items.size(); bkt++)
+                valid &= isCount(&histograms->items[idx].items[bkt]);
+        }
+        return(valid);
+    }
+
+    // Live histogram bucket counts, by histogram name.
+    std::vector<uint32_t> histogram(const t_json &root, const char *name)
+    {
+        // Locals.
+        //
+        std::vector<uint32_t>           counts;
+
+        for(const t_json &count : root.member("live")->member("histograms")->member(name)->items)
+            counts.push_back((uint32_t)count.number);
+        return(counts);
+    }
+
+    uint32_t counter(const t_json &root, const char *name, const char *sample = "live")
+    {
+        return((uint32_t)root.member(sample)->member("counters")->member(name)->number);
+    }
+
+    const t_json *queue(const t_json &root, const char *name)
+    {
+        for(const t_json &queue : root.member("live")->member("queues")->items)
+            if(queue.member("name")->text == name)
+                return(&queue);
+        return(NULL);
+    }
+
+    // Bucket by definition, the number of bits needed to hold the value, the last bucket holding everything from 2^14.
+    uint32_t referenceBucket(uint32_t value)
+    {
+        // Locals.
+        //
+        uint32_t                        bits = 0;
+
+        while(bits < 32 && (value >> bits) != 0)
+            bits++;
+        return(bits < METRICS_HIST_BUCKETS - 1 ? bits : METRICS_HIST_BUCKETS - 1);
+    }
+
+    std::vector<uint32_t> minus(const std::vector<uint32_t> &after, const std::vector<uint32_t> &before)
+    {
+        // Locals.
+        //
+        std::vector<uint32_t>           delta;
+
+        for(size_t idx = 0; idx < after.size() && idx < before.size(); idx++)
+            delta.push_back(after[idx] - before[idx]);
+        return(delta);
+    }
+}
+
+// Until a sample of the interface has been committed there is none to report, the live figures are always there.
+TEST_CASE(noInterfaceSampleBeforeCommit)
+{
+    // Locals.
+    //
+    t_json                              root = metrics();
+
+    CHECK(hasMembers(&root, { "version", "histogramBuckets", "live", "interface" }));
+    CHECK(root.member("interface")->type == t_json::JSON_NULL);
+    CHECK(sampleValid(root.member("live")));
+}
+
+// The document, its live sample and every task and queue in it match the schema the web page reads.
+TEST_CASE(jsonMatchesSchema)
+{
+    // Locals.
+    //
+    TaskHandle_t                        task = NULL;
+    t_json                              root;
+
+    xTaskCreate([](void *) { for(;;) vTaskDelay(1000); }, "metricsProbe", 4096, NULL, 5, &task);
+    root = metrics();
+    CHECK(hasMembers(&root, { "version", "histogramBuckets", "live", "interface" }));
+    CHECK(root.member("version")->type == t_json::JSON_NUMBER && std::abs(root.member("version")->number - METRICS_VERSION) < 0.001);
+    CHECK(root.member("histogramBuckets")->type == t_json::JSON_NUMBER && root.member("histogramBuckets")->number == METRICS_HIST_BUCKETS);
+    CHECK(sampleValid(root.member("live")));
+
+    // The heap figures and the task list are those of the system.
+    CHECK_EQ(root.member("live")->member("heap")->member("free")->number, (double)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    CHECK_EQ(root.member("live")->member("heap")->member("min")->number, (double)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    CHECK_EQ(root.member("live")->member("heap")->member("largest")->number, (double)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    CHECK_EQ(root.member("live")->member("tasks")->items.size(), (size_t)uxTaskGetNumberOfTasks());
+    for(const t_json &entry : root.member("live")->member("tasks")->items)
+    {
+        if(entry.member("name")->text == "metricsProbe")
+            CHECK_EQ(entry.member("stackFree")->number, (double)uxTaskGetStackHighWaterMark(task));
+    }
+}
+
+// Every value lands in the bucket of the bits needed to hold it, 0 in bucket 0 and from 2^14 up in the last bucket.
+TEST_CASE(bucketIsLog2)
+{
+    // Locals.
+    //
+    std::mt19937                        rng(0x5EED0048);
+    uint32_t                            wrong = 0;
+    uint32_t                            value;
+
+    CHECK_EQ(Metrics::bucket(0), 0u);
+    CHECK_EQ(Metrics::bucket(1), 1u);
+    for(uint32_t bits = 1; bits < METRICS_HIST_BUCKETS - 1; bits++)
+    {
+        CHECK_EQ(Metrics::bucket(1u << (bits - 1)), bits);
+        CHECK_EQ(Metrics::bucket((1u << bits) - 1), bits);
+    }
+    CHECK_EQ(Metrics::bucket(1u << (METRICS_HIST_BUCKETS - 2)), (uint32_t)METRICS_HIST_BUCKETS - 1);
+    CHECK_EQ(Metrics::bucket(0xFFFFFFFF), (uint32_t)METRICS_HIST_BUCKETS - 1);
+
+    for(value = 0; value < (1u << 20); value++)
+        wrong += (Metrics::bucket(value) != referenceBucket(value));
+    for(int idx = 0; idx < 1000000; idx++)
+    {
+        value = rng() >> (rng() % 32);
+        wrong += (Metrics::bucket(value) != referenceBucket(value));
+    }
+    CHECK_EQ(wrong, 0u);
+}
+
+// Values recorded in a histogram are counted in their buckets and in no other histogram.
+TEST_CASE(recordedValuesCounted)
+{
+    // Locals.
+    //
+    std::vector<uint32_t>               values = { 0, 1, 2, 3, 4, 100, 1000, 1023, 1024, 16383, 16384, 500000, 0xFFFFFFFF };
+    std::vector<uint32_t>               expected(METRICS_HIST_BUCKETS, 0);
+    t_json                              before = metrics();
+    t_json                              after;
+
+    for(uint32_t value : values)
+    {
+        Metrics::record(Metrics::HIST_KEYMAP, value);
+        expected[referenceBucket(value)]++;
+    }
+    after = metrics();
+    CHECK(minus(histogram(after, "keymap"), histogram(before, "keymap")) == expected);
+    for(const char *name : { "input", "queue", "output", "total" })
+        CHECK(histogram(after, name) == histogram(before, name));
+}
+
+// Records and counts made at once from several threads into the same buckets are all counted, none are lost to a racing update.
+TEST_CASE(concurrentRecordsCounted)
+{
+    // Locals.
+    //
+    std::vector<std::thread>            threads;
+    std::atomic<bool>                   start(false);
+    t_json                              before = metrics();
+    t_json                              after;
+    std::vector<uint32_t>               delta;
+
+    for(int thread = 0; thread < RECORD_THREADS; thread++)
+    {
+        threads.push_back(std::thread([&start](uint32_t value)
+        {
+            while(!start)
+                std::this_thread::yield();
+            for(int idx = 0; idx < RECORDS_PER_THREAD; idx++)
+                Metrics::record(Metrics::HIST_OUTPUT, value);
+            for(int idx = 0; idx < RECORDS_PER_THREAD; idx++)
+                Metrics::count(Metrics::COUNTER_PS2_RESEND);
+        }, 16u << (thread % 2)));
+    }
+    start = true;
+    for(std::thread &thread : threads)
+        thread.join();
+    after = metrics();
+    delta = minus(histogram(after, "output"), histogram(before, "output"));
+    for(uint32_t bkt = 0; bkt < METRICS_HIST_BUCKETS; bkt++)
+        CHECK_EQ(delta[bkt], (uint32_t)(bkt == Metrics::bucket(16) || bkt == Metrics::bucket(32) ? RECORD_THREADS * RECORDS_PER_THREAD / 2 : 0));
+    CHECK_EQ(counter(after, "ps2Resend") - counter(before, "ps2Resend"), (uint32_t)(RECORD_THREADS * RECORDS_PER_THREAD));
+}
+
+// Each counter is reported under its own name.
+TEST_CASE(countersReportedByName)
+{
+    // Locals.
+    //
+    const char                         *names[Metrics::COUNTER_MAX] = { "xmitQueueFull", "rawKeyQueueFull", "keyQueueFull", "ps2Parity", "ps2Resend", "ps2Overrun", "uartRxOverflow" };
+    t_json                              before = metrics();
+    t_json                              after;
+
+    for(int idx = 0; idx < Metrics::COUNTER_MAX; idx++)
+        for(int cnt = 0; cnt <= idx; cnt++)
+            Metrics::count((enum Metrics::COUNTER)idx);
+    after = metrics();
+    for(int idx = 0; idx < Metrics::COUNTER_MAX; idx++)
+        CHECK_EQ(counter(after, names[idx]) - counter(before, names[idx]), (uint32_t)(idx + 1));
+}
+
+// A task CPU share is of the run time of all cores, the run time counter and the uptime both run from the system timer.
+TEST_CASE(cpuShareOfAllCores)
+{
+    // Locals.
+    //
+    std::atomic<bool>                   spun(false);
+    t_json                              root;
+    double                              expected;
+
+    xTaskCreate([](void *arg)
+    {
+        // Locals.
+        //
+        struct timespec                 cpuTime;
+
+        do {
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+        } while(cpuTime.tv_sec * 1000 + cpuTime.tv_nsec / 1000000 < CPU_SPIN_MS);
+        *(std::atomic<bool> *)arg = true;
+        for(;;) vTaskDelay(1000);
+    }, "metricsSpin", 4096, &spun, 5, NULL);
+    while(!spun)
+        vTaskDelay(10);
+
+    root = metrics();
+    for(const t_json &task : root.member("live")->member("tasks")->items)
+    {
+        if(task.member("name")->text == "metricsSpin")
+        {
+            expected = task.member("runTime")->number * 100.0 / (root.member("live")->member("uptimeMs")->number * 1000.0 * portNUM_PROCESSORS);
+            CHECK(task.member("runTime")->number >= CPU_SPIN_MS * 1000);
+            CHECK(std::abs(task.member("cpu")->number - expected) <= expected * 0.05 + 0.1);
+        }
+    }
+}
+
+// A registered queue reports its depth, the deepest it has been seen and its size. A queue without a handle is not registered, only
+// the first METRICS_MAX_QUEUES are and names are cut to fit.
+TEST_CASE(queueDepthsReported)
+{
+    // Locals.
+    //
+    QueueHandle_t                       xmitQueue = xQueueCreate(10, sizeof(uint32_t));
+    uint32_t                            item = 0;
+    t_json                              root;
+
+    Metrics::addQueue("nullQueue", NULL);
+    Metrics::addQueue("xmitQueue", xmitQueue);
+    for(int idx = 0; idx < 3; idx++)
+        xQueueSend(xmitQueue, &item, 0);
+    root = metrics();
+    if(CHECK(queue(root, "xmitQueue") != NULL))
+    {
+        CHECK_EQ(queue(root, "xmitQueue")->member("depth")->number, 3.0);
+        CHECK_EQ(queue(root, "xmitQueue")->member("peak")->number, 3.0);
+        CHECK_EQ(queue(root, "xmitQueue")->member("size")->number, 10.0);
+    }
+    xQueueReceive(xmitQueue, &item, 0);
+    xQueueReceive(xmitQueue, &item, 0);
+    root = metrics();
+    CHECK_EQ(queue(root, "xmitQueue")->member("depth")->number, 1.0);
+    CHECK_EQ(queue(root, "xmitQueue")->member("peak")->number, 3.0);
+    CHECK(queue(root, "nullQueue") == NULL);
+
+    for(const char *name : { "rawKeyQueue", "keyQueue", "queueWithALongName", "queueFive" })
+        Metrics::addQueue(name, xQueueCreate(4, sizeof(uint32_t)));
+    root = metrics();
+    CHECK_EQ(root.member("live")->member("queues")->items.size(), (size_t)METRICS_MAX_QUEUES);
+    CHECK(queue(root, "queueWithALongN") != NULL);
+    CHECK(queue(root, "queueFive") == NULL);
+    CHECK(sampleValid(root.member("live")));
+}
+
+// A commit retains the sample for the web page, later activity changes the live figures but not the retained sample until the next commit.
+TEST_CASE(commitRetainsSample)
+{
+    // Locals.
+    //
+    t_json                              committed;
+    t_json                              later;
+
+    Metrics::count(Metrics::COUNTER_PS2_OVERRUN);
+    Metrics::commit();
+    committed = metrics();
+    CHECK(sampleValid(committed.member("interface")));
+    CHECK_EQ(counter(committed, "ps2Overrun", "interface"), counter(committed, "ps2Overrun"));
+
+    Metrics::count(Metrics::COUNTER_PS2_OVERRUN);
+    Metrics::record(Metrics::HIST_TOTAL, 5000);
+    later = metrics();
+    CHECK_EQ(counter(later, "ps2Overrun", "interface"), counter(committed, "ps2Overrun", "interface"));
+    CHECK_EQ(counter(later, "ps2Overrun"), counter(committed, "ps2Overrun") + 1);
+    CHECK(later.member("interface")->member("histograms")->member("total")->items[Metrics::bucket(5000)].number ==
+          committed.member("interface")->member("histograms")->member("total")->items[Metrics::bucket(5000)].number);
+
+    Metrics::commit();
+    CHECK_EQ(counter(metrics(), "ps2Overrun", "interface"), counter(later, "ps2Overrun"));
+}
+
+// Sampling for the page is cheap enough to serve on every poll.
+TEST_CASE(jsonBenchmark)
+{
+    // Locals.
+    //
+    size_t                              length = 0;
+
+    TestRunner::benchmark("Metrics::json", 2000, [&](uint32_t) { length += Metrics::json().size(); });
+    CHECK(length > 0);
+    TestRunner::benchmark("Metrics::record", 10000000, [](uint32_t idx) { Metrics::record(Metrics::HIST_QUEUE, idx); });
+}
+
+// Each stage records the time since the previous one and starts the next, a stage with no start has no timestamp and is not recorded.
+TEST_CASE(stagesTimedInTurn)
+{
+    // Locals.
+    //
+    const int64_t                       stageUs[Metrics::HIST_TOTAL] = { 300, 40, 5000, 2 };
+    t_json                              before = metrics();
+    t_json                              after;
+    uint32_t                            start;
+    uint32_t                            time;
+    std::vector<uint32_t>               expected;
+    const char                         *name;
+
+    Shim::freezeTime();
+    start = time = Metrics::now();
+    for(int idx = 0; idx < Metrics::HIST_TOTAL; idx++)
+    {
+        Shim::advanceTime(stageUs[idx]);
+        CHECK_EQ(time = Metrics::stage((enum Metrics::HISTOGRAM)idx, time), Metrics::now());
+    }
+    Metrics::record(Metrics::HIST_TOTAL, time - start);
+    CHECK_EQ(Metrics::stage(Metrics::HIST_INPUT, 0), Metrics::now());
+    after = metrics();
+
+    for(int idx = 0; idx < Metrics::HIST_MAX; idx++)
+    {
+        expected.assign(METRICS_HIST_BUCKETS, 0);
+        expected[Metrics::bucket(idx < Metrics::HIST_TOTAL ? stageUs[idx] : 300 + 40 + 5000 + 2)] = 1;
+        name = before.member("live")->member("histograms")->names[idx].c_str();
+        CHECK(minus(histogram(after, name), histogram(before, name)) == expected);
+    }
+    Shim::releaseTime();
+}
+
+// Timestamps are the 32 bit microsecond timer. A stage spanning the wrap is timed correctly and zero, which means no timestamp, is never
+// returned. Run last as the clock is left past the wrap.
+TEST_CASE(stageAcrossTimerWrap)
+{
+    // Locals.
+    //
+    t_json                              before = metrics();
+    t_json                              after;
+    uint32_t                            start;
+
+    Shim::freezeTime();
+    Shim::advanceTime((1LL << 32) - (esp_timer_get_time() & 0xFFFFFFFF) - 100);
+    start = Metrics::now();
+    CHECK_EQ(start, 0xFFFFFFFF - 99);
+    Shim::advanceTime(100);
+    CHECK_EQ((uint32_t)esp_timer_get_time(), 0u);
+    CHECK_EQ(Metrics::now(), 1u);
+    Shim::advanceTime(150);
+    CHECK_EQ(Metrics::stage(Metrics::HIST_QUEUE, start), 150u);
+    after = metrics();
+    CHECK_EQ(histogram(after, "queue")[Metrics::bucket(250)] - histogram(before, "queue")[Metrics::bucket(250)], 1u);
+    CHECK(histogram(after, "queue")[METRICS_HIST_BUCKETS - 1] == histogram(before, "queue")[METRICS_HIST_BUCKETS - 1]);
+    Shim::releaseTime();
+}
+
+TEST_MAIN()
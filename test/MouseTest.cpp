@@ -0,0 +1,558 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            MouseTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the mouse pipeline. A stand-in PS/2 mouse on the clock and data lines streams
+//                  synthetic packets far faster than a real mouse and a stand-in Sharp host strobes MSCTRL
+//                  and reads the packets from the UART, so movement travels PS2Mouse, HID and Mouse as on
+//                  the target. The displacement the host sees is checked against the displacement sent.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "NVS.h"
+#include "LED.h"
+#include "SWITCH.h"
+#include "HID.h"
+#include "Mouse.h"
+#include "TimerService.h"
+#include "driver/uart.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // Stand-in PS/2 mouse. Host writes are clocked in and acknowledged as a mouse would, the self test result after a reset is left out as the
+    // driver does not wait for it. Once reporting is enabled queued movement is sent as standard 3 byte packets, back to back.
+    class StandInMouse
+    {
+        public:
+            struct t_move
+            {
+                int                     dx;
+                int                     dy;
+                uint8_t                 buttons;
+            };
+
+            StandInMouse(void)
+            {
+                reporting = false;
+                commands  = 0;
+                lastCommand = std::chrono::steady_clock::now();
+                std::thread(&StandInMouse::run, this).detach();
+            }
+
+            // Queue movement for the mouse to report.
+            void move(const std::vector<t_move> &moves)
+            {
+                std::lock_guard<std::mutex> lk(lock);
+                pending.insert(pending.end(), moves.begin(), moves.end());
+            }
+
+            // Wait until every queued packet has been clocked out.
+            bool drained(uint32_t timeoutMs = 5000)
+            {
+                // Locals.
+                //
+                auto                    end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+                while(std::chrono::steady_clock::now() < end)
+                {
+                    {
+                        std::lock_guard<std::mutex> lk(lock);
+                        if(pending.empty() && sending == false)
+                            return(true);
+                    }
+                    Shim::settle(1);
+                }
+                return(false);
+            }
+
+            // Wait until the driver has finished configuring the mouse, reporting enabled and no command for the given time.
+            bool configured(uint32_t quietMs = 500, uint32_t timeoutMs = 10000)
+            {
+                // Locals.
+                //
+                auto                    end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+                while(std::chrono::steady_clock::now() < end)
+                {
+                    {
+                        std::lock_guard<std::mutex> lk(lock);
+                        if(reporting && std::chrono::steady_clock::now() - lastCommand > std::chrono::milliseconds(quietMs))
+                            return(true);
+                    }
+                    Shim::settle(10);
+                }
+                return(false);
+            }
+
+            std::atomic<bool>           reporting;
+            std::atomic<uint32_t>       commands;
+
+        private:
+            // One clock pulse, the driver interrupts on the falling edge.
+            void clockPulse(void)
+            {
+                Shim::setInput(CONFIG_PS2_HW_CLKPIN, 0);
+                Shim::setInput(CONFIG_PS2_HW_CLKPIN, 1);
+            }
+
+            // Clock a byte out to the driver, start bit, 8 data bits LSB first, odd parity and stop bit.
+            void sendByte(uint8_t data)
+            {
+                // Locals.
+                //
+                int                     parity = 1;
+
+                Shim::setInput(CONFIG_PS2_HW_DATAPIN, 0);
+                clockPulse();
+                for(int bit = 0; bit < 8; bit++)
+                {
+                    Shim::setInput(CONFIG_PS2_HW_DATAPIN, (data >> bit) & 1);
+                    parity ^= (data >> bit) & 1;
+                    clockPulse();
+                }
+                Shim::setInput(CONFIG_PS2_HW_DATAPIN, parity);
+                clockPulse();
+                Shim::setInput(CONFIG_PS2_HW_DATAPIN, 1);
+                clockPulse();
+            }
+
+            // Clock in a byte the driver is sending, the data line is sampled after each rising edge, then pull data low for the acknowledge.
+            uint8_t receiveByte(void)
+            {
+                // Locals.
+                //
+                uint8_t                 data = 0;
+
+                // The driver reattaches its interrupt after releasing the clock.
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                for(int bit = 0; bit < 8; bit++)
+                {
+                    clockPulse();
+                    data |= Shim::getLevel(CONFIG_PS2_HW_DATAPIN) << bit;
+                }
+                clockPulse();
+                clockPulse();
+                Shim::setInput(CONFIG_PS2_HW_DATAPIN, 0);
+                clockPulse();
+                Shim::setInput(CONFIG_PS2_HW_DATAPIN, 1);
+                return(data);
+            }
+
+            // Act on a command or its parameter and reply.
+            void command(uint8_t cmd)
+            {
+                // Locals.
+                //
+                std::vector<uint8_t>    reply = { PS2Mouse::MOUSE_RESP_ACK };
+
+                if(parameter)
+                {
+                    parameter = false;
+                } else
+                {
+                    switch(cmd)
+                    {
+                        case PS2Mouse::MOUSE_CMD_RESET:
+                        case PS2Mouse::MOUSE_CMD_DISABLE_STREAMING:
+                            reporting = false;
+                            break;
+                        case PS2Mouse::MOUSE_CMD_ENABLE_STREAMING:
+                            reporting = true;
+                            break;
+                        case PS2Mouse::MOUSE_CMD_GET_DEVICE_ID:
+                            reply.push_back(0x00);
+                            break;
+                        case PS2Mouse::MOUSE_CMD_SET_SAMPLE_RATE:
+                        case PS2Mouse::MOUSE_CMD_SET_RESOLUTION:
+                            parameter = true;
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                for(uint8_t data : reply)
+                    sendByte(data);
+                std::lock_guard<std::mutex> lk(lock);
+                lastCommand = std::chrono::steady_clock::now();
+                commands++;
+            }
+
+            void run(void)
+            {
+                // Locals.
+                //
+                t_move                  next;
+
+                for(;;)
+                {
+                    // A host write is signalled by data pulled low with the clock released.
+                    if(Shim::getLevel(CONFIG_PS2_HW_DATAPIN) == 0 && Shim::getLevel(CONFIG_PS2_HW_CLKPIN) == 1)
+                    {
+                        command(receiveByte());
+                        continue;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lk(lock);
+                        sending = reporting && pending.empty() == false;
+                        if(sending)
+                        {
+                            next = pending.front();
+                            pending.pop_front();
+                        }
+                    }
+                    if(sending)
+                    {
+                        sendByte(0x08 | next.buttons | (next.dx < 0 ? 0x10 : 0x00) | (next.dy < 0 ? 0x20 : 0x00));
+                        sendByte(next.dx & 0xFF);
+                        sendByte(next.dy & 0xFF);
+                        std::lock_guard<std::mutex> lk(lock);
+                        sending = false;
+                    } else
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    }
+                }
+            }
+
+            std::mutex                  lock;
+            std::deque<t_move>          pending;
+            bool                        sending = false;
+            bool                        parameter = false;
+            std::chrono::steady_clock::time_point lastCommand;
+    };
+
+    // Stand-in Sharp host, strobes MSCTRL and reads the packet sent in reply, keeping the running displacement.
+    struct t_sharpHost
+    {
+        int32_t                         x = 0;
+        int32_t                         y = 0;
+        uint32_t                        packets = 0;
+        uint8_t                         lastStatus = 0;
+        bool                            inRange = true;
+
+        // Request one packet, false if the interface does not answer.
+        bool request(void)
+        {
+            // Locals.
+            //
+            uint8_t                     buf[3];
+            size_t                      rcvCnt = 0;
+            ssize_t                     len;
+            struct pollfd               pfd = { Shim::uartHostFd(UART_NUM_1), POLLIN, 0 };
+
+            Shim::setInput(CONFIG_HOST_KDB0, 0);
+            while(rcvCnt < sizeof(buf) && poll(&pfd, 1, 500) > 0 && (len = read(pfd.fd, buf + rcvCnt, sizeof(buf) - rcvCnt)) > 0)
+                rcvCnt += len;
+            Shim::setInput(CONFIG_HOST_KDB0, 1);
+            if(rcvCnt != sizeof(buf))
+                return(false);
+            lastStatus = buf[0];
+            x         += (int8_t)buf[1];
+            y         += (int8_t)buf[2];
+            inRange   &= (buf[0] & 0xF0) == 0;
+            packets++;
+            return(true);
+        }
+
+        // Request packets until the interface has no movement left to send.
+        bool drain(void)
+        {
+            // Locals.
+            //
+            int                         idle = 0;
+            int32_t                     lastX;
+            int32_t                     lastY;
+
+            // Let the HID thread collect the last of the movement.
+            Shim::settle(3 * HID_MOUSE_DATA_POLL_DELAY);
+            while(idle < 3)
+            {
+                lastX = x;
+                lastY = y;
+                if(request() == false)
+                    return(false);
+                idle = (x == lastX && y == lastY) ? idle + 1 : 0;
+            }
+            return(true);
+        }
+    };
+
+    struct t_rig
+    {
+        NVS                             nvs;
+        LED                            *led;
+        SWITCH                         *sw;
+        StandInMouse                   *ps2;
+        HID                            *hid;
+        Mouse                          *mouse;
+    };
+
+    // The pipeline, brought up once in the order app_main does for a mouse host with the stand-in mouse plugged in.
+    t_rig &rig(void)
+    {
+        // Locals.
+        //
+        static t_rig                   *instance = NULL;
+
+        if(instance == NULL)
+        {
+            instance = new t_rig;
+            instance->led = new LED(CONFIG_PWRLED);
+            TimerService::getInstance();
+            instance->nvs.init();
+            instance->nvs.open("SharpKey");
+            instance->sw    = new SWITCH(instance->led);
+            instance->ps2   = new StandInMouse();
+            instance->hid   = new HID(HID::HID_DEVICE_TYPE_MOUSE, &instance->nvs, instance->led, instance->sw);
+            instance->mouse = new Mouse(2, &instance->nvs, instance->led, instance->hid, false);
+            instance->hid->setMouseHostScaling(HID::HID_MOUSE_HOST_SCALING_1_1);
+            instance->hid->setMouseHostAcceleration(HID::HID_MOUSE_HOST_ACCEL_OFF);
+        }
+        return(*instance);
+    }
+
+    // Bring up the pipeline and empty it of earlier movement, false if the mouse was never configured.
+    bool ready(t_sharpHost &host)
+    {
+        // Locals.
+        //
+        t_rig                          &pipe = rig();
+
+        if(pipe.ps2->configured() == false || host.drain() == false)
+            return(false);
+        host.x = host.y = 0;
+        host.packets = 0;
+        return(true);
+    }
+
+    // Run a mouse line tool and return its output, one string per line.
+    std::vector<std::string> lineTool(const std::string &tool, int packets, int seed)
+    {
+        // Locals.
+        //
+        std::vector<std::string>        lines;
+        char                            line[256];
+        FILE                           *toolOut = popen((tool + " " + std::to_string(packets) + " " + std::to_string(seed) + " 2>/dev/null").c_str(), "r");
+
+        while(toolOut != NULL && fgets(line, sizeof(line), toolOut) != NULL)
+            lines.push_back(std::string(line, strcspn(line, "\n")));
+        if(toolOut != NULL)
+            pclose(toolOut);
+        return(lines);
+    }
+
+    // Random movement in the full 9 bit PS/2 range with the position kept within +/-limit, so the interface accumulator never saturates.
+    std::vector<StandInMouse::t_move> randomMoves(uint32_t count, int limit, int32_t &sumX, int32_t &sumY)
+    {
+        // Locals.
+        //
+        std::vector<StandInMouse::t_move> moves;
+        int                             dx;
+        int                             dy;
+
+        for(uint32_t idx = 0; idx < count; idx++)
+        {
+            dx = (rand() % 512) - 256;
+            dy = (rand() % 512) - 256;
+            dx = (sumX + dx > limit || sumX + dx < -limit) ? -dx : dx;
+            dy = (sumY + dy > limit || sumY + dy < -limit) ? -dy : dy;
+            dx = dx > 255 ? 255 : dx;
+            dy = dy > 255 ? 255 : dy;
+            sumX += dx;
+            sumY += dy;
+            moves.push_back({ dx, dy, (uint8_t)(rand() & 0x03) });
+        }
+        return(moves);
+    }
+}
+
+// The driver configures the mouse and enables reporting, the mouse is left in streaming mode.
+TEST_CASE(mouseConfigured)
+{
+    // Locals.
+    //
+    t_rig                              &pipe = rig();
+
+    CHECK(pipe.ps2->configured());
+    CHECK(pipe.ps2->commands > 0);
+    CHECK(pipe.ps2->reporting);
+}
+
+// Packets sent far faster than the HID poll and the host strobe are summed, not dropped, so the host sees the full displacement.
+TEST_CASE(highRatePacketsPreserveDisplacement)
+{
+    // Locals.
+    //
+    t_sharpHost                         host;
+    int32_t                             sumX = 0;
+    int32_t                             sumY = 0;
+    std::atomic<bool>                   streaming(true);
+    std::thread                         strobe;
+
+    srand(26);
+    if(CHECK(ready(host)) == false)
+        return;
+
+    // The host strobes every 2ms whilst the mouse streams, the HID polls every 10ms, so dozens of packets are coalesced per read.
+    strobe = std::thread([&](void) { while(streaming) { host.request(); std::this_thread::sleep_for(std::chrono::milliseconds(2)); } });
+    for(int burst = 0; burst < 10; burst++)
+    {
+        rig().ps2->move(randomMoves(2000, 2000, sumX, sumY));
+        CHECK(rig().ps2->drained());
+    }
+    streaming = false;
+    strobe.join();
+    CHECK(host.drain());
+
+    // Y is inverted on the Sharp host.
+    CHECK_EQ(host.x, sumX);
+    CHECK_EQ(host.y, -sumY);
+    CHECK(host.inRange);
+}
+
+// A movement larger than a host packet is split over several packets, each within the 8 bit host range, with none of it lost.
+TEST_CASE(largeMovementSplitIntoHostPackets)
+{
+    // Locals.
+    //
+    t_sharpHost                         host;
+    std::vector<StandInMouse::t_move>   moves(30, { 255, -200, 0x00 });
+    int32_t                             lastX;
+
+    if(CHECK(ready(host)) == false)
+        return;
+
+    rig().ps2->move(moves);
+    CHECK(rig().ps2->drained());
+    Shim::settle(3 * HID_MOUSE_DATA_POLL_DELAY);
+
+    // The whole movement is waiting, the host sees full scale packets until the remainder.
+    lastX = host.x;
+    CHECK(host.request());
+    CHECK_EQ(host.x - lastX, 127);
+    CHECK(host.drain());
+    CHECK_EQ(host.x, 30 * 255);
+    CHECK_EQ(host.y, 30 * 200);
+    CHECK(host.packets >= (30 * 255) / 127);
+}
+
+// A click shorter than the host strobe period is latched until the host has seen it, the release follows in the next packet.
+TEST_CASE(shortClickLatched)
+{
+    // Locals.
+    //
+    t_sharpHost                         host;
+
+    if(CHECK(ready(host)) == false)
+        return;
+
+    rig().ps2->move({ { 1, 0, 0x01 }, { 0, 0, 0x00 }, { -1, 0, 0x02 }, { 0, 0, 0x00 } });
+    CHECK(rig().ps2->drained());
+    Shim::settle(3 * HID_MOUSE_DATA_POLL_DELAY);
+    CHECK(host.request());
+    CHECK_EQ(host.lastStatus & 0x03, 0x03);
+    CHECK(host.request());
+    CHECK_EQ(host.lastStatus & 0x03, 0x00);
+    CHECK_EQ(host.x, 0);
+}
+
+// Only the button bits are sent, PS/2 status bit 3 is always set by the mouse but an idle packet after movement is all zero.
+TEST_CASE(idlePacketAfterMovementClear)
+{
+    // Locals.
+    //
+    t_sharpHost                         host;
+
+    if(CHECK(ready(host)) == false)
+        return;
+
+    rig().ps2->move({ { 5, -3, 0x00 }, { 2, 1, 0x04 }, { 0, 0, 0x00 } });
+    CHECK(rig().ps2->drained());
+    CHECK(host.drain());
+    CHECK(host.request());
+    CHECK_EQ(host.lastStatus, 0x00);
+}
+
+// The hardware UART puts the same frames on MSDATA as the bitbang transport, bit for bit, and the inverted UART their complement. Each frame
+// is a low start bit, the byte LSB first and two high stop bits, and each packet carries the buttons and movement given to the interface.
+TEST_CASE(uartFramesMatchBitbang)
+{
+    // Locals.
+    //
+    const int                           PACKETS = 48;
+    std::vector<std::string>            uart    = lineTool(MOUSE_LINE_UART_TOOL, PACKETS, 28);
+    std::vector<std::string>            invert  = lineTool(MOUSE_LINE_INVERT_TOOL, PACKETS, 28);
+    std::vector<std::string>            bitbang = lineTool(MOUSE_LINE_BITBANG_TOOL, PACKETS, 28);
+    std::string                         complement;
+    unsigned int                        expected[3];
+    uint32_t                            frames = 0;
+    uint32_t                            byteIdx = 3;
+    uint8_t                             data;
+
+    if(CHECK_EQ(uart.size(), (size_t)PACKETS * 4) == false || CHECK_EQ(bitbang.size(), uart.size()) == false || CHECK_EQ(invert.size(), uart.size()) == false)
+        return;
+    for(size_t idx = 0; idx < uart.size(); idx++)
+    {
+        CHECK(bitbang[idx] == uart[idx]);
+        if(sscanf(uart[idx].c_str(), "packet %x %x %x", &expected[0], &expected[1], &expected[2]) == 3)
+        {
+            CHECK(invert[idx] == uart[idx]);
+            CHECK_EQ(byteIdx, 3u);
+            byteIdx = 0;
+            continue;
+        }
+        complement = uart[idx];
+        for(char &level : complement)
+            level = level == '0' ? '1' : '0';
+        CHECK(invert[idx] == complement);
+
+        // <Start><D0..D7><Stop><Stop>
+        if(CHECK_EQ(uart[idx].size(), (size_t)11) == false || byteIdx >= 3)
+            continue;
+        data = 0;
+        for(int bit = 0; bit < 8; bit++)
+            data |= (uart[idx][1 + bit] == '1') << bit;
+        CHECK_EQ(uart[idx][0], '0');
+        CHECK(uart[idx].substr(9) == "11");
+        CHECK_EQ(data, (uint8_t)expected[byteIdx++]);
+        frames++;
+    }
+    CHECK_EQ(frames, (uint32_t)PACKETS * 3);
+}
+
+TEST_MAIN()
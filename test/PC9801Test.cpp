@@ -0,0 +1,386 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            PC9801Test.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the PC-9801 host protocol. The host UART is a pty and a scripted stand-in
+//                  PC-9801 on its far side sends commands, checks each reply and asserts /RST as a line
+//                  break, whilst the stand-in BT keyboard holds keys and records the LED reports it is
+//                  sent.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//                  Oct 2026 - Key latency stage test.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "PC9801.h"
+#include "HostHarness.h"
+#include "TestRunner.h"
+
+namespace
+{
+    #define PC9801_UART                 UART_NUM_2
+    #define PC9801_BREAK                0x80
+    #define BT_MOD_L_SHIFT              0x02
+    #define REPLY_WAIT_MS               200
+    #define REPLY_QUIET_MS              30
+    #define LATENCY_TAPS                10
+
+    // One exchange of the stand-in host, the bytes it sends and the reply it expects. A step sending nothing asserts /RST.
+    struct t_step
+    {
+        std::vector<uint8_t>            send;
+        std::vector<uint8_t>            expect;
+    };
+
+    // The stand-in host's scripts. The boot script is the host identifying the keyboard after a reset, reading then clearing the
+    // LEDs and setting the repeat rate.
+    const std::vector<t_step>           bootScript  = { { {},           {} },
+                                                        { { 0x9F },     { 0xFA, 0xA0, 0x80 } },
+                                                        { { 0x96 },     { 0xFA, 0xA0, 0x86 } },
+                                                        { { 0x9D, 0x60 }, { 0xFA, 0xFA, 0x70 } },
+                                                        { { 0x9D, 0x70 }, { 0xFA, 0xFA } },
+                                                        { { 0x95, 0x03 }, { 0xFA, 0xFA } },
+                                                        { { 0x9C, 0x30 }, { 0xFA, 0xFA } } };
+    const std::vector<t_step>           nackScript  = { { { 0x90 },     { 0xFC } },
+                                                        { { 0xF3 },     { 0xFC } },
+                                                        { { 0x9D, 0x30 }, { 0xFA, 0xFC } },
+                                                        { { 0x9C, 0x80 }, { 0xFA, 0xFC } },
+                                                        { { 0x12, 0x40, 0x41 }, {} },
+                                                        { { 0x9F },     { 0xFA, 0xA0, 0x80 } } };
+    // A key code received by the host and when, in milli-seconds from the start of the capture.
+    struct t_rcvKey
+    {
+        uint8_t                         code;
+        double                          atMs;
+    };
+
+    // The interface under test, created once as it owns the host UART.
+    PC9801 &pc9801(void)
+    {
+        // Locals.
+        //
+        static PC9801                  *instance = NULL;
+        HostHarness::t_host            &host = HostHarness::host();
+
+        if(instance == NULL)
+        {
+            instance = new PC9801(0, &host.nvs, host.led, host.hid, host.fsPath.c_str());
+            Shim::settle(100);
+        }
+        return(*instance);
+    }
+
+    // Bytes the host receives over the given period, timed from the start of the capture. With stopAfter set the capture ends once
+    // that many bytes have arrived and the line has then been quiet.
+    std::vector<t_rcvKey> hostCapture(int periodMs, std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now(), size_t stopAfter = 0)
+    {
+        // Locals.
+        //
+        struct pollfd                   pfd = { Shim::uartHostFd(PC9801_UART), POLLIN, 0 };
+        std::vector<t_rcvKey>           keys;
+        uint8_t                         buf[64];
+        ssize_t                         rcvCnt;
+        double                          atMs;
+        double                          lastMs = 0.0;
+
+        while((atMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) < periodMs)
+        {
+            if(poll(&pfd, 1, 1) > 0 && (rcvCnt = read(pfd.fd, buf, sizeof(buf))) > 0)
+            {
+                for(ssize_t idx = 0; idx < rcvCnt; idx++)
+                    keys.push_back({ buf[idx], atMs });
+                lastMs = atMs;
+            }
+            if(stopAfter != 0 && keys.size() >= stopAfter && atMs - lastMs >= REPLY_QUIET_MS)
+                break;
+        }
+        return(keys);
+    }
+
+    std::vector<uint8_t> codes(const std::vector<t_rcvKey> &keys)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            result;
+
+        for(const t_rcvKey &key : keys)
+            result.push_back(key.code);
+        return(result);
+    }
+
+    // Play a script as the host, returning the index of the first step whose reply differs from that expected or -1 if all match.
+    int hostScript(const std::vector<t_step> &script)
+    {
+        pc9801();
+        for(size_t idx = 0; idx < script.size(); idx++)
+        {
+            if(script[idx].send.empty())
+            {
+                Shim::uartBreak(PC9801_UART);
+                Shim::settle(PC9801_HID_POLL_MS * 3);
+            } else
+            if(write(Shim::uartHostFd(PC9801_UART), script[idx].send.data(), script[idx].send.size()) != (ssize_t)script[idx].send.size())
+            {
+                return((int)idx);
+            }
+            if(codes(hostCapture(script[idx].expect.empty() ? REPLY_QUIET_MS * 2 : REPLY_WAIT_MS, std::chrono::steady_clock::now(),
+                                 script[idx].expect.size())) != script[idx].expect)
+            {
+                return((int)idx);
+            }
+        }
+        return(-1);
+    }
+
+    // Hold the given keys for the period, returning what the host received from the press up to and including the release.
+    std::vector<t_rcvKey> holdKeys(uint8_t modifiers, const std::set<uint8_t> &btKeys, int holdMs)
+    {
+        // Locals.
+        //
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<t_rcvKey>           keys;
+        std::vector<t_rcvKey>           released;
+
+        pc9801();
+        HostHarness::keyReport(modifiers, btKeys);
+        keys = hostCapture(holdMs, start);
+        HostHarness::keyReport(0x00, {});
+        released = hostCapture(holdMs + 150, start);
+        keys.insert(keys.end(), released.begin(), released.end());
+        return(keys);
+    }
+
+    // The LED report most recently sent to the stand-in keyboard, waiting for the HID thread to forward a change.
+    uint8_t keyboardLEDs(uint32_t sentBefore)
+    {
+        // Locals.
+        //
+        esp_hidh_dev_t                 *keyboard = HostHarness::host().keyboard;
+
+        for(int waited = 0; waited < 500 && Shim::hidhOutputCount(keyboard) == sentBefore; waited += 5)
+            Shim::settle(5);
+        return(Shim::hidhOutput(keyboard).empty() ? 0xFF : Shim::hidhOutput(keyboard)[0]);
+    }
+
+    uint32_t ledReports(void)
+    {
+        return(Shim::hidhOutputCount(HostHarness::host().keyboard));
+    }
+
+    // The gaps between successive makes of a code, the first being the repeat delay.
+    std::vector<double> repeatGaps(const std::vector<t_rcvKey> &keys, uint8_t code)
+    {
+        // Locals.
+        //
+        std::vector<double>             gaps;
+        double                          lastMs = -1.0;
+
+        for(const t_rcvKey &key : keys)
+        {
+            if(key.code != code)
+                continue;
+            if(lastMs >= 0.0)
+                gaps.push_back(key.atMs - lastMs);
+            lastMs = key.atMs;
+        }
+        return(gaps);
+    }
+
+    double median(std::vector<double> values)
+    {
+        if(values.empty())
+            return(0.0);
+        std::sort(values.begin(), values.end());
+        return(values[values.size() / 2]);
+    }
+}
+
+// The host boots, identifies the keyboard and sets it up, each command acknowledged and each query answered.
+TEST_CASE(hostBootHandshake)
+{
+    CHECK_EQ(hostScript(bootScript), -1);
+    CHECK(codes(holdKeys(0x00, { BT_KEY_A }, 100)) == std::vector<uint8_t>({ PC9801_KEY_A, PC9801_KEY_A | PC9801_BREAK }));
+}
+
+// Replies come from the interface thread as soon as the command arrives, not on the HID thread's poll.
+TEST_CASE(replyLatency)
+{
+    // Locals.
+    //
+    std::chrono::steady_clock::time_point start;
+    std::vector<t_rcvKey>               reply;
+    std::vector<double>                 latency;
+    const uint8_t                       identify = PC9801_HOSTCMD_IDENTIFY;
+
+    pc9801();
+    for(int idx = 0; idx < 20; idx++)
+    {
+        start = std::chrono::steady_clock::now();
+        CHECK_EQ(write(Shim::uartHostFd(PC9801_UART), &identify, 1), 1);
+        reply = hostCapture(REPLY_WAIT_MS, start, 3);
+        if(CHECK_EQ(reply.size(), 3u))
+            latency.push_back(reply.back().atMs);
+    }
+    CHECK(median(latency) < 5.0);
+}
+
+// Unknown commands and bad parameters are refused and leave the link ready for the next command, bytes which are not commands are
+// noise on the shared /RST line and get no reply.
+TEST_CASE(badCommandsRefused)
+{
+    CHECK_EQ(hostScript(nackScript), -1);
+}
+
+// CAPS and KANA drive the keyboard CAPS and SCROLL LEDs, NUM has no keyboard LED. The host reads back the state it set.
+TEST_CASE(ledSetAndRead)
+{
+    // Locals.
+    //
+    uint32_t                            sent;
+    const uint8_t                       leds[][2] = { { 0x74, BT_LED_CAPSLOCK   }, { 0x78, BT_LED_SCROLLLOCK }, { 0x7C, BT_LED_CAPSLOCK | BT_LED_SCROLLLOCK },
+                                                      { 0x71, 0x00              }, { 0x7D, BT_LED_CAPSLOCK | BT_LED_SCROLLLOCK }, { 0x70, 0x00 } };
+
+    for(const uint8_t *led : leds)
+    {
+        sent = ledReports();
+        CHECK_EQ(hostScript({ { { PC9801_HOSTCMD_LED, led[0] }, { PC9801_RESP_ACK, PC9801_RESP_ACK } } }), -1);
+        CHECK_EQ(keyboardLEDs(sent), led[1]);
+        CHECK_EQ(hostScript({ { { PC9801_HOSTCMD_LED, PC9801_LED_READ }, { PC9801_RESP_ACK, PC9801_RESP_ACK, led[0] } } }), -1);
+    }
+}
+
+// A held key repeats at the delay and rate the host sets, the repeats keeping to the rate's cadence. The release ends the repeats.
+TEST_CASE(hostSetsRepeatRate)
+{
+    // Locals.
+    //
+    std::vector<t_rcvKey>               keys;
+    std::vector<double>                 gaps;
+
+    CHECK_EQ(hostScript({ { { 0x9C, 0x62 }, { 0xFA, 0xFA } } }), -1);
+    keys = holdKeys(0x00, { BT_KEY_A }, 600);
+    gaps = repeatGaps(keys, PC9801_KEY_A);
+    if(CHECK(gaps.size() >= 7 && gaps.size() <= 9))
+    {
+        CHECK(std::abs(gaps[0] - 250.0) < 15.0);
+        gaps.erase(gaps.begin());
+        CHECK(std::abs(median(gaps) - 50.0) < 5.0);
+        CHECK_EQ(keys.back().code, PC9801_KEY_A | PC9801_BREAK);
+    }
+    CHECK(hostCapture(300).empty());
+
+    CHECK_EQ(hostScript({ { { 0x9C, 0x21 }, { 0xFA, 0xFA } } }), -1);
+    keys = holdKeys(0x00, { BT_KEY_A }, 700);
+    gaps = repeatGaps(keys, PC9801_KEY_A);
+    if(CHECK(gaps.size() >= 5 && gaps.size() <= 7))
+    {
+        CHECK(std::abs(gaps[0] - 500.0) < 15.0);
+        gaps.erase(gaps.begin());
+        CHECK(std::abs(median(gaps) - 40.0) < 5.0);
+    }
+
+    CHECK_EQ(hostScript({ { { 0x9C, 0x71 }, { 0xFA, 0xFA } } }), -1);
+    keys = holdKeys(0x00, { BT_KEY_A }, 900);
+    gaps = repeatGaps(keys, PC9801_KEY_A);
+    if(CHECK_EQ(gaps.size(), 4u))
+    {
+        CHECK(std::abs(gaps[0] - 250.0) < 15.0);
+        CHECK(std::abs(gaps[1] - 200.0) < 15.0);
+    }
+}
+
+// Modifier keys never repeat.
+TEST_CASE(modifiersDontRepeat)
+{
+    CHECK_EQ(hostScript({ { { 0x9C, 0x62 }, { 0xFA, 0xFA } } }), -1);
+    CHECK(codes(holdKeys(BT_MOD_L_SHIFT, {}, 600)) == std::vector<uint8_t>({ PC9801_KEY_SHIFT, PC9801_KEY_SHIFT | PC9801_BREAK }));
+}
+
+// A host reset part way through a command returns the keyboard to its power on state, the LEDs are cleared, the repeat rate is the
+// default and a key held across the reset stops repeating. The partial command is dropped so the link is in step for the rebooted host.
+TEST_CASE(resetResynchronises)
+{
+    // Locals.
+    //
+    uint32_t                            sent;
+    std::vector<t_rcvKey>               keys;
+    std::vector<double>                 gaps;
+    std::chrono::steady_clock::time_point start;
+
+    CHECK_EQ(hostScript({ { { 0x9D, 0x7C }, { 0xFA, 0xFA } }, { { 0x9C, 0x62 }, { 0xFA, 0xFA } } }), -1);
+    sent = ledReports();
+    CHECK_EQ(hostScript({ { { 0x9D }, { 0xFA } }, { {}, {} }, { { 0x74 }, {} } }), -1);
+    CHECK_EQ(keyboardLEDs(sent), 0x00);
+    CHECK_EQ(hostScript({ { { 0x9D, 0x60 }, { 0xFA, 0xFA, 0x70 } } }), -1);
+
+    // A key held across the reset.
+    CHECK_EQ(hostScript({ { { 0x9C, 0x62 }, { 0xFA, 0xFA } } }), -1);
+    start = std::chrono::steady_clock::now();
+    HostHarness::keyReport(0x00, { BT_KEY_A });
+    keys = hostCapture(400, start);
+    CHECK(repeatGaps(keys, PC9801_KEY_A).size() >= 3);
+    Shim::uartBreak(PC9801_UART);
+    hostCapture(PC9801_HID_POLL_MS * 2);
+    CHECK(hostCapture(300).empty());
+    HostHarness::keyReport(0x00, {});
+    CHECK(codes(hostCapture(100)) == std::vector<uint8_t>({ PC9801_KEY_A | PC9801_BREAK }));
+
+    keys = holdKeys(0x00, { BT_KEY_A }, 800);
+    gaps = repeatGaps(keys, PC9801_KEY_A);
+    if(CHECK(gaps.size() >= 5 && gaps.size() <= 6))
+    {
+        CHECK(std::abs(gaps[0] - PC9801_REPEAT_DELAY_DEFAULT) < 15.0);
+        gaps.erase(gaps.begin());
+        CHECK(std::abs(median(gaps) - PC9801_REPEAT_TIME_DEFAULT) < 5.0);
+    }
+}
+
+// Each key is timed through every stage from the Bluetooth report to the byte sent to the host, repeats through the queue and output only.
+TEST_CASE(keyLatencyRecorded)
+{
+    // Locals.
+    //
+    HostHarness::t_latency              before = HostHarness::latency();
+    std::vector<t_rcvKey>               keys;
+    uint32_t                            hostCodes = 0;
+
+    for(int idx = 0; idx < LATENCY_TAPS; idx++)
+    {
+        keys = holdKeys(0x00, { BT_KEY_A }, 30);
+        CHECK(codes(keys) == std::vector<uint8_t>({ PC9801_KEY_A, PC9801_KEY_A | PC9801_BREAK }));
+        hostCodes += keys.size();
+    }
+    HostHarness::latencyRecorded(before, 2 * LATENCY_TAPS, hostCodes);
+
+    CHECK_EQ(hostScript({ { { 0x9C, 0x62 }, { 0xFA, 0xFA } } }), -1);
+    before = HostHarness::latency();
+    keys = holdKeys(0x00, { BT_KEY_A }, 500);
+    CHECK(keys.size() > 4);
+    HostHarness::latencyRecorded(before, 2, keys.size(), keys.size(), 2);
+}
+
+TEST_MAIN()
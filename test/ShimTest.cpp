@@ -0,0 +1,304 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            ShimTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the host shim itself, the kernel primitives, timers, virtual GPIO, UART and
+//                  NVS must behave as the SharpKey classes expect of the target before the class tests
+//                  can be trusted.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "driver/timer.h"
+#include "driver/uart.h"
+#include "nvs_flash.h"
+#include "Arduino.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    std::vector<int>                    fired;
+
+    void recordTimer(void *arg)
+    {
+        fired.push_back((int)(intptr_t)arg);
+    }
+
+    std::atomic<int>                    isrCount(0);
+
+    void countIsr(void *arg)
+    {
+        isrCount++;
+    }
+
+    QueueHandle_t                       echoQueue;
+
+    void echoTask(void *pvParameters)
+    {
+        // Locals.
+        //
+        int                             value;
+
+        for(;;)
+        {
+            if(xQueueReceive(echoQueue, &value, portMAX_DELAY) == pdTRUE)
+                xTaskNotifyGive((TaskHandle_t)pvParameters);
+        }
+    }
+}
+
+// With the clock frozen a timed wait only ends when the test advances time past its deadline.
+TEST_CASE(frozenClockHoldsTimedWaits)
+{
+    // Locals.
+    //
+    QueueHandle_t                       queue = xQueueCreate(1, sizeof(int));
+    int                                 value = 0;
+    int64_t                             start;
+
+    Shim::freezeTime();
+    start = Shim::now();
+    CHECK(xQueueReceive(queue, &value, 0) == pdFALSE);
+    CHECK_EQ(Shim::now(), start);
+    Shim::advanceTime(5000);
+    CHECK_EQ(Shim::now() - start, 5000);
+    CHECK_EQ(xTaskGetTickCount() - (TickType_t)(start / 1000), (TickType_t)5);
+    Shim::releaseTime();
+    vQueueDelete(queue);
+}
+
+// esp_timer callbacks fire in deadline order at their deadline, a stopped timer never fires and starting an active timer fails.
+TEST_CASE(espTimerOrderingAndStop)
+{
+    // Locals.
+    //
+    esp_timer_handle_t                  timers[3];
+    esp_timer_create_args_t             args = { recordTimer, NULL, ESP_TIMER_TASK, "t", false };
+
+    fired.clear();
+    Shim::freezeTime();
+    for(int idx = 0; idx < 3; idx++)
+    {
+        args.arg = (void *)(intptr_t)idx;
+        esp_timer_create(&args, &timers[idx]);
+    }
+    esp_timer_start_once(timers[0], 300);
+    esp_timer_start_once(timers[1], 100);
+    esp_timer_start_once(timers[2], 200);
+    CHECK_EQ(esp_timer_start_once(timers[1], 50), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(esp_timer_stop(timers[2]), ESP_OK);
+    Shim::advanceTime(150);
+    CHECK_EQ(fired.size(), 1U);
+    Shim::advanceTime(1000);
+    CHECK_EQ(fired.size(), 2U);
+    if(fired.size() == 2)
+    {
+        CHECK_EQ(fired[0], 1);
+        CHECK_EQ(fired[1], 0);
+    }
+    CHECK(!esp_timer_is_active(timers[0]));
+    Shim::releaseTime();
+}
+
+// The general purpose timer counts at 80MHz / divider and its alarm is one shot.
+TEST_CASE(hardwareTimerAlarmIsOneShot)
+{
+    // Locals.
+    //
+    timer_config_t                      config = { TIMER_ALARM_DIS, TIMER_PAUSE, TIMER_INTR_LEVEL, TIMER_COUNT_UP, TIMER_AUTORELOAD_DIS, 80 };
+    static int                          alarms;
+    uint64_t                            count;
+
+    alarms = 0;
+    Shim::freezeTime();
+    timer_init(TIMER_GROUP_1, TIMER_1, &config);
+    timer_set_counter_value(TIMER_GROUP_1, TIMER_1, 0);
+    timer_isr_callback_add(TIMER_GROUP_1, TIMER_1, [](void *arg) -> bool { alarms++; return(false); }, NULL, 0);
+    timer_start(TIMER_GROUP_1, TIMER_1);
+    timer_group_set_alarm_value_in_isr(TIMER_GROUP_1, TIMER_1, 1000);
+    timer_group_enable_alarm_in_isr(TIMER_GROUP_1, TIMER_1);
+    Shim::advanceTime(999);
+    CHECK_EQ(alarms, 0);
+    Shim::advanceTime(1);
+    CHECK_EQ(alarms, 1);
+    Shim::advanceTime(5000);
+    CHECK_EQ(alarms, 1);
+    timer_get_counter_value(TIMER_GROUP_1, TIMER_1, &count);
+    CHECK_EQ(count, 6000U);
+    timer_pause(TIMER_GROUP_1, TIMER_1);
+    Shim::releaseTime();
+}
+
+// A task blocked on a queue is woken by a send from another thread, and its notification reaches the sender.
+TEST_CASE(taskQueueAndNotify)
+{
+    // Locals.
+    //
+    int                                 value = 42;
+
+    echoQueue = xQueueCreate(4, sizeof(int));
+    xTaskCreatePinnedToCore(echoTask, "echo", 2048, xTaskGetCurrentTaskHandle(), 5, NULL, 0);
+    CHECK(xQueueSend(echoQueue, &value, 0) == pdTRUE);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)), 1U);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 0U);
+}
+
+// Semaphores are single item queues, a queue set reports the member holding data.
+TEST_CASE(semaphoresAndQueueSets)
+{
+    // Locals.
+    //
+    SemaphoreHandle_t                   mutex = xSemaphoreCreateMutex();
+    SemaphoreHandle_t                   binary = xSemaphoreCreateBinary();
+    QueueHandle_t                       queue = xQueueCreate(2, sizeof(int));
+    QueueSetHandle_t                    set = xQueueCreateSet(4);
+    int                                 value = 7;
+
+    CHECK(xSemaphoreTake(mutex, 0) == pdTRUE);
+    CHECK(xSemaphoreTake(mutex, 0) == pdFALSE);
+    CHECK(xSemaphoreGive(mutex) == pdTRUE);
+    CHECK(xSemaphoreGive(mutex) == pdFALSE);
+    CHECK(xSemaphoreTake(binary, 0) == pdFALSE);
+    CHECK(xQueueAddToSet(queue, set) == pdPASS);
+    CHECK(xQueueAddToSet(binary, set) == pdPASS);
+    CHECK(xQueueSelectFromSet(set, 0) == NULL);
+    xQueueSend(queue, &value, 0);
+    xSemaphoreGive(binary);
+    CHECK(xQueueSelectFromSet(set, 0) == queue);
+    CHECK(xQueueSelectFromSet(set, 0) == binary);
+    CHECK_EQ(uxQueueMessagesWaiting(queue), 1U);
+}
+
+TEST_CASE(eventGroupWaitAll)
+{
+    // Locals.
+    //
+    EventGroupHandle_t                  group = xEventGroupCreate();
+
+    xEventGroupSetBits(group, 0x01);
+    CHECK_EQ(xEventGroupWaitBits(group, 0x03, pdFALSE, pdTRUE, 0) & 0x03, 0x01U);
+    xEventGroupSetBits(group, 0x02);
+    CHECK_EQ(xEventGroupWaitBits(group, 0x03, pdTRUE, pdTRUE, 0) & 0x03, 0x03U);
+    CHECK_EQ(xEventGroupGetBits(group), 0U);
+}
+
+// Pin levels are the external level wired-AND with an enabled output, edges raise the matching interrupt.
+TEST_CASE(gpioLevelsAndEdges)
+{
+    // Locals.
+    //
+    gpio_config_t                       ioConf;
+
+    memset(&ioConf, 0, sizeof(ioConf));
+    ioConf.pin_bit_mask = (1ULL << 4) | (1ULL << 33);
+    ioConf.mode         = GPIO_MODE_INPUT;
+    ioConf.intr_type    = GPIO_INTR_NEGEDGE;
+    gpio_config(&ioConf);
+    gpio_isr_handler_add((gpio_num_t)4, countIsr, NULL);
+    isrCount = 0;
+    CHECK_EQ(REG_READ(GPIO_IN_REG) & (1 << 4), (uint32_t)(1 << 4));
+    Shim::setInput(4, 0);
+    CHECK_EQ(isrCount.load(), 1);
+    CHECK_EQ(REG_READ(GPIO_IN_REG) & (1 << 4), 0U);
+    Shim::setInput(4, 1);
+    CHECK_EQ(isrCount.load(), 1);
+    Shim::setInput(33, 0);
+    CHECK_EQ(REG_READ(GPIO_IN1_REG) & (1 << 1), 0U);
+    Shim::setInput(33, 1);
+
+    pinMode(5, OUTPUT);
+    GPIO.out_w1tc = (1 << 5);
+    CHECK_EQ(digitalRead(5), 0);
+    GPIO.out_w1ts = (1 << 5);
+    CHECK_EQ(digitalRead(5), 1);
+    Shim::setInput(5, 0);
+    CHECK_EQ(digitalRead(5), 0);
+    CHECK_EQ(Shim::getOutput(5), 1);
+    Shim::setInput(5, 1);
+}
+
+// Bytes written by the host end of the pty arrive as a data event and are read back, writes reach the host end.
+TEST_CASE(uartPtyRoundTrip)
+{
+    // Locals.
+    //
+    QueueHandle_t                       events;
+    uart_event_t                        event;
+    uint8_t                             buf[8];
+    const uint8_t                       hostData[3] = { 0x41, 0x42, 0x43 };
+    int                                 hostFd;
+
+    CHECK_EQ(uart_driver_install(UART_NUM_1, 256, 256, 8, &events, 0), ESP_OK);
+    hostFd = Shim::uartHostFd(UART_NUM_1);
+    CHECK(hostFd >= 0);
+    CHECK_EQ(write(hostFd, hostData, sizeof(hostData)), 3);
+    CHECK(xQueueReceive(events, &event, pdMS_TO_TICKS(1000)) == pdTRUE);
+    CHECK_EQ(event.type, UART_DATA);
+    Shim::settle(10);
+    CHECK_EQ(uart_read_bytes(UART_NUM_1, buf, sizeof(buf), 0), 3);
+    CHECK(memcmp(buf, hostData, 3) == 0);
+    CHECK_EQ(uart_write_bytes(UART_NUM_1, "\x55", 1), 1);
+    CHECK_EQ(read(hostFd, buf, 1), 1);
+    CHECK_EQ(buf[0], 0x55);
+    Shim::uartBreak(UART_NUM_1);
+    CHECK(xQueueReceive(events, &event, pdMS_TO_TICKS(1000)) == pdTRUE);
+    CHECK_EQ(event.type, UART_BREAK);
+}
+
+// Blob reads follow the target, a NULL buffer sizes the blob and a short buffer is rejected.
+TEST_CASE(nvsBlobSemantics)
+{
+    // Locals.
+    //
+    nvs_handle_t                        handle;
+    uint32_t                            value = 0x12345678;
+    uint16_t                            shortValue;
+    size_t                              size;
+
+    nvs_flash_init();
+    nvs_open("test", NVS_READWRITE, &handle);
+    size = sizeof(value);
+    CHECK_EQ(nvs_get_blob(handle, "key", &value, &size), ESP_ERR_NVS_NOT_FOUND);
+    CHECK_EQ(nvs_set_blob(handle, "key", &value, sizeof(value)), ESP_OK);
+    CHECK_EQ(nvs_get_blob(handle, "key", NULL, &size), ESP_OK);
+    CHECK_EQ(size, sizeof(value));
+    size = sizeof(shortValue);
+    CHECK_EQ(nvs_get_blob(handle, "key", &shortValue, &size), ESP_ERR_NVS_INVALID_LENGTH);
+    Shim::nvsErase();
+    size = sizeof(value);
+    CHECK_EQ(nvs_get_blob(handle, "key", &value, &size), ESP_ERR_NVS_NOT_FOUND);
+}
+
+TEST_MAIN()
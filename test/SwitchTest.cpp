@@ -0,0 +1,209 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            SwitchTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the config/WiFi switch. Presses of set durations are made on the switch pin with
+//                  the clock frozen and stepped, and the callback each press fires is checked against the
+//                  press time bands.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "LED.h"
+#include "SWITCH.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    // Callbacks fired, in order. The reset callback answers resetAllowed, a restart ends the switch thread so it is only allowed last.
+    std::vector<int>                    fired;
+    bool                                resetAllowed = false;
+
+    #define RESET_EVENT                 0x10
+
+    void cancelEvent(void)    { fired.push_back(SWITCH::SWITCH_EVENT_CANCEL); }
+    void wifiEnEvent(void)    { fired.push_back(SWITCH::SWITCH_EVENT_WIFIEN); }
+    void wifiDefEvent(void)   { fired.push_back(SWITCH::SWITCH_EVENT_WIFIDEF); }
+    void btPairingEvent(void) { fired.push_back(SWITCH::SWITCH_EVENT_BTPAIRING); }
+    void clearNVSEvent(void)  { fired.push_back(SWITCH::SWITCH_EVENT_CLEARNVS); }
+    bool resetEvent(void)     { fired.push_back(RESET_EVENT); return(resetAllowed); }
+
+    // The switch under test, created with the clock frozen so presses are timed in stepped time.
+    SWITCH &sw(void)
+    {
+        // Locals.
+        //
+        static SWITCH                  *instance = NULL;
+
+        if(instance == NULL)
+        {
+            Shim::freezeTime();
+            Shim::setInput(CONFIG_IF_WIFI_EN_KEY, 1);
+            instance = new SWITCH(new LED(CONFIG_PWRLED));
+            instance->setCancelEventCallback(&cancelEvent);
+            instance->setWifiEnEventCallback(&wifiEnEvent);
+            instance->setWifiDefEventCallback(&wifiDefEvent);
+            instance->setBTPairingEventCallback(&btPairingEvent);
+            instance->setClearNVSEventCallback(&clearNVSEvent);
+            instance->setResetEventCallback(&resetEvent);
+            Shim::waitBlocked(xTaskGetHandle("switch"));
+        }
+        return(*instance);
+    }
+
+    // Change the switch level and let the thread woken by the edge reach its debounce wait, as it would at once on the target.
+    void setSwitch(int level)
+    {
+        Shim::setInput(CONFIG_IF_WIFI_EN_KEY, level);
+        Shim::waitBlocked(xTaskGetHandle("switch"));
+    }
+
+    // Step the clock, letting the switch thread act on each step.
+    bool step(uint32_t ms)
+    {
+        // Locals.
+        //
+        bool                            blocked = true;
+
+        for(uint32_t elapsed = 0; elapsed < ms; elapsed += 10)
+        {
+            Shim::advanceTime((ms - elapsed < 10 ? ms - elapsed : 10) * 1000LL);
+            blocked &= Shim::waitBlocked(xTaskGetHandle("switch"));
+        }
+        return(blocked);
+    }
+
+    // Hold the switch down for the given time then release it, returning once the release has been debounced and acted on. The press
+    // starts from a quiet switch so it is not taken as the second of a reset pair.
+    std::vector<int> press(uint32_t heldMs, uint32_t gapMs = 2 * SWITCH_RESET_WINDOW_MS)
+    {
+        sw();
+        step(gapMs);
+        fired.clear();
+        setSwitch(0);
+        step(heldMs);
+        setSwitch(1);
+        step(2 * SWITCH_DEBOUNCE_MS);
+        return(fired);
+    }
+}
+
+// The press time bands, with the margins between them where a release does nothing.
+TEST_CASE(classifyPressBands)
+{
+    CHECK_EQ(SWITCH::classifyPress(0),                             SWITCH::SWITCH_EVENT_NONE);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_CANCEL_MIN_MS - 1),      SWITCH::SWITCH_EVENT_NONE);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_CANCEL_MIN_MS),          SWITCH::SWITCH_EVENT_CANCEL);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_WIFIEN_MIN_MS - 1),      SWITCH::SWITCH_EVENT_CANCEL);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_WIFIEN_MIN_MS),          SWITCH::SWITCH_EVENT_NONE);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_WIFIEN_MIN_MS + 1),      SWITCH::SWITCH_EVENT_WIFIEN);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_WIFIEN_MAX_MS - 1),      SWITCH::SWITCH_EVENT_WIFIEN);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_WIFIEN_MAX_MS),          SWITCH::SWITCH_EVENT_NONE);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_WIFIDEF_MIN_MS),         SWITCH::SWITCH_EVENT_NONE);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_WIFIDEF_MIN_MS + 1),     SWITCH::SWITCH_EVENT_WIFIDEF);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_BTPAIRING_MIN_MS - 1),   SWITCH::SWITCH_EVENT_WIFIDEF);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_BTPAIRING_MIN_MS),       SWITCH::SWITCH_EVENT_BTPAIRING);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_CLEARNVS_MIN_MS - 1),    SWITCH::SWITCH_EVENT_BTPAIRING);
+    CHECK_EQ(SWITCH::classifyPress(SWITCH_CLEARNVS_MIN_MS),        SWITCH::SWITCH_EVENT_CLEARNVS);
+    CHECK_EQ(SWITCH::classifyPress(60000),                         SWITCH::SWITCH_EVENT_CLEARNVS);
+}
+
+// Each held time fires the callback of its band and nothing else.
+TEST_CASE(pressFiresBandCallback)
+{
+    CHECK(press(500)   == std::vector<int>({ SWITCH::SWITCH_EVENT_CANCEL }));
+    CHECK(press(2000)  == std::vector<int>({ SWITCH::SWITCH_EVENT_WIFIEN }));
+    CHECK(press(7000)  == std::vector<int>({ SWITCH::SWITCH_EVENT_WIFIDEF }));
+    CHECK(press(12000) == std::vector<int>({ SWITCH::SWITCH_EVENT_BTPAIRING }));
+    CHECK(press(16000) == std::vector<int>({ SWITCH::SWITCH_EVENT_CLEARNVS }));
+}
+
+// The press is timed in milli-seconds from the debounced edges, either side of a band boundary selects either side's action.
+TEST_CASE(pressTimedInMilliseconds)
+{
+    CHECK(press(SWITCH_WIFIEN_MAX_MS - 50)    == std::vector<int>({ SWITCH::SWITCH_EVENT_WIFIEN }));
+    CHECK(press(SWITCH_WIFIEN_MAX_MS + 50)    == std::vector<int>());
+    CHECK(press(SWITCH_BTPAIRING_MIN_MS - 50) == std::vector<int>({ SWITCH::SWITCH_EVENT_WIFIDEF }));
+    CHECK(press(SWITCH_BTPAIRING_MIN_MS + 50) == std::vector<int>({ SWITCH::SWITCH_EVENT_BTPAIRING }));
+}
+
+// Contact bounce and presses too short to be deliberate fire nothing, as does a release between bands.
+TEST_CASE(bounceAndMarginsIgnored)
+{
+    CHECK(press(5)    == std::vector<int>());
+    CHECK(press(100)  == std::vector<int>());
+    CHECK(press(4500) == std::vector<int>());
+
+    // A contact glitch part way through a press doesnt split it in two.
+    sw();
+    step(2 * SWITCH_RESET_WINDOW_MS);
+    fired.clear();
+    setSwitch(0);
+    step(1500);
+    setSwitch(1);
+    step(5);
+    setSwitch(0);
+    step(1500);
+    setSwitch(1);
+    step(2 * SWITCH_DEBOUNCE_MS);
+    CHECK(fired == std::vector<int>({ SWITCH::SWITCH_EVENT_WIFIEN }));
+}
+
+// An idle switch fires nothing however long it is left.
+TEST_CASE(idleSwitchQuiet)
+{
+    sw();
+    fired.clear();
+    CHECK(step(60000));
+    CHECK(fired.empty());
+}
+
+// Two short presses within the reset window cancel then request a reset, further apart they are two cancels.
+TEST_CASE(doublePressRequestsReset)
+{
+    // Locals.
+    //
+    std::vector<int>                    first;
+
+    resetAllowed = false;
+    press(300);
+    CHECK(press(300, 200) == std::vector<int>({ SWITCH::SWITCH_EVENT_CANCEL, RESET_EVENT }));
+    CHECK_EQ(Shim::restartCount(), 0u);
+
+    first = press(300);
+    CHECK(first == std::vector<int>({ SWITCH::SWITCH_EVENT_CANCEL }));
+    CHECK(press(300, SWITCH_RESET_WINDOW_MS + 100) == std::vector<int>({ SWITCH::SWITCH_EVENT_CANCEL }));
+}
+
+// A reset the handler allows restarts, this ends the switch thread so it runs last.
+TEST_CASE(doublePressRestarts)
+{
+    resetAllowed = true;
+    press(300);
+    CHECK(press(300, 200) == std::vector<int>({ SWITCH::SWITCH_EVENT_CANCEL, RESET_EVENT }));
+    CHECK_EQ(Shim::restartCount(), 1u);
+}
+
+TEST_MAIN()
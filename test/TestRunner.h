@@ -0,0 +1,153 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            TestRunner.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Minimal test runner for the host tests. Test cases register themselves, checks record
+//                  a failure and carry on so a run reports every broken expectation.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Interface threads started by a test never end, so the runner leaves with _exit rather than running static destructors under them.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef TESTRUNNER_H
+#define TESTRUNNER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace TestRunner
+{
+    typedef void t_testFunc(void);
+
+    struct t_testCase
+    {
+        const char                     *name;
+        t_testFunc                     *func;
+    };
+
+    inline std::vector<t_testCase> &cases(void)
+    {
+        static std::vector<t_testCase> registered;
+        return(registered);
+    }
+
+    inline int &failures(void)
+    {
+        static int count = 0;
+        return(count);
+    }
+
+    struct Registrar
+    {
+        Registrar(const char *name, t_testFunc *func)
+        {
+            cases().push_back({ name, func });
+        }
+    };
+
+    inline bool check(bool result, const char *expr, const char *file, int line)
+    {
+        if(!result)
+        {
+            fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+            failures()++;
+        }
+        return(result);
+    }
+
+    template <typename A, typename B> bool checkEqual(const A &actual, const B &expected, const char *exprA, const char *exprB, const char *file, int line)
+    {
+        if(!(actual == expected))
+        {
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", file, line, exprA, exprB, (long long)actual, (long long)expected);
+            failures()++;
+            return(false);
+        }
+        return(true);
+    }
+
+    // Time a block of work, printed so a benchmark run can be compared between builds.
+    template <typename F> double benchmark(const char *name, uint32_t iterations, F work)
+    {
+        // Locals.
+        //
+        auto                            start = std::chrono::steady_clock::now();
+        double                          nsPerOp;
+
+        for(uint32_t idx = 0; idx < iterations; idx++)
+            work(idx);
+        nsPerOp = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+        printf("[ BENCH    ] %-40s %10u ops %10.1f ns/op\n", name, iterations, nsPerOp);
+        return(nsPerOp);
+    }
+
+    // Run every registered case, or only those named on the command line.
+    inline int run(int argc, char **argv)
+    {
+        // Locals.
+        //
+        int                             failed = 0;
+        int                             before;
+        bool                            selected;
+
+        for(const t_testCase &test : cases())
+        {
+            selected = argc < 2;
+            for(int idx = 1; idx < argc; idx++)
+                selected |= strcmp(argv[idx], test.name) == 0;
+            if(!selected)
+                continue;
+            printf("[ RUN      ] %s\n", test.name);
+            fflush(stdout);
+            before = failures();
+            test.func();
+            printf("%s %s\n", failures() == before ? "[       OK ]" : "[  FAILED  ]", test.name);
+            fflush(stdout);
+            failed += failures() == before ? 0 : 1;
+        }
+        printf("%d of %zu test cases failed\n", failed, cases().size());
+        fflush(stdout);
+        fflush(stderr);
+        _exit(failed == 0 ? 0 : 1);
+    }
+}
+
+#define TEST_CASE(name)                                                                                  \
+    static void name(void);                                                                              \
+    static TestRunner::Registrar name##Registrar(#name, name);                                           \
+    static void name(void)
+
+#define CHECK(expr)                     TestRunner::check((expr), #expr, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected)      TestRunner::checkEqual((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+
+#define TEST_MAIN()                                                                                      \
+    int main(int argc, char **argv)                                                                      \
+    {                                                                                                    \
+        return(TestRunner::run(argc, argv));                                                             \
+    }
+
+#endif // TESTRUNNER_H
@@ -0,0 +1,217 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            TimerServiceTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the TimerService deadline scheduler on the frozen shim clock, heap ordering
+//                  across threads, cancellation, rescheduling and wake jitter.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "TimerService.h"
+#include "Shim.h"
+#include "TestRunner.h"
+
+namespace
+{
+    #define WORKER_COUNT                5
+    #define WORKER_DEADLINES            40
+
+    struct t_wake
+    {
+        int                             worker;
+        uint64_t                        deadline;
+        uint64_t                        woken;
+    };
+
+    struct t_worker
+    {
+        int                             index;
+        std::vector<uint64_t>           deadlines;
+        TaskHandle_t                    handle;
+    };
+
+    std::mutex                          wakeLock;
+    std::vector<t_wake>                 wakes;
+
+    // Sleep through a list of deadlines, recording the time of each wake.
+    void workerTask(void *pvParameters)
+    {
+        // Locals.
+        //
+        t_worker                       *worker = (t_worker *)pvParameters;
+        TimerService                   *timers = TimerService::getInstance();
+        int                             timerId = timers->registerTimer(xTaskGetCurrentTaskHandle());
+
+        for(uint64_t deadline : worker->deadlines)
+        {
+            timers->sleepUntil(timerId, deadline);
+            std::lock_guard<std::mutex> lk(wakeLock);
+            wakes.push_back({ worker->index, deadline, timers->now() });
+        }
+        vTaskDelete(NULL);
+    }
+}
+
+// Threads sleeping on interleaved deadlines are woken in deadline order and, the clock only moving when stepped, exactly on the deadline.
+TEST_CASE(heapOrderAndWakeJitter)
+{
+    // Locals.
+    //
+    TimerService                       *timers;
+    static t_worker                     workers[WORKER_COUNT];
+    std::mt19937                        rng(29);
+    std::set<uint64_t>                  times;
+    uint64_t                            deadline;
+    size_t                              expected = 0;
+    size_t                              total = 0;
+    bool                                blocked = true;
+
+    Shim::freezeTime();
+    timers = TimerService::getInstance();
+
+    // Deadlines on a 10uS grid, beyond the alarm lead so each wake comes from its own alarm.
+    for(int idx = 0; idx < WORKER_COUNT; idx++)
+    {
+        workers[idx].index = idx;
+        deadline = timers->now();
+        for(int cnt = 0; cnt < WORKER_DEADLINES; cnt++)
+        {
+            deadline += 10 * (1 + rng() % 200);
+            workers[idx].deadlines.push_back(deadline);
+            times.insert(deadline);
+        }
+        total += workers[idx].deadlines.size();
+        xTaskCreatePinnedToCore(workerTask, "worker", 4096, &workers[idx], 5, &workers[idx].handle, idx % 2);
+    }
+    for(int idx = 0; idx < WORKER_COUNT; idx++)
+        blocked &= Shim::waitBlocked(workers[idx].handle);
+    CHECK(blocked);
+
+    // Step to each deadline in turn and let the woken threads run before stepping again.
+    for(uint64_t wakeTime : times)
+    {
+        Shim::advanceTime(wakeTime - timers->now());
+        for(int idx = 0; idx < WORKER_COUNT; idx++)
+            blocked &= Shim::waitBlocked(workers[idx].handle);
+        for(int idx = 0; idx < WORKER_COUNT; idx++)
+            expected += std::count(workers[idx].deadlines.begin(), workers[idx].deadlines.end(), wakeTime);
+        std::lock_guard<std::mutex> lk(wakeLock);
+        CHECK_EQ(wakes.size(), expected);
+    }
+    CHECK(blocked);
+
+    std::lock_guard<std::mutex> lk(wakeLock);
+    CHECK_EQ(wakes.size(), total);
+    for(size_t idx = 0; idx < wakes.size(); idx++)
+    {
+        CHECK_EQ(wakes[idx].woken, wakes[idx].deadline);
+        if(idx > 0)
+            CHECK(wakes[idx].woken >= wakes[idx - 1].woken);
+    }
+    Shim::releaseTime();
+}
+
+// A cancelled timer never fires, a rescheduled timer fires only at its new deadline and cancelling the earliest re-arms for the next.
+TEST_CASE(cancelAndReschedule)
+{
+    // Locals.
+    //
+    TimerService                       *timers;
+    int                                 timerA;
+    int                                 timerB;
+    uint64_t                            start;
+
+    Shim::freezeTime();
+    timers = TimerService::getInstance();
+    timerA = timers->registerTimer(xTaskGetCurrentTaskHandle());
+    timerB = timers->registerTimer(xTaskGetCurrentTaskHandle());
+    ulTaskNotifyTake(pdTRUE, 0);
+    start = timers->now();
+
+    // Deadlines within the alarm lead are refused.
+    CHECK(!timers->startTimer(timerA, start + TIMERSERVICE_ALARM_LEAD));
+    CHECK(!timers->startTimer(TIMERSERVICE_MAX_TIMERS, start + 1000));
+
+    CHECK(timers->startTimer(timerA, start + 1000));
+    timers->cancelTimer(timerA);
+    Shim::advanceTime(2000);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 0U);
+
+    start = timers->now();
+    CHECK(timers->startTimer(timerA, start + 1000));
+    CHECK(timers->startTimer(timerA, start + 3000));
+    Shim::advanceTime(2000);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 0U);
+    Shim::advanceTime(1000);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 1U);
+
+    start = timers->now();
+    CHECK(timers->startTimer(timerA, start + 1000));
+    CHECK(timers->startTimer(timerB, start + 2000));
+    timers->cancelTimer(timerA);
+    Shim::advanceTime(1500);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 0U);
+    Shim::advanceTime(499);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 0U);
+    Shim::advanceTime(1);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 1U);
+
+    // Moving a later timer ahead of the earliest re-arms the alarm for it.
+    start = timers->now();
+    CHECK(timers->startTimer(timerA, start + 3000));
+    CHECK(timers->startTimer(timerB, start + 2000));
+    CHECK(timers->startTimer(timerA, start + 500));
+    Shim::advanceTime(500);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 1U);
+    Shim::advanceTime(1500);
+    CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 1U);
+    Shim::releaseTime();
+}
+
+// Every slot can be registered once, further registrations are refused.
+TEST_CASE(registrationLimit)
+{
+    // Locals.
+    //
+    TimerService                       *timers = TimerService::getInstance();
+    int                                 timerId;
+    int                                 registered = 0;
+
+    while((timerId = timers->registerTimer(xTaskGetCurrentTaskHandle())) != TIMERSERVICE_INVALID)
+    {
+        CHECK(timerId < TIMERSERVICE_MAX_TIMERS);
+        registered++;
+    }
+    CHECK(registered <= TIMERSERVICE_MAX_TIMERS);
+}
+
+TEST_MAIN()
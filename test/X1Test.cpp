@@ -0,0 +1,219 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            X1Test.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the X1 host interface on the virtual GPIO. Keys typed on the stand-in keyboard
+//                  are decoded from the pulse train the interface writes to KDO0, as the X1 receives it.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <thread>
+#include <vector>
+#include "X1.h"
+#include "HostHarness.h"
+#include "TestRunner.h"
+
+namespace
+{
+    #define BT_KEY_A                    0x04
+    #define BT_MOD_L_SHIFT              0x02
+    #define X1_MODE_A_BITS              16
+    #define X1_HEADER_LOW_US            1000                            // Mode A header, low then high.
+    #define X1_HEADER_HIGH_US           700
+    #define X1_BIT_LOW_US               250                             // Each data bit and the stop bit start with a 250uS low.
+    #define X1_BIT_ONE_US               1750                            // High time of a 1 bit, a 0 bit is high for 750uS.
+    #define X1_BIT_ZERO_US              750
+    #define X1_STEP_US                  50                              // Clock step, every edge of the protocol is a multiple of it.
+    #define X1_TIMING_SLACK_US          (X1_STEP_US + 1)                // An edge lands within a step of its deadline.
+
+    // A frame as the X1 received it, the 16 data bits of a mode A frame, CTRL then key, MSB first.
+    struct t_frame
+    {
+        uint16_t                        data;
+        bool                            timingOk;
+    };
+
+    // The interface under test, created once as it owns the host GPIO. The clock is frozen once it is running so the frame timing does
+    // not depend on host scheduling.
+    X1 &x1(void)
+    {
+        // Locals.
+        //
+        static X1                      *instance = NULL;
+        HostHarness::t_host            &host = HostHarness::host();
+
+        if(instance == NULL)
+        {
+            instance = new X1(1, &host.nvs, host.led, host.hid, host.fsPath.c_str());
+            Shim::settle(100);
+            Shim::freezeTime();
+        }
+        return(*instance);
+    }
+
+    // The KDO0 levels as transitions, repeated writes of the same level removed.
+    std::vector<Shim::t_gpioWrite> transitions(void)
+    {
+        // Locals.
+        //
+        std::vector<Shim::t_gpioWrite>  edges;
+
+        for(const Shim::t_gpioWrite &write : Shim::gpioWrites(CONFIG_HOST_KDO0))
+        {
+            if(edges.empty() || edges.back().level != write.level)
+                edges.push_back(write);
+        }
+        return(edges);
+    }
+
+    bool near(int64_t actualUs, int64_t expectedUs)
+    {
+        return(actualUs > expectedUs - X1_TIMING_SLACK_US && actualUs < expectedUs + X1_TIMING_SLACK_US);
+    }
+
+    // Decode the mode A frames on KDO0. A frame is the header low and high, 16 data bits each a low then a high whose length gives the
+    // bit, and the stop bit low. The line idles high.
+    std::vector<t_frame> decodeFrames(void)
+    {
+        // Locals.
+        //
+        std::vector<Shim::t_gpioWrite>  edges = transitions();
+        std::vector<t_frame>            frames;
+        t_frame                         frame;
+        size_t                          pos = 0;
+        int64_t                         highUs;
+
+        // Each frame is 18 falling and 18 rising edges from the header fall.
+        while(pos < edges.size() && edges[pos].level != 0)
+            pos++;
+        while(pos + 2 * (X1_MODE_A_BITS + 2) <= edges.size())
+        {
+            frame.data     = 0;
+            frame.timingOk = near(edges[pos + 1].timeUs - edges[pos].timeUs, X1_HEADER_LOW_US) && near(edges[pos + 2].timeUs - edges[pos + 1].timeUs, X1_HEADER_HIGH_US);
+            pos += 2;
+            for(int bit = 0; bit < X1_MODE_A_BITS; bit++, pos += 2)
+            {
+                highUs = edges[pos + 2].timeUs - edges[pos + 1].timeUs;
+                frame.data      = (frame.data << 1) | (highUs > (X1_BIT_ONE_US + X1_BIT_ZERO_US) / 2 ? 1 : 0);
+                frame.timingOk &= near(edges[pos + 1].timeUs - edges[pos].timeUs, X1_BIT_LOW_US) && (near(highUs, X1_BIT_ONE_US) || near(highUs, X1_BIT_ZERO_US));
+            }
+            frame.timingOk &= near(edges[pos + 1].timeUs - edges[pos].timeUs, X1_BIT_LOW_US);
+            frames.push_back(frame);
+            pos += 2;
+        }
+        return(frames);
+    }
+
+    // Run the firmware for the given time a clock step at a time. A step is only taken once the X1 thread has seen the last, either
+    // spinning on the bit timer or blocked waiting for a key, so each edge is written at its deadline.
+    void runFor(int64_t us)
+    {
+        // Locals.
+        //
+        TaskHandle_t                    task = xTaskGetHandle("x1if");
+        uint64_t                        reads;
+
+        for(int64_t elapsed = 0; elapsed < us; elapsed += X1_STEP_US)
+        {
+            reads = Shim::timerCounterReads();
+            Shim::advanceTime(X1_STEP_US);
+            while(Shim::timerCounterReads() < reads + 2 && Shim::waitBlocked(task, 0) == false)
+                std::this_thread::yield();
+        }
+    }
+
+    // Tap a key on the stand-in keyboard and return the frames the X1 received.
+    std::vector<t_frame> typeKey(uint8_t btKey, uint8_t modifiers)
+    {
+        x1();
+        Shim::gpioTrace(CONFIG_HOST_KDO0);
+        HostHarness::keyReport(modifiers, { btKey });
+        runFor(100000);
+        HostHarness::keyReport(0x00, {});
+        runFor(200000);
+        return(decodeFrames());
+    }
+
+    // The frames received, data only.
+    std::vector<uint16_t> frameData(const std::vector<t_frame> &frames)
+    {
+        // Locals.
+        //
+        std::vector<uint16_t>           data;
+
+        for(const t_frame &frame : frames)
+            data.push_back(frame.data);
+        return(data);
+    }
+
+    bool timingOk(const std::vector<t_frame> &frames)
+    {
+        for(const t_frame &frame : frames)
+        {
+            if(frame.timingOk == false)
+                return(false);
+        }
+        return(true);
+    }
+
+    // A mode A frame, CTRL is negative logic, a cleared bit is active.
+    uint16_t modeAFrame(uint8_t activeCtrl, uint8_t key)
+    {
+        return((uint16_t)(((0xFF & ~activeCtrl) << 8) | key));
+    }
+}
+
+// The line idles high once the interface is running.
+TEST_CASE(lineIdlesHigh)
+{
+    x1();
+    CHECK_EQ(Shim::getOutput(CONFIG_HOST_KDO0), 1);
+}
+
+// A key press is a frame with the key code and PRESS active, letters are sent in upper case as on the X1 keyboard. The release is a frame
+// with key code 0x00 and no CTRL bits active. Every pulse is within the mode A timing.
+TEST_CASE(keyPressAndRelease)
+{
+    // Locals.
+    //
+    std::vector<t_frame>                frames = typeKey(BT_KEY_A, 0x00);
+
+    CHECK(frameData(frames) == std::vector<uint16_t>({ modeAFrame(X1_CTRL_PRESS, 'A'), modeAFrame(0, 0x00) }));
+    CHECK(timingOk(frames));
+}
+
+// SHIFT is sent on its own with SHIFT active, then the shifted character with PRESS and SHIFT active. Releasing the key and SHIFT each
+// send a release frame.
+TEST_CASE(shiftedKey)
+{
+    // Locals.
+    //
+    std::vector<t_frame>                frames = typeKey(BT_KEY_1, BT_MOD_L_SHIFT);
+
+    CHECK(frameData(frames) == std::vector<uint16_t>({ modeAFrame(X1_CTRL_SHIFT, 0x00), modeAFrame(X1_CTRL_PRESS | X1_CTRL_SHIFT, '!'),
+                                                       modeAFrame(0, 0x00), modeAFrame(0, 0x00) }));
+    CHECK(timingOk(frames));
+}
+
+TEST_MAIN()
@@ -0,0 +1,463 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            X68KTest.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Tests of the X68000 host command processor. The host UART is a pty, the test plays the
+//                  X68000 on its far side writing command byte streams as the host sends them and timing
+//                  the key codes returned, whilst the stand-in BT keyboard holds keys and records the LED
+//                  reports it is sent.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//                  Oct 2026 - Key latency stage test.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include "X68K.h"
+#include "HostHarness.h"
+#include "TestRunner.h"
+
+namespace
+{
+    #define X68K_UART                   UART_NUM_2
+    #define X68K_BREAK                  0x80
+    #define BT_MOD_L_SHIFT              0x02
+    #define LATENCY_TAPS                10
+    #define MACRO_INHIBITS              6
+
+    // Host command streams as the X68000 sends them. At power on the IPL polls the keyboard, sets the LEDs off, enables key data,
+    // sets the brightness and the default repeat rate, the 0x40/0x41 polls are interleaved throughout.
+    const std::vector<uint8_t>          bootStream  = { 0x41, 0x40, 0xFF, 0x49, 0x57, 0x41, 0x63, 0x74, 0x40, 0x41 };
+    const std::vector<uint8_t>          capsOn      = { 0xF7 };
+    const std::vector<uint8_t>          kanaOn      = { 0xF6 };
+    const std::vector<uint8_t>          capsOff     = { 0xFE };
+    const std::vector<uint8_t>          ledsOff     = { 0xFF };
+    const std::vector<uint8_t>          insOn       = { 0xEF };
+    const std::vector<uint8_t>          ledResend   = { 0x41, 0xF7, 0x40, 0xF7, 0xF7, 0x41 };
+    const std::vector<uint8_t>          keyInhibit  = { 0x48 };
+    const std::vector<uint8_t>          keyEnable   = { 0x49 };
+    const std::vector<uint8_t>          brightness  = { 0x54, 0x55, 0x56, 0x57, 0x40, 0x41 };
+    const std::vector<uint8_t>          fastRepeat  = { 0x61, 0x72 };                                // 300ms delay, 50ms interval.
+    const std::vector<uint8_t>          quickRepeat = { 0x60, 0x71 };                                // 200ms delay, 35ms interval.
+    const std::vector<uint8_t>          defRepeat   = { 0x63, 0x74 };                                // 500ms delay, 110ms interval.
+
+    // A key code received by the host and when, in milli-seconds from the start of the capture.
+    struct t_rcvKey
+    {
+        uint8_t                         code;
+        double                          atMs;
+    };
+
+    // The interface under test, created once as it owns the host UART.
+    X68K &x68k(void)
+    {
+        // Locals.
+        //
+        static X68K                    *instance = NULL;
+        HostHarness::t_host            &host = HostHarness::host();
+
+        if(instance == NULL)
+        {
+            instance = new X68K(0, &host.nvs, host.led, host.hid, host.fsPath.c_str());
+            Shim::settle(100);
+        }
+        return(*instance);
+    }
+
+    // Write a host command stream and give the HID thread time to act on it.
+    void hostSend(const std::vector<uint8_t> &stream)
+    {
+        x68k();
+        CHECK_EQ(write(Shim::uartHostFd(X68K_UART), stream.data(), stream.size()), (ssize_t)stream.size());
+        Shim::settle(X68K_HID_POLL_MS * 3);
+    }
+
+    // Key codes the host receives over the given period, timed from the start of the capture.
+    std::vector<t_rcvKey> hostCapture(int periodMs, std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now())
+    {
+        // Locals.
+        //
+        struct pollfd                   pfd = { Shim::uartHostFd(X68K_UART), POLLIN, 0 };
+        std::vector<t_rcvKey>           keys;
+        uint8_t                         buf[64];
+        ssize_t                         rcvCnt;
+        double                          atMs;
+
+        while((atMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()) < periodMs)
+        {
+            if(poll(&pfd, 1, 1) > 0 && (rcvCnt = read(pfd.fd, buf, sizeof(buf))) > 0)
+            {
+                for(ssize_t idx = 0; idx < rcvCnt; idx++)
+                    keys.push_back({ buf[idx], atMs });
+            }
+        }
+        return(keys);
+    }
+
+    std::vector<uint8_t> codes(const std::vector<t_rcvKey> &keys)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            result;
+
+        for(const t_rcvKey &key : keys)
+            result.push_back(key.code);
+        return(result);
+    }
+
+    // Hold the given keys for the period, returning what the host received from the press up to and including the release.
+    std::vector<t_rcvKey> holdKeys(uint8_t modifiers, const std::set<uint8_t> &btKeys, int holdMs)
+    {
+        // Locals.
+        //
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<t_rcvKey>           keys;
+        std::vector<t_rcvKey>           released;
+
+        x68k();
+        HostHarness::keyReport(modifiers, btKeys);
+        keys = hostCapture(holdMs, start);
+        HostHarness::keyReport(0x00, {});
+        released = hostCapture(holdMs + 150, start);
+        keys.insert(keys.end(), released.begin(), released.end());
+        return(keys);
+    }
+
+    // The LED report most recently sent to the stand-in keyboard, waiting for the HID thread to forward a change.
+    uint8_t keyboardLEDs(uint32_t sentBefore)
+    {
+        // Locals.
+        //
+        esp_hidh_dev_t                 *keyboard = HostHarness::host().keyboard;
+
+        for(int waited = 0; waited < 500 && Shim::hidhOutputCount(keyboard) == sentBefore; waited += 5)
+            Shim::settle(5);
+        return(Shim::hidhOutput(keyboard).empty() ? 0xFF : Shim::hidhOutput(keyboard)[0]);
+    }
+
+    uint32_t ledReports(void)
+    {
+        return(Shim::hidhOutputCount(HostHarness::host().keyboard));
+    }
+
+    // The gaps between successive makes of a code, the first being the repeat delay.
+    std::vector<double> repeatGaps(const std::vector<t_rcvKey> &keys, uint8_t code)
+    {
+        // Locals.
+        //
+        std::vector<double>             gaps;
+        double                          lastMs = -1.0;
+
+        for(const t_rcvKey &key : keys)
+        {
+            if(key.code != code)
+                continue;
+            if(lastMs >= 0.0)
+                gaps.push_back(key.atMs - lastMs);
+            lastMs = key.atMs;
+        }
+        return(gaps);
+    }
+
+    // The time covered by successive gaps, from the first make to the last.
+    double span(const std::vector<double> &gaps)
+    {
+        // Locals.
+        //
+        double                          total = 0.0;
+
+        for(double gap : gaps)
+            total += gap;
+        return(total);
+    }
+
+    double median(std::vector<double> values)
+    {
+        if(values.empty())
+            return(0.0);
+        std::sort(values.begin(), values.end());
+        return(values[values.size() / 2]);
+    }
+}
+
+// The power on stream leaves the LEDs as they were, they are already off, and key data flows at the default rate.
+TEST_CASE(bootStreamEnablesKeys)
+{
+    // Locals.
+    //
+    uint32_t                            sent;
+    std::vector<t_rcvKey>               keys;
+    std::vector<double>                 gaps;
+
+    x68k();
+    sent = ledReports();
+    hostSend(bootStream);
+    CHECK_EQ(ledReports(), sent);
+
+    keys = holdKeys(0x00, { BT_KEY_A }, 800);
+    gaps = repeatGaps(keys, X68K_KEY_A);
+    if(CHECK_EQ(gaps.size(), 3u))
+    {
+        CHECK_EQ(keys.front().code, X68K_KEY_A);
+        CHECK_EQ(keys.back().code, X68K_KEY_A | X68K_BREAK);
+        CHECK(std::abs(gaps[0] - X68K_REPEAT_DELAY_DEFAULT) < 15.0);
+    }
+}
+
+// CAPS maps to the keyboard CAPS LED and KANA to its SCROLL LED, a bit clear is on. The other X68000 LEDs have no keyboard LED.
+TEST_CASE(ledStreamDrivesKeyboardLEDs)
+{
+    // Locals.
+    //
+    uint32_t                            sent;
+
+    hostSend(ledsOff);
+    sent = ledReports();
+    hostSend(capsOn);
+    CHECK_EQ(keyboardLEDs(sent), BT_LED_CAPSLOCK);
+    sent = ledReports();
+    hostSend(kanaOn);
+    CHECK_EQ(keyboardLEDs(sent), BT_LED_CAPSLOCK | BT_LED_SCROLLLOCK);
+    sent = ledReports();
+    hostSend(capsOff);
+    CHECK_EQ(keyboardLEDs(sent), BT_LED_SCROLLLOCK);
+    sent = ledReports();
+    hostSend(insOn);
+    CHECK_EQ(keyboardLEDs(sent), 0x00);
+    sent = ledReports();
+    hostSend(ledsOff);
+    CHECK_EQ(keyboardLEDs(sent), 0x00);
+}
+
+// The host resends the LED state, only a change is forwarded to the keyboard.
+TEST_CASE(ledResendNotForwarded)
+{
+    // Locals.
+    //
+    uint32_t                            sent;
+
+    hostSend(ledsOff);
+    sent = ledReports();
+    hostSend(ledResend);
+    CHECK_EQ(keyboardLEDs(sent), BT_LED_CAPSLOCK);
+    CHECK_EQ(ledReports(), sent + 1);
+    hostSend(ledResend);
+    hostSend(capsOn);
+    CHECK_EQ(ledReports(), sent + 1);
+    hostSend(ledsOff);
+    CHECK_EQ(ledReports(), sent + 2);
+}
+
+// A held key repeats at the delay and interval the host sets, the repeats keeping to the interval's cadence without drifting.
+TEST_CASE(hostSetsRepeatRate)
+{
+    // Locals.
+    //
+    std::vector<t_rcvKey>               keys;
+    std::vector<double>                 gaps;
+
+    hostSend(keyEnable);
+    hostSend(fastRepeat);
+    keys  = holdKeys(0x00, { BT_KEY_A }, 700);
+    gaps  = repeatGaps(keys, X68K_KEY_A);
+    if(CHECK(gaps.size() >= 8 && gaps.size() <= 10))
+    {
+        CHECK(std::abs(gaps[0] - 300.0) < 15.0);
+        gaps.erase(gaps.begin());
+        CHECK(std::abs(median(gaps) - 50.0) < 5.0);
+        CHECK(std::abs(span(gaps) - gaps.size() * 50.0) < 8.0);
+        CHECK_EQ(keys.back().code, X68K_KEY_A | X68K_BREAK);
+    }
+
+    hostSend(quickRepeat);
+    keys  = holdKeys(0x00, { BT_KEY_A }, 500);
+    gaps  = repeatGaps(keys, X68K_KEY_A);
+    if(CHECK(gaps.size() >= 8 && gaps.size() <= 10))
+    {
+        CHECK(std::abs(gaps[0] - 200.0) < 15.0);
+        gaps.erase(gaps.begin());
+        CHECK(std::abs(median(gaps) - 35.0) < 5.0);
+        CHECK(std::abs(span(gaps) - gaps.size() * 35.0) < 8.0);
+    }
+    hostSend(defRepeat);
+}
+
+// Repeats end with the release, nothing follows the break.
+TEST_CASE(releaseEndsRepeat)
+{
+    // Locals.
+    //
+    std::vector<t_rcvKey>               keys;
+
+    hostSend(quickRepeat);
+    keys = holdKeys(0x00, { BT_KEY_A }, 400);
+    CHECK_EQ(keys.back().code, X68K_KEY_A | X68K_BREAK);
+    CHECK(hostCapture(400).empty());
+    hostSend(defRepeat);
+}
+
+// The most recently pressed key repeats, releasing it doesnt restart the repeat of a key still held.
+TEST_CASE(lastKeyRepeats)
+{
+    // Locals.
+    //
+    std::vector<t_rcvKey>               keys;
+    std::chrono::steady_clock::time_point start;
+
+    hostSend(quickRepeat);
+    start = std::chrono::steady_clock::now();
+    HostHarness::keyReport(0x00, { BT_KEY_A });
+    Shim::settle(100);
+    HostHarness::keyReport(0x00, { BT_KEY_A, BT_KEY_B });
+    keys = hostCapture(500, start);
+    CHECK_EQ(repeatGaps(keys, X68K_KEY_A).size(), 0u);
+    CHECK(repeatGaps(keys, X68K_KEY_B).size() >= 5);
+
+    HostHarness::keyReport(0x00, { BT_KEY_A });
+    CHECK(codes(hostCapture(400)) == std::vector<uint8_t>({ X68K_KEY_B | X68K_BREAK }));
+    HostHarness::keyReport(0x00, {});
+    CHECK(codes(hostCapture(100)) == std::vector<uint8_t>({ X68K_KEY_A | X68K_BREAK }));
+    hostSend(defRepeat);
+}
+
+// Modifier keys never repeat.
+TEST_CASE(modifiersDontRepeat)
+{
+    hostSend(quickRepeat);
+    CHECK(codes(holdKeys(BT_MOD_L_SHIFT, {}, 600)) == std::vector<uint8_t>({ X68K_KEY_SHIFT, X68K_KEY_SHIFT | X68K_BREAK }));
+    hostSend(defRepeat);
+}
+
+// Whilst the host inhibits key data no make or repeat is sent, breaks still are so the host is not left with a key held.
+TEST_CASE(hostInhibitsKeys)
+{
+    // Locals.
+    //
+    std::vector<t_rcvKey>               keys;
+    std::chrono::steady_clock::time_point start;
+
+    hostSend(quickRepeat);
+    hostSend(keyInhibit);
+    CHECK(codes(holdKeys(0x00, { BT_KEY_A }, 400)) == std::vector<uint8_t>({ X68K_KEY_A | X68K_BREAK }));
+
+    // Inhibited part way through a repeat, the repeats stop and the break is sent.
+    hostSend(keyEnable);
+    start = std::chrono::steady_clock::now();
+    HostHarness::keyReport(0x00, { BT_KEY_A });
+    keys = hostCapture(300, start);
+    CHECK(repeatGaps(keys, X68K_KEY_A).size() >= 2);
+    hostSend(keyInhibit);
+    hostCapture(20);
+    CHECK(hostCapture(200).empty());
+    HostHarness::keyReport(0x00, {});
+    CHECK(codes(hostCapture(100)) == std::vector<uint8_t>({ X68K_KEY_A | X68K_BREAK }));
+
+    hostSend(keyEnable);
+    CHECK(codes(holdKeys(0x00, { BT_KEY_A }, 100)) == std::vector<uint8_t>({ X68K_KEY_A, X68K_KEY_A | X68K_BREAK }));
+    hostSend(defRepeat);
+}
+
+// Brightness and poll bytes change nothing, the LEDs are not touched and key data flows.
+TEST_CASE(brightnessAndPollsIgnored)
+{
+    // Locals.
+    //
+    uint32_t                            sent;
+
+    hostSend(ledsOff);
+    sent = ledReports();
+    hostSend(brightness);
+    CHECK_EQ(ledReports(), sent);
+    CHECK(codes(holdKeys(0x00, { BT_KEY_A }, 100)) == std::vector<uint8_t>({ X68K_KEY_A, X68K_KEY_A | X68K_BREAK }));
+}
+
+// Each key is timed through every stage from the Bluetooth report to the byte sent to the host, repeats through the queue and output only.
+TEST_CASE(keyLatencyRecorded)
+{
+    // Locals.
+    //
+    HostHarness::t_latency              before = HostHarness::latency();
+    std::vector<t_rcvKey>               keys;
+    uint32_t                            hostCodes = 0;
+
+    for(int idx = 0; idx < LATENCY_TAPS; idx++)
+    {
+        keys = holdKeys(0x00, { BT_KEY_A }, 30);
+        CHECK(codes(keys) == std::vector<uint8_t>({ X68K_KEY_A, X68K_KEY_A | X68K_BREAK }));
+        hostCodes += keys.size();
+    }
+    HostHarness::latencyRecorded(before, 2 * LATENCY_TAPS, hostCodes);
+
+    hostSend(quickRepeat);
+    before = HostHarness::latency();
+    keys = holdKeys(0x00, { BT_KEY_A }, 400);
+    CHECK(keys.size() > 4);
+    HostHarness::latencyRecorded(before, 2, keys.size(), keys.size(), 2);
+    hostSend(defRepeat);
+}
+
+// The host inhibiting key data during macro playback refuses keys, each inhibit widens the gap between macro keys well beyond the pace the
+// host set before it.
+TEST_CASE(inhibitSlowsMacro)
+{
+    // Locals.
+    //
+    std::string                         fileName = HostHarness::host().fsPath + "/inhibit.txt";
+    std::chrono::steady_clock::time_point start;
+    std::vector<double>                 before;
+    std::vector<double>                 after;
+
+    std::ofstream(fileName) << std::string(80, 'a');
+    hostSend(keyEnable);
+    hostCapture(20);
+    start = std::chrono::steady_clock::now();
+    CHECK(x68k().macroPlay(fileName));
+    before = repeatGaps(hostCapture(KEYMACRO_START_DELAY_MS + 150, start), X68K_KEY_A);
+
+    for(int idx = 0; idx < MACRO_INHIBITS; idx++)
+    {
+        CHECK_EQ(write(Shim::uartHostFd(X68K_UART), keyInhibit.data(), keyInhibit.size()), (ssize_t)keyInhibit.size());
+        Shim::settle(30);
+        CHECK_EQ(write(Shim::uartHostFd(X68K_UART), keyEnable.data(), keyEnable.size()), (ssize_t)keyEnable.size());
+        Shim::settle(5);
+    }
+    hostCapture(2);
+    after = repeatGaps(hostCapture(KEYMACRO_GAP_MAX_MS * 4), X68K_KEY_A);
+
+    CHECK(before.size() >= 4);
+    CHECK(after.size() >= 1);
+    CHECK(median(before) < 30.0);
+    CHECK(after.empty() == false && after[0] > 60.0);
+
+    x68k().macroCancel();
+    for(int waited = 0; waited < 1000 && x68k().macroActive(); waited += 10)
+        Shim::settle(10);
+    CHECK(x68k().macroActive() == false);
+    hostCapture(50);
+}
+
+TEST_MAIN()
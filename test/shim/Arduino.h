@@ -0,0 +1,76 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            Arduino.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the arduino-esp32 core API used by the PS/2 drivers. Pin functions act on
+//                  the shim virtual GPIO, an attached interrupt is raised on the matching edge of the pin
+//                  level.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ARDUINO_H
+#define SHIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+
+#define LOW                             0x0
+#define HIGH                            0x1
+
+#define INPUT                           0x01
+#define OUTPUT                          0x02
+#define PULLUP                          0x04
+#define INPUT_PULLUP                    0x05
+#define PULLDOWN                        0x08
+#define INPUT_PULLDOWN                  0x09
+#define OPEN_DRAIN                      0x10
+#define OUTPUT_OPEN_DRAIN               0x12
+
+#define RISING                          0x01
+#define FALLING                         0x02
+#define CHANGE                          0x03
+
+#define digitalPinToInterrupt(p)        (((p) < 40) ? (p) : -1)
+
+typedef void                          (*voidFuncPtr)(void);
+typedef uint8_t                         byte;
+
+void                                    pinMode(uint8_t pin, uint8_t mode);
+void                                    digitalWrite(uint8_t pin, uint8_t val);
+int                                     digitalRead(uint8_t pin);
+void                                    attachInterrupt(uint8_t pin, voidFuncPtr handler, int mode);
+void                                    detachInterrupt(uint8_t pin);
+unsigned long                           millis(void);
+unsigned long                           micros(void);
+void                                    delay(uint32_t ms);
+void                                    delayMicroseconds(uint32_t us);
+
+#endif // SHIM_ARDUINO_H
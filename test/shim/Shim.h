@@ -0,0 +1,125 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            Shim.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Test control interface of the host shim. Lets a test freeze and step the clock, drive
+//                  and sample the virtual GPIO, play the host end of a UART and inspect what the firmware
+//                  wrote to the LEDC and NVS.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           The shim is a stand in for the target, it models the behaviour the SharpKey classes rely on rather than the silicon.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_H
+#define SHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_hidh.h"
+
+namespace Shim
+{
+    // Clock. Time runs with the host clock until frozen, once frozen it only moves when a test advances it. Advancing steps
+    // through every timer event due in the interval, in deadline order, running its callback at the event time.
+    void                                freezeTime(void);
+    void                                releaseTime(void);
+    bool                                isTimeFrozen(void);
+    int64_t                             now(void);
+    void                                advanceTime(int64_t us);
+
+    // Reads of a hardware timer counter. A task spinning on the counter reads it continuously, so with a frozen clock two further reads
+    // after advancing time show the task has seen the new time and acted on it.
+    uint64_t                            timerCounterReads(void);
+
+    // Give the interface threads real time to act on whatever the test just did.
+    void                                settle(uint32_t ms = 20);
+
+    // Wait, in real time, until a task is blocked on a condition it cannot meet without the test or has ended. Used with a frozen
+    // clock to let the woken tasks run before time is advanced again. Returns false on timeout.
+    bool                                waitBlocked(TaskHandle_t task, uint32_t timeoutMs = 2000);
+
+    // Virtual GPIO. The external level defaults to high (pulled up), interrupts are raised in the caller on a level change.
+    void                                setInput(int pin, int level);
+    int                                 getLevel(int pin);
+    int                                 getOutput(int pin);
+    uint32_t                            gpioEdgeCount(int pin);
+
+    // Output latch writes on a traced pin, each with the time it was made, whether or not the level changed. Starting a trace clears it.
+    struct t_gpioWrite
+    {
+        int64_t                         timeUs;
+        int                             level;
+    };
+    void                                gpioTrace(int pin);
+    std::vector<t_gpioWrite>            gpioWrites(int pin);
+
+    // UART, each installed port is a pseudo terminal. The returned descriptor is the host end of the line.
+    int                                 uartHostFd(int port);
+    void                                uartBreak(int port);
+
+    // Tx line of a traced port as the UART would serialise it, one level per bit period from the start bit to the last stop bit of each
+    // byte, following the configured data bits, parity, stop bits and inversion. Idle time between bytes is not recorded.
+    void                                uartTrace(int port);
+    std::vector<uint8_t>                uartTxBits(int port);
+
+    // Recorded peripheral output.
+    uint32_t                            ledcFreq(void);
+    uint32_t                            ledcDuty(void);
+    uint32_t                            ledcClockHz(void);
+
+    // LED output level at the current time, from the duty, the frequency and the time of the last timer reset.
+    int                                 ledcLevel(void);
+
+    // NVS, wipe every namespace as an erased flash would.
+    void                                nvsErase(void);
+
+    // Number of writes made to a key, in any namespace.
+    uint32_t                            nvsWrites(const char *key);
+
+    // HID host, create a device handle and raise events against it through the callback registered with esp_hidh_init.
+    esp_hidh_dev_t                     *hidhCreateDevice(const uint8_t *bda, esp_hid_transport_t transport, esp_hid_usage_t usage, const char *name);
+    void                                hidhOpen(esp_hidh_dev_t *dev);
+    void                                hidhClose(esp_hidh_dev_t *dev);
+    void                                hidhInput(esp_hidh_dev_t *dev, esp_hid_usage_t usage, uint16_t reportId, const uint8_t *data, uint16_t length);
+    std::vector<uint8_t>                hidhOutput(esp_hidh_dev_t *dev);
+    uint32_t                            hidhOutputCount(esp_hidh_dev_t *dev);
+
+    // HID host open, the time esp_hidh_dev_open blocks before the link is up and the number of opens made of a device.
+    void                                hidhOpenDelay(esp_hidh_dev_t *dev, uint32_t ms);
+    uint32_t                            hidhOpenCount(esp_hidh_dev_t *dev);
+
+    // Bluetooth GAP. Bonded devices are returned by the bond lists. Each BLE scan reports the devices advertising the HID service then
+    // completes after the scan time, in real milli-seconds, rather than the requested duration. No BT Classic device is discoverable.
+    void                                btBond(const uint8_t *bda, esp_hid_transport_t transport);
+    void                                bleAdvertise(const uint8_t *bda, const char *name);
+    void                                btScanTime(uint32_t ms);
+
+    // Restarts requested by the firmware. esp_restart throws Restart, a task is ended by it, a test can catch it.
+    struct Restart {};
+    uint32_t                            restartCount(void);
+}
+
+#endif // SHIM_H
@@ -0,0 +1,634 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            ShimBT.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the Bluedroid stack and the ESP HID host. Stack calls succeed without a
+//                  radio, HID host events are raised by the test against shim owned device handles and
+//                  delivered on an event thread as the HID host event loop does on the target.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           The shim is a stand in for the target, it models the behaviour the SharpKey classes rely on rather than the silicon.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "esp_bt.h"
+#include "esp_bt_defs.h"
+#include "esp_bt_main.h"
+#include "esp_bt_device.h"
+#include "esp_gap_bt_api.h"
+#include "esp_gap_ble_api.h"
+#include "esp_hid_common.h"
+#include "esp_hidh.h"
+#include "Shim.h"
+
+struct esp_hidh_dev_s
+{
+    esp_bd_addr_t                       bda;
+    esp_hid_transport_t                 transport;
+    esp_hid_usage_t                     usage;
+    std::string                         name;
+    std::vector<uint8_t>                output;
+    uint32_t                            outputCount;
+    uint32_t                            openDelayMs;
+    uint32_t                            openCount;
+};
+
+namespace
+{
+    // HID host event awaiting delivery, the data is owned by the event so the callback sees a stable buffer.
+    struct t_hidhEvent
+    {
+        esp_hidh_event_t                id;
+        esp_hidh_event_data_t           param;
+        std::vector<uint8_t>            data;
+        uint64_t                        seq;
+    };
+
+    std::mutex                          hidhLock;
+    std::condition_variable             hidhWake;
+    std::deque<t_hidhEvent>             hidhEvents;
+    uint64_t                            hidhPosted = 0;
+    uint64_t                            hidhDelivered = 0;
+    esp_hidh_config_t                   hidhConfig;
+    bool                                hidhRunning = false;
+    std::vector<esp_hidh_dev_t *>       hidhDevices;
+
+    // GAP state, bonded devices, devices advertising the HID service and the callbacks the scan results are delivered to.
+    struct t_advert
+    {
+        esp_bd_addr_t                   bda;
+        std::string                     name;
+    };
+    std::mutex                          gapLock;
+    std::vector<esp_ble_bond_dev_t>     bleBonds;
+    std::vector<std::array<uint8_t, ESP_BD_ADDR_LEN>> btBonds;
+    std::vector<t_advert>               bleAdverts;
+    uint32_t                            scanTimeMs = 0;
+    esp_gap_ble_cb_t                    bleGapCallback = NULL;
+    esp_bt_gap_cb_t                     btGapCallback = NULL;
+
+    void hidhDispatcher(void)
+    {
+        std::unique_lock<std::mutex> lk(hidhLock);
+        for(;;)
+        {
+            hidhWake.wait(lk, [](void) { return(!hidhEvents.empty()); });
+            t_hidhEvent event = hidhEvents.front();
+            hidhEvents.pop_front();
+            if(event.id == ESP_HIDH_INPUT_EVENT)
+                event.param.input.data = event.data.data();
+            lk.unlock();
+            if(hidhConfig.callback != NULL)
+                hidhConfig.callback(hidhConfig.callback_arg, "ESP_HIDH_EVENTS", event.id, &event.param);
+            lk.lock();
+            hidhDelivered = event.seq;
+            hidhWake.notify_all();
+        }
+    }
+
+    uint64_t hidhPost(esp_hidh_event_t id, const esp_hidh_event_data_t &param, const uint8_t *data, uint16_t length)
+    {
+        // Locals.
+        //
+        t_hidhEvent                 event;
+
+        std::lock_guard<std::mutex> lk(hidhLock);
+        event.id    = id;
+        event.param = param;
+        if(data != NULL)
+            event.data.assign(data, data + length);
+        event.seq   = ++hidhPosted;
+
+        // Without esp_hidh_init there is no event task, the event is dropped as on the target.
+        if(!hidhRunning)
+        {
+            hidhDelivered = event.seq;
+            return(event.seq);
+        }
+        hidhEvents.push_back(event);
+        hidhWake.notify_all();
+        return(event.seq);
+    }
+
+    // Test initiated events are delivered before the test continues.
+    void hidhWait(uint64_t seq)
+    {
+        std::unique_lock<std::mutex> lk(hidhLock);
+        hidhWake.wait(lk, [seq](void) { return(hidhDelivered >= seq); });
+    }
+
+    // Walk an EIR or advertising block of length, type, data records.
+    uint8_t *resolveRecord(uint8_t *block, size_t blockLen, uint8_t type, uint8_t *length)
+    {
+        // Locals.
+        //
+        size_t                      pos = 0;
+
+        *length = 0;
+        if(block == NULL)
+            return(NULL);
+        while(pos < blockLen && block[pos] != 0)
+        {
+            if(pos + 1 + block[pos] > blockLen)
+                break;
+            if(block[pos + 1] == type)
+            {
+                *length = block[pos] - 1;
+                return(&block[pos + 2]);
+            }
+            pos += 1 + block[pos];
+        }
+        return(NULL);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Controller and stack.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg)                 { return(ESP_OK); }
+esp_err_t esp_bt_controller_deinit(void)                                          { return(ESP_OK); }
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode)                            { return(ESP_OK); }
+esp_err_t esp_bt_controller_disable(void)                                         { return(ESP_OK); }
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode)                       { return(ESP_OK); }
+esp_err_t esp_ble_tx_power_set(esp_ble_power_type_t power_type, esp_power_level_t power_level) { return(ESP_OK); }
+esp_err_t esp_bredr_tx_power_set(esp_power_level_t min_power_level, esp_power_level_t max_power_level) { return(ESP_OK); }
+esp_err_t esp_bluedroid_init(void)                                                { return(ESP_OK); }
+esp_err_t esp_bluedroid_deinit(void)                                              { return(ESP_OK); }
+esp_err_t esp_bluedroid_enable(void)                                              { return(ESP_OK); }
+esp_err_t esp_bluedroid_disable(void)                                             { return(ESP_OK); }
+esp_err_t esp_bt_dev_set_device_name(const char *name)                            { return(ESP_OK); }
+
+const uint8_t *esp_bt_dev_get_address(void)
+{
+    static const uint8_t address[ESP_BD_ADDR_LEN] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+    return(address);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Classic GAP.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_bt_gap_set_scan_mode(esp_bt_connection_mode_t c_mode, esp_bt_discovery_mode_t d_mode) { return(ESP_OK); }
+esp_err_t esp_bt_gap_cancel_discovery(void)                                       { return(ESP_OK); }
+esp_err_t esp_bt_gap_set_pin(esp_bt_pin_type_t pin_type, uint8_t pin_code_len, esp_bt_pin_code_t pin_code) { return(ESP_OK); }
+esp_err_t esp_bt_gap_set_security_param(esp_bt_sp_param_t param_type, void *value, uint8_t len) { return(ESP_OK); }
+
+esp_err_t esp_bt_gap_register_callback(esp_bt_gap_cb_t callback)
+{
+    std::lock_guard<std::mutex> lk(gapLock);
+    btGapCallback = callback;
+    return(ESP_OK);
+}
+
+// No BT Classic device is discoverable, the inquiry starts and stops.
+esp_err_t esp_bt_gap_start_discovery(esp_bt_inq_mode_t mode, uint8_t inq_len, uint8_t num_rsps)
+{
+    // Locals.
+    //
+    esp_bt_gap_cb_param_t           param;
+    esp_bt_gap_cb_t                 callback;
+
+    {
+        std::lock_guard<std::mutex> lk(gapLock);
+        callback = btGapCallback;
+    }
+    if(callback != NULL)
+    {
+        memset(&param, 0, sizeof(param));
+        param.disc_st_chg.state = ESP_BT_GAP_DISCOVERY_STARTED;
+        callback(ESP_BT_GAP_DISC_STATE_CHANGED_EVT, &param);
+        param.disc_st_chg.state = ESP_BT_GAP_DISCOVERY_STOPPED;
+        callback(ESP_BT_GAP_DISC_STATE_CHANGED_EVT, &param);
+    }
+    return(ESP_OK);
+}
+
+int esp_bt_gap_get_bond_device_num(void)
+{
+    std::lock_guard<std::mutex> lk(gapLock);
+    return((int)btBonds.size());
+}
+
+esp_err_t esp_bt_gap_get_bond_device_list(int *dev_num, esp_bd_addr_t *dev_list)
+{
+    std::lock_guard<std::mutex> lk(gapLock);
+    *dev_num = *dev_num < (int)btBonds.size() ? *dev_num : (int)btBonds.size();
+    for(int idx = 0; idx < *dev_num; idx++)
+        memcpy(dev_list[idx], btBonds[idx].data(), sizeof(esp_bd_addr_t));
+    return(ESP_OK);
+}
+
+uint8_t *esp_bt_gap_resolve_eir_data(uint8_t *eir, esp_bt_eir_type_t type, uint8_t *length)
+{
+    return(resolveRecord(eir, 240, type, length));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BLE GAP.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_ble_gattc_register_callback(esp_gattc_cb_t callback)                { return(ESP_OK); }
+esp_err_t esp_ble_gap_stop_scanning(void)                                         { return(ESP_OK); }
+esp_err_t esp_ble_gap_set_security_param(esp_ble_sm_param_t param_type, void *value, uint8_t len) { return(ESP_OK); }
+esp_err_t esp_ble_gap_security_rsp(esp_bd_addr_t bd_addr, bool accept)            { return(ESP_OK); }
+esp_err_t esp_ble_passkey_reply(esp_bd_addr_t bd_addr, bool accept, uint32_t passkey) { return(ESP_OK); }
+esp_err_t esp_ble_confirm_reply(esp_bd_addr_t bd_addr, bool accept)               { return(ESP_OK); }
+
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback)
+{
+    std::lock_guard<std::mutex> lk(gapLock);
+    bleGapCallback = callback;
+    return(ESP_OK);
+}
+
+esp_err_t esp_ble_gap_set_scan_params(esp_ble_scan_params_t *scan_params)
+{
+    // Locals.
+    //
+    esp_ble_gap_cb_param_t          param;
+    esp_gap_ble_cb_t                callback;
+
+    {
+        std::lock_guard<std::mutex> lk(gapLock);
+        callback = bleGapCallback;
+    }
+    if(callback != NULL)
+    {
+        memset(&param, 0, sizeof(param));
+        callback(ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT, &param);
+    }
+    return(ESP_OK);
+}
+
+// The scan runs for the shim scan time rather than the requested duration, each advertising device is reported then the scan completes.
+esp_err_t esp_ble_gap_start_scanning(uint32_t duration)
+{
+    // Locals.
+    //
+    esp_ble_gap_cb_param_t          param;
+    esp_gap_ble_cb_t                callback;
+    std::vector<t_advert>           adverts;
+    uint32_t                        scanTime;
+    int                             pos;
+    const uint8_t                   uuid[2] = { (uint8_t)(ESP_GATT_UUID_HID_SVC & 0xFF), (uint8_t)(ESP_GATT_UUID_HID_SVC >> 8) };
+    const uint8_t                   appearance[2] = { 0xC1, 0x03 };
+    auto                            addRecord = [&param, &pos](uint8_t type, const uint8_t *data, size_t len)
+    {
+        param.scan_rst.ble_adv[pos++] = (uint8_t)(len + 1);
+        param.scan_rst.ble_adv[pos++] = type;
+        memcpy(&param.scan_rst.ble_adv[pos], data, len);
+        pos += len;
+    };
+
+    {
+        std::lock_guard<std::mutex> lk(gapLock);
+        callback = bleGapCallback;
+        adverts  = bleAdverts;
+        scanTime = scanTimeMs;
+    }
+    if(callback == NULL)
+        return(ESP_OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(scanTime));
+    for(const t_advert &advert : adverts)
+    {
+        memset(&param, 0, sizeof(param));
+        pos = 0;
+        param.scan_rst.search_evt    = ESP_GAP_SEARCH_INQ_RES_EVT;
+        param.scan_rst.ble_addr_type = BLE_ADDR_TYPE_RANDOM;
+        param.scan_rst.rssi          = -50;
+        memcpy(param.scan_rst.bda, advert.bda, sizeof(esp_bd_addr_t));
+        addRecord(ESP_BLE_AD_TYPE_16SRV_CMPL, uuid, sizeof(uuid));
+        addRecord(ESP_BLE_AD_TYPE_APPEARANCE, appearance, sizeof(appearance));
+        addRecord(ESP_BLE_AD_TYPE_NAME_CMPL, (const uint8_t *)advert.name.c_str(), advert.name.size());
+        callback(ESP_GAP_BLE_SCAN_RESULT_EVT, &param);
+    }
+    memset(&param, 0, sizeof(param));
+    param.scan_rst.search_evt = ESP_GAP_SEARCH_INQ_CMPL_EVT;
+    param.scan_rst.num_resps  = adverts.size();
+    callback(ESP_GAP_BLE_SCAN_RESULT_EVT, &param);
+    return(ESP_OK);
+}
+
+int esp_ble_get_bond_device_num(void)
+{
+    std::lock_guard<std::mutex> lk(gapLock);
+    return((int)bleBonds.size());
+}
+
+esp_err_t esp_ble_get_bond_device_list(int *dev_num, esp_ble_bond_dev_t *dev_list)
+{
+    std::lock_guard<std::mutex> lk(gapLock);
+    *dev_num = *dev_num < (int)bleBonds.size() ? *dev_num : (int)bleBonds.size();
+    for(int idx = 0; idx < *dev_num; idx++)
+        dev_list[idx] = bleBonds[idx];
+    return(ESP_OK);
+}
+
+uint8_t *esp_ble_resolve_adv_data(uint8_t *adv_data, uint8_t type, uint8_t *length)
+{
+    return(resolveRecord(adv_data, ESP_BLE_ADV_DATA_LEN_MAX + ESP_BLE_SCAN_RSP_DATA_LEN_MAX, type, length));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HID common.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_hid_usage_t esp_hid_usage_from_appearance(uint16_t appearance)
+{
+    switch(appearance)
+    {
+        case 0x03C1:    return(ESP_HID_USAGE_KEYBOARD);
+        case 0x03C2:    return(ESP_HID_USAGE_MOUSE);
+        case 0x03C3:    return(ESP_HID_USAGE_JOYSTICK);
+        case 0x03C4:    return(ESP_HID_USAGE_GAMEPAD);
+        case 0x03C5:    return(ESP_HID_USAGE_TABLET);
+        default:        return(ESP_HID_USAGE_GENERIC);
+    }
+}
+
+// Class of device, minor bits 4 and 5 of a peripheral flag a keyboard and a pointing device.
+esp_hid_usage_t esp_hid_usage_from_cod(uint32_t cod)
+{
+    // Locals.
+    //
+    uint32_t                        major = (cod >> 8) & 0x1F;
+    uint32_t                        minor = (cod >> 2) & 0x3F;
+
+    if(major != ESP_BT_COD_MAJOR_DEV_PERIPHERAL)
+        return(ESP_HID_USAGE_GENERIC);
+    if(minor & 0x10)
+        return(ESP_HID_USAGE_KEYBOARD);
+    if(minor & 0x20)
+        return(ESP_HID_USAGE_MOUSE);
+    switch(minor & 0x0F)
+    {
+        case 1:         return(ESP_HID_USAGE_JOYSTICK);
+        case 2:         return(ESP_HID_USAGE_GAMEPAD);
+        case 5:         return(ESP_HID_USAGE_TABLET);
+        default:        return(ESP_HID_USAGE_GENERIC);
+    }
+}
+
+const char *esp_hid_usage_str(esp_hid_usage_t usage)
+{
+    switch(usage)
+    {
+        case ESP_HID_USAGE_GENERIC:     return("GENERIC");
+        case ESP_HID_USAGE_KEYBOARD:    return("KEYBOARD");
+        case ESP_HID_USAGE_MOUSE:       return("MOUSE");
+        case ESP_HID_USAGE_JOYSTICK:    return("JOYSTICK");
+        case ESP_HID_USAGE_GAMEPAD:     return("GAMEPAD");
+        case ESP_HID_USAGE_TABLET:      return("TABLET");
+        case ESP_HID_USAGE_CCONTROL:    return("CCONTROL");
+        case ESP_HID_USAGE_VENDOR:      return("VENDOR");
+        default:                        return("UNKNOWN");
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HID host.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_hidh_init(const esp_hidh_config_t *config)
+{
+    std::lock_guard<std::mutex> lk(hidhLock);
+    hidhConfig = *config;
+    if(!hidhRunning)
+    {
+        hidhRunning = true;
+        std::thread(hidhDispatcher).detach();
+    }
+    return(ESP_OK);
+}
+
+// Opening a device known to the shim raises its open event, as the stack does once the link is up, an unknown device fails. The open
+// blocks for the link up delay of the device.
+esp_hidh_dev_t *esp_hidh_dev_open(esp_bd_addr_t bda, esp_hid_transport_t transport, uint8_t remote_addr_type)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                 *dev = NULL;
+    esp_hidh_event_data_t           param;
+    uint32_t                        delayMs = 0;
+
+    {
+        std::lock_guard<std::mutex> lk(hidhLock);
+        for(esp_hidh_dev_t *known : hidhDevices)
+        {
+            if(memcmp(known->bda, bda, sizeof(esp_bd_addr_t)) == 0)
+                dev = known;
+        }
+        if(dev != NULL)
+        {
+            dev->openCount++;
+            delayMs = dev->openDelayMs;
+        }
+    }
+    if(dev != NULL)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        memset(&param, 0, sizeof(param));
+        param.open.status = ESP_OK;
+        param.open.dev    = dev;
+        hidhPost(ESP_HIDH_OPEN_EVENT, param, NULL, 0);
+    }
+    return(dev);
+}
+
+esp_err_t esp_hidh_dev_close(esp_hidh_dev_t *dev)
+{
+    // Locals.
+    //
+    esp_hidh_event_data_t           param;
+
+    memset(&param, 0, sizeof(param));
+    param.close.dev = dev;
+    hidhPost(ESP_HIDH_CLOSE_EVENT, param, NULL, 0);
+    return(ESP_OK);
+}
+
+void esp_hidh_dev_dump(esp_hidh_dev_t *dev, FILE *fp)
+{
+}
+
+const uint8_t *esp_hidh_dev_bda_get(esp_hidh_dev_t *dev)
+{
+    return(dev->bda);
+}
+
+const char *esp_hidh_dev_name_get(esp_hidh_dev_t *dev)
+{
+    return(dev->name.c_str());
+}
+
+esp_hid_transport_t esp_hidh_dev_transport_get(esp_hidh_dev_t *dev)
+{
+    return(dev->transport);
+}
+
+esp_hid_usage_t esp_hidh_dev_usage_get(esp_hidh_dev_t *dev)
+{
+    return(dev->usage);
+}
+
+esp_err_t esp_hidh_dev_output_set(esp_hidh_dev_t *dev, size_t map_index, size_t report_id, uint8_t *value, size_t value_len)
+{
+    std::lock_guard<std::mutex> lk(hidhLock);
+    dev->output.assign(value, value + value_len);
+    dev->outputCount++;
+    return(ESP_OK);
+}
+
+esp_err_t esp_hidh_dev_get_report(esp_hidh_dev_t *dev, size_t map_index, size_t report_id, int report_type, size_t max_len)
+{
+    return(ESP_OK);
+}
+
+void esp_hidh_gattc_event_handler(int event, int gattc_if, void *param)
+{
+}
+
+esp_hidh_dev_t *Shim::hidhCreateDevice(const uint8_t *bda, esp_hid_transport_t transport, esp_hid_usage_t usage, const char *name)
+{
+    // Locals.
+    //
+    esp_hidh_dev_t                 *dev = new esp_hidh_dev_t;
+
+    memcpy(dev->bda, bda, sizeof(esp_bd_addr_t));
+    dev->transport   = transport;
+    dev->usage       = usage;
+    dev->name        = name;
+    dev->outputCount = 0;
+    dev->openDelayMs = 0;
+    dev->openCount   = 0;
+    std::lock_guard<std::mutex> lk(hidhLock);
+    hidhDevices.push_back(dev);
+    return(dev);
+}
+
+void Shim::hidhOpenDelay(esp_hidh_dev_t *dev, uint32_t ms)
+{
+    std::lock_guard<std::mutex> lk(hidhLock);
+    dev->openDelayMs = ms;
+}
+
+uint32_t Shim::hidhOpenCount(esp_hidh_dev_t *dev)
+{
+    std::lock_guard<std::mutex> lk(hidhLock);
+    return(dev->openCount);
+}
+
+void Shim::btBond(const uint8_t *bda, esp_hid_transport_t transport)
+{
+    // Locals.
+    //
+    esp_ble_bond_dev_t              bond;
+
+    std::lock_guard<std::mutex> lk(gapLock);
+    if(transport == ESP_HID_TRANSPORT_BLE)
+    {
+        memset(&bond, 0, sizeof(bond));
+        memcpy(bond.bd_addr, bda, sizeof(esp_bd_addr_t));
+        bleBonds.push_back(bond);
+    } else
+    {
+        btBonds.push_back(std::array<uint8_t, ESP_BD_ADDR_LEN>());
+        memcpy(btBonds.back().data(), bda, sizeof(esp_bd_addr_t));
+    }
+}
+
+void Shim::bleAdvertise(const uint8_t *bda, const char *name)
+{
+    // Locals.
+    //
+    t_advert                        advert;
+
+    memcpy(advert.bda, bda, sizeof(esp_bd_addr_t));
+    advert.name = name;
+    std::lock_guard<std::mutex> lk(gapLock);
+    bleAdverts.push_back(advert);
+}
+
+void Shim::btScanTime(uint32_t ms)
+{
+    std::lock_guard<std::mutex> lk(gapLock);
+    scanTimeMs = ms;
+}
+
+void Shim::hidhOpen(esp_hidh_dev_t *dev)
+{
+    // Locals.
+    //
+    esp_hidh_event_data_t           param;
+
+    memset(&param, 0, sizeof(param));
+    param.open.status = ESP_OK;
+    param.open.dev    = dev;
+    hidhWait(hidhPost(ESP_HIDH_OPEN_EVENT, param, NULL, 0));
+}
+
+void Shim::hidhClose(esp_hidh_dev_t *dev)
+{
+    // Locals.
+    //
+    esp_hidh_event_data_t           param;
+
+    memset(&param, 0, sizeof(param));
+    param.close.dev = dev;
+    hidhWait(hidhPost(ESP_HIDH_CLOSE_EVENT, param, NULL, 0));
+}
+
+void Shim::hidhInput(esp_hidh_dev_t *dev, esp_hid_usage_t usage, uint16_t reportId, const uint8_t *data, uint16_t length)
+{
+    // Locals.
+    //
+    esp_hidh_event_data_t           param;
+
+    memset(&param, 0, sizeof(param));
+    param.input.dev       = dev;
+    param.input.usage     = usage;
+    param.input.report_id = reportId;
+    param.input.length    = length;
+    hidhWait(hidhPost(ESP_HIDH_INPUT_EVENT, param, data, length));
+}
+
+std::vector<uint8_t> Shim::hidhOutput(esp_hidh_dev_t *dev)
+{
+    std::lock_guard<std::mutex> lk(hidhLock);
+    return(dev->output);
+}
+
+uint32_t Shim::hidhOutputCount(esp_hidh_dev_t *dev)
+{
+    std::lock_guard<std::mutex> lk(hidhLock);
+    return(dev->outputCount);
+}
@@ -0,0 +1,831 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            ShimIO.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF peripheral drivers and storage. GPIO pins are virtual with
+//                  wired-AND levels, each UART is a pseudo terminal, LEDC output is recorded and
+//                  NVS is held in memory.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           The shim is a stand in for the target, it models the behaviour the SharpKey classes rely on rather than the silicon.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_event.h"
+#include "esp_littlefs.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+#include "driver/ledc.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "Arduino.h"
+#include "Shim.h"
+#include "ShimKernel.h"
+
+gpio_dev_t GPIO;
+
+namespace
+{
+    using namespace ShimKernel;
+
+    #define SHIM_GPIO_PINS                  40
+
+    // Virtual pin. The level on the pin is the external level wired-AND with the output latch when the output is enabled.
+    struct
+    {
+        int                             external;
+        bool                            output;
+        int                             latch;
+        int                             level;
+        gpio_int_type_t                 intrType;
+        gpio_isr_t                      isr;
+        void                           *isrArg;
+        voidFuncPtr                     arduinoIsr;
+        int                             arduinoMode;
+        uint32_t                        edges;
+        bool                            traced;
+        std::vector<Shim::t_gpioWrite>  writes;
+    } pin[SHIM_GPIO_PINS];
+    std::mutex                          gpioLock;
+    bool                                gpioReady = false;
+
+    // Pseudo terminal backed UART port.
+    struct
+    {
+        bool                            installed;
+        int                             hostFd;
+        int                             devFd;
+        size_t                          rxSize;
+        std::deque<uint8_t>             rx;
+        QueueHandle_t                   eventQueue;
+        uart_config_t                   config;
+        uint32_t                        inverse;
+        bool                            traced;
+        std::vector<uint8_t>            txBits;
+    } uart[UART_NUM_MAX];
+
+    uint32_t                            ledcFrequency = 0;
+    uint32_t                            ledcDutyValue = 0;
+    uint32_t                            ledcPendingDuty = 0;
+    uint32_t                            ledcResolution = 10;
+    uint32_t                            ledcClock = 0;
+    int64_t                             ledcResetTime = 0;
+
+    std::mutex                          nvsLock;
+    std::map<std::string, std::map<std::string, std::vector<uint8_t>>> nvsStore;
+    std::map<std::string, uint32_t>     nvsKeyWrites;
+    std::vector<std::string>            nvsHandles;
+
+    void gpioInit(void)
+    {
+        if(gpioReady)
+            return;
+        for(int idx = 0; idx < SHIM_GPIO_PINS; idx++)
+        {
+            pin[idx].external    = 1;
+            pin[idx].output      = false;
+            pin[idx].latch       = 0;
+            pin[idx].level       = 1;
+            pin[idx].intrType    = GPIO_INTR_DISABLE;
+            pin[idx].isr         = NULL;
+            pin[idx].isrArg      = NULL;
+            pin[idx].arduinoIsr  = NULL;
+            pin[idx].arduinoMode = 0;
+            pin[idx].edges       = 0;
+            pin[idx].traced      = false;
+        }
+        gpioReady = true;
+    }
+
+    bool edgeMatches(int mode, int oldLevel, int newLevel)
+    {
+        return((mode == GPIO_INTR_POSEDGE && oldLevel == 0 && newLevel == 1) ||
+               (mode == GPIO_INTR_NEGEDGE && oldLevel == 1 && newLevel == 0) ||
+               (mode == GPIO_INTR_ANYEDGE));
+    }
+
+    // Recalculate the level of a pin after a change, with the GPIO lock held, and raise its interrupts once the lock is released.
+    void gpioUpdate(int gpioNum, std::unique_lock<std::mutex> &lk)
+    {
+        // Locals.
+        //
+        int                         oldLevel = pin[gpioNum].level;
+        int                         newLevel = pin[gpioNum].external & (pin[gpioNum].output ? pin[gpioNum].latch : 1);
+        gpio_isr_t                  isr = NULL;
+        void                       *isrArg = NULL;
+        voidFuncPtr                 arduinoIsr = NULL;
+
+        if(oldLevel == newLevel)
+            return;
+        pin[gpioNum].level = newLevel;
+        pin[gpioNum].edges++;
+        if(pin[gpioNum].isr != NULL && edgeMatches(pin[gpioNum].intrType, oldLevel, newLevel))
+        {
+            isr    = pin[gpioNum].isr;
+            isrArg = pin[gpioNum].isrArg;
+        }
+        if(pin[gpioNum].arduinoIsr != NULL && edgeMatches(pin[gpioNum].arduinoMode, oldLevel, newLevel))
+            arduinoIsr = pin[gpioNum].arduinoIsr;
+        lk.unlock();
+        if(isr != NULL)
+            isr(isrArg);
+        if(arduinoIsr != NULL)
+            arduinoIsr();
+        lk.lock();
+    }
+
+    // Set the output latch of a pin, with the GPIO lock held.
+    void gpioLatch(int gpioNum, int level, std::unique_lock<std::mutex> &lk)
+    {
+        pin[gpioNum].latch = level;
+        if(pin[gpioNum].traced)
+            pin[gpioNum].writes.push_back({ Shim::now(), level });
+        gpioUpdate(gpioNum, lk);
+    }
+
+    void gpioWriteMask(uint32_t mask, int level)
+    {
+        std::unique_lock<std::mutex> lk(gpioLock);
+        gpioInit();
+        for(int idx = 0; idx < 32; idx++)
+        {
+            if(mask & (1UL << idx))
+                gpioLatch(idx, level, lk);
+        }
+    }
+
+    // Serialise a byte as the UART would, start bit, data bits LSB first, parity then stop bits, inverted if the Tx line is.
+    void uartSerialise(int port, uint8_t data)
+    {
+        // Locals.
+        //
+        int                         dataBits = 5 + uart[port].config.data_bits;
+        int                         stopBits = uart[port].config.stop_bits == UART_STOP_BITS_1 ? 1 : 2;
+        int                         invert = (uart[port].inverse & UART_SIGNAL_TXD_INV) ? 1 : 0;
+        int                         parity = uart[port].config.parity == UART_PARITY_ODD ? 1 : 0;
+
+        uart[port].txBits.push_back(0 ^ invert);
+        for(int bit = 0; bit < dataBits; bit++)
+        {
+            uart[port].txBits.push_back(((data >> bit) & 1) ^ invert);
+            parity ^= (data >> bit) & 1;
+        }
+        if(uart[port].config.parity == UART_PARITY_EVEN || uart[port].config.parity == UART_PARITY_ODD)
+            uart[port].txBits.push_back(parity ^ invert);
+        // 1.5 stop bits is recorded as 2, the record is at bit resolution.
+        for(int bit = 0; bit < stopBits; bit++)
+            uart[port].txBits.push_back(1 ^ invert);
+    }
+
+    void uartReader(int port)
+    {
+        // Locals.
+        //
+        uint8_t                     buf[256];
+        ssize_t                     rcvCnt;
+        uart_event_t                event;
+
+        for(;;)
+        {
+            rcvCnt = read(uart[port].devFd, buf, sizeof(buf));
+            if(rcvCnt <= 0)
+            {
+                usleep(1000);
+                continue;
+            }
+            memset(&event, 0, sizeof(event));
+            {
+                std::lock_guard<std::mutex> lk(lock);
+                if(uart[port].rx.size() + rcvCnt > uart[port].rxSize)
+                {
+                    event.type = UART_BUFFER_FULL;
+                } else
+                {
+                    uart[port].rx.insert(uart[port].rx.end(), buf, buf + rcvCnt);
+                    event.type = UART_DATA;
+                    event.size = rcvCnt;
+                }
+                wake.notify_all();
+            }
+            xQueueSend(uart[port].eventQueue, &event, 0);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GPIO.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+shimGpioW1ts &shimGpioW1ts::operator=(uint32_t mask)
+{
+    gpioWriteMask(mask, 1);
+    return(*this);
+}
+
+shimGpioW1tc &shimGpioW1tc::operator=(uint32_t mask)
+{
+    gpioWriteMask(mask, 0);
+    return(*this);
+}
+
+uint32_t shimRegRead(uint32_t reg)
+{
+    // Locals.
+    //
+    uint32_t                        value = 0;
+    int                             first = reg == GPIO_IN1_REG ? 32 : 0;
+
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    for(int idx = first; idx < SHIM_GPIO_PINS && idx < first + 32; idx++)
+    {
+        if(pin[idx].level)
+            value |= (1UL << (idx - first));
+    }
+    return(value);
+}
+
+esp_err_t gpio_config(const gpio_config_t *pGPIOConfig)
+{
+    std::unique_lock<std::mutex> lk(gpioLock);
+    gpioInit();
+    for(int idx = 0; idx < SHIM_GPIO_PINS; idx++)
+    {
+        if(pGPIOConfig->pin_bit_mask & (1ULL << idx))
+        {
+            pin[idx].output   = (pGPIOConfig->mode & GPIO_MODE_OUTPUT) != 0;
+            pin[idx].intrType = pGPIOConfig->intr_type;
+            gpioUpdate(idx, lk);
+        }
+    }
+    return(ESP_OK);
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    std::unique_lock<std::mutex> lk(gpioLock);
+    gpioInit();
+    gpioLatch(gpio_num, level ? 1 : 0, lk);
+    return(ESP_OK);
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    return(pin[gpio_num].level);
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    std::unique_lock<std::mutex> lk(gpioLock);
+    gpioInit();
+    pin[gpio_num].output = (mode & GPIO_MODE_OUTPUT) != 0;
+    gpioUpdate(gpio_num, lk);
+    return(ESP_OK);
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    pin[gpio_num].intrType = intr_type;
+    return(ESP_OK);
+}
+
+esp_err_t gpio_set_drive_capability(gpio_num_t gpio_num, gpio_drive_cap_t strength)
+{
+    return(ESP_OK);
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    // Locals.
+    //
+    static bool                     installed = false;
+
+    std::lock_guard<std::mutex> lk(gpioLock);
+    if(installed)
+        return(ESP_ERR_INVALID_STATE);
+    installed = true;
+    return(ESP_OK);
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    pin[gpio_num].isr    = isr_handler;
+    pin[gpio_num].isrArg = args;
+    return(ESP_OK);
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    pin[gpio_num].isr = NULL;
+    return(ESP_OK);
+}
+
+void Shim::setInput(int gpioNum, int level)
+{
+    std::unique_lock<std::mutex> lk(gpioLock);
+    gpioInit();
+    pin[gpioNum].external = level ? 1 : 0;
+    gpioUpdate(gpioNum, lk);
+}
+
+int Shim::getLevel(int gpioNum)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    return(pin[gpioNum].level);
+}
+
+int Shim::getOutput(int gpioNum)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    return(pin[gpioNum].latch);
+}
+
+uint32_t Shim::gpioEdgeCount(int gpioNum)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    return(pin[gpioNum].edges);
+}
+
+void Shim::gpioTrace(int gpioNum)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    pin[gpioNum].traced = true;
+    pin[gpioNum].writes.clear();
+}
+
+std::vector<Shim::t_gpioWrite> Shim::gpioWrites(int gpioNum)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    return(pin[gpioNum].writes);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arduino core.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void pinMode(uint8_t gpioNum, uint8_t mode)
+{
+    gpio_set_direction((gpio_num_t)gpioNum, (mode & OUTPUT) ? GPIO_MODE_OUTPUT : GPIO_MODE_INPUT);
+}
+
+void digitalWrite(uint8_t gpioNum, uint8_t val)
+{
+    gpio_set_level((gpio_num_t)gpioNum, val);
+}
+
+int digitalRead(uint8_t gpioNum)
+{
+    return(gpio_get_level((gpio_num_t)gpioNum));
+}
+
+// Arduino edge modes share the encoding of the IDF interrupt types, RISING is a positive edge and FALLING a negative edge.
+void attachInterrupt(uint8_t gpioNum, voidFuncPtr handler, int mode)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    pin[gpioNum].arduinoIsr  = handler;
+    pin[gpioNum].arduinoMode = mode;
+}
+
+void detachInterrupt(uint8_t gpioNum)
+{
+    std::lock_guard<std::mutex> lk(gpioLock);
+    gpioInit();
+    pin[gpioNum].arduinoIsr = NULL;
+}
+
+unsigned long millis(void)
+{
+    return((unsigned long)(Shim::now() / 1000));
+}
+
+unsigned long micros(void)
+{
+    return((unsigned long)Shim::now());
+}
+
+void delay(uint32_t ms)
+{
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+// Busy waits on the target, on the host the wait is in shim time so a frozen clock is respected.
+void delayMicroseconds(uint32_t us)
+{
+    std::unique_lock<std::mutex> lk(lock);
+    waitUntil(lk, Shim::now() + us, [](void) { return(false); });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// UART.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    // Locals.
+    //
+    struct termios                  tio;
+    int                             hostFd;
+    int                             devFd;
+
+    if(uart_num < 0 || uart_num >= UART_NUM_MAX || uart[uart_num].installed)
+        return(ESP_ERR_INVALID_ARG);
+    hostFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(hostFd < 0 || grantpt(hostFd) != 0 || unlockpt(hostFd) != 0)
+        return(ESP_FAIL);
+    devFd = open(ptsname(hostFd), O_RDWR | O_NOCTTY);
+    if(devFd < 0)
+        return(ESP_FAIL);
+    tcgetattr(devFd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(devFd, TCSANOW, &tio);
+
+    uart[uart_num].installed  = true;
+    uart[uart_num].hostFd     = hostFd;
+    uart[uart_num].devFd      = devFd;
+    uart[uart_num].rxSize     = rx_buffer_size;
+    uart[uart_num].eventQueue = xQueueCreate(queue_size, sizeof(uart_event_t));
+    if(uart_queue != NULL)
+        *uart_queue = uart[uart_num].eventQueue;
+    std::thread(uartReader, (int)uart_num).detach();
+    return(ESP_OK);
+}
+
+esp_err_t uart_driver_delete(uart_port_t uart_num)
+{
+    return(ESP_OK);
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    uart[uart_num].config = *uart_config;
+    return(ESP_OK);
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return(ESP_OK);
+}
+
+esp_err_t uart_set_line_inverse(uart_port_t uart_num, uint32_t inverse_mask)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    uart[uart_num].inverse = inverse_mask;
+    return(ESP_OK);
+}
+
+esp_err_t uart_set_rx_full_threshold(uart_port_t uart_num, int threshold)
+{
+    return(ESP_OK);
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t uart_num, const uint8_t tout_thresh)
+{
+    return(ESP_OK);
+}
+
+esp_err_t uart_flush_input(uart_port_t uart_num)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    uart[uart_num].rx.clear();
+    return(ESP_OK);
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    tcdrain(uart[uart_num].devFd);
+    return(ESP_OK);
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    // Locals.
+    //
+    uint32_t                        rcvCnt = 0;
+
+    std::unique_lock<std::mutex> lk(lock);
+    waitUntil(lk, deadline(ticks_to_wait), [uart_num, length](void) { return(uart[uart_num].rx.size() >= length); });
+    while(rcvCnt < length && !uart[uart_num].rx.empty())
+    {
+        ((uint8_t *)buf)[rcvCnt++] = uart[uart_num].rx.front();
+        uart[uart_num].rx.pop_front();
+    }
+    return(rcvCnt);
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        for(size_t idx = 0; uart[uart_num].traced && idx < size; idx++)
+            uartSerialise(uart_num, ((const uint8_t *)src)[idx]);
+    }
+    return(write(uart[uart_num].devFd, src, size));
+}
+
+int Shim::uartHostFd(int port)
+{
+    return(uart[port].installed ? uart[port].hostFd : -1);
+}
+
+void Shim::uartTrace(int port)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    uart[port].traced = true;
+    uart[port].txBits.clear();
+}
+
+std::vector<uint8_t> Shim::uartTxBits(int port)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    return(uart[port].txBits);
+}
+
+void Shim::uartBreak(int port)
+{
+    // Locals.
+    //
+    uart_event_t                    event;
+
+    memset(&event, 0, sizeof(event));
+    event.type = UART_BREAK;
+    xQueueSend(uart[port].eventQueue, &event, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LEDC.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The timer divides its clock by an 18 bit divider with 8 fractional bits, 1 to 1023.99, then counts through the duty resolution. So
+// a clock bounds the frequency range, 80MHz APB from ~76Hz and 1MHz REF_TICK to ~976Hz at 10 bits. The automatic selection takes APB
+// if the frequency is within its range, otherwise REF_TICK, and ledc_set_freq keeps whichever clock the timer was configured with.
+namespace
+{
+    bool ledcDividerValid(uint32_t clock, uint32_t freq_hz)
+    {
+        // Locals.
+        //
+        uint64_t                    divider;
+
+        if(freq_hz == 0)
+            return(false);
+        divider = ((uint64_t)clock << 8) / ((uint64_t)freq_hz << ledcResolution);
+        return(divider >= 256 && divider <= 0x3FFFF);
+    }
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    // Locals.
+    //
+    uint32_t                        clock;
+
+    ledcResolution = timer_conf->duty_resolution;
+    switch(timer_conf->clk_cfg)
+    {
+        case LEDC_USE_REF_TICK:
+            clock = 1000000UL;
+            break;
+        case LEDC_USE_RTC8M_CLK:
+            clock = 8000000UL;
+            break;
+        case LEDC_USE_APB_CLK:
+            clock = 80000000UL;
+            break;
+        case LEDC_AUTO_CLK:
+        default:
+            clock = ledcDividerValid(80000000UL, timer_conf->freq_hz) ? 80000000UL : 1000000UL;
+            break;
+    }
+    if(!ledcDividerValid(clock, timer_conf->freq_hz))
+        return(ESP_FAIL);
+    ledcClock     = clock;
+    ledcFrequency = timer_conf->freq_hz;
+    ledcResetTime = Shim::now();
+    return(ESP_OK);
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf)
+{
+    ledcDutyValue = ledcPendingDuty = ledc_conf->duty;
+    return(ESP_OK);
+}
+
+esp_err_t ledc_set_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num, uint32_t freq_hz)
+{
+    if(!ledcDividerValid(ledcClock, freq_hz))
+        return(ESP_FAIL);
+    ledcFrequency = freq_hz;
+    return(ESP_OK);
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    ledcPendingDuty = duty;
+    return(ESP_OK);
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    ledcDutyValue = ledcPendingDuty;
+    return(ESP_OK);
+}
+
+esp_err_t ledc_timer_rst(ledc_mode_t speed_mode, ledc_timer_t timer_sel)
+{
+    ledcResetTime = Shim::now();
+    return(ESP_OK);
+}
+
+uint32_t Shim::ledcFreq(void)
+{
+    return(ledcFrequency);
+}
+
+uint32_t Shim::ledcDuty(void)
+{
+    return(ledcDutyValue);
+}
+
+uint32_t Shim::ledcClockHz(void)
+{
+    return(ledcClock);
+}
+
+// The counter starts from 0 on a reset and the output is high until it reaches the duty value.
+int Shim::ledcLevel(void)
+{
+    // Locals.
+    //
+    int64_t                         period;
+    int64_t                         phase;
+
+    if(ledcDutyValue == 0 || ledcFrequency == 0)
+        return(0);
+    if(ledcDutyValue >= (1UL << ledcResolution))
+        return(1);
+    period = 1000000LL / ledcFrequency;
+    phase  = (Shim::now() - ledcResetTime) % period;
+    return(phase < period * ledcDutyValue / (1LL << ledcResolution) ? 1 : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// NVS.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t nvs_flash_init(void)
+{
+    return(ESP_OK);
+}
+
+esp_err_t nvs_flash_deinit(void)
+{
+    return(ESP_OK);
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    Shim::nvsErase();
+    return(ESP_OK);
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    std::lock_guard<std::mutex> lk(nvsLock);
+    nvsHandles.push_back(name);
+    *out_handle = nvsHandles.size();
+    return(ESP_OK);
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    std::lock_guard<std::mutex> lk(nvsLock);
+    if(handle == 0 || handle > nvsHandles.size())
+        return(ESP_ERR_INVALID_ARG);
+    nvsStore[nvsHandles[handle - 1]][key].assign((const uint8_t *)value, (const uint8_t *)value + length);
+    nvsKeyWrites[key]++;
+    return(ESP_OK);
+}
+
+// As on the target a NULL buffer returns the stored size and a buffer smaller than the blob is an error.
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    std::lock_guard<std::mutex> lk(nvsLock);
+    if(handle == 0 || handle > nvsHandles.size())
+        return(ESP_ERR_INVALID_ARG);
+    auto ns = nvsStore.find(nvsHandles[handle - 1]);
+    if(ns == nvsStore.end() || ns->second.find(key) == ns->second.end())
+        return(ESP_ERR_NVS_NOT_FOUND);
+    std::vector<uint8_t> &blob = ns->second[key];
+    if(out_value != NULL)
+    {
+        if(*length < blob.size())
+            return(ESP_ERR_NVS_INVALID_LENGTH);
+        memcpy(out_value, blob.data(), blob.size());
+    }
+    *length = blob.size();
+    return(ESP_OK);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    std::lock_guard<std::mutex> lk(nvsLock);
+    if(handle == 0 || handle > nvsHandles.size())
+        return(ESP_ERR_INVALID_ARG);
+    return(nvsStore[nvsHandles[handle - 1]].erase(key) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND);
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return(ESP_OK);
+}
+
+void Shim::nvsErase(void)
+{
+    std::lock_guard<std::mutex> lk(nvsLock);
+    nvsStore.clear();
+}
+
+uint32_t Shim::nvsWrites(const char *key)
+{
+    std::lock_guard<std::mutex> lk(nvsLock);
+    return(nvsKeyWrites[key]);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// File system and event loop.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_vfs_littlefs_register(const esp_vfs_littlefs_conf_t *conf)
+{
+    return(ESP_OK);
+}
+
+esp_err_t esp_littlefs_info(const char *partition_label, size_t *total_bytes, size_t *used_bytes)
+{
+    *total_bytes = 1024 * 1024;
+    *used_bytes  = 0;
+    return(ESP_OK);
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return(ESP_OK);
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id, esp_event_handler_t event_handler,
+                                              void *event_handler_arg, esp_event_handler_instance_t *instance)
+{
+    return(ESP_OK);
+}
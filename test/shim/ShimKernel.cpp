@@ -0,0 +1,1114 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            ShimKernel.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the FreeRTOS kernel, the ESP-IDF high resolution and general purpose
+//                  timers and the system services. Tasks run as POSIX threads, every blocking primitive
+//                  waits on the kernel condition variable against a deadline in shim time so a frozen
+//                  clock stops time for the whole firmware.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           The shim is a stand in for the target, it models the behaviour the SharpKey classes rely on rather than the silicon.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "driver/timer.h"
+#include "Shim.h"
+#include "ShimKernel.h"
+
+// Kernel objects.
+struct shimTask
+{
+    std::string                         name;
+    UBaseType_t                         priority;
+    uint32_t                            stackDepth;
+    BaseType_t                          coreId;
+    uint32_t                            notifyCount;
+    UBaseType_t                         taskNumber;
+    pthread_t                           thread;
+
+    // Wait state for Shim::waitBlocked, the condition and deadline of the wait in progress.
+    const std::function<bool(void)>    *waitReady;
+    int64_t                             waitDeadline;
+    bool                                finished;
+};
+
+struct shimQueue
+{
+    UBaseType_t                         length;
+    UBaseType_t                         itemSize;
+    std::deque<std::vector<uint8_t>>    items;
+    shimQueue                          *set;
+};
+
+struct shimEventGroup
+{
+    EventBits_t                         bits;
+};
+
+struct shimTimer
+{
+    esp_timer_cb_t                      callback;
+    void                               *arg;
+    std::string                         name;
+    uint64_t                            period;
+    uint64_t                            eventId;
+    bool                                active;
+};
+
+namespace ShimKernel
+{
+    std::mutex                          lock;
+    std::condition_variable             wake;
+}
+
+namespace
+{
+    using namespace ShimKernel;
+
+    // Clock state. Real time is the host monotonic clock plus an offset which keeps shim time continuous across a freeze.
+    std::atomic<bool>                   timeFrozen(false);
+    std::atomic<int64_t>                frozenTime(0);
+    std::atomic<int64_t>                timeOffset(0);
+    const std::chrono::steady_clock::time_point timeBase = std::chrono::steady_clock::now();
+
+    // Timer events ordered by deadline then by scheduling order.
+    std::map<std::pair<int64_t, uint64_t>, std::function<void(void)>> events;
+    std::map<uint64_t, int64_t>         eventTimes;
+    uint64_t                            eventSeq = 0;
+    bool                                dispatcherRunning = false;
+
+    // Task registry.
+    std::vector<shimTask *>             tasks;
+    thread_local shimTask              *currentTask = NULL;
+    std::condition_variable             blockedWake;
+    std::atomic<uint32_t>               threadSeq(0);
+    thread_local uint32_t               threadToken = 0;
+
+    // General purpose hardware timers.
+    struct
+    {
+        int64_t                         baseTime;
+        uint64_t                        baseCount;
+        uint32_t                        divider;
+        bool                            running;
+        uint64_t                        alarmValue;
+        bool                            alarmEnabled;
+        uint64_t                        alarmEvent;
+        timer_isr_t                     isr;
+        void                           *isrArg;
+    } hwTimer[TIMER_GROUP_MAX][TIMER_MAX];
+    std::atomic<uint64_t>               counterReads(0);
+
+    std::atomic<uint32_t>               restarts(0);
+    esp_log_level_t                     logLevel = ESP_LOG_WARN;
+
+    int64_t realTime(void)
+    {
+        return(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeBase).count());
+    }
+
+    shimTask *newTask(const char *name, UBaseType_t priority, uint32_t stackDepth, BaseType_t coreId)
+    {
+        // Locals.
+        //
+        shimTask                       *task = new shimTask;
+
+        task->name        = name == NULL ? "" : name;
+        task->priority    = priority;
+        task->stackDepth  = stackDepth;
+        task->coreId      = coreId;
+        task->notifyCount = 0;
+        task->thread      = pthread_self();
+        task->waitReady   = NULL;
+        task->waitDeadline = -1;
+        task->finished    = false;
+        std::lock_guard<std::mutex> lk(lock);
+        task->taskNumber  = tasks.size() + 1;
+        tasks.push_back(task);
+        return(task);
+    }
+
+    // Threads not created through the task API, the test itself or the timer dispatcher, are registered on first use.
+    shimTask *selfTask(void)
+    {
+        if(currentTask == NULL)
+        {
+            currentTask = newTask("main", 1, 8192, 0);
+        }
+        return(currentTask);
+    }
+
+    void dispatcher(void)
+    {
+        // Locals.
+        //
+        std::unique_lock<std::mutex> lk(lock);
+        int64_t                     curTime;
+
+        currentTask = NULL;
+        for(;;)
+        {
+            if(events.empty() || timeFrozen)
+            {
+                wake.wait(lk);
+                continue;
+            }
+            curTime = Shim::now();
+            auto it = events.begin();
+            if(it->first.first <= curTime)
+            {
+                std::function<void(void)> callback = it->second;
+                eventTimes.erase(it->first.second);
+                events.erase(it);
+                lk.unlock();
+                callback();
+                lk.lock();
+                wake.notify_all();
+            } else
+            {
+                wake.wait_for(lk, std::chrono::microseconds(it->first.first - curTime));
+            }
+        }
+    }
+
+    BaseType_t queueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait, bool front)
+    {
+        // Locals.
+        //
+        std::unique_lock<std::mutex> lk(lock);
+        std::vector<uint8_t>        item(xQueue->itemSize);
+
+        if(!waitUntil(lk, deadline(xTicksToWait), [xQueue](void) { return(xQueue->items.size() < xQueue->length); }))
+            return(errQUEUE_FULL);
+        if(xQueue->itemSize > 0)
+            memcpy(item.data(), pvItemToQueue, xQueue->itemSize);
+        if(front)
+            xQueue->items.push_front(item);
+        else
+            xQueue->items.push_back(item);
+
+        // Members of a set post their handle to the set so a select returns the queue holding data.
+        if(xQueue->set != NULL)
+        {
+            std::vector<uint8_t> member(sizeof(QueueHandle_t));
+            memcpy(member.data(), &xQueue, sizeof(QueueHandle_t));
+            xQueue->set->items.push_back(member);
+        }
+        wake.notify_all();
+        return(pdTRUE);
+    }
+
+    void timerFire(esp_timer_handle_t timer)
+    {
+        // Locals.
+        //
+        esp_timer_cb_t              callback;
+        void                       *arg;
+
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            if(!timer->active)
+                return;
+            if(timer->period > 0)
+                timer->eventId = schedule(Shim::now() + timer->period, [timer](void) { timerFire(timer); });
+            else
+                timer->active = false;
+            callback = timer->callback;
+            arg      = timer->arg;
+        }
+        callback(arg);
+    }
+
+    uint64_t hwTimerCount(timer_group_t group, timer_idx_t idx)
+    {
+        if(!hwTimer[group][idx].running)
+            return(hwTimer[group][idx].baseCount);
+        return(hwTimer[group][idx].baseCount + (uint64_t)((Shim::now() - hwTimer[group][idx].baseTime) * 80 / hwTimer[group][idx].divider));
+    }
+
+    // Arm the alarm as a one shot event at the time the counter reaches the alarm value, the hardware disables the alarm when it fires.
+    void hwTimerArm(timer_group_t group, timer_idx_t idx)
+    {
+        // Locals.
+        //
+        int64_t                     alarmTime;
+        uint64_t                    count = hwTimerCount(group, idx);
+
+        if(hwTimer[group][idx].alarmEvent != 0)
+        {
+            cancel(hwTimer[group][idx].alarmEvent);
+            hwTimer[group][idx].alarmEvent = 0;
+        }
+        if(!hwTimer[group][idx].alarmEnabled || !hwTimer[group][idx].running)
+            return;
+
+        alarmTime = Shim::now();
+        if(hwTimer[group][idx].alarmValue > count)
+            alarmTime += (int64_t)((hwTimer[group][idx].alarmValue - count) * hwTimer[group][idx].divider / 80);
+        hwTimer[group][idx].alarmEvent = schedule(alarmTime, [group, idx](void)
+        {
+            timer_isr_t isr;
+            void       *isrArg;
+            {
+                std::lock_guard<std::mutex> lk(lock);
+                hwTimer[group][idx].alarmEvent   = 0;
+                hwTimer[group][idx].alarmEnabled = false;
+                isr    = hwTimer[group][idx].isr;
+                isrArg = hwTimer[group][idx].isrArg;
+            }
+            if(isr != NULL)
+                isr(isrArg);
+        });
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Kernel internals.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t ShimKernel::deadline(TickType_t ticks)
+{
+    if(ticks == portMAX_DELAY)
+        return(-1);
+    return(Shim::now() + (int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+bool ShimKernel::waitUntil(std::unique_lock<std::mutex> &lk, int64_t deadlineUs, const std::function<bool(void)> &ready)
+{
+    // Locals.
+    //
+    int64_t                         curTime;
+
+    for(;;)
+    {
+        if(ready())
+            return(true);
+        curTime = Shim::now();
+        if(deadlineUs >= 0 && curTime >= deadlineUs)
+            return(false);
+        if(currentTask != NULL)
+        {
+            currentTask->waitReady    = &ready;
+            currentTask->waitDeadline = deadlineUs;
+            blockedWake.notify_all();
+        }
+        if(deadlineUs < 0 || timeFrozen)
+            wake.wait(lk);
+        else
+            wake.wait_for(lk, std::chrono::microseconds(deadlineUs - curTime));
+        if(currentTask != NULL)
+            currentTask->waitReady = NULL;
+    }
+}
+
+uint64_t ShimKernel::schedule(int64_t atUs, const std::function<void(void)> &callback)
+{
+    // Locals.
+    //
+    uint64_t                        eventId = ++eventSeq;
+
+    events[std::make_pair(atUs, eventId)] = callback;
+    eventTimes[eventId] = atUs;
+    if(!dispatcherRunning)
+    {
+        dispatcherRunning = true;
+        std::thread(dispatcher).detach();
+    }
+    wake.notify_all();
+    return(eventId);
+}
+
+void ShimKernel::cancel(uint64_t eventId)
+{
+    // Locals.
+    //
+    auto                            it = eventTimes.find(eventId);
+
+    if(it != eventTimes.end())
+    {
+        events.erase(std::make_pair(it->second, eventId));
+        eventTimes.erase(it);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Test control.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t Shim::now(void)
+{
+    if(timeFrozen)
+        return(frozenTime);
+    return(realTime() + timeOffset);
+}
+
+void Shim::freezeTime(void)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(!timeFrozen)
+    {
+        frozenTime = realTime() + timeOffset;
+        timeFrozen = true;
+    }
+}
+
+void Shim::releaseTime(void)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(timeFrozen)
+    {
+        timeOffset = frozenTime - realTime();
+        timeFrozen = false;
+    }
+    wake.notify_all();
+}
+
+bool Shim::isTimeFrozen(void)
+{
+    return(timeFrozen);
+}
+
+void Shim::advanceTime(int64_t us)
+{
+    // Locals.
+    //
+    int64_t                         target;
+
+    freezeTime();
+    std::unique_lock<std::mutex> lk(lock);
+    target = frozenTime + us;
+    while(!events.empty() && events.begin()->first.first <= target)
+    {
+        auto it = events.begin();
+        std::function<void(void)> callback = it->second;
+        if(it->first.first > frozenTime)
+            frozenTime = it->first.first;
+        eventTimes.erase(it->first.second);
+        events.erase(it);
+        lk.unlock();
+        callback();
+        lk.lock();
+        wake.notify_all();
+    }
+    frozenTime = target;
+    wake.notify_all();
+}
+
+bool Shim::waitBlocked(TaskHandle_t task, uint32_t timeoutMs)
+{
+    // Locals.
+    //
+    std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    // Blocked means waiting on a condition which is not met before a deadline which has not passed, a woken task still
+    // inside the wait is runnable.
+    std::unique_lock<std::mutex> lk(lock);
+    for(;;)
+    {
+        if(task->finished)
+            return(true);
+        if(task->waitReady != NULL && !(*task->waitReady)() && (task->waitDeadline < 0 || Shim::now() < task->waitDeadline))
+            return(true);
+        if(blockedWake.wait_until(lk, timeout) == std::cv_status::timeout)
+            return(false);
+    }
+}
+
+void Shim::settle(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+uint32_t Shim::restartCount(void)
+{
+    return(restarts);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FreeRTOS port layer.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Critical sections are recursive spinlocks owned by a thread, as on the dual core target an interrupt raised in another
+// thread spins until the owner leaves.
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    // Locals.
+    //
+    uint32_t                        expected;
+
+    if(threadToken == 0)
+        threadToken = ++threadSeq;
+    if(__atomic_load_n(&mux->owner, __ATOMIC_ACQUIRE) == threadToken)
+    {
+        mux->count++;
+        return;
+    }
+    for(;;)
+    {
+        expected = 0;
+        if(__atomic_compare_exchange_n(&mux->owner, &expected, threadToken, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+        std::this_thread::yield();
+    }
+    mux->count = 1;
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    if(--mux->count == 0)
+        __atomic_store_n(&mux->owner, 0, __ATOMIC_RELEASE);
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+    return(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tasks.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters,
+                                   UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask, BaseType_t xCoreID)
+{
+    // Locals.
+    //
+    shimTask                       *task = newTask(pcName, uxPriority, usStackDepth, xCoreID);
+
+    if(pvCreatedTask != NULL)
+        *pvCreatedTask = task;
+    std::thread([task, pvTaskCode, pvParameters](void)
+    {
+        currentTask  = task;
+        task->thread = pthread_self();
+        try
+        {
+            pvTaskCode(pvParameters);
+        }
+        catch(const ShimKernel::TaskExit &)
+        {
+        }
+        catch(const Shim::Restart &)
+        {
+        }
+        std::lock_guard<std::mutex> lk(lock);
+        task->finished = true;
+        blockedWake.notify_all();
+    }).detach();
+    return(pdPASS);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters,
+                       UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask)
+{
+    return(xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, tskNO_AFFINITY));
+}
+
+// Only a task deleting itself is supported, the thread unwinds back to its entry.
+void vTaskDelete(TaskHandle_t xTask)
+{
+    if(xTask == NULL || xTask == currentTask)
+        throw ShimKernel::TaskExit();
+}
+
+void vTaskSuspend(TaskHandle_t xTask)
+{
+    if(xTask == NULL || xTask == currentTask)
+    {
+        std::unique_lock<std::mutex> lk(lock);
+        waitUntil(lk, -1, [](void) { return(false); });
+    }
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    if(xTicksToDelay == 0)
+    {
+        std::this_thread::yield();
+        return;
+    }
+    std::unique_lock<std::mutex> lk(lock);
+    waitUntil(lk, deadline(xTicksToDelay), [](void) { return(false); });
+}
+
+void taskYIELD(void)
+{
+    std::this_thread::yield();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return((TickType_t)(Shim::now() / 1000 / portTICK_PERIOD_MS));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return(selfTask());
+}
+
+// Tasks are looked up by the name given at creation, the first created with the name is returned.
+TaskHandle_t xTaskGetHandle(const char *pcNameToQuery)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    for(shimTask *task : tasks)
+    {
+        if(task->name.compare(pcNameToQuery) == 0)
+            return(task);
+    }
+    return(NULL);
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
+{
+    return((xTask == NULL ? selfTask() : xTask)->stackDepth / 2);
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    return(tasks.size());
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t *pulTotalRunTime)
+{
+    // Locals.
+    //
+    UBaseType_t                     count = 0;
+    clockid_t                       clockId;
+    struct timespec                 cpuTime;
+
+    int64_t                         totalRunTime = Shim::now();
+
+    // A thread CPU clock can run ahead of the wall clock shortly after start up, FreeRTOS never reports a task run time above the total.
+    std::lock_guard<std::mutex> lk(lock);
+    for(shimTask *task : tasks)
+    {
+        if(count >= uxArraySize)
+            break;
+        memset(&pxTaskStatusArray[count], 0, sizeof(TaskStatus_t));
+        pxTaskStatusArray[count].xHandle              = task;
+        pxTaskStatusArray[count].pcTaskName           = task->name.c_str();
+        pxTaskStatusArray[count].xTaskNumber          = task->taskNumber;
+        pxTaskStatusArray[count].uxCurrentPriority    = task->priority;
+        pxTaskStatusArray[count].uxBasePriority       = task->priority;
+        pxTaskStatusArray[count].usStackHighWaterMark = task->stackDepth / 2;
+        pxTaskStatusArray[count].xCoreID              = task->coreId;
+        if(pthread_getcpuclockid(task->thread, &clockId) == 0 && clock_gettime(clockId, &cpuTime) == 0)
+            pxTaskStatusArray[count].ulRunTimeCounter = (uint32_t)std::min((int64_t)(cpuTime.tv_sec * 1000000LL + cpuTime.tv_nsec / 1000), totalRunTime);
+        count++;
+    }
+    if(pulTotalRunTime != NULL)
+        *pulTotalRunTime = (uint32_t)totalRunTime;
+    return(count);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    // Locals.
+    //
+    shimTask                       *task = selfTask();
+    uint32_t                        count;
+
+    std::unique_lock<std::mutex> lk(lock);
+    waitUntil(lk, deadline(xTicksToWait), [task](void) { return(task->notifyCount > 0); });
+    count = task->notifyCount;
+    if(count > 0)
+        task->notifyCount = xClearCountOnExit == pdTRUE ? 0 : count - 1;
+    return(count);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    xTaskToNotify->notifyCount++;
+    wake.notify_all();
+    return(pdPASS);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    xTaskNotifyGive(xTaskToNotify);
+    if(pxHigherPriorityTaskWoken != NULL)
+        *pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Queues, semaphores and queue sets.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    // Locals.
+    //
+    shimQueue                      *queue = new shimQueue;
+
+    queue->length   = uxQueueLength;
+    queue->itemSize = uxItemSize;
+    queue->set      = NULL;
+    return(queue);
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    delete xQueue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return(queueSend(xQueue, pvItemToQueue, xTicksToWait, false));
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return(queueSend(xQueue, pvItemToQueue, xTicksToWait, false));
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void *pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if(pxHigherPriorityTaskWoken != NULL)
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    return(queueSend(xQueue, pvItemToQueue, 0, false));
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    std::unique_lock<std::mutex> lk(lock);
+    if(!waitUntil(lk, deadline(xTicksToWait), [xQueue](void) { return(!xQueue->items.empty()); }))
+        return(pdFALSE);
+    if(xQueue->itemSize > 0)
+        memcpy(pvBuffer, xQueue->items.front().data(), xQueue->itemSize);
+    xQueue->items.pop_front();
+    wake.notify_all();
+    return(pdTRUE);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    std::unique_lock<std::mutex> lk(lock);
+    if(!waitUntil(lk, deadline(xTicksToWait), [xQueue](void) { return(!xQueue->items.empty()); }))
+        return(pdFALSE);
+    if(xQueue->itemSize > 0)
+        memcpy(pvBuffer, xQueue->items.front().data(), xQueue->itemSize);
+    return(pdTRUE);
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    xQueue->items.clear();
+    wake.notify_all();
+    return(pdPASS);
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    return(xQueue->items.size());
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    return(xQueue->length - xQueue->items.size());
+}
+
+QueueSetHandle_t xQueueCreateSet(const UBaseType_t uxEventQueueLength)
+{
+    return(xQueueCreate(uxEventQueueLength, sizeof(QueueHandle_t)));
+}
+
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t xQueueOrSemaphore, QueueSetHandle_t xQueueSet)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(xQueueOrSemaphore->set != NULL || !xQueueOrSemaphore->items.empty())
+        return(pdFAIL);
+    xQueueOrSemaphore->set = xQueueSet;
+    return(pdPASS);
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t xQueueSet, const TickType_t xTicksToWait)
+{
+    // Locals.
+    //
+    QueueSetMemberHandle_t          member = NULL;
+
+    return(xQueueReceive(xQueueSet, &member, xTicksToWait) == pdTRUE ? member : NULL);
+}
+
+// A mutex is a single item queue which starts full, a binary semaphore starts empty.
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    // Locals.
+    //
+    SemaphoreHandle_t               mutex = xQueueCreate(1, 0);
+
+    mutex->items.push_back(std::vector<uint8_t>());
+    return(mutex);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return(xQueueCreate(1, 0));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Event groups.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return(new shimEventGroup{0});
+}
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup)
+{
+    delete xEventGroup;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    xEventGroup->bits |= uxBitsToSet;
+    wake.notify_all();
+    return(xEventGroup->bits);
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear)
+{
+    // Locals.
+    //
+    EventBits_t                     bits;
+
+    std::lock_guard<std::mutex> lk(lock);
+    bits = xEventGroup->bits;
+    xEventGroup->bits &= ~uxBitsToClear;
+    return(bits);
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    return(xEventGroup->bits);
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+                                const BaseType_t xWaitForAllBits, TickType_t xTicksToWait)
+{
+    // Locals.
+    //
+    EventBits_t                     bits;
+    bool                            met;
+
+    std::unique_lock<std::mutex> lk(lock);
+    met = waitUntil(lk, deadline(xTicksToWait), [&](void)
+    {
+        return(xWaitForAllBits == pdTRUE ? (xEventGroup->bits & uxBitsToWaitFor) == uxBitsToWaitFor : (xEventGroup->bits & uxBitsToWaitFor) != 0);
+    });
+    bits = xEventGroup->bits;
+    if(met && xClearOnExit == pdTRUE)
+        xEventGroup->bits &= ~uxBitsToWaitFor;
+    return(bits);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// High resolution timer.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    // Locals.
+    //
+    shimTimer                      *timer = new shimTimer;
+
+    timer->callback = create_args->callback;
+    timer->arg      = create_args->arg;
+    timer->name     = create_args->name == NULL ? "" : create_args->name;
+    timer->period   = 0;
+    timer->eventId  = 0;
+    timer->active   = false;
+    *out_handle = timer;
+    return(ESP_OK);
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(timer->active)
+        return(ESP_ERR_INVALID_STATE);
+    timer->active  = true;
+    timer->period  = 0;
+    timer->eventId = schedule(Shim::now() + timeout_us, [timer](void) { timerFire(timer); });
+    return(ESP_OK);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(timer->active)
+        return(ESP_ERR_INVALID_STATE);
+    timer->active  = true;
+    timer->period  = period;
+    timer->eventId = schedule(Shim::now() + period, [timer](void) { timerFire(timer); });
+    return(ESP_OK);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(!timer->active)
+        return(ESP_ERR_INVALID_STATE);
+    cancel(timer->eventId);
+    timer->active = false;
+    return(ESP_OK);
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    {
+        std::lock_guard<std::mutex> lk(lock);
+        if(timer->active)
+            return(ESP_ERR_INVALID_STATE);
+    }
+    delete timer;
+    return(ESP_OK);
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    return(timer->active);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return(Shim::now());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// General purpose timers.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t timer_init(timer_group_t group_num, timer_idx_t timer_num, const timer_config_t *config)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    hwTimer[group_num][timer_num].baseTime     = Shim::now();
+    hwTimer[group_num][timer_num].baseCount    = 0;
+    hwTimer[group_num][timer_num].divider      = config->divider < 2 ? 2 : config->divider;
+    hwTimer[group_num][timer_num].running      = config->counter_en == TIMER_START;
+    hwTimer[group_num][timer_num].alarmEnabled = config->alarm_en == TIMER_ALARM_EN;
+    hwTimer[group_num][timer_num].alarmValue   = 0;
+    hwTimer[group_num][timer_num].alarmEvent   = 0;
+    return(ESP_OK);
+}
+
+esp_err_t timer_set_counter_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t load_val)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    hwTimer[group_num][timer_num].baseTime  = Shim::now();
+    hwTimer[group_num][timer_num].baseCount = load_val;
+    hwTimerArm(group_num, timer_num);
+    return(ESP_OK);
+}
+
+esp_err_t timer_get_counter_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t *timer_val)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    *timer_val = hwTimerCount(group_num, timer_num);
+    counterReads++;
+    return(ESP_OK);
+}
+
+uint64_t Shim::timerCounterReads(void)
+{
+    return(counterReads);
+}
+
+esp_err_t timer_isr_callback_add(timer_group_t group_num, timer_idx_t timer_num, timer_isr_t isr_handler, void *arg, int intr_alloc_flags)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    hwTimer[group_num][timer_num].isr    = isr_handler;
+    hwTimer[group_num][timer_num].isrArg = arg;
+    return(ESP_OK);
+}
+
+esp_err_t timer_start(timer_group_t group_num, timer_idx_t timer_num)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    if(!hwTimer[group_num][timer_num].running)
+    {
+        hwTimer[group_num][timer_num].baseTime = Shim::now();
+        hwTimer[group_num][timer_num].running  = true;
+    }
+    hwTimerArm(group_num, timer_num);
+    return(ESP_OK);
+}
+
+esp_err_t timer_pause(timer_group_t group_num, timer_idx_t timer_num)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    hwTimer[group_num][timer_num].baseCount = hwTimerCount(group_num, timer_num);
+    hwTimer[group_num][timer_num].running   = false;
+    hwTimerArm(group_num, timer_num);
+    return(ESP_OK);
+}
+
+uint64_t timer_group_get_counter_value_in_isr(timer_group_t group_num, timer_idx_t timer_num)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    return(hwTimerCount(group_num, timer_num));
+}
+
+void timer_group_set_alarm_value_in_isr(timer_group_t group_num, timer_idx_t timer_num, uint64_t alarm_val)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    hwTimer[group_num][timer_num].alarmValue = alarm_val;
+    hwTimerArm(group_num, timer_num);
+}
+
+void timer_group_enable_alarm_in_isr(timer_group_t group_num, timer_idx_t timer_num)
+{
+    std::lock_guard<std::mutex> lk(lock);
+    hwTimer[group_num][timer_num].alarmEnabled = true;
+    hwTimerArm(group_num, timer_num);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// System services.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void esp_restart(void)
+{
+    restarts++;
+    throw Shim::Restart();
+}
+
+esp_reset_reason_t esp_reset_reason(void)
+{
+    return(ESP_RST_POWERON);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+}
+
+// Host memory is not tracked, report the figures of a freshly booted target.
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return(160 * 1024);
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    return(128 * 1024);
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return(64 * 1024);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch(code)
+    {
+        case ESP_OK:                    return("ESP_OK");
+        case ESP_FAIL:                  return("ESP_FAIL");
+        case ESP_ERR_NO_MEM:            return("ESP_ERR_NO_MEM");
+        case ESP_ERR_INVALID_ARG:       return("ESP_ERR_INVALID_ARG");
+        case ESP_ERR_INVALID_STATE:     return("ESP_ERR_INVALID_STATE");
+        case ESP_ERR_INVALID_SIZE:      return("ESP_ERR_INVALID_SIZE");
+        case ESP_ERR_NOT_FOUND:         return("ESP_ERR_NOT_FOUND");
+        case ESP_ERR_NOT_SUPPORTED:     return("ESP_ERR_NOT_SUPPORTED");
+        case ESP_ERR_TIMEOUT:           return("ESP_ERR_TIMEOUT");
+        case ESP_ERR_NVS_NOT_FOUND:     return("ESP_ERR_NVS_NOT_FOUND");
+        default:                        return("UNKNOWN ERROR");
+    }
+}
+
+void _esp_error_check_failed(esp_err_t rc, const char *file, int line, const char *function, const char *expression)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d in %s\nexpression: %s\n", rc, esp_err_to_name(rc), file, line, function, expression);
+    abort();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Logging.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    logLevel = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    // Locals.
+    //
+    va_list                         args;
+
+    if(level > logLevel)
+        return;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void esp_log_buffer_hex_internal(const char *tag, const void *buffer, uint16_t buff_len, esp_log_level_t level)
+{
+    if(level > logLevel)
+        return;
+    for(uint16_t idx = 0; idx < buff_len; idx++)
+        fprintf(stderr, "%02x%s", ((const uint8_t *)buffer)[idx], (idx % 16) == 15 || idx == buff_len - 1 ? "\n" : " ");
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return((uint32_t)(Shim::now() / 1000));
+}
@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            ShimKernel.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Internal interface shared by the shim modules. A single kernel lock and condition
+//                  variable serialise the shim state, every blocking call waits on it against a deadline
+//                  in shim time and every state change wakes the waiters to re-check.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Not for use by tests, see Shim.h.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_KERNEL_H
+#define SHIM_KERNEL_H
+
+#include <stdint.h>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "freertos/FreeRTOS.h"
+
+namespace ShimKernel
+{
+    // Exception used to unwind a task which deletes itself or requests a restart.
+    struct TaskExit {};
+
+    extern std::mutex                   lock;
+    extern std::condition_variable      wake;
+
+    // Deadline in shim time for a tick count, -1 waits forever.
+    int64_t                             deadline(TickType_t ticks);
+
+    // Wait, with the kernel lock held, until ready() is true or the deadline passes. Returns the final ready() state.
+    bool                                waitUntil(std::unique_lock<std::mutex> &lk, int64_t deadlineUs, const std::function<bool(void)> &ready);
+
+    // Timer events, run by the dispatcher thread in real time or by Shim::advanceTime when the clock is frozen. Both are
+    // called with the kernel lock held, the callback runs without it.
+    uint64_t                            schedule(int64_t atUs, const std::function<void(void)> &callback);
+    void                                cancel(uint64_t eventId);
+}
+
+#endif // SHIM_KERNEL_H
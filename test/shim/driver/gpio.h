@@ -0,0 +1,106 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            gpio.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF GPIO driver. Pins are virtual, the level seen on a pin is the
+//                  external level set by a test wired-AND with the output latch when the pin is an
+//                  output, and edge interrupts are raised in the thread which changed the level.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_DRIVER_GPIO_H
+#define SHIM_DRIVER_GPIO_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_intr_alloc.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
+#include "soc/gpio_struct.h"
+
+typedef enum {
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_MAX = 40
+} gpio_num_t;
+
+typedef enum {
+    GPIO_INTR_DISABLE = 0,
+    GPIO_INTR_POSEDGE = 1,
+    GPIO_INTR_NEGEDGE = 2,
+    GPIO_INTR_ANYEDGE = 3,
+    GPIO_INTR_LOW_LEVEL = 4,
+    GPIO_INTR_HIGH_LEVEL = 5,
+    GPIO_INTR_MAX
+} gpio_int_type_t;
+
+typedef enum {
+    GPIO_MODE_DISABLE = 0,
+    GPIO_MODE_INPUT = 1,
+    GPIO_MODE_OUTPUT = 2,
+    GPIO_MODE_OUTPUT_OD = 6,
+    GPIO_MODE_INPUT_OUTPUT_OD = 7,
+    GPIO_MODE_INPUT_OUTPUT = 3
+} gpio_mode_t;
+
+typedef enum {
+    GPIO_PULLUP_DISABLE = 0,
+    GPIO_PULLUP_ENABLE = 1
+} gpio_pullup_t;
+
+typedef enum {
+    GPIO_PULLDOWN_DISABLE = 0,
+    GPIO_PULLDOWN_ENABLE = 1
+} gpio_pulldown_t;
+
+typedef enum {
+    GPIO_DRIVE_CAP_0 = 0,
+    GPIO_DRIVE_CAP_1 = 1,
+    GPIO_DRIVE_CAP_2 = 2,
+    GPIO_DRIVE_CAP_DEFAULT = 2,
+    GPIO_DRIVE_CAP_3 = 3,
+    GPIO_DRIVE_CAP_MAX
+} gpio_drive_cap_t;
+
+typedef struct {
+    uint64_t                            pin_bit_mask;
+    gpio_mode_t                         mode;
+    gpio_pullup_t                       pull_up_en;
+    gpio_pulldown_t                     pull_down_en;
+    gpio_int_type_t                     intr_type;
+} gpio_config_t;
+
+typedef void                          (*gpio_isr_t)(void *arg);
+
+esp_err_t                               gpio_config(const gpio_config_t *pGPIOConfig);
+esp_err_t                               gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+int                                     gpio_get_level(gpio_num_t gpio_num);
+esp_err_t                               gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+esp_err_t                               gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type);
+esp_err_t                               gpio_set_drive_capability(gpio_num_t gpio_num, gpio_drive_cap_t strength);
+esp_err_t                               gpio_install_isr_service(int intr_alloc_flags);
+esp_err_t                               gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args);
+esp_err_t                               gpio_isr_handler_remove(gpio_num_t gpio_num);
+
+#endif // SHIM_DRIVER_GPIO_H
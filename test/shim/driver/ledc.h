@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            ledc.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF LED PWM driver. Settings are recorded so a test can read back
+//                  the frequency and duty driven onto the LED, frequencies outside the range of the clock
+//                  the timer was configured with are rejected as on the target.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_DRIVER_LEDC_H
+#define SHIM_DRIVER_LEDC_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+typedef enum {
+    LEDC_HIGH_SPEED_MODE = 0,
+    LEDC_LOW_SPEED_MODE,
+    LEDC_SPEED_MODE_MAX
+} ledc_mode_t;
+
+typedef enum {
+    LEDC_INTR_DISABLE = 0,
+    LEDC_INTR_FADE_END,
+    LEDC_INTR_MAX
+} ledc_intr_type_t;
+
+typedef enum {
+    LEDC_TIMER_0 = 0,
+    LEDC_TIMER_1,
+    LEDC_TIMER_2,
+    LEDC_TIMER_3,
+    LEDC_TIMER_MAX
+} ledc_timer_t;
+
+typedef enum {
+    LEDC_CHANNEL_0 = 0,
+    LEDC_CHANNEL_1,
+    LEDC_CHANNEL_MAX = 8
+} ledc_channel_t;
+
+typedef enum {
+    LEDC_TIMER_1_BIT = 1,
+    LEDC_TIMER_8_BIT = 8,
+    LEDC_TIMER_10_BIT = 10,
+    LEDC_TIMER_13_BIT = 13,
+    LEDC_TIMER_BIT_MAX = 21
+} ledc_timer_bit_t;
+
+typedef enum {
+    LEDC_AUTO_CLK = 0,
+    LEDC_USE_REF_TICK,
+    LEDC_USE_APB_CLK,
+    LEDC_USE_RTC8M_CLK
+} ledc_clk_cfg_t;
+
+typedef struct {
+    int                                 gpio_num;
+    ledc_mode_t                         speed_mode;
+    ledc_channel_t                      channel;
+    ledc_intr_type_t                    intr_type;
+    ledc_timer_t                        timer_sel;
+    uint32_t                            duty;
+    int                                 hpoint;
+    struct {
+        unsigned int                    output_invert: 1;
+    } flags;
+} ledc_channel_config_t;
+
+typedef struct {
+    ledc_mode_t                         speed_mode;
+    ledc_timer_bit_t                    duty_resolution;
+    ledc_timer_t                        timer_num;
+    uint32_t                            freq_hz;
+    ledc_clk_cfg_t                      clk_cfg;
+} ledc_timer_config_t;
+
+esp_err_t                               ledc_timer_config(const ledc_timer_config_t *timer_conf);
+esp_err_t                               ledc_channel_config(const ledc_channel_config_t *ledc_conf);
+esp_err_t                               ledc_set_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num, uint32_t freq_hz);
+esp_err_t                               ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty);
+esp_err_t                               ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel);
+esp_err_t                               ledc_timer_rst(ledc_mode_t speed_mode, ledc_timer_t timer_sel);
+
+#endif // SHIM_DRIVER_LEDC_H
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            timer.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF general purpose timer driver. Counters are derived from the
+//                  shim clock and an armed alarm is a one shot event which disables itself and calls the
+//                  registered callback, as the hardware does.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_DRIVER_TIMER_H
+#define SHIM_DRIVER_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_intr_alloc.h"
+
+typedef enum {
+    TIMER_GROUP_0 = 0,
+    TIMER_GROUP_1 = 1,
+    TIMER_GROUP_MAX
+} timer_group_t;
+
+typedef enum {
+    TIMER_0 = 0,
+    TIMER_1 = 1,
+    TIMER_MAX
+} timer_idx_t;
+
+typedef enum {
+    TIMER_COUNT_DOWN = 0,
+    TIMER_COUNT_UP = 1,
+    TIMER_COUNT_MAX
+} timer_count_dir_t;
+
+typedef enum {
+    TIMER_PAUSE = 0,
+    TIMER_START = 1
+} timer_start_t;
+
+typedef enum {
+    TIMER_ALARM_DIS = 0,
+    TIMER_ALARM_EN = 1,
+    TIMER_ALARM_MAX
+} timer_alarm_t;
+
+typedef enum {
+    TIMER_INTR_LEVEL = 0,
+    TIMER_INTR_MAX
+} timer_intr_mode_t;
+
+typedef enum {
+    TIMER_AUTORELOAD_DIS = 0,
+    TIMER_AUTORELOAD_EN = 1,
+    TIMER_AUTORELOAD_MAX
+} timer_autoreload_t;
+
+typedef struct {
+    timer_alarm_t                       alarm_en;
+    timer_start_t                       counter_en;
+    timer_intr_mode_t                   intr_type;
+    timer_count_dir_t                   counter_dir;
+    timer_autoreload_t                  auto_reload;
+    uint32_t                            divider;
+} timer_config_t;
+
+typedef bool                          (*timer_isr_t)(void *);
+
+esp_err_t                               timer_init(timer_group_t group_num, timer_idx_t timer_num, const timer_config_t *config);
+esp_err_t                               timer_set_counter_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t load_val);
+esp_err_t                               timer_get_counter_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t *timer_val);
+esp_err_t                               timer_isr_callback_add(timer_group_t group_num, timer_idx_t timer_num, timer_isr_t isr_handler, void *arg, int intr_alloc_flags);
+esp_err_t                               timer_start(timer_group_t group_num, timer_idx_t timer_num);
+esp_err_t                               timer_pause(timer_group_t group_num, timer_idx_t timer_num);
+uint64_t                                timer_group_get_counter_value_in_isr(timer_group_t group_num, timer_idx_t timer_num);
+void                                    timer_group_set_alarm_value_in_isr(timer_group_t group_num, timer_idx_t timer_num, uint64_t alarm_val);
+void                                    timer_group_enable_alarm_in_isr(timer_group_t group_num, timer_idx_t timer_num);
+
+#endif // SHIM_DRIVER_TIMER_H
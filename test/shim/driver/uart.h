@@ -0,0 +1,138 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            uart.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF UART driver. Each installed port is backed by a pseudo
+//                  terminal, a test plays the host on the master side while the driver reads and writes
+//                  the slave side, receive data and breaks are posted to the event queue as on the
+//                  target.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_DRIVER_UART_H
+#define SHIM_DRIVER_UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_intr_alloc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef int                             uart_port_t;
+
+#define UART_NUM_0                      0
+#define UART_NUM_1                      1
+#define UART_NUM_2                      2
+#define UART_NUM_MAX                    3
+#define UART_PIN_NO_CHANGE              -1
+
+typedef enum {
+    UART_DATA_5_BITS = 0,
+    UART_DATA_6_BITS = 1,
+    UART_DATA_7_BITS = 2,
+    UART_DATA_8_BITS = 3,
+    UART_DATA_BITS_MAX
+} uart_word_length_t;
+
+typedef enum {
+    UART_STOP_BITS_1 = 1,
+    UART_STOP_BITS_1_5 = 2,
+    UART_STOP_BITS_2 = 3,
+    UART_STOP_BITS_MAX
+} uart_stop_bits_t;
+
+typedef enum {
+    UART_PARITY_DISABLE = 0,
+    UART_PARITY_EVEN = 2,
+    UART_PARITY_ODD = 3
+} uart_parity_t;
+
+typedef enum {
+    UART_HW_FLOWCTRL_DISABLE = 0,
+    UART_HW_FLOWCTRL_RTS = 1,
+    UART_HW_FLOWCTRL_CTS = 2,
+    UART_HW_FLOWCTRL_CTS_RTS = 3,
+    UART_HW_FLOWCTRL_MAX
+} uart_hw_flowcontrol_t;
+
+typedef enum {
+    UART_SCLK_APB = 0,
+    UART_SCLK_REF_TICK = 1
+} uart_sclk_t;
+
+typedef enum {
+    UART_SIGNAL_INV_DISABLE = 0,
+    UART_SIGNAL_IRDA_TX_INV = (1 << 0),
+    UART_SIGNAL_IRDA_RX_INV = (1 << 1),
+    UART_SIGNAL_RXD_INV = (1 << 2),
+    UART_SIGNAL_CTS_INV = (1 << 3),
+    UART_SIGNAL_DSR_INV = (1 << 4),
+    UART_SIGNAL_TXD_INV = (1 << 5),
+    UART_SIGNAL_RTS_INV = (1 << 6),
+    UART_SIGNAL_DTR_INV = (1 << 7)
+} uart_signal_inv_t;
+
+typedef struct {
+    int                                 baud_rate;
+    uart_word_length_t                  data_bits;
+    uart_parity_t                       parity;
+    uart_stop_bits_t                    stop_bits;
+    uart_hw_flowcontrol_t               flow_ctrl;
+    uint8_t                             rx_flow_ctrl_thresh;
+    uart_sclk_t                         source_clk;
+} uart_config_t;
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t                   type;
+    size_t                              size;
+    bool                                timeout_flag;
+} uart_event_t;
+
+esp_err_t                               uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags);
+esp_err_t                               uart_driver_delete(uart_port_t uart_num);
+esp_err_t                               uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config);
+esp_err_t                               uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num);
+esp_err_t                               uart_set_line_inverse(uart_port_t uart_num, uint32_t inverse_mask);
+esp_err_t                               uart_set_rx_full_threshold(uart_port_t uart_num, int threshold);
+esp_err_t                               uart_set_rx_timeout(uart_port_t uart_num, const uint8_t tout_thresh);
+esp_err_t                               uart_flush_input(uart_port_t uart_num);
+esp_err_t                               uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait);
+int                                     uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait);
+int                                     uart_write_bytes(uart_port_t uart_num, const void *src, size_t size);
+
+#endif // SHIM_DRIVER_UART_H
@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_bt.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the Bluetooth controller API.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided, calls succeed without a radio.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_BT_H
+#define SHIM_ESP_BT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_bt_defs.h"
+
+typedef enum {
+    ESP_BT_MODE_IDLE                    = 0x00,
+    ESP_BT_MODE_BLE                     = 0x01,
+    ESP_BT_MODE_CLASSIC_BT              = 0x02,
+    ESP_BT_MODE_BTDM                    = 0x03
+} esp_bt_mode_t;
+
+typedef enum {
+    ESP_PWR_LVL_N12 = 0,
+    ESP_PWR_LVL_N9,
+    ESP_PWR_LVL_N6,
+    ESP_PWR_LVL_N3,
+    ESP_PWR_LVL_N0,
+    ESP_PWR_LVL_P3,
+    ESP_PWR_LVL_P6,
+    ESP_PWR_LVL_P9
+} esp_power_level_t;
+
+typedef enum {
+    ESP_BLE_PWR_TYPE_CONN_HDL0 = 0,
+    ESP_BLE_PWR_TYPE_ADV = 9,
+    ESP_BLE_PWR_TYPE_SCAN = 10,
+    ESP_BLE_PWR_TYPE_DEFAULT = 11
+} esp_ble_power_type_t;
+
+typedef struct {
+    uint8_t                             mode;
+    uint8_t                             bt_max_acl_conn;
+    uint8_t                             bt_max_sync_conn;
+} esp_bt_controller_config_t;
+
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() { ESP_BT_MODE_BTDM, 1, 0 }
+
+esp_err_t                               esp_bt_controller_init(esp_bt_controller_config_t *cfg);
+esp_err_t                               esp_bt_controller_deinit(void);
+esp_err_t                               esp_bt_controller_enable(esp_bt_mode_t mode);
+esp_err_t                               esp_bt_controller_disable(void);
+esp_err_t                               esp_bt_controller_mem_release(esp_bt_mode_t mode);
+esp_err_t                               esp_ble_tx_power_set(esp_ble_power_type_t power_type, esp_power_level_t power_level);
+esp_err_t                               esp_bredr_tx_power_set(esp_power_level_t min_power_level, esp_power_level_t max_power_level);
+
+#endif // SHIM_ESP_BT_H
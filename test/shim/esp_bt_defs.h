@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_bt_defs.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the Bluedroid common definitions.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided, calls succeed without a radio.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_BT_DEFS_H
+#define SHIM_ESP_BT_DEFS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define ESP_BD_ADDR_LEN                 6
+typedef uint8_t                         esp_bd_addr_t[ESP_BD_ADDR_LEN];
+
+#define ESP_BD_ADDR_STR                 "%02x:%02x:%02x:%02x:%02x:%02x"
+#define ESP_BD_ADDR_HEX(addr)           addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]
+
+#define ESP_UUID_LEN_16                 2
+#define ESP_UUID_LEN_32                 4
+#define ESP_UUID_LEN_128                16
+
+typedef struct {
+    uint16_t                            len;
+    union {
+        uint16_t                        uuid16;
+        uint32_t                        uuid32;
+        uint8_t                         uuid128[ESP_UUID_LEN_128];
+    } uuid;
+} __attribute__((packed)) esp_bt_uuid_t;
+
+typedef enum {
+    BLE_ADDR_TYPE_PUBLIC                = 0x00,
+    BLE_ADDR_TYPE_RANDOM                = 0x01,
+    BLE_ADDR_TYPE_RPA_PUBLIC            = 0x02,
+    BLE_ADDR_TYPE_RPA_RANDOM            = 0x03
+} esp_ble_addr_type_t;
+
+typedef uint8_t                         esp_ble_key_mask_t;
+#define ESP_BLE_ENC_KEY_MASK            (1 << 0)
+#define ESP_BLE_ID_KEY_MASK             (1 << 1)
+#define ESP_BLE_CSR_KEY_MASK            (1 << 2)
+#define ESP_BLE_LINK_KEY_MASK           (1 << 3)
+
+#define ESP_GATT_UUID_HID_SVC           0x1812
+
+#endif // SHIM_ESP_BT_DEFS_H
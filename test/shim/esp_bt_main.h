@@ -0,0 +1,40 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_bt_main.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the Bluedroid stack control API.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided, calls succeed without a radio.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_BT_MAIN_H
+#define SHIM_ESP_BT_MAIN_H
+
+#include "esp_err.h"
+
+esp_err_t                               esp_bluedroid_init(void);
+esp_err_t                               esp_bluedroid_deinit(void);
+esp_err_t                               esp_bluedroid_enable(void);
+esp_err_t                               esp_bluedroid_disable(void);
+
+#endif // SHIM_ESP_BT_MAIN_H
@@ -0,0 +1,65 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_hid_common.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP HID common definitions.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided, calls succeed without a radio.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_HID_COMMON_H
+#define SHIM_ESP_HID_COMMON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_HID_TRANSPORT_BT,
+    ESP_HID_TRANSPORT_BLE,
+    ESP_HID_TRANSPORT_USB,
+    ESP_HID_TRANSPORT_MAX
+} esp_hid_transport_t;
+
+typedef enum {
+    ESP_HID_USAGE_GENERIC  = 0,
+    ESP_HID_USAGE_KEYBOARD = 1,
+    ESP_HID_USAGE_MOUSE    = 2,
+    ESP_HID_USAGE_JOYSTICK = 4,
+    ESP_HID_USAGE_GAMEPAD  = 8,
+    ESP_HID_USAGE_TABLET   = 16,
+    ESP_HID_USAGE_CCONTROL = 32,
+    ESP_HID_USAGE_VENDOR   = 64
+} esp_hid_usage_t;
+
+typedef enum {
+    ESP_HID_REPORT_TYPE_INPUT = 1,
+    ESP_HID_REPORT_TYPE_OUTPUT,
+    ESP_HID_REPORT_TYPE_FEATURE
+} esp_hid_report_type_t;
+
+esp_hid_usage_t                         esp_hid_usage_from_appearance(uint16_t appearance);
+esp_hid_usage_t                         esp_hid_usage_from_cod(uint32_t cod);
+const char                             *esp_hid_usage_str(esp_hid_usage_t usage);
+
+#endif // SHIM_ESP_HID_COMMON_H
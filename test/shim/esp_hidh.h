@@ -0,0 +1,105 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_hidh.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP HID host API. Device handles are opaque tokens owned by the shim
+//                  so a test can raise open, input and close events against them.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided, calls succeed without a radio.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_HIDH_H
+#define SHIM_ESP_HIDH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_bt_defs.h"
+#include "esp_hid_common.h"
+
+typedef struct esp_hidh_dev_s           esp_hidh_dev_t;
+
+typedef enum {
+    ESP_HIDH_ANY_EVENT = -1,
+    ESP_HIDH_OPEN_EVENT = 0,
+    ESP_HIDH_BATTERY_EVENT,
+    ESP_HIDH_INPUT_EVENT,
+    ESP_HIDH_FEATURE_EVENT,
+    ESP_HIDH_CLOSE_EVENT,
+    ESP_HIDH_START_EVENT,
+    ESP_HIDH_STOP_EVENT,
+    ESP_HIDH_MAX_EVENT
+} esp_hidh_event_t;
+
+typedef union {
+    struct {
+        esp_err_t                       status;
+        esp_hidh_dev_t                 *dev;
+    } open;
+    struct {
+        esp_hidh_dev_t                 *dev;
+        int                             reason;
+    } close;
+    struct {
+        esp_hidh_dev_t                 *dev;
+        uint8_t                         level;
+    } battery;
+    struct {
+        esp_hidh_dev_t                 *dev;
+        esp_hid_usage_t                 usage;
+        uint16_t                        report_id;
+        uint16_t                        length;
+        uint8_t                        *data;
+        uint8_t                         map_index;
+    } input;
+    struct {
+        esp_hidh_dev_t                 *dev;
+        esp_hid_usage_t                 usage;
+        uint16_t                        report_id;
+        uint16_t                        length;
+        uint8_t                        *data;
+        uint8_t                         map_index;
+    } feature;
+} esp_hidh_event_data_t;
+
+typedef struct {
+    esp_event_handler_t                 callback;
+    uint16_t                            event_stack_size;
+    void                               *callback_arg;
+} esp_hidh_config_t;
+
+esp_err_t                               esp_hidh_init(const esp_hidh_config_t *config);
+esp_hidh_dev_t                         *esp_hidh_dev_open(esp_bd_addr_t bda, esp_hid_transport_t transport, uint8_t remote_addr_type);
+esp_err_t                               esp_hidh_dev_close(esp_hidh_dev_t *dev);
+void                                    esp_hidh_dev_dump(esp_hidh_dev_t *dev, FILE *fp);
+const uint8_t                          *esp_hidh_dev_bda_get(esp_hidh_dev_t *dev);
+const char                             *esp_hidh_dev_name_get(esp_hidh_dev_t *dev);
+esp_hid_transport_t                     esp_hidh_dev_transport_get(esp_hidh_dev_t *dev);
+esp_hid_usage_t                         esp_hidh_dev_usage_get(esp_hidh_dev_t *dev);
+esp_err_t                               esp_hidh_dev_output_set(esp_hidh_dev_t *dev, size_t map_index, size_t report_id, uint8_t *value, size_t value_len);
+esp_err_t                               esp_hidh_dev_get_report(esp_hidh_dev_t *dev, size_t map_index, size_t report_id, int report_type, size_t max_len);
+void                                    esp_hidh_gattc_event_handler(int event, int gattc_if, void *param);
+
+#endif // SHIM_ESP_HIDH_H
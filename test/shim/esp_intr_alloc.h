@@ -0,0 +1,39 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_intr_alloc.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF interrupt allocation flags.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_INTR_ALLOC_H
+#define SHIM_ESP_INTR_ALLOC_H
+
+#define ESP_INTR_FLAG_LEVEL1            (1<<1)
+#define ESP_INTR_FLAG_LEVEL3            (1<<3)
+#define ESP_INTR_FLAG_SHARED            (1<<8)
+#define ESP_INTR_FLAG_EDGE              (1<<9)
+#define ESP_INTR_FLAG_IRAM              (1<<10)
+
+#endif // SHIM_ESP_INTR_ALLOC_H
@@ -0,0 +1,50 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_littlefs.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the LittleFS VFS component. The interfaces open their files through the
+//                  stdio and fstream paths handed to them, so on the host the file system is a plain
+//                  directory and nothing needs registering.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_LITTLEFS_H
+#define SHIM_ESP_LITTLEFS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct {
+    const char                         *base_path;
+    const char                         *partition_label;
+    uint8_t                             format_if_mount_failed:1;
+    uint8_t                             dont_mount:1;
+} esp_vfs_littlefs_conf_t;
+
+esp_err_t                               esp_vfs_littlefs_register(const esp_vfs_littlefs_conf_t *conf);
+esp_err_t                               esp_littlefs_info(const char *partition_label, size_t *total_bytes, size_t *used_bytes);
+
+#endif // SHIM_ESP_LITTLEFS_H
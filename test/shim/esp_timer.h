@@ -0,0 +1,63 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            esp_timer.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF high resolution timer. Time is the shim clock, which can be
+//                  frozen and stepped by a test, and callbacks are dispatched from a single timer thread
+//                  as on the target.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_ESP_TIMER_H
+#define SHIM_ESP_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct shimTimer               *esp_timer_handle_t;
+typedef void                          (*esp_timer_cb_t)(void *arg);
+
+typedef enum {
+    ESP_TIMER_TASK,
+    ESP_TIMER_MAX
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t                      callback;
+    void                               *arg;
+    esp_timer_dispatch_t                dispatch_method;
+    const char                         *name;
+    bool                                skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t                               esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle);
+esp_err_t                               esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t                               esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period);
+esp_err_t                               esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t                               esp_timer_delete(esp_timer_handle_t timer);
+bool                                    esp_timer_is_active(esp_timer_handle_t timer);
+int64_t                                 esp_timer_get_time(void);
+
+#endif // SHIM_ESP_TIMER_H
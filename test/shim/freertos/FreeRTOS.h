@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            FreeRTOS.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the FreeRTOS kernel types and port layer used by the SharpKey. Tasks are
+//                  POSIX threads, queues and semaphores are condition variable backed and critical
+//                  sections are recursive spinlocks, so the interface classes run unmodified on Linux.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_FREERTOS_H
+#define SHIM_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+
+// Kernel types, sized as the Xtensa port.
+typedef uint32_t                        TickType_t;
+typedef int                             BaseType_t;
+typedef unsigned int                    UBaseType_t;
+typedef void                          (*TaskFunction_t)(void *);
+
+// Kernel constants.
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define pdPASS                          pdTRUE
+#define pdFAIL                          pdFALSE
+#define errQUEUE_FULL                   0
+#define portMAX_DELAY                   (TickType_t)0xffffffffUL
+#define configTICK_RATE_HZ              CONFIG_FREERTOS_HZ
+#define configMAX_PRIORITIES            25
+#define portTICK_PERIOD_MS              ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portNUM_PROCESSORS              2
+#define pdMS_TO_TICKS(xTimeInMs)        ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define tskIDLE_PRIORITY                0
+#define tskNO_AFFINITY                  0x7FFFFFFF
+
+// Critical sections. A portMUX is a recursive spinlock owned by a thread, shared between threads and the simulated interrupts.
+typedef struct {
+    uint32_t                            owner;
+    uint32_t                            count;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED    { 0, 0 }
+
+void                                    vPortEnterCritical(portMUX_TYPE *mux);
+void                                    vPortExitCritical(portMUX_TYPE *mux);
+#define portENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+#define portYIELD_FROM_ISR()            do { } while(0)
+
+// Heap, host memory is not tracked.
+size_t                                  xPortGetFreeHeapSize(void);
+
+#endif // SHIM_FREERTOS_H
@@ -0,0 +1,46 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            event_groups.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the FreeRTOS event group API.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_EVENT_GROUPS_H
+#define SHIM_EVENT_GROUPS_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct shimEventGroup          *EventGroupHandle_t;
+typedef uint32_t                        EventBits_t;
+
+EventGroupHandle_t                      xEventGroupCreate(void);
+void                                    vEventGroupDelete(EventGroupHandle_t xEventGroup);
+EventBits_t                             xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet);
+EventBits_t                             xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear);
+EventBits_t                             xEventGroupGetBits(EventGroupHandle_t xEventGroup);
+EventBits_t                             xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+                                                            const BaseType_t xWaitForAllBits, TickType_t xTicksToWait);
+
+#endif // SHIM_EVENT_GROUPS_H
@@ -0,0 +1,57 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            queue.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the FreeRTOS queue and queue set API. Queues copy fixed size items into a
+//                  mutex guarded ring, a queue belonging to a set posts its handle to the set on each
+//                  send as per the kernel.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_QUEUE_H
+#define SHIM_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+// Queue handles, semaphores and queue sets are queues as per the kernel.
+typedef struct shimQueue               *QueueHandle_t;
+typedef QueueHandle_t                   xQueueHandle;
+typedef QueueHandle_t                   QueueSetHandle_t;
+typedef QueueHandle_t                   QueueSetMemberHandle_t;
+
+QueueHandle_t                           xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+void                                    vQueueDelete(QueueHandle_t xQueue);
+BaseType_t                              xQueueSend(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t                              xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t                              xQueueSendFromISR(QueueHandle_t xQueue, const void *pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken);
+BaseType_t                              xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+BaseType_t                              xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+BaseType_t                              xQueueReset(QueueHandle_t xQueue);
+UBaseType_t                             uxQueueMessagesWaiting(const QueueHandle_t xQueue);
+UBaseType_t                             uxQueueSpacesAvailable(const QueueHandle_t xQueue);
+QueueSetHandle_t                        xQueueCreateSet(const UBaseType_t uxEventQueueLength);
+BaseType_t                              xQueueAddToSet(QueueSetMemberHandle_t xQueueOrSemaphore, QueueSetHandle_t xQueueSet);
+QueueSetMemberHandle_t                  xQueueSelectFromSet(QueueSetHandle_t xQueueSet, const TickType_t xTicksToWait);
+
+#endif // SHIM_QUEUE_H
@@ -0,0 +1,47 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            semphr.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the FreeRTOS semaphore API. Semaphores are zero length item queues, a
+//                  mutex starts full and a binary semaphore empty.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_SEMPHR_H
+#define SHIM_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef QueueHandle_t                   SemaphoreHandle_t;
+typedef QueueHandle_t                   xSemaphoreHandle;
+
+SemaphoreHandle_t                       xSemaphoreCreateMutex(void);
+SemaphoreHandle_t                       xSemaphoreCreateBinary(void);
+#define xSemaphoreTake(xSemaphore, xBlockTime)   xQueueReceive((xSemaphore), NULL, (xBlockTime))
+#define xSemaphoreGive(xSemaphore)               xQueueSend((xSemaphore), NULL, 0)
+#define xSemaphoreGiveFromISR(xSemaphore, pxWoken) xQueueSendFromISR((xSemaphore), NULL, (pxWoken))
+#define vSemaphoreDelete(xSemaphore)             vQueueDelete((xSemaphore))
+
+#endif // SHIM_SEMPHR_H
@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            task.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the FreeRTOS task API. Each task is a POSIX thread with a notification
+//                  counter, task notifications are the mechanism the interface threads block on.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_TASK_H
+#define SHIM_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+// Task handle, the control block is private to the shim.
+typedef struct shimTask                *TaskHandle_t;
+
+// Task state as returned by uxTaskGetSystemState.
+typedef struct {
+    TaskHandle_t                        xHandle;
+    const char                         *pcTaskName;
+    UBaseType_t                         xTaskNumber;
+    int                                 eCurrentState;
+    UBaseType_t                         uxCurrentPriority;
+    UBaseType_t                         uxBasePriority;
+    uint32_t                            ulRunTimeCounter;
+    void                               *pxStackBase;
+    uint32_t                            usStackHighWaterMark;
+    BaseType_t                          xCoreID;
+} TaskStatus_t;
+
+BaseType_t                              xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters,
+                                                                UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask, BaseType_t xCoreID);
+BaseType_t                              xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth, void *pvParameters,
+                                                    UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask);
+void                                    vTaskDelete(TaskHandle_t xTask);
+void                                    vTaskSuspend(TaskHandle_t xTask);
+void                                    vTaskDelay(const TickType_t xTicksToDelay);
+TickType_t                              xTaskGetTickCount(void);
+TaskHandle_t                            xTaskGetCurrentTaskHandle(void);
+TaskHandle_t                            xTaskGetHandle(const char *pcNameToQuery);
+UBaseType_t                             uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+UBaseType_t                             uxTaskGetNumberOfTasks(void);
+UBaseType_t                             uxTaskGetSystemState(TaskStatus_t *pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t *pulTotalRunTime);
+uint32_t                                ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+BaseType_t                              xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void                                    vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken);
+void                                    taskYIELD(void);
+
+#endif // SHIM_TASK_H
@@ -0,0 +1,54 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            nvs.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP-IDF non volatile storage API. Blobs are held in memory per
+//                  namespace and survive an NVS close and reopen within a test run, a test can clear them
+//                  to model a freshly erased flash.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_NVS_H
+#define SHIM_NVS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef uint32_t                        nvs_handle_t;
+typedef nvs_handle_t                    nvs_handle;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE
+} nvs_open_mode_t;
+
+esp_err_t                               nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle);
+void                                    nvs_close(nvs_handle_t handle);
+esp_err_t                               nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t                               nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length);
+esp_err_t                               nvs_erase_key(nvs_handle_t handle, const char *key);
+esp_err_t                               nvs_commit(nvs_handle_t handle);
+
+#endif // SHIM_NVS_H
@@ -0,0 +1,55 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            gpio_struct.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP32 GPIO register block. Writes to the set and clear registers
+//                  update the virtual output bank held by the shim, pins 0-31 only as on the target.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_SOC_GPIO_STRUCT_H
+#define SHIM_SOC_GPIO_STRUCT_H
+
+#include <stdint.h>
+
+// Write one to set register.
+struct shimGpioW1ts
+{
+    shimGpioW1ts                       &operator=(uint32_t mask);
+};
+
+// Write one to clear register.
+struct shimGpioW1tc
+{
+    shimGpioW1tc                       &operator=(uint32_t mask);
+};
+
+typedef struct {
+    shimGpioW1ts                        out_w1ts;
+    shimGpioW1tc                        out_w1tc;
+} gpio_dev_t;
+
+extern gpio_dev_t                       GPIO;
+
+#endif // SHIM_SOC_GPIO_STRUCT_H
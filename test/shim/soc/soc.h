@@ -0,0 +1,41 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            soc.h
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host shim of the ESP32 register access macros. Register reads are routed to the
+//                  virtual GPIO banks held by the shim.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:           Only the API used by the SharpKey is provided.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHIM_SOC_SOC_H
+#define SHIM_SOC_SOC_H
+
+#include <stdint.h>
+
+uint32_t                                shimRegRead(uint32_t reg);
+
+#define REG_READ(_r)                    shimRegRead((uint32_t)(_r))
+#define BIT(nr)                         (1UL << (nr))
+
+#endif // SHIM_SOC_SOC_H
@@ -0,0 +1,168 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            KeyMapOverlayTool.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host side tool for SharpKey keymap overlay files, built from the firmware overlay
+//                  logic. The firmware stores only the rows which differ from the inbuilt keymap, this
+//                  tool creates an overlay from a complete keymap and expands an overlay back into a
+//                  complete keymap.
+//
+//                  keymap_overlay diff  <inbuilt> <complete> <entry size> <overlay out>
+//                  keymap_overlay merge <inbuilt> <overlay> <complete out>
+//
+//                  <inbuilt> is a complete keymap file holding the interface inbuilt keymap, ie. the
+//                  keymap downloaded from an interface with no user changes.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write, replaces keymap_overlay.py.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "KeyMapOverlay.h"
+
+namespace
+{
+    bool readFile(const char *fileName, std::vector<uint8_t> &data)
+    {
+        // Locals.
+        //
+        std::ifstream                   fileIn(fileName, std::ios::in | std::ios::binary);
+
+        data.assign(std::istreambuf_iterator<char>(fileIn), std::istreambuf_iterator<char>());
+        return(fileIn.is_open() && !fileIn.bad());
+    }
+
+    bool writeFile(const char *fileName, const std::vector<uint8_t> &data)
+    {
+        // Locals.
+        //
+        std::ofstream                   fileOut(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        fileOut.write((const char *)data.data(), data.size());
+        return(fileOut.good());
+    }
+
+    // Row pointers into a complete keymap.
+    std::vector<const uint8_t *> splitRows(const std::vector<uint8_t> &data, size_t entrySize)
+    {
+        // Locals.
+        //
+        std::vector<const uint8_t *>    rows;
+
+        for(size_t pos = 0; pos < data.size(); pos += entrySize)
+            rows.push_back(&data[pos]);
+        return(rows);
+    }
+
+    // Create an overlay holding the edits which turn the inbuilt keymap into the complete keymap.
+    int diffKeyMap(const char *inbuiltFile, const char *completeFile, const char *entrySizeArg, const char *overlayFile)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            inbuilt;
+        std::vector<uint8_t>            complete;
+        std::vector<KeyMapOverlay::t_overlayRecord> records;
+        std::vector<const uint8_t *>    entries;
+        size_t                          entrySize = strtoul(entrySizeArg, NULL, 0);
+
+        if(!readFile(inbuiltFile, inbuilt) || !readFile(completeFile, complete))
+        {
+            fprintf(stderr, "Cannot read %s or %s.\n", inbuiltFile, completeFile);
+            return(1);
+        }
+        if(entrySize == 0 || (inbuilt.size() % entrySize) != 0 || (complete.size() % entrySize) != 0)
+        {
+            fprintf(stderr, "Keymap size is not a multiple of the entry size %zu.\n", entrySize);
+            return(1);
+        }
+        KeyMapOverlay::diff(splitRows(complete, entrySize), inbuilt.data(), inbuilt.size() / entrySize, entrySize, records, entries);
+        if(KeyMapOverlay::save(overlayFile, splitRows(complete, entrySize), inbuilt.data(), inbuilt.size() / entrySize, entrySize) == false)
+        {
+            fprintf(stderr, "Cannot write %s.\n", overlayFile);
+            return(1);
+        }
+        printf("%zu rows differ from the inbuilt keymap of %zu rows.\n", records.size(), inbuilt.size() / entrySize);
+        return(0);
+    }
+
+    // Expand an overlay into the complete keymap it was made from, merging it as the firmware does.
+    int mergeKeyMap(const char *inbuiltFile, const char *overlayFile, const char *completeFile)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            inbuilt;
+        std::vector<uint8_t>            complete;
+        KeyMapOverlay::t_overlayHeader  header;
+        KeyMapOverlay::t_overlayMap     map;
+        std::ifstream                   overlayIn(overlayFile, std::ios::in | std::ios::binary);
+        const uint8_t                  *row;
+
+        overlayIn.read((char *)&header, sizeof(header));
+        if(!overlayIn.good() || header.magic != KEYMAP_OVERLAY_MAGIC || header.format != KEYMAP_OVERLAY_FORMAT || header.entrySize == 0)
+        {
+            fprintf(stderr, "%s is not a keymap overlay.\n", overlayFile);
+            return(1);
+        }
+        if(!readFile(inbuiltFile, inbuilt) || inbuilt.size() != (size_t)header.baseRows * header.entrySize)
+        {
+            fprintf(stderr, "Overlay was made against an inbuilt keymap of %d rows of %d bytes, %s does not match.\n", header.baseRows, header.entrySize, inbuiltFile);
+            return(1);
+        }
+        if(KeyMapOverlay::load(overlayFile, inbuilt.data(), header.baseRows, header.entrySize, map) != KeyMapOverlay::OVERLAY_LOAD_OVERLAY)
+        {
+            fprintf(stderr, "Overlay %s is corrupt.\n", overlayFile);
+            return(1);
+        }
+        for(int idx = 0; idx < map.rows; idx++)
+        {
+            row = (map.index == NULL ? &inbuilt[idx * header.entrySize] :
+                   (map.index[idx] < header.baseRows ? &inbuilt[map.index[idx] * header.entrySize] : &map.overlay[(map.index[idx] - header.baseRows) * header.entrySize]));
+            complete.insert(complete.end(), row, row + header.entrySize);
+        }
+        delete [] map.index;
+        delete [] map.overlay;
+        if(writeFile(completeFile, complete) == false)
+        {
+            fprintf(stderr, "Cannot write %s.\n", completeFile);
+            return(1);
+        }
+        return(0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if(argc == 6 && strcmp(argv[1], "diff") == 0)
+        return(diffKeyMap(argv[2], argv[3], argv[4], argv[5]));
+    if(argc == 5 && strcmp(argv[1], "merge") == 0)
+        return(mergeKeyMap(argv[2], argv[3], argv[4]));
+
+    fprintf(stderr, "Usage: %s diff <inbuilt> <complete> <entry size> <overlay out>\n"
+                    "       %s merge <inbuilt> <overlay> <complete out>\n", argv[0], argv[0]);
+    return(2);
+}
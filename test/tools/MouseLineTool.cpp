@@ -0,0 +1,199 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Name:            MouseLineTool.cpp
+// Created:         Oct 2026
+// Version:         v1.0
+// Author(s):       Philip Smart
+// Description:     Host side tool which records the MSDATA line of the Sharp mouse interface. It is built
+//                  with Mouse.cpp once per host transport, hardware UART, inverted hardware UART and
+//                  bitbang, so the frames each transport puts on the wire can be compared.
+//
+//                  mouse_line_<transport> <packets> <seed>
+//
+//                  Movement and buttons are fed to the interface from a seeded generator, MSCTRL is
+//                  strobed for each packet and the line is printed as one frame per byte:
+//
+//                  packet <status> <x> <y>     expected bytes of the next packet, hex.
+//                  <11 levels>                 start bit, 8 data bits LSB first, 2 stop bits, one line per byte.
+// Credits:
+// Copyright:       (c) 2019-2022 Philip Smart <philip.smart@net2net.org>
+//
+// History:         Oct 2026 - Initial write.
+//
+// Notes:
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This source file is free software: you can redistribute it and#or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This source file is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "NVS.h"
+#include "LED.h"
+#include "HID.h"
+#include "Mouse.h"
+#include "TimerService.h"
+#include "driver/uart.h"
+#include "Shim.h"
+
+namespace
+{
+    #define FRAME_BITS                      11
+
+    // The line levels recorded since the last call, from the UART serialiser or, in bitbang mode, from the MSDATA latch writes. Each frame
+    // is timed from the write which sets the idle level before its start bit, the bit deadlines follow it. A write is never made before its
+    // deadline but may be made after it, so each bit period is sampled at its end.
+    std::vector<uint8_t> lineBits(size_t &consumed)
+    {
+        // Locals.
+        //
+        std::vector<uint8_t>            bits;
+      #ifdef CONFIG_HOST_BITBANG_UART
+        std::vector<Shim::t_gpioWrite>  writes = Shim::gpioWrites(CONFIG_HOST_KDB1);
+        size_t                          pos;
+        int64_t                         start;
+        int64_t                         sample;
+
+        for(pos = consumed; pos + 1 < writes.size(); pos++)
+        {
+            if(writes[pos].level != 1 || writes[pos + 1].level != 0)
+                continue;
+            start = writes[pos].timeUs;
+            for(int bit = 0; bit < FRAME_BITS; bit++)
+            {
+                sample = start + (int64_t)((bit + 1) * BITBANG_UART_BIT_TIME) - 1;
+                while(pos + 1 < writes.size() && writes[pos + 1].timeUs <= sample)
+                    pos++;
+                bits.push_back(writes[pos].level);
+            }
+        }
+        consumed = writes.size();
+      #else
+        std::vector<uint8_t>            txBits = Shim::uartTxBits(UART_NUM_1);
+
+        bits.assign(txBits.begin() + consumed, txBits.end());
+        consumed = txBits.size();
+      #endif
+        return(bits);
+    }
+
+    // The number of line events recorded, latch writes in bitbang mode, bit periods otherwise.
+    size_t lineEvents(void)
+    {
+      #ifdef CONFIG_HOST_BITBANG_UART
+        return(Shim::gpioWrites(CONFIG_HOST_KDB1).size());
+      #else
+        return(Shim::uartTxBits(UART_NUM_1).size());
+      #endif
+    }
+
+  #ifdef CONFIG_HOST_BITBANG_UART
+    // Wait, for a bounded real time, until the line has the given number of events or the transmitting thread has read the bit timer
+    // counter the given number of times.
+    void waitLine(size_t events, uint64_t reads)
+    {
+        for(int wait = 0; wait < 5000 && lineEvents() < events && Shim::timerCounterReads() < reads; wait++)
+            usleep(100);
+    }
+  #endif
+}
+
+int main(int argc, char **argv)
+{
+    // Locals.
+    //
+    NVS                                 nvs;
+    LED                                *led;
+    HID                                *hid;
+    Mouse                              *mouse;
+    HID::t_mouseMessageElement          message = { 0, 0, 0, 0 };
+    uint8_t                             lastButtons = 0;
+    int                                 packets;
+    size_t                              consumed = 0;
+    size_t                              events;
+    // Each packet is 3 frames, in bitbang mode a frame is 11 latch writes, the idle level, the start bit, 8 data bits and the stop bits.
+    size_t                              eventsPerPacket = 3 * FRAME_BITS;
+    std::vector<uint8_t>                bits;
+
+    if(argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <packets> <seed>\n", argv[0]);
+        return(1);
+    }
+    packets = atoi(argv[1]);
+    srand(atoi(argv[2]));
+
+  #ifdef CONFIG_HOST_BITBANG_UART
+    Shim::gpioTrace(CONFIG_HOST_KDB1);
+  #else
+    Shim::uartTrace(UART_NUM_1);
+  #endif
+
+    led = new LED(CONFIG_PWRLED);
+    TimerService::getInstance();
+    nvs.init();
+    nvs.open("SharpKey");
+    hid   = new HID(&nvs);
+    mouse = new Mouse(2, &nvs, led, hid, false);
+
+    // The interface drives MSDATA high once its thread is running, start after it.
+    Shim::settle(20);
+  #ifdef CONFIG_HOST_BITBANG_UART
+    Shim::freezeTime();
+  #endif
+    lineBits(consumed);
+    for(int idx = 0; idx < packets; idx++)
+    {
+        // Movement within a single host packet, Y is inverted by the interface. Buttons pressed since the last packet are latched.
+        message.xPos   = (rand() % 256) - 128;
+        message.yPos   = (rand() % 256) - 127;
+        message.status = rand() & 0x07;
+        mouse->mouseReceiveData(message);
+        printf("packet %02x %02x %02x\n", lastButtons | message.status, (uint8_t)message.xPos, (uint8_t)-message.yPos);
+        lastButtons = message.status;
+
+        // Strobe MSCTRL and hold it low until the packet has been sent.
+        events = lineEvents();
+        Shim::setInput(CONFIG_HOST_KDB0, 0);
+      #ifdef CONFIG_HOST_BITBANG_UART
+        // The bitbang transport spins on the timer counter with the clock frozen, step it a bit period at a time once the thread has seen the
+        // last step, so every edge lands on its deadline regardless of host scheduling.
+        waitLine(events + eventsPerPacket, Shim::timerCounterReads() + 1);
+        for(int step = 0; step < 3 * FRAME_BITS && lineEvents() < events + eventsPerPacket; step++)
+        {
+            Shim::advanceTime(BITBANG_UART_BIT_TIME);
+            waitLine(events + eventsPerPacket, Shim::timerCounterReads() + 2);
+        }
+        // Run the final stop bits out so the thread returns to idle before MSCTRL is released.
+        Shim::advanceTime(BITBANG_UART_BIT_TIME * 2);
+        Shim::settle(2);
+      #else
+        for(int wait = 0; wait < 50 && lineEvents() < events + eventsPerPacket; wait++)
+            Shim::settle(10);
+        Shim::settle(2);
+      #endif
+        Shim::setInput(CONFIG_HOST_KDB0, 1);
+
+        bits = lineBits(consumed);
+        for(size_t pos = 0; pos < bits.size(); pos++)
+            printf("%d%s", bits[pos], (pos % FRAME_BITS) == FRAME_BITS - 1 ? "\n" : "");
+        if(bits.size() % FRAME_BITS != 0)
+            printf("\n");
+    }
+    fflush(stdout);
+    _exit(0);
+}
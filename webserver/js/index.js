@@ -37,15 +37,18 @@ function enableIfConfig()
     if(activeInterface === "KeyInterface ")
     {
         document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
     }
     // Mouse interface active?
     else if(activeInterface === "Mouse ")
     {
         document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
         document.getElementById("mouseCfgAvailable").style.display = 'compact';
     } else
     {
         document.getElementById("keyMapAvailable").style.display = 'compact';
+        document.getElementById("macroAvailable").style.display = 'compact';
 
         // Secondary interface available?
         if(secondaryInterface == "Mouse ")
@@ -58,9 +61,132 @@ function enableIfConfig()
     }
 }
 
+// Method to open the live channel and show the status pushed by the SharpKey.
+function showLiveStatus()
+{
+    if(!("WebSocket" in window))
+    {
+        return;
+    }
+    var liveSocket = new WebSocket("ws://" + window.location.host + "/ws");
+    liveSocket.onmessage = function(e)
+    {
+        if(typeof e.data === "string")
+        {
+            var msg = JSON.parse(e.data);
+            if(msg.type === "status")
+            {
+                document.getElementById("liveStatus").innerHTML = "Up " + msg.uptime + "s, free heap " + msg.heap + " bytes (lowest " + msg.heapMin + ")<br><br>";
+            }
+        }
+    };
+    liveSocket.onclose = function()
+    {
+        document.getElementById("liveStatus").innerHTML = "";
+    };
+}
+
+// Method to return the label of a log2 histogram bucket, bucket 0 is zero, bucket n is below 2^n and the last bucket is open ended.
+function histogramLabel(bucket, buckets)
+{
+    if(bucket == 0)
+    {
+        return("0");
+    }
+    if(bucket == buckets - 1)
+    {
+        return("&ge;" + Math.pow(2, bucket - 1));
+    }
+    return("&lt;" + Math.pow(2, bucket));
+}
+
+// Method to return the bucket holding the given percentile of a histogram, -1 if empty.
+function histogramPercentile(counts, percentile)
+{
+    var total = counts.reduce(function(sum, cnt) { return(sum + cnt); }, 0);
+    var running = 0;
+    if(total == 0)
+    {
+        return(-1);
+    }
+    for(var idx=0; idx < counts.length; idx++)
+    {
+        running += counts[idx];
+        if(running * 100 >= total * percentile)
+        {
+            return(idx);
+        }
+    }
+    return(counts.length - 1);
+}
+
+// Method to format one sample of the metrics as tables.
+function metricsSample(title, sample, buckets)
+{
+    var html = "<b>" + title + "</b> <i>(up " + (sample.uptimeMs / 1000).toFixed(1) + "s, free heap " + sample.heap.free + " bytes, lowest " + sample.heap.min + ", largest block " + sample.heap.largest + ")</i><br>";
+
+    html += "<table class=\"table table-borderless table-sm\"><thead><tr><th>Task</th><th>CPU</th><th>Free Stack</th></tr></thead><tbody>";
+    sample.tasks.forEach(function(task)
+    {
+        html += "<tr><td>" + task.name + "</td><td>" + task.cpu + "%</td><td" + (task.stackFree < 1024 ? " style=\"color: red;\"" : "") + ">" + task.stackFree + "</td></tr>";
+    });
+    if(sample.tasks.length == 0) { html += "<tr><td colspan=\"3\">Task statistics not enabled in this build.</td></tr>"; }
+    html += "</tbody></table>";
+
+    if(sample.queues.length > 0)
+    {
+        html += "<table class=\"table table-borderless table-sm\"><thead><tr><th>Queue</th><th>Depth</th><th>Peak</th><th>Size</th></tr></thead><tbody>";
+        sample.queues.forEach(function(queue)
+        {
+            html += "<tr><td>" + queue.name + "</td><td>" + queue.depth + "</td><td>" + queue.peak + "</td><td>" + queue.size + "</td></tr>";
+        });
+        html += "</tbody></table>";
+    }
+
+    html += "<table class=\"table table-borderless table-sm\"><thead><tr><th>Counter</th><th>Count</th></tr></thead><tbody>";
+    Object.keys(sample.counters).forEach(function(name)
+    {
+        html += "<tr><td>" + name + "</td><td" + (sample.counters[name] > 0 ? " style=\"color: red;\"" : "") + ">" + sample.counters[name] + "</td></tr>";
+    });
+    html += "</tbody></table>";
+
+    Object.keys(sample.histograms).forEach(function(name)
+    {
+        var counts = sample.histograms[name];
+        var p50 = histogramPercentile(counts, 50);
+        var p99 = histogramPercentile(counts, 99);
+        html += "<table class=\"table table-borderless table-sm\"><thead><tr><th>" + name + " (uS)</th>";
+        for(var idx=0; idx < counts.length; idx++) { html += "<th>" + histogramLabel(idx, buckets) + "</th>"; }
+        html += "</tr></thead><tbody><tr><td>" + (p50 < 0 ? "No samples" : "50% " + histogramLabel(p50, buckets) + ", 99% " + histogramLabel(p99, buckets)) + "</td>";
+        for(var idx=0; idx < counts.length; idx++) { html += "<td>" + counts[idx] + "</td>"; }
+        html += "</tr></tbody></table>";
+    });
+    return(html);
+}
+
+// Method to fetch and show the runtime metrics, the last host interface run and the running WiFi mode.
+function showMetrics()
+{
+    $.getJSON("/metrics", function(metrics)
+    {
+        var html = "";
+        if(metrics.interface === null)
+        {
+            html += "<b>Last Interface Run</b><br>No interface run recorded since power on.<br><br>";
+        } else
+        {
+            html += metricsSample("Last Interface Run", metrics.interface, metrics.histogramBuckets);
+        }
+        html += metricsSample("WiFi Mode", metrics.live, metrics.histogramBuckets);
+        document.getElementById("metrics").innerHTML = html;
+    });
+}
+
 // On document load, setup the items viewable on the page according to set values.
 document.addEventListener("DOMContentLoaded", function setPageDefaults()
 {
     showIPConfig();
     enableIfConfig();
+    showLiveStatus();
+    showMetrics();
 });
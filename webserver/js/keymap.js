@@ -142,15 +142,18 @@ function enableIfConfig()
     if(activeInterface === "KeyInterface ")
     {
         document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
     }
     // Mouse interface active?
     else if(activeInterface === "Mouse ")
     {
         document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
         document.getElementById("mouseCfgAvailable").style.display = 'compact';
     } else
     {
         document.getElementById("keyMapAvailable").style.display = 'compact';
+        document.getElementById("macroAvailable").style.display = 'compact';
 
         // Secondary interface available?
         if(secondaryInterface == "Mouse ")
@@ -498,6 +501,152 @@ function deleteKeyMapData()
     return true;
 }
 
+// Live channel to the SharpKey. When open, a Save sends only the rows changed since the table was loaded or last saved, as binary row edits.
+// Edit operations match the keymap overlay, 0 = insert before the row, 1 = replace the row, 2 = delete the row.
+var $liveSocket = null;
+var $liveAck = null;
+var $savedRows = null;
+
+function openLiveChannel()
+{
+    if(!("WebSocket" in window))
+    {
+        return;
+    }
+    $liveSocket = new WebSocket("ws://" + window.location.host + "/ws");
+    $liveSocket.binaryType = "arraybuffer";
+    $liveSocket.onmessage = function(e)
+    {
+        if(e.data instanceof ArrayBuffer)
+        {
+            var ack = new Uint8Array(e.data);
+            if(ack.length == 4 && ack[0] == 0x41 && $liveAck !== null)
+            {
+                var callback = $liveAck;
+                $liveAck = null;
+                callback(ack[1] == 0, ack[2] | (ack[3] << 8));
+            }
+        } else
+        {
+            var msg = JSON.parse(e.data);
+            if(msg.type === "keymap")
+            {
+                showMessage(10000, 'keymapEditorMsg', "<p style=\"color:orange;\">The keymap has been changed from another browser, refresh the page to see the changes.</p>");
+            }
+            else if(msg.type === "key")
+            {
+                $('#keymapLiveKey').html("Key typed: <b>" + hexValue(msg.scanCode, 4) + "</b>, keymap row: <b>" + (msg.row < 0 ? "none" : msg.row) + "</b>");
+            }
+        }
+    };
+    $liveSocket.onclose = function()
+    {
+        $liveSocket = null;
+        $liveAck = null;
+    };
+}
+
+// Method to format a value as fixed width hex, as the keymap table shows it.
+function hexValue(value, digits)
+{
+    return("0x" + ("00000000" + value.toString(16).toUpperCase()).slice(-digits));
+}
+
+// Method to convert a table row into the bytes of a keymap row, values are hex as parsed by the SharpKey and the select checkbox is dropped.
+function rowBytes(row)
+{
+    return(row.filter(function(value) { return(typeof value !== 'boolean'); })
+              .map(function(value) { return((parseInt(String(value), 16) || 0) & 0xFF); }));
+}
+
+// Method to compute the row edits which turn the old rows into the new. Rows common to the start and end are skipped, rows in between are
+// replaced where they differ and the remainder inserted or deleted.
+function keyMapEdits(oldRows, newRows)
+{
+    var edits = [];
+    var head = 0;
+    var tail = 0;
+    var same = function(a, b) { return(a.length == b.length && a.every(function(value, idx) { return(value == b[idx]); })); };
+
+    while(head < oldRows.length && head < newRows.length && same(oldRows[head], newRows[head]))
+    {
+        head++;
+    }
+    while(tail < oldRows.length - head && tail < newRows.length - head && same(oldRows[oldRows.length - 1 - tail], newRows[newRows.length - 1 - tail]))
+    {
+        tail++;
+    }
+    var oldCnt = oldRows.length - head - tail;
+    var newCnt = newRows.length - head - tail;
+    for(var idx = 0; idx < Math.min(oldCnt, newCnt); idx++)
+    {
+        if(!same(oldRows[head + idx], newRows[head + idx]))
+        {
+            edits.push({ op: 1, row: head + idx, entry: newRows[head + idx] });
+        }
+    }
+    for(var idx = oldCnt; idx < newCnt; idx++)
+    {
+        edits.push({ op: 0, row: head + idx, entry: newRows[head + idx] });
+    }
+    for(var idx = newCnt; idx < oldCnt; idx++)
+    {
+        edits.push({ op: 2, row: head + newCnt, entry: [] });
+    }
+    return(edits);
+}
+
+// Method to save the table changes as row edits over the live channel. Returns false if the channel is not available or the changes are
+// too large for one message, the whole table is then uploaded.
+function saveKeyMapEdits(data)
+{
+    var rows = data.map(rowBytes);
+    var edits;
+    var frame;
+    var pos = 3;
+
+    if($liveSocket === null || $liveSocket.readyState !== WebSocket.OPEN || $liveAck !== null || $savedRows === null)
+    {
+        return(false);
+    }
+    edits = keyMapEdits($savedRows, rows);
+    edits.forEach(function(edit) { pos += 3 + edit.entry.length; });
+    if(edits.length == 0 || edits.length > 255 || pos > 4096)
+    {
+        return(false);
+    }
+
+    frame = new Uint8Array(pos);
+    frame[0] = 0x45;
+    frame[1] = edits.length;
+    frame[2] = rows[0].length;
+    pos = 3;
+    edits.forEach(function(edit) {
+        frame[pos++] = edit.op;
+        frame[pos++] = edit.row & 0xFF;
+        frame[pos++] = (edit.row >> 8) & 0xFF;
+        frame.set(edit.entry, pos);
+        pos += edit.entry.length;
+    });
+
+    $liveAck = function(applied, rowCnt)
+    {
+        if(applied)
+        {
+            $savedRows = rows;
+            showMessage(5000, 'keymapEditorMsg', "<p style=\"color:green;\">" + edits.length + " row(s) saved, the keymap has " + rowCnt + " rows and is active, keys typed on a PS/2 keyboard show the new mapping. Press <b>Reboot</b> to return to the host interface.</p>");
+            $currentDataSetModified = false;
+            updateButtons();
+        } else
+        {
+            showMessage(5000, 'keymapEditorMsg', "<p style=\"color:red;\">Error: the keymap edit was rejected - Please retry Save</p>");
+        }
+    };
+    showMessage(5000, 'keymapEditorMsg', "<p style=\"color:orange;\">Saving keymap changes, please wait...</p>");
+    $liveSocket.send(frame);
+    return(true);
+}
+
 // Method to save the current keymap table data to the interface.
 function saveKeyMapData()
 {
@@ -511,7 +660,7 @@ function saveKeyMapData()
     {
         alert("No data to save!!");
 
-    } else 
+    } else if(saveKeyMapEdits(data) == false)
     {
         var xhttp;
         if(window.XMLHttpRequest)
@@ -531,6 +680,7 @@ function saveKeyMapData()
                 if (xhttp.status == 200) 
                 {
                     showMessage(5000, 'keymapEditorMsg', "<p style=\"color:green;\">Upload complete. Please press <b>Reboot</b> to activate new key map.</p>");
+                    $savedRows = data.map(rowBytes);
                    
                     // Reset the data modified flag and update button state.
                     $currentDataSetModified = false;
@@ -631,6 +781,7 @@ $(document).ready(function() {
                   })
                   .then((data) => {
                       keymapTable.loadData(data);
+                      $savedRows = data.map(rowBytes);
                       setupTableListeners();
                   });
             });
@@ -650,4 +801,7 @@ $(document).ready(function() {
    
     // Setup the menu options according to underlying interface.
     enableIfConfig();
+
+    // Open the live channel for saving edits.
+    openLiveChannel();
 });
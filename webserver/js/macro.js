@@ -0,0 +1,121 @@
+// Method to display a message in a message field. The existing html is saved and replaced
+// with the new html. After a timeout period the original html is restored.
+//
+$origMessage = null;
+$origId = null;
+$msgTimerId = null;
+function showMessage(timeout, id, message)
+{
+    // Is this a new message whilst one is active?
+    if($origMessage !== null)
+    {
+        // Cancel timer and restore original message.
+        clearTimeout($msgTimerId);
+        $('#' + $origId).html($origMessage);
+    }
+
+    // Store original message and Id so that on timer expiry it can be replaced..
+    $origMessage = $('#' + id).html();
+    $origId = id;
+
+    // Change HTML and set timer to restore it.
+    $('#' + id).html(message);
+    $msgTimerId = setTimeout(function(msgFieldId) 
+               {
+                    $('#' + msgFieldId).html($origMessage);
+                    $origMessage = null;
+               }, timeout, id);
+}
+
+// Method to enable the correct side-bar menu for the underlying host interface.
+function enableIfConfig()
+{
+    // Disable keymap if no host is connected to the SharpKey. KeyInterface is the base class which exists when
+    // no host was detected to invoke a host specific sub-class.
+    if(activeInterface === "KeyInterface ")
+    {
+        document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
+    }
+    // Mouse interface active?
+    else if(activeInterface === "Mouse ")
+    {
+        document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
+        document.getElementById("mouseCfgAvailable").style.display = 'compact';
+    } else
+    {
+        document.getElementById("keyMapAvailable").style.display = 'compact';
+        document.getElementById("macroAvailable").style.display = 'compact';
+
+        // Secondary interface available?
+        if(secondaryInterface == "Mouse ")
+        {
+            document.getElementById("mouseCfgAvailable").style.display = 'compact';
+        } else
+        {
+            document.getElementById("mouseCfgAvailable").style.display = 'none';
+        }
+    }
+}
+
+// Method to load the text of the selected macro, a macro not yet stored is empty.
+function loadMacro()
+{
+    $.ajax(
+    {
+        type: "GET",
+        url: "/macro" + $("#macroSlot").val() + ".txt",
+        dataType: "text",
+        cache: false,
+        success: function(data)
+                 {
+                     $("#macroText").val(data);
+                 },
+        error:   function()
+                 {
+                     $("#macroText").val("");
+                 }
+    });
+}
+
+$(document).ready(function() {
+
+    // Setup the menu options according to underlying interface.
+    enableIfConfig();
+
+    // Show the stored text when a macro is selected.
+    loadMacro();
+    $("#macroSlot").change(function()
+    {
+        loadMacro();
+    });
+
+    // AJAX code to post the macro text as is so that we can receive back the number of keys or an error.
+    $("#macroSave").submit( function(e)
+    {
+        var form = $(this);
+        var actionUrl = form.attr('action') + "/" + $("#macroSlot").val();
+
+        // Prevent default submit action, we want to manually submit and be able to receive a response for errors/success.
+        e.preventDefault();
+        
+        $.ajax(
+        {
+            type: "POST",
+            url: actionUrl,
+            contentType: "text/plain",
+            processData: false,
+            data: $("#macroText").val(),
+            success: function(data)
+                     {
+                         // Show the message then revert back to original text.
+                         showMessage(10000, "macroMsg", $("#macroText").val().length == 0 ? "Macro removed." : "Macro saved, " + data + " keys.");
+                     },
+            error:   function(xhr)
+                     {
+                         showMessage(10000, "macroMsg", "Macro not saved: " + xhr.responseText);
+                     }
+         });
+    });
+});
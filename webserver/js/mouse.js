@@ -35,15 +35,18 @@ function enableIfConfig()
     if(activeInterface === "KeyInterface ")
     {
         document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
     }
     // Mouse interface active?
     else if(activeInterface === "Mouse ")
     {
         document.getElementById("keyMapAvailable").style.display = 'none';
+        document.getElementById("macroAvailable").style.display = 'none';
         document.getElementById("mouseCfgAvailable").style.display = 'compact';
     } else
     {
         document.getElementById("keyMapAvailable").style.display = 'compact';
+        document.getElementById("macroAvailable").style.display = 'compact';
 
         // Secondary interface available?
         if(secondaryInterface == "Mouse ")